@@ -0,0 +1,69 @@
+/** @addtogroup abi_generic
+ * @{
+ */
+/** @file Boot-time event trace interface
+ */
+
+#ifndef _ABI_BOOTTRACE_H_
+#define _ABI_BOOTTRACE_H_
+
+#include <stdint.h>
+#include <abi/proc/task.h>
+
+/** Maximum length of event name including the terminating null */
+#define BOOTTRACE_NAME_LEN  32
+
+typedef enum {
+	/** Record an event, argument is a boottrace_event_t */
+	BOOTTRACE_RECORD,
+	/** Read events starting at the given event number */
+	BOOTTRACE_READ,
+	/** Get number of events dropped because the trace was full */
+	BOOTTRACE_LOST
+} boottrace_operation_t;
+
+typedef enum {
+	/**
+	 * Task was created (kernel). @c task_id is the creating task,
+	 * @c arg is the ID of the new task, @c name its initial name.
+	 */
+	BOOTTRACE_TASK_CREATE,
+	/** Task set its name (kernel). */
+	BOOTTRACE_TASK_NAME,
+	/** Task reported it is ready by setting its return value (ns). */
+	BOOTTRACE_TASK_READY,
+	/** Task finished waiting for task @c arg. */
+	BOOTTRACE_TASK_WAIT,
+	/** Service @c arg was registered with the naming service (ns). */
+	BOOTTRACE_NS_REGISTER,
+	/** Service @c name was registered with location service (locsrv). */
+	BOOTTRACE_LOC_REGISTER,
+	/** Task finished waiting for location service @c name. */
+	BOOTTRACE_LOC_WAIT,
+	/** Driver attached to device @c name (devman). */
+	BOOTTRACE_DRIVER_ATTACH,
+	/** File system @c name on service @c arg was mounted (vfs). */
+	BOOTTRACE_MOUNT,
+	/** Generic milestone */
+	BOOTTRACE_MARK
+} boottrace_type_t;
+
+/** Boot-time trace event */
+typedef struct {
+	/** Time since boot in microseconds, filled in by the kernel */
+	uint64_t time;
+	/** Task the event relates to, zero means the recording task */
+	task_id_t task_id;
+	/** Event-specific argument */
+	uint64_t arg;
+	/** Event type (boottrace_type_t) */
+	uint32_t type;
+	uint32_t reserved;
+	/** Event-specific name */
+	char name[BOOTTRACE_NAME_LEN];
+} boottrace_event_t;
+
+#endif
+
+/** @}
+ */
@@ -120,6 +120,7 @@ enum {
 	 * on answer, the recipient must set:
 	 *
 	 * - ARG1 - source user page address
+	 * - ARG2 - page-in flags (AS_PAGE_IN_*)
 	 */
 	IPC_M_PAGE_IN,
 
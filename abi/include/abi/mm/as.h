@@ -47,6 +47,15 @@ enum {
 	AS_AREA_LATE_RESERVE = 0x20,
 };
 
+/** Flags returned by the pager in ARG2 of the IPC_M_PAGE_IN answer. */
+enum {
+	/**
+	 * The page may be shared with other address spaces. Writable areas
+	 * map it read-only and get a private copy on the first write.
+	 */
+	AS_PAGE_IN_COW = 0x01,
+};
+
 static void *const AS_AREA_ANY = (void *) -1;
 static void *const AS_MAP_FAILED = (void *) -1;
 static void *const AS_AREA_UNPAGED = NULL;
@@ -0,0 +1,56 @@
+/** @addtogroup abi_generic
+ * @{
+ */
+/** @file Sampling profiler interface
+ */
+
+#ifndef _ABI_PROFILE_H_
+#define _ABI_PROFILE_H_
+
+#include <stdint.h>
+#include <abi/proc/task.h>
+#include <abi/proc/thread.h>
+
+/** Maximum number of return addresses recorded with a sample */
+#define PROFILE_STACK_DEPTH  8
+
+typedef enum {
+	/** Start sampling, argument is the sampling period in clock ticks */
+	PROFILE_START,
+	/** Stop sampling */
+	PROFILE_STOP,
+	/** Drain recorded samples */
+	PROFILE_READ,
+	/** Get number of samples lost since start */
+	PROFILE_LOST
+} profile_operation_t;
+
+typedef enum {
+	/** Sample was taken while executing userspace code */
+	PROFILE_SAMPLE_USPACE = 1 << 0,
+	/** No thread was running on the CPU */
+	PROFILE_SAMPLE_IDLE = 1 << 1
+} profile_sample_flags_t;
+
+/** Profiler sample */
+typedef struct {
+	/** Task that was running on the CPU */
+	task_id_t task_id;
+	/** Thread that was running on the CPU */
+	thread_id_t thread_id;
+	/** Program counter */
+	uintptr_t pc;
+	/** CPU the sample was taken on */
+	uint16_t cpu;
+	/** Sample flags (profile_sample_flags_t) */
+	uint8_t flags;
+	/** Number of valid entries in @c stack */
+	uint8_t depth;
+	/** Kernel return addresses, innermost first (none for userspace) */
+	uintptr_t stack[PROFILE_STACK_DEPTH];
+} profile_sample_t;
+
+#endif
+
+/** @}
+ */
@@ -107,7 +107,9 @@ typedef enum {
 
 	SYS_DEBUG_CONSOLE,
 
-	SYS_KLOG
+	SYS_KLOG,
+	SYS_PROFILE,
+	SYS_BOOTTRACE
 } syscall_t;
 
 #endif
@@ -0,0 +1,23 @@
+/** @addtogroup kernel_generic_debug
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_BOOTTRACE_H_
+#define KERN_BOOTTRACE_H_
+
+#include <typedefs.h>
+#include <abi/boottrace.h>
+
+extern void boottrace_init(void);
+extern void boottrace_record(boottrace_type_t, task_id_t, uint64_t,
+    const char *);
+
+extern sys_errno_t sys_boottrace(sysarg_t, sysarg_t, uspace_addr_t, size_t,
+    uspace_ptr_size_t);
+
+#endif
+
+/** @}
+ */
@@ -198,6 +198,9 @@ typedef struct thread {
 	/** Thread's kernel stack. */
 	uint8_t *kstack;
 
+	/** Innermost interrupted context, NULL outside exception handlers. */
+	istate_t *istate;
+
 #ifdef CONFIG_UDEBUG
 	/**
 	 * If true, the scheduler will print a stack trace
@@ -0,0 +1,22 @@
+/** @addtogroup kernel_generic_debug
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_PROFILE_H_
+#define KERN_PROFILE_H_
+
+#include <typedefs.h>
+#include <abi/profile.h>
+
+extern void profile_init(void);
+extern void profile_tick(void);
+
+extern sys_errno_t sys_profile(sysarg_t, sysarg_t, uspace_addr_t, size_t,
+    uspace_ptr_size_t);
+
+#endif
+
+/** @}
+ */
@@ -70,6 +70,12 @@
  */
 #define PERM_IRQ_REG     (1 << 3)
 
+/**
+ * PERM_DEBUG allows its holder to profile the system and read kernel
+ * tracing data, which contain addresses and events of other tasks.
+ */
+#define PERM_DEBUG       (1 << 4)
+
 typedef uint32_t perm_t;
 
 #ifdef __32_BITS__
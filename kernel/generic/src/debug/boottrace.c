@@ -0,0 +1,204 @@
+/** @addtogroup kernel_generic_debug
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Boot-time event trace.
+ *
+ * The kernel records task creation and naming, userspace records its own
+ * milestones (service registration, driver attach, mounts, ...) using
+ * sys_boottrace(). All events are time-stamped by the kernel and stored in
+ * a single buffer in the order they were recorded. The buffer is filled
+ * only once, so that the start of the boot is never overwritten. Events
+ * recorded after it is full are dropped and counted as lost.
+ */
+
+#include <abi/boottrace.h>
+#include <arch.h>
+#include <barrier.h>
+#include <boottrace.h>
+#include <errno.h>
+#include <macros.h>
+#include <mem.h>
+#include <proc/task.h>
+#include <security/perm.h>
+#include <stdlib.h>
+#include <str.h>
+#include <synch/spinlock.h>
+#include <syscall/copy.h>
+#include <time/clock.h>
+
+/** Capacity of the trace in events */
+#define BOOTTRACE_EVENTS  2048
+
+/** Maximum number of events transferred by a single read */
+#define BOOTTRACE_READ_EVENTS  64
+
+/** Protects the trace */
+IRQ_SPINLOCK_STATIC_INITIALIZE(boottrace_lock);
+
+/** Recorded events or @c NULL if tracing is not available */
+static boottrace_event_t *boottrace_events;
+
+/** Number of recorded events */
+static size_t boottrace_count;
+
+/** Number of events dropped because the trace was full */
+static size_t boottrace_lost;
+
+/** Initialize the boot-time trace. */
+void boottrace_init(void)
+{
+	boottrace_events = malloc(BOOTTRACE_EVENTS *
+	    sizeof(boottrace_event_t));
+}
+
+/** Get time since boot.
+ *
+ * @return Time since boot in microseconds.
+ */
+static uint64_t boottrace_time(void)
+{
+	if (!uptime)
+		return 0;
+
+	sysarg_t s2 = uptime->seconds2;
+
+	read_barrier();
+	sysarg_t usec = uptime->useconds;
+
+	read_barrier();
+	sysarg_t s1 = uptime->seconds1;
+
+	if (s1 != s2)
+		return (uint64_t) max(s1, s2) * 1000000;
+
+	return (uint64_t) s1 * 1000000 + usec;
+}
+
+/** Time-stamp and store an event.
+ *
+ * @param event Event to store.
+ */
+static void boottrace_store(boottrace_event_t *event)
+{
+	event->time = boottrace_time();
+
+	irq_spinlock_lock(&boottrace_lock, true);
+
+	if (!boottrace_events || boottrace_count >= BOOTTRACE_EVENTS) {
+		boottrace_lost++;
+		irq_spinlock_unlock(&boottrace_lock, true);
+		return;
+	}
+
+	boottrace_events[boottrace_count++] = *event;
+	irq_spinlock_unlock(&boottrace_lock, true);
+}
+
+/** Record a kernel event.
+ *
+ * @param type    Event type.
+ * @param task_id Task the event relates to.
+ * @param arg     Event-specific argument.
+ * @param name    Event-specific name or @c NULL.
+ */
+void boottrace_record(boottrace_type_t type, task_id_t task_id, uint64_t arg,
+    const char *name)
+{
+	boottrace_event_t event = {
+		.task_id = task_id,
+		.arg = arg,
+		.type = type
+	};
+
+	if (name)
+		str_cpy(event.name, BOOTTRACE_NAME_LEN, name);
+
+	boottrace_store(&event);
+}
+
+/** Record and read boot-time trace events.
+ *
+ * Events may describe other tasks and the trace has a fixed size, so
+ * only tasks with PERM_DEBUG can record or read them.
+ *
+ * @param operation    Operation to perform (boottrace_operation_t).
+ * @param arg          Number of the first event for BOOTTRACE_READ.
+ * @param buf          Event to record for BOOTTRACE_RECORD, buffer for
+ *                     events for BOOTTRACE_READ.
+ * @param size         Size of @a buf.
+ * @param uspace_nread Number of bytes read for BOOTTRACE_READ, number of
+ *                     lost events for BOOTTRACE_LOST.
+ *
+ * @return EPERM if the task lacks PERM_DEBUG, other error code otherwise.
+ */
+sys_errno_t sys_boottrace(sysarg_t operation, sysarg_t arg, uspace_addr_t buf,
+    size_t size, uspace_ptr_size_t uspace_nread)
+{
+	boottrace_event_t event;
+	boottrace_event_t *data;
+	size_t count;
+	errno_t rc;
+
+	if (!(perm_get(TASK) & PERM_DEBUG))
+		return (sys_errno_t) EPERM;
+
+	switch (operation) {
+	case BOOTTRACE_RECORD:
+		if (size != sizeof(event))
+			return (sys_errno_t) EINVAL;
+
+		rc = copy_from_uspace(&event, buf, sizeof(event));
+		if (rc != EOK)
+			return (sys_errno_t) rc;
+
+		event.name[BOOTTRACE_NAME_LEN - 1] = '\0';
+		if (event.task_id == 0)
+			event.task_id = TASK->taskid;
+
+		boottrace_store(&event);
+		return EOK;
+	case BOOTTRACE_READ:
+		count = min(size / sizeof(boottrace_event_t),
+		    (size_t) BOOTTRACE_READ_EVENTS);
+		if (count == 0)
+			return (sys_errno_t) EINVAL;
+
+		data = malloc(count * sizeof(boottrace_event_t));
+		if (!data)
+			return (sys_errno_t) ENOMEM;
+
+		irq_spinlock_lock(&boottrace_lock, true);
+		if (arg < boottrace_count) {
+			count = min(count, boottrace_count - arg);
+			memcpy(data, &boottrace_events[arg],
+			    count * sizeof(boottrace_event_t));
+		} else {
+			count = 0;
+		}
+		irq_spinlock_unlock(&boottrace_lock, true);
+
+		size = count * sizeof(boottrace_event_t);
+		rc = copy_to_uspace(buf, data, size);
+		free(data);
+		if (rc != EOK)
+			return (sys_errno_t) rc;
+
+		return (sys_errno_t) copy_to_uspace(uspace_nread, &size,
+		    sizeof(size));
+	case BOOTTRACE_LOST:
+		irq_spinlock_lock(&boottrace_lock, true);
+		count = boottrace_lost;
+		irq_spinlock_unlock(&boottrace_lock, true);
+
+		return (sys_errno_t) copy_to_uspace(uspace_nread, &count,
+		    sizeof(count));
+	default:
+		return (sys_errno_t) ENOTSUP;
+	}
+}
+
+/** @}
+ */
@@ -0,0 +1,347 @@
+/** @addtogroup kernel_generic_debug
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Sampling CPU profiler.
+ *
+ * When enabled, every clock tick (or every n-th tick) records the running
+ * task and thread, the interrupted program counter and a few return
+ * addresses into a ring buffer of the current CPU. Each ring has a single
+ * producer (the clock interrupt on its CPU) and a single consumer
+ * (sys_profile() under profile_lock), so no lock is needed between them.
+ * When a ring is full, new samples are dropped and counted as lost.
+ *
+ * The ring buffers are allocated on the first start and kept afterwards,
+ * so that the clock handler never races with their deallocation.
+ */
+
+#include <abi/profile.h>
+#include <arch.h>
+#include <assert.h>
+#include <atomic.h>
+#include <config.h>
+#include <cpu.h>
+#include <errno.h>
+#include <interrupt.h>
+#include <macros.h>
+#include <proc/task.h>
+#include <proc/thread.h>
+#include <profile.h>
+#include <security/perm.h>
+#include <stacktrace.h>
+#include <stdlib.h>
+#include <synch/mutex.h>
+#include <syscall/copy.h>
+
+/** Number of samples in a per-CPU ring, must be a power of two */
+#define PROFILE_RING_SAMPLES  1024
+
+/** Maximum number of samples transferred by a single read */
+#define PROFILE_READ_SAMPLES  256
+
+/** Per-CPU sample ring */
+typedef struct {
+	profile_sample_t *samples;
+	/** Producer position, only written by the owning CPU */
+	atomic_size_t head;
+	/** Consumer position, only written under profile_lock */
+	atomic_size_t tail;
+	/** Ticks since the last sample, only accessed by the owning CPU */
+	size_t ticks;
+} profile_ring_t;
+
+/** Serializes profiler control and readers */
+static mutex_t profile_lock;
+
+/** Per-CPU rings, indexed by CPU ID */
+static profile_ring_t *profile_rings;
+
+/** Whether the clock handler records samples */
+static atomic_bool profile_active = false;
+
+/** Sampling period in clock ticks */
+static atomic_size_t profile_period = 1;
+
+/** Number of samples dropped because a ring was full */
+static atomic_size_t profile_lost = 0;
+
+/** Initialize the profiler. */
+void profile_init(void)
+{
+	mutex_initialize(&profile_lock, MUTEX_PASSIVE);
+}
+
+/** Check that a kernel frame pointer points to the current stack.
+ *
+ * @param fp    Frame pointer to check.
+ * @param above Frame pointer of the inner frame, the outer frame must
+ *              lie above it.
+ *
+ * @return True if it is safe to read the frame.
+ */
+static bool profile_kernel_fp_valid(uintptr_t fp, uintptr_t above)
+{
+	uintptr_t base = THREAD ? (uintptr_t) THREAD->kstack :
+	    (uintptr_t) CPU->stack;
+
+	return (fp % sizeof(uintptr_t) == 0) && (fp > above) &&
+	    (fp >= base) && (fp < base + STACK_SIZE - 2 * sizeof(uintptr_t));
+}
+
+/** Record return addresses of the interrupted context.
+ *
+ * Kernel frames are only followed while they stay within the current
+ * kernel stack. Userspace frames are not followed at all: reading them
+ * could fault and sleep in the clock handler, possibly migrating the
+ * thread to another CPU and making it a second producer of that CPU's
+ * ring. Userspace samples thus only record the program counter.
+ *
+ * @param sample Sample to fill in.
+ * @param istate Interrupted context.
+ */
+static void profile_stack(profile_sample_t *sample, istate_t *istate)
+{
+	stack_trace_context_t ctx = {
+		.fp = istate_get_fp(istate),
+		.pc = istate_get_pc(istate),
+		.istate = istate
+	};
+	uintptr_t ra;
+	uintptr_t fp;
+
+	if (istate_from_uspace(istate))
+		return;
+
+	if (!profile_kernel_fp_valid(ctx.fp, 0))
+		return;
+
+	while (sample->depth < PROFILE_STACK_DEPTH &&
+	    kst_ops.stack_trace_context_validate(&ctx)) {
+		if (!kst_ops.return_address_get(&ctx, &ra))
+			break;
+		if (ra == 0)
+			break;
+
+		sample->stack[sample->depth++] = ra;
+
+		if (!kst_ops.frame_pointer_prev(&ctx, &fp))
+			break;
+
+		/* Outer frames must lie above, this also prevents cycles */
+		if (!profile_kernel_fp_valid(fp, ctx.fp))
+			break;
+
+		ctx.fp = fp;
+		ctx.pc = ra;
+	}
+}
+
+/** Take a profiler sample.
+ *
+ * Called from clock() with interrupts disabled.
+ */
+void profile_tick(void)
+{
+	if (!atomic_load_explicit(&profile_active, memory_order_relaxed))
+		return;
+
+	profile_ring_t *ring = &profile_rings[CPU->id];
+	if (++ring->ticks < atomic_load_explicit(&profile_period,
+	    memory_order_relaxed))
+		return;
+	ring->ticks = 0;
+
+	profile_sample_t sample = {
+		.cpu = CPU->id
+	};
+
+	if (THREAD) {
+		/* The innermost interrupted context is the clock interrupt */
+		istate_t *istate = THREAD->istate;
+		if (!istate)
+			return;
+
+		sample.task_id = TASK->taskid;
+		sample.thread_id = THREAD->tid;
+		sample.pc = istate_get_pc(istate);
+		if (istate_from_uspace(istate))
+			sample.flags |= PROFILE_SAMPLE_USPACE;
+
+		/* Does not sleep, so we stay the only producer of the ring */
+		profile_stack(&sample, istate);
+	} else {
+		sample.flags = PROFILE_SAMPLE_IDLE;
+	}
+
+	size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	if (head - tail >= PROFILE_RING_SAMPLES) {
+		atomic_inc(&profile_lost);
+		return;
+	}
+
+	ring->samples[head % PROFILE_RING_SAMPLES] = sample;
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/** Allocate per-CPU rings.
+ *
+ * @return EOK on success, ENOMEM if out of memory.
+ */
+static errno_t profile_alloc(void)
+{
+	assert(mutex_locked(&profile_lock));
+
+	if (profile_rings)
+		return EOK;
+
+	profile_ring_t *rings = malloc(config.cpu_count *
+	    sizeof(profile_ring_t));
+	if (!rings)
+		return ENOMEM;
+
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		rings[i].samples = malloc(PROFILE_RING_SAMPLES *
+		    sizeof(profile_sample_t));
+		if (!rings[i].samples) {
+			while (i-- > 0)
+				free(rings[i].samples);
+			free(rings);
+			return ENOMEM;
+		}
+
+		atomic_init(&rings[i].head, 0);
+		atomic_init(&rings[i].tail, 0);
+		rings[i].ticks = 0;
+	}
+
+	profile_rings = rings;
+	return EOK;
+}
+
+/** Move samples from per-CPU rings to a buffer.
+ *
+ * @param data  Destination buffer.
+ * @param count Capacity of the buffer in samples.
+ *
+ * @return Number of samples stored.
+ */
+static size_t profile_drain(profile_sample_t *data, size_t count)
+{
+	assert(mutex_locked(&profile_lock));
+
+	size_t copied = 0;
+
+	for (unsigned int i = 0; i < config.cpu_count && copied < count; i++) {
+		profile_ring_t *ring = &profile_rings[i];
+		size_t tail = atomic_load_explicit(&ring->tail,
+		    memory_order_relaxed);
+		size_t head = atomic_load_explicit(&ring->head,
+		    memory_order_acquire);
+
+		while (tail != head && copied < count) {
+			data[copied++] = ring->samples[tail % PROFILE_RING_SAMPLES];
+			tail++;
+		}
+
+		atomic_store_explicit(&ring->tail, tail, memory_order_release);
+	}
+
+	return copied;
+}
+
+/** Discard samples recorded so far. */
+static void profile_discard(void)
+{
+	assert(mutex_locked(&profile_lock));
+
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		profile_ring_t *ring = &profile_rings[i];
+		atomic_store_explicit(&ring->tail,
+		    atomic_load_explicit(&ring->head, memory_order_acquire),
+		    memory_order_release);
+	}
+}
+
+/** Control the profiler and read samples.
+ *
+ * @param operation    Operation to perform (profile_operation_t).
+ * @param arg          Sampling period in clock ticks for PROFILE_START.
+ * @param buf          Buffer for samples for PROFILE_READ.
+ * @param size         Size of @a buf.
+ * @param uspace_nread Number of bytes read for PROFILE_READ, number of
+ *                     lost samples for PROFILE_LOST.
+ *
+ * @return EPERM if the task lacks PERM_DEBUG, other error code otherwise.
+ */
+sys_errno_t sys_profile(sysarg_t operation, sysarg_t arg, uspace_addr_t buf,
+    size_t size, uspace_ptr_size_t uspace_nread)
+{
+	profile_sample_t *data;
+	size_t count;
+	errno_t rc;
+
+	if (!(perm_get(TASK) & PERM_DEBUG))
+		return (sys_errno_t) EPERM;
+
+	switch (operation) {
+	case PROFILE_START:
+		if (arg == 0)
+			return (sys_errno_t) EINVAL;
+
+		mutex_lock(&profile_lock);
+		if (atomic_load(&profile_active)) {
+			mutex_unlock(&profile_lock);
+			return (sys_errno_t) EBUSY;
+		}
+
+		rc = profile_alloc();
+		if (rc != EOK) {
+			mutex_unlock(&profile_lock);
+			return (sys_errno_t) rc;
+		}
+
+		profile_discard();
+		atomic_store(&profile_period, arg);
+		atomic_store(&profile_lost, 0);
+		atomic_store(&profile_active, true);
+		mutex_unlock(&profile_lock);
+		return EOK;
+	case PROFILE_STOP:
+		atomic_store(&profile_active, false);
+		return EOK;
+	case PROFILE_READ:
+		count = min(size / sizeof(profile_sample_t),
+		    (size_t) PROFILE_READ_SAMPLES);
+		if (count == 0)
+			return (sys_errno_t) EINVAL;
+
+		data = malloc(count * sizeof(profile_sample_t));
+		if (!data)
+			return (sys_errno_t) ENOMEM;
+
+		mutex_lock(&profile_lock);
+		count = profile_rings ? profile_drain(data, count) : 0;
+		mutex_unlock(&profile_lock);
+
+		size = count * sizeof(profile_sample_t);
+		rc = copy_to_uspace(buf, data, size);
+		free(data);
+		if (rc != EOK)
+			return (sys_errno_t) rc;
+
+		return (sys_errno_t) copy_to_uspace(uspace_nread, &size,
+		    sizeof(size));
+	case PROFILE_LOST:
+		count = atomic_load(&profile_lost);
+		return (sys_errno_t) copy_to_uspace(uspace_nread, &count,
+		    sizeof(count));
+	default:
+		return (sys_errno_t) ENOTSUP;
+	}
+}
+
+/** @}
+ */
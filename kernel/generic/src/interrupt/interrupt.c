@@ -123,6 +123,13 @@ _NO_TRACE void exc_dispatch(unsigned int n, istate_t *istate)
 
 	uint64_t begin_cycle = get_cycle();
 
+	/* Make the interrupted context available to the profiler */
+	istate_t *istate_prev = NULL;
+	if (THREAD) {
+		istate_prev = THREAD->istate;
+		THREAD->istate = istate;
+	}
+
 #ifdef CONFIG_UDEBUG
 	if (THREAD)
 		THREAD->udebug.uspace_state = istate;
@@ -135,6 +142,9 @@ _NO_TRACE void exc_dispatch(unsigned int n, istate_t *istate)
 		THREAD->udebug.uspace_state = NULL;
 #endif
 
+	if (THREAD)
+		THREAD->istate = istate_prev;
+
 	/* This is a safe place to exit exiting thread */
 	if ((THREAD) && (THREAD->interrupted) && (istate_from_uspace(istate)))
 		thread_exit();
@@ -53,10 +53,46 @@
 #include <console/console.h>
 #include <abi/log.h>
 #include <stdlib.h>
+#include <config.h>
+#include <cpu.h>
+#include <macros.h>
 
 #define LOG_PAGES    8
 #define LOG_LENGTH   (LOG_PAGES * PAGE_SIZE)
-#define LOG_ENTRY_HEADER_LENGTH (sizeof(size_t) + sizeof(uint32_t))
+#define LOG_ENTRY_HEADER_LENGTH (sizeof(size_t) + 3 * sizeof(uint32_t))
+
+/** Size of the per-CPU staging ring, must be a power of two */
+#define LOG_CPU_LENGTH  (2 * PAGE_SIZE)
+
+/** Per-CPU staging ring.
+ *
+ * Entries are formatted into the ring of the current CPU with interrupts
+ * disabled, without taking any global lock. The ring has the same entry
+ * format as the log buffer. Committed entries are moved to the log buffer
+ * and to kio by log_merge(), in the order of their sequence numbers.
+ */
+typedef struct {
+	/** End of committed entries, only written by the owning CPU */
+	atomic_size_t head;
+	/** Start of entries not merged yet, only written under log_lock */
+	atomic_size_t tail;
+	/** Length (including header) of the entry being written */
+	size_t cur_len;
+	/** Entry being written does not fit into the ring */
+	bool overflow;
+	/** An entry is being written */
+	bool busy;
+	/** Number of entries started while another one was being written */
+	unsigned int nested;
+	/** Interrupt level to restore in log_end() */
+	ipl_t ipl;
+	/** Number of entries dropped because the ring was full */
+	atomic_size_t dropped;
+	/** Number of dropped entries already reported, under log_lock */
+	size_t reported;
+	/** Ring data */
+	uint8_t buffer[LOG_CPU_LENGTH];
+} log_cpu_t;
 
 /** Cyclic buffer holding the data for kernel log */
 uint8_t log_buffer[LOG_LENGTH] __attribute__((aligned(PAGE_SIZE)));
@@ -64,6 +100,9 @@ uint8_t log_buffer[LOG_LENGTH] __attribute__((aligned(PAGE_SIZE)));
 /** Kernel log initialized */
 static atomic_bool log_inited = false;
 
+/** Per-CPU staging rings, NULL until initialized */
+static log_cpu_t *log_cpus = NULL;
+
 /** Position in the cyclic buffer where the first log entry starts */
 size_t log_start = 0;
 
@@ -74,7 +113,7 @@ size_t log_used = 0;
 SPINLOCK_STATIC_INITIALIZE_NAME(log_lock, "log_lock");
 
 /** Overall count of logged messages, which may overflow as needed */
-static uint32_t log_counter = 0;
+static atomic_uint log_counter = 0;
 
 /** Starting position of the entry currently being written to the log */
 static size_t log_current_start = 0;
@@ -85,6 +124,9 @@ static size_t log_current_len = 0;
 /** Start of the next entry to be handed to uspace starting from log_start */
 static size_t next_for_uspace = 0;
 
+/** Entry being moved from a staging ring, protected by log_lock */
+static uint8_t log_merge_buffer[LOG_CPU_LENGTH];
+
 static void log_update(void *);
 
 /** Initialize kernel logging facility
@@ -92,10 +134,43 @@ static void log_update(void *);
  */
 void log_init(void)
 {
+	/*
+	 * Without staging rings, everything is written directly
+	 * to the log buffer.
+	 */
+	log_cpu_t *cpus = malloc(config.cpu_count * sizeof(log_cpu_t));
+	if (cpus != NULL) {
+		for (unsigned int i = 0; i < config.cpu_count; i++) {
+			atomic_init(&cpus[i].head, 0);
+			atomic_init(&cpus[i].tail, 0);
+			cpus[i].cur_len = 0;
+			cpus[i].overflow = false;
+			cpus[i].busy = false;
+			cpus[i].nested = 0;
+			atomic_init(&cpus[i].dropped, 0);
+			cpus[i].reported = 0;
+		}
+
+		log_cpus = cpus;
+	}
+
 	event_set_unmask_callback(EVENT_KLOG, log_update);
 	atomic_store(&log_inited, true);
 }
 
+/** Get staging ring of the current CPU.
+ *
+ * @return Staging ring or NULL if the entry is to be written directly
+ *         to the log buffer.
+ */
+static log_cpu_t *log_cpu_get(void)
+{
+	if (!atomic_load(&log_inited) || log_cpus == NULL || CPU == NULL)
+		return NULL;
+
+	return &log_cpus[CPU->id];
+}
+
 static size_t log_copy_from(uint8_t *data, size_t pos, size_t len)
 {
 	for (size_t i = 0; i < len; i++, pos = (pos + 1) % LOG_LENGTH) {
@@ -112,6 +187,20 @@ static size_t log_copy_to(const uint8_t *data, size_t pos, size_t len)
 	return pos;
 }
 
+static void log_cpu_copy_from(log_cpu_t *lc, uint8_t *data, size_t pos,
+    size_t len)
+{
+	for (size_t i = 0; i < len; i++, pos++)
+		data[i] = lc->buffer[pos % LOG_CPU_LENGTH];
+}
+
+static void log_cpu_copy_to(log_cpu_t *lc, const uint8_t *data, size_t pos,
+    size_t len)
+{
+	for (size_t i = 0; i < len; i++, pos++)
+		lc->buffer[pos % LOG_CPU_LENGTH] = data[i];
+}
+
 /** Append data to the currently open log entry.
  *
  * This function requires that the log_lock is acquired by the caller.
@@ -143,43 +232,291 @@ static void log_append(const uint8_t *data, size_t len)
 	log_current_len += len;
 }
 
-/** Begin writing an entry to the log.
+/** Start an entry in the log buffer.
  *
- * This acquires the log and output buffer locks, so only calls to log_* functions should
- * be used until calling log_end.
+ * This function requires that the log_lock is acquired by the caller.
  */
-void log_begin(log_facility_t fac, log_level_t level)
+static void log_buffer_begin(void)
 {
-	spinlock_lock(&log_lock);
-	spinlock_lock(&kio_lock);
-
 	log_current_start = (log_start + log_used) % LOG_LENGTH;
 	log_current_len = 0;
+}
 
-	/* Write header of the log entry, the length will be written in log_end() */
-	log_append((uint8_t *) &log_current_len, sizeof(size_t));
-	log_append((uint8_t *) &log_counter, sizeof(uint32_t));
+/** Finish an entry in the log buffer.
+ *
+ * This function requires that the log_lock is acquired by the caller.
+ */
+static void log_buffer_end(void)
+{
+	/* Set the length in the header to correct value */
+	log_copy_to((uint8_t *) &log_current_len, log_current_start, sizeof(size_t));
+	log_used += log_current_len;
+}
+
+/** Append data to the entry being written to a staging ring.
+ *
+ * If the entry does not fit, it is marked to be dropped in log_end().
+ */
+static void log_cpu_append(log_cpu_t *lc, const uint8_t *data, size_t len)
+{
+	if (lc->overflow)
+		return;
+
+	size_t head = atomic_load_explicit(&lc->head, memory_order_relaxed);
+	size_t tail = atomic_load_explicit(&lc->tail, memory_order_acquire);
+	if (len > LOG_CPU_LENGTH - (head - tail) - lc->cur_len) {
+		lc->overflow = true;
+		return;
+	}
+
+	log_cpu_copy_to(lc, data, head + lc->cur_len, len);
+	lc->cur_len += len;
+}
+
+/** Append entry header to the open entry. */
+static void log_header_append(log_cpu_t *lc, log_facility_t fac,
+    log_level_t level)
+{
+	/* Length and sequence number are filled in when the entry ends */
+	size_t len = 0;
+	uint32_t counter = 0;
 	uint32_t fac32 = fac;
 	uint32_t lvl32 = level;
-	log_append((uint8_t *) &fac32, sizeof(uint32_t));
-	log_append((uint8_t *) &lvl32, sizeof(uint32_t));
 
-	log_counter++;
+	if (lc != NULL) {
+		log_cpu_append(lc, (uint8_t *) &len, sizeof(size_t));
+		log_cpu_append(lc, (uint8_t *) &counter, sizeof(uint32_t));
+		log_cpu_append(lc, (uint8_t *) &fac32, sizeof(uint32_t));
+		log_cpu_append(lc, (uint8_t *) &lvl32, sizeof(uint32_t));
+	} else {
+		counter = atomic_postinc(&log_counter);
+		log_append((uint8_t *) &len, sizeof(size_t));
+		log_append((uint8_t *) &counter, sizeof(uint32_t));
+		log_append((uint8_t *) &fac32, sizeof(uint32_t));
+		log_append((uint8_t *) &lvl32, sizeof(uint32_t));
+	}
+}
+
+/** Check whether any staging ring holds committed entries. */
+static bool log_staged(void)
+{
+	if (log_cpus == NULL)
+		return false;
+
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		if (atomic_load_explicit(&log_cpus[i].tail, memory_order_relaxed) !=
+		    atomic_load_explicit(&log_cpus[i].head, memory_order_acquire))
+			return true;
+	}
+
+	return false;
+}
+
+/** Write a complete entry to the log buffer and kio.
+ *
+ * This function requires that log_lock and kio_lock are acquired by the
+ * caller.
+ *
+ * @param entry Entry including header.
+ * @param len   Length of the entry including header.
+ */
+static void log_entry_write(const uint8_t *entry, size_t len)
+{
+	log_buffer_begin();
+	log_append(entry, len);
+	log_buffer_end();
+
+	size_t offset = LOG_ENTRY_HEADER_LENGTH;
+	while (offset < len)
+		kio_push_char(str_decode((const char *) entry, &offset, len));
+	kio_push_char('\n');
+}
+
+/** Report entries dropped by a CPU since the last report.
+ *
+ * This function requires that log_lock and kio_lock are acquired by the
+ * caller.
+ */
+static void log_report_dropped(unsigned int cpu, log_cpu_t *lc)
+{
+	size_t dropped = atomic_load_explicit(&lc->dropped,
+	    memory_order_relaxed);
+	if (dropped == lc->reported)
+		return;
+
+	struct {
+		size_t len;
+		uint32_t counter;
+		uint32_t fac;
+		uint32_t lvl;
+		char msg[64];
+	} __attribute__((packed)) entry;
+
+	int n = snprintf(entry.msg, sizeof(entry.msg),
+	    "cpu%u: %zu log messages dropped", cpu, dropped - lc->reported);
+	if (n < 0)
+		return;
+
+	entry.len = LOG_ENTRY_HEADER_LENGTH + min((size_t) n,
+	    sizeof(entry.msg) - 1);
+	entry.counter = atomic_postinc(&log_counter);
+	entry.fac = LF_OTHER;
+	entry.lvl = LVL_WARN;
+	log_entry_write((uint8_t *) &entry, entry.len);
+
+	lc->reported = dropped;
+}
+
+/** Move committed entries from staging rings to the log buffer and kio.
+ *
+ * Entries are merged in the order of their sequence numbers.
+ * This function requires that log_lock and kio_lock are acquired by the
+ * caller.
+ */
+static void log_merge(void)
+{
+	while (true) {
+		log_cpu_t *next = NULL;
+		uint32_t next_counter = 0;
+
+		for (unsigned int i = 0; i < config.cpu_count; i++) {
+			log_cpu_t *lc = &log_cpus[i];
+			size_t tail = atomic_load_explicit(&lc->tail,
+			    memory_order_relaxed);
+			size_t head = atomic_load_explicit(&lc->head,
+			    memory_order_acquire);
+			if (tail == head)
+				continue;
+
+			uint32_t counter;
+			log_cpu_copy_from(lc, (uint8_t *) &counter,
+			    tail + sizeof(size_t), sizeof(uint32_t));
+
+			/* Sequence numbers may wrap around */
+			if (next == NULL ||
+			    (int32_t) (counter - next_counter) < 0) {
+				next = lc;
+				next_counter = counter;
+			}
+		}
+
+		if (next == NULL)
+			break;
+
+		size_t tail = atomic_load_explicit(&next->tail,
+		    memory_order_relaxed);
+		size_t len;
+		log_cpu_copy_from(next, (uint8_t *) &len, tail, sizeof(size_t));
+		log_cpu_copy_from(next, log_merge_buffer, tail, len);
+		atomic_store_explicit(&next->tail, tail + len,
+		    memory_order_release);
+
+		log_entry_write(log_merge_buffer, len);
+	}
+
+	for (unsigned int i = 0; i < config.cpu_count; i++)
+		log_report_dropped(i, &log_cpus[i]);
+}
+
+/** Merge staged entries unless another CPU is already doing it.
+ *
+ * If log_lock is busy, its holder rechecks the rings after releasing it,
+ * so an entry committed before calling this function is never left
+ * behind.
+ */
+static void log_flush(void)
+{
+	atomic_thread_fence(memory_order_seq_cst);
+
+	while (log_staged()) {
+		if (!spinlock_trylock(&log_lock))
+			return;
+
+		spinlock_lock(&kio_lock);
+		log_merge();
+		spinlock_unlock(&kio_lock);
+		spinlock_unlock(&log_lock);
+
+		atomic_thread_fence(memory_order_seq_cst);
+	}
+}
+
+/** Begin writing an entry to the log.
+ *
+ * Once the log is initialized, the entry is written to the staging ring of
+ * the current CPU with interrupts disabled. Before that, this acquires the
+ * log and output buffer locks. In either case, only calls to log_*
+ * functions should be used until calling log_end.
+ */
+void log_begin(log_facility_t fac, log_level_t level)
+{
+	ipl_t ipl = interrupts_disable();
+	log_cpu_t *lc = log_cpu_get();
+
+	if (lc == NULL) {
+		interrupts_restore(ipl);
+
+		spinlock_lock(&log_lock);
+		spinlock_lock(&kio_lock);
+
+		log_buffer_begin();
+		log_header_append(NULL, fac, level);
+		return;
+	}
+
+	if (lc->busy) {
+		/* Entry logged while writing another one, e.g. from a fault */
+		lc->nested++;
+		return;
+	}
+
+	lc->busy = true;
+	lc->ipl = ipl;
+	lc->cur_len = 0;
+	lc->overflow = false;
+	log_header_append(lc, fac, level);
 }
 
 /** Finish writing an entry to the log.
  *
- * This releases the log and output buffer locks.
+ * This commits the entry and merges it to the log buffer and kio, unless
+ * another CPU is doing that already.
  */
 void log_end(void)
 {
-	/* Set the length in the header to correct value */
-	log_copy_to((uint8_t *) &log_current_len, log_current_start, sizeof(size_t));
-	log_used += log_current_len;
+	log_cpu_t *lc = log_cpu_get();
 
-	kio_push_char('\n');
-	spinlock_unlock(&kio_lock);
-	spinlock_unlock(&log_lock);
+	if (lc == NULL) {
+		log_buffer_end();
+
+		kio_push_char('\n');
+		spinlock_unlock(&kio_lock);
+		spinlock_unlock(&log_lock);
+	} else if (lc->nested > 0) {
+		lc->nested--;
+		atomic_inc(&lc->dropped);
+		return;
+	} else {
+		if (lc->overflow) {
+			atomic_inc(&lc->dropped);
+		} else {
+			size_t head = atomic_load_explicit(&lc->head,
+			    memory_order_relaxed);
+			uint32_t counter = atomic_postinc(&log_counter);
+
+			log_cpu_copy_to(lc, (uint8_t *) &lc->cur_len, head,
+			    sizeof(size_t));
+			log_cpu_copy_to(lc, (uint8_t *) &counter,
+			    head + sizeof(size_t), sizeof(uint32_t));
+			atomic_store_explicit(&lc->head, head + lc->cur_len,
+			    memory_order_release);
+		}
+
+		lc->busy = false;
+		interrupts_restore(lc->ipl);
+
+		log_flush();
+	}
 
 	/* This has to be called after we released the locks above */
 	kio_flush();
@@ -192,7 +529,14 @@ static void log_update(void *event)
 	if (!atomic_load(&log_inited))
 		return;
 
-	spinlock_lock(&log_lock);
+	/*
+	 * We can be called from an interrupt handler that interrupted
+	 * the holder of log_lock on this CPU. The holder notifies the
+	 * reader itself after releasing the lock.
+	 */
+	if (!spinlock_trylock(&log_lock))
+		return;
+
 	if (next_for_uspace < log_used)
 		event_notify_0(EVENT_KLOG, true);
 	spinlock_unlock(&log_lock);
@@ -200,9 +544,16 @@ static void log_update(void *event)
 
 static int log_printf_str_write(const char *str, size_t size, void *data)
 {
+	log_cpu_t *lc = data;
 	size_t offset = 0;
 	size_t chars = 0;
 
+	if (lc != NULL) {
+		if (lc->nested == 0)
+			log_cpu_append(lc, (const uint8_t *) str, size);
+		return str_nlength(str, size);
+	}
+
 	while (offset < size) {
 		kio_push_char(str_decode(str, &offset, size));
 		chars++;
@@ -215,20 +566,27 @@ static int log_printf_str_write(const char *str, size_t size, void *data)
 
 static int log_printf_wstr_write(const char32_t *wstr, size_t size, void *data)
 {
+	log_cpu_t *lc = data;
 	char buffer[16];
 	size_t offset = 0;
 	size_t chars = 0;
 
 	for (offset = 0; offset < size; offset += sizeof(char32_t), chars++) {
-		kio_push_char(wstr[chars]);
-
 		size_t buffer_offset = 0;
 		errno_t rc = chr_encode(wstr[chars], buffer, &buffer_offset, 16);
 		if (rc != EOK) {
 			return EOF;
 		}
 
-		log_append((const uint8_t *)buffer, buffer_offset);
+		if (lc != NULL) {
+			if (lc->nested == 0) {
+				log_cpu_append(lc, (const uint8_t *) buffer,
+				    buffer_offset);
+			}
+		} else {
+			kio_push_char(wstr[chars]);
+			log_append((const uint8_t *)buffer, buffer_offset);
+		}
 	}
 
 	return chars;
@@ -242,10 +600,23 @@ int log_vprintf(const char *fmt, va_list args)
 {
 	int ret;
 
+	/*
+	 * An open entry keeps interrupts disabled, so we cannot migrate
+	 * to another CPU after checking.
+	 */
+	ipl_t ipl = interrupts_disable();
+	log_cpu_t *lc = log_cpu_get();
+	bool open = (lc != NULL && lc->busy);
+	interrupts_restore(ipl);
+
+	/* Without an open entry, only print the message */
+	if (lc != NULL && !open)
+		return vprintf(fmt, args);
+
 	printf_spec_t ps = {
 		log_printf_str_write,
 		log_printf_wstr_write,
-		NULL
+		lc
 	};
 
 	ret = printf_core(fmt, &ps, args);
@@ -324,6 +695,9 @@ sys_errno_t sys_klog(sysarg_t operation, uspace_addr_t buf, size_t size,
 		free(data);
 		return EOK;
 	case KLOG_READ:
+		/* Pick up entries still waiting in staging rings */
+		log_flush();
+
 		data = (char *) malloc(size);
 		if (!data)
 			return (sys_errno_t) ENOMEM;
@@ -365,6 +739,12 @@ sys_errno_t sys_klog(sysarg_t operation, uspace_addr_t buf, size_t size,
 
 		spinlock_unlock(&log_lock);
 
+		/* Handle entries that could not be merged while we held the lock */
+		log_flush();
+		kio_flush();
+		kio_update(NULL);
+		log_update(NULL);
+
 		if (rc != EOK) {
 			free(data);
 			return (sys_errno_t) rc;
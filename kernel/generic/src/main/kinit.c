@@ -269,7 +269,7 @@ void kinit(void *arg)
 			 */
 			perm_set(programs[i].task,
 			    PERM_PERM | PERM_MEM_MANAGER |
-			    PERM_IO_MANAGER | PERM_IRQ_REG);
+			    PERM_IO_MANAGER | PERM_IRQ_REG | PERM_DEBUG);
 
 			if (!ipc_box_0) {
 				ipc_box_0 = &programs[i].task->answerbox;
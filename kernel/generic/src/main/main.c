@@ -89,6 +89,8 @@
 #include <sysinfo/sysinfo.h>
 #include <sysinfo/stats.h>
 #include <lib/ra.h>
+#include <profile.h>
+#include <boottrace.h>
 #include <cap/cap.h>
 
 /*
@@ -295,6 +297,8 @@ void main_bsp_separated_stack(void)
 	kio_init();
 	log_init();
 	stats_init();
+	profile_init();
+	boottrace_init();
 
 	/*
 	 * Create kernel task.
@@ -39,6 +39,10 @@
 #include <mm/as.h>
 #include <mm/page.h>
 #include <mm/frame.h>
+#include <mm/km.h>
+#include <mm/tlb.h>
+#include <genarch/mm/page_pt.h>
+#include <genarch/mm/page_ht.h>
 #include <abi/mm/as.h>
 #include <abi/ipc/methods.h>
 #include <ipc/sysipc.h>
@@ -48,6 +52,8 @@
 #include <assert.h>
 #include <errno.h>
 #include <log.h>
+#include <mem.h>
+#include <config.h>
 #include <str.h>
 
 static bool user_create(as_area_t *);
@@ -95,6 +101,68 @@ bool user_is_shareable(as_area_t *area)
 	return false;
 }
 
+/** Make a private copy of a frame shared with the pager.
+ *
+ * @param frame Frame to copy.
+ * @param copy  Place to store the physical address of the copy.
+ *
+ * @return True on success, false if there is no memory for the copy.
+ */
+static bool user_frame_copy(uintptr_t frame, uintptr_t *copy)
+{
+	uintptr_t src;
+	uintptr_t dst;
+
+	dst = km_temporary_page_get(copy, FRAME_ATOMIC);
+	if (*copy == 0)
+		return false;
+
+	if (frame < config.identity_size)
+		src = PA2KA(frame);
+	else
+		src = km_map(frame, PAGE_SIZE, PAGE_SIZE,
+		    PAGE_READ | PAGE_CACHEABLE);
+
+	memcpy((void *) dst, (void *) src, PAGE_SIZE);
+	smc_coherence((void *) dst, PAGE_SIZE);
+
+	if (frame >= config.identity_size)
+		km_unmap(src, PAGE_SIZE);
+	km_temporary_page_put(dst);
+
+	return true;
+}
+
+/** Break copy-on-write sharing of a page mapped read-only.
+ *
+ * The address space area and page tables must be already locked.
+ *
+ * @param area  Pointer to the address space area.
+ * @param upage Faulting virtual page.
+ * @param frame Frame currently mapped at @a upage.
+ *
+ * @return AS_PF_FAULT on failure or AS_PF_OK on success.
+ */
+static int user_page_unshare(as_area_t *area, uintptr_t upage,
+    uintptr_t frame)
+{
+	uintptr_t copy;
+
+	if (!user_frame_copy(frame, &copy))
+		return AS_PF_FAULT;
+
+	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, AS->asid, upage, 1);
+	page_mapping_remove(AS, upage);
+	tlb_invalidate_pages(AS->asid, upage, 1);
+	as_invalidate_translation_cache(AS, upage, 1);
+	tlb_shootdown_finalize(ipl);
+
+	page_mapping_insert(AS, upage, copy, as_area_get_flags(area));
+	user_frame_free(area, upage, frame);
+
+	return AS_PF_OK;
+}
+
 /** Service a page fault in the user-paged address space area.
  *
  * The address space area and page tables must be already locked.
@@ -115,6 +183,15 @@ int user_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 	if (!as_area_check_access(area, access))
 		return AS_PF_FAULT;
 
+	/*
+	 * A write to a present page means that we have mapped a frame shared
+	 * with the pager read-only and now need to make a private copy.
+	 */
+	pte_t pte;
+	if (access == PF_ACCESS_WRITE &&
+	    page_mapping_find(AS, upage, false, &pte) && PTE_PRESENT(&pte))
+		return user_page_unshare(area, upage, PTE_GET_FRAME(&pte));
+
 	as_area_pager_info_t *pager_info = &area->backend_data.pager_info;
 
 	ipc_data_t data = { };
@@ -145,7 +222,23 @@ int user_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 	 */
 
 	uintptr_t frame = ipc_get_arg1(&data);
-	page_mapping_insert(AS, upage, frame, as_area_get_flags(area));
+	unsigned int flags = as_area_get_flags(area);
+
+	if ((ipc_get_arg2(&data) & AS_PAGE_IN_COW) && (flags & PAGE_WRITE)) {
+		if (access == PF_ACCESS_WRITE) {
+			/* Do not bother mapping the shared frame. */
+			uintptr_t copy;
+			bool copied = user_frame_copy(frame, &copy);
+			user_frame_free(area, upage, frame);
+			if (!copied)
+				return AS_PF_FAULT;
+			frame = copy;
+		} else {
+			flags &= ~PAGE_WRITE;
+		}
+	}
+
+	page_mapping_insert(AS, upage, frame, flags);
 	if (!used_space_insert(&area->used_space, upage, 1))
 		panic("Cannot insert used space.");
 
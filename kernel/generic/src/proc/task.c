@@ -58,6 +58,7 @@
 #include <str.h>
 #include <syscall/copy.h>
 #include <macros.h>
+#include <boottrace.h>
 
 /** Spinlock protecting the @c tasks ordered dictionary. */
 IRQ_SPINLOCK_INITIALIZE(tasks_lock);
@@ -257,6 +258,9 @@ task_t *task_create(as_t *as, const char *name)
 
 	irq_spinlock_unlock(&tasks_lock, true);
 
+	boottrace_record(BOOTTRACE_TASK_CREATE, TASK ? TASK->taskid : 0,
+	    task->taskid, name);
+
 	return task;
 }
 
@@ -393,6 +397,8 @@ sys_errno_t sys_task_set_name(const uspace_ptr_char uspace_name, size_t name_len
 	irq_spinlock_unlock(&TASK->lock, false);
 	irq_spinlock_unlock(&tasks_lock, true);
 
+	boottrace_record(BOOTTRACE_TASK_NAME, TASK->taskid, 0, namebuf);
+
 	return EOK;
 }
 
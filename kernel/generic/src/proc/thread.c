@@ -392,6 +392,7 @@ thread_t *thread_create(void (*func)(void *), void *arg, task_t *task,
 	thread->sleep_queue = NULL;
 	thread->timeout_pending = false;
 
+	thread->istate = NULL;
 	thread->in_copy_from_uspace = false;
 	thread->in_copy_to_uspace = false;
 
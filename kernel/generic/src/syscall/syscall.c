@@ -54,6 +54,8 @@
 #include <console/console.h>
 #include <udebug/udebug.h>
 #include <log.h>
+#include <profile.h>
+#include <boottrace.h>
 
 static syshandler_t syscall_table[] = {
 	/* System management syscalls. */
@@ -133,6 +135,12 @@ static syshandler_t syscall_table[] = {
 	[SYS_DEBUG_CONSOLE] = (syshandler_t) sys_debug_console,
 
 	[SYS_KLOG] = (syshandler_t) sys_klog,
+
+	/* Profiler syscalls. */
+	[SYS_PROFILE] = (syshandler_t) sys_profile,
+
+	/* Boot-time trace syscalls. */
+	[SYS_BOOTTRACE] = (syshandler_t) sys_boottrace,
 };
 
 /** Dispatch system call */
@@ -57,6 +57,7 @@
 #include <mm/frame.h>
 #include <ddi/ddi.h>
 #include <arch/cycle.h>
+#include <profile.h>
 
 /* Pointer to variable with uptime */
 uptime_t *uptime;
@@ -191,6 +192,9 @@ void clock(void)
 	}
 	CPU->missed_clock_ticks = 0;
 
+	/* Take a profiler sample if profiling is enabled */
+	profile_tick();
+
 	/*
 	 * Do CPU usage accounting and find out whether to preempt THREAD.
 	 *
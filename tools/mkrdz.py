@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+
+"""
+Compressed RAM disk image creator
+
+The image is split into chunks which are compressed independently
+(raw deflate), so that the RAM disk server can decompress them on
+first access. All-zero chunks are omitted, chunks which do not
+compress are stored as is and identical chunks share their data.
+"""
+
+import sys
+import zlib
+import xstruct
+
+MAGIC = b'HORDCIMG'
+VERSION = 1
+BLOCK_SIZE = 512
+DEFAULT_CHUNK_SIZE = 65536
+
+HEADER = """little:
+	char magic[8]      /* HORDCIMG */
+	uint32_t version   /* image format version */
+	uint32_t chunk_size /* uncompressed chunk size */
+	uint64_t img_size  /* uncompressed image size */
+	uint32_t chunks    /* number of chunks */
+	uint32_t reserved
+"""
+
+CHUNK = """little:
+	uint32_t offset    /* offset of chunk data */
+	uint32_t length    /* length of chunk data */
+"""
+
+def compress_chunk(data):
+	"Compress chunk into raw deflate stream"
+
+	comp = zlib.compressobj(9, zlib.DEFLATED, -15)
+	return comp.compress(data) + comp.flush()
+
+def usage(prname):
+	"Print usage syntax"
+	print("%s [--chunk-size <bytes>] <input image> <output image>" % prname)
+
+def main():
+	chunk_size = DEFAULT_CHUNK_SIZE
+	args = sys.argv[1:]
+
+	if (len(args) >= 2) and (args[0] == '--chunk-size'):
+		if (not args[1].isdigit()):
+			print("<bytes> must be a number")
+			return 1
+
+		chunk_size = int(args[1])
+		args = args[2:]
+
+	if (len(args) != 2):
+		usage(sys.argv[0])
+		return 1
+
+	if (chunk_size == 0) or (chunk_size % BLOCK_SIZE != 0):
+		print("Chunk size must be a non-zero multiple of %d" % BLOCK_SIZE)
+		return 1
+
+	with open(args[0], "rb") as inf:
+		image = inf.read()
+
+	size = len(image)
+	chunks = (size + chunk_size - 1) // chunk_size
+	zero = bytes(chunk_size)
+
+	header = xstruct.create(HEADER)
+	desc = xstruct.create(CHUNK)
+	data_offset = header.size() + chunks * desc.size()
+
+	table = []
+	blobs = []
+	shared = {}
+	offset = data_offset
+
+	for i in range(chunks):
+		data = image[i * chunk_size:(i + 1) * chunk_size]
+		data = data.ljust(chunk_size, b'\0')
+
+		if (data == zero):
+			table.append((0, 0))
+			continue
+
+		if (data in shared):
+			table.append(shared[data])
+			continue
+
+		blob = compress_chunk(data)
+		if (len(blob) >= chunk_size):
+			blob = data
+
+		entry = (offset, len(blob))
+		shared[data] = entry
+		table.append(entry)
+		blobs.append(blob)
+		offset += len(blob)
+
+	if (offset > 0xffffffff):
+		print("Compressed image too large")
+		return 1
+
+	with open(args[1], "wb") as outf:
+		header.magic = MAGIC
+		header.version = VERSION
+		header.chunk_size = chunk_size
+		header.img_size = size
+		header.chunks = chunks
+		header.reserved = 0
+		outf.write(header.pack())
+
+		for (chunk_offset, chunk_length) in table:
+			desc.offset = chunk_offset
+			desc.length = chunk_length
+			outf.write(desc.pack())
+
+		for blob in blobs:
+			outf.write(blob)
+
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main())
@@ -49,6 +49,7 @@ static const char *cmdname = "mount";
 static struct option const long_options[] = {
 	{ "help", no_argument, 0, 'h' },
 	{ "instance", required_argument, 0, 'i' },
+	{ "nocache", no_argument, 0, 'n' },
 	{ "types", no_argument, 0, 't' },
 	{ 0, 0, 0, 0 }
 };
@@ -61,6 +62,7 @@ void help_cmd_mount(unsigned int level)
 	    "Options:\n"
 	    "  -h, --help       A short option summary\n"
 	    "  -i, --instance ## Mount a specific instance\n"
+	    "  -n, --nocache    Do not cache names within the file system\n"
 	    "  -t, --types      List available file system types\n";
 
 	if (level == HELP_SHORT) {
@@ -135,6 +137,7 @@ int cmd_mount(char **argv)
 	int c, opt_ind;
 	unsigned int instance = 0;
 	bool instance_set = false;
+	unsigned int flags = 0;
 	char **t_argv;
 
 	argc = cli_count_args(argv);
@@ -145,7 +148,7 @@ int cmd_mount(char **argv)
 	opt_ind = 0;
 
 	while (c != -1) {
-		c = getopt_long(argc, argv, "i:ht", long_options, &opt_ind);
+		c = getopt_long(argc, argv, "i:nht", long_options, &opt_ind);
 		switch (c) {
 		case 'h':
 			help_cmd_mount(HELP_LONG);
@@ -154,17 +157,24 @@ int cmd_mount(char **argv)
 			instance = (unsigned int) strtol(optarg, NULL, 10);
 			instance_set = true;
 			break;
+		case 'n':
+			flags |= VFS_MOUNT_NO_DCACHE;
+			break;
 		case 't':
 			print_fstypes();
 			return CMD_SUCCESS;
 		}
 	}
 
+	t_argv = &argv[0];
 	if (instance_set) {
 		argc -= 2;
-		t_argv = &argv[2];
-	} else
-		t_argv = &argv[0];
+		t_argv += 2;
+	}
+	if (flags & VFS_MOUNT_NO_DCACHE) {
+		argc -= 1;
+		t_argv += 1;
+	}
 
 	if ((argc == 2) || (argc > 5)) {
 		printf("%s: invalid number of arguments. Try `mount --help'\n",
@@ -180,7 +190,7 @@ int cmd_mount(char **argv)
 	if (argc == 5)
 		mopts = t_argv[4];
 
-	rc = vfs_mount_path(t_argv[2], t_argv[1], dev, mopts, 0, instance);
+	rc = vfs_mount_path(t_argv[2], t_argv[1], dev, mopts, flags, instance);
 	if (rc != EOK) {
 		printf("Unable to mount %s filesystem to %s on %s (rc=%s)\n",
 		    t_argv[2], t_argv[1], t_argv[3], str_error(rc));
@@ -0,0 +1,505 @@
+/** @addtogroup boottrace
+ * @{
+ */
+/**
+ * @file
+ * @brief Boot-time trace report.
+ *
+ * Reads the boot-time event trace recorded by the kernel and system
+ * services and reports how long each task took to start and the critical
+ * path leading to a target event (by default the first terminal ready for
+ * the user).
+ *
+ * The critical path is reconstructed backwards from the target. The
+ * predecessor of an event is the previous event of the same task, or the
+ * creation of the task for its first event. When a task finished waiting
+ * for another task or for a service, the event that ended the wait (the
+ * other task getting ready, the service being registered) is the
+ * predecessor instead, unless the waiting task was still busy after it.
+ */
+
+#include <boottrace.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+
+#define NAME  "boottrace"
+
+/** Number of events read at once */
+#define BT_READ_EVENTS  64
+
+/** No event */
+#define BT_NONE  ((size_t) -1)
+
+/** Task appearing in the trace */
+typedef struct {
+	/** Task ID */
+	task_id_t id;
+	/** Last name of the task */
+	const char *name;
+	/** Index of task creation event or BT_NONE */
+	size_t create;
+	/** Index of the event reporting the task ready or BT_NONE */
+	size_t ready;
+	/** Index of the last event of the task */
+	size_t last;
+	/** Time spent by the task on the critical path */
+	uint64_t path_time;
+} bt_task_t;
+
+/** Recorded events */
+static boottrace_event_t *events;
+static size_t nevents;
+
+/** Tasks appearing in the trace */
+static bt_task_t *tasks;
+static size_t ntasks;
+
+static void print_syntax(void)
+{
+	printf("Syntax: %s [<options>]\n", NAME);
+	printf("\t-l         List all events\n");
+	printf("\t-t <name>  Target the last event with the given name or "
+	    "of the given task\n");
+}
+
+/** Read all recorded events.
+ *
+ * @return EOK on success or an error code.
+ */
+static errno_t bt_events_read(void)
+{
+	size_t cap = 0;
+	size_t nread;
+	errno_t rc;
+
+	do {
+		if (nevents + BT_READ_EVENTS > cap) {
+			cap = 2 * cap + BT_READ_EVENTS;
+			boottrace_event_t *nev = realloc(events,
+			    cap * sizeof(boottrace_event_t));
+			if (nev == NULL)
+				return ENOMEM;
+			events = nev;
+		}
+
+		rc = boottrace_read(nevents, &events[nevents], BT_READ_EVENTS,
+		    &nread);
+		if (rc != EOK)
+			return rc;
+
+		nevents += nread;
+	} while (nread > 0);
+
+	return EOK;
+}
+
+/** Find task by ID.
+ *
+ * @param id Task ID.
+ * @return Task or @c NULL if the task does not appear in the trace.
+ */
+static bt_task_t *bt_task_find(task_id_t id)
+{
+	for (size_t i = 0; i < ntasks; i++) {
+		if (tasks[i].id == id)
+			return &tasks[i];
+	}
+
+	return NULL;
+}
+
+/** Find or add task.
+ *
+ * @param id Task ID.
+ * @return Task or @c NULL if out of memory.
+ */
+static bt_task_t *bt_task_get(task_id_t id)
+{
+	bt_task_t *task = bt_task_find(id);
+	if (task != NULL)
+		return task;
+
+	bt_task_t *ntask = realloc(tasks, (ntasks + 1) * sizeof(bt_task_t));
+	if (ntask == NULL)
+		return NULL;
+
+	tasks = ntask;
+	task = &tasks[ntasks++];
+	task->id = id;
+	task->name = NULL;
+	task->create = BT_NONE;
+	task->ready = BT_NONE;
+	task->last = BT_NONE;
+	task->path_time = 0;
+	return task;
+}
+
+/** Collect tasks appearing in the trace.
+ *
+ * @return EOK on success, ENOMEM if out of memory.
+ */
+static errno_t bt_tasks_collect(void)
+{
+	for (size_t i = 0; i < nevents; i++) {
+		boottrace_event_t *ev = &events[i];
+		bt_task_t *task = bt_task_get(ev->task_id);
+		if (task == NULL)
+			return ENOMEM;
+
+		task->last = i;
+
+		switch (ev->type) {
+		case BOOTTRACE_TASK_CREATE:
+			task = bt_task_get(ev->arg);
+			if (task == NULL)
+				return ENOMEM;
+			task->create = i;
+			task->name = ev->name;
+			break;
+		case BOOTTRACE_TASK_NAME:
+			task->name = ev->name;
+			break;
+		case BOOTTRACE_TASK_READY:
+			if (task->ready == BT_NONE)
+				task->ready = i;
+			break;
+		default:
+			break;
+		}
+	}
+
+	return EOK;
+}
+
+/** Get printable task name.
+ *
+ * @param id Task ID.
+ * @return Task name.
+ */
+static const char *bt_task_name(task_id_t id)
+{
+	bt_task_t *task = bt_task_find(id);
+
+	if (id == 0)
+		return "(boot)";
+	if (task == NULL || task->name == NULL)
+		return "(unknown)";
+
+	return task->name;
+}
+
+/** Print time in milliseconds. */
+static void bt_time_print(uint64_t usec)
+{
+	printf("%5" PRIu64 ".%03" PRIu64, usec / 1000, usec % 1000);
+}
+
+/** Print event description. */
+static void bt_event_print(boottrace_event_t *ev)
+{
+	switch (ev->type) {
+	case BOOTTRACE_TASK_CREATE:
+		printf("created task %" PRIu64 " (%s)", ev->arg,
+		    bt_task_name(ev->arg));
+		break;
+	case BOOTTRACE_TASK_NAME:
+		printf("named '%s'", ev->name);
+		break;
+	case BOOTTRACE_TASK_READY:
+		printf("ready (%" PRId64 ")", (int64_t) ev->arg);
+		break;
+	case BOOTTRACE_TASK_WAIT:
+		printf("waited for task %" PRIu64 " (%s)", ev->arg, ev->name);
+		break;
+	case BOOTTRACE_NS_REGISTER:
+		printf("registered naming service %" PRIu64, ev->arg);
+		break;
+	case BOOTTRACE_LOC_REGISTER:
+		printf("registered service '%s'", ev->name);
+		break;
+	case BOOTTRACE_LOC_WAIT:
+		printf("waited for service '%s'", ev->name);
+		break;
+	case BOOTTRACE_DRIVER_ATTACH:
+		printf("attached to '%s'", ev->name);
+		break;
+	case BOOTTRACE_MOUNT:
+		printf("mounted %s (service %" PRIu64 ")", ev->name, ev->arg);
+		break;
+	case BOOTTRACE_MARK:
+		printf("mark '%s'", ev->name);
+		break;
+	default:
+		printf("event %" PRIu32 " '%s'", ev->type, ev->name);
+		break;
+	}
+}
+
+/** List all events. */
+static void bt_list(void)
+{
+	printf("    time [ms]  task\n");
+
+	for (size_t i = 0; i < nevents; i++) {
+		boottrace_event_t *ev = &events[i];
+
+		printf("    ");
+		bt_time_print(ev->time);
+		printf("  %-16s ", bt_task_name(ev->task_id));
+		bt_event_print(ev);
+		printf("\n");
+	}
+}
+
+/** Print per-task startup times. */
+static void bt_stages_print(void)
+{
+	printf("Task startup [ms]:\n");
+	printf("    created     ready  startup  task\n");
+
+	for (size_t i = 0; i < ntasks; i++) {
+		bt_task_t *task = &tasks[i];
+
+		if (task->create == BT_NONE)
+			continue;
+
+		uint64_t start = events[task->create].time;
+		size_t end = task->ready != BT_NONE ? task->ready : task->last;
+
+		printf("    ");
+		bt_time_print(start);
+		printf(" ");
+		if (task->ready != BT_NONE)
+			bt_time_print(events[task->ready].time);
+		else
+			printf("        -");
+		printf(" ");
+		bt_time_print(events[end].time - start);
+		printf("  %s\n", bt_task_name(task->id));
+	}
+}
+
+/** Find previous event of the same task.
+ *
+ * @param i Event index.
+ * @return Index of the previous event of the task or BT_NONE.
+ */
+static size_t bt_prev_own(size_t i)
+{
+	for (size_t j = i; j-- > 0;) {
+		if (events[j].task_id == events[i].task_id)
+			return j;
+	}
+
+	return BT_NONE;
+}
+
+/** Find event which ended a wait.
+ *
+ * @param i Event index of finished wait.
+ * @return Index of the event which ended the wait or BT_NONE.
+ */
+static size_t bt_wait_cause(size_t i)
+{
+	boottrace_event_t *ev = &events[i];
+
+	for (size_t j = i; j-- > 0;) {
+		boottrace_event_t *cause = &events[j];
+
+		switch (ev->type) {
+		case BOOTTRACE_TASK_WAIT:
+			if (cause->task_id == ev->arg)
+				return j;
+			break;
+		case BOOTTRACE_LOC_WAIT:
+			if (cause->type == BOOTTRACE_LOC_REGISTER &&
+			    str_cmp(cause->name, ev->name) == 0)
+				return j;
+			break;
+		default:
+			return BT_NONE;
+		}
+	}
+
+	return BT_NONE;
+}
+
+/** Find predecessor of an event on the critical path.
+ *
+ * @param i Event index.
+ * @return Index of the predecessor or BT_NONE.
+ */
+static size_t bt_pred(size_t i)
+{
+	size_t own = bt_prev_own(i);
+	size_t cause = bt_wait_cause(i);
+
+	if (cause != BT_NONE &&
+	    (own == BT_NONE || events[cause].time >= events[own].time))
+		return cause;
+
+	if (own != BT_NONE)
+		return own;
+
+	bt_task_t *task = bt_task_find(events[i].task_id);
+	if (task != NULL && task->create != BT_NONE && task->create < i)
+		return task->create;
+
+	return BT_NONE;
+}
+
+/** Find target event.
+ *
+ * @param name Event or task name or @c NULL for the default target.
+ * @return Index of the target event or BT_NONE.
+ */
+static size_t bt_target_find(const char *name)
+{
+	if (name == NULL) {
+		/* First terminal ready for the user */
+		for (size_t i = 0; i < nevents; i++) {
+			if (events[i].type == BOOTTRACE_MARK)
+				return i;
+		}
+
+		return nevents > 0 ? nevents - 1 : BT_NONE;
+	}
+
+	for (size_t i = nevents; i-- > 0;) {
+		if (str_cmp(events[i].name, name) == 0 ||
+		    str_cmp(bt_task_name(events[i].task_id), name) == 0)
+			return i;
+	}
+
+	return BT_NONE;
+}
+
+/** Print critical path leading to an event.
+ *
+ * @param target Index of the target event.
+ * @return EOK on success, ENOMEM if out of memory.
+ */
+static errno_t bt_path_print(size_t target)
+{
+	size_t *path = calloc(nevents, sizeof(size_t));
+	size_t len = 0;
+
+	if (path == NULL)
+		return ENOMEM;
+
+	/* Predecessors always have lower indices, so this terminates */
+	for (size_t i = target; i != BT_NONE; i = bt_pred(i))
+		path[len++] = i;
+
+	printf("Critical path [ms]:\n");
+	printf("        time     delta  task\n");
+
+	uint64_t prev = 0;
+	while (len-- > 0) {
+		boottrace_event_t *ev = &events[path[len]];
+		uint64_t delta = ev->time - prev;
+		bt_task_t *task = bt_task_find(ev->task_id);
+
+		if (task != NULL)
+			task->path_time += delta;
+
+		printf("    ");
+		bt_time_print(ev->time);
+		printf(" ");
+		bt_time_print(delta);
+		printf("  %-16s ", bt_task_name(ev->task_id));
+		bt_event_print(ev);
+		printf("\n");
+
+		prev = ev->time;
+	}
+
+	free(path);
+
+	printf("Critical path by task [ms]:\n");
+	for (size_t i = 0; i < ntasks; i++) {
+		if (tasks[i].path_time == 0)
+			continue;
+
+		printf("    ");
+		bt_time_print(tasks[i].path_time);
+		printf("  %s\n", bt_task_name(tasks[i].id));
+	}
+
+	return EOK;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *target_name = NULL;
+	bool list = false;
+	size_t lost;
+	errno_t rc;
+	int c;
+
+	while ((c = getopt(argc, argv, "lt:h")) != -1) {
+		switch (c) {
+		case 'l':
+			list = true;
+			break;
+		case 't':
+			target_name = optarg;
+			break;
+		case 'h':
+			print_syntax();
+			return 0;
+		default:
+			print_syntax();
+			return 1;
+		}
+	}
+
+	if (optind < argc) {
+		print_syntax();
+		return 1;
+	}
+
+	rc = bt_events_read();
+	if (rc != EOK) {
+		printf("%s: Failed reading boot trace: %s.\n", NAME,
+		    str_error(rc));
+		return 1;
+	}
+
+	rc = bt_tasks_collect();
+	if (rc != EOK) {
+		printf("%s: Out of memory.\n", NAME);
+		return 1;
+	}
+
+	if (boottrace_lost(&lost) == EOK && lost > 0)
+		printf("%s: %zu events were lost.\n", NAME, lost);
+
+	if (list)
+		bt_list();
+	else
+		bt_stages_print();
+
+	size_t target = bt_target_find(target_name);
+	if (target == BT_NONE) {
+		printf("%s: Target event not found.\n", NAME);
+		return 1;
+	}
+
+	rc = bt_path_print(target);
+	if (rc != EOK) {
+		printf("%s: Out of memory.\n", NAME);
+		return 1;
+	}
+
+	return 0;
+}
+
+/** @}
+ */
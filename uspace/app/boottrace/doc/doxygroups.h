@@ -0,0 +1,4 @@
+/** @addtogroup boottrace boottrace
+ * @brief Boot-time trace report
+ * @ingroup apps
+ */
@@ -51,6 +51,7 @@
 #include <condition_variable>
 #include <deque>
 #include <exception>
+#include <execution>
 #include <fstream>
 #include <functional>
 #include <initializer_list>
@@ -82,6 +83,8 @@
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
+#include <flat_hash_map>
+#include <flat_hash_set>
 #include <queue>
 #include <set>
 #include <map>
@@ -113,6 +116,8 @@ int main()
     ts.add<std::test::set_test>();
     ts.add<std::test::unordered_map_test>();
     ts.add<std::test::unordered_set_test>();
+    ts.add<std::test::flat_hash_test>();
+    ts.add<std::test::execution_test>();
     ts.add<std::test::numeric_test>();
     ts.add<std::test::adaptors_test>();
     ts.add<std::test::memory_test>();
@@ -121,6 +126,9 @@ int main()
     ts.add<std::test::functional_test>();
     ts.add<std::test::algorithm_test>();
     ts.add<std::test::future_test>();
+    ts.add<std::test::string_bench>();
+    ts.add<std::test::hash_table_bench>();
+    ts.add<std::test::parallel_bench>();
 
     return ts.run(true) ? 0 : 1;
 }
@@ -35,6 +35,7 @@
  */
 
 #include <errno.h>
+#include <inttypes.h>
 #include <inet/addr.h>
 #include <inet/dnsr.h>
 #include <ipc/services.h>
@@ -53,6 +54,8 @@ static void print_syntax(void)
 	printf("\t%s get-ns\n", NAME);
 	printf("\t%s set-ns <server-addr>\n", NAME);
 	printf("\t%s unset-ns\n", NAME);
+	printf("\t%s cache-stats\n", NAME);
+	printf("\t%s cache-flush\n", NAME);
 }
 
 static errno_t dnscfg_set_ns(int argc, char *argv[])
@@ -125,6 +128,40 @@ static errno_t dnscfg_print(void)
 	return EOK;
 }
 
+static errno_t dnscfg_cache_stats(void)
+{
+	dnsr_cache_stats_t stats;
+	errno_t rc = dnsr_get_cache_stats(&stats);
+	if (rc != EOK) {
+		printf("%s: Failed getting cache statistics (%s)\n",
+		    NAME, str_error(rc));
+		return rc;
+	}
+
+	printf("Entries: %" PRIu64 "/%" PRIu64 "\n", stats.entries,
+	    stats.max_entries);
+	printf("Hits: %" PRIu64 "\n", stats.hits);
+	printf("Negative hits: %" PRIu64 "\n", stats.neg_hits);
+	printf("Misses: %" PRIu64 "\n", stats.misses);
+	printf("Coalesced queries: %" PRIu64 "\n", stats.coalesced);
+	printf("Insertions: %" PRIu64 "\n", stats.inserts);
+	printf("Evictions: %" PRIu64 "\n", stats.evictions);
+	printf("Expirations: %" PRIu64 "\n", stats.expirations);
+	return EOK;
+}
+
+static errno_t dnscfg_cache_flush(void)
+{
+	errno_t rc = dnsr_flush_cache();
+	if (rc != EOK) {
+		printf("%s: Failed flushing cache (%s)\n", NAME,
+		    str_error(rc));
+		return rc;
+	}
+
+	return EOK;
+}
+
 int main(int argc, char *argv[])
 {
 	if ((argc < 2) || (str_cmp(argv[1], "get-ns") == 0))
@@ -133,6 +170,10 @@ int main(int argc, char *argv[])
 		return dnscfg_set_ns(argc - 2, argv + 2);
 	else if (str_cmp(argv[1], "unset-ns") == 0)
 		return dnscfg_unset_ns();
+	else if (str_cmp(argv[1], "cache-stats") == 0)
+		return dnscfg_cache_stats();
+	else if (str_cmp(argv[1], "cache-flush") == 0)
+		return dnscfg_cache_flush();
 	else {
 		printf("%s: Unknown command '%s'.\n", NAME, argv[1]);
 		print_syntax();
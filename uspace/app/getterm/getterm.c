@@ -33,6 +33,7 @@
  * @file
  */
 
+#include <boottrace.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <task.h>
@@ -166,6 +167,9 @@ int main(int argc, char *argv[])
 	if (print_msg)
 		welcome_msg_print();
 
+	/* The terminal is ready for the user */
+	boottrace_record(BOOTTRACE_MARK, 0, 0, term);
+
 	task_id_t id;
 	task_wait_t twait;
 
@@ -0,0 +1,171 @@
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <macros.h>
+#include <pcm/format.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * PCM mixing benchmark. Mixes a source buffer into a destination buffer
+ * one period at a time, as the sound server does for every playing
+ * source. One operation is one mixed frame, so the reported throughput
+ * is in frames/s.
+ */
+
+#define DEFAULT_SRC_FORMAT "s16le"
+#define DEFAULT_DST_FORMAT "s16le"
+#define DEFAULT_CHANNELS "2"
+#define DEFAULT_FRAMES "1024"
+
+/** Sample format names accepted by the benchmark */
+static struct {
+	const char *name;
+	pcm_sample_format_t format;
+} pcm_mix_formats[] = {
+	{ "u8", PCM_SAMPLE_UINT8 },
+	{ "s8", PCM_SAMPLE_SINT8 },
+	{ "u16le", PCM_SAMPLE_UINT16_LE },
+	{ "u16be", PCM_SAMPLE_UINT16_BE },
+	{ "s16le", PCM_SAMPLE_SINT16_LE },
+	{ "s16be", PCM_SAMPLE_SINT16_BE },
+	{ "u32le", PCM_SAMPLE_UINT32_LE },
+	{ "u32be", PCM_SAMPLE_UINT32_BE },
+	{ "s32le", PCM_SAMPLE_SINT32_LE },
+	{ "s32be", PCM_SAMPLE_SINT32_BE },
+	{ "float", PCM_SAMPLE_FLOAT32 }
+};
+
+static pcm_format_t src_format;
+static pcm_format_t dst_format;
+static size_t nframes;
+static void *src_buf = NULL;
+static void *dst_buf = NULL;
+
+static bool parse_format(bench_env_t *env, bench_run_t *run,
+    const char *param, const char *def, pcm_sample_format_t *format)
+{
+	const char *sfmt;
+	size_t i;
+
+	sfmt = bench_env_param_get(env, param, def);
+	for (i = 0; i < sizeof(pcm_mix_formats) / sizeof(pcm_mix_formats[0]);
+	    i++) {
+		if (str_cmp(sfmt, pcm_mix_formats[i].name) == 0) {
+			*format = pcm_mix_formats[i].format;
+			return true;
+		}
+	}
+
+	return bench_run_fail(run, "unknown sample format '%s'", sfmt);
+}
+
+static bool parse_uint(bench_env_t *env, bench_run_t *run,
+    const char *param, const char *def, uint64_t max, uint64_t *val)
+{
+	const char *snum;
+	errno_t rc;
+
+	snum = bench_env_param_get(env, param, def);
+	rc = str_uint64_t(snum, NULL, 10, true, val);
+	if (rc != EOK || *val == 0 || *val > max)
+		return bench_run_fail(run, "invalid %s '%s'", param, snum);
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	free(src_buf);
+	src_buf = NULL;
+	free(dst_buf);
+	dst_buf = NULL;
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	uint64_t channels;
+	uint64_t frames;
+	uint8_t *p;
+	size_t size;
+	size_t i;
+
+	if (!parse_format(env, run, "src", DEFAULT_SRC_FORMAT,
+	    &src_format.sample_format))
+		return false;
+	if (!parse_format(env, run, "dst", DEFAULT_DST_FORMAT,
+	    &dst_format.sample_format))
+		return false;
+	if (!parse_uint(env, run, "channels", DEFAULT_CHANNELS, 64, &channels))
+		return false;
+	if (!parse_uint(env, run, "frames", DEFAULT_FRAMES, 1024 * 1024,
+	    &frames))
+		return false;
+
+	src_format.channels = dst_format.channels = channels;
+	src_format.sampling_rate = dst_format.sampling_rate = 44100;
+	nframes = frames;
+
+	src_buf = malloc(nframes * pcm_format_frame_size(&src_format));
+	dst_buf = malloc(nframes * pcm_format_frame_size(&dst_format));
+	if (src_buf == NULL || dst_buf == NULL) {
+		teardown(env, run);
+		return bench_run_fail(run, "out of memory");
+	}
+
+	/* Start from silence and mix in some low-level noise */
+	pcm_format_silence(src_buf, nframes * pcm_format_frame_size(&src_format),
+	    &src_format);
+	pcm_format_silence(dst_buf, nframes * pcm_format_frame_size(&dst_format),
+	    &dst_format);
+
+	p = src_buf;
+	size = nframes * pcm_format_frame_size(&src_format);
+	if (src_format.sample_format != PCM_SAMPLE_FLOAT32) {
+		for (i = 0; i < size; i++)
+			p[i] ^= (i * 7919) & 0x0f;
+	}
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	size_t frames;
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count += frames) {
+		frames = min(nframes, niter - count);
+		rc = pcm_format_convert_and_mix(dst_buf,
+		    frames * pcm_format_frame_size(&dst_format), src_buf,
+		    frames * pcm_format_frame_size(&src_format), &src_format,
+		    &dst_format);
+		if (rc != EOK) {
+			return bench_run_fail(run, "mixing failed: %s (%d)",
+			    str_error(rc), rc);
+		}
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_pcm_mix = {
+	.name = "pcm_mix",
+	.desc = "PCM mixing and conversion, ops are frames "
+	    "(params src, dst, channels, frames)",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
@@ -38,13 +38,23 @@
 #include "hbench.h"
 
 benchmark_t *benchmarks[] = {
+	&benchmark_amap_lookup,
+	&benchmark_bd_rand_read,
+	&benchmark_bd_seq_read,
 	&benchmark_dir_read,
+	&benchmark_dl_startup,
 	&benchmark_fibril_mutex,
 	&benchmark_file_read,
 	&benchmark_malloc1,
 	&benchmark_malloc2,
 	&benchmark_ns_ping,
-	&benchmark_ping_pong
+	&benchmark_path_walk,
+	&benchmark_pcm_mix,
+	&benchmark_ping_pong,
+	&benchmark_route_lookup,
+	&benchmark_task_spawn,
+	&benchmark_tcp_xfer,
+	&benchmark_udp_xfer
 };
 
 size_t benchmark_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
@@ -0,0 +1,435 @@
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <as.h>
+#include <bd.h>
+#include <block.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <limits.h>
+#include <loc.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <vbd.h>
+#include "../hbench.h"
+
+/*
+ * Block device throughput benchmarks. Each iteration reads one request of
+ * 'blocks' blocks directly from the device (bypassing the block cache),
+ * either at consecutive addresses or at random ones. Iterations are spread
+ * evenly over 'depth' fibrils that issue their requests concurrently, so
+ * that drivers with command queueing (e.g. AHCI NCQ) can keep several
+ * requests in flight. With submit=1 a single fibril instead keeps 'depth'
+ * requests outstanding using the queued block device protocol, with data
+ * in a buffer shared with the server.
+ *
+ * With part=N the requests go to partition N of disk 'svc' (through vbd)
+ * instead of the disk itself, which allows comparing partition and raw
+ * disk throughput.
+ */
+
+#define DEFAULT_SVC "bd/ahci_0"
+#define DEFAULT_BLOCKS "128"
+#define DEFAULT_DEPTH "1"
+#define DEFAULT_SUBMIT "0"
+#define DEFAULT_PART "0"
+
+/** Maximum number of concurrent requests */
+#define BD_XFER_DEPTH_MAX 32
+/** Maximum request size in bytes */
+#define BD_XFER_REQ_MAX (1024 * 1024)
+
+/** One request issuer */
+typedef struct {
+	/** Buffer for data */
+	void *buf;
+	/** Number of requests to issue */
+	uint64_t count;
+	/** Address of the first block for sequential access */
+	aoff64_t start;
+	/** Seed for random access */
+	unsigned int seed;
+	/** Result */
+	errno_t rc;
+} bd_xfer_issuer_t;
+
+static service_id_t svc_id;
+static bool svc_open = false;
+static size_t req_blocks;
+static size_t ndepth;
+static aoff64_t nblocks;
+static bool random_access;
+static bd_xfer_issuer_t issuers[BD_XFER_DEPTH_MAX];
+/** Use queued protocol */
+static bool submit;
+/** Separate connection for the queued protocol */
+static bd_t *xbd = NULL;
+static async_sess_t *xsess = NULL;
+/** Buffer shared with the server, one request size per outstanding request */
+static void *shbuf = AS_MAP_FAILED;
+static size_t req_size;
+
+static FIBRIL_MUTEX_INITIALIZE(xfer_lock);
+static FIBRIL_CONDVAR_INITIALIZE(xfer_cv);
+/** Number of issuers that have finished */
+static size_t issuers_done;
+
+/** Simple linear congruential generator, good enough for picking blocks */
+static aoff64_t bd_xfer_rand(unsigned int *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 1;
+}
+
+/** Issuer fibril.
+ *
+ * @param arg Issuer
+ * @return EOK
+ */
+static errno_t bd_xfer_issuer_fibril(void *arg)
+{
+	bd_xfer_issuer_t *issuer = (bd_xfer_issuer_t *) arg;
+	aoff64_t span = nblocks - req_blocks + 1;
+	aoff64_t ba = issuer->start;
+	uint64_t i;
+
+	issuer->rc = EOK;
+	for (i = 0; i < issuer->count && issuer->rc == EOK; i++) {
+		if (random_access) {
+			ba = (bd_xfer_rand(&issuer->seed) % span);
+		} else if (ba >= span) {
+			ba = 0;
+		}
+
+		issuer->rc = block_read_direct(svc_id, ba, req_blocks,
+		    issuer->buf);
+		ba += req_blocks;
+	}
+
+	fibril_mutex_lock(&xfer_lock);
+	++issuers_done;
+	fibril_condvar_broadcast(&xfer_cv);
+	fibril_mutex_unlock(&xfer_lock);
+
+	return EOK;
+}
+
+/** Run benchmark keeping requests outstanding with the queued protocol.
+ *
+ * Request @c i uses slot @c i % depth of the shared buffer, requests
+ * are waited for in order of submission.
+ */
+static bool runner_submit(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	bd_req_t reqs[BD_XFER_DEPTH_MAX];
+	aoff64_t span = nblocks - req_blocks + 1;
+	aoff64_t ba = 0;
+	unsigned int seed = 1;
+	uint64_t issued = 0;
+	uint64_t done = 0;
+	size_t slot;
+	errno_t rc = EOK;
+	errno_t wrc;
+
+	bench_run_start(run);
+
+	while (done < issued || (issued < size && rc == EOK)) {
+		while (issued < size && issued - done < ndepth && rc == EOK) {
+			if (random_access) {
+				ba = bd_xfer_rand(&seed) % span;
+			} else if (ba >= span) {
+				ba = 0;
+			}
+
+			slot = issued % ndepth;
+			rc = bd_submit_read(xbd, ba, req_blocks, slot * req_size,
+			    req_size, &reqs[slot]);
+			if (rc != EOK)
+				break;
+
+			ba += req_blocks;
+			++issued;
+		}
+
+		if (done == issued)
+			break;
+
+		wrc = bd_req_wait(&reqs[done % ndepth]);
+		if (wrc != EOK && rc == EOK)
+			rc = wrc;
+		++done;
+	}
+
+	bench_run_stop(run);
+
+	if (rc != EOK)
+		return bench_run_fail(run, "read failed: %s", str_error(rc));
+
+	return true;
+}
+
+/** Find service of a partition.
+ *
+ * @param disk Disk service
+ * @param index Partition index
+ * @param rsid Place to store partition service
+ * @return EOK on success or an error code
+ */
+static errno_t bd_xfer_part_find(service_id_t disk, int index,
+    service_id_t *rsid)
+{
+	vbd_t *vbd;
+	vbd_part_info_t pinfo;
+	service_id_t *parts = NULL;
+	size_t nparts;
+	size_t i;
+	errno_t rc;
+
+	rc = vbd_create(&vbd);
+	if (rc != EOK)
+		return rc;
+
+	rc = vbd_label_get_parts(vbd, disk, &parts, &nparts);
+	if (rc != EOK)
+		goto out;
+
+	rc = ENOENT;
+	for (i = 0; i < nparts; i++) {
+		if (vbd_part_get_info(vbd, parts[i], &pinfo) != EOK)
+			continue;
+
+		if (pinfo.index == index && pinfo.svc_id != 0) {
+			*rsid = pinfo.svc_id;
+			rc = EOK;
+			break;
+		}
+	}
+
+out:
+	free(parts);
+	vbd_destroy(vbd);
+	return rc;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	fid_t fid;
+	size_t i;
+
+	if (submit)
+		return runner_submit(env, run, size);
+
+	issuers_done = 0;
+	for (i = 0; i < ndepth; i++) {
+		issuers[i].count = size / ndepth +
+		    (i < size % ndepth ? 1 : 0);
+		/* Sequential issuers read disjoint parts of the device */
+		issuers[i].start = (nblocks / ndepth) * i;
+		issuers[i].seed = i + 1;
+	}
+
+	bench_run_start(run);
+
+	for (i = 0; i < ndepth; i++) {
+		fid = fibril_create(bd_xfer_issuer_fibril, &issuers[i]);
+		if (fid == 0) {
+			/* Count it as finished so that we do not wait for it */
+			issuers[i].rc = ENOMEM;
+			fibril_mutex_lock(&xfer_lock);
+			++issuers_done;
+			fibril_mutex_unlock(&xfer_lock);
+			continue;
+		}
+
+		fibril_add_ready(fid);
+	}
+
+	fibril_mutex_lock(&xfer_lock);
+	while (issuers_done < ndepth)
+		fibril_condvar_wait(&xfer_cv, &xfer_lock);
+	fibril_mutex_unlock(&xfer_lock);
+
+	bench_run_stop(run);
+
+	for (i = 0; i < ndepth; i++) {
+		if (issuers[i].rc != EOK) {
+			return bench_run_fail(run, "read failed: %s",
+			    str_error(issuers[i].rc));
+		}
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	size_t i;
+
+	for (i = 0; i < BD_XFER_DEPTH_MAX; i++) {
+		free(issuers[i].buf);
+		issuers[i].buf = NULL;
+	}
+
+	if (xbd != NULL) {
+		bd_close(xbd);
+		xbd = NULL;
+	}
+
+	if (xsess != NULL) {
+		async_hangup(xsess);
+		xsess = NULL;
+	}
+
+	if (shbuf != AS_MAP_FAILED) {
+		as_area_destroy(shbuf);
+		shbuf = AS_MAP_FAILED;
+	}
+
+	if (svc_open) {
+		block_fini(svc_id);
+		svc_open = false;
+	}
+
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *svc;
+	const char *sblocks;
+	const char *sdepth;
+	const char *ssubmit;
+	const char *spart;
+	size_t bsize;
+	uint64_t num;
+	size_t i;
+	errno_t rc;
+
+	svc = bench_env_param_get(env, "svc", DEFAULT_SVC);
+	rc = loc_service_get_id(svc, &svc_id, 0);
+	if (rc != EOK) {
+		return bench_run_fail(run, "cannot resolve service '%s': %s",
+		    svc, str_error(rc));
+	}
+
+	spart = bench_env_param_get(env, "part", DEFAULT_PART);
+	rc = str_uint64_t(spart, NULL, 10, true, &num);
+	if (rc != EOK || num > INT_MAX)
+		return bench_run_fail(run, "invalid partition '%s'", spart);
+
+	if (num != 0) {
+		rc = bd_xfer_part_find(svc_id, num, &svc_id);
+		if (rc != EOK) {
+			return bench_run_fail(run, "cannot find partition %s "
+			    "of '%s': %s", spart, svc, str_error(rc));
+		}
+	}
+
+	rc = block_init(svc_id, 2048);
+	if (rc != EOK) {
+		return bench_run_fail(run, "cannot open '%s': %s", svc,
+		    str_error(rc));
+	}
+
+	svc_open = true;
+
+	rc = block_get_bsize(svc_id, &bsize);
+	if (rc == EOK)
+		rc = block_get_nblocks(svc_id, &nblocks);
+	if (rc != EOK) {
+		return bench_run_fail(run, "cannot query '%s': %s", svc,
+		    str_error(rc));
+	}
+
+	sblocks = bench_env_param_get(env, "blocks", DEFAULT_BLOCKS);
+	rc = str_uint64_t(sblocks, NULL, 10, true, &num);
+	if (rc != EOK || num == 0 || num * bsize > BD_XFER_REQ_MAX ||
+	    num > nblocks) {
+		return bench_run_fail(run, "invalid request size '%s'",
+		    sblocks);
+	}
+	req_blocks = num;
+
+	sdepth = bench_env_param_get(env, "depth", DEFAULT_DEPTH);
+	rc = str_uint64_t(sdepth, NULL, 10, true, &num);
+	if (rc != EOK || num == 0 || num > BD_XFER_DEPTH_MAX) {
+		return bench_run_fail(run, "invalid depth '%s'", sdepth);
+	}
+	ndepth = num;
+	req_size = req_blocks * bsize;
+
+	ssubmit = bench_env_param_get(env, "submit", DEFAULT_SUBMIT);
+	submit = str_cmp(ssubmit, "0") != 0;
+	if (submit) {
+		xsess = loc_service_connect(svc_id, INTERFACE_BLOCK, 0);
+		if (xsess == NULL)
+			return bench_run_fail(run, "cannot connect to '%s'", svc);
+
+		rc = bd_open(xsess, &xbd);
+		if (rc != EOK) {
+			return bench_run_fail(run, "cannot open '%s': %s", svc,
+			    str_error(rc));
+		}
+
+		shbuf = as_area_create(AS_AREA_ANY, ndepth * req_size,
+		    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
+		    AS_AREA_UNPAGED);
+		if (shbuf == AS_MAP_FAILED)
+			return bench_run_fail(run, "out of memory");
+
+		rc = bd_share_buf(xbd, shbuf, ndepth * req_size);
+		if (rc != EOK) {
+			return bench_run_fail(run, "cannot share buffer with "
+			    "'%s': %s", svc, str_error(rc));
+		}
+
+		return true;
+	}
+
+	for (i = 0; i < ndepth; i++) {
+		issuers[i].buf = malloc(req_size);
+		if (issuers[i].buf == NULL) {
+			teardown(env, run);
+			return bench_run_fail(run, "out of memory");
+		}
+	}
+
+	return true;
+}
+
+static bool setup_seq(bench_env_t *env, bench_run_t *run)
+{
+	random_access = false;
+	return setup(env, run);
+}
+
+static bool setup_rand(bench_env_t *env, bench_run_t *run)
+{
+	random_access = true;
+	return setup(env, run);
+}
+
+benchmark_t benchmark_bd_seq_read = {
+	.name = "bd_seq_read",
+	.desc = "Sequential direct reads from a block device "
+	    "(params 'svc', 'blocks', 'depth', 'submit', 'part').",
+	.entry = &runner,
+	.setup = &setup_seq,
+	.teardown = &teardown
+};
+
+benchmark_t benchmark_bd_rand_read = {
+	.name = "bd_rand_read",
+	.desc = "Random direct reads from a block device "
+	    "(params 'svc', 'blocks', 'depth', 'submit', 'part').",
+	.entry = &runner,
+	.setup = &setup_rand,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
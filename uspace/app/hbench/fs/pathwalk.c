@@ -0,0 +1,135 @@
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/*
+ * Path lookup benchmark. Creates a chain of nested directories with a file
+ * at the bottom and repeatedly opens the file by its full path. Each
+ * iteration also looks up a name which does not exist next to the file.
+ */
+
+#define DEFAULT_DIR "/tmp"
+#define DEFAULT_DEPTH "8"
+
+/** Longest path we build */
+#define PATH_WALK_MAX 1024
+
+static char **paths = NULL;
+static size_t npaths;
+static char missing[PATH_WALK_MAX];
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	if (paths == NULL)
+		return true;
+
+	for (size_t i = npaths; i > 0; i--) {
+		if (paths[i - 1] != NULL) {
+			(void) vfs_unlink_path(paths[i - 1]);
+			free(paths[i - 1]);
+		}
+	}
+
+	free(paths);
+	paths = NULL;
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *dir;
+	const char *sdepth;
+	uint64_t depth;
+	char path[PATH_WALK_MAX];
+	errno_t rc;
+
+	dir = bench_env_param_get(env, "dir", DEFAULT_DIR);
+	sdepth = bench_env_param_get(env, "depth", DEFAULT_DEPTH);
+	rc = str_uint64_t(sdepth, NULL, 10, true, &depth);
+	if (rc != EOK || depth == 0 || depth > 64)
+		return bench_run_fail(run, "invalid depth '%s'", sdepth);
+
+	/* Top directory, nested directories and the file */
+	npaths = depth + 2;
+	paths = calloc(npaths, sizeof(char *));
+	if (paths == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	snprintf(path, sizeof(path), "%s/hbench_path_walk", dir);
+	for (size_t i = 0; i < npaths; i++) {
+		size_t len = str_size(path);
+		if (i == npaths - 1)
+			snprintf(path + len, sizeof(path) - len, "/file");
+		else if (i > 0)
+			snprintf(path + len, sizeof(path) - len, "/dir%zu", i);
+
+		rc = vfs_link_path(path, i < npaths - 1 ? KIND_DIRECTORY :
+		    KIND_FILE, NULL);
+		if (rc != EOK) {
+			teardown(env, run);
+			return bench_run_fail(run, "failed creating %s: %s",
+			    path, str_error(rc));
+		}
+
+		paths[i] = str_dup(path);
+		if (paths[i] == NULL) {
+			(void) vfs_unlink_path(path);
+			teardown(env, run);
+			return bench_run_fail(run, "out of memory");
+		}
+	}
+
+	snprintf(missing, sizeof(missing), "%s.missing", path);
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	const char *file = paths[npaths - 1];
+	int fd;
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		rc = vfs_lookup(file, WALK_REGULAR, &fd);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed to open %s: %s",
+			    file, str_error(rc));
+		}
+
+		vfs_put(fd);
+
+		rc = vfs_lookup(missing, WALK_REGULAR, &fd);
+		if (rc != ENOENT) {
+			if (rc == EOK)
+				vfs_put(fd);
+			return bench_run_fail(run, "unexpected result looking "
+			    "up %s: %s", missing, str_error(rc));
+		}
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_path_walk = {
+	.name = "path_walk",
+	.desc = "Repeatedly open a file at the bottom of a deep directory "
+	    "tree (use 'dir' and 'depth' params to alter the defaults).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
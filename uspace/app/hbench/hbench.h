@@ -131,13 +131,23 @@ extern benchmark_t *benchmarks[];
 extern size_t benchmark_count;
 
 /* Put your benchmark descriptors here (and also to benchlist.c). */
+extern benchmark_t benchmark_amap_lookup;
+extern benchmark_t benchmark_bd_rand_read;
+extern benchmark_t benchmark_bd_seq_read;
 extern benchmark_t benchmark_dir_read;
+extern benchmark_t benchmark_dl_startup;
 extern benchmark_t benchmark_fibril_mutex;
 extern benchmark_t benchmark_file_read;
 extern benchmark_t benchmark_malloc1;
 extern benchmark_t benchmark_malloc2;
 extern benchmark_t benchmark_ns_ping;
+extern benchmark_t benchmark_path_walk;
+extern benchmark_t benchmark_pcm_mix;
 extern benchmark_t benchmark_ping_pong;
+extern benchmark_t benchmark_route_lookup;
+extern benchmark_t benchmark_task_spawn;
+extern benchmark_t benchmark_tcp_xfer;
+extern benchmark_t benchmark_udp_xfer;
 
 #endif
 
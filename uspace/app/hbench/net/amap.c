@@ -0,0 +1,148 @@
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <mem.h>
+#include <nettl/amap.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Association map lookup benchmark. Populates the map with many fully
+ * specified associations (as with a busy server) plus a listener and
+ * measures the cost of finding the association for an incoming packet.
+ */
+
+#define DEFAULT_ASSOCS "10000"
+
+static amap_t *amap = NULL;
+static inet_ep2_t *epps = NULL;
+static size_t nassocs;
+
+/** Fill in endpoint pair of the i-th test association. */
+static void amap_bench_epp(size_t i, inet_ep2_t *epp)
+{
+	memset(epp, 0, sizeof(*epp));
+	inet_addr(&epp->local.addr, 10, 0, 0, 1);
+	epp->local.port = 80;
+	inet_addr(&epp->remote.addr, 10, 1 + (i >> 16) % 254, (i >> 8) & 0xff,
+	    i & 0xff);
+	epp->remote.port = inet_port_dyn_lo + i % 1000;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	inet_ep2_t epp;
+	size_t i;
+
+	if (amap == NULL)
+		return true;
+
+	for (i = 0; i < nassocs; i++)
+		amap_remove(amap, &epps[i]);
+
+	memset(&epp, 0, sizeof(epp));
+	epp.local.port = 80;
+	amap_remove(amap, &epp);
+
+	amap_destroy(amap);
+	amap = NULL;
+	free(epps);
+	epps = NULL;
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *snum;
+	inet_ep2_t epp;
+	inet_ep2_t aepp;
+	uint64_t num;
+	size_t i;
+	errno_t rc;
+
+	snum = bench_env_param_get(env, "assocs", DEFAULT_ASSOCS);
+	rc = str_uint64_t(snum, NULL, 10, true, &num);
+	if (rc != EOK || num == 0)
+		return bench_run_fail(run, "invalid number of associations '%s'",
+		    snum);
+
+	nassocs = num;
+	epps = calloc(nassocs, sizeof(inet_ep2_t));
+	if (epps == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	rc = amap_create(&amap);
+	if (rc != EOK) {
+		free(epps);
+		epps = NULL;
+		return bench_run_fail(run, "failed creating association map: "
+		    "%s (%d)", str_error(rc), rc);
+	}
+
+	/* Listener on port 80 */
+	memset(&epp, 0, sizeof(epp));
+	epp.local.port = 80;
+	rc = amap_insert(amap, &epp, amap, af_allow_system, &aepp);
+	if (rc != EOK) {
+		amap_destroy(amap);
+		amap = NULL;
+		free(epps);
+		epps = NULL;
+		return bench_run_fail(run, "failed inserting listener: %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	for (i = 0; i < nassocs; i++) {
+		amap_bench_epp(i, &epps[i]);
+		rc = amap_insert(amap, &epps[i], &epps[i], af_allow_system,
+		    &aepp);
+		if (rc != EOK) {
+			nassocs = i;
+			teardown(env, run);
+			return bench_run_fail(run, "failed inserting "
+			    "association: %s (%d)", str_error(rc), rc);
+		}
+	}
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	inet_ep2_t epp;
+	void *arg;
+	size_t i;
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		/* Spread lookups over the whole map */
+		i = (count * 7919) % nassocs;
+		epp = epps[i];
+		rc = amap_find_match(amap, &epp, &arg);
+		if (rc != EOK || arg != &epps[i]) {
+			return bench_run_fail(run, "association %zu not found",
+			    i);
+		}
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_amap_lookup = {
+	.name = "amap_lookup",
+	.desc = "Association map lookup with many connections (param assocs)",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
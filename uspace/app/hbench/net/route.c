@@ -0,0 +1,124 @@
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <inet/addr.h>
+#include <inet/lpm.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Routing table lookup benchmark. Loads a longest prefix match table
+ * with many IPv4 routes of varying length (plus a default route) and
+ * measures the cost of finding the route for a destination. The number
+ * of distinct destinations controls how much the destination cache helps.
+ */
+
+#define DEFAULT_ROUTES "10000"
+#define DEFAULT_DESTS "4096"
+
+static INET_LPM_INITIALIZE(lpm);
+static inet_addr_t *dests = NULL;
+static size_t ndests;
+static int route_value;
+
+/** Simple deterministic pseudo-random number generator. */
+static uint32_t route_bench_rand(uint32_t *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 8;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	inet_lpm_finalize(&lpm);
+	free(dests);
+	dests = NULL;
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *sroutes;
+	const char *sdests;
+	inet_naddr_t naddr;
+	uint64_t nroutes;
+	uint64_t num;
+	uint32_t seed = 1;
+	uint32_t r;
+	size_t i;
+	errno_t rc;
+
+	sroutes = bench_env_param_get(env, "routes", DEFAULT_ROUTES);
+	rc = str_uint64_t(sroutes, NULL, 10, true, &nroutes);
+	if (rc != EOK)
+		return bench_run_fail(run, "invalid number of routes '%s'",
+		    sroutes);
+
+	sdests = bench_env_param_get(env, "dests", DEFAULT_DESTS);
+	rc = str_uint64_t(sdests, NULL, 10, true, &num);
+	if (rc != EOK || num == 0)
+		return bench_run_fail(run, "invalid number of destinations "
+		    "'%s'", sdests);
+
+	ndests = num;
+	dests = calloc(ndests, sizeof(inet_addr_t));
+	if (dests == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	inet_lpm_initialize(&lpm);
+
+	/* Default route */
+	inet_naddr(&naddr, 0, 0, 0, 0, 0);
+	rc = inet_lpm_insert(&lpm, &naddr, &route_value);
+	if (rc != EOK)
+		goto error;
+
+	for (i = 0; i < nroutes; i++) {
+		r = route_bench_rand(&seed);
+		inet_naddr(&naddr, 10, r >> 16, r >> 8, r,
+		    16 + route_bench_rand(&seed) % 13);
+		rc = inet_lpm_insert(&lpm, &naddr, &route_value);
+		if (rc != EOK && rc != EEXIST)
+			goto error;
+	}
+
+	for (i = 0; i < ndests; i++) {
+		r = route_bench_rand(&seed);
+		inet_addr(&dests[i], 10, r >> 16, r >> 8, r);
+	}
+
+	return true;
+error:
+	teardown(env, run);
+	return bench_run_fail(run, "failed inserting route: %s (%d)",
+	    str_error(rc), rc);
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		if (inet_lpm_lookup(&lpm, &dests[count % ndests]) == NULL)
+			return bench_run_fail(run, "no route to destination");
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_route_lookup = {
+	.name = "route_lookup",
+	.desc = "Routing table lookup (params routes, dests)",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
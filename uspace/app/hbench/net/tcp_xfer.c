@@ -0,0 +1,352 @@
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <inet/addr.h>
+#include <inet/endpoint.h>
+#include <inet/tcp.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * TCP transfer benchmark. Streams data over the loopback from one or more
+ * connections to connections of the same client accepted by a listener,
+ * and measures the time until all data has been received. Each iteration
+ * sends one buffer, iterations are spread evenly over the connections which
+ * all send concurrently. With ring=1 both ends use shared memory data rings
+ * instead of an IPC round trip per call.
+ */
+
+#define DEFAULT_SIZE "1024"
+#define DEFAULT_CONNS "1"
+#define DEFAULT_RING "0"
+
+/** Maximum number of concurrent connections */
+#define TCP_XFER_CONNS_MAX 64
+/** Size of each data ring */
+#define TCP_XFER_RING_SIZE 65536
+/** Size of receive buffer */
+#define TCP_XFER_RBUF_SIZE 16384
+/** Port to listen on */
+#define TCP_XFER_PORT 10007
+/** Give up if no data arrives for this long */
+#define TCP_XFER_TIMEOUT SEC2USEC(2)
+
+/** Sending side of one connection */
+typedef struct {
+	/** Connection */
+	tcp_conn_t *conn;
+	/** Number of buffers to send */
+	uint64_t count;
+	/** Result of sending */
+	errno_t rc;
+} tcp_xfer_sender_t;
+
+static tcp_t *tcp = NULL;
+static tcp_listener_t *lst = NULL;
+static tcp_xfer_sender_t senders[TCP_XFER_CONNS_MAX];
+static size_t nconns;
+static void *send_buf = NULL;
+static size_t send_size;
+static bool ring;
+
+static FIBRIL_MUTEX_INITIALIZE(xfer_lock);
+static FIBRIL_CONDVAR_INITIALIZE(xfer_cv);
+/** Number of incoming connections that have been set up */
+static size_t accepted;
+/** Number of incoming connections that have been closed */
+static size_t closed;
+/** Number of senders that have finished */
+static size_t senders_done;
+/** Number of bytes received */
+static uint64_t recv_bytes;
+/** Number of bytes to receive */
+static uint64_t recv_total;
+
+static void tcp_xfer_new_conn(tcp_listener_t *lst, tcp_conn_t *aconn)
+{
+	char *rbuf;
+	size_t nrecv;
+	errno_t rc = EOK;
+
+	rbuf = malloc(TCP_XFER_RBUF_SIZE);
+	if (rbuf == NULL)
+		rc = ENOMEM;
+
+	if (rc == EOK && ring)
+		rc = tcp_conn_ring_create(aconn, TCP_XFER_RING_SIZE);
+
+	fibril_mutex_lock(&xfer_lock);
+	++accepted;
+	fibril_condvar_broadcast(&xfer_cv);
+	fibril_mutex_unlock(&xfer_lock);
+
+	/* The connection is destroyed once we return */
+	while (rc == EOK) {
+		rc = tcp_conn_recv_wait(aconn, rbuf, TCP_XFER_RBUF_SIZE,
+		    &nrecv);
+		if (rc != EOK || nrecv == 0)
+			break;
+
+		fibril_mutex_lock(&xfer_lock);
+		recv_bytes += nrecv;
+		fibril_condvar_broadcast(&xfer_cv);
+		fibril_mutex_unlock(&xfer_lock);
+	}
+
+	fibril_mutex_lock(&xfer_lock);
+	++closed;
+	fibril_condvar_broadcast(&xfer_cv);
+	fibril_mutex_unlock(&xfer_lock);
+
+	free(rbuf);
+}
+
+static tcp_listen_cb_t tcp_xfer_listen_cb = {
+	.new_conn = tcp_xfer_new_conn
+};
+
+/** Sender fibril.
+ *
+ * @param arg Sender
+ * @return EOK
+ */
+static errno_t tcp_xfer_sender_fibril(void *arg)
+{
+	tcp_xfer_sender_t *sender = (tcp_xfer_sender_t *) arg;
+	uint64_t i;
+
+	sender->rc = EOK;
+	for (i = 0; i < sender->count && sender->rc == EOK; i++)
+		sender->rc = tcp_conn_send(sender->conn, send_buf, send_size);
+
+	fibril_mutex_lock(&xfer_lock);
+	++senders_done;
+	fibril_condvar_broadcast(&xfer_cv);
+	fibril_mutex_unlock(&xfer_lock);
+
+	return EOK;
+}
+
+/** Wait until condition holds or no progress is made for a while.
+ *
+ * Must be called with xfer_lock held.
+ *
+ * @param cond Function checking the condition
+ * @return @c true if condition holds
+ */
+static bool tcp_xfer_wait(bool (*cond)(void))
+{
+	errno_t rc = EOK;
+
+	while (!cond() && rc == EOK) {
+		rc = fibril_condvar_wait_timeout(&xfer_cv, &xfer_lock,
+		    TCP_XFER_TIMEOUT);
+	}
+
+	return cond();
+}
+
+static bool all_accepted(void)
+{
+	return accepted == nconns;
+}
+
+static bool all_closed(void)
+{
+	return closed == accepted;
+}
+
+static bool all_sent(void)
+{
+	return senders_done == nconns;
+}
+
+static bool all_received(void)
+{
+	return recv_bytes >= recv_total || closed > 0;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	size_t i;
+
+	for (i = 0; i < nconns; i++) {
+		tcp_conn_destroy(senders[i].conn);
+		senders[i].conn = NULL;
+	}
+
+	/* Wait for receiving side to see FIN */
+	fibril_mutex_lock(&xfer_lock);
+	(void) tcp_xfer_wait(all_closed);
+	fibril_mutex_unlock(&xfer_lock);
+
+	tcp_listener_destroy(lst);
+	lst = NULL;
+	tcp_destroy(tcp);
+	tcp = NULL;
+	free(send_buf);
+	send_buf = NULL;
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *ssize;
+	const char *sconns;
+	const char *sring;
+	inet_ep2_t epp;
+	inet_ep_t ep;
+	uint64_t num;
+	size_t i;
+	errno_t rc;
+
+	ssize = bench_env_param_get(env, "size", DEFAULT_SIZE);
+	rc = str_uint64_t(ssize, NULL, 10, true, &num);
+	if (rc != EOK || num == 0 || num > TCP_XFER_RING_SIZE)
+		return bench_run_fail(run, "invalid buffer size '%s'", ssize);
+	send_size = num;
+
+	sconns = bench_env_param_get(env, "conns", DEFAULT_CONNS);
+	rc = str_uint64_t(sconns, NULL, 10, true, &num);
+	if (rc != EOK || num == 0 || num > TCP_XFER_CONNS_MAX) {
+		return bench_run_fail(run, "invalid number of connections "
+		    "'%s'", sconns);
+	}
+
+	sring = bench_env_param_get(env, "ring", DEFAULT_RING);
+	ring = str_cmp(sring, "0") != 0;
+
+	send_buf = calloc(1, send_size);
+	if (send_buf == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	nconns = 0;
+	accepted = 0;
+	closed = 0;
+
+	rc = tcp_create(&tcp);
+	if (rc != EOK) {
+		free(send_buf);
+		send_buf = NULL;
+		return bench_run_fail(run, "failed connecting to TCP: %s",
+		    str_error(rc));
+	}
+
+	inet_ep_init(&ep);
+	inet_addr(&ep.addr, 127, 0, 0, 1);
+	ep.port = TCP_XFER_PORT;
+
+	rc = tcp_listener_create(tcp, &ep, &tcp_xfer_listen_cb, NULL,
+	    NULL, NULL, &lst);
+	if (rc != EOK)
+		goto error;
+
+	inet_ep2_init(&epp);
+	epp.remote = ep;
+
+	for (i = 0; i < num; i++) {
+		rc = tcp_conn_create(tcp, &epp, NULL, NULL, &senders[i].conn);
+		if (rc != EOK)
+			goto error;
+
+		++nconns;
+
+		rc = tcp_conn_wait_connected(senders[i].conn);
+		if (rc != EOK)
+			goto error;
+
+		if (ring) {
+			rc = tcp_conn_ring_create(senders[i].conn,
+			    TCP_XFER_RING_SIZE);
+			if (rc != EOK)
+				goto error;
+		}
+	}
+
+	/* Wait for the incoming connections to be set up */
+	fibril_mutex_lock(&xfer_lock);
+	if (!tcp_xfer_wait(all_accepted) || closed > 0)
+		rc = EIO;
+	fibril_mutex_unlock(&xfer_lock);
+
+	if (rc != EOK)
+		goto error;
+
+	return true;
+error:
+	teardown(env, run);
+	return bench_run_fail(run, "failed setting up connections: %s",
+	    str_error(rc));
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	fid_t fid;
+	size_t i;
+	bool ok;
+
+	fibril_mutex_lock(&xfer_lock);
+	recv_bytes = 0;
+	recv_total = niter * send_size;
+	senders_done = 0;
+	fibril_mutex_unlock(&xfer_lock);
+
+	for (i = 0; i < nconns; i++) {
+		senders[i].count = niter / nconns;
+		if (i < niter % nconns)
+			++senders[i].count;
+	}
+
+	bench_run_start(run);
+
+	for (i = 0; i < nconns; i++) {
+		fid = fibril_create(tcp_xfer_sender_fibril, &senders[i]);
+		if (fid == 0) {
+			senders[i].rc = ENOMEM;
+			fibril_mutex_lock(&xfer_lock);
+			++senders_done;
+			fibril_mutex_unlock(&xfer_lock);
+			continue;
+		}
+
+		fibril_add_ready(fid);
+	}
+
+	fibril_mutex_lock(&xfer_lock);
+	/* Senders are bounded by flow control, do not time out on them */
+	while (!all_sent())
+		fibril_condvar_wait(&xfer_cv, &xfer_lock);
+	ok = tcp_xfer_wait(all_received) && recv_bytes >= recv_total;
+	fibril_mutex_unlock(&xfer_lock);
+
+	for (i = 0; i < nconns; i++) {
+		if (senders[i].rc != EOK) {
+			return bench_run_fail(run, "failed sending data: %s",
+			    str_error(senders[i].rc));
+		}
+	}
+
+	if (!ok)
+		return bench_run_fail(run, "data not received");
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_tcp_xfer = {
+	.name = "tcp_xfer",
+	.desc = "TCP loopback transfer (params size, conns, ring)",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
@@ -0,0 +1,193 @@
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <fibril_synch.h>
+#include <inet/addr.h>
+#include <inet/endpoint.h>
+#include <inet/udp.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * UDP transfer benchmark. Sends messages over the loopback between two
+ * associations of the same client, keeping at most a fixed number of
+ * messages in flight so that none are dropped. With ring=1 both
+ * associations use shared memory message rings instead of an IPC
+ * round trip per message.
+ */
+
+#define DEFAULT_SIZE "64"
+#define DEFAULT_WINDOW "32"
+#define DEFAULT_RING "0"
+
+/** Size of each message ring */
+#define UDP_XFER_RING_SIZE 65536
+/** Port to receive messages on */
+#define UDP_XFER_PORT 10007
+/** Give up if no message arrives for this long */
+#define UDP_XFER_TIMEOUT SEC2USEC(2)
+
+static udp_t *udp = NULL;
+static udp_assoc_t *rassoc = NULL;
+static udp_assoc_t *sassoc = NULL;
+static void *msg_buf = NULL;
+static size_t msg_size;
+static uint64_t window;
+
+static FIBRIL_MUTEX_INITIALIZE(recv_lock);
+static FIBRIL_CONDVAR_INITIALIZE(recv_cv);
+static uint64_t recv_count;
+
+static void udp_xfer_recv_msg(udp_assoc_t *assoc, udp_rmsg_t *rmsg)
+{
+	fibril_mutex_lock(&recv_lock);
+	++recv_count;
+	fibril_condvar_broadcast(&recv_cv);
+	fibril_mutex_unlock(&recv_lock);
+}
+
+static udp_cb_t udp_xfer_cb = {
+	.recv_msg = udp_xfer_recv_msg
+};
+
+/** Wait until at most @a inflight sent messages are not received yet. */
+static bool udp_xfer_wait(uint64_t sent, uint64_t inflight)
+{
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&recv_lock);
+	while (sent - recv_count > inflight && rc == EOK) {
+		rc = fibril_condvar_wait_timeout(&recv_cv, &recv_lock,
+		    UDP_XFER_TIMEOUT);
+	}
+	fibril_mutex_unlock(&recv_lock);
+
+	return rc == EOK;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	udp_assoc_destroy(sassoc);
+	sassoc = NULL;
+	udp_assoc_destroy(rassoc);
+	rassoc = NULL;
+	udp_destroy(udp);
+	udp = NULL;
+	free(msg_buf);
+	msg_buf = NULL;
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *ssize;
+	const char *swindow;
+	const char *sring;
+	inet_ep2_t epp;
+	uint64_t num;
+	bool ring;
+	errno_t rc;
+
+	ssize = bench_env_param_get(env, "size", DEFAULT_SIZE);
+	rc = str_uint64_t(ssize, NULL, 10, true, &num);
+	if (rc != EOK || num > UDP_XFER_RING_SIZE / 4)
+		return bench_run_fail(run, "invalid message size '%s'", ssize);
+	msg_size = num;
+
+	swindow = bench_env_param_get(env, "window", DEFAULT_WINDOW);
+	rc = str_uint64_t(swindow, NULL, 10, true, &window);
+	if (rc != EOK || window == 0)
+		return bench_run_fail(run, "invalid window '%s'", swindow);
+
+	sring = bench_env_param_get(env, "ring", DEFAULT_RING);
+	ring = str_cmp(sring, "0") != 0;
+
+	msg_buf = calloc(1, msg_size > 0 ? msg_size : 1);
+	if (msg_buf == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	rc = udp_create(&udp);
+	if (rc != EOK) {
+		free(msg_buf);
+		msg_buf = NULL;
+		return bench_run_fail(run, "failed connecting to UDP: %s",
+		    str_error(rc));
+	}
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 127, 0, 0, 1);
+	epp.local.port = UDP_XFER_PORT;
+
+	rc = udp_assoc_create(udp, &epp, &udp_xfer_cb, NULL, &rassoc);
+	if (rc != EOK)
+		goto error;
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 127, 0, 0, 1);
+	inet_addr(&epp.remote.addr, 127, 0, 0, 1);
+	epp.remote.port = UDP_XFER_PORT;
+
+	rc = udp_assoc_create(udp, &epp, NULL, NULL, &sassoc);
+	if (rc != EOK)
+		goto error;
+
+	if (ring) {
+		rc = udp_assoc_ring_create(rassoc, UDP_XFER_RING_SIZE);
+		if (rc != EOK)
+			goto error;
+
+		rc = udp_assoc_ring_create(sassoc, UDP_XFER_RING_SIZE);
+		if (rc != EOK)
+			goto error;
+	}
+
+	return true;
+error:
+	teardown(env, run);
+	return bench_run_fail(run, "failed setting up associations: %s",
+	    str_error(rc));
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	errno_t rc;
+
+	fibril_mutex_lock(&recv_lock);
+	recv_count = 0;
+	fibril_mutex_unlock(&recv_lock);
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		if (!udp_xfer_wait(count, window - 1))
+			return bench_run_fail(run, "message lost");
+
+		rc = udp_assoc_send_msg(sassoc, NULL, msg_buf, msg_size);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed sending message: %s",
+			    str_error(rc));
+		}
+	}
+
+	if (!udp_xfer_wait(niter, 0))
+		return bench_run_fail(run, "message lost");
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_udp_xfer = {
+	.name = "udp_xfer",
+	.desc = "UDP loopback transfer (params size, window, ring)",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
@@ -0,0 +1,117 @@
+/** @addtogroup hbench
+ * @{
+ */
+/**
+ * @file Task spawn latency benchmarks
+ *
+ * Measure the time from spawning a task until it terminates. With
+ * a short-running program this is dominated by loading the program and
+ * its libraries, so it shows how much demand paging and sharing
+ * of program text save. With a dynamically linked program it also
+ * includes the time needed to link it.
+ */
+
+#include <errno.h>
+#include <str_error.h>
+#include <task.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/** Default program to spawn */
+#define SPAWN_DEFAULT_APP "/app/hello"
+
+/** Default dynamically linked program to spawn */
+#define DL_DEFAULT_APP "/app/dltest"
+
+/** File receiving output of the spawned program */
+#define SPAWN_LOG "/tmp/hbench_task_spawn.log"
+
+/** Spawn a program repeatedly and wait for it to terminate.
+ *
+ * @param run Benchmark run
+ * @param size Number of iterations
+ * @param path Program path
+ * @param arg Program argument
+ * @param check_rv Fail if the program does not return zero
+ */
+static bool spawn_run(bench_run_t *run, uint64_t size, const char *path,
+    const char *arg, bool check_rv)
+{
+	const char *const args[] = { path, arg, NULL };
+	task_id_t id;
+	task_wait_t wait;
+	task_exit_t texit;
+	int retval;
+	int fd;
+	errno_t rc;
+	bool ret = true;
+
+	rc = vfs_lookup_open(SPAWN_LOG, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_WRITE, &fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to create %s: %s",
+		    SPAWN_LOG, str_error(rc));
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		rc = task_spawnvf(&id, &wait, path, args, -1, fd, fd);
+		if (rc != EOK) {
+			ret = bench_run_fail(run, "failed to spawn %s: %s",
+			    path, str_error(rc));
+			goto leave;
+		}
+
+		rc = task_wait(&wait, &texit, &retval);
+		if (rc != EOK || texit != TASK_EXIT_NORMAL ||
+		    (check_rv && retval != 0)) {
+			ret = bench_run_fail(run, "%s did not terminate "
+			    "successfully", path);
+			goto leave;
+		}
+	}
+	bench_run_stop(run);
+
+leave:
+	vfs_put(fd);
+	(void) vfs_unlink_path(SPAWN_LOG);
+	return ret;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	const char *path = bench_env_param_get(env, "app", SPAWN_DEFAULT_APP);
+	const char *arg = bench_env_param_get(env, "arg", "--help");
+
+	return spawn_run(run, size, path, arg, false);
+}
+
+static bool dl_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	const char *path = bench_env_param_get(env, "app", DL_DEFAULT_APP);
+
+	/* Only run the tests using the implicitly linked library */
+	return spawn_run(run, size, path, "-n", true);
+}
+
+benchmark_t benchmark_task_spawn = {
+	.name = "task_spawn",
+	.desc = "Spawn a short-lived task and wait for it to finish "
+	    "(use 'app' and 'arg' params to alter the default).",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_dl_startup = {
+	.name = "dl_startup",
+	.desc = "Spawn a dynamically linked program and wait for it to finish "
+	    "(use 'app' param to alter the default).",
+	.entry = &dl_runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/**
+ * @}
+ */
@@ -33,6 +33,7 @@
  * @file
  */
 
+#include <boottrace.h>
 #include <fibril.h>
 #include <stdio.h>
 #include <stdarg.h>
@@ -236,6 +237,8 @@ static errno_t srv_startl(const char *path, ...)
 		return rc;
 	}
 
+	boottrace_record(BOOTTRACE_TASK_WAIT, 0, id, path);
+
 	if (texit != TASK_EXIT_NORMAL) {
 		printf("%s: Server %s failed to start (unexpectedly "
 		    "terminated)\n", NAME, path);
@@ -38,7 +38,10 @@
 #include <str_error.h>
 #include <str.h>
 #include <audio_mixer_iface.h>
+#include <hound/protocol.h>
+#include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define DEFAULT_SERVICE "devices/\\hw\\pci0\\00:01.0\\sb16\\control"
 
@@ -125,11 +128,55 @@ static void get_level(async_exch_t *exch, int argc, char *argv[])
 	printf("Control item %u level: %u.\n", item, value);
 }
 
+/**
+ * Print latency and underrun statistics of streams in the sound server.
+ * @return Exit code.
+ */
+static int print_streams(void)
+{
+	hound_sess_t *sess = hound_service_connect(HOUND_SERVICE);
+	if (!sess) {
+		printf("Failed to connect to sound server.\n");
+		return 1;
+	}
+
+	hound_stream_stats_t *stats = NULL;
+	size_t count = 0;
+	errno_t ret = hound_service_get_stream_stats(sess, &stats, &count);
+	hound_service_disconnect(sess);
+	if (ret != EOK) {
+		printf("Failed to get stream statistics: %s.\n",
+		    str_error(ret));
+		return 1;
+	}
+
+	printf("%zu stream(s)\n", count);
+	for (size_t i = 0; i < count; ++i) {
+		const hound_stream_stats_t *s = &stats[i];
+		printf("\n%s (%s) %u ch %u Hz %s, buffer %zu B\n",
+		    s->name, s->record ? "record" : "playback",
+		    s->format.channels, s->format.sampling_rate,
+		    pcm_sample_format_str(s->format.sample_format),
+		    s->buffer_size);
+		printf("\tframes: %" PRIu64 ", underruns: %" PRIu64
+		    ", overruns: %" PRIu64 "\n",
+		    s->frames, s->underruns, s->overruns);
+		printf("\tlatency: %lld us, max: %lld us\n",
+		    (long long) s->latency, (long long) s->latency_max);
+	}
+
+	free(stats);
+	return 0;
+}
+
 int main(int argc, char *argv[])
 {
 	const char *service = DEFAULT_SERVICE;
 	void (*command)(async_exch_t *, int, char *[]) = NULL;
 
+	if (argc == 2 && str_cmp(argv[1], "streams") == 0)
+		return print_streams();
+
 	if (argc >= 2 && str_cmp(argv[1], "setlevel") == 0) {
 		command = set_level;
 		if (argc == 5)
@@ -175,6 +222,8 @@ int main(int argc, char *argv[])
 		    "settings\n", argv[0]);
 		printf("Use '%s setlevel idx' command to change "
 		    "settings\n", argv[0]);
+		printf("Use '%s streams' command to show sound server "
+		    "stream statistics\n", argv[0]);
 	}
 
 	async_exchange_end(exch);
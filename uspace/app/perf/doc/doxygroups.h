@@ -0,0 +1,4 @@
+/** @addtogroup perf perf
+ * @brief Sampling profiler
+ * @ingroup apps
+ */
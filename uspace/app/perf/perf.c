@@ -0,0 +1,670 @@
+/** @addtogroup perf
+ * @{
+ */
+/**
+ * @file
+ * @brief Sampling profiler.
+ *
+ * Records samples taken by the kernel on clock ticks, either for a given
+ * time or while a command runs, and prints a flat profile and optionally
+ * a call graph. Userspace addresses are resolved using the symbol table
+ * of the task's executable, kernel addresses using the kernel image.
+ * Addresses in dynamically loaded libraries are reported as unknown.
+ */
+
+#include <adt/list.h>
+#include <errno.h>
+#include <fibril.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <macros.h>
+#include <profile.h>
+#include <stats.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <symtab.h>
+#include <task.h>
+#include <time.h>
+
+#define NAME  "perf"
+
+/** Default kernel image */
+#define PERF_KERNEL_PATH  "/boot/kernel.elf"
+
+/** Default recording time in seconds */
+#define PERF_DURATION_DEFAULT  5
+
+/** Default number of report lines */
+#define PERF_LINES_DEFAULT  20
+
+/** Interval between draining kernel sample buffers */
+#define PERF_DRAIN_USEC  50000
+
+/** Number of samples read at once */
+#define PERF_READ_SAMPLES  64
+
+/** Maximum number of callers printed for a function */
+#define PERF_CALLERS_MAX  5
+
+struct perf_module;
+
+/** Symbol with sample counters */
+typedef struct {
+	/** Symbol address */
+	uintptr_t addr;
+	/** Symbol name, NULL if unknown */
+	const char *name;
+	/** Containing module */
+	struct perf_module *module;
+	/** Samples with PC in this symbol */
+	size_t self;
+	/** Samples with this symbol anywhere on the stack */
+	size_t total;
+	/** Index of the last sample counted in @c total, plus one */
+	size_t stamp;
+	/** Callers, list of perf_edge_t */
+	list_t callers;
+} perf_sym_t;
+
+/** Call graph edge */
+typedef struct {
+	/** Link in perf_sym_t.callers */
+	link_t link;
+	/** Calling symbol */
+	perf_sym_t *caller;
+	/** Number of samples with this call */
+	size_t count;
+} perf_edge_t;
+
+/** Executable image */
+typedef struct perf_module {
+	/** Link in @c modules */
+	link_t link;
+	/** Module name (path of the executable) */
+	char *name;
+	/** Symbol table or NULL if it could not be loaded */
+	symtab_t *symtab;
+	/** Symbols sorted by address */
+	perf_sym_t *syms;
+	/** Number of symbols */
+	size_t nsyms;
+	/** Addresses not covered by any symbol */
+	perf_sym_t unknown;
+} perf_module_t;
+
+/** Task seen in samples */
+typedef struct {
+	/** Link in @c tasks */
+	link_t link;
+	/** Task ID */
+	task_id_t id;
+	/** Task name */
+	char *name;
+	/** Executable image, resolved when reporting */
+	perf_module_t *module;
+} perf_task_t;
+
+static const char *kernel_path = PERF_KERNEL_PATH;
+
+static list_t modules;
+static list_t tasks;
+static perf_module_t *kernel_module;
+static perf_module_t *idle_module;
+
+/** Recorded samples */
+static profile_sample_t *samples;
+static size_t samples_count;
+static size_t samples_size;
+
+/** Set when the profiled command terminates */
+static bool command_done;
+
+static void print_syntax(void)
+{
+	printf("Syntax: %s [<options>] [<command> [<args>...]]\n", NAME);
+	printf("\t-d <sec>   Record for the given time if no command is "
+	    "given (default %d)\n", PERF_DURATION_DEFAULT);
+	printf("\t-p <ticks> Sampling period in clock ticks (default 1)\n");
+	printf("\t-k <file>  Kernel image (default %s)\n", PERF_KERNEL_PATH);
+	printf("\t-n <count> Number of functions reported (default %d)\n",
+	    PERF_LINES_DEFAULT);
+	printf("\t-g         Print call graph\n");
+}
+
+/** Compare symbols by address for qsort(). */
+static int perf_sym_addr_cmp(const void *a, const void *b)
+{
+	const perf_sym_t *sa = a;
+	const perf_sym_t *sb = b;
+
+	if (sa->addr < sb->addr)
+		return -1;
+	if (sa->addr > sb->addr)
+		return 1;
+	return 0;
+}
+
+static void perf_sym_init(perf_sym_t *sym, perf_module_t *module,
+    uintptr_t addr, const char *name)
+{
+	sym->addr = addr;
+	sym->name = name;
+	sym->module = module;
+	sym->self = 0;
+	sym->total = 0;
+	sym->stamp = 0;
+	list_initialize(&sym->callers);
+}
+
+/** Build sorted symbol index of a module.
+ *
+ * Uses the same selection of symbols as symtab_addr_to_name(), but allows
+ * binary search instead of scanning the whole table for each address.
+ */
+static errno_t perf_module_index(perf_module_t *module)
+{
+	symtab_t *st = module->symtab;
+	size_t count = st->sym_size / sizeof(elf_symbol_t);
+
+	module->syms = calloc(count, sizeof(perf_sym_t));
+	if (module->syms == NULL)
+		return ENOMEM;
+
+	for (size_t i = 0; i < count; i++) {
+		if (st->sym[i].st_name == 0)
+			continue;
+
+		unsigned stype = elf_st_type(st->sym[i].st_info);
+		if (stype != STT_OBJECT && stype != STT_FUNC &&
+		    stype != STT_NOTYPE)
+			continue;
+
+		const char *sname = st->strtab + st->sym[i].st_name;
+		/* Filter out special ARM symbols. */
+		if (sname[0] == '$')
+			continue;
+
+		perf_sym_init(&module->syms[module->nsyms++], module,
+		    st->sym[i].st_value, sname);
+	}
+
+	qsort(module->syms, module->nsyms, sizeof(perf_sym_t),
+	    perf_sym_addr_cmp);
+	return EOK;
+}
+
+/** Get module for an executable, loading its symbols on first use.
+ *
+ * @param name Path of the executable.
+ * @return Module or NULL if out of memory.
+ */
+static perf_module_t *perf_module_get(const char *name)
+{
+	list_foreach(modules, link, perf_module_t, module) {
+		if (str_cmp(module->name, name) == 0)
+			return module;
+	}
+
+	perf_module_t *module = calloc(1, sizeof(perf_module_t));
+	if (module == NULL)
+		return NULL;
+
+	module->name = str_dup(name);
+	if (module->name == NULL) {
+		free(module);
+		return NULL;
+	}
+
+	perf_sym_init(&module->unknown, module, 0, NULL);
+
+	if (name[0] == '/' && symtab_load(name, &module->symtab) == EOK) {
+		if (perf_module_index(module) != EOK) {
+			symtab_delete(module->symtab);
+			module->symtab = NULL;
+		}
+	}
+
+	list_append(&module->link, &modules);
+	return module;
+}
+
+/** Find symbol containing an address.
+ *
+ * @param module Module to search.
+ * @param addr   Address to look up.
+ * @return Symbol, never NULL.
+ */
+static perf_sym_t *perf_module_lookup(perf_module_t *module, uintptr_t addr)
+{
+	size_t lo = 0;
+	size_t hi = module->nsyms;
+
+	/* Find the first symbol above @a addr */
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (module->syms[mid].addr <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == 0)
+		return &module->unknown;
+
+	return &module->syms[lo - 1];
+}
+
+/** Remember a task seen in samples.
+ *
+ * The task name is read right away, as the task might be gone by the
+ * time we report.
+ */
+static perf_task_t *perf_task_get(task_id_t id)
+{
+	list_foreach(tasks, link, perf_task_t, task) {
+		if (task->id == id)
+			return task;
+	}
+
+	perf_task_t *task = calloc(1, sizeof(perf_task_t));
+	if (task == NULL)
+		return NULL;
+
+	stats_task_t *stats = stats_get_task(id);
+	task->id = id;
+	task->name = str_dup(stats != NULL ? stats->name : "[unknown]");
+	free(stats);
+	if (task->name == NULL) {
+		free(task);
+		return NULL;
+	}
+
+	list_append(&task->link, &tasks);
+	return task;
+}
+
+/** Read samples recorded by the kernel so far. */
+static errno_t perf_drain(void)
+{
+	static profile_sample_t buf[PERF_READ_SAMPLES];
+	size_t nread;
+	errno_t rc;
+
+	while (true) {
+		rc = profile_read(buf, PERF_READ_SAMPLES, &nread);
+		if (rc != EOK)
+			return rc;
+		if (nread == 0)
+			return EOK;
+
+		if (samples_count + nread > samples_size) {
+			size_t nsize = max(samples_size * 2,
+			    samples_count + nread);
+			profile_sample_t *nsamples = realloc(samples,
+			    nsize * sizeof(profile_sample_t));
+			if (nsamples == NULL)
+				return ENOMEM;
+			samples = nsamples;
+			samples_size = nsize;
+		}
+
+		for (size_t i = 0; i < nread; i++) {
+			if ((buf[i].flags & PROFILE_SAMPLE_USPACE) != 0 &&
+			    perf_task_get(buf[i].task_id) == NULL)
+				return ENOMEM;
+			samples[samples_count++] = buf[i];
+		}
+	}
+}
+
+static errno_t perf_wait_fibril(void *arg)
+{
+	task_wait_t *wait = arg;
+	task_exit_t texit;
+	int retval;
+
+	(void) task_wait(wait, &texit, &retval);
+	command_done = true;
+	return EOK;
+}
+
+/** Count call from @a caller to @a callee. */
+static errno_t perf_edge_add(perf_sym_t *callee, perf_sym_t *caller)
+{
+	list_foreach(callee->callers, link, perf_edge_t, edge) {
+		if (edge->caller == caller) {
+			edge->count++;
+			return EOK;
+		}
+	}
+
+	perf_edge_t *edge = calloc(1, sizeof(perf_edge_t));
+	if (edge == NULL)
+		return ENOMEM;
+
+	edge->caller = caller;
+	edge->count = 1;
+	list_append(&edge->link, &callee->callers);
+	return EOK;
+}
+
+/** Attribute samples to symbols. */
+static errno_t perf_analyze(void)
+{
+	perf_sym_t *chain[1 + PROFILE_STACK_DEPTH];
+	errno_t rc;
+
+	kernel_module = perf_module_get(kernel_path);
+	idle_module = perf_module_get("[idle]");
+	if (kernel_module == NULL || idle_module == NULL)
+		return ENOMEM;
+	idle_module->unknown.name = "[idle]";
+
+	list_foreach(tasks, link, perf_task_t, task) {
+		task->module = perf_module_get(task->name);
+		if (task->module == NULL)
+			return ENOMEM;
+	}
+
+	for (size_t i = 0; i < samples_count; i++) {
+		profile_sample_t *sample = &samples[i];
+		perf_module_t *module = kernel_module;
+		size_t depth = 0;
+
+		if ((sample->flags & PROFILE_SAMPLE_IDLE) != 0) {
+			module = idle_module;
+		} else if ((sample->flags & PROFILE_SAMPLE_USPACE) != 0) {
+			module = perf_task_get(sample->task_id)->module;
+		}
+
+		chain[depth++] = perf_module_lookup(module, sample->pc);
+		for (size_t j = 0; j < sample->depth &&
+		    j < PROFILE_STACK_DEPTH; j++) {
+			/* Attribute the return address to the calling instruction */
+			chain[depth++] = perf_module_lookup(module,
+			    sample->stack[j] - 1);
+		}
+
+		chain[0]->self++;
+		for (size_t j = 0; j < depth; j++) {
+			if (chain[j]->stamp != i + 1) {
+				chain[j]->stamp = i + 1;
+				chain[j]->total++;
+			}
+
+			if (j + 1 < depth) {
+				rc = perf_edge_add(chain[j], chain[j + 1]);
+				if (rc != EOK)
+					return rc;
+			}
+		}
+	}
+
+	return EOK;
+}
+
+static int perf_sym_self_cmp(const void *a, const void *b)
+{
+	const perf_sym_t *sa = *(const perf_sym_t **) a;
+	const perf_sym_t *sb = *(const perf_sym_t **) b;
+
+	if (sa->self != sb->self)
+		return sa->self > sb->self ? -1 : 1;
+	if (sa->total != sb->total)
+		return sa->total > sb->total ? -1 : 1;
+	return 0;
+}
+
+static int perf_sym_total_cmp(const void *a, const void *b)
+{
+	const perf_sym_t *sa = *(const perf_sym_t **) a;
+	const perf_sym_t *sb = *(const perf_sym_t **) b;
+
+	if (sa->total != sb->total)
+		return sa->total > sb->total ? -1 : 1;
+	if (sa->self != sb->self)
+		return sa->self > sb->self ? -1 : 1;
+	return 0;
+}
+
+static int perf_edge_cmp(const void *a, const void *b)
+{
+	const perf_edge_t *ea = *(const perf_edge_t **) a;
+	const perf_edge_t *eb = *(const perf_edge_t **) b;
+
+	if (ea->count != eb->count)
+		return ea->count > eb->count ? -1 : 1;
+	return 0;
+}
+
+static void perf_sym_print(perf_sym_t *sym)
+{
+	const char *module = str_rchr(sym->module->name, '/');
+	module = module != NULL ? module + 1 : sym->module->name;
+
+	if (sym->name != NULL)
+		printf("%s: %s\n", module, sym->name);
+	else
+		printf("%s: [unknown]\n", module);
+}
+
+/** Print percentage of samples with two decimal places. */
+static void perf_percent_print(size_t count)
+{
+	uint64_t p = (uint64_t) count * 10000 / samples_count;
+	printf("%3" PRIu64 ".%02" PRIu64 "%% ", p / 100, p % 100);
+}
+
+/** Print callers of a symbol, most frequent first. */
+static void perf_callers_print(perf_sym_t *sym)
+{
+	size_t count = list_count(&sym->callers);
+	if (count == 0)
+		return;
+
+	perf_edge_t **edges = calloc(count, sizeof(perf_edge_t *));
+	if (edges == NULL)
+		return;
+
+	size_t i = 0;
+	list_foreach(sym->callers, link, perf_edge_t, edge)
+		edges[i++] = edge;
+
+	qsort(edges, count, sizeof(perf_edge_t *), perf_edge_cmp);
+
+	for (i = 0; i < count && i < PERF_CALLERS_MAX; i++) {
+		printf("%27s%8zu  <- ", "", edges[i]->count);
+		perf_sym_print(edges[i]->caller);
+	}
+
+	free(edges);
+}
+
+/** Print flat profile and optionally call graph. */
+static errno_t perf_report(size_t lines, bool graph)
+{
+	size_t count = 0;
+
+	list_foreach(modules, link, perf_module_t, module) {
+		count += module->nsyms + 1;
+	}
+
+	perf_sym_t **syms = calloc(count, sizeof(perf_sym_t *));
+	if (syms == NULL)
+		return ENOMEM;
+
+	/* Collect symbols with samples */
+	count = 0;
+	list_foreach(modules, link, perf_module_t, module) {
+		for (size_t i = 0; i < module->nsyms; i++) {
+			if (module->syms[i].total > 0)
+				syms[count++] = &module->syms[i];
+		}
+
+		if (module->unknown.total > 0)
+			syms[count++] = &module->unknown;
+	}
+
+	printf("\nFlat profile:\n\n");
+	printf("  Self   Total   Samples  Function\n");
+	qsort(syms, count, sizeof(perf_sym_t *), perf_sym_self_cmp);
+	for (size_t i = 0; i < count && i < lines; i++) {
+		if (syms[i]->self == 0)
+			break;
+		perf_percent_print(syms[i]->self);
+		perf_percent_print(syms[i]->total);
+		printf("%8zu  ", syms[i]->self);
+		perf_sym_print(syms[i]);
+	}
+
+	if (graph) {
+		printf("\nCall graph:\n\n");
+		printf("  Total  Self    Samples  Function / callers\n");
+		qsort(syms, count, sizeof(perf_sym_t *), perf_sym_total_cmp);
+		for (size_t i = 0; i < count && i < lines; i++) {
+			perf_percent_print(syms[i]->total);
+			perf_percent_print(syms[i]->self);
+			printf("%8zu  ", syms[i]->total);
+			perf_sym_print(syms[i]);
+			perf_callers_print(syms[i]);
+		}
+	}
+
+	free(syms);
+	return EOK;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t duration = PERF_DURATION_DEFAULT;
+	uint32_t period = 1;
+	size_t lines = PERF_LINES_DEFAULT;
+	bool graph = false;
+	task_wait_t wait;
+	task_id_t id;
+	size_t lost;
+	errno_t rc;
+	int c;
+
+	/* Stop at the first non-option, it starts the command */
+	while ((c = getopt(argc, argv, "+d:p:k:n:gh")) != -1) {
+		switch (c) {
+		case 'd':
+			rc = str_uint32_t(optarg, NULL, 10, true, &duration);
+			break;
+		case 'p':
+			rc = str_uint32_t(optarg, NULL, 10, true, &period);
+			if (rc == EOK && period == 0)
+				rc = EINVAL;
+			break;
+		case 'k':
+			kernel_path = optarg;
+			rc = EOK;
+			break;
+		case 'n':
+			rc = str_size_t(optarg, NULL, 10, true, &lines);
+			break;
+		case 'g':
+			graph = true;
+			rc = EOK;
+			break;
+		case 'h':
+			print_syntax();
+			return 0;
+		default:
+			rc = EINVAL;
+			break;
+		}
+
+		if (rc != EOK) {
+			print_syntax();
+			return 1;
+		}
+	}
+
+	list_initialize(&modules);
+	list_initialize(&tasks);
+
+	rc = profile_start(period);
+	if (rc != EOK) {
+		printf("%s: Failed starting profiler: %s.\n", NAME,
+		    str_error(rc));
+		return 1;
+	}
+
+	if (optind < argc) {
+		rc = task_spawnv(&id, &wait, argv[optind],
+		    (const char *const *) &argv[optind]);
+		if (rc != EOK) {
+			printf("%s: Failed spawning '%s': %s.\n", NAME,
+			    argv[optind], str_error(rc));
+			profile_stop();
+			return 1;
+		}
+
+		fid_t fid = fibril_create(perf_wait_fibril, &wait);
+		if (fid == NULL) {
+			printf("%s: Out of memory.\n", NAME);
+			profile_stop();
+			return 1;
+		}
+		fibril_add_ready(fid);
+	} else {
+		printf("%s: Recording for %" PRIu32 " seconds.\n", NAME,
+		    duration);
+	}
+
+	struct timespec start;
+	struct timespec now;
+	getuptime(&start);
+
+	while (true) {
+		fibril_usleep(PERF_DRAIN_USEC);
+
+		rc = perf_drain();
+		if (rc != EOK)
+			break;
+
+		if (optind < argc) {
+			if (command_done)
+				break;
+		} else {
+			getuptime(&now);
+			if (ts_sub_diff(&now, &start) >= SEC2NSEC(duration))
+				break;
+		}
+	}
+
+	profile_stop();
+	if (rc == EOK)
+		rc = perf_drain();
+	if (rc != EOK) {
+		printf("%s: Failed reading samples: %s.\n", NAME,
+		    str_error(rc));
+		return 1;
+	}
+
+	if (profile_lost(&lost) != EOK)
+		lost = 0;
+
+	printf("%s: %zu samples, %zu lost.\n", NAME, samples_count, lost);
+	if (samples_count == 0)
+		return 0;
+
+	rc = perf_analyze();
+	if (rc == EOK)
+		rc = perf_report(lines, graph);
+	if (rc != EOK) {
+		printf("%s: Failed creating report: %s.\n", NAME,
+		    str_error(rc));
+		return 1;
+	}
+
+	return 0;
+}
+
+/** @}
+ */
@@ -113,7 +113,11 @@ const sc_desc_t syscall_desc[] = {
 	/* Kernel console syscalls. */
 	[SYS_DEBUG_CONSOLE] = { "debug_console", 0, V_ERRNO },
 
-	[SYS_KLOG] = { "klog", 5, V_ERRNO }
+	[SYS_KLOG] = { "klog", 5, V_ERRNO },
+
+	[SYS_PROFILE] = { "profile", 5, V_ERRNO },
+
+	[SYS_BOOTTRACE] = { "boottrace", 5, V_ERRNO }
 };
 
 const size_t syscall_desc_len = (sizeof(syscall_desc) / sizeof(sc_desc_t));
@@ -32,6 +32,7 @@
 
 #include <as.h>
 #include <errno.h>
+#include <macros.h>
 #include <stdio.h>
 #include <ddf/interrupt.h>
 #include <ddf/log.h>
@@ -116,8 +117,7 @@ static errno_t write_blocks(ddf_fun_t *, uint64_t, size_t, void *);
 
 static errno_t ahci_identify_device(sata_dev_t *);
 static errno_t ahci_set_highest_ultra_dma_mode(sata_dev_t *);
-static errno_t ahci_rb_fpdma(sata_dev_t *, uintptr_t, uint64_t);
-static errno_t ahci_wb_fpdma(sata_dev_t *, uintptr_t, uint64_t);
+static errno_t ahci_rw_fpdma(sata_dev_t *, uint64_t, size_t, void *, bool);
 
 static void ahci_sata_devices_create(ahci_dev_t *, ddf_dev_t *);
 static ahci_dev_t *ahci_ahci_create(ddf_dev_t *);
@@ -214,7 +214,7 @@ static errno_t get_block_size(ddf_fun_t *fun, size_t *block_size)
 	return EOK;
 }
 
-/** Read data blocks into SATA device.
+/** Read data blocks from SATA device.
  *
  * @param fun      Device function handling the call.
  * @param blocknum Number of first block.
@@ -228,33 +228,7 @@ static errno_t read_blocks(ddf_fun_t *fun, uint64_t blocknum,
     size_t count, void *buf)
 {
 	sata_dev_t *sata = fun_sata_dev(fun);
-
-	uintptr_t phys;
-	void *ibuf = AS_AREA_ANY;
-	errno_t rc = dmamem_map_anonymous(sata->block_size, DMAMEM_4GiB,
-	    AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &ibuf);
-	if (rc != EOK) {
-		ddf_msg(LVL_ERROR, "Cannot allocate read buffer.");
-		return rc;
-	}
-
-	memset(buf, 0, sata->block_size);
-
-	fibril_mutex_lock(&sata->lock);
-
-	for (size_t cur = 0; cur < count; cur++) {
-		rc = ahci_rb_fpdma(sata, phys, blocknum + cur);
-		if (rc != EOK)
-			break;
-
-		memcpy((void *) (((uint8_t *) buf) + (sata->block_size * cur)),
-		    ibuf, sata->block_size);
-	}
-
-	fibril_mutex_unlock(&sata->lock);
-	dmamem_unmap_anonymous(ibuf);
-
-	return rc;
+	return ahci_rw_fpdma(sata, blocknum, count, buf, false);
 }
 
 /** Write data blocks into SATA device.
@@ -271,30 +245,7 @@ static errno_t write_blocks(ddf_fun_t *fun, uint64_t blocknum,
     size_t count, void *buf)
 {
 	sata_dev_t *sata = fun_sata_dev(fun);
-
-	uintptr_t phys;
-	void *ibuf = AS_AREA_ANY;
-	errno_t rc = dmamem_map_anonymous(sata->block_size, DMAMEM_4GiB,
-	    AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &ibuf);
-	if (rc != EOK) {
-		ddf_msg(LVL_ERROR, "Cannot allocate write buffer.");
-		return rc;
-	}
-
-	fibril_mutex_lock(&sata->lock);
-
-	for (size_t cur = 0; cur < count; cur++) {
-		memcpy(ibuf, (void *) (((uint8_t *) buf) + (sata->block_size * cur)),
-		    sata->block_size);
-		rc = ahci_wb_fpdma(sata, phys, blocknum + cur);
-		if (rc != EOK)
-			break;
-	}
-
-	fibril_mutex_unlock(&sata->lock);
-	dmamem_unmap_anonymous(ibuf);
-
-	return rc;
+	return ahci_rw_fpdma(sata, blocknum, count, buf, true);
 }
 
 /*
@@ -335,7 +286,7 @@ static ahci_port_is_t ahci_wait_event(sata_dev_t *sata)
 static void ahci_identify_device_cmd(sata_dev_t *sata, uintptr_t phys)
 {
 	volatile sata_std_command_frame_t *cmd =
-	    (sata_std_command_frame_t *) sata->cmd_table;
+	    (sata_std_command_frame_t *) sata->slots[0].cmd_table;
 
 	cmd->fis_type = SATA_CMD_FIS_TYPE;
 	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
@@ -351,7 +302,7 @@ static void ahci_identify_device_cmd(sata_dev_t *sata, uintptr_t phys)
 	cmd->reserved2 = 0;
 
 	volatile ahci_cmd_prdt_t *prdt =
-	    (ahci_cmd_prdt_t *) (&sata->cmd_table[0x20]);
+	    (ahci_cmd_prdt_t *) (&sata->slots[0].cmd_table[0x20]);
 
 	prdt->data_address_low = LO(phys);
 	prdt->data_address_upper = HI(phys);
@@ -380,7 +331,7 @@ static void ahci_identify_device_cmd(sata_dev_t *sata, uintptr_t phys)
 static void ahci_identify_packet_device_cmd(sata_dev_t *sata, uintptr_t phys)
 {
 	volatile sata_std_command_frame_t *cmd =
-	    (sata_std_command_frame_t *) sata->cmd_table;
+	    (sata_std_command_frame_t *) sata->slots[0].cmd_table;
 
 	cmd->fis_type = SATA_CMD_FIS_TYPE;
 	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
@@ -396,7 +347,7 @@ static void ahci_identify_packet_device_cmd(sata_dev_t *sata, uintptr_t phys)
 	cmd->reserved2 = 0;
 
 	volatile ahci_cmd_prdt_t *prdt =
-	    (ahci_cmd_prdt_t *) (&sata->cmd_table[0x20]);
+	    (ahci_cmd_prdt_t *) (&sata->slots[0].cmd_table[0x20]);
 
 	prdt->data_address_low = LO(phys);
 	prdt->data_address_upper = HI(phys);
@@ -468,6 +419,7 @@ static errno_t ahci_identify_device(sata_dev_t *sata)
 	}
 
 	ahci_get_model_name(idata->model_name, sata->model);
+	sata->queue_depth = (idata->queue_depth & 0x1f) + 1;
 
 	/*
 	 * Due to QEMU limitation (as of 2012-06-22),
@@ -561,7 +513,7 @@ error:
 static void ahci_set_mode_cmd(sata_dev_t *sata, uintptr_t phys, uint8_t mode)
 {
 	volatile sata_std_command_frame_t *cmd =
-	    (sata_std_command_frame_t *) sata->cmd_table;
+	    (sata_std_command_frame_t *) sata->slots[0].cmd_table;
 
 	cmd->fis_type = SATA_CMD_FIS_TYPE;
 	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
@@ -577,7 +529,7 @@ static void ahci_set_mode_cmd(sata_dev_t *sata, uintptr_t phys, uint8_t mode)
 	cmd->reserved2 = 0;
 
 	volatile ahci_cmd_prdt_t *prdt =
-	    (ahci_cmd_prdt_t *) (&sata->cmd_table[0x20]);
+	    (ahci_cmd_prdt_t *) (&sata->slots[0].cmd_table[0x20]);
 
 	prdt->data_address_low = LO(phys);
 	prdt->data_address_upper = HI(phys);
@@ -668,110 +620,65 @@ error:
 	return EINTR;
 }
 
-/** Set AHCI registers for reading one sector from the SATA device using FPDMA.
+/** Fill PRD table of a command slot.
  *
- * @param sata     SATA device structure.
- * @param phys     Physical address of buffer for sector data.
- * @param blocknum Block number to read.
+ * The data region is split into entries of at most AHCI_PRDT_DBC_MAX
+ * bytes each.
  *
- */
-static void ahci_rb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
-    uint64_t blocknum)
-{
-	volatile sata_ncq_command_frame_t *cmd =
-	    (sata_ncq_command_frame_t *) sata->cmd_table;
-
-	cmd->fis_type = SATA_CMD_FIS_TYPE;
-	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
-	cmd->command = 0x60;
-	cmd->tag = 0;
-	cmd->control = 0;
-
-	cmd->reserved1 = 0;
-	cmd->reserved2 = 0;
-	cmd->reserved3 = 0;
-	cmd->reserved4 = 0;
-	cmd->reserved5 = 0;
-	cmd->reserved6 = 0;
-
-	cmd->sector_count_low = 1;
-	cmd->sector_count_high = 0;
-
-	cmd->lba0 = blocknum & 0xff;
-	cmd->lba1 = (blocknum >> 8) & 0xff;
-	cmd->lba2 = (blocknum >> 16) & 0xff;
-	cmd->lba3 = (blocknum >> 24) & 0xff;
-	cmd->lba4 = (blocknum >> 32) & 0xff;
-	cmd->lba5 = (blocknum >> 40) & 0xff;
-
-	volatile ahci_cmd_prdt_t *prdt =
-	    (ahci_cmd_prdt_t *) (&sata->cmd_table[0x20]);
-
-	prdt->data_address_low = LO(phys);
-	prdt->data_address_upper = HI(phys);
-	prdt->reserved1 = 0;
-	prdt->dbc = sata->block_size - 1;
-	prdt->reserved2 = 0;
-	prdt->ioc = 0;
-
-	sata->cmd_header->prdtl = 1;
-	sata->cmd_header->flags =
-	    AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK |
-	    AHCI_CMDHDR_FLAGS_5DWCMD;
-	sata->cmd_header->bytesprocessed = 0;
-
-	sata->port->pxsact |= 1;
-	sata->port->pxci |= 1;
-}
-
-/** Read one sector from the SATA device using FPDMA.
+ * @param slot Command slot.
+ * @param phys Physical address of the data region.
+ * @param size Size of the data region (in bytes, must be even).
  *
- * @param sata     SATA device structure.
- * @param phys     Physical address of buffer for sector data.
- * @param blocknum Block number to read.
- *
- * @return EOK if succeed, error code otherwise
+ * @return Number of PRD entries used.
  *
  */
-static errno_t ahci_rb_fpdma(sata_dev_t *sata, uintptr_t phys, uint64_t blocknum)
+static uint16_t ahci_slot_prdt_fill(ahci_slot_t *slot, uintptr_t phys,
+    size_t size)
 {
-	if (sata->is_invalid_device) {
-		ddf_msg(LVL_ERROR,
-		    "%s: FPDMA read from invalid device", sata->model);
-		return EINTR;
+	volatile ahci_cmd_prdt_t *prdt = (ahci_cmd_prdt_t *)
+	    (&slot->cmd_table[AHCI_CMDTABLE_PRDT_OFFSET / sizeof(uint32_t)]);
+	uint16_t entries = 0;
+
+	while ((size > 0) && (entries < AHCI_SLOT_PRDT_ENTRIES)) {
+		size_t len = min(size, AHCI_PRDT_DBC_MAX);
+
+		prdt[entries].data_address_low = LO(phys);
+		prdt[entries].data_address_upper = HI(phys);
+		prdt[entries].reserved1 = 0;
+		prdt[entries].dbc = len - 1;
+		prdt[entries].reserved2 = 0;
+		prdt[entries].ioc = 0;
+
+		phys += len;
+		size -= len;
+		entries++;
 	}
 
-	ahci_rb_fpdma_cmd(sata, phys, blocknum);
-	ahci_port_is_t pxis = ahci_wait_event(sata);
-
-	if ((sata->is_invalid_device) || (ahci_port_is_error(pxis))) {
-		ddf_msg(LVL_ERROR,
-		    "%s: Unrecoverable error during FPDMA read", sata->model);
-		return EINTR;
-	}
-
-	return EOK;
+	return entries;
 }
 
-/** Set AHCI registers for writing one sector to the SATA device, use FPDMA.
+/** Set AHCI registers for a queued FPDMA transfer and issue it.
  *
- * @param sata     SATA device structure.
- * @param phys     Physical address of buffer with sector data.
- * @param blocknum Block number to write.
+ * The event lock must be held by the caller.
  *
- * @return EOK if succeed, error code otherwise
+ * @param sata     SATA device structure.
+ * @param tag      Command slot (NCQ tag) to use.
+ * @param blocknum Number of first block.
+ * @param count    Number of blocks to transfer.
+ * @param write    Transfer direction.
  *
  */
-static void ahci_wb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
-    uint64_t blocknum)
+static void ahci_fpdma_cmd(sata_dev_t *sata, unsigned int tag,
+    uint64_t blocknum, size_t count, bool write)
 {
+	ahci_slot_t *slot = &sata->slots[tag];
 	volatile sata_ncq_command_frame_t *cmd =
-	    (sata_ncq_command_frame_t *) sata->cmd_table;
+	    (sata_ncq_command_frame_t *) slot->cmd_table;
 
 	cmd->fis_type = SATA_CMD_FIS_TYPE;
 	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
-	cmd->command = 0x61;
-	cmd->tag = 0;
+	cmd->command = write ? 0x61 : 0x60;
+	cmd->tag = tag << 3;
 	cmd->control = 0;
 
 	cmd->reserved1 = 0;
@@ -781,8 +688,8 @@ static void ahci_wb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
 	cmd->reserved5 = 0;
 	cmd->reserved6 = 0;
 
-	cmd->sector_count_low = 1;
-	cmd->sector_count_high = 0;
+	cmd->sector_count_low = count & 0xff;
+	cmd->sector_count_high = (count >> 8) & 0xff;
 
 	cmd->lba0 = blocknum & 0xff;
 	cmd->lba1 = (blocknum >> 8) & 0xff;
@@ -791,54 +698,141 @@ static void ahci_wb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
 	cmd->lba4 = (blocknum >> 32) & 0xff;
 	cmd->lba5 = (blocknum >> 40) & 0xff;
 
-	volatile ahci_cmd_prdt_t *prdt =
-	    (ahci_cmd_prdt_t *) (&sata->cmd_table[0x20]);
+	volatile ahci_cmdhdr_t *cmd_header = &sata->cmd_header[tag];
 
-	prdt->data_address_low = LO(phys);
-	prdt->data_address_upper = HI(phys);
-	prdt->reserved1 = 0;
-	prdt->dbc = sata->block_size - 1;
-	prdt->reserved2 = 0;
-	prdt->ioc = 0;
-
-	sata->cmd_header->prdtl = 1;
-	sata->cmd_header->flags =
+	cmd_header->prdtl = ahci_slot_prdt_fill(slot, slot->buf_phys,
+	    count * sata->block_size);
+	cmd_header->flags =
 	    AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK |
-	    AHCI_CMDHDR_FLAGS_WRITE |
 	    AHCI_CMDHDR_FLAGS_5DWCMD;
-	sata->cmd_header->bytesprocessed = 0;
+	if (write)
+		cmd_header->flags |= AHCI_CMDHDR_FLAGS_WRITE;
+	cmd_header->bytesprocessed = 0;
 
-	sata->port->pxsact |= 1;
-	sata->port->pxci |= 1;
+	slot->done = false;
+	slot->rc = EOK;
+	sata->slots_issued |= 1U << tag;
+
+	/*
+	 * Both registers are write-one-to-set, only the bit of this
+	 * tag may be written, otherwise commands which have just
+	 * finished would be issued again.
+	 */
+	sata->port->pxsact = 1U << tag;
+	sata->port->pxci = 1U << tag;
 }
 
-/** Write one sector into the SATA device, use FPDMA.
+/** Transfer data blocks using queued FPDMA commands.
+ *
+ * The transfer is split into chunks of at most AHCI_SLOT_BUF_SIZE
+ * bytes. Each chunk is issued as a separate NCQ command in its own
+ * command slot, so that several chunks (and several concurrent
+ * requests) are in flight at the same time.
+ *
+ * To avoid a deadlock between requests, a request only blocks waiting
+ * for a free slot if it does not own any slot. Otherwise it first
+ * retires its oldest command.
  *
  * @param sata     SATA device structure.
- * @param phys     Physical address of buffer with sector data.
- * @param blocknum Block number to write.
+ * @param blocknum Number of first block.
+ * @param count    Number of blocks to transfer.
+ * @param buf      Data buffer.
+ * @param write    Transfer direction.
  *
  * @return EOK if succeed, error code otherwise
  *
  */
-static errno_t ahci_wb_fpdma(sata_dev_t *sata, uintptr_t phys, uint64_t blocknum)
+static errno_t ahci_rw_fpdma(sata_dev_t *sata, uint64_t blocknum,
+    size_t count, void *buf, bool write)
 {
-	if (sata->is_invalid_device) {
-		ddf_msg(LVL_ERROR,
-		    "%s: FPDMA write to invalid device", sata->model);
-		return EINTR;
-	}
+	/* Slots owned by this request in the order of issue */
+	unsigned int owned[AHCI_SLOTS_MAX];
+	size_t owned_pos[AHCI_SLOTS_MAX];
+	size_t owned_cnt[AHCI_SLOTS_MAX];
+	unsigned int head = 0;
+	unsigned int nowned = 0;
+
+	size_t chunk = AHCI_SLOT_BUF_SIZE / sata->block_size;
+	size_t pos = 0;
+	errno_t rc = EOK;
 
-	ahci_wb_fpdma_cmd(sata, phys, blocknum);
-	ahci_port_is_t pxis = ahci_wait_event(sata);
+	fibril_mutex_lock(&sata->event_lock);
 
-	if ((sata->is_invalid_device) || (ahci_port_is_error(pxis))) {
-		ddf_msg(LVL_ERROR,
-		    "%s: Unrecoverable error during FPDMA write", sata->model);
-		return EINTR;
+	while (((pos < count) && (rc == EOK)) || (nowned > 0)) {
+		if ((sata->is_invalid_device) && (rc == EOK)) {
+			ddf_msg(LVL_ERROR, "%s: FPDMA %s on invalid device",
+			    sata->model, write ? "write" : "read");
+			rc = EINTR;
+		}
+
+		if ((pos < count) && (rc == EOK)) {
+			if ((sata->slots_free != 0) && (!sata->recovering)) {
+				unsigned int tag = 0;
+				while ((sata->slots_free & (1U << tag)) == 0)
+					tag++;
+
+				sata->slots_free &= ~(1U << tag);
+
+				size_t cnt = min(count - pos, chunk);
+				uint8_t *data = (uint8_t *) buf +
+				    pos * sata->block_size;
+
+				if (write) {
+					fibril_mutex_unlock(&sata->event_lock);
+					memcpy(sata->slots[tag].buf, data,
+					    cnt * sata->block_size);
+					fibril_mutex_lock(&sata->event_lock);
+				}
+
+				ahci_fpdma_cmd(sata, tag, blocknum + pos, cnt,
+				    write);
+
+				unsigned int idx = (head + nowned) % AHCI_SLOTS_MAX;
+				owned[idx] = tag;
+				owned_pos[idx] = pos;
+				owned_cnt[idx] = cnt;
+				nowned++;
+				pos += cnt;
+				continue;
+			}
+
+			if (nowned == 0) {
+				fibril_condvar_wait(&sata->slot_condvar,
+				    &sata->event_lock);
+				continue;
+			}
+		}
+
+		/* Retire the oldest command of this request */
+		unsigned int tag = owned[head];
+		ahci_slot_t *slot = &sata->slots[tag];
+
+		while (!slot->done) {
+			fibril_condvar_wait(&sata->slot_condvar,
+			    &sata->event_lock);
+		}
+
+		if (slot->rc != EOK) {
+			ddf_msg(LVL_ERROR, "%s: Unrecoverable error during "
+			    "FPDMA %s", sata->model, write ? "write" : "read");
+			rc = slot->rc;
+		} else if ((!write) && (rc == EOK)) {
+			fibril_mutex_unlock(&sata->event_lock);
+			memcpy((uint8_t *) buf + owned_pos[head] *
+			    sata->block_size, slot->buf,
+			    owned_cnt[head] * sata->block_size);
+			fibril_mutex_lock(&sata->event_lock);
+		}
+
+		sata->slots_free |= 1U << tag;
+		fibril_condvar_broadcast(&sata->slot_condvar);
+
+		head = (head + 1) % AHCI_SLOTS_MAX;
+		nowned--;
 	}
 
-	return EOK;
+	fibril_mutex_unlock(&sata->event_lock);
+	return rc;
 }
 
 /*
@@ -887,6 +881,229 @@ static irq_cmd_t ahci_cmds[] = {
 	AHCI_PORT_CMDS(31)
 };
 
+/** Restart command processing on a port after an error.
+ *
+ * All commands issued on the port are dropped by the HBA. Must not be
+ * called with the event lock held, as it sleeps.
+ *
+ * @param sata SATA device structure.
+ *
+ * @return True if the port was restarted.
+ *
+ */
+static bool ahci_sata_restart(sata_dev_t *sata)
+{
+	ahci_port_cmd_t pxcmd;
+	ahci_port_tfd_t pxtfd;
+
+	pxcmd.u32 = sata->port->pxcmd;
+	pxcmd.st = 0;
+	sata->port->pxcmd = pxcmd.u32;
+
+	/* Wait (at most 500 ms) for the command list to stop running */
+	for (unsigned int i = 0; i < 50; i++) {
+		pxcmd.u32 = sata->port->pxcmd;
+		if (!pxcmd.cr)
+			break;
+
+		fibril_usleep(10000);
+	}
+
+	if (pxcmd.cr)
+		return false;
+
+	sata->port->pxserr = 0xffffffff;
+	sata->port->pxis = 0xffffffff;
+
+	/* The device must not be busy (BSY, DRQ), otherwise it needs a reset */
+	pxtfd.u32 = sata->port->pxtfd;
+	if ((pxtfd.sts & 0x88) != 0)
+		return false;
+
+	pxcmd.u32 = sata->port->pxcmd;
+	pxcmd.st = 1;
+	sata->port->pxcmd = pxcmd.u32;
+
+	return true;
+}
+
+/** Set AHCI registers for reading a log page and issue the command.
+ *
+ * Uses the command slot 0 and its data buffer. The command is not queued.
+ *
+ * @param sata SATA device structure.
+ * @param log  Log address.
+ *
+ */
+static void ahci_read_log_ext_cmd(sata_dev_t *sata, uint8_t log)
+{
+	ahci_slot_t *slot = &sata->slots[0];
+	volatile sata_std_command_frame_t *cmd =
+	    (sata_std_command_frame_t *) slot->cmd_table;
+
+	cmd->fis_type = SATA_CMD_FIS_TYPE;
+	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
+	cmd->command = 0x2f;
+	cmd->features = 0;
+	cmd->lba_lower = log;
+	cmd->device = 0;
+	cmd->lba_upper = 0;
+	cmd->features_upper = 0;
+	cmd->count = 1;
+	cmd->reserved1 = 0;
+	cmd->control = 0;
+	cmd->reserved2 = 0;
+
+	volatile ahci_cmdhdr_t *cmd_header = &sata->cmd_header[0];
+
+	cmd_header->prdtl = ahci_slot_prdt_fill(slot, slot->buf_phys,
+	    SATA_LOG_PAGE_LENGTH);
+	cmd_header->flags =
+	    AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK |
+	    AHCI_CMDHDR_FLAGS_5DWCMD;
+	cmd_header->bytesprocessed = 0;
+
+	sata->port->pxci = 1;
+}
+
+/** Read the NCQ command error log of a device.
+ *
+ * Reading the log clears the error state of the device. Until then,
+ * the device aborts all queued commands.
+ *
+ * @param sata SATA device structure.
+ *
+ * @return True if the log was read.
+ *
+ */
+static bool ahci_read_ncq_error_log(sata_dev_t *sata)
+{
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&sata->event_lock);
+
+	sata->event_pxis = 0;
+	ahci_read_log_ext_cmd(sata, SATA_LOG_NCQ_ERROR);
+
+	while ((sata->event_pxis == 0) && (rc == EOK)) {
+		rc = fibril_condvar_wait_timeout(&sata->event_condvar,
+		    &sata->event_lock, 1000000);
+	}
+
+	ahci_port_is_t pxis = sata->event_pxis;
+
+	fibril_mutex_unlock(&sata->event_lock);
+
+	if ((rc != EOK) || (ahci_port_is_error(pxis)))
+		return false;
+
+	uint8_t *page = sata->slots[0].buf;
+
+	/* Unless the NQ bit is set, the error was caused by a queued command */
+	if ((page[0] & 0x80) == 0) {
+		ddf_msg(LVL_WARN, "%s: Queued command %u failed, status 0x%x, "
+		    "error 0x%x", sata->model, page[0] & 0x1f, page[2],
+		    page[3]);
+	}
+
+	return true;
+}
+
+/** Recover a port from an error of queued commands.
+ *
+ * Runs in its own fibril started by ahci_slots_complete(), so that the
+ * interrupt handler does not sleep. All commands in flight have been
+ * failed already and no new commands are issued until the recovery
+ * finishes. If the port cannot be recovered, the device is marked
+ * invalid.
+ *
+ * @param arg SATA device structure.
+ *
+ * @return Always EOK.
+ *
+ */
+static errno_t ahci_sata_recover(void *arg)
+{
+	sata_dev_t *sata = (sata_dev_t *) arg;
+	uint32_t all = (sata->slot_count == 32) ? 0xffffffff :
+	    ((1U << sata->slot_count) - 1);
+
+	/* Slot 0 is used for reading the log, wait until it is released */
+	fibril_mutex_lock(&sata->event_lock);
+	while (sata->slots_free != all)
+		fibril_condvar_wait(&sata->slot_condvar, &sata->event_lock);
+	fibril_mutex_unlock(&sata->event_lock);
+
+	bool recovered = ahci_sata_restart(sata) &&
+	    ahci_read_ncq_error_log(sata);
+
+	fibril_mutex_lock(&sata->event_lock);
+
+	if (!recovered) {
+		ddf_msg(LVL_ERROR, "%s: Cannot recover from error",
+		    sata->model);
+		sata->is_invalid_device = true;
+	}
+
+	sata->recovering = false;
+	fibril_condvar_broadcast(&sata->slot_condvar);
+
+	fibril_mutex_unlock(&sata->event_lock);
+	return EOK;
+}
+
+/** Complete queued commands by tag.
+ *
+ * A command is finished when the HBA has cleared the bit of its tag
+ * in both PxSACT and PxCI. On error, all commands in flight are failed
+ * and recovery of the port is started in a separate fibril.
+ *
+ * The event lock must be held by the caller.
+ *
+ * @param sata SATA device structure.
+ * @param pxis Port interrupt status.
+ *
+ */
+static void ahci_slots_complete(sata_dev_t *sata, ahci_port_is_t pxis)
+{
+	uint32_t finished;
+	errno_t rc = EOK;
+
+	if (ahci_port_is_error(pxis)) {
+		if (ahci_port_is_permanent_error(pxis)) {
+			sata->is_invalid_device = true;
+		} else if (!sata->recovering) {
+			fid_t fid = fibril_create(ahci_sata_recover, sata);
+			if (fid == 0) {
+				sata->is_invalid_device = true;
+			} else {
+				sata->recovering = true;
+				fibril_add_ready(fid);
+			}
+		}
+
+		finished = sata->slots_issued;
+		rc = EINTR;
+	} else {
+		uint32_t active = sata->port->pxsact | sata->port->pxci;
+		finished = sata->slots_issued & ~active;
+	}
+
+	if (finished == 0)
+		return;
+
+	for (unsigned int tag = 0; tag < sata->slot_count; tag++) {
+		if ((finished & (1U << tag)) == 0)
+			continue;
+
+		sata->slots[tag].rc = rc;
+		sata->slots[tag].done = true;
+	}
+
+	sata->slots_issued &= ~finished;
+	fibril_condvar_broadcast(&sata->slot_condvar);
+}
+
 /** AHCI interrupt handler.
  *
  * @param icall The IPC call structure.
@@ -914,6 +1131,9 @@ static void ahci_interrupt(ipc_call_t *icall, ddf_dev_t *dev)
 		sata->event_pxis = pxis;
 		fibril_condvar_signal(&sata->event_condvar);
 
+		if (sata->slots_issued != 0)
+			ahci_slots_complete(sata, pxis);
+
 		fibril_mutex_unlock(&sata->event_lock);
 	}
 }
@@ -968,16 +1188,22 @@ static sata_dev_t *ahci_sata_allocate(ahci_dev_t *ahci, volatile ahci_port_t *po
 	sata->port->pxclb = LO(phys);
 	sata->cmd_header = (ahci_cmdhdr_t *) virt_cmd;
 
-	/* Allocate and init command table structure. */
-	rc = dmamem_map_anonymous(size, DMAMEM_4GiB,
-	    AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &virt_table);
+	/* Allocate and init command tables of all slots. */
+	rc = dmamem_map_anonymous(AHCI_SLOTS_MAX * AHCI_SLOT_CMDTABLE_SIZE,
+	    DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &virt_table);
 	if (rc != EOK)
 		goto error_table;
 
-	memset(virt_table, 0, size);
-	sata->cmd_header->cmdtableu = HI(phys);
-	sata->cmd_header->cmdtable = LO(phys);
-	sata->cmd_table = (uint32_t *) virt_table;
+	memset(virt_table, 0, AHCI_SLOTS_MAX * AHCI_SLOT_CMDTABLE_SIZE);
+
+	for (unsigned int tag = 0; tag < AHCI_SLOTS_MAX; tag++) {
+		uintptr_t table_phys = phys + tag * AHCI_SLOT_CMDTABLE_SIZE;
+
+		sata->cmd_header[tag].cmdtableu = HI(table_phys);
+		sata->cmd_header[tag].cmdtable = LO(table_phys);
+		sata->slots[tag].cmd_table = (uint32_t *)
+		    ((uint8_t *) virt_table + tag * AHCI_SLOT_CMDTABLE_SIZE);
+	}
 
 	return sata;
 
@@ -990,6 +1216,56 @@ error_retfis:
 	return NULL;
 }
 
+/** Allocate data buffers of command slots.
+ *
+ * The number of slots used is limited by the number of command slots
+ * of the HBA and by the NCQ queue depth of the device. If not all
+ * buffers can be allocated, fewer slots are used.
+ *
+ * @param sata SATA device structure.
+ *
+ * @return EOK if succeed, error code otherwise.
+ *
+ */
+static errno_t ahci_sata_slots_init(sata_dev_t *sata)
+{
+	ahci_ghc_cap_t cap;
+	cap.u32 = sata->ahci->memregs->ghc.cap;
+
+	unsigned int count = min(cap.ncs + 1U, sata->queue_depth);
+	count = min(count, (unsigned int) AHCI_SLOTS_MAX);
+
+	for (unsigned int tag = 0; tag < count; tag++) {
+		ahci_slot_t *slot = &sata->slots[tag];
+
+		slot->buf = AS_AREA_ANY;
+		errno_t rc = dmamem_map_anonymous(AHCI_SLOT_BUF_SIZE,
+		    DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE, 0,
+		    &slot->buf_phys, &slot->buf);
+		if (rc != EOK) {
+			if (tag == 0) {
+				ddf_msg(LVL_ERROR, "%s: Cannot allocate slot "
+				    "buffers.", sata->model);
+				return rc;
+			}
+
+			ddf_msg(LVL_WARN, "%s: Using only %u command slots.",
+			    sata->model, tag);
+			count = tag;
+			break;
+		}
+	}
+
+	sata->slot_count = count;
+	sata->slots_free = (count == 32) ? 0xffffffff : ((1U << count) - 1);
+	sata->slots_issued = 0;
+
+	ddf_msg(LVL_NOTE, "%s: %u command slots, %u KiB per command.",
+	    sata->model, count, AHCI_SLOT_BUF_SIZE / 1024);
+
+	return EOK;
+}
+
 /** Initialize and start SATA hardware device.
  *
  * @param sata SATA device structure.
@@ -1056,6 +1332,7 @@ static errno_t ahci_sata_create(ahci_dev_t *ahci, ddf_dev_t *dev,
 	fibril_mutex_initialize(&sata->lock);
 	fibril_mutex_initialize(&sata->event_lock);
 	fibril_condvar_initialize(&sata->event_condvar);
+	fibril_condvar_initialize(&sata->slot_condvar);
 
 	ahci_sata_hw_start(sata);
 
@@ -1067,6 +1344,10 @@ static errno_t ahci_sata_create(ahci_dev_t *ahci, ddf_dev_t *dev,
 	if (ahci_set_highest_ultra_dma_mode(sata) != EOK)
 		goto error;
 
+	/* Set up command slots for queued transfers */
+	if (ahci_sata_slots_init(sata) != EOK)
+		goto error;
+
 	/* Add device to the system */
 	char sata_dev_name[16];
 	snprintf(sata_dev_name, 16, "ahci_%u", sata_devices_count);
@@ -35,11 +35,26 @@
 
 #include <async.h>
 #include <ddf/interrupt.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stddef.h>
 #include <stdint.h>
 #include "ahci_hw.h"
 
+/** Maximum number of command slots (NCQ tags) used on a port. */
+#define AHCI_SLOTS_MAX  32
+
+/** Number of PRD entries in the command table of a slot. */
+#define AHCI_SLOT_PRDT_ENTRIES  8
+
+/** Size of the command table of a slot (in bytes). */
+#define AHCI_SLOT_CMDTABLE_SIZE \
+	(AHCI_CMDTABLE_PRDT_OFFSET + \
+	AHCI_SLOT_PRDT_ENTRIES * sizeof(ahci_cmd_prdt_t))
+
+/** Size of the data buffer of a slot (in bytes). */
+#define AHCI_SLOT_BUF_SIZE  (64 * 1024)
+
 /** AHCI Device. */
 typedef struct {
 	/** Pointer to ddf device. */
@@ -55,6 +70,24 @@ typedef struct {
 	async_sess_t *parent_sess;
 } ahci_dev_t;
 
+/** AHCI command slot. */
+typedef struct {
+	/** Pointer to command table of the slot. */
+	volatile uint32_t *cmd_table;
+
+	/** Data buffer of the slot. */
+	void *buf;
+
+	/** Physical address of the data buffer. */
+	uintptr_t buf_phys;
+
+	/** Command issued in the slot has finished. */
+	bool done;
+
+	/** Result of the command issued in the slot. */
+	errno_t rc;
+} ahci_slot_t;
+
 /** SATA Device. */
 typedef struct {
 	/** Pointer to AHCI device. */
@@ -72,16 +105,31 @@ typedef struct {
 	/** Pointer to SATA port. */
 	volatile ahci_port_t *port;
 
-	/** Pointer to command header. */
+	/** Pointer to command list (one command header per slot). */
 	volatile ahci_cmdhdr_t *cmd_header;
 
-	/** Pointer to command table. */
-	volatile uint32_t *cmd_table;
+	/** Command slots. */
+	ahci_slot_t slots[AHCI_SLOTS_MAX];
+
+	/** Number of slots usable for queued commands. */
+	unsigned int slot_count;
+
+	/** Bitmap of free slots. */
+	uint32_t slots_free;
+
+	/** Bitmap of slots with a queued command in flight. */
+	uint32_t slots_issued;
+
+	/** Port is recovering from an error, no commands may be issued. */
+	bool recovering;
+
+	/** Condition variable signalled when a slot is freed or finished. */
+	fibril_condvar_t slot_condvar;
 
 	/** Mutex for single operation on device. */
 	fibril_mutex_t lock;
 
-	/** Mutex for event signaling condition variable. */
+	/** Mutex for event signaling and slot state. */
 	fibril_mutex_t event_lock;
 
 	/** Event signaling condition variable. */
@@ -104,6 +152,9 @@ typedef struct {
 
 	/** Highest UDMA mode supported. */
 	uint8_t highest_udma_mode;
+
+	/** NCQ queue depth reported by the device. */
+	unsigned int queue_depth;
 } sata_dev_t;
 
 #endif
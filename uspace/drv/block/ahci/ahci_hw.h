@@ -1004,8 +1004,19 @@ typedef volatile struct {
 	uint32_t cmdtable;
 	/** Command Table Descriptor Base Address Upper 32-bits. */
 	uint32_t cmdtableu;
+	/** Reserved. */
+	uint32_t reserved[4];
 } ahci_cmdhdr_t;
 
+/** Number of command headers in the command list. */
+#define AHCI_CMDHDR_COUNT  32
+
+/** Offset of the PRD table within a command table (in bytes). */
+#define AHCI_CMDTABLE_PRDT_OFFSET  0x80
+
+/** Maximum number of bytes described by a single PRD entry. */
+#define AHCI_PRDT_DBC_MAX  (4 * 1024 * 1024)
+
 /** Clear Busy upon R_OK (C) flag. */
 #define AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK  0x0400
 
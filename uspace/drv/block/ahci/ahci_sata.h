@@ -48,6 +48,12 @@
 /** Size for indentify (packet) device buffer in bytes. */
 #define SATA_IDENTIFY_DEVICE_BUFFER_LENGTH  512
 
+/** Size of a general purpose log page in bytes. */
+#define SATA_LOG_PAGE_LENGTH  512
+
+/** Log address of the NCQ command error log. */
+#define SATA_LOG_NCQ_ERROR  0x10
+
 /*
  * SATA Fis Frames
  */
@@ -341,7 +341,7 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 		goto fail;
 
 	/* Reset the device and negotiate the feature bits */
-	rc = virtio_device_setup_start(vdev, 0);
+	rc = virtio_device_setup_start(vdev, 0, 0);
 	if (rc != EOK)
 		goto fail;
 
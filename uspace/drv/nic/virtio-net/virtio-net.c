@@ -32,9 +32,11 @@
 #include <stdint.h>
 
 #include <as.h>
+#include <byteorder.h>
 #include <ddf/driver.h>
 #include <ddf/interrupt.h>
 #include <ddf/log.h>
+#include <inet/checksum.h>
 #include <ops/nic.h>
 #include <pci_dev_iface.h>
 #include <nic/nic.h>
@@ -69,6 +71,35 @@ static driver_t virtio_net_driver = {
 	.driver_ops = &virtio_net_driver_ops
 };
 
+/** Complete partially computed checksum of a received frame.
+ *
+ * If VIRTIO_NET_F_GUEST_CSUM has been negotiated, the device may skip
+ * computing the transport-layer checksum. The checksum field then only
+ * contains the pseudo-header sum and we need to finish the calculation
+ * over the rest of the packet.
+ *
+ * @param hdr Virtio-net packet header
+ * @param data Frame data
+ * @param size Frame size in bytes
+ * @return @c true on success, @c false if the header is malformed
+ */
+static bool virtio_net_csum_complete(virtio_net_hdr_t *hdr, uint8_t *data,
+    size_t size)
+{
+	size_t start = uint16_t_le2host(hdr->csum_start);
+	size_t offset = uint16_t_le2host(hdr->csum_offset);
+	uint16_t csum;
+
+	if (start >= size || offset + sizeof(uint16_t) > size - start)
+		return false;
+
+	csum = inet_checksum_calc(INET_CHECKSUM_INIT, data + start,
+	    size - start);
+	data[start + offset] = csum >> 8;
+	data[start + offset + 1] = csum & 0xff;
+	return true;
+}
+
 static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 {
 	nic_t *nic = ddf_dev_data_get(dev);
@@ -91,7 +122,15 @@ static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 		nic_frame_t *frame = nic_alloc_frame(nic, len - sizeof(*hdr));
 		if (frame) {
 			memcpy(frame->data, &hdr[1], len - sizeof(*hdr));
-			nic_received_frame(nic, frame);
+			if ((hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) != 0 &&
+			    !virtio_net_csum_complete(hdr, frame->data,
+			    frame->size)) {
+				ddf_msg(LVL_WARN,
+				    "Bad RX checksum offsets, packet dropped");
+				nic_release_frame(nic, frame);
+			} else {
+				nic_received_frame(nic, frame);
+			}
 		} else {
 			ddf_msg(LVL_WARN,
 			    "Cannot allocate RX frame, packet dropped");
@@ -195,9 +234,13 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 	if (rc != EOK)
 		goto fail;
 
-	/* Reset the device and negotiate the feature bits */
+	/*
+	 * Reset the device and negotiate the feature bits. If the device
+	 * offers it, let it pass us packets with partial checksums so that
+	 * the host does not need to compute them for packets sent to us.
+	 */
 	rc = virtio_device_setup_start(vdev,
-	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ);
+	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ, VIRTIO_NET_F_GUEST_CSUM);
 	if (rc != EOK)
 		goto fail;
 
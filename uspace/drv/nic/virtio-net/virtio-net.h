@@ -46,6 +46,11 @@
 /** Control channel is available */
 #define VIRTIO_NET_F_CTRL_VQ		(1U << 17)
 
+/** Checksum needs to be completed using csum_start and csum_offset */
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM	1
+/** Checksum has been validated */
+#define VIRTIO_NET_HDR_F_DATA_VALID	2
+
 #define VIRTIO_NET_HDR_GSO_NONE 0
 typedef struct {
 	uint8_t flags;
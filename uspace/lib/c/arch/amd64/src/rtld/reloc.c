@@ -44,11 +44,89 @@
 #include <rtld/rtld_debug.h>
 #include <rtld/rtld_arch.h>
 
+/** Name of the PLT resolver entry point in libc (see lazy.S) */
+#define LAZY_BIND_ENTRY "__rtld_lazy_bind"
+
+extern void *__rtld_lazy_bind_resolve(module_t *, size_t);
+
 void module_process_pre_arch(module_t *m)
 {
 	/* Unused */
 }
 
+/** Set up lazy binding of PLT relocations.
+ *
+ * GOT[1] is set to point to the module and GOT[2] to the resolver entry
+ * point, which the first PLT entry passes control to. The GOT slots
+ * initially point back to their PLT entries, we just need to relocate
+ * them.
+ *
+ * The module providing the resolver needs to be bound eagerly as the
+ * resolver uses its functions.
+ *
+ * @param m Module
+ * @return @c true if the PLT will be bound lazily, @c false if
+ *         the PLT relocations need to be processed eagerly
+ */
+bool module_plt_lazy_arch(module_t *m)
+{
+	elf_rela_t *rt = m->dyn.jmp_rel;
+	size_t rt_entries = m->dyn.plt_rel_sz / sizeof(elf_rela_t);
+	uintptr_t *got = m->dyn.plt_got;
+	elf_symbol_t *sym;
+	module_t *dest;
+	size_t i;
+
+	if (got == NULL || m->dyn.plt_rel != DT_RELA)
+		return false;
+
+	for (i = 0; i < rt_entries; i++) {
+		if (ELF64_R_TYPE(rt[i].r_info) != R_X86_64_JUMP_SLOT)
+			return false;
+	}
+
+	sym = symbol_def_find(LAZY_BIND_ENTRY, m, ssf_none, &dest);
+	if (sym == NULL || dest == m)
+		return false;
+
+	got[1] = (uintptr_t) m;
+	got[2] = (uintptr_t) symbol_get_addr(sym, dest, NULL);
+
+	for (i = 0; i < rt_entries; i++)
+		*(uintptr_t *) (rt[i].r_offset + m->bias) += m->bias;
+
+	return true;
+}
+
+/** Resolve PLT relocation on the first call through the PLT entry.
+ *
+ * Called from __rtld_lazy_bind.
+ *
+ * @param m Module containing the PLT
+ * @param idx Index of the relocation in the PLT relocation table
+ * @return Address of the function
+ */
+void *__rtld_lazy_bind_resolve(module_t *m, size_t idx)
+{
+	elf_rela_t *rela = (elf_rela_t *) m->dyn.jmp_rel + idx;
+	elf_symbol_t *sym_table = m->dyn.sym_tab;
+	elf_symbol_t *sym = &sym_table[ELF64_R_SYM(rela->r_info)];
+	const char *name = m->dyn.str_tab + sym->st_name;
+	elf_symbol_t *sym_def;
+	module_t *dest;
+	void *addr;
+
+	sym_def = symbol_def_find(name, m, ssf_none, &dest);
+	if (sym_def == NULL) {
+		printf("Definition of '%s' not found.\n", name);
+		abort();
+	}
+
+	addr = symbol_get_addr(sym_def, dest, NULL);
+	*(uintptr_t *) (rela->r_offset + m->bias) = (uintptr_t) addr;
+	return addr;
+}
+
 /**
  * Process (fixup) all relocations in a relocation table with implicit addends.
  */
@@ -0,0 +1,79 @@
+/** @addtogroup libc
+ * @{
+ */
+/**
+ * @file
+ * @brief Boot-time event trace.
+ *
+ * Only tasks with the PERM_DEBUG permission can record or read events.
+ */
+
+#include <abi/boottrace.h>
+#include <boottrace.h>
+#include <libc.h>
+#include <str.h>
+
+/** Record a boot-time trace event.
+ *
+ * Recording is best-effort, errors (including missing permission)
+ * are ignored.
+ *
+ * @param type    Event type.
+ * @param task_id Task the event relates to, zero for the current task.
+ * @param arg     Event-specific argument.
+ * @param name    Event-specific name or @c NULL, truncated if too long.
+ */
+void boottrace_record(boottrace_type_t type, task_id_t task_id, uint64_t arg,
+    const char *name)
+{
+	boottrace_event_t event = {
+		.task_id = task_id,
+		.arg = arg,
+		.type = type
+	};
+
+	if (name != NULL)
+		str_cpy(event.name, BOOTTRACE_NAME_LEN, name);
+
+	(void) __SYSCALL5(SYS_BOOTTRACE, BOOTTRACE_RECORD, 0,
+	    (sysarg_t) &event, sizeof(event), 0);
+}
+
+/** Read recorded boot-time trace events.
+ *
+ * @param first  Number of the first event to read.
+ * @param events Buffer for events.
+ * @param count  Capacity of @a events.
+ * @param nread  Place to store number of events read. Zero means there
+ *               are no more events at the moment.
+ *
+ * @return EOK on success or an error code.
+ */
+errno_t boottrace_read(size_t first, boottrace_event_t *events, size_t count,
+    size_t *nread)
+{
+	size_t size;
+	errno_t rc = (errno_t) __SYSCALL5(SYS_BOOTTRACE, BOOTTRACE_READ,
+	    first, (sysarg_t) events, count * sizeof(boottrace_event_t),
+	    (sysarg_t) &size);
+	if (rc != EOK)
+		return rc;
+
+	*nread = size / sizeof(boottrace_event_t);
+	return EOK;
+}
+
+/** Get number of events dropped because the trace was full.
+ *
+ * @param lost Place to store the number of lost events.
+ *
+ * @return EOK on success or an error code.
+ */
+errno_t boottrace_lost(size_t *lost)
+{
+	return (errno_t) __SYSCALL5(SYS_BOOTTRACE, BOOTTRACE_LOST, 0, 0, 0,
+	    (sysarg_t) lost);
+}
+
+/** @}
+ */
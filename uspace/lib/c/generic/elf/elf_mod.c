@@ -37,15 +37,22 @@
  * @brief	Userspace ELF module loader.
  *
  * This module allows loading ELF binaries (both executables and
- * shared objects) from VFS. The current implementation allocates
- * anonymous memory, fills it with segment data and then adjusts
- * the memory areas' flags to the final value. In the future,
- * the segments will be mapped directly from the file.
+ * shared objects) from VFS. Whole file pages of a segment are mapped
+ * directly from the file through the VFS pager so that they are paged in
+ * on demand and shared among tasks running the same binary. Pages of
+ * writable segments are copied on the first write. The rest of the
+ * segment (the partial last page and bss) is loaded into anonymous memory,
+ * which is then given the final access flags.
  */
 
 #include <errno.h>
 #include <stdio.h>
 #include <vfs/vfs.h>
+#include <async.h>
+#include <fibril_synch.h>
+#include <ipc/services.h>
+#include <ipc/vfs.h>
+#include <ns.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <align.h>
@@ -67,6 +74,10 @@ static errno_t elf_load_module(elf_ld_t *elf);
 static errno_t segment_header(elf_ld_t *elf, elf_segment_header_t *entry);
 static errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry);
 
+/** Session to the VFS pager, NULL if not connected yet */
+static async_sess_t *elf_pager_sess = NULL;
+static FIBRIL_MUTEX_INITIALIZE(elf_pager_lock);
+
 /** Load ELF binary from a file.
  *
  * Load an ELF binary from the specified file. If the file is
@@ -98,10 +109,13 @@ errno_t elf_load_file(int file, eld_flags_t flags, elf_finfo_t *info)
 	elf.fd = ofile;
 	elf.info = info;
 	elf.flags = flags;
+	elf.paged = false;
 
 	rc = elf_load_module(&elf);
 
-	vfs_put(ofile);
+	/* The pager needs the file for as long as the segments are mapped. */
+	if (!elf.paged)
+		vfs_put(ofile);
 	return rc;
 }
 
@@ -371,6 +385,76 @@ static errno_t segment_header(elf_ld_t *elf, elf_segment_header_t *entry)
 	return EOK;
 }
 
+/** Get session to the VFS pager.
+ *
+ * @return Session or NULL if the pager is not available.
+ */
+static async_sess_t *get_pager_sess(void)
+{
+	fibril_mutex_lock(&elf_pager_lock);
+	if (elf_pager_sess == NULL) {
+		elf_pager_sess = service_connect(SERVICE_VFS, INTERFACE_PAGER,
+		    0, NULL);
+	}
+	fibril_mutex_unlock(&elf_pager_lock);
+
+	return elf_pager_sess;
+}
+
+/** Map the file-backed pages of a segment through the VFS pager.
+ *
+ * Only pages that are completely initialized from the file are mapped.
+ * If the segment has no bss, this includes its partial last page.
+ *
+ * @param elf	Loader state.
+ * @param entry Program header entry describing segment to be loaded.
+ * @param flags Final flags for the memory area.
+ *
+ * @return Number of bytes mapped at the page-aligned start of the segment.
+ */
+static size_t map_segment(elf_ld_t *elf, elf_segment_header_t *entry,
+    int flags)
+{
+	uintptr_t base;
+	uintptr_t fend;
+	aoff64_t fbase;
+	size_t size;
+	async_sess_t *sess;
+	void *a;
+
+	if ((entry->p_offset % PAGE_SIZE) != (entry->p_vaddr % PAGE_SIZE))
+		return 0;
+
+	base = ALIGN_DOWN(entry->p_vaddr, PAGE_SIZE);
+	fend = entry->p_vaddr + entry->p_filesz;
+
+	if (entry->p_memsz == entry->p_filesz)
+		size = ALIGN_UP(fend, PAGE_SIZE) - base;
+	else
+		size = ALIGN_DOWN(fend, PAGE_SIZE) - base;
+
+	if (size == 0)
+		return 0;
+
+	sess = get_pager_sess();
+	if (sess == NULL)
+		return 0;
+
+	fbase = entry->p_offset - (entry->p_vaddr - base);
+
+	a = async_as_area_create((uint8_t *) base + elf->bias, size, flags,
+	    sess, elf->fd, (flags & AS_AREA_WRITE) ? VFS_PAGER_WRITE : 0,
+	    fbase);
+	if (a == AS_MAP_FAILED) {
+		DPRINTF("pager mapping failed (%p, %zu)\n",
+		    (void *) (base + elf->bias), size);
+		return 0;
+	}
+
+	elf->paged = true;
+	return size;
+}
+
 /** Load segment described by program header entry.
  *
  * @param elf	Loader state.
@@ -384,9 +468,13 @@ errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 	int flags = 0;
 	uintptr_t bias;
 	uintptr_t base;
-	void *seg_ptr;
+	uintptr_t abase;
+	uintptr_t fend;
+	uintptr_t rd_addr;
+	size_t rd_sz;
 	uintptr_t seg_addr;
 	size_t mem_sz;
+	size_t paged;
 	aoff64_t pos;
 	errno_t rc;
 	size_t nr;
@@ -394,7 +482,6 @@ errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 	bias = elf->bias;
 
 	seg_addr = entry->p_vaddr + bias;
-	seg_ptr = (void *) seg_addr;
 
 	DPRINTF("Load segment v_addr=0x%zx at addr %p, size 0x%zx, flags %c%c%c\n",
 	    entry->p_vaddr,
@@ -433,27 +520,43 @@ errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 	    ALIGN_UP(entry->p_memsz, PAGE_SIZE)));
 
 	/*
-	 * For the course of loading, the area needs to be readable
-	 * and writeable.
+	 * Map whole file pages directly unless the caller wants to modify
+	 * the segments.
 	 */
-	a = as_area_create((uint8_t *) base + bias, mem_sz,
+	paged = 0;
+	if ((elf->flags & ELDF_RW) == 0)
+		paged = map_segment(elf, entry, flags);
+
+	if (paged >= mem_sz)
+		return EOK;
+
+	/*
+	 * For the course of loading, the rest of the area needs to be
+	 * readable and writeable.
+	 */
+	abase = base + bias + paged;
+	a = as_area_create((void *) abase, mem_sz - paged,
 	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
 	    AS_AREA_UNPAGED);
 	if (a == AS_MAP_FAILED) {
 		DPRINTF("memory mapping failed (%p, %zu)\n",
-		    (void *) (base + bias), mem_sz);
+		    (void *) abase, mem_sz - paged);
 		return ENOMEM;
 	}
 
 	DPRINTF("as_area_create(%p, %#zx, %d) -> %p\n",
-	    (void *) (base + bias), mem_sz, flags, (void *) a);
+	    (void *) abase, mem_sz - paged, flags, (void *) a);
 
 	/*
-	 * Load segment data
+	 * Load segment data not mapped from the file
 	 */
-	pos = entry->p_offset;
-	rc = vfs_read(elf->fd, &pos, seg_ptr, entry->p_filesz, &nr);
-	if (rc != EOK || nr != entry->p_filesz) {
+	fend = seg_addr + entry->p_filesz;
+	rd_addr = max(seg_addr, abase);
+	rd_sz = fend > rd_addr ? fend - rd_addr : 0;
+
+	pos = entry->p_offset + (rd_addr - seg_addr);
+	rc = vfs_read(elf->fd, &pos, (void *) rd_addr, rd_sz, &nr);
+	if (rc != EOK || nr != rd_sz) {
 		DPRINTF("read error\n");
 		return EIO;
 	}
@@ -465,17 +568,16 @@ errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 	if ((elf->flags & ELDF_RW) != 0)
 		return EOK;
 
-	DPRINTF("as_area_change_flags(%p, %x)\n",
-	    (uint8_t *) base + bias, flags);
-	rc = as_area_change_flags((uint8_t *) base + bias, flags);
+	DPRINTF("as_area_change_flags(%p, %x)\n", (void *) abase, flags);
+	rc = as_area_change_flags((void *) abase, flags);
 	if (rc != EOK) {
 		DPRINTF("Failed to set memory area flags.\n");
 		return ENOMEM;
 	}
 
-	if (flags & AS_AREA_EXEC) {
-		/* Enforce SMC coherence for the segment */
-		if (smc_coherence(seg_ptr, entry->p_filesz))
+	if ((flags & AS_AREA_EXEC) && rd_sz > 0) {
+		/* Enforce SMC coherence for the loaded part of the segment */
+		if (smc_coherence((void *) rd_addr, rd_sz))
 			return ENOMEM;
 	}
 
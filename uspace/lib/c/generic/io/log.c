@@ -31,7 +31,10 @@
  * @{
  */
 
+#include <align.h>
+#include <as.h>
 #include <assert.h>
+#include <barrier.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <stdarg.h>
@@ -66,6 +69,242 @@ static async_sess_t *logger_session;
 /** Maximum length of a single log message (in bytes). */
 #define MESSAGE_BUFFER_SIZE 4096
 
+/** Table of effective log levels shared by logger (indexed by log id - 1). */
+static const uint8_t *log_levels;
+
+/** Serializes writers to the message ring. */
+static FIBRIL_MUTEX_INITIALIZE(log_ring_lock);
+
+/** Message ring shared with logger or @c NULL if not available. */
+static logger_ring_hdr_t *log_ring;
+
+/** Data area of the message ring. */
+static uint8_t *log_ring_data;
+
+/** Map table of effective log levels published by logger.
+ *
+ * @param session Initialized IPC session with the logger.
+ * @return EOK on success or an error code.
+ */
+static errno_t logger_map_levels(async_sess_t *session)
+{
+	async_exch_t *exchange;
+	ipc_call_t answer;
+	void *dst;
+	errno_t rc;
+
+	exchange = async_exchange_begin(session);
+	if (exchange == NULL)
+		return ENOMEM;
+
+	aid_t req = async_send_0(exchange, LOGGER_WRITER_GET_LEVELS, &answer);
+	rc = async_share_in_start_0_0(exchange,
+	    PAGES2SIZE(SIZE2PAGES(LOGGER_LEVELS_MAX)), &dst);
+	async_exchange_end(exchange);
+
+	if (rc != EOK || dst == AS_MAP_FAILED) {
+		async_forget(req);
+		return rc != EOK ? rc : ENOMEM;
+	}
+
+	async_wait_for(req, &rc);
+	if (rc != EOK) {
+		as_area_destroy(dst);
+		return rc;
+	}
+
+	log_levels = dst;
+	return EOK;
+}
+
+/** Create message ring shared with logger.
+ *
+ * @param session Initialized IPC session with the logger.
+ * @return EOK on success or an error code.
+ */
+static errno_t logger_ring_create(async_sess_t *session)
+{
+	async_exch_t *exchange;
+	size_t size;
+	void *area;
+	errno_t rc;
+
+	size = PAGES2SIZE(SIZE2PAGES(sizeof(logger_ring_hdr_t) +
+	    LOGGER_RING_DATA_SIZE));
+	area = as_area_create(AS_AREA_ANY, size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (area == AS_MAP_FAILED)
+		return ENOMEM;
+
+	memset(area, 0, sizeof(logger_ring_hdr_t));
+
+	exchange = async_exchange_begin(session);
+	if (exchange == NULL) {
+		as_area_destroy(area);
+		return ENOMEM;
+	}
+
+	aid_t req = async_send_0(exchange, LOGGER_WRITER_RING_CREATE, NULL);
+	rc = async_share_out_start(exchange, area, AS_AREA_READ |
+	    AS_AREA_WRITE | AS_AREA_CACHEABLE);
+	async_exchange_end(exchange);
+
+	if (rc != EOK) {
+		async_forget(req);
+		as_area_destroy(area);
+		return rc;
+	}
+
+	async_wait_for(req, &rc);
+	if (rc != EOK) {
+		as_area_destroy(area);
+		return rc;
+	}
+
+	log_ring_data = (uint8_t *) area + sizeof(logger_ring_hdr_t);
+	log_ring = area;
+	return EOK;
+}
+
+/** Ask logger to process messages in the ring.
+ *
+ * @param session Initialized IPC session with the logger.
+ * @param wait Wait until logger has drained the ring.
+ * @return Error code or EOK on success.
+ */
+static errno_t logger_ring_kick(async_sess_t *session, bool wait)
+{
+	errno_t rc = EOK;
+
+	async_exch_t *exchange = async_exchange_begin(session);
+	if (exchange == NULL)
+		return ENOMEM;
+
+	if (wait)
+		rc = async_req_0_0(exchange, LOGGER_WRITER_RING_KICK);
+	else
+		async_msg_0(exchange, LOGGER_WRITER_RING_KICK);
+
+	async_exchange_end(exchange);
+	return rc;
+}
+
+/** Reserve space for the next message in the ring.
+ *
+ * If the message would not fit before the end of the ring, a padding
+ * record is written first. The padding becomes visible to logger only
+ * when the message is committed.
+ *
+ * @param head Place to store new head position (before the message).
+ * @return Pointer to the record header or @c NULL if there is not enough
+ *         free space.
+ */
+static logger_ring_rec_t *logger_ring_reserve(uint32_t *head)
+{
+	logger_ring_rec_t *rec;
+	uint32_t h = log_ring->head;
+	uint32_t tail = ACCESS_ONCE(log_ring->tail);
+
+	/* Do not overwrite records before logger is done with them */
+	memory_barrier();
+
+	size_t need = ALIGN_UP(sizeof(logger_ring_rec_t) + MESSAGE_BUFFER_SIZE,
+	    LOGGER_RING_ALIGN);
+	size_t off = h % LOGGER_RING_DATA_SIZE;
+	size_t contig = LOGGER_RING_DATA_SIZE - off;
+
+	if (contig < need) {
+		if (LOGGER_RING_DATA_SIZE - (h - tail) < contig + need)
+			return NULL;
+
+		rec = (logger_ring_rec_t *) (log_ring_data + off);
+		rec->size = 0;
+		rec->level = LOGGER_RING_PAD;
+		rec->log = 0;
+		h += contig;
+		off = 0;
+	} else if (LOGGER_RING_DATA_SIZE - (h - tail) < need) {
+		return NULL;
+	}
+
+	*head = h;
+	return (logger_ring_rec_t *) (log_ring_data + off);
+}
+
+/** Format message directly into the message ring.
+ *
+ * @param session Initialized IPC session with the logger.
+ * @param log Log to use.
+ * @param level Verbosity level of the message.
+ * @param fmt Format string.
+ * @param args Arguments.
+ * @return EOK on success, ENOSPC if the ring stays full, EIO if logger
+ *         refused to process the ring.
+ */
+static errno_t logger_ring_message(async_sess_t *session, log_t log,
+    log_level_t level, const char *fmt, va_list args)
+{
+	logger_ring_rec_t *rec;
+	char *text;
+	size_t size;
+	uint32_t head;
+	bool kick;
+	errno_t rc;
+
+	fibril_mutex_lock(&log_ring_lock);
+
+	if (log_ring == NULL) {
+		/* Ring has been disabled meanwhile */
+		fibril_mutex_unlock(&log_ring_lock);
+		return EIO;
+	}
+
+	rec = logger_ring_reserve(&head);
+	if (rec == NULL) {
+		/* Let logger catch up with us */
+		rc = logger_ring_kick(session, true);
+		if (rc == EOK)
+			rec = logger_ring_reserve(&head);
+		if (rec == NULL) {
+			if (rc != EOK) {
+				/* Logger cannot use the ring, stop using it */
+				log_ring = NULL;
+			}
+			fibril_mutex_unlock(&log_ring_lock);
+			return rc != EOK ? EIO : ENOSPC;
+		}
+	}
+
+	text = (char *) rec + sizeof(logger_ring_rec_t);
+	vsnprintf(text, MESSAGE_BUFFER_SIZE, fmt, args);
+
+	// FIXME: remove when all USB drivers use libc logging explicitly
+	str_rtrim(text, '\n');
+	size = str_size(text);
+
+	rec->size = size;
+	rec->level = level;
+	rec->log = log;
+
+	/* Publish the record */
+	write_barrier();
+	log_ring->head = head + ALIGN_UP(sizeof(logger_ring_rec_t) + size,
+	    LOGGER_RING_ALIGN);
+
+	/* Check whether logger is waiting for a kick */
+	memory_barrier();
+	kick = ACCESS_ONCE(log_ring->cons_wait) != 0;
+	if (kick)
+		log_ring->cons_wait = 0;
+
+	fibril_mutex_unlock(&log_ring_lock);
+
+	if (kick)
+		(void) logger_ring_kick(session, false);
+
+	return EOK;
+}
+
 /** Send formatted message to the logger service.
  *
  * @param session Initialized IPC session with the logger.
@@ -174,6 +413,13 @@ errno_t log_init(const char *prog_name)
 
 	default_log_id = log_create(prog_name, LOG_NO_PARENT);
 
+	/*
+	 * Both of these are optimizations, if logger does not support
+	 * them we simply send every message via IPC.
+	 */
+	(void) logger_map_levels(logger_session);
+	(void) logger_ring_create(logger_session);
+
 	return EOK;
 }
 
@@ -229,6 +475,10 @@ void log_msg(log_t ctx, log_level_t level, const char *fmt, ...)
 }
 
 /** Write an entry to the log (va_list variant).
+ *
+ * Messages above the effective level of the log (as published by logger)
+ * are dropped without being formatted. Others are formatted directly into
+ * the message ring shared with logger, if possible.
  *
  * @param ctx Log to use (use LOG_DEFAULT if you have no idea what it means).
  * @param level Severity level of the message.
@@ -239,6 +489,23 @@ void log_msgv(log_t ctx, log_level_t level, const char *fmt, va_list args)
 {
 	assert(level < LVL_LIMIT);
 
+	log_t log = (ctx == LOG_DEFAULT) ? default_log_id : ctx;
+
+	if (log_levels != NULL && log >= 1 && log <= LOGGER_LEVELS_MAX &&
+	    level > ACCESS_ONCE(log_levels[log - 1]))
+		return;
+
+	if (log_ring != NULL) {
+		va_list ring_args;
+
+		va_copy(ring_args, args);
+		errno_t rc = logger_ring_message(logger_session, log, level,
+		    fmt, ring_args);
+		va_end(ring_args);
+		if (rc == EOK)
+			return;
+	}
+
 	char *message_buffer = malloc(MESSAGE_BUFFER_SIZE);
 	if (message_buffer == NULL)
 		return;
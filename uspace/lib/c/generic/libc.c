@@ -53,6 +53,7 @@
 
 #ifdef CONFIG_RTLD
 #include <rtld/rtld.h>
+#include <rtld/symbol.h>
 #endif
 
 progsymbols_t __progsymbols;
@@ -95,6 +96,9 @@ void __libc_main(void *pcb_ptr)
 	__malloc_init();
 
 #ifdef CONFIG_RTLD
+	if (symbol_init() != EOK)
+		abort();
+
 	if (__pcb != NULL && __pcb->rtld_runtime != NULL) {
 		runtime_env = (rtld_t *) __pcb->rtld_runtime;
 	} else {
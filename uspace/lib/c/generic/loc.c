@@ -27,6 +27,7 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <boottrace.h>
 #include <str.h>
 #include <ipc/services.h>
 #include <ns.h>
@@ -360,6 +361,9 @@ errno_t loc_service_get_id(const char *fqdn, service_id_t *handle,
 	if (handle != NULL)
 		*handle = (service_id_t) ipc_get_arg1(&answer);
 
+	if (flags & IPC_FLAG_BLOCKING)
+		boottrace_record(BOOTTRACE_LOC_WAIT, 0, ipc_get_arg1(&answer), fqdn);
+
 	return retval;
 }
 
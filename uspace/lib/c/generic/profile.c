@@ -0,0 +1,76 @@
+/** @addtogroup libc
+ * @{
+ */
+/**
+ * @file
+ * @brief Kernel sampling profiler control.
+ *
+ * All functions require the PERM_DEBUG permission and return EPERM
+ * without it.
+ */
+
+#include <abi/profile.h>
+#include <libc.h>
+#include <profile.h>
+
+/** Start recording profiler samples.
+ *
+ * Samples recorded by a previous run and not read yet are discarded.
+ *
+ * @param period Sampling period in clock ticks.
+ *
+ * @return EOK on success, EBUSY if the profiler is already running.
+ */
+errno_t profile_start(unsigned int period)
+{
+	return (errno_t) __SYSCALL5(SYS_PROFILE, PROFILE_START, period,
+	    0, 0, 0);
+}
+
+/** Stop recording profiler samples.
+ *
+ * Samples recorded so far can still be read.
+ *
+ * @return EOK on success.
+ */
+errno_t profile_stop(void)
+{
+	return (errno_t) __SYSCALL5(SYS_PROFILE, PROFILE_STOP, 0, 0, 0, 0);
+}
+
+/** Read recorded profiler samples.
+ *
+ * @param samples Buffer for samples.
+ * @param count   Capacity of @a samples.
+ * @param nread   Place to store number of samples read. Zero means there
+ *                are no more samples at the moment.
+ *
+ * @return EOK on success or an error code.
+ */
+errno_t profile_read(profile_sample_t *samples, size_t count, size_t *nread)
+{
+	size_t size;
+	errno_t rc = (errno_t) __SYSCALL5(SYS_PROFILE, PROFILE_READ, 0,
+	    (sysarg_t) samples, count * sizeof(profile_sample_t),
+	    (sysarg_t) &size);
+	if (rc != EOK)
+		return rc;
+
+	*nread = size / sizeof(profile_sample_t);
+	return EOK;
+}
+
+/** Get number of samples lost because of full buffers.
+ *
+ * @param lost Place to store the number of samples lost since start.
+ *
+ * @return EOK on success or an error code.
+ */
+errno_t profile_lost(size_t *lost)
+{
+	return (errno_t) __SYSCALL5(SYS_PROFILE, PROFILE_LOST, 0, 0, 0,
+	    (sysarg_t) lost);
+}
+
+/** @}
+ */
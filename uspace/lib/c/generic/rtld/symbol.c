@@ -34,6 +34,7 @@
  * @file
  */
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
@@ -44,6 +45,36 @@
 #include <rtld/rtld_debug.h>
 #include <rtld/symbol.h>
 
+#include "../private/fibril.h"
+
+/** Number of entries in the symbol lookup cache (power of two) */
+#define SYM_CACHE_SIZE 1024
+
+/** Maximum number of used entries in the symbol lookup cache */
+#define SYM_CACHE_MAX (SYM_CACHE_SIZE / 4 * 3)
+
+/** Symbol name with precomputed hashes */
+typedef struct {
+	/** Symbol name */
+	const char *name;
+	/** GNU hash of the name */
+	uint32_t gnu_hash;
+	/** SysV hash of the name, computed on first use */
+	elf_word elf_hash;
+	/** @c true iff @c elf_hash is valid */
+	bool elf_hash_valid;
+} sym_key_t;
+
+/** Synchronizes access to the symbol lookup cache */
+static fibril_rmutex_t sym_cache_lock;
+
+/**
+ * Symbol lookup cache can be used. Lazy binding can resolve symbols
+ * before libc is initialized (starting with __libc_main itself), when
+ * neither the lock nor the heap can be used yet.
+ */
+static bool sym_cache_ready = false;
+
 /*
  * Hash tables are 32-bit (elf_word) even for 64-bit ELF files.
  */
@@ -62,38 +93,126 @@ static elf_word elf_hash(const unsigned char *name)
 	return h;
 }
 
-static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
+/** Compute GNU hash of a symbol name. */
+static uint32_t gnu_hash(const unsigned char *name)
+{
+	uint32_t h = 5381;
+
+	while (*name)
+		h = (h << 5) + h + *name++;
+
+	return h;
+}
+
+static void sym_key_init(sym_key_t *key, const char *name)
+{
+	key->name = name;
+	key->gnu_hash = gnu_hash((const unsigned char *) name);
+	key->elf_hash_valid = false;
+}
+
+/** Look up symbol in a module using its SysV hash table. */
+static elf_symbol_t *sym_find_sysv(sym_key_t *key, module_t *m)
 {
 	elf_symbol_t *sym_table;
-	elf_symbol_t *s, *sym;
+	elf_symbol_t *s;
 	elf_word nbucket;
 	/* elf_word nchain; */
 	elf_word i;
 	char *s_name;
 	elf_word bucket;
 
-	DPRINTF("def_find_in_module('%s', %s)\n", name, m->dyn.soname);
+	if (!key->elf_hash_valid) {
+		key->elf_hash = elf_hash((const unsigned char *) key->name);
+		key->elf_hash_valid = true;
+	}
 
 	sym_table = m->dyn.sym_tab;
 	nbucket = m->dyn.hash[0];
 	/* nchain = m->dyn.hash[1]; XXX Use to check HT range */
 
-	bucket = elf_hash((unsigned char *)name) % nbucket;
+	bucket = key->elf_hash % nbucket;
 	i = m->dyn.hash[2 + bucket];
 
-	sym = NULL;
 	while (i != STN_UNDEF) {
 		s = &sym_table[i];
 		s_name = m->dyn.str_tab + s->st_name;
 
-		if (str_cmp(name, s_name) == 0) {
-			sym = s;
-			break;
-		}
+		if (str_cmp(key->name, s_name) == 0)
+			return s;
 
 		i = m->dyn.hash[2 + nbucket + i];
 	}
 
+	return NULL;
+}
+
+/** Look up symbol in a module using its GNU hash table.
+ *
+ * The table starts with a Bloom filter which lets us reject most
+ * modules that do not define the symbol without touching the buckets.
+ * Chains are sorted by bucket and the hash values stored alongside
+ * the symbols have the lowest bit set at the end of each chain.
+ */
+static elf_symbol_t *sym_find_gnu(sym_key_t *key, module_t *m)
+{
+	const size_t wbits = sizeof(uintptr_t) * 8;
+	elf_word *ht = m->dyn.gnu_hash;
+	elf_word nbucket = ht[0];
+	elf_word symoffset = ht[1];
+	elf_word bloom_size = ht[2];
+	elf_word bloom_shift = ht[3];
+	const uintptr_t *bloom = (const uintptr_t *) &ht[4];
+	const elf_word *buckets = (const elf_word *) &bloom[bloom_size];
+	const elf_word *chain = &buckets[nbucket];
+	elf_symbol_t *sym_table = m->dyn.sym_tab;
+	uint32_t h = key->gnu_hash;
+	uintptr_t word;
+	uintptr_t mask;
+	elf_word i;
+	elf_word ch;
+
+	if (nbucket == 0 || bloom_size == 0)
+		return NULL;
+
+	word = bloom[(h / wbits) % bloom_size];
+	mask = ((uintptr_t) 1 << (h % wbits)) |
+	    ((uintptr_t) 1 << ((h >> bloom_shift) % wbits));
+	if ((word & mask) != mask)
+		return NULL;
+
+	i = buckets[h % nbucket];
+	if (i < symoffset)
+		return NULL;
+
+	while (true) {
+		ch = chain[i - symoffset];
+		if ((ch | 1) == (h | 1) && str_cmp(key->name,
+		    m->dyn.str_tab + sym_table[i].st_name) == 0)
+			return &sym_table[i];
+
+		if ((ch & 1) != 0)
+			break;
+
+		++i;
+	}
+
+	return NULL;
+}
+
+static elf_symbol_t *def_find_in_module(sym_key_t *key, module_t *m)
+{
+	elf_symbol_t *sym;
+
+	DPRINTF("def_find_in_module('%s', %s)\n", key->name, m->dyn.soname);
+
+	if (m->dyn.gnu_hash != NULL)
+		sym = sym_find_gnu(key, m);
+	else if (m->dyn.hash != NULL)
+		sym = sym_find_sysv(key, m);
+	else
+		sym = NULL;
+
 	if (!sym)
 		return NULL;	/* Not found */
 
@@ -105,6 +224,115 @@ static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
 	return sym; /* Found */
 }
 
+/** Initialize symbol lookup.
+ *
+ * @return EOK on success or an error code
+ */
+errno_t symbol_init(void)
+{
+	errno_t rc;
+
+	rc = fibril_rmutex_initialize(&sym_cache_lock);
+	if (rc != EOK)
+		return rc;
+
+	sym_cache_ready = true;
+	return EOK;
+}
+
+/** Look up symbol in the lookup cache.
+ *
+ * @param rtld	Run-time dynamic linker
+ * @param key	Symbol name
+ * @param mod	Place to store module containing the definition
+ * @return Symbol definition or @c NULL if not cached
+ */
+static elf_symbol_t *sym_cache_find(rtld_t *rtld, sym_key_t *key,
+    module_t **mod)
+{
+	rtld_sym_cache_entry_t *e;
+	elf_symbol_t *sym = NULL;
+	size_t i;
+
+	if (!sym_cache_ready)
+		return NULL;
+
+	fibril_rmutex_lock(&sym_cache_lock);
+
+	if (rtld->sym_cache != NULL) {
+		i = key->gnu_hash % SYM_CACHE_SIZE;
+		while (rtld->sym_cache[i].name != NULL) {
+			e = &rtld->sym_cache[i];
+			if (e->hash == key->gnu_hash &&
+			    str_cmp(e->name, key->name) == 0) {
+				sym = e->sym;
+				*mod = e->mod;
+				break;
+			}
+
+			i = (i + 1) % SYM_CACHE_SIZE;
+		}
+	}
+
+	fibril_rmutex_unlock(&sym_cache_lock);
+	return sym;
+}
+
+/** Insert symbol definition into the lookup cache.
+ *
+ * Only definitions found in the global modules are cached. Since modules
+ * are only ever appended to the search list, they remain valid.
+ *
+ * @param rtld	Run-time dynamic linker
+ * @param key	Symbol name
+ * @param sym	Symbol definition
+ * @param mod	Module containing the definition
+ */
+static void sym_cache_insert(rtld_t *rtld, sym_key_t *key, elf_symbol_t *sym,
+    module_t *mod)
+{
+	rtld_sym_cache_entry_t *cache = NULL;
+	size_t i;
+
+	if (!sym_cache_ready)
+		return;
+
+	/* Allocate the cache outside of the critical section */
+	if (rtld->sym_cache == NULL)
+		cache = calloc(SYM_CACHE_SIZE, sizeof(rtld_sym_cache_entry_t));
+
+	fibril_rmutex_lock(&sym_cache_lock);
+
+	if (rtld->sym_cache == NULL) {
+		rtld->sym_cache = cache;
+		cache = NULL;
+	}
+
+	if (rtld->sym_cache != NULL && rtld->sym_cache_used < SYM_CACHE_MAX) {
+		i = key->gnu_hash % SYM_CACHE_SIZE;
+		while (rtld->sym_cache[i].name != NULL) {
+			if (rtld->sym_cache[i].hash == key->gnu_hash &&
+			    str_cmp(rtld->sym_cache[i].name, key->name) == 0) {
+				/* Inserted by someone else meanwhile */
+				goto out;
+			}
+
+			i = (i + 1) % SYM_CACHE_SIZE;
+		}
+
+		/* Keep the name valid as long as the module is loaded */
+		rtld->sym_cache[i].name = mod->dyn.str_tab + sym->st_name;
+		rtld->sym_cache[i].hash = key->gnu_hash;
+		rtld->sym_cache[i].sym = sym;
+		rtld->sym_cache[i].mod = mod;
+		rtld->sym_cache_used++;
+	}
+
+out:
+	fibril_rmutex_unlock(&sym_cache_lock);
+	free(cache);
+}
+
 /** Find the definition of a symbol in a module and its deps.
  *
  * Search the module dependency graph is breadth-first, beginning
@@ -121,9 +349,12 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 {
 	module_t *m, *dm;
 	elf_symbol_t *sym, *s;
+	sym_key_t key;
 	list_t queue;
 	size_t i;
 
+	sym_key_init(&key, name);
+
 	/*
 	 * Do a BFS using the queue_link and bfs_tag fields.
 	 * Vertices (modules) are tagged the moment they are inserted
@@ -149,7 +380,7 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 		list_remove(&m->queue_link);
 
 		/* If ssf_noroot is specified, do not look in start module */
-		s = def_find_in_module(name, m);
+		s = def_find_in_module(&key, m);
 		if (s != NULL) {
 			/* Symbol found */
 			sym = s;
@@ -186,7 +417,7 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
  *
  * By definition in System V ABI, if module origin has the flag DT_SYMBOLIC,
  * origin is searched first. Otherwise, search global modules in the default
- * order.
+ * order. Definitions found in the global modules are cached.
  *
  * @param name		Name of the symbol to search for.
  * @param origin	Module in which the dependency originates.
@@ -199,6 +430,9 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
     symbol_search_flags_t flags, module_t **mod)
 {
 	elf_symbol_t *s;
+	sym_key_t key;
+
+	sym_key_init(&key, name);
 
 	DPRINTF("symbol_def_find('%s', origin='%s'\n",
 	    name, origin->dyn.soname);
@@ -208,7 +442,7 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 		 * Origin module has a DT_SYMBOLIC flag.
 		 * Try this module first
 		 */
-		s = def_find_in_module(name, origin);
+		s = def_find_in_module(&key, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
@@ -218,13 +452,21 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 
 	/* Not DT_SYMBOLIC or no match. Now try other locations. */
 
+	if (flags == ssf_none) {
+		s = sym_cache_find(origin->rtld, &key, mod);
+		if (s != NULL)
+			return s;
+	}
+
 	list_foreach(origin->rtld->modules, modules_link, module_t, m) {
 		DPRINTF("module '%s' local?\n", m->dyn.soname);
 		if (!m->local && (!m->exec || (flags & ssf_noexec) == 0)) {
 			DPRINTF("!local->find '%s' in module '%s'\n", name, m->dyn.soname);
-			s = def_find_in_module(name, m);
+			s = def_find_in_module(&key, m);
 			if (s != NULL) {
 				/* Found */
+				if (flags == ssf_none)
+					sym_cache_insert(origin->rtld, &key, s, m);
 				*mod = m;
 				return s;
 			}
@@ -237,7 +479,7 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 	    origin->dyn.soname);
 
 	if (!origin->exec || (flags & ssf_noexec) == 0) {
-		s = def_find_in_module(name, origin);
+		s = def_find_in_module(&key, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
@@ -0,0 +1,23 @@
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_BOOTTRACE_H_
+#define _LIBC_BOOTTRACE_H_
+
+#include <abi/boottrace.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+extern void boottrace_record(boottrace_type_t, task_id_t, uint64_t,
+    const char *);
+extern errno_t boottrace_read(size_t, boottrace_event_t *, size_t, size_t *);
+extern errno_t boottrace_lost(size_t *);
+
+#endif
+
+/** @}
+ */
@@ -38,6 +38,7 @@
 #define ELF_MOD_H_
 
 #include <elf/elf.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <loader/pcb.h>
@@ -96,6 +97,9 @@ typedef struct {
 
 	/** Store extracted info here */
 	elf_finfo_t *info;
+
+	/** Some segments are paged in from @c fd, which must stay open */
+	bool paged;
 } elf_ld_t;
 
 extern errno_t elf_load_file(int, eld_flags_t, elf_finfo_t *);
@@ -34,6 +34,7 @@
 #define _LIBC_IPC_LOGGER_H_
 
 #include <ipc/common.h>
+#include <stdint.h>
 
 typedef enum {
 	/** Set (global) default displayed logging level.
@@ -71,9 +72,72 @@ typedef enum {
 	 * Returns: error code
 	 * Followed by: string with the message.
 	 */
-	LOGGER_WRITER_MESSAGE
+	LOGGER_WRITER_MESSAGE,
+	/** Get table of log levels.
+	 *
+	 * Returns: error code
+	 * Followed by: share in of the (read-only) table of log levels,
+	 * indexed by log id - 1.
+	 */
+	LOGGER_WRITER_GET_LEVELS,
+	/** Create message ring.
+	 *
+	 * Returns: error code
+	 * Followed by: share out of area with logger_ring_hdr_t followed
+	 * by LOGGER_RING_DATA_SIZE bytes of ring data.
+	 */
+	LOGGER_WRITER_RING_CREATE,
+	/** Notify logger about messages in the ring.
+	 *
+	 * Returns: error code (once the ring has been drained)
+	 */
+	LOGGER_WRITER_RING_KICK
 } logger_writer_request_t;
 
+/** Maximum number of logs whose level is published in the level table */
+#define LOGGER_LEVELS_MAX 4096
+
+/** Size of message ring data area (power of two) */
+#define LOGGER_RING_DATA_SIZE 32768
+
+/** Record alignment in message ring */
+#define LOGGER_RING_ALIGN 8
+
+/** Level of padding record in message ring */
+#define LOGGER_RING_PAD 0xffff
+
+/** Header of message ring shared by writer client with logger.
+ *
+ * The client writes messages to the ring and advances @c head, logger
+ * consumes them and advances @c tail. Positions are free-running byte
+ * counts. Before going idle logger sets @c cons_wait and the client
+ * sends LOGGER_WRITER_RING_KICK when it finds it set.
+ */
+typedef struct {
+	/** Producer position */
+	uint32_t head;
+	/** Logger is waiting for LOGGER_WRITER_RING_KICK */
+	uint32_t cons_wait;
+	uint32_t pad0[14];
+	/** Consumer position */
+	uint32_t tail;
+	uint32_t pad1[15];
+} logger_ring_hdr_t;
+
+/** Message record in message ring, followed by message text.
+ *
+ * Records are aligned to LOGGER_RING_ALIGN and never wrap around
+ * the end of the data area. The text is not null-terminated.
+ */
+typedef struct {
+	/** Size of message text in bytes */
+	uint16_t size;
+	/** Message severity level (log_level_t) or LOGGER_RING_PAD */
+	uint16_t level;
+	/** Log id */
+	uint32_t log;
+} logger_ring_rec_t;
+
 #endif
 
 /** @}
@@ -61,6 +61,8 @@ typedef struct {
 	unsigned int instance;
 	bool concurrent_read_write;
 	bool write_retains_size;
+	/** Namespace of the fs changes without going through VFS. */
+	bool external_namespace;
 } vfs_info_t;
 
 /** Data returned by filesystem probe regarding a specific volume. */
@@ -69,6 +71,18 @@ typedef struct {
 	char vuid[FS_VUID_MAXLEN + 1];
 } vfs_fs_probe_info_t;
 
+/** Flags passed by clients of the VFS pager as the second pager argument.
+ *
+ * The first pager argument is the file descriptor and the third one is
+ * the page-aligned offset within the file at which the area starts.
+ */
+typedef enum {
+	/** The area is writable. */
+	VFS_PAGER_WRITE = 1,
+	/** Modifications of the area should be written back to the file. */
+	VFS_PAGER_SHARED = 2
+} vfs_pager_flags_t;
+
 typedef enum {
 	VFS_IN_CLONE = IPC_FIRST_USER_METHOD,
 	VFS_IN_FSPROBE,
@@ -181,6 +195,8 @@ enum {
 	VFS_MOUNT_BLOCKING = 1,
 	VFS_MOUNT_CONNECT_ONLY = 2,
 	VFS_MOUNT_NO_REF = 4,
+	/** Do not cache names within the mounted file system. */
+	VFS_MOUNT_NO_DCACHE = 8,
 };
 
 enum {
@@ -0,0 +1,22 @@
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_PROFILE_H_
+#define _LIBC_PROFILE_H_
+
+#include <abi/profile.h>
+#include <errno.h>
+#include <stddef.h>
+
+extern errno_t profile_start(unsigned int);
+extern errno_t profile_stop(void);
+extern errno_t profile_read(profile_sample_t *, size_t, size_t *);
+extern errno_t profile_lost(size_t *);
+
+#endif
+
+/** @}
+ */
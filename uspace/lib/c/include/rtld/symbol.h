@@ -47,6 +47,7 @@ typedef enum {
 	ssf_noexec = 0x1
 } symbol_search_flags_t;
 
+extern errno_t symbol_init(void);
 extern elf_symbol_t *symbol_bfs_find(const char *, module_t *, module_t **);
 extern elf_symbol_t *symbol_def_find(const char *, module_t *,
     symbol_search_flags_t, module_t **);
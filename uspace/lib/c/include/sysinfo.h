@@ -39,6 +39,9 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <abi/sysinfo.h>
+#include <_bits/decls.h>
+
+__HELENOS_DECLS_BEGIN;
 
 extern char *sysinfo_get_keys(const char *, size_t *);
 extern sysinfo_item_val_type_t sysinfo_get_val_type(const char *);
@@ -46,6 +49,8 @@ extern errno_t sysinfo_get_value(const char *, sysarg_t *);
 extern void *sysinfo_get_data(const char *, size_t *);
 extern void *sysinfo_get_property(const char *, const char *, size_t *);
 
+__HELENOS_DECLS_END;
+
 #endif
 
 /** @}
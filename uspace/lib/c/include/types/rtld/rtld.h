@@ -42,6 +42,18 @@
 
 #include <types/rtld/module.h>
 
+/** Symbol lookup cache entry */
+typedef struct {
+	/** Symbol name, NULL if the entry is free */
+	const char *name;
+	/** GNU hash of the symbol name */
+	uint32_t hash;
+	/** Symbol definition */
+	elf_symbol_t *sym;
+	/** Module containing the definition */
+	module_t *mod;
+} rtld_sym_cache_entry_t;
+
 typedef struct rtld {
 	elf_dyn_t *rtld_dynamic;
 	module_t rtld;
@@ -60,6 +72,11 @@ typedef struct rtld {
 
 	/** List of initial modules */
 	list_t imodules;
+
+	/** Cache of symbols found in the global modules (open addressing) */
+	rtld_sym_cache_entry_t *sym_cache;
+	/** Number of used entries in @c sym_cache */
+	size_t sym_cache_used;
 } rtld_t;
 
 #endif
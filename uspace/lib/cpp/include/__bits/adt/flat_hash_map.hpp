@@ -0,0 +1,136 @@
+#ifndef LIBCPP_BITS_ADT_FLAT_HASH_MAP
+#define LIBCPP_BITS_ADT_FLAT_HASH_MAP
+
+#include <__bits/adt/flat_hash_table.hpp>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace std::hel
+{
+    /**
+     * HelenOS extension: hash map with open addressing.
+     *
+     * The interface follows unordered_map (without the bucket
+     * interface and multi variants), but the elements are stored
+     * in a flat array instead of in separately allocated nodes.
+     * This makes lookups and insertions considerably faster and
+     * the map smaller, but insertion invalidates all iterators,
+     * pointers and references to elements of the map.
+     */
+    template<
+        class Key, class Value,
+        class Hash = hash<Key>,
+        class Pred = equal_to<Key>,
+        class Alloc = allocator<pair<const Key, Value>>
+    >
+    class flat_hash_map: public aux::flat_hash_table<
+        pair<const Key, Value>, Key,
+        aux::key_value_key_extractor<Key, Value>,
+        Hash, Pred, Alloc
+    >
+    {
+        using base_ = aux::flat_hash_table<
+            pair<const Key, Value>, Key,
+            aux::key_value_key_extractor<Key, Value>,
+            Hash, Pred, Alloc
+        >;
+
+        public:
+            using mapped_type = Value;
+            using typename base_::key_type;
+            using typename base_::iterator;
+            using typename base_::const_iterator;
+
+            using base_::base_;
+
+            template<class... Args>
+            pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+            {
+                auto [idx, inserted] = this->find_or_prepare_insert_(key);
+                if (inserted)
+                    this->construct_at_(idx, key, forward<Args>(args)...);
+
+                return make_pair(this->iterator_at_(idx), inserted);
+            }
+
+            template<class... Args>
+            pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+            {
+                auto [idx, inserted] = this->find_or_prepare_insert_(key);
+                if (inserted)
+                    this->construct_at_(idx, move(key), forward<Args>(args)...);
+
+                return make_pair(this->iterator_at_(idx), inserted);
+            }
+
+            template<class T>
+            pair<iterator, bool> insert_or_assign(const key_type& key, T&& obj)
+            {
+                auto res = try_emplace(key, forward<T>(obj));
+                if (!res.second)
+                    res.first->second = forward<T>(obj);
+
+                return res;
+            }
+
+            mapped_type& operator[](const key_type& key)
+            {
+                return try_emplace(key, mapped_type{}).first->second;
+            }
+
+            mapped_type& operator[](key_type&& key)
+            {
+                return try_emplace(move(key), mapped_type{}).first->second;
+            }
+
+            mapped_type& at(const key_type& key)
+            {
+                auto it = this->find(key);
+
+                // TODO: throw out_of_range if it == end()
+                return it->second;
+            }
+
+            const mapped_type& at(const key_type& key) const
+            {
+                auto it = this->find(key);
+
+                // TODO: throw out_of_range if it == end()
+                return it->second;
+            }
+    };
+
+    template<class Key, class Value, class Hash, class Pred, class Alloc>
+    bool operator==(const flat_hash_map<Key, Value, Hash, Pred, Alloc>& lhs,
+                    const flat_hash_map<Key, Value, Hash, Pred, Alloc>& rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+
+        for (const auto& val: lhs)
+        {
+            auto it = rhs.find(val.first);
+            if (it == rhs.end() || !(it->second == val.second))
+                return false;
+        }
+
+        return true;
+    }
+
+    template<class Key, class Value, class Hash, class Pred, class Alloc>
+    bool operator!=(const flat_hash_map<Key, Value, Hash, Pred, Alloc>& lhs,
+                    const flat_hash_map<Key, Value, Hash, Pred, Alloc>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<class Key, class Value, class Hash, class Pred, class Alloc>
+    void swap(flat_hash_map<Key, Value, Hash, Pred, Alloc>& lhs,
+              flat_hash_map<Key, Value, Hash, Pred, Alloc>& rhs)
+    {
+        lhs.swap(rhs);
+    }
+}
+
+#endif
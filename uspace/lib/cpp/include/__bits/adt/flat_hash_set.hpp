@@ -0,0 +1,67 @@
+#ifndef LIBCPP_BITS_ADT_FLAT_HASH_SET
+#define LIBCPP_BITS_ADT_FLAT_HASH_SET
+
+#include <__bits/adt/flat_hash_table.hpp>
+#include <functional>
+#include <memory>
+
+namespace std::hel
+{
+    /**
+     * HelenOS extension: hash set with open addressing.
+     *
+     * Same as flat_hash_map, insertion invalidates all
+     * iterators, pointers and references to elements.
+     */
+    template<
+        class Key,
+        class Hash = hash<Key>,
+        class Pred = equal_to<Key>,
+        class Alloc = allocator<Key>
+    >
+    class flat_hash_set: public aux::flat_hash_table<
+        Key, Key, aux::key_no_value_key_extractor<Key>,
+        Hash, Pred, Alloc
+    >
+    {
+        using base_ = aux::flat_hash_table<
+            Key, Key, aux::key_no_value_key_extractor<Key>,
+            Hash, Pred, Alloc
+        >;
+
+        public:
+            using base_::base_;
+    };
+
+    template<class Key, class Hash, class Pred, class Alloc>
+    bool operator==(const flat_hash_set<Key, Hash, Pred, Alloc>& lhs,
+                    const flat_hash_set<Key, Hash, Pred, Alloc>& rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+
+        for (const auto& key: lhs)
+        {
+            if (!rhs.contains(key))
+                return false;
+        }
+
+        return true;
+    }
+
+    template<class Key, class Hash, class Pred, class Alloc>
+    bool operator!=(const flat_hash_set<Key, Hash, Pred, Alloc>& lhs,
+                    const flat_hash_set<Key, Hash, Pred, Alloc>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<class Key, class Hash, class Pred, class Alloc>
+    void swap(flat_hash_set<Key, Hash, Pred, Alloc>& lhs,
+              flat_hash_set<Key, Hash, Pred, Alloc>& rhs)
+    {
+        lhs.swap(rhs);
+    }
+}
+
+#endif
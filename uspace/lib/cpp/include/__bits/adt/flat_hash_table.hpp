@@ -0,0 +1,882 @@
+#ifndef LIBCPP_BITS_ADT_FLAT_HASH_TABLE
+#define LIBCPP_BITS_ADT_FLAT_HASH_TABLE
+
+#include <__bits/adt/key_extractors.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace std::aux
+{
+    /**
+     * Open addressing hash table used by the flat_hash_map
+     * and flat_hash_set extension containers.
+     *
+     * Elements are stored directly in one array of slots,
+     * next to which we keep one control byte per slot. The
+     * control byte either marks the slot as empty or deleted
+     * or holds 7 bits of the hash of the element in the slot.
+     * Lookups compare control bytes of 8 consecutive slots at
+     * once (using plain integer arithmetic) and only compare
+     * keys of the slots whose hash bits match, so a probe
+     * rarely touches more than one cache line of the slots.
+     *
+     * The price for this is that, unlike with unordered_map,
+     * insertion invalidates all iterators, pointers and
+     * references to elements (the table can be rehashed,
+     * which moves the elements). Erasure only invalidates
+     * iterators, pointers and references to the erased element.
+     */
+
+    struct flat_hash_ctrl
+    {
+        static constexpr uint8_t empty{0x80};
+        static constexpr uint8_t deleted{0xfe};
+
+        /**
+         * Number of slots whose control bytes we
+         * examine at once.
+         */
+        static constexpr size_t group_width{8};
+
+        static constexpr uint64_t lsbs{0x0101010101010101ull};
+        static constexpr uint64_t msbs{0x8080808080808080ull};
+
+        static bool is_full(uint8_t c) noexcept
+        {
+            return (c & 0x80) == 0;
+        }
+
+        /**
+         * Loads control bytes of a group so that the
+         * byte of the first slot is the least significant
+         * one regardless of endianness.
+         */
+        static uint64_t load(const uint8_t* ctrl) noexcept
+        {
+            uint64_t group{};
+            for (size_t i = 0; i < group_width; ++i)
+                group |= static_cast<uint64_t>(ctrl[i]) << (8 * i);
+
+            return group;
+        }
+
+        /**
+         * Returns a mask with the high bit set in each
+         * byte that (possibly) equals h2. False positives
+         * are possible, but are rare and harmless, since
+         * we compare keys of matching slots anyway.
+         */
+        static uint64_t match(uint64_t group, uint8_t h2) noexcept
+        {
+            auto x = group ^ (lsbs * h2);
+
+            return (x - lsbs) & ~x & msbs;
+        }
+
+        static uint64_t match_empty(uint64_t group) noexcept
+        {
+            // Only empty has the high bit set and bit 1 clear.
+            return group & (~group << 6) & msbs;
+        }
+
+        static uint64_t match_empty_or_deleted(uint64_t group) noexcept
+        {
+            // Only empty and deleted have the high bit set and bit 0 clear.
+            return group & (~group << 7) & msbs;
+        }
+
+        static size_t first(uint64_t mask) noexcept
+        {
+            return static_cast<size_t>(__builtin_ctzll(mask)) / 8;
+        }
+    };
+
+    template<class Value, class Reference, class Pointer>
+    class flat_hash_table_const_iterator;
+
+    template<class Value, class Reference, class Pointer>
+    class flat_hash_table_iterator
+    {
+        public:
+            using value_type      = Value;
+            using reference       = Reference;
+            using pointer         = Pointer;
+            using difference_type = ptrdiff_t;
+
+            using iterator_category = forward_iterator_tag;
+
+            flat_hash_table_iterator(const uint8_t* ctrl = nullptr,
+                                     const uint8_t* ctrl_end = nullptr,
+                                     value_type* slot = nullptr)
+                : ctrl_{ctrl}, ctrl_end_{ctrl_end}, slot_{slot}
+            {
+                skip_free_();
+            }
+
+            flat_hash_table_iterator(const flat_hash_table_iterator&) = default;
+            flat_hash_table_iterator& operator=(const flat_hash_table_iterator&) = default;
+
+            reference operator*() const
+            {
+                return *slot_;
+            }
+
+            pointer operator->() const
+            {
+                return slot_;
+            }
+
+            flat_hash_table_iterator& operator++()
+            {
+                ++ctrl_;
+                ++slot_;
+                skip_free_();
+
+                return *this;
+            }
+
+            flat_hash_table_iterator operator++(int)
+            {
+                auto tmp = *this;
+                ++(*this);
+
+                return tmp;
+            }
+
+            bool operator==(const flat_hash_table_iterator& other) const
+            {
+                return ctrl_ == other.ctrl_;
+            }
+
+            bool operator!=(const flat_hash_table_iterator& other) const
+            {
+                return ctrl_ != other.ctrl_;
+            }
+
+        private:
+            const uint8_t* ctrl_;
+            const uint8_t* ctrl_end_;
+            value_type* slot_;
+
+            void skip_free_()
+            {
+                while (ctrl_ != ctrl_end_ && !flat_hash_ctrl::is_full(*ctrl_))
+                {
+                    ++ctrl_;
+                    ++slot_;
+                }
+            }
+
+            template<class V, class R, class P>
+            friend class flat_hash_table_const_iterator;
+
+            template<class, class, class, class, class, class>
+            friend class flat_hash_table;
+    };
+
+    template<class Value, class ConstReference, class ConstPointer>
+    class flat_hash_table_const_iterator
+    {
+        public:
+            using value_type      = Value;
+            using reference       = ConstReference;
+            using pointer         = ConstPointer;
+            using difference_type = ptrdiff_t;
+
+            using iterator_category = forward_iterator_tag;
+
+            flat_hash_table_const_iterator(const uint8_t* ctrl = nullptr,
+                                           const uint8_t* ctrl_end = nullptr,
+                                           const value_type* slot = nullptr)
+                : ctrl_{ctrl}, ctrl_end_{ctrl_end}, slot_{slot}
+            {
+                skip_free_();
+            }
+
+            template<class Reference, class Pointer>
+            flat_hash_table_const_iterator(
+                const flat_hash_table_iterator<Value, Reference, Pointer>& other)
+                : ctrl_{other.ctrl_}, ctrl_end_{other.ctrl_end_}, slot_{other.slot_}
+            { /* DUMMY BODY */ }
+
+            flat_hash_table_const_iterator(const flat_hash_table_const_iterator&) = default;
+            flat_hash_table_const_iterator& operator=(const flat_hash_table_const_iterator&) = default;
+
+            reference operator*() const
+            {
+                return *slot_;
+            }
+
+            pointer operator->() const
+            {
+                return slot_;
+            }
+
+            flat_hash_table_const_iterator& operator++()
+            {
+                ++ctrl_;
+                ++slot_;
+                skip_free_();
+
+                return *this;
+            }
+
+            flat_hash_table_const_iterator operator++(int)
+            {
+                auto tmp = *this;
+                ++(*this);
+
+                return tmp;
+            }
+
+            bool operator==(const flat_hash_table_const_iterator& other) const
+            {
+                return ctrl_ == other.ctrl_;
+            }
+
+            bool operator!=(const flat_hash_table_const_iterator& other) const
+            {
+                return ctrl_ != other.ctrl_;
+            }
+
+        private:
+            const uint8_t* ctrl_;
+            const uint8_t* ctrl_end_;
+            const value_type* slot_;
+
+            void skip_free_()
+            {
+                while (ctrl_ != ctrl_end_ && !flat_hash_ctrl::is_full(*ctrl_))
+                {
+                    ++ctrl_;
+                    ++slot_;
+                }
+            }
+
+            template<class, class, class, class, class, class>
+            friend class flat_hash_table;
+    };
+
+    template<class Value, class R1, class P1, class R2, class P2>
+    bool operator==(const flat_hash_table_iterator<Value, R1, P1>& lhs,
+                    const flat_hash_table_const_iterator<Value, R2, P2>& rhs)
+    {
+        return flat_hash_table_const_iterator<Value, R2, P2>{lhs} == rhs;
+    }
+
+    template<class Value, class R1, class P1, class R2, class P2>
+    bool operator!=(const flat_hash_table_iterator<Value, R1, P1>& lhs,
+                    const flat_hash_table_const_iterator<Value, R2, P2>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<class Value, class R1, class P1, class R2, class P2>
+    bool operator==(const flat_hash_table_const_iterator<Value, R1, P1>& lhs,
+                    const flat_hash_table_iterator<Value, R2, P2>& rhs)
+    {
+        return rhs == lhs;
+    }
+
+    template<class Value, class R1, class P1, class R2, class P2>
+    bool operator!=(const flat_hash_table_const_iterator<Value, R1, P1>& lhs,
+                    const flat_hash_table_iterator<Value, R2, P2>& rhs)
+    {
+        return !(rhs == lhs);
+    }
+
+    template<
+        class Value, class Key, class KeyExtractor,
+        class Hasher, class KeyEq, class Alloc
+    >
+    class flat_hash_table
+    {
+        public:
+            using value_type      = Value;
+            using key_type        = Key;
+            using size_type       = size_t;
+            using difference_type = ptrdiff_t;
+            using allocator_type  = Alloc;
+            using key_equal       = KeyEq;
+            using hasher          = Hasher;
+            using key_extract     = KeyExtractor;
+            using reference       = value_type&;
+            using const_reference = const value_type&;
+            using pointer         = value_type*;
+            using const_pointer   = const value_type*;
+
+            using iterator       = flat_hash_table_iterator<
+                value_type, reference, pointer
+            >;
+            using const_iterator = flat_hash_table_const_iterator<
+                value_type, const_reference, const_pointer
+            >;
+
+            flat_hash_table()
+                : flat_hash_table(size_type{})
+            { /* DUMMY BODY */ }
+
+            explicit flat_hash_table(size_type n, const hasher& hf = hasher{},
+                                     const key_equal& eql = key_equal{},
+                                     const allocator_type& alloc = allocator_type{})
+                : ctrl_{}, slots_{}, capacity_{}, size_{}, growth_left_{},
+                  hasher_{hf}, key_eq_{eql}, key_extractor_{}, allocator_{alloc}
+            {
+                if (n > 0)
+                    reserve(n);
+            }
+
+            template<class InputIterator>
+            flat_hash_table(InputIterator first, InputIterator last,
+                            size_type n = 0, const hasher& hf = hasher{},
+                            const key_equal& eql = key_equal{},
+                            const allocator_type& alloc = allocator_type{})
+                : flat_hash_table(n, hf, eql, alloc)
+            {
+                insert(first, last);
+            }
+
+            flat_hash_table(initializer_list<value_type> init,
+                            size_type n = 0, const hasher& hf = hasher{},
+                            const key_equal& eql = key_equal{},
+                            const allocator_type& alloc = allocator_type{})
+                : flat_hash_table(n, hf, eql, alloc)
+            {
+                insert(init.begin(), init.end());
+            }
+
+            flat_hash_table(const flat_hash_table& other)
+                : flat_hash_table(other.size_, other.hasher_,
+                                  other.key_eq_, other.allocator_)
+            {
+                insert(other.begin(), other.end());
+            }
+
+            flat_hash_table(flat_hash_table&& other) noexcept
+                : ctrl_{other.ctrl_}, slots_{other.slots_},
+                  capacity_{other.capacity_}, size_{other.size_},
+                  growth_left_{other.growth_left_},
+                  hasher_{move(other.hasher_)}, key_eq_{move(other.key_eq_)},
+                  key_extractor_{}, allocator_{move(other.allocator_)}
+            {
+                other.ctrl_ = nullptr;
+                other.slots_ = nullptr;
+                other.capacity_ = 0;
+                other.size_ = 0;
+                other.growth_left_ = 0;
+            }
+
+            flat_hash_table& operator=(const flat_hash_table& other)
+            {
+                if (this != &other)
+                {
+                    flat_hash_table tmp{other};
+                    swap(tmp);
+                }
+
+                return *this;
+            }
+
+            flat_hash_table& operator=(flat_hash_table&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    flat_hash_table tmp{move(other)};
+                    swap(tmp);
+                }
+
+                return *this;
+            }
+
+            flat_hash_table& operator=(initializer_list<value_type> init)
+            {
+                clear();
+                insert(init.begin(), init.end());
+
+                return *this;
+            }
+
+            ~flat_hash_table()
+            {
+                destroy_();
+            }
+
+            allocator_type get_allocator() const noexcept
+            {
+                return allocator_;
+            }
+
+            bool empty() const noexcept
+            {
+                return size_ == 0;
+            }
+
+            size_type size() const noexcept
+            {
+                return size_;
+            }
+
+            size_type max_size() const noexcept
+            {
+                return allocator_traits<allocator_type>::max_size(allocator_);
+            }
+
+            iterator begin() noexcept
+            {
+                return iterator{ctrl_, ctrl_ + capacity_, slots_};
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return cbegin();
+            }
+
+            iterator end() noexcept
+            {
+                return iterator{ctrl_ + capacity_, ctrl_ + capacity_,
+                                slots_ + capacity_};
+            }
+
+            const_iterator end() const noexcept
+            {
+                return cend();
+            }
+
+            const_iterator cbegin() const noexcept
+            {
+                return const_iterator{ctrl_, ctrl_ + capacity_, slots_};
+            }
+
+            const_iterator cend() const noexcept
+            {
+                return const_iterator{ctrl_ + capacity_, ctrl_ + capacity_,
+                                      slots_ + capacity_};
+            }
+
+            template<class... Args>
+            pair<iterator, bool> emplace(Args&&... args)
+            {
+                value_type val{forward<Args>(args)...};
+
+                return insert(move(val));
+            }
+
+            pair<iterator, bool> insert(const value_type& val)
+            {
+                auto [idx, inserted] = find_or_prepare_insert_(key_extractor_(val));
+                if (inserted)
+                    construct_at_(idx, val);
+
+                return make_pair(iterator_at_(idx), inserted);
+            }
+
+            pair<iterator, bool> insert(value_type&& val)
+            {
+                auto [idx, inserted] = find_or_prepare_insert_(key_extractor_(val));
+                if (inserted)
+                    construct_at_(idx, move(val));
+
+                return make_pair(iterator_at_(idx), inserted);
+            }
+
+            template<class InputIterator>
+            void insert(InputIterator first, InputIterator last)
+            {
+                while (first != last)
+                    insert(*first++);
+            }
+
+            void insert(initializer_list<value_type> init)
+            {
+                insert(init.begin(), init.end());
+            }
+
+            iterator erase(const_iterator position)
+            {
+                auto idx = static_cast<size_type>(position.ctrl_ - ctrl_);
+                erase_at_(idx);
+
+                return iterator{ctrl_ + idx + 1, ctrl_ + capacity_,
+                                slots_ + idx + 1};
+            }
+
+            iterator erase(iterator position)
+            {
+                return erase(const_iterator{position});
+            }
+
+            size_type erase(const key_type& key)
+            {
+                auto idx = find_(key);
+                if (idx == capacity_)
+                    return 0;
+
+                erase_at_(idx);
+
+                return 1;
+            }
+
+            iterator erase(const_iterator first, const_iterator last)
+            {
+                while (first != last)
+                    first = erase(first);
+
+                return iterator{const_cast<uint8_t*>(last.ctrl_), ctrl_ + capacity_,
+                                const_cast<value_type*>(last.slot_)};
+            }
+
+            void clear() noexcept
+            {
+                if (capacity_ == 0)
+                    return;
+
+                for (size_type i = 0; i < capacity_; ++i)
+                {
+                    if (flat_hash_ctrl::is_full(ctrl_[i]))
+                        allocator_traits<allocator_type>::destroy(allocator_, slots_ + i);
+                }
+
+                std::memset(ctrl_, flat_hash_ctrl::empty,
+                            capacity_ + flat_hash_ctrl::group_width);
+                size_ = 0;
+                growth_left_ = max_growth_(capacity_);
+            }
+
+            void swap(flat_hash_table& other)
+            {
+                std::swap(ctrl_, other.ctrl_);
+                std::swap(slots_, other.slots_);
+                std::swap(capacity_, other.capacity_);
+                std::swap(size_, other.size_);
+                std::swap(growth_left_, other.growth_left_);
+                std::swap(hasher_, other.hasher_);
+                std::swap(key_eq_, other.key_eq_);
+                std::swap(allocator_, other.allocator_);
+            }
+
+            hasher hash_function() const
+            {
+                return hasher_;
+            }
+
+            key_equal key_eq() const
+            {
+                return key_eq_;
+            }
+
+            iterator find(const key_type& key)
+            {
+                return iterator_at_(find_(key));
+            }
+
+            const_iterator find(const key_type& key) const
+            {
+                return const_iterator_at_(find_(key));
+            }
+
+            size_type count(const key_type& key) const
+            {
+                return find_(key) != capacity_ ? 1 : 0;
+            }
+
+            bool contains(const key_type& key) const
+            {
+                return find_(key) != capacity_;
+            }
+
+            size_type bucket_count() const noexcept
+            {
+                return capacity_;
+            }
+
+            float load_factor() const noexcept
+            {
+                if (capacity_ == 0)
+                    return 0.f;
+
+                return size_ / static_cast<float>(capacity_);
+            }
+
+            float max_load_factor() const noexcept
+            {
+                return max_load_num_ / static_cast<float>(max_load_den_);
+            }
+
+            void rehash(size_type n)
+            {
+                auto needed = min_capacity_(max(n, size_));
+                if (needed != capacity_ || growth_left_ < max_growth_(capacity_) - size_)
+                    resize_(needed);
+            }
+
+            void reserve(size_type n)
+            {
+                if (n > size_ + growth_left_)
+                    resize_(min_capacity_(n));
+            }
+
+            /**
+             * HelenOS extension: number of bytes of memory
+             * allocated by the table.
+             */
+            size_type memory_usage() const noexcept
+            {
+                if (capacity_ == 0)
+                    return 0;
+
+                return capacity_ * sizeof(value_type) +
+                       capacity_ + flat_hash_ctrl::group_width;
+            }
+
+        protected:
+            /**
+             * Finds the key, or reserves a slot for it if it is
+             * not present. In that case the caller is responsible
+             * for constructing an element with the key in the slot.
+             */
+            pair<size_type, bool> find_or_prepare_insert_(const key_type& key)
+            {
+                auto h = hash_(key);
+                auto idx = find_(key, h);
+                if (idx != capacity_)
+                    return make_pair(idx, false);
+
+                return make_pair(prepare_insert_(h), true);
+            }
+
+            template<class... Args>
+            void construct_at_(size_type idx, Args&&... args)
+            {
+                allocator_traits<allocator_type>::construct(
+                    allocator_, slots_ + idx, forward<Args>(args)...
+                );
+            }
+
+            iterator iterator_at_(size_type idx) noexcept
+            {
+                return iterator{ctrl_ + idx, ctrl_ + capacity_, slots_ + idx};
+            }
+
+            const_iterator const_iterator_at_(size_type idx) const noexcept
+            {
+                return const_iterator{ctrl_ + idx, ctrl_ + capacity_, slots_ + idx};
+            }
+
+            size_type find_(const key_type& key) const
+            {
+                return find_(key, hash_(key));
+            }
+
+        private:
+            uint8_t* ctrl_;
+            value_type* slots_;
+            size_type capacity_;
+            size_type size_;
+            size_type growth_left_;
+            hasher hasher_;
+            key_equal key_eq_;
+            key_extract key_extractor_;
+            allocator_type allocator_;
+
+            // Maximum load factor of 7/8.
+            static constexpr size_type max_load_num_{7};
+            static constexpr size_type max_load_den_{8};
+
+            static constexpr size_type min_capacity_value_{
+                flat_hash_ctrl::group_width
+            };
+
+            static size_type max_growth_(size_type capacity) noexcept
+            {
+                return capacity / max_load_den_ * max_load_num_;
+            }
+
+            static size_type min_capacity_(size_type n) noexcept
+            {
+                size_type capacity{min_capacity_value_};
+                while (max_growth_(capacity) < n)
+                    capacity *= 2;
+
+                return capacity;
+            }
+
+            /**
+             * Standard hashers are often the identity,
+             * so we mix the bits before we use them.
+             */
+            size_t hash_(const key_type& key) const
+            {
+                uint64_t h = static_cast<uint64_t>(hasher_(key)) *
+                    0x9e3779b97f4a7c15ull;
+
+                return static_cast<size_t>(h ^ (h >> 32));
+            }
+
+            static uint8_t h2_(size_t h) noexcept
+            {
+                return static_cast<uint8_t>(h & 0x7f);
+            }
+
+            static size_t h1_(size_t h) noexcept
+            {
+                return h >> 7;
+            }
+
+            void set_ctrl_(size_type idx, uint8_t c) noexcept
+            {
+                ctrl_[idx] = c;
+
+                // Groups starting near the end wrap around.
+                if (idx < flat_hash_ctrl::group_width)
+                    ctrl_[capacity_ + idx] = c;
+            }
+
+            size_type find_(const key_type& key, size_t h) const
+            {
+                if (size_ == 0)
+                    return capacity_;
+
+                auto mask = capacity_ - 1;
+                auto pos = h1_(h) & mask;
+                size_type step{};
+
+                while (true)
+                {
+                    auto group = flat_hash_ctrl::load(ctrl_ + pos);
+
+                    auto match = flat_hash_ctrl::match(group, h2_(h));
+                    while (match != 0)
+                    {
+                        auto idx = (pos + flat_hash_ctrl::first(match)) & mask;
+                        if (key_eq_(key_extractor_(slots_[idx]), key))
+                            return idx;
+
+                        match &= match - 1;
+                    }
+
+                    if (flat_hash_ctrl::match_empty(group) != 0)
+                        return capacity_;
+
+                    step += flat_hash_ctrl::group_width;
+                    pos = (pos + step) & mask;
+                }
+            }
+
+            /**
+             * Returns the first empty or deleted slot in
+             * the probe sequence of hash h.
+             */
+            size_type find_free_(size_t h) const noexcept
+            {
+                auto mask = capacity_ - 1;
+                auto pos = h1_(h) & mask;
+                size_type step{};
+
+                while (true)
+                {
+                    auto group = flat_hash_ctrl::load(ctrl_ + pos);
+
+                    auto match = flat_hash_ctrl::match_empty_or_deleted(group);
+                    if (match != 0)
+                        return (pos + flat_hash_ctrl::first(match)) & mask;
+
+                    step += flat_hash_ctrl::group_width;
+                    pos = (pos + step) & mask;
+                }
+            }
+
+            size_type prepare_insert_(size_t h)
+            {
+                auto idx = capacity_ > 0 ? find_free_(h) : capacity_;
+
+                if (capacity_ == 0 ||
+                    (growth_left_ == 0 && ctrl_[idx] != flat_hash_ctrl::deleted))
+                {
+                    /**
+                     * If most of the used up growth went to
+                     * deleted slots, just get rid of them,
+                     * otherwise grow.
+                     */
+                    if (capacity_ > 0 && size_ <= max_growth_(capacity_) / 2)
+                        resize_(capacity_);
+                    else
+                        resize_(capacity_ > 0 ? capacity_ * 2 : min_capacity_value_);
+
+                    idx = find_free_(h);
+                }
+
+                if (ctrl_[idx] == flat_hash_ctrl::empty)
+                    --growth_left_;
+
+                set_ctrl_(idx, h2_(h));
+                ++size_;
+
+                return idx;
+            }
+
+            void erase_at_(size_type idx)
+            {
+                allocator_traits<allocator_type>::destroy(allocator_, slots_ + idx);
+                set_ctrl_(idx, flat_hash_ctrl::deleted);
+                --size_;
+            }
+
+            void resize_(size_type capacity)
+            {
+                auto old_ctrl = ctrl_;
+                auto old_slots = slots_;
+                auto old_capacity = capacity_;
+
+                ctrl_ = new uint8_t[capacity + flat_hash_ctrl::group_width];
+                std::memset(ctrl_, flat_hash_ctrl::empty,
+                            capacity + flat_hash_ctrl::group_width);
+                slots_ = allocator_.allocate(capacity);
+                capacity_ = capacity;
+                growth_left_ = max_growth_(capacity) - size_;
+
+                for (size_type i = 0; i < old_capacity; ++i)
+                {
+                    if (!flat_hash_ctrl::is_full(old_ctrl[i]))
+                        continue;
+
+                    auto h = hash_(key_extractor_(old_slots[i]));
+                    auto idx = find_free_(h);
+                    set_ctrl_(idx, h2_(h));
+
+                    allocator_traits<allocator_type>::construct(
+                        allocator_, slots_ + idx, move(old_slots[i])
+                    );
+                    allocator_traits<allocator_type>::destroy(allocator_, old_slots + i);
+                }
+
+                if (old_capacity > 0)
+                {
+                    allocator_.deallocate(old_slots, old_capacity);
+                    delete[] old_ctrl;
+                }
+            }
+
+            void destroy_()
+            {
+                if (capacity_ == 0)
+                    return;
+
+                clear();
+                allocator_.deallocate(slots_, capacity_);
+                delete[] ctrl_;
+
+                ctrl_ = nullptr;
+                slots_ = nullptr;
+                capacity_ = 0;
+                growth_left_ = 0;
+            }
+    };
+}
+
+#endif
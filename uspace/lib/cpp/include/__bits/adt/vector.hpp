@@ -33,6 +33,7 @@
 #include <initializer_list>
 #include <iterator>
 #include <memory>
+#include <type_traits>
 #include <utility>
 
 namespace std
@@ -82,15 +83,19 @@ namespace std
                 data_ = allocator_.allocate(capacity_);
 
                 for (size_type i = 0; i < size_; ++i)
-                    data_[i] = val;
+                    allocator_traits<Allocator>::construct(allocator_, data_ + i, val);
             }
 
-            template<class InputIterator>
+            template<
+                class InputIterator,
+                enable_if_t<!is_integral<InputIterator>::value>* = nullptr
+            >
             vector(InputIterator first, InputIterator last,
                    const Allocator& alloc = Allocator{})
+                : data_{nullptr}, size_{}, capacity_{}, allocator_{alloc}
             {
-                // TODO: research constraints and provide multiple
-                //       implementations via enable_if
+                while (first != last)
+                    push_back(*first++);
             }
 
             vector(const vector& other)
@@ -100,7 +105,7 @@ namespace std
                 data_ = allocator_.allocate(capacity_);
 
                 for (size_type i = 0; i < size_; ++i)
-                    data_[i] = other.data_[i];
+                    allocator_traits<Allocator>::construct(allocator_, data_ + i, other.data_[i]);
             }
 
             vector(vector&& other) noexcept
@@ -119,7 +124,7 @@ namespace std
                 data_ = allocator_.allocate(capacity_);
 
                 for (size_type i = 0; i < size_; ++i)
-                    data_[i] = other.data_[i];
+                    allocator_traits<Allocator>::construct(allocator_, data_ + i, other.data_[i]);
             }
 
             vector(initializer_list<T> init, const Allocator& alloc = Allocator{})
@@ -131,12 +136,13 @@ namespace std
                 auto it = init.begin();
                 for (size_type i = 0; it != init.end(); ++i, ++it)
                 {
-                    data_[i] = *it;
+                    allocator_traits<Allocator>::construct(allocator_, data_ + i, *it);
                 }
             }
 
             ~vector()
             {
+                destroy_from_end_until_(begin());
                 allocator_.deallocate(data_, capacity_);
             }
 
@@ -153,7 +159,10 @@ namespace std
                          allocator_traits<Allocator>::is_always_equal::value)
             {
                 if (data_)
+                {
+                    destroy_from_end_until_(begin());
                     allocator_.deallocate(data_, capacity_);
+                }
 
                 // TODO: test this
                 data_ = other.data_;
@@ -274,16 +283,33 @@ namespace std
 
             void resize(size_type sz)
             {
-                resize_with_copy_(size_, capacity_);
+                if (sz <= size_)
+                {
+                    destroy_from_end_until_(begin() + sz);
+                    size_ = sz;
+                    return;
+                }
+
+                reserve(sz);
+                for (; size_ < sz; ++size_)
+                    allocator_traits<Allocator>::construct(allocator_, data_ + size_);
             }
 
             void resize(size_type sz, const value_type& val)
             {
-                auto old_size = size_;
-                resize_with_copy_(sz, capacity_);
+                if (sz <= size_)
+                {
+                    destroy_from_end_until_(begin() + sz);
+                    size_ = sz;
+                    return;
+                }
 
-                for (size_type i = old_size - 1; i < size_; ++i)
-                    data_[i] = val;
+                // Val may refer to one of our elements.
+                value_type copy(val);
+
+                reserve(sz);
+                for (; size_ < sz; ++size_)
+                    allocator_traits<Allocator>::construct(allocator_, data_ + size_, copy);
             }
 
             size_type capacity() const noexcept
@@ -377,6 +403,7 @@ namespace std
 
                 allocator_traits<Allocator>::construct(allocator_,
                                                        begin() + size_, forward<Args>(args)...);
+                ++size_;
 
                 return back();
             }
@@ -385,14 +412,18 @@ namespace std
             {
                 if (size_ >= capacity_)
                     resize_with_copy_(size_, next_capacity_());
-                data_[size_++] = x;
+                allocator_traits<Allocator>::construct(allocator_,
+                                                       data_ + size_, x);
+                ++size_;
             }
 
             void push_back(T&& x)
             {
                 if (size_ >= capacity_)
                     resize_with_copy_(size_, next_capacity_());
-                data_[size_++] = forward<T>(x);
+                allocator_traits<Allocator>::construct(allocator_,
+                                                       data_ + size_, forward<T>(x));
+                ++size_;
             }
 
             void pop_back()
@@ -404,22 +435,18 @@ namespace std
             template<class... Args>
             iterator emplace(const_iterator position, Args&&... args)
             {
-                auto pos = const_cast<iterator>(position);
+                // The arguments may refer to one of our elements.
+                value_type tmp(forward<Args>(args)...);
 
-                pos = shift_(pos, 1);
-                allocator_.construct(pos, forward<Args>(args)...);
-
-                return pos;
+                return insert(position, move(tmp));
             }
 
             iterator insert(const_iterator position, const value_type& x)
             {
-                auto pos = const_cast<iterator>(position);
-
-                pos = shift_(pos, 1);
-                *pos = x;
+                // X may refer to one of our elements.
+                value_type copy(x);
 
-                return pos;
+                return insert(position, move(copy));
             }
 
             iterator insert(const_iterator position, value_type&& x)
@@ -427,7 +454,7 @@ namespace std
                 auto pos = const_cast<iterator>(position);
 
                 pos = shift_(pos, 1);
-                *pos = forward<value_type>(x);
+                allocator_traits<Allocator>::construct(allocator_, pos, forward<value_type>(x));
 
                 return pos;
             }
@@ -435,16 +462,19 @@ namespace std
             iterator insert(const_iterator position, size_type count, const value_type& x)
             {
                 auto pos = const_cast<iterator>(position);
+                value_type copy(x);
 
                 pos = shift_(pos, count);
-                auto copy_target = pos;
                 for (size_type i = 0; i < count; ++i)
-                    *copy_target++ = x;
+                    allocator_traits<Allocator>::construct(allocator_, pos + i, copy);
 
                 return pos;
             }
 
-            template<class InputIterator>
+            template<
+                class InputIterator,
+                enable_if_t<!is_integral<InputIterator>::value>* = nullptr
+            >
             iterator insert(const_iterator position, InputIterator first,
                             InputIterator last)
             {
@@ -452,34 +482,27 @@ namespace std
                 auto count = static_cast<size_type>(last - first);
 
                 pos = shift_(pos, count);
-                copy(first, last, pos);
+                for (auto it = pos; first != last; ++it, ++first)
+                    allocator_traits<Allocator>::construct(allocator_, it, *first);
 
                 return pos;
             }
 
             iterator insert(const_iterator position, initializer_list<T> init)
             {
-                auto pos = const_cast<iterator>(position);
-
-                pos = shift_(pos, init.size());
-                copy(init.begin(), init.end(), pos);
-
-                return pos;
+                return insert(position, init.begin(), init.end());
             }
 
             iterator erase(const_iterator position)
             {
-                iterator pos = const_cast<iterator>(position);
-                copy(position + 1, cend(), pos);
-                --size_;
-
-                return pos;
+                return erase(position, position + 1);
             }
 
             iterator erase(const_iterator first, const_iterator last)
             {
                 iterator pos = const_cast<iterator>(first);
-                copy(last, cend(), pos);
+                auto new_end = move(const_cast<iterator>(last), end(), pos);
+                destroy_from_end_until_(new_end);
                 size_ -= static_cast<size_type>(last - first);
 
                 return pos;
@@ -507,16 +530,6 @@ namespace std
             size_type capacity_;
             allocator_type allocator_;
 
-            void resize_without_copy_(size_type capacity)
-            {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
-
-                data_ = allocator_.allocate(capacity);
-                size_ = 0;
-                capacity_ = capacity;
-            }
-
             void resize_with_copy_(size_type size, size_type capacity)
             {
                 if (size < size_)
@@ -528,7 +541,12 @@ namespace std
 
                     auto to_copy = min(size, size_);
                     for (size_type i = 0; i < to_copy; ++i)
-                        new_data[i] = move(data_[i]);
+                    {
+                        // New storage is uninitialized.
+                        allocator_traits<Allocator>::construct(allocator_,
+                                                               new_data + i, move(data_[i]));
+                        allocator_traits<Allocator>::destroy(allocator_, data_ + i);
+                    }
 
                     std::swap(data_, new_data);
 
@@ -557,33 +575,47 @@ namespace std
                     return max(capacity_ * 2, size_type{2u});
             }
 
+            /**
+             * Makes a gap of count elements at position. The gap
+             * is uninitialized storage, the caller constructs the
+             * new elements in it.
+             */
             iterator shift_(iterator position, size_type count)
             {
-                if (size_ + count < capacity_)
+                auto start_idx = static_cast<size_type>(position - begin());
+
+                if (size_ + count <= capacity_)
                 {
-                    copy_backward(position, end(), end() + count);
+                    for (size_type i = size_; i > start_idx; --i)
+                    {
+                        allocator_traits<Allocator>::construct(allocator_,
+                                                               data_ + i - 1 + count, move(data_[i - 1]));
+                        allocator_traits<Allocator>::destroy(allocator_, data_ + i - 1);
+                    }
                     size_ += count;
 
                     return position;
                 }
                 else
                 {
-                    auto start_idx = static_cast<size_type>(position - begin());
-                    auto end_idx = start_idx + count;
                     auto new_size = size_ + count;
-
-                    // Auxiliary vector for easier swap.
-                    vector tmp{};
-                    tmp.resize_without_copy_(max(new_size, capacity_));
-                    tmp.size_ = new_size;
-
-                    // Copy before insertion index.
-                    copy(begin(), begin() + start_idx, tmp.begin());
-
-                    // Copy after insertion index.
-                    copy(begin() + start_idx, end(), tmp.begin() + end_idx);
-
-                    swap(tmp);
+                    auto new_capacity = next_capacity_(new_size);
+                    auto new_data = allocator_.allocate(new_capacity);
+
+                    for (size_type i = 0; i < size_; ++i)
+                    {
+                        auto target = i < start_idx ? i : i + count;
+                        allocator_traits<Allocator>::construct(allocator_,
+                                                               new_data + target, move(data_[i]));
+                        allocator_traits<Allocator>::destroy(allocator_, data_ + i);
+                    }
+
+                    if (data_)
+                        allocator_.deallocate(data_, capacity_);
+
+                    data_ = new_data;
+                    size_ = new_size;
+                    capacity_ = new_capacity;
 
                     // Position was invalidated!
                     return begin() + start_idx;
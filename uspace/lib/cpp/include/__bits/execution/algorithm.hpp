@@ -0,0 +1,490 @@
+#ifndef LIBCPP_BITS_EXECUTION_ALGORITHM
+#define LIBCPP_BITS_EXECUTION_ALGORITHM
+
+#include <__bits/builtins.hpp>
+#include <__bits/execution/policy.hpp>
+#include <__bits/execution/pool.hpp>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace std
+{
+    namespace aux
+    {
+        /**
+         * We only split random access ranges, everything
+         * else is executed sequentially, which is permitted.
+         */
+        template<class ExecutionPolicy, class... Iterators>
+        inline constexpr bool execute_in_parallel_v =
+            is_parallel_policy<decay_t<ExecutionPolicy>>::value &&
+            (is_base_of_v<
+                random_access_iterator_tag,
+                typename iterator_traits<Iterators>::iterator_category
+            > && ...);
+
+        /**
+         * Smallest number of elements a task gets, so that
+         * the overhead of the task does not outweigh the work.
+         */
+        inline constexpr size_t parallel_min_chunk{512};
+
+        /**
+         * Few chunks per fibril, so that stealing can
+         * balance chunks that take longer than others.
+         */
+        inline constexpr size_t parallel_chunks_per_fibril{4};
+
+        inline size_t parallel_chunks(size_t n)
+        {
+            auto concurrency = parallel_pool::get().concurrency();
+            if (concurrency <= 1)
+                return 1;
+
+            auto chunks = min(concurrency * parallel_chunks_per_fibril,
+                              n / parallel_min_chunk);
+
+            return chunks > 0 ? chunks : 1;
+        }
+
+        /**
+         * Splits [0, n) into the given number of chunks and
+         * calls f(chunk_index, begin, end) for each of them
+         * in parallel. The caller processes the last chunk.
+         */
+        template<class Function>
+        void parallel_for(size_t n, size_t chunks, Function f)
+        {
+            if (chunks <= 1)
+            {
+                f(size_t{}, size_t{}, n);
+
+                return;
+            }
+
+            task_group group{};
+
+            size_t begin{};
+            for (size_t i = 0; i < chunks; ++i)
+            {
+                auto end = begin + (n - begin) / (chunks - i);
+
+                if (i < chunks - 1)
+                    group.run([&f, i, begin, end]{ f(i, begin, end); });
+                else
+                    f(i, begin, end);
+
+                begin = end;
+            }
+
+            group.wait();
+        }
+
+        template<class Function>
+        void parallel_for(size_t n, Function f)
+        {
+            parallel_for(n, parallel_chunks(n), f);
+        }
+
+        /**
+         * Reduces the results of calling f(begin, end) on
+         * chunks of [0, n), which must not be empty.
+         */
+        template<class T, class Function, class BinaryOperation>
+        T parallel_reduce(size_t n, T init, Function f, BinaryOperation op)
+        {
+            auto chunks = parallel_chunks(n);
+            vector<T> partials(chunks, init);
+
+            parallel_for(n, chunks, [&](size_t i, size_t begin, size_t end){
+                partials[i] = f(begin, end);
+            });
+
+            return accumulate(partials.begin(), partials.end(), init, op);
+        }
+
+        /**
+         * Median of three pivot, Hoare partition with the
+         * pivot kept in the first element. Stops on elements
+         * equal to the pivot, so that ranges with many equal
+         * elements still split evenly.
+         */
+        template<class RandomAccessIterator, class Compare>
+        RandomAccessIterator parallel_partition(RandomAccessIterator first,
+                                                RandomAccessIterator last,
+                                                Compare& comp)
+        {
+            auto mid = first + (last - first) / 2;
+            auto back = last - 1;
+
+            if (comp(*mid, *first))
+                iter_swap(mid, first);
+            if (comp(*back, *mid))
+            {
+                iter_swap(back, mid);
+                if (comp(*mid, *first))
+                    iter_swap(mid, first);
+            }
+
+            iter_swap(first, mid);
+
+            auto i = first + 1;
+            auto j = back;
+            while (true)
+            {
+                while (i <= j && comp(*i, *first))
+                    ++i;
+                while (i <= j && comp(*first, *j))
+                    --j;
+
+                if (i >= j)
+                    break;
+
+                iter_swap(i++, j--);
+            }
+
+            iter_swap(first, j);
+
+            return j;
+        }
+
+        /**
+         * Ranges smaller than this are sorted sequentially.
+         */
+        inline constexpr size_t parallel_sort_cutoff{2048};
+
+        template<class RandomAccessIterator, class Compare>
+        void parallel_sort(RandomAccessIterator first, RandomAccessIterator last,
+                           Compare& comp, size_t depth, task_group& group)
+        {
+            /**
+             * We spawn the smaller part and continue with the
+             * bigger one. Once the depth limit is reached, the
+             * partitioning is likely degenerate and we fall back
+             * to the sequential sort, which is O(n log n).
+             */
+            while (static_cast<size_t>(last - first) > parallel_sort_cutoff && depth > 0)
+            {
+                --depth;
+
+                auto pivot = parallel_partition(first, last, comp);
+                auto lfirst = first;
+                auto llast = pivot;
+                auto rfirst = pivot + 1;
+                auto rlast = last;
+
+                if (llast - lfirst > rlast - rfirst)
+                {
+                    swap(lfirst, rfirst);
+                    swap(llast, rlast);
+                }
+
+                group.run([lfirst, llast, depth, &comp, &group]{
+                    parallel_sort(lfirst, llast, comp, depth, group);
+                });
+
+                first = rfirst;
+                last = rlast;
+            }
+
+            sort(first, last, comp);
+        }
+    }
+
+    /**
+     * 25.2.4, for each:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator, class Function>
+    aux::enable_if_execution_policy_t<ExecutionPolicy>
+    for_each(ExecutionPolicy&&, ForwardIterator first, ForwardIterator last,
+             Function f)
+    {
+        if constexpr (aux::execute_in_parallel_v<ExecutionPolicy, ForwardIterator>)
+        {
+            aux::parallel_for(last - first, [&](size_t, size_t begin, size_t end){
+                for_each(first + begin, first + end, f);
+            });
+        }
+        else
+            for_each(first, last, f);
+    }
+
+    /**
+     * 25.2.9, count:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator, class Predicate>
+    aux::enable_if_execution_policy_t<
+        ExecutionPolicy, typename iterator_traits<ForwardIterator>::difference_type
+    >
+    count_if(ExecutionPolicy&&, ForwardIterator first, ForwardIterator last,
+             Predicate pred)
+    {
+        using difference_type = typename iterator_traits<ForwardIterator>::difference_type;
+
+        if constexpr (aux::execute_in_parallel_v<ExecutionPolicy, ForwardIterator>)
+        {
+            if (first == last)
+                return difference_type{};
+
+            return aux::parallel_reduce(
+                last - first, difference_type{},
+                [&](size_t begin, size_t end){
+                    return count_if(first + begin, first + end, pred);
+                },
+                plus<difference_type>{}
+            );
+        }
+        else
+            return count_if(first, last, pred);
+    }
+
+    template<class ExecutionPolicy, class ForwardIterator, class T>
+    aux::enable_if_execution_policy_t<
+        ExecutionPolicy, typename iterator_traits<ForwardIterator>::difference_type
+    >
+    count(ExecutionPolicy&& policy, ForwardIterator first, ForwardIterator last,
+          const T& value)
+    {
+        return count_if(
+            forward<ExecutionPolicy>(policy), first, last,
+            [&value](const auto& x){ return x == value; }
+        );
+    }
+
+    /**
+     * 25.3.4, transform:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator1,
+             class ForwardIterator2, class UnaryOperation>
+    aux::enable_if_execution_policy_t<ExecutionPolicy, ForwardIterator2>
+    transform(ExecutionPolicy&&, ForwardIterator1 first, ForwardIterator1 last,
+              ForwardIterator2 result, UnaryOperation op)
+    {
+        if constexpr (aux::execute_in_parallel_v<
+            ExecutionPolicy, ForwardIterator1, ForwardIterator2
+        >)
+        {
+            auto n = last - first;
+            aux::parallel_for(n, [&](size_t, size_t begin, size_t end){
+                transform(first + begin, first + end, result + begin, op);
+            });
+
+            return result + n;
+        }
+        else
+            return transform(first, last, result, op);
+    }
+
+    template<class ExecutionPolicy, class ForwardIterator1, class ForwardIterator2,
+             class ForwardIterator3, class BinaryOperation>
+    aux::enable_if_execution_policy_t<ExecutionPolicy, ForwardIterator3>
+    transform(ExecutionPolicy&&, ForwardIterator1 first1, ForwardIterator1 last1,
+              ForwardIterator2 first2, ForwardIterator3 result, BinaryOperation op)
+    {
+        if constexpr (aux::execute_in_parallel_v<
+            ExecutionPolicy, ForwardIterator1, ForwardIterator2, ForwardIterator3
+        >)
+        {
+            auto n = last1 - first1;
+            aux::parallel_for(n, [&](size_t, size_t begin, size_t end){
+                transform(first1 + begin, first1 + end, first2 + begin,
+                          result + begin, op);
+            });
+
+            return result + n;
+        }
+        else
+            return transform(first1, last1, first2, result, op);
+    }
+
+    /**
+     * 25.3.6, fill:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator, class T>
+    aux::enable_if_execution_policy_t<ExecutionPolicy>
+    fill(ExecutionPolicy&&, ForwardIterator first, ForwardIterator last,
+         const T& value)
+    {
+        if constexpr (aux::execute_in_parallel_v<ExecutionPolicy, ForwardIterator>)
+        {
+            aux::parallel_for(last - first, [&](size_t, size_t begin, size_t end){
+                fill(first + begin, first + end, value);
+            });
+        }
+        else
+            fill(first, last, value);
+    }
+
+    /**
+     * 25.4.1.1, sort:
+     */
+
+    template<class ExecutionPolicy, class RandomAccessIterator, class Compare>
+    aux::enable_if_execution_policy_t<ExecutionPolicy>
+    sort(ExecutionPolicy&&, RandomAccessIterator first, RandomAccessIterator last,
+         Compare comp)
+    {
+        if constexpr (aux::execute_in_parallel_v<ExecutionPolicy, RandomAccessIterator>)
+        {
+            auto n = static_cast<size_t>(last - first);
+            if (n <= aux::parallel_sort_cutoff ||
+                aux::parallel_pool::get().concurrency() <= 1)
+            {
+                sort(first, last, comp);
+
+                return;
+            }
+
+            aux::task_group group{};
+            aux::parallel_sort(first, last, comp, 2 * aux::floor(aux::log2(n)), group);
+            group.wait();
+        }
+        else
+            sort(first, last, comp);
+    }
+
+    template<class ExecutionPolicy, class RandomAccessIterator>
+    aux::enable_if_execution_policy_t<ExecutionPolicy>
+    sort(ExecutionPolicy&& policy, RandomAccessIterator first,
+         RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        sort(forward<ExecutionPolicy>(policy), first, last, less<value_type>{});
+    }
+
+    /**
+     * C++17, reduce:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator, class T,
+             class BinaryOperation>
+    aux::enable_if_execution_policy_t<ExecutionPolicy, T>
+    reduce(ExecutionPolicy&&, ForwardIterator first, ForwardIterator last,
+           T init, BinaryOperation op)
+    {
+        if constexpr (aux::execute_in_parallel_v<ExecutionPolicy, ForwardIterator>)
+        {
+            if (first == last)
+                return init;
+
+            return aux::parallel_reduce(
+                last - first, init,
+                [&](size_t begin, size_t end){
+                    T acc = first[begin];
+                    for (auto i = begin + 1; i < end; ++i)
+                        acc = op(acc, first[i]);
+
+                    return acc;
+                },
+                op
+            );
+        }
+        else
+            return reduce(first, last, init, op);
+    }
+
+    template<class ExecutionPolicy, class ForwardIterator, class T>
+    aux::enable_if_execution_policy_t<ExecutionPolicy, T>
+    reduce(ExecutionPolicy&& policy, ForwardIterator first,
+           ForwardIterator last, T init)
+    {
+        return reduce(forward<ExecutionPolicy>(policy), first, last,
+                      init, plus<>{});
+    }
+
+    template<class ExecutionPolicy, class ForwardIterator>
+    aux::enable_if_execution_policy_t<
+        ExecutionPolicy, typename iterator_traits<ForwardIterator>::value_type
+    >
+    reduce(ExecutionPolicy&& policy, ForwardIterator first, ForwardIterator last)
+    {
+        using value_type = typename iterator_traits<ForwardIterator>::value_type;
+
+        return reduce(forward<ExecutionPolicy>(policy), first, last,
+                      value_type{}, plus<>{});
+    }
+
+    /**
+     * C++17, transform reduce:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator1, class ForwardIterator2,
+             class T, class BinaryOperation1, class BinaryOperation2>
+    aux::enable_if_execution_policy_t<ExecutionPolicy, T>
+    transform_reduce(ExecutionPolicy&&, ForwardIterator1 first1,
+                     ForwardIterator1 last1, ForwardIterator2 first2, T init,
+                     BinaryOperation1 op1, BinaryOperation2 op2)
+    {
+        if constexpr (aux::execute_in_parallel_v<
+            ExecutionPolicy, ForwardIterator1, ForwardIterator2
+        >)
+        {
+            if (first1 == last1)
+                return init;
+
+            return aux::parallel_reduce(
+                last1 - first1, init,
+                [&](size_t begin, size_t end){
+                    T acc = op2(first1[begin], first2[begin]);
+                    for (auto i = begin + 1; i < end; ++i)
+                        acc = op1(acc, op2(first1[i], first2[i]));
+
+                    return acc;
+                },
+                op1
+            );
+        }
+        else
+            return transform_reduce(first1, last1, first2, init, op1, op2);
+    }
+
+    template<class ExecutionPolicy, class ForwardIterator1,
+             class ForwardIterator2, class T>
+    aux::enable_if_execution_policy_t<ExecutionPolicy, T>
+    transform_reduce(ExecutionPolicy&& policy, ForwardIterator1 first1,
+                     ForwardIterator1 last1, ForwardIterator2 first2, T init)
+    {
+        return transform_reduce(forward<ExecutionPolicy>(policy), first1, last1,
+                                first2, init, plus<>{}, multiplies<>{});
+    }
+
+    template<class ExecutionPolicy, class ForwardIterator, class T,
+             class BinaryOperation, class UnaryOperation>
+    aux::enable_if_execution_policy_t<ExecutionPolicy, T>
+    transform_reduce(ExecutionPolicy&&, ForwardIterator first,
+                     ForwardIterator last, T init,
+                     BinaryOperation bop, UnaryOperation uop)
+    {
+        if constexpr (aux::execute_in_parallel_v<ExecutionPolicy, ForwardIterator>)
+        {
+            if (first == last)
+                return init;
+
+            return aux::parallel_reduce(
+                last - first, init,
+                [&](size_t begin, size_t end){
+                    T acc = uop(first[begin]);
+                    for (auto i = begin + 1; i < end; ++i)
+                        acc = bop(acc, uop(first[i]));
+
+                    return acc;
+                },
+                bop
+            );
+        }
+        else
+            return transform_reduce(first, last, init, bop, uop);
+    }
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef LIBCPP_BITS_EXECUTION_POLICY
+#define LIBCPP_BITS_EXECUTION_POLICY
+
+#include <__bits/type_traits/type_traits.hpp>
+
+namespace std
+{
+    /**
+     * 20.19.3, execution policy type trait:
+     */
+
+    template<class T>
+    struct is_execution_policy: false_type
+    { /* DUMMY BODY */ };
+
+    template<class T>
+    inline constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+    namespace execution
+    {
+        /**
+         * 20.19.4, sequenced execution policy:
+         */
+
+        class sequenced_policy
+        { /* DUMMY BODY */ };
+
+        /**
+         * 20.19.5, parallel execution policy:
+         */
+
+        class parallel_policy
+        { /* DUMMY BODY */ };
+
+        /**
+         * 20.19.6, parallel and unsequenced execution policy:
+         */
+
+        class parallel_unsequenced_policy
+        { /* DUMMY BODY */ };
+
+        /**
+         * 20.19.7, execution policy objects:
+         */
+
+        inline constexpr sequenced_policy seq{};
+        inline constexpr parallel_policy par{};
+        inline constexpr parallel_unsequenced_policy par_unseq{};
+    }
+
+    template<>
+    struct is_execution_policy<execution::sequenced_policy>: true_type
+    { /* DUMMY BODY */ };
+
+    template<>
+    struct is_execution_policy<execution::parallel_policy>: true_type
+    { /* DUMMY BODY */ };
+
+    template<>
+    struct is_execution_policy<execution::parallel_unsequenced_policy>: true_type
+    { /* DUMMY BODY */ };
+
+    namespace aux
+    {
+        /**
+         * Note: We do not vectorize explicitly, so par_unseq
+         *       is executed the same way as par.
+         */
+        template<class T>
+        struct is_parallel_policy: false_type
+        { /* DUMMY BODY */ };
+
+        template<>
+        struct is_parallel_policy<execution::parallel_policy>: true_type
+        { /* DUMMY BODY */ };
+
+        template<>
+        struct is_parallel_policy<execution::parallel_unsequenced_policy>: true_type
+        { /* DUMMY BODY */ };
+
+        /**
+         * Used to remove the policy overloads from overload
+         * resolution when the first argument is not a policy.
+         */
+        template<class ExecutionPolicy, class T = void>
+        using enable_if_execution_policy_t = enable_if_t<
+            is_execution_policy_v<decay_t<ExecutionPolicy>>, T
+        >;
+    }
+}
+
+#endif
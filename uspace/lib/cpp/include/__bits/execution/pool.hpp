@@ -0,0 +1,177 @@
+#ifndef LIBCPP_BITS_EXECUTION_POOL
+#define LIBCPP_BITS_EXECUTION_POOL
+
+#include <__bits/thread/threading.hpp>
+#include <__bits/utility/forward_move.hpp>
+#include <cstdlib>
+#include <type_traits>
+
+namespace std::aux
+{
+    /**
+     * Pool of worker fibrils used by the parallel algorithms.
+     *
+     * Each worker owns a deque of tasks. A worker pushes
+     * the tasks it spawns to the back of its deque and pops
+     * from the back (so that it continues with the data that
+     * is still in its cache), idle workers steal from the
+     * front of the deques of other workers. The workers are
+     * fibrils, which the fibril scheduler spreads over its
+     * runner threads, so when a worker blocks, the runner
+     * simply continues with another worker.
+     */
+
+    class task_group;
+
+    class parallel_task
+    {
+        public:
+            virtual void execute() noexcept = 0;
+
+            virtual ~parallel_task() = default;
+
+        private:
+            parallel_task* prev_{};
+            parallel_task* next_{};
+            task_group* group_{};
+
+            friend class parallel_pool;
+            friend class task_group;
+    };
+
+    template<class Callable>
+    class parallel_task_impl: public parallel_task
+    {
+        public:
+            parallel_task_impl(Callable&& clbl)
+                : callable_{forward<Callable>(clbl)}
+            { /* DUMMY BODY */ }
+
+            /**
+             * Note: The standard requires std::terminate to be
+             *       called when an element access function of
+             *       a parallel algorithm exits via an exception,
+             *       which noexcept does for us.
+             */
+            void execute() noexcept override
+            {
+                callable_();
+            }
+
+        private:
+            Callable callable_;
+    };
+
+    class parallel_pool
+    {
+        public:
+            /**
+             * Returns the pool, the first call starts
+             * the workers.
+             */
+            static parallel_pool& get();
+
+            /**
+             * Number of fibrils that execute tasks of
+             * a parallel algorithm, i.e. the workers that
+             * are allowed to take tasks and the caller.
+             */
+            size_t concurrency() const noexcept
+            {
+                return active_ + 1;
+            }
+
+            /**
+             * Limits the number of fibrils that execute
+             * tasks (used by benchmarks to measure scaling),
+             * zero means no limit. Must not be called while
+             * a parallel algorithm is running.
+             */
+            void set_concurrency(size_t n) noexcept;
+
+            size_t workers() const noexcept
+            {
+                return worker_count_;
+            }
+
+        private:
+            struct worker
+            {
+                mutex_t mtx;
+                parallel_task* head;
+                parallel_task* tail;
+                thread_t fid;
+                size_t idx;
+                parallel_pool* pool;
+            };
+
+            worker* workers_;
+            size_t worker_count_;
+            size_t active_;
+
+            mutex_t sleep_mtx_;
+            condvar_t sleep_cv_;
+            condvar_t idle_cv_;
+            size_t sleepers_;
+
+            parallel_pool();
+
+            void push_(parallel_task*);
+            parallel_task* take_(worker*);
+            parallel_task* pop_back_(worker&);
+            parallel_task* pop_front_(worker&);
+            bool has_work_();
+            worker* current_worker_();
+            worker& shared_();
+            void sleep_(worker&);
+
+            static void execute_(parallel_task*);
+            static int worker_main_(void*);
+
+            friend class task_group;
+    };
+
+    /**
+     * Set of tasks that can be waited for together.
+     */
+    class task_group
+    {
+        public:
+            task_group();
+
+            task_group(const task_group&) = delete;
+            task_group& operator=(const task_group&) = delete;
+
+            ~task_group();
+
+            template<class Callable>
+            void run(Callable&& clbl)
+            {
+                auto task = new parallel_task_impl<decay_t<Callable>>{
+                    forward<Callable>(clbl)
+                };
+
+                add_(task);
+            }
+
+            /**
+             * Waits until all tasks of the group are finished.
+             * If called from a worker, the worker executes
+             * tasks in the meantime.
+             */
+            void wait();
+
+        private:
+            parallel_pool& pool_;
+            mutex_t mtx_;
+            condvar_t cv_;
+            size_t pending_;
+
+            void add_(parallel_task*);
+            void finished_();
+
+            friend class parallel_pool;
+    };
+}
+
+#endif
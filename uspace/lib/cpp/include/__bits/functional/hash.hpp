@@ -75,7 +75,9 @@ namespace std
             static_assert(is_arithmetic<T>::value || is_pointer<T>::value,
                           "invalid type passed to aux::hash");
 
+            // Types narrower than 64 bits must not leave garbage in the result.
             converter<T> conv;
+            conv.converted = 0;
             conv.value = x;
 
             return hash_<size_t>(conv.converted);
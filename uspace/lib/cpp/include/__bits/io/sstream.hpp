@@ -72,9 +72,13 @@ namespace std
             basic_stringbuf(const basic_stringbuf&) = delete;
 
             basic_stringbuf(basic_stringbuf&& other)
-                : mode_{move(other.mode_)}, str_{move(other.str_)}
+                : mode_{move(other.mode_)}, str_{}
             {
+                auto old_data = other.str_.data();
+
+                str_ = move(other.str_);
                 basic_streambuf<char_type, traits_type>::swap(other);
+                rebase_(old_data);
             }
 
             /**
@@ -90,10 +94,15 @@ namespace std
 
             void swap(basic_stringbuf& rhs)
             {
+                auto old_data = str_.data();
+                auto rhs_old_data = rhs.str_.data();
+
                 std::swap(mode_, rhs.mode_);
                 std::swap(str_, rhs.str_);
 
                 basic_streambuf<char_type, traits_type>::swap(rhs);
+                rebase_(rhs_old_data);
+                rhs.rebase_(old_data);
             }
 
             /**
@@ -250,6 +259,26 @@ namespace std
                 }
             }
 
+            /**
+             * Short strings live inside the string object, so
+             * after the string moves the buffer pointers need
+             * to be adjusted from its previous storage.
+             */
+            void rebase_(const char_type* old_data)
+            {
+                auto fix = [this, old_data](char_type*& ptr) {
+                    if (ptr)
+                        ptr = str_.begin() + (ptr - old_data);
+                };
+
+                fix(this->input_begin_);
+                fix(this->input_next_);
+                fix(this->input_end_);
+                fix(this->output_begin_);
+                fix(this->output_next_);
+                fix(this->output_end_);
+            }
+
             bool ensure_free_space_(size_t n = 1)
             {
                 str_.ensure_free_space_(n);
@@ -29,6 +29,7 @@
 #ifndef LIBCPP_BITS_NUMERIC
 #define LIBCPP_BITS_NUMERIC
 
+#include <iterator>
 #include <utility>
 
 namespace std
@@ -87,6 +88,72 @@ namespace std
         return res;
     }
 
+    /**
+     * C++17, reduce:
+     * Note: The sequential versions apply the operation
+     *       in order, the parallel versions in <execution>
+     *       rely on it being associative and commutative.
+     */
+
+    template<class InputIterator, class T, class BinaryOperation>
+    T reduce(InputIterator first, InputIterator last, T init,
+             BinaryOperation op)
+    {
+        return accumulate(first, last, init, op);
+    }
+
+    template<class InputIterator, class T>
+    T reduce(InputIterator first, InputIterator last, T init)
+    {
+        return accumulate(first, last, init);
+    }
+
+    template<class InputIterator>
+    typename iterator_traits<InputIterator>::value_type
+    reduce(InputIterator first, InputIterator last)
+    {
+        return accumulate(
+            first, last,
+            typename iterator_traits<InputIterator>::value_type{}
+        );
+    }
+
+    /**
+     * C++17, transform reduce:
+     */
+
+    template<class InputIterator1, class InputIterator2, class T,
+             class BinaryOperation1, class BinaryOperation2>
+    T transform_reduce(InputIterator1 first1, InputIterator1 last1,
+                       InputIterator2 first2, T init,
+                       BinaryOperation1 op1, BinaryOperation2 op2)
+    {
+        auto res{init};
+        while (first1 != last1)
+            res = op1(res, op2(*first1++, *first2++));
+
+        return res;
+    }
+
+    template<class InputIterator1, class InputIterator2, class T>
+    T transform_reduce(InputIterator1 first1, InputIterator1 last1,
+                       InputIterator2 first2, T init)
+    {
+        return inner_product(first1, last1, first2, init);
+    }
+
+    template<class InputIterator, class T,
+             class BinaryOperation, class UnaryOperation>
+    T transform_reduce(InputIterator first, InputIterator last, T init,
+                       BinaryOperation bop, UnaryOperation uop)
+    {
+        auto res{init};
+        while (first != last)
+            res = bop(res, uop(*first++));
+
+        return res;
+    }
+
     /**
      * 26.7.4, partial sum:
      */
@@ -470,7 +470,8 @@ namespace std
             { /* DUMMY BODY */ }
 
             explicit basic_string(const allocator_type& alloc)
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
                 /**
                  * Postconditions:
@@ -478,29 +479,27 @@ namespace std
                  *  size() = 0
                  *  capacity() = unspecified
                  */
-                data_ = allocator_.allocate(default_capacity_);
-                capacity_ = default_capacity_;
+                ensure_null_terminator_();
             }
 
             basic_string(const basic_string& other)
-                : data_{}, size_{other.size_}, capacity_{other.capacity_},
+                : data_{local_}, size_{}, capacity_{local_capacity_},
                   allocator_{other.allocator_}
             {
-                init_(other.data(), size_);
+                init_(other.data(), other.size_);
             }
 
             basic_string(basic_string&& other)
-                : data_{other.data_}, size_{other.size_},
-                  capacity_{other.capacity_}, allocator_{move(other.allocator_)}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{move(other.allocator_)}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                move_from_(other);
             }
 
             basic_string(const basic_string& other, size_type pos, size_type n = npos,
                          const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
                 // TODO: if pos < other.size() throw out_of_range.
                 auto len = min(n, other.size() - pos);
@@ -508,40 +507,36 @@ namespace std
             }
 
             basic_string(const value_type* str, size_type n, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
-                init_(str, size_);
+                init_(str, n);
             }
 
             basic_string(const value_type* str, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
                 init_(str, traits_type::length(str));
             }
 
             basic_string(size_type n, value_type c, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
-                data_ = allocator_.allocate(capacity_);
-                for (size_type i = 0; i < size_; ++i)
-                    traits_type::assign(data_[i], c);
-                ensure_null_terminator_();
+                init_(n, c);
             }
 
             template<class InputIterator>
             basic_string(InputIterator first, InputIterator last,
                          const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
                 if constexpr (is_integral<InputIterator>::value)
                 { // Required by the standard.
-                    size_ = static_cast<size_type>(first);
-                    capacity_ = size_;
-                    data_ = allocator_.allocate(capacity_);
-
-                    for (size_type i = 0; i < size_; ++i)
-                        traits_type::assign(data_[i], static_cast<value_type>(last));
-                    ensure_null_terminator_();
+                    init_(static_cast<size_type>(first),
+                          static_cast<value_type>(last));
                 }
                 else
                 {
@@ -555,31 +550,28 @@ namespace std
             { /* DUMMY BODY */ }
 
             basic_string(const basic_string& other, const allocator_type& alloc)
-                : data_{}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
-                init_(other.data(), size_);
+                init_(other.data(), other.size_);
             }
 
             basic_string(basic_string&& other, const allocator_type& alloc)
-                : data_{other.data_}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                move_from_(other);
             }
 
             ~basic_string()
             {
-                allocator_.deallocate(data_, capacity_);
+                deallocate_();
             }
 
             basic_string& operator=(const basic_string& other)
             {
                 if (this != &other)
-                {
-                    basic_string tmp{other};
-                    swap(tmp);
-                }
+                    assign(other.data(), other.size());
 
                 return *this;
             }
@@ -589,30 +581,27 @@ namespace std
                          allocator_traits<allocator_type>::is_always_equal::value)
             {
                 if (this != &other)
-                    swap(other);
+                {
+                    deallocate_();
+                    move_from_(other);
+                }
 
                 return *this;
             }
 
             basic_string& operator=(const value_type* other)
             {
-                *this = basic_string{other};
-
-                return *this;
+                return assign(other);
             }
 
             basic_string& operator=(value_type c)
             {
-                *this = basic_string{1, c};
-
-                return *this;
+                return assign(1, c);
             }
 
             basic_string& operator=(initializer_list<value_type> init)
             {
-                *this = basic_string{init};
-
-                return *this;
+                return assign(init.begin(), init.size());
             }
 
             /**
@@ -704,9 +693,9 @@ namespace std
                 // TODO: if new_size > max_size() throw length_error.
                 if (new_size > size_)
                 {
-                    ensure_free_space_(new_size - size_ + 1);
+                    ensure_free_space_(new_size - size_);
                     for (size_type i = size_; i < new_size; ++i)
-                        traits_type::assign(data_[i], i);
+                        traits_type::assign(data_[i], c);
                 }
 
                 size_ = new_size;
@@ -736,13 +725,31 @@ namespace std
 
             void shrink_to_fit()
             {
-                if (size_ != capacity_)
-                    resize_with_copy_(size_, capacity_);
+                if (is_local_() || size_ + 1 == capacity_)
+                    return;
+
+                if (size_ + 1 <= local_capacity_)
+                {
+                    // Move back to the in-object buffer.
+                    traits_type::copy(local_, data_, size_ + 1);
+                    allocator_.deallocate(data_, capacity_);
+                    data_ = local_;
+                    capacity_ = local_capacity_;
+                }
+                else
+                {
+                    auto new_data = allocator_.allocate(size_ + 1);
+                    traits_type::copy(new_data, data_, size_ + 1);
+                    allocator_.deallocate(data_, capacity_);
+                    data_ = new_data;
+                    capacity_ = size_ + 1;
+                }
             }
 
             void clear() noexcept
             {
                 size_ = 0;
+                ensure_null_terminator_();
             }
 
             bool empty() const noexcept
@@ -856,7 +863,13 @@ namespace std
 
             basic_string& append(size_type n, value_type c)
             {
-                return append(basic_string(n, c));
+                ensure_free_space_(n);
+                for (size_type i = 0; i < n; ++i)
+                    traits_type::assign(data_[size_ + i], c);
+                size_ += n;
+                ensure_null_terminator_();
+
+                return *this;
             }
 
             template<class InputIterator>
@@ -884,9 +897,7 @@ namespace std
 
             basic_string& assign(basic_string&& str)
             {
-                swap(str);
-
-                return *this;
+                return *this = move(str);
             }
 
             basic_string& assign(const basic_string& str, size_type pos,
@@ -895,7 +906,6 @@ namespace std
                 if (pos < str.size())
                 {
                     auto len = min(n, str.size() - pos);
-                    ensure_free_space_(len);
 
                     return assign(str.data() + pos, len);
                 }
@@ -907,8 +917,16 @@ namespace std
             basic_string& assign(const value_type* str, size_type n)
             {
                 // TODO: if (n > max_size()) throw length_error.
-                resize_without_copy_(n);
-                traits_type::copy(begin(), str, n);
+                if (n + 1 <= capacity_)
+                {
+                    // Source may overlap with our own buffer.
+                    traits_type::move(data_, str, n);
+                }
+                else
+                {
+                    resize_without_copy_(n);
+                    traits_type::copy(data_, str, n);
+                }
                 size_ = n;
                 ensure_null_terminator_();
 
@@ -922,7 +940,14 @@ namespace std
 
             basic_string& assign(size_type n, value_type c)
             {
-                return assign(basic_string(n, c));
+                if (n + 1 > capacity_)
+                    resize_without_copy_(n);
+                for (size_type i = 0; i < n; ++i)
+                    traits_type::assign(data_[i], c);
+                size_ = n;
+                ensure_null_terminator_();
+
+                return *this;
             }
 
             template<class InputIterator>
@@ -1081,9 +1106,23 @@ namespace std
                 // TODO: throw out_of_range if pos > size()
                 // TODO: if size() - len > max_size() - n2 throw length_error
                 auto len = min(n1, size_ - pos);
+                auto new_size = size_ - len + n2;
+
+                if (new_size + 1 <= capacity_ &&
+                    (str + n2 <= data_ || str >= data_ + capacity_))
+                {
+                    // Fits in place and the source is not our own buffer.
+                    traits_type::move(data_ + pos + n2, data_ + pos + len,
+                                      size_ - pos - len);
+                    traits_type::copy(data_ + pos, str, n2);
+                    size_ = new_size;
+                    ensure_null_terminator_();
+
+                    return *this;
+                }
 
                 basic_string tmp{};
-                tmp.resize_without_copy_(size_ - len + n2);
+                tmp.resize_without_copy_(new_size);
 
                 // Prefix.
                 copy_(begin(), begin() + pos, tmp.begin());
@@ -1094,7 +1133,8 @@ namespace std
                 // Suffix.
                 copy_(begin() + pos + len, end(), tmp.begin() + pos + n2);
 
-                tmp.size_ = size_ - len + n2;
+                tmp.size_ = new_size;
+                tmp.ensure_null_terminator_();
                 swap(tmp);
                 return *this;
             }
@@ -1160,9 +1200,18 @@ namespace std
                 noexcept(allocator_traits<allocator_type>::propagate_on_container_swap::value ||
                          allocator_traits<allocator_type>::is_always_equal::value)
             {
-                std::swap(data_, other.data_);
-                std::swap(size_, other.size_);
-                std::swap(capacity_, other.capacity_);
+                if (!is_local_() && !other.is_local_())
+                {
+                    std::swap(data_, other.data_);
+                    std::swap(size_, other.size_);
+                    std::swap(capacity_, other.capacity_);
+                    return;
+                }
+
+                // In-object buffers cannot be swapped by swapping pointers.
+                basic_string tmp{std::move(other)};
+                other.move_from_(*this);
+                move_from_(tmp);
             }
 
             /**
@@ -1476,35 +1525,83 @@ namespace std
             }
 
         private:
+            /**
+             * Short strings (including the null terminator) are
+             * stored in the object itself, so that default
+             * construction, moves and most temporaries do not
+             * need to touch the allocator.
+             */
+            static constexpr size_type local_capacity_{
+                16 / sizeof(value_type) > 1 ? 16 / sizeof(value_type) : 2
+            };
+
             value_type* data_;
             size_type size_;
             size_type capacity_;
             allocator_type allocator_;
+            value_type local_[local_capacity_];
 
             template<class C, class T, class A>
             friend class basic_stringbuf;
 
+            bool is_local_() const noexcept
+            {
+                return data_ == local_;
+            }
+
+            void deallocate_()
+            {
+                if (!is_local_())
+                    allocator_.deallocate(data_, capacity_);
+            }
+
             /**
-             * Arbitrary value, standard just requires
-             * data() to have some capacity.
-             * (Well, we could've done data_ = &data_ and
-             * set capacity to 0, but that would be too cryptic.)
+             * Takes over contents of other, leaving it empty.
+             * Our previous buffer (if any) must have already
+             * been released.
              */
-            static constexpr size_type default_capacity_{4};
+            void move_from_(basic_string& other) noexcept
+            {
+                if (other.is_local_())
+                {
+                    data_ = local_;
+                    capacity_ = local_capacity_;
+                    traits_type::copy(local_, other.local_, other.size_ + 1);
+                }
+                else
+                {
+                    data_ = other.data_;
+                    capacity_ = other.capacity_;
+                }
+                size_ = other.size_;
+
+                other.data_ = other.local_;
+                other.capacity_ = local_capacity_;
+                other.size_ = 0;
+                other.ensure_null_terminator_();
+            }
 
             void init_(const value_type* str, size_type size)
             {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+                if (size + 1 > capacity_)
+                    resize_without_copy_(size);
 
                 size_ = size;
-                capacity_ = size + 1;
-
-                data_ = allocator_.allocate(capacity_);
                 traits_type::copy(data_, str, size);
                 ensure_null_terminator_();
             }
 
+            void init_(size_type n, value_type c)
+            {
+                if (n + 1 > capacity_)
+                    resize_without_copy_(n);
+
+                size_ = n;
+                for (size_type i = 0; i < size_; ++i)
+                    traits_type::assign(data_[i], c);
+                ensure_null_terminator_();
+            }
+
             size_type next_capacity_(size_type hint = 0) const noexcept
             {
                 if (hint != 0)
@@ -1524,32 +1621,38 @@ namespace std
                     resize_with_copy_(size_, max(size_ + 1 + n, next_capacity_()));
             }
 
-            void resize_without_copy_(size_type capacity)
+            /**
+             * Makes room for size characters (and the null
+             * terminator), discarding current contents.
+             */
+            void resize_without_copy_(size_type size)
             {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+                if (size + 1 > capacity_)
+                {
+                    deallocate_();
+
+                    data_ = allocator_.allocate(size + 1);
+                    capacity_ = size + 1;
+                }
 
-                data_ = allocator_.allocate(capacity);
                 size_ = 0;
-                capacity_ = capacity;
                 ensure_null_terminator_();
             }
 
             void resize_with_copy_(size_type size, size_type capacity)
             {
-                if(capacity_ == 0 || capacity_ < capacity)
+                if (capacity_ < capacity)
                 {
                     auto new_data = allocator_.allocate(capacity);
 
                     auto to_copy = min(size, size_);
-                    traits_type::move(new_data, data_, to_copy);
-
-                    std::swap(data_, new_data);
+                    traits_type::copy(new_data, data_, to_copy);
 
-                    allocator_.deallocate(new_data, capacity_);
+                    deallocate_();
+                    data_ = new_data;
+                    capacity_ = capacity;
                 }
 
-                capacity_ = capacity;
                 size_ = size;
                 ensure_null_terminator_();
             }
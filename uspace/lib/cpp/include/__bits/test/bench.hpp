@@ -0,0 +1,53 @@
+#ifndef LIBCPP_BITS_TEST_BENCH
+#define LIBCPP_BITS_TEST_BENCH
+
+#include <__bits/test/test.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+namespace std::test
+{
+    /**
+     * Base for micro-benchmarks. These run as part of
+     * the test set, so that they are exercised (and their
+     * results checked) along with the tests, but they also
+     * report how long each measured loop took.
+     */
+    class bench_suite: public test_suite
+    {
+        protected:
+            template<class Func>
+            void measure(const char* bname, unsigned int iterations,
+                         Func&& func)
+            {
+                auto start = std::chrono::steady_clock::now();
+
+                for (unsigned int i = 0; i < iterations; ++i)
+                    func(i);
+
+                auto end = std::chrono::steady_clock::now();
+                auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(
+                    end - start
+                ).count();
+
+                if (report_)
+                    std::printf("[%s][%s] ... %lld us (%u iterations)\n",
+                                name(), bname, static_cast<long long>(usecs),
+                                iterations);
+            }
+
+            /**
+             * Prevents the compiler from optimizing
+             * away the benchmarked operations.
+             */
+            void consume(uintptr_t value)
+            {
+                sink_ = sink_ + value;
+            }
+
+            volatile uintptr_t sink_{};
+    };
+}
+
+#endif
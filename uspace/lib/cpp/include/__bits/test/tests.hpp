@@ -29,6 +29,7 @@
 #ifndef LIBCPP_BITS_TEST_TESTS
 #define LIBCPP_BITS_TEST_TESTS
 
+#include <__bits/test/bench.hpp>
 #include <__bits/test/test.hpp>
 #include <cstdio>
 #include <vector>
@@ -125,6 +126,19 @@ namespace std::test
             void test_compare();
     };
 
+    class string_bench: public bench_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void bench_construction();
+            void bench_copy_and_move();
+            void bench_append();
+            void bench_concatenation();
+    };
+
     class bitset_test: public test_suite
     {
         public:
@@ -219,6 +233,59 @@ namespace std::test
             void test_multi();
     };
 
+    class execution_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void test_for_each();
+            void test_transform();
+            void test_count();
+            void test_sort();
+            void test_reduce();
+            void test_nested();
+    };
+
+    class parallel_bench: public bench_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void bench_algorithms(size_t);
+    };
+
+    class flat_hash_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void test_constructors_and_assignment();
+            void test_emplace_insert();
+            void test_erase();
+            void test_growth();
+            void test_set();
+    };
+
+    class hash_table_bench: public bench_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            template<class Map>
+            void bench_map(const char*, const char*, const char*, Map&);
+
+            void bench_int_keys();
+            void bench_string_keys();
+    };
+
     class numeric_test: public test_suite
     {
         public:
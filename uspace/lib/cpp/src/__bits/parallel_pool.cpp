@@ -0,0 +1,339 @@
+#include <__bits/execution/pool.hpp>
+#include <thread>
+
+namespace std::aux
+{
+    parallel_pool& parallel_pool::get()
+    {
+        /**
+         * Note: The workers never exit, so the
+         *       pool is intentionally never destroyed.
+         */
+        static parallel_pool* instance = new parallel_pool{};
+
+        return *instance;
+    }
+
+    parallel_pool::parallel_pool()
+        : workers_{}, worker_count_{}, active_{}, sleep_mtx_{},
+          sleep_cv_{}, idle_cv_{}, sleepers_{}
+    {
+        threading::mutex::init(sleep_mtx_);
+        threading::condvar::init(sleep_cv_);
+        threading::condvar::init(idle_cv_);
+
+        /**
+         * The fibril calling a parallel algorithm helps
+         * to execute its tasks, so we need one worker
+         * less than there are processors.
+         */
+        size_t cpus = thread::hardware_concurrency();
+        size_t count = cpus > 1 ? cpus - 1 : 0;
+
+        if (count > 0)
+            ::helenos::fibril_enable_multithreaded();
+
+        /**
+         * The last deque does not belong to any worker,
+         * fibrils that are not workers push their tasks
+         * there.
+         */
+        workers_ = new worker[count + 1];
+        for (size_t i = 0; i <= count; ++i)
+        {
+            auto& w = workers_[i];
+
+            threading::mutex::init(w.mtx);
+            w.head = nullptr;
+            w.tail = nullptr;
+            w.fid = thread_t{};
+            w.idx = i;
+            w.pool = this;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            workers_[i].fid = threading::thread::create(worker_main_, workers_[i]);
+            if (workers_[i].fid == thread_t{})
+                break;
+
+            ++worker_count_;
+        }
+
+        active_ = worker_count_;
+
+        /**
+         * Start the workers only after all of them
+         * have their fibril ids assigned, since they
+         * use them to find their deques.
+         */
+        for (size_t i = 0; i < worker_count_; ++i)
+            threading::thread::start(workers_[i].fid);
+    }
+
+    void parallel_pool::set_concurrency(size_t n) noexcept
+    {
+        threading::mutex::lock(sleep_mtx_);
+
+        if (n == 0 || n > worker_count_ + 1)
+            active_ = worker_count_;
+        else
+            active_ = n - 1;
+
+        threading::mutex::unlock(sleep_mtx_);
+
+        /**
+         * Workers sleeping on sleep_cv_ that are now over
+         * the limit move to idle_cv_, so that they do not
+         * swallow wakeups meant for the active ones.
+         */
+        threading::condvar::broadcast(idle_cv_);
+        threading::condvar::broadcast(sleep_cv_);
+    }
+
+    void parallel_pool::push_(parallel_task* task)
+    {
+        auto w = current_worker_();
+        auto& dq = w ? *w : shared_();
+
+        threading::mutex::lock(dq.mtx);
+        task->next_ = nullptr;
+        task->prev_ = dq.tail;
+        if (dq.tail)
+            dq.tail->next_ = task;
+        else
+            dq.head = task;
+        dq.tail = task;
+        threading::mutex::unlock(dq.mtx);
+
+        threading::mutex::lock(sleep_mtx_);
+        if (sleepers_ > 0)
+            threading::condvar::signal(sleep_cv_);
+        threading::mutex::unlock(sleep_mtx_);
+    }
+
+    parallel_task* parallel_pool::take_(worker* w)
+    {
+        // Our own tasks first, the newest is likely still in cache.
+        auto task = pop_back_(w ? *w : shared_());
+        if (task)
+            return task;
+
+        // Then steal the oldest tasks of others.
+        auto active = active_;
+        auto start = w ? w->idx + 1 : 0;
+        for (size_t i = 0; i < active; ++i)
+        {
+            auto victim = (start + i) % active;
+            if (w && victim == w->idx)
+                continue;
+
+            task = pop_front_(workers_[victim]);
+            if (task)
+                return task;
+        }
+
+        if (w)
+            task = pop_front_(shared_());
+
+        return task;
+    }
+
+    parallel_task* parallel_pool::pop_back_(worker& dq)
+    {
+        threading::mutex::lock(dq.mtx);
+
+        auto task = dq.tail;
+        if (task)
+        {
+            dq.tail = task->prev_;
+            if (dq.tail)
+                dq.tail->next_ = nullptr;
+            else
+                dq.head = nullptr;
+        }
+
+        threading::mutex::unlock(dq.mtx);
+
+        return task;
+    }
+
+    parallel_task* parallel_pool::pop_front_(worker& dq)
+    {
+        threading::mutex::lock(dq.mtx);
+
+        auto task = dq.head;
+        if (task)
+        {
+            dq.head = task->next_;
+            if (dq.head)
+                dq.head->prev_ = nullptr;
+            else
+                dq.tail = nullptr;
+        }
+
+        threading::mutex::unlock(dq.mtx);
+
+        return task;
+    }
+
+    bool parallel_pool::has_work_()
+    {
+        for (size_t i = 0; i <= worker_count_; ++i)
+        {
+            if (i >= active_ && i < worker_count_)
+                continue;
+
+            auto& dq = workers_[i];
+
+            threading::mutex::lock(dq.mtx);
+            bool work = dq.head != nullptr;
+            threading::mutex::unlock(dq.mtx);
+
+            if (work)
+                return true;
+        }
+
+        return false;
+    }
+
+    parallel_pool::worker* parallel_pool::current_worker_()
+    {
+        auto fid = threading::thread::this_thread();
+        for (size_t i = 0; i < worker_count_; ++i)
+        {
+            if (workers_[i].fid == fid)
+                return &workers_[i];
+        }
+
+        return nullptr;
+    }
+
+    parallel_pool::worker& parallel_pool::shared_()
+    {
+        return workers_[worker_count_];
+    }
+
+    void parallel_pool::sleep_(worker& w)
+    {
+        threading::mutex::lock(sleep_mtx_);
+
+        while (w.idx >= active_)
+            threading::condvar::wait(idle_cv_, sleep_mtx_);
+
+        /**
+         * Pushers signal under sleep_mtx_ after the task
+         * is in a deque, so checking the deques here under
+         * the same mutex cannot miss a wakeup.
+         */
+        if (!has_work_())
+        {
+            ++sleepers_;
+            threading::condvar::wait(sleep_cv_, sleep_mtx_);
+            --sleepers_;
+        }
+
+        // The limit might have changed while we slept.
+        while (w.idx >= active_)
+            threading::condvar::wait(idle_cv_, sleep_mtx_);
+
+        threading::mutex::unlock(sleep_mtx_);
+    }
+
+    void parallel_pool::execute_(parallel_task* task)
+    {
+        auto group = task->group_;
+
+        task->execute();
+        delete task;
+
+        group->finished_();
+    }
+
+    int parallel_pool::worker_main_(void* arg)
+    {
+        auto& w = *static_cast<worker*>(arg);
+        auto& pool = *w.pool;
+
+        while (true)
+        {
+            /**
+             * Workers over the concurrency limit must not
+             * take any tasks, sleep_ parks them until they
+             * are allowed to.
+             */
+            parallel_task* task = nullptr;
+            if (w.idx < pool.active_)
+                task = pool.take_(&w);
+
+            if (task)
+                execute_(task);
+            else
+                pool.sleep_(w);
+        }
+
+        return 0;
+    }
+
+    task_group::task_group()
+        : pool_{parallel_pool::get()}, mtx_{}, cv_{}, pending_{}
+    {
+        threading::mutex::init(mtx_);
+        threading::condvar::init(cv_);
+    }
+
+    task_group::~task_group()
+    {
+        wait();
+    }
+
+    void task_group::wait()
+    {
+        auto w = pool_.current_worker_();
+
+        while (true)
+        {
+            threading::mutex::lock(mtx_);
+            auto pending = pending_;
+            threading::mutex::unlock(mtx_);
+
+            if (pending == 0)
+                return;
+
+            auto task = pool_.take_(w);
+            if (task)
+            {
+                parallel_pool::execute_(task);
+                continue;
+            }
+
+            /**
+             * Nothing left to take, so all our remaining
+             * tasks are already being executed by someone.
+             */
+            threading::mutex::lock(mtx_);
+            while (pending_ != 0)
+                threading::condvar::wait(cv_, mtx_);
+            threading::mutex::unlock(mtx_);
+        }
+    }
+
+    void task_group::add_(parallel_task* task)
+    {
+        task->group_ = this;
+
+        threading::mutex::lock(mtx_);
+        ++pending_;
+        threading::mutex::unlock(mtx_);
+
+        pool_.push_(task);
+    }
+
+    void task_group::finished_()
+    {
+        threading::mutex::lock(mtx_);
+        if (--pending_ == 0)
+            threading::condvar::broadcast(cv_);
+        threading::mutex::unlock(mtx_);
+    }
+}
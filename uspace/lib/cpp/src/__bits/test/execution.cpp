@@ -0,0 +1,252 @@
+#include <__bits/test/tests.hpp>
+#include <algorithm>
+#include <execution>
+#include <list>
+#include <numeric>
+#include <vector>
+
+namespace std::test
+{
+    namespace
+    {
+        /**
+         * Deterministic pseudo-random data, so that
+         * failures are reproducible.
+         */
+        std::vector<unsigned int> random_data(size_t n, unsigned int modulo)
+        {
+            std::vector<unsigned int> res(n);
+
+            unsigned int x{12345u};
+            for (auto& val: res)
+            {
+                x = x * 1103515245u + 12345u;
+                val = (x >> 8) % modulo;
+            }
+
+            return res;
+        }
+    }
+
+    bool execution_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_for_each();
+        test_transform();
+        test_count();
+        test_sort();
+        test_reduce();
+        test_nested();
+
+        return end();
+    }
+
+    const char* execution_test::name()
+    {
+        return "execution";
+    }
+
+    void execution_test::test_for_each()
+    {
+        std::vector<int> data1(10000);
+        std::fill(data1.begin(), data1.end(), 1);
+
+        std::for_each(
+            std::execution::par, data1.begin(), data1.end(),
+            [](auto& x){ x *= 2; }
+        );
+        test_eq(
+            "for_each par",
+            std::count(data1.begin(), data1.end(), 2),
+            10000
+        );
+
+        std::for_each(
+            std::execution::seq, data1.begin(), data1.end(),
+            [](auto& x){ x += 1; }
+        );
+        test_eq(
+            "for_each seq",
+            std::count(data1.begin(), data1.end(), 3),
+            10000
+        );
+
+        std::list<int> data2{1, 2, 3};
+        std::for_each(
+            std::execution::par_unseq, data2.begin(), data2.end(),
+            [](auto& x){ x *= 10; }
+        );
+        auto check1 = {10, 20, 30};
+        test_eq(
+            "for_each non random access",
+            check1.begin(), check1.end(),
+            data2.begin(), data2.end()
+        );
+
+        std::vector<int> data3(10000);
+        std::fill(std::execution::par, data3.begin(), data3.end(), 7);
+        test_eq(
+            "fill par",
+            std::count(data3.begin(), data3.end(), 7),
+            10000
+        );
+
+        std::vector<int> data4{};
+        std::fill(std::execution::par, data4.begin(), data4.end(), 7);
+        test_eq("fill empty", data4.empty(), true);
+    }
+
+    void execution_test::test_transform()
+    {
+        std::vector<int> data1(10000);
+        std::iota(data1.begin(), data1.end(), 0);
+        std::vector<int> res1(10000);
+
+        auto it1 = std::transform(
+            std::execution::par, data1.begin(), data1.end(),
+            res1.begin(), [](auto x){ return x * 3; }
+        );
+        test_eq("transform par return", it1, res1.end());
+
+        bool ok{true};
+        for (int i = 0; i < 10000; ++i)
+            ok = ok && res1[i] == i * 3;
+        test_eq("transform par", ok, true);
+
+        auto it2 = std::transform(
+            std::execution::par, data1.begin(), data1.end(),
+            res1.begin(), res1.begin(), [](auto x, auto y){ return y - x; }
+        );
+        test_eq("transform binary par return", it2, res1.end());
+
+        ok = true;
+        for (int i = 0; i < 10000; ++i)
+            ok = ok && res1[i] == i * 2;
+        test_eq("transform binary par", ok, true);
+    }
+
+    void execution_test::test_count()
+    {
+        auto data1 = random_data(20000, 10);
+
+        auto res1 = std::count(std::execution::par, data1.begin(), data1.end(), 3u);
+        auto check1 = std::count(data1.begin(), data1.end(), 3u);
+        test_eq("count par", res1, check1);
+
+        auto res2 = std::count_if(
+            std::execution::par, data1.begin(), data1.end(),
+            [](auto x){ return x % 2 == 0; }
+        );
+        auto check2 = std::count_if(
+            data1.begin(), data1.end(),
+            [](auto x){ return x % 2 == 0; }
+        );
+        test_eq("count_if par", res2, check2);
+    }
+
+    void execution_test::test_sort()
+    {
+        auto data1 = random_data(50000, 1000000);
+        auto check1 = data1;
+        std::sort(check1.begin(), check1.end());
+
+        std::sort(std::execution::par, data1.begin(), data1.end());
+        test_eq("sort par", data1 == check1, true);
+
+        // Already sorted input.
+        std::sort(std::execution::par, data1.begin(), data1.end());
+        test_eq("sort par sorted", data1 == check1, true);
+
+        // Reversed input.
+        std::reverse(data1.begin(), data1.end());
+        std::sort(std::execution::par, data1.begin(), data1.end());
+        test_eq("sort par reversed", data1 == check1, true);
+
+        // Mostly equal elements.
+        auto data2 = random_data(50000, 3);
+        auto check2 = data2;
+        std::sort(check2.begin(), check2.end());
+        std::sort(std::execution::par, data2.begin(), data2.end());
+        test_eq("sort par duplicates", data2 == check2, true);
+
+        auto data3 = random_data(50000, 1000);
+        std::sort(
+            std::execution::par_unseq, data3.begin(), data3.end(),
+            [](auto x, auto y){ return x > y; }
+        );
+        test_eq(
+            "sort par comparator",
+            std::is_sorted(data3.rbegin(), data3.rend()), true
+        );
+
+        std::vector<unsigned int> data4{3, 1, 2};
+        std::sort(std::execution::par, data4.begin(), data4.end());
+        auto check4 = {1u, 2u, 3u};
+        test_eq(
+            "sort par small",
+            check4.begin(), check4.end(),
+            data4.begin(), data4.end()
+        );
+    }
+
+    void execution_test::test_reduce()
+    {
+        std::vector<unsigned long long> data1(100000);
+        std::iota(data1.begin(), data1.end(), 1ull);
+
+        auto res1 = std::reduce(std::execution::par, data1.begin(), data1.end());
+        test_eq("reduce par", res1, 5000050000ull);
+
+        auto res2 = std::reduce(
+            std::execution::par, data1.begin(), data1.end(), 10ull
+        );
+        test_eq("reduce par init", res2, 5000050010ull);
+
+        auto res3 = std::reduce(
+            std::execution::par, data1.begin(), data1.end(), 0ull,
+            [](auto x, auto y){ return x > y ? x : y; }
+        );
+        test_eq("reduce par op", res3, 100000ull);
+
+        auto res4 = std::reduce(
+            std::execution::par, data1.begin(), data1.begin(), 42ull
+        );
+        test_eq("reduce par empty", res4, 42ull);
+
+        auto res5 = std::transform_reduce(
+            std::execution::par, data1.begin(), data1.end(),
+            data1.begin(), 0ull
+        );
+        auto check5 = std::inner_product(
+            data1.begin(), data1.end(), data1.begin(), 0ull
+        );
+        test_eq("transform_reduce par binary", res5, check5);
+
+        auto res6 = std::transform_reduce(
+            std::execution::par, data1.begin(), data1.end(), 0ull,
+            std::plus<>{}, [](auto x){ return x % 2; }
+        );
+        test_eq("transform_reduce par unary", res6, 50000ull);
+    }
+
+    void execution_test::test_nested()
+    {
+        std::vector<std::vector<unsigned int>> data1(8);
+        for (auto& vec: data1)
+            vec = random_data(10000, 100000);
+
+        std::for_each(
+            std::execution::par, data1.begin(), data1.end(),
+            [](auto& vec){
+                std::sort(std::execution::par, vec.begin(), vec.end());
+            }
+        );
+
+        bool ok{true};
+        for (const auto& vec: data1)
+            ok = ok && std::is_sorted(vec.begin(), vec.end());
+        test_eq("nested par", ok, true);
+    }
+}
@@ -0,0 +1,218 @@
+#include <__bits/test/tests.hpp>
+#include <flat_hash_map>
+#include <flat_hash_set>
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+namespace std::test
+{
+    bool flat_hash_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_constructors_and_assignment();
+        test_emplace_insert();
+        test_erase();
+        test_growth();
+        test_set();
+
+        return end();
+    }
+
+    const char* flat_hash_test::name()
+    {
+        return "flat_hash";
+    }
+
+    void flat_hash_test::test_constructors_and_assignment()
+    {
+        auto check1 = {1, 2, 3, 4, 5, 6, 7};
+        auto src1 = {
+            std::pair<const int, int>{3, 3},
+            std::pair<const int, int>{1, 1},
+            std::pair<const int, int>{5, 5},
+            std::pair<const int, int>{2, 2},
+            std::pair<const int, int>{7, 7},
+            std::pair<const int, int>{6, 6},
+            std::pair<const int, int>{4, 4}
+        };
+
+        std::hel::flat_hash_map<int, int> m1{src1};
+        test_contains(
+            "initializer list initialization",
+            check1.begin(), check1.end(), m1
+        );
+        test_eq("size", m1.size(), 7U);
+
+        std::hel::flat_hash_map<int, int> m2{src1.begin(), src1.end()};
+        test_contains(
+            "iterator range initialization",
+            check1.begin(), check1.end(), m2
+        );
+
+        std::hel::flat_hash_map<int, int> m3{m1};
+        test_contains(
+            "copy initialization",
+            check1.begin(), check1.end(), m3
+        );
+
+        std::hel::flat_hash_map<int, int> m4{std::move(m1)};
+        test_contains(
+            "move initialization",
+            check1.begin(), check1.end(), m4
+        );
+        test_eq("move initialization - origin empty", m1.size(), 0U);
+        test_eq("empty", m1.empty(), true);
+
+        m1 = m4;
+        test_contains(
+            "copy assignment",
+            check1.begin(), check1.end(), m1
+        );
+        test_eq("equality", m1 == m4, true);
+
+        m4 = std::move(m1);
+        test_contains(
+            "move assignment",
+            check1.begin(), check1.end(), m4
+        );
+        test_eq("move assignment - origin empty", m1.size(), 0U);
+
+        size_t count{};
+        for (const auto& val: m4)
+        {
+            if (val.first == val.second)
+                ++count;
+        }
+        test_eq("iteration", count, 7U);
+    }
+
+    void flat_hash_test::test_emplace_insert()
+    {
+        std::hel::flat_hash_map<int, int> map1{};
+
+        auto res1 = map1.emplace(1, 2);
+        test_eq("first emplace succession", res1.second, true);
+        test_eq("first emplace equivalence pt1", res1.first->first, 1);
+        test_eq("first emplace equivalence pt2", res1.first->second, 2);
+
+        auto res2 = map1.emplace(1, 3);
+        test_eq("second emplace failure", res2.second, false);
+        test_eq("second emplace keeps value", res2.first->second, 2);
+
+        auto res3 = map1.try_emplace(2, 4);
+        test_eq("try_emplace succession", res3.second, true);
+        test_eq("try_emplace value", map1.at(2), 4);
+
+        auto res4 = map1.insert_or_assign(2, 5);
+        test_eq("insert_or_assign existing", res4.second, false);
+        test_eq("insert_or_assign value", map1[2], 5);
+
+        auto res5 = map1.insert(std::pair<const int, int>{3, 6});
+        test_eq("insert succession", res5.second, true);
+        test_eq("insert size", map1.size(), 3U);
+        test_eq("operator[] new key", map1[4], 0);
+        test_eq("operator[] size", map1.size(), 4U);
+
+        std::hel::flat_hash_map<std::string, std::size_t> map2{};
+        for (auto word: {"a", "b", "a", "a", "c", "b"})
+            ++map2[word];
+        test_eq("string keys pt1", map2["a"], 3U);
+        test_eq("string keys pt2", map2["b"], 2U);
+        test_eq("string keys pt3", map2.count("c"), 1U);
+        test_eq("string keys pt4", map2.count("d"), 0U);
+    }
+
+    void flat_hash_test::test_erase()
+    {
+        std::hel::flat_hash_map<int, int> map1{};
+        for (int i = 0; i < 100; ++i)
+            map1.emplace(i, i * 2);
+
+        test_eq("erase by key", map1.erase(10), 1U);
+        test_eq("erase missing key", map1.erase(10), 0U);
+        test_eq("erase size", map1.size(), 99U);
+        test_eq("find erased", map1.find(10) == map1.end(), true);
+        test_eq("find after erase", map1.find(11)->second, 22);
+
+        // Erase all odd keys while iterating.
+        auto it = map1.begin();
+        while (it != map1.end())
+        {
+            if (it->first % 2 == 1)
+                it = map1.erase(it);
+            else
+                ++it;
+        }
+        test_eq("erase while iterating size", map1.size(), 49U);
+
+        bool ok{true};
+        for (int i = 0; i < 100; ++i)
+            ok = ok && (map1.count(i) == (i % 2 == 0 && i != 10 ? 1U : 0U));
+        test_eq("erase while iterating contents", ok, true);
+
+        // Reuse deleted slots.
+        for (int i = 0; i < 1000; ++i)
+        {
+            map1.emplace(1001, i);
+            map1.erase(1001);
+        }
+        test_eq("insert after erase size", map1.size(), 49U);
+        test_eq("deleted slots do not grow table", map1.bucket_count() <= 128U, true);
+
+        map1.clear();
+        test_eq("clear", map1.empty(), true);
+        test_eq("find after clear", map1.find(0) == map1.end(), true);
+    }
+
+    void flat_hash_test::test_growth()
+    {
+        std::hel::flat_hash_map<unsigned int, unsigned int> map1{};
+
+        for (unsigned int i = 0; i < 10000; ++i)
+            map1[i * 64] = i;
+        test_eq("growth size", map1.size(), 10000U);
+        test_eq("growth load factor", map1.load_factor() <= map1.max_load_factor(), true);
+
+        bool ok{true};
+        for (unsigned int i = 0; i < 10000; ++i)
+        {
+            auto it = map1.find(i * 64);
+            ok = ok && it != map1.end() && it->second == i;
+            ok = ok && map1.find(i * 64 + 1) == map1.end();
+        }
+        test_eq("growth lookup", ok, true);
+
+        std::hel::flat_hash_map<int, int> map2{};
+        map2.reserve(1000);
+        auto buckets = map2.bucket_count();
+        for (int i = 0; i < 1000; ++i)
+            map2.emplace(i, i);
+        test_eq("reserve", map2.bucket_count(), buckets);
+    }
+
+    void flat_hash_test::test_set()
+    {
+        auto check1 = {1, 2, 3, 4, 5};
+        std::hel::flat_hash_set<int> set1{3, 1, 5, 2, 4, 3, 1};
+
+        test_contains(
+            "set initializer list",
+            check1.begin(), check1.end(), set1
+        );
+        test_eq("set size", set1.size(), 5U);
+
+        auto res1 = set1.insert(6);
+        test_eq("set insert", res1.second, true);
+        auto res2 = set1.insert(6);
+        test_eq("set insert duplicate", res2.second, false);
+
+        test_eq("set erase", set1.erase(1), 1U);
+        test_eq("set contains", set1.contains(1), false);
+
+        std::hel::flat_hash_set<int> set2{2, 3, 4, 5, 6};
+        test_eq("set equality", set1 == set2, true);
+    }
+}
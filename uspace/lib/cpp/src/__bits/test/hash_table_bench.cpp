@@ -0,0 +1,143 @@
+#include <__bits/adt/hash_table_bucket.hpp>
+#include <__bits/adt/list_node.hpp>
+#include <__bits/test/tests.hpp>
+#include <flat_hash_map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace std::test
+{
+    namespace
+    {
+        constexpr unsigned int bench_elements{20'000u};
+
+        /**
+         * Spread the keys so that neither table benefits
+         * from them being consecutive.
+         */
+        unsigned int bench_key(unsigned int i)
+        {
+            return i * 2654435761u;
+        }
+
+        /**
+         * Approximate memory footprint of unordered_map,
+         * which does not tell us its allocations.
+         */
+        template<class Map>
+        size_t unordered_memory_usage(const Map& map)
+        {
+            using value_type = typename Map::value_type;
+
+            return map.bucket_count() *
+                   sizeof(aux::hash_table_bucket<value_type, size_t>) +
+                   map.size() * sizeof(aux::list_node<value_type>);
+        }
+    }
+
+    bool hash_table_bench::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        bench_int_keys();
+        bench_string_keys();
+
+        return end();
+    }
+
+    const char* hash_table_bench::name()
+    {
+        return "hash_table_bench";
+    }
+
+    template<class Map>
+    void hash_table_bench::bench_map(const char* insert_name,
+                                     const char* find_name,
+                                     const char* miss_name,
+                                     Map& map)
+    {
+        measure(insert_name, bench_elements, [&](unsigned int i) {
+            map.emplace(bench_key(i), i);
+        });
+
+        size_t found{};
+        measure(find_name, bench_elements, [&](unsigned int i) {
+            auto it = map.find(bench_key(i));
+            if (it != map.end() && it->second == i)
+                ++found;
+        });
+        test_eq(find_name, found, static_cast<size_t>(bench_elements));
+
+        found = 0;
+        measure(miss_name, bench_elements, [&](unsigned int i) {
+            if (map.find(bench_key(i + bench_elements)) != map.end())
+                ++found;
+        });
+        test_eq(miss_name, found, 0U);
+    }
+
+    void hash_table_bench::bench_int_keys()
+    {
+        std::unordered_map<unsigned int, unsigned int> umap{};
+        std::hel::flat_hash_map<unsigned int, unsigned int> fmap{};
+
+        bench_map(
+            "unordered_map insert", "unordered_map find",
+            "unordered_map find missing", umap
+        );
+        bench_map(
+            "flat_hash_map insert", "flat_hash_map find",
+            "flat_hash_map find missing", fmap
+        );
+
+        test_eq("same size", umap.size(), fmap.size());
+
+        if (report_)
+        {
+            std::printf("[%s][unordered_map memory] ... %zu bytes\n",
+                        name(), unordered_memory_usage(umap));
+            std::printf("[%s][flat_hash_map memory] ... %zu bytes\n",
+                        name(), fmap.memory_usage());
+        }
+    }
+
+    void hash_table_bench::bench_string_keys()
+    {
+        std::vector<std::string> keys{};
+        keys.reserve(bench_elements / 10);
+        for (unsigned int i = 0; i < bench_elements / 10; ++i)
+        {
+            std::string key{"key"};
+            for (unsigned int n = bench_key(i); n != 0; n /= 10)
+                key.push_back('0' + n % 10);
+            keys.push_back(std::move(key));
+        }
+
+        std::unordered_map<std::string, unsigned int> umap{};
+        std::hel::flat_hash_map<std::string, unsigned int> fmap{};
+
+        measure("unordered_map string insert", bench_elements / 10, [&](unsigned int i) {
+            umap.emplace(keys[i], i);
+        });
+        measure("flat_hash_map string insert", bench_elements / 10, [&](unsigned int i) {
+            fmap.emplace(keys[i], i);
+        });
+
+        size_t ufound{};
+        measure("unordered_map string find", bench_elements / 10, [&](unsigned int i) {
+            if (umap.find(keys[i]) != umap.end())
+                ++ufound;
+        });
+
+        size_t ffound{};
+        measure("flat_hash_map string find", bench_elements / 10, [&](unsigned int i) {
+            if (fmap.find(keys[i]) != fmap.end())
+                ++ffound;
+        });
+
+        test_eq("string find", ufound, ffound);
+        test_eq("string find count", ffound, static_cast<size_t>(bench_elements / 10));
+    }
+}
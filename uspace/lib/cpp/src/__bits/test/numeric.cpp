@@ -150,6 +150,33 @@ namespace std::test
             "iota", check5.begin(), check5.end(),
             result.begin(), result.end()
         );
+
+        auto res10 = std::reduce(data1.begin(), data1.end());
+        test_eq("reduce pt1", res10, 15);
+
+        auto res11 = std::reduce(
+            data1.begin(), data1.end(), 2,
+            [](const auto& lhs, const auto& rhs){
+                return lhs * rhs;
+            }
+        );
+        test_eq("reduce pt2", res11, 240);
+
+        auto res12 = std::transform_reduce(
+            data2.begin(), data2.end(), data3.begin(), 0
+        );
+        test_eq("transform_reduce pt1", res12, 79);
+
+        auto res13 = std::transform_reduce(
+            data1.begin(), data1.end(), 0,
+            [](const auto& lhs, const auto& rhs){
+                return lhs + rhs;
+            },
+            [](const auto& x){
+                return x * x;
+            }
+        );
+        test_eq("transform_reduce pt2", res13, 55);
     }
 
     void numeric_test::test_complex()
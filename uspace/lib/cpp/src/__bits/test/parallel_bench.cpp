@@ -0,0 +1,102 @@
+#include <__bits/execution/pool.hpp>
+#include <__bits/test/tests.hpp>
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <vector>
+
+namespace std::test
+{
+    namespace
+    {
+        constexpr size_t bench_elements{200'000};
+        constexpr unsigned int bench_rounds{5};
+    }
+
+    bool parallel_bench::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        auto& pool = aux::parallel_pool::get();
+        auto max = pool.workers() + 1;
+
+        if (report_)
+            std::printf("[%s][fibrils] ... %zu\n", name(), max);
+
+        /**
+         * Run everything with one fibril first (which is
+         * what the sequential algorithms get), then double
+         * the number of fibrils up to the whole pool.
+         */
+        for (size_t n = 1; ; n = std::min(n * 2, max))
+        {
+            pool.set_concurrency(n);
+            bench_algorithms(n);
+
+            if (n == max)
+                break;
+        }
+        pool.set_concurrency(0);
+
+        return end();
+    }
+
+    const char* parallel_bench::name()
+    {
+        return "parallel_bench";
+    }
+
+    void parallel_bench::bench_algorithms(size_t fibrils)
+    {
+        char bname[64];
+
+        std::vector<unsigned int> data(bench_elements);
+        std::vector<unsigned int> result(bench_elements);
+
+        std::snprintf(bname, sizeof(bname), "sort %zu", fibrils);
+        measure(bname, bench_rounds, [&](unsigned int round) {
+            unsigned int x{round + 1};
+            for (auto& val: data)
+            {
+                x = x * 1103515245u + 12345u;
+                val = x >> 8;
+            }
+
+            std::sort(std::execution::par, data.begin(), data.end());
+        });
+        test_eq(bname, std::is_sorted(data.begin(), data.end()), true);
+
+        std::snprintf(bname, sizeof(bname), "transform %zu", fibrils);
+        measure(bname, bench_rounds, [&](unsigned int) {
+            std::transform(
+                std::execution::par, data.begin(), data.end(), result.begin(),
+                [](auto x){
+                    for (int i = 0; i < 16; ++i)
+                        x = x * 2654435761u + 1u;
+
+                    return x;
+                }
+            );
+        });
+        consume(result.back());
+
+        std::snprintf(bname, sizeof(bname), "reduce %zu", fibrils);
+        unsigned long long sum{};
+        measure(bname, bench_rounds, [&](unsigned int) {
+            sum += std::reduce(
+                std::execution::par, data.begin(), data.end(), 0ull
+            );
+        });
+        consume(static_cast<uintptr_t>(sum));
+
+        std::snprintf(bname, sizeof(bname), "for_each %zu", fibrils);
+        measure(bname, bench_rounds, [&](unsigned int) {
+            std::for_each(
+                std::execution::par, result.begin(), result.end(),
+                [](auto& x){ x = x / 3 + x % 7; }
+            );
+        });
+        consume(result.front());
+    }
+}
@@ -0,0 +1,162 @@
+#include <__bits/test/tests.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace std::test
+{
+    namespace
+    {
+        constexpr unsigned int bench_iterations{100'000u};
+
+        const char* short_literal{"short string"};
+        const char* long_literal{
+            "a string that is far too long to fit in the object itself"
+        };
+    }
+
+    bool string_bench::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        bench_construction();
+        bench_copy_and_move();
+        bench_append();
+        bench_concatenation();
+
+        return end();
+    }
+
+    const char* string_bench::name()
+    {
+        return "string_bench";
+    }
+
+    void string_bench::bench_construction()
+    {
+        size_t total{};
+
+        measure("default construction", bench_iterations, [&](unsigned int) {
+            std::string str{};
+            total += str.size();
+            consume(reinterpret_cast<uintptr_t>(str.c_str()));
+        });
+        test_eq("default construction result", total, 0ul);
+
+        total = 0;
+        measure("short construction", bench_iterations, [&](unsigned int) {
+            std::string str{short_literal};
+            total += str.size();
+        });
+        test_eq(
+            "short construction result",
+            total, bench_iterations * std::string{short_literal}.size()
+        );
+
+        total = 0;
+        measure("long construction", bench_iterations, [&](unsigned int) {
+            std::string str{long_literal};
+            total += str.size();
+        });
+        test_eq(
+            "long construction result",
+            total, bench_iterations * std::string{long_literal}.size()
+        );
+    }
+
+    void string_bench::bench_copy_and_move()
+    {
+        std::string short_str{short_literal};
+        std::string long_str{long_literal};
+        size_t total{};
+
+        measure("short copy", bench_iterations, [&](unsigned int) {
+            std::string str{short_str};
+            total += str.size();
+        });
+        test_eq(
+            "short copy result",
+            total, bench_iterations * short_str.size()
+        );
+
+        total = 0;
+        measure("short move", bench_iterations, [&](unsigned int) {
+            std::string str{std::move(short_str)};
+            total += str.size();
+            short_str = std::move(str);
+        });
+        test_eq(
+            "short move result",
+            total, bench_iterations * short_str.size()
+        );
+
+        total = 0;
+        measure("long move", bench_iterations, [&](unsigned int) {
+            std::string str{std::move(long_str)};
+            total += str.size();
+            long_str = std::move(str);
+        });
+        test_eq(
+            "long move result",
+            total, bench_iterations * long_str.size()
+        );
+
+        total = 0;
+        measure("short swap", bench_iterations, [&](unsigned int) {
+            std::string str{};
+            str.swap(short_str);
+            total += str.size();
+            short_str.swap(str);
+        });
+        test_eq(
+            "short swap result",
+            total, bench_iterations * short_str.size()
+        );
+    }
+
+    void string_bench::bench_append()
+    {
+        std::string str{};
+        size_t total{};
+
+        measure("push_back", bench_iterations / 100, [&](unsigned int) {
+            str.clear();
+            for (unsigned int i = 0; i < 100; ++i)
+                str.push_back('a' + i % 26);
+            total += str.size();
+        });
+        test_eq("push_back result", total, bench_iterations);
+
+        total = 0;
+        measure("append to new", bench_iterations / 10, [&](unsigned int) {
+            std::string str{};
+            for (unsigned int i = 0; i < 10; ++i)
+                str.append("abc");
+            total += str.size();
+        });
+        test_eq("append to new result", total, bench_iterations * 3);
+    }
+
+    void string_bench::bench_concatenation()
+    {
+        std::string prefix{"key"};
+        size_t total{};
+
+        measure("short concatenation", bench_iterations, [&](unsigned int i) {
+            std::string str = prefix + "_" + std::string(1, '0' + i % 10);
+            total += str.size();
+        });
+        test_eq("short concatenation result", total, bench_iterations * 5);
+
+        std::vector<std::string> strings{};
+        strings.reserve(bench_iterations / 10);
+        measure("vector of short strings", bench_iterations / 10, [&](unsigned int) {
+            strings.push_back(short_literal);
+        });
+        test_eq(
+            "vector of short strings result",
+            strings.size(), static_cast<size_t>(bench_iterations / 10)
+        );
+    }
+}
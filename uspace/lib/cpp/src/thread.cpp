@@ -32,6 +32,8 @@
 #include <thread>
 #include <utility>
 
+#include <sysinfo.h>
+
 namespace std
 {
     thread::thread() noexcept
@@ -119,9 +121,23 @@ namespace std
 
     unsigned thread::hardware_concurrency() noexcept
     {
-        // TODO:
-        __unimplemented();
-        return 0;
+        size_t size{};
+        auto cpus = static_cast<stats_cpu_t*>(
+            ::helenos::sysinfo_get_data("system.cpus", &size)
+        );
+        if (!cpus)
+            return 0;
+
+        unsigned count{};
+        for (size_t i = 0; i < size / sizeof(stats_cpu_t); ++i)
+        {
+            if (cpus[i].active)
+                ++count;
+        }
+
+        std::free(cpus);
+
+        return count;
     }
 
     void swap(thread& x, thread& y) noexcept
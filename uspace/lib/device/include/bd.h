@@ -40,8 +40,24 @@
 
 typedef struct {
 	async_sess_t *sess;
+	/** Buffer shared with the server or @c NULL */
+	void *shbuf;
+	/** Size of the shared buffer */
+	size_t shbuf_size;
 } bd_t;
 
+/** Request submitted to a block device.
+ *
+ * Storage is provided by the caller and must remain valid until
+ * the request has been waited for.
+ */
+typedef struct {
+	/** Request ID */
+	aid_t aid;
+	/** Answer to the request */
+	ipc_call_t answer;
+} bd_req_t;
+
 extern errno_t bd_open(async_sess_t *, bd_t **);
 extern void bd_close(bd_t *);
 extern errno_t bd_read_blocks(bd_t *, aoff64_t, size_t, void *, size_t);
@@ -50,6 +66,12 @@ extern errno_t bd_write_blocks(bd_t *, aoff64_t, size_t, const void *, size_t);
 extern errno_t bd_sync_cache(bd_t *, aoff64_t, size_t);
 extern errno_t bd_get_block_size(bd_t *, size_t *);
 extern errno_t bd_get_num_blocks(bd_t *, aoff64_t *);
+extern errno_t bd_share_buf(bd_t *, void *, size_t);
+extern errno_t bd_submit_read(bd_t *, aoff64_t, size_t, size_t, size_t,
+    bd_req_t *);
+extern errno_t bd_submit_write(bd_t *, aoff64_t, size_t, size_t, size_t,
+    bd_req_t *);
+extern errno_t bd_req_wait(bd_req_t *);
 
 #endif
 
@@ -47,6 +47,13 @@ typedef struct bd_ops bd_ops_t;
 typedef struct {
 	bd_ops_t *ops;
 	void *sarg;
+	/**
+	 * Maximum number of submitted requests executed concurrently
+	 * per client session. With the default of 1 requests are
+	 * executed one at a time by the connection fibril. Other
+	 * requests are never executed concurrently with submitted ones.
+	 */
+	unsigned int qdepth;
 } bd_srvs_t;
 
 /** Server structure (per client session) */
@@ -54,6 +61,16 @@ typedef struct {
 	bd_srvs_t *srvs;
 	async_sess_t *client_sess;
 	void *carg;
+	/** Buffer shared by the client or @c NULL */
+	void *shbuf;
+	/** Size of the shared buffer */
+	size_t shbuf_size;
+	/** Synchronizes @c queued */
+	fibril_mutex_t lock;
+	/** Signalled when a submitted request finishes */
+	fibril_condvar_t cv;
+	/** Number of submitted requests being executed */
+	unsigned int queued;
 } bd_srv_t;
 
 struct bd_ops {
@@ -65,6 +82,10 @@ struct bd_ops {
 	errno_t (*write_blocks)(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
 	errno_t (*get_block_size)(bd_srv_t *, size_t *);
 	errno_t (*get_num_blocks)(bd_srv_t *, aoff64_t *);
+	errno_t (*share_buf)(bd_srv_t *);
+	errno_t (*fwd_begin)(bd_srv_t *, aoff64_t, size_t, async_exch_t **,
+	    aoff64_t *);
+	void (*fwd_end)(bd_srv_t *, async_exch_t *);
 };
 
 extern void bd_srvs_init(bd_srvs_t *);
@@ -43,7 +43,10 @@ typedef enum {
 	BD_READ_BLOCKS,
 	BD_SYNC_CACHE,
 	BD_WRITE_BLOCKS,
-	BD_READ_TOC
+	BD_READ_TOC,
+	BD_SHARE_BUF,
+	BD_SUBMIT_READ,
+	BD_SUBMIT_WRITE
 } bd_request_t;
 
 #endif
@@ -34,6 +34,7 @@
  * @brief Block device client interface
  */
 
+#include <as.h>
 #include <async.h>
 #include <assert.h>
 #include <bd.h>
@@ -195,6 +196,128 @@ errno_t bd_get_num_blocks(bd_t *bd, aoff64_t *rnb)
 	return EOK;
 }
 
+/** Share a buffer with the block device server.
+ *
+ * The buffer is used for data of requests submitted with bd_submit_read()
+ * and bd_submit_write(), the server accesses it directly instead of
+ * copying the data. Only one buffer can be shared per connection.
+ *
+ * @param bd Block device
+ * @param buf Buffer, must be the start of an address space area
+ * @param size Size of the buffer
+ * @return EOK on success or an error code
+ */
+errno_t bd_share_buf(bd_t *bd, void *buf, size_t size)
+{
+	if (bd->shbuf != NULL)
+		return EBUSY;
+
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, BD_SHARE_BUF, &answer);
+	errno_t rc = async_share_out_start(exch, buf,
+	    AS_AREA_READ | AS_AREA_WRITE);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+
+	if (retval != EOK)
+		return retval;
+
+	bd->shbuf = buf;
+	bd->shbuf_size = size;
+	return EOK;
+}
+
+/** Submit request to the block device.
+ *
+ * @param bd Block device
+ * @param method BD_SUBMIT_READ or BD_SUBMIT_WRITE
+ * @param ba Address of first block
+ * @param cnt Number of blocks
+ * @param offs Offset of data in the shared buffer
+ * @param size Size of data
+ * @param req Place to store the request
+ * @return EOK on success or an error code
+ */
+static errno_t bd_submit(bd_t *bd, sysarg_t method, aoff64_t ba, size_t cnt,
+    size_t offs, size_t size, bd_req_t *req)
+{
+	if (bd->shbuf == NULL)
+		return EINVAL;
+
+	if (offs > bd->shbuf_size || size > bd->shbuf_size - offs)
+		return EINVAL;
+
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+	req->aid = async_send_5(exch, method, LOWER32(ba), UPPER32(ba), cnt,
+	    offs, size, &req->answer);
+	async_exchange_end(exch);
+
+	if (req->aid == 0)
+		return ENOMEM;
+
+	return EOK;
+}
+
+/** Submit read request.
+ *
+ * The request is executed asynchronously, several requests can be
+ * outstanding at the same time. Data is read into the shared buffer.
+ * Wait for completion of the request using bd_req_wait().
+ *
+ * @param bd Block device
+ * @param ba Address of first block
+ * @param cnt Number of blocks
+ * @param offs Offset of data in the shared buffer
+ * @param size Size of data
+ * @param req Place to store the request
+ * @return EOK on success or an error code
+ */
+errno_t bd_submit_read(bd_t *bd, aoff64_t ba, size_t cnt, size_t offs,
+    size_t size, bd_req_t *req)
+{
+	return bd_submit(bd, BD_SUBMIT_READ, ba, cnt, offs, size, req);
+}
+
+/** Submit write request.
+ *
+ * Like bd_submit_read(), data is written from the shared buffer.
+ *
+ * @param bd Block device
+ * @param ba Address of first block
+ * @param cnt Number of blocks
+ * @param offs Offset of data in the shared buffer
+ * @param size Size of data
+ * @param req Place to store the request
+ * @return EOK on success or an error code
+ */
+errno_t bd_submit_write(bd_t *bd, aoff64_t ba, size_t cnt, size_t offs,
+    size_t size, bd_req_t *req)
+{
+	return bd_submit(bd, BD_SUBMIT_WRITE, ba, cnt, offs, size, req);
+}
+
+/** Wait for completion of a submitted request.
+ *
+ * @param req Request
+ * @return Result of the request
+ */
+errno_t bd_req_wait(bd_req_t *req)
+{
+	errno_t retval;
+
+	async_wait_for(req->aid, &retval);
+	return retval;
+}
+
 static void bd_cb_conn(ipc_call_t *icall, void *arg)
 {
 	bd_t *bd = (bd_t *)arg;
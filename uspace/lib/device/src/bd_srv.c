@@ -33,7 +33,9 @@
  * @file
  * @brief Block device server stub
  */
+#include <as.h>
 #include <errno.h>
+#include <fibril.h>
 #include <ipc/bd.h>
 #include <macros.h>
 #include <stdlib.h>
@@ -42,6 +44,65 @@
 
 #include <bd_srv.h>
 
+/** Try forwarding a read or write request to another block device.
+ *
+ * A service that only translates block addresses (e.g. a partition)
+ * can provide the fwd_begin operation returning an exchange with the
+ * underlying device and the translated address. The data transfer
+ * call of the client is then forwarded to that device, so the data
+ * does not pass through this server.
+ *
+ * @param srv Server structure
+ * @param call Call with BD_READ_BLOCKS or BD_WRITE_BLOCKS request
+ * @return @c true if the request has been handled
+ */
+static bool bd_fwd_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	sysarg_t method = ipc_get_imethod(call);
+	aoff64_t ba;
+	aoff64_t fba;
+	size_t cnt;
+	async_exch_t *exch;
+	ipc_call_t dcall;
+	errno_t rc;
+
+	if (srv->srvs->ops->fwd_begin == NULL)
+		return false;
+
+	ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
+	cnt = ipc_get_arg3(call);
+
+	rc = srv->srvs->ops->fwd_begin(srv, ba, cnt, &exch, &fba);
+	if (rc == ENOTSUP)
+		return false;
+
+	if (rc != EOK) {
+		/* Reject the data transfer call as well */
+		if (method == BD_READ_BLOCKS) {
+			if (async_data_read_receive(&dcall, NULL))
+				async_answer_0(&dcall, rc);
+		} else {
+			if (async_data_write_receive(&dcall, NULL))
+				async_answer_0(&dcall, rc);
+		}
+
+		async_answer_0(call, rc);
+		return true;
+	}
+
+	if (method == BD_READ_BLOCKS) {
+		rc = async_data_read_forward_3_0(exch, BD_READ_BLOCKS,
+		    LOWER32(fba), UPPER32(fba), cnt);
+	} else {
+		rc = async_data_write_forward_3_0(exch, BD_WRITE_BLOCKS,
+		    LOWER32(fba), UPPER32(fba), cnt);
+	}
+
+	srv->srvs->ops->fwd_end(srv, exch);
+	async_answer_0(call, rc);
+	return true;
+}
+
 static void bd_read_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 {
 	aoff64_t ba;
@@ -50,6 +111,9 @@ static void bd_read_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	size_t size;
 	errno_t rc;
 
+	if (bd_fwd_srv(srv, call))
+		return;
+
 	ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
 	cnt = ipc_get_arg3(call);
 
@@ -156,6 +220,9 @@ static void bd_write_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	size_t size;
 	errno_t rc;
 
+	if (bd_fwd_srv(srv, call))
+		return;
+
 	ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
 	cnt = ipc_get_arg3(call);
 
@@ -175,6 +242,173 @@ static void bd_write_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	async_answer_0(call, rc);
 }
 
+static void bd_share_buf_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	ipc_call_t scall;
+	size_t size;
+	unsigned int flags;
+	void *buf;
+	errno_t rc;
+
+	if (!async_share_out_receive(&scall, &size, &flags)) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (srv->shbuf != NULL ||
+	    (flags & (AS_AREA_READ | AS_AREA_WRITE)) !=
+	    (AS_AREA_READ | AS_AREA_WRITE)) {
+		async_answer_0(&scall, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	rc = async_share_out_finalize(&scall, &buf);
+	if (rc != EOK) {
+		async_answer_0(call, rc);
+		return;
+	}
+
+	srv->shbuf = buf;
+	srv->shbuf_size = size;
+
+	if (srv->srvs->ops->share_buf != NULL) {
+		rc = srv->srvs->ops->share_buf(srv);
+		if (rc != EOK) {
+			as_area_destroy(srv->shbuf);
+			srv->shbuf = NULL;
+			srv->shbuf_size = 0;
+		}
+	}
+
+	async_answer_0(call, rc);
+}
+
+/** Execute a submitted request.
+ *
+ * @param srv Server structure
+ * @param call Call with the request
+ */
+static void bd_submit_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	aoff64_t ba;
+	size_t cnt;
+	size_t offs;
+	size_t size;
+	void *buf;
+	errno_t rc;
+
+	ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
+	cnt = ipc_get_arg3(call);
+	offs = ipc_get_arg4(call);
+	size = ipc_get_arg5(call);
+
+	if (srv->shbuf == NULL || offs > srv->shbuf_size ||
+	    size > srv->shbuf_size - offs) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	buf = (char *) srv->shbuf + offs;
+
+	if (ipc_get_imethod(call) == BD_SUBMIT_READ) {
+		if (srv->srvs->ops->read_blocks == NULL) {
+			async_answer_0(call, ENOTSUP);
+			return;
+		}
+
+		rc = srv->srvs->ops->read_blocks(srv, ba, cnt, buf, size);
+	} else {
+		if (srv->srvs->ops->write_blocks == NULL) {
+			async_answer_0(call, ENOTSUP);
+			return;
+		}
+
+		rc = srv->srvs->ops->write_blocks(srv, ba, cnt, buf, size);
+	}
+
+	async_answer_0(call, rc);
+}
+
+/** Submitted request executed by its own fibril */
+typedef struct {
+	bd_srv_t *srv;
+	ipc_call_t call;
+} bd_submit_t;
+
+static errno_t bd_submit_fibril(void *arg)
+{
+	bd_submit_t *submit = (bd_submit_t *) arg;
+	bd_srv_t *srv = submit->srv;
+
+	bd_submit_srv(srv, &submit->call);
+	free(submit);
+
+	fibril_mutex_lock(&srv->lock);
+	--srv->queued;
+	fibril_condvar_broadcast(&srv->cv);
+	fibril_mutex_unlock(&srv->lock);
+
+	return EOK;
+}
+
+/** Dispatch a submitted request.
+ *
+ * If the service allows it, the request is executed by a new fibril
+ * so that the connection fibril can accept further requests. Otherwise,
+ * or when the queue is full, it is executed right away.
+ *
+ * @param srv Server structure
+ * @param call Call with the request
+ */
+static void bd_submit_dispatch(bd_srv_t *srv, ipc_call_t *call)
+{
+	bd_submit_t *submit;
+	fid_t fid;
+
+	fibril_mutex_lock(&srv->lock);
+	if (srv->queued + 1 >= srv->srvs->qdepth) {
+		fibril_mutex_unlock(&srv->lock);
+		bd_submit_srv(srv, call);
+		return;
+	}
+
+	submit = malloc(sizeof(bd_submit_t));
+	if (submit == NULL) {
+		fibril_mutex_unlock(&srv->lock);
+		bd_submit_srv(srv, call);
+		return;
+	}
+
+	submit->srv = srv;
+	submit->call = *call;
+
+	fid = fibril_create(bd_submit_fibril, submit);
+	if (fid == 0) {
+		fibril_mutex_unlock(&srv->lock);
+		free(submit);
+		bd_submit_srv(srv, call);
+		return;
+	}
+
+	++srv->queued;
+	fibril_mutex_unlock(&srv->lock);
+
+	fibril_add_ready(fid);
+}
+
+/** Wait until all submitted requests have finished.
+ *
+ * @param srv Server structure
+ */
+static void bd_submit_wait_all(bd_srv_t *srv)
+{
+	fibril_mutex_lock(&srv->lock);
+	while (srv->queued > 0)
+		fibril_condvar_wait(&srv->cv, &srv->lock);
+	fibril_mutex_unlock(&srv->lock);
+}
+
 static void bd_get_block_size_srv(bd_srv_t *srv, ipc_call_t *call)
 {
 	errno_t rc;
@@ -212,6 +446,8 @@ static bd_srv_t *bd_srv_create(bd_srvs_t *srvs)
 		return NULL;
 
 	srv->srvs = srvs;
+	fibril_mutex_initialize(&srv->lock);
+	fibril_condvar_initialize(&srv->cv);
 	return srv;
 }
 
@@ -219,6 +455,7 @@ void bd_srvs_init(bd_srvs_t *srvs)
 {
 	srvs->ops = NULL;
 	srvs->sarg = NULL;
+	srvs->qdepth = 1;
 }
 
 errno_t bd_conn(ipc_call_t *icall, bd_srvs_t *srvs)
@@ -254,6 +491,13 @@ errno_t bd_conn(ipc_call_t *icall, bd_srvs_t *srvs)
 			break;
 		}
 
+		/*
+		 * Only submitted requests are executed concurrently.
+		 * Other requests wait for them to finish.
+		 */
+		if (method != BD_SUBMIT_READ && method != BD_SUBMIT_WRITE)
+			bd_submit_wait_all(srv);
+
 		switch (method) {
 		case BD_READ_BLOCKS:
 			bd_read_blocks_srv(srv, &call);
@@ -273,12 +517,25 @@ errno_t bd_conn(ipc_call_t *icall, bd_srvs_t *srvs)
 		case BD_GET_NUM_BLOCKS:
 			bd_get_num_blocks_srv(srv, &call);
 			break;
+		case BD_SHARE_BUF:
+			bd_share_buf_srv(srv, &call);
+			break;
+		case BD_SUBMIT_READ:
+		case BD_SUBMIT_WRITE:
+			bd_submit_dispatch(srv, &call);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 		}
 	}
 
+	/* Wait for submitted requests to finish */
+	bd_submit_wait_all(srv);
+
 	rc = srvs->ops->close(srv);
+
+	if (srv->shbuf != NULL)
+		as_area_destroy(srv->shbuf);
 	free(srv);
 
 	return rc;
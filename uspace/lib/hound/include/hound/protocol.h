@@ -56,6 +56,31 @@ typedef enum {
 
 typedef async_sess_t hound_sess_t;
 
+/** Maximum length of a context name in stream statistics */
+#define HOUND_STATS_NAME_LEN 32
+
+/** Stream statistics */
+typedef struct {
+	/** Name of the owning context, truncated */
+	char name[HOUND_STATS_NAME_LEN];
+	/** Stream belongs to a recording context */
+	bool record;
+	/** Stream data format */
+	pcm_format_t format;
+	/** Size of the server side stream buffer */
+	size_t buffer_size;
+	/** Number of frames passed through the stream */
+	uint64_t frames;
+	/** Number of times the stream ran out of data while playing */
+	uint64_t underruns;
+	/** Number of times recorded data were dropped on full buffer */
+	uint64_t overruns;
+	/** Time the data currently spend in the stream buffer */
+	usec_t latency;
+	/** Maximum observed buffer latency */
+	usec_t latency_max;
+} hound_stream_stats_t;
+
 typedef struct {
 } *hound_context_id_t;
 
@@ -83,6 +108,9 @@ static inline errno_t hound_service_get_list_all(hound_sess_t *sess,
 	return hound_service_get_list(sess, ids, count, flags, NULL);
 }
 
+errno_t hound_service_get_stream_stats(hound_sess_t *sess,
+    hound_stream_stats_t **stats, size_t *count);
+
 errno_t hound_service_connect_source_sink(hound_sess_t *sess, const char *source,
     const char *sink);
 errno_t hound_service_disconnect_source_sink(hound_sess_t *sess, const char *source,
@@ -123,6 +151,8 @@ typedef struct hound_server_iface {
 	errno_t (*stream_data_write)(void *, void *, size_t);
 	/** Read data from the stream */
 	errno_t (*stream_data_read)(void *, void *, size_t);
+	/** Get statistics of all streams */
+	errno_t (*get_stream_stats)(void *, hound_stream_stats_t **, size_t *);
 	void *server;
 } hound_server_iface_t;
 
@@ -64,6 +64,8 @@ enum ipc_methods {
 	IPC_M_HOUND_STREAM_EXIT,
 	/** Wait until there is no data in the stream */
 	IPC_M_HOUND_STREAM_DRAIN,
+	/** Request statistics of all streams */
+	IPC_M_HOUND_GET_STREAM_STATS,
 };
 
 /** PCM format conversion helper structure */
@@ -239,6 +241,57 @@ errno_t hound_service_get_list(hound_sess_t *sess, char ***ids, size_t *count,
 	return ret;
 }
 
+/**
+ * Retrieve statistics of all streams.
+ * @param[in] sess Valid audio session.
+ * @param[out] stats Array of stream statistics, to be freed by the caller.
+ * @param[out] count Number of elements in the @p stats array.
+ * @return Error code.
+ */
+errno_t hound_service_get_stream_stats(hound_sess_t *sess,
+    hound_stream_stats_t **stats, size_t *count)
+{
+	assert(sess);
+	assert(stats);
+	assert(count);
+
+	async_exch_t *exch = async_exchange_begin(sess);
+	if (!exch)
+		return ENOMEM;
+
+	ipc_call_t res_call;
+	aid_t mid = async_send_0(exch, IPC_M_HOUND_GET_STREAM_STATS, &res_call);
+	errno_t ret = mid ? EOK : EPARTY;
+	if (ret == EOK)
+		async_wait_for(mid, &ret);
+
+	if (ret != EOK) {
+		async_exchange_end(exch);
+		return ret;
+	}
+
+	const size_t stats_count = ipc_get_arg1(&res_call);
+	hound_stream_stats_t *buf = NULL;
+	if (stats_count) {
+		buf = calloc(stats_count, sizeof(hound_stream_stats_t));
+		if (!buf)
+			ret = ENOMEM;
+		if (ret == EOK)
+			ret = async_data_read_start(exch, buf,
+			    stats_count * sizeof(hound_stream_stats_t));
+	}
+	async_exchange_end(exch);
+
+	if (ret != EOK) {
+		free(buf);
+		return ret;
+	}
+
+	*stats = buf;
+	*count = stats_count;
+	return EOK;
+}
+
 /**
  * Create a new connection between a source and a sink.
  * @param sess Valid audio session.
@@ -608,6 +661,32 @@ void hound_connection_handler(ipc_call_t *icall, void *arg)
 				}
 			}
 			break;
+		case IPC_M_HOUND_GET_STREAM_STATS:
+			/* check interface functions */
+			if (!server_iface || !server_iface->get_stream_stats) {
+				async_answer_0(&call, ENOTSUP);
+				break;
+			}
+
+			hound_stream_stats_t *stats = NULL;
+			size_t stats_count = 0;
+			ret = server_iface->get_stream_stats(server_iface->server,
+			    &stats, &stats_count);
+			if (ret != EOK)
+				stats_count = 0;
+			async_answer_1(&call, ret, stats_count);
+
+			/* Send statistics table */
+			if (stats_count > 0) {
+				ipc_call_t id;
+				if (async_data_read_receive(&id, NULL)) {
+					async_data_read_finalize(&id, stats,
+					    stats_count *
+					    sizeof(hound_stream_stats_t));
+				}
+			}
+			free(stats);
+			break;
 		case IPC_M_HOUND_STREAM_EXIT:
 		case IPC_M_HOUND_STREAM_DRAIN:
 			/* Stream exit/drain is only allowed in stream context */
@@ -0,0 +1,24 @@
+/** @addtogroup libinet
+ * @{
+ */
+/**
+ * @file Internet checksum
+ */
+
+#ifndef LIBINET_INET_CHECKSUM_H
+#define LIBINET_INET_CHECKSUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Initial value for inet_checksum_calc() */
+#define INET_CHECKSUM_INIT 0xffff
+
+extern uint16_t inet_checksum_calc(uint16_t, const void *, size_t);
+extern uint16_t inet_checksum_update16(uint16_t, uint16_t, uint16_t);
+extern uint16_t inet_checksum_update32(uint16_t, uint32_t, uint32_t);
+
+#endif
+
+/** @}
+ */
@@ -0,0 +1,66 @@
+/** @addtogroup libinet
+ * @{
+ */
+/**
+ * @file Longest prefix match table
+ */
+
+#ifndef LIBINET_INET_LPM_H
+#define LIBINET_INET_LPM_H
+
+#include <errno.h>
+#include <inet/addr.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Number of entries in the destination cache */
+#define INET_LPM_CACHE_SIZE 64
+
+struct inet_lpm_node;
+
+/** Destination cache entry */
+typedef struct {
+	/** Destination address */
+	inet_addr_t addr;
+	/** Lookup result */
+	void *value;
+	/** Entry is valid if this matches inet_lpm_t.gen */
+	uint32_t gen;
+} inet_lpm_cache_entry_t;
+
+/** Longest prefix match table.
+ *
+ * Maps IPv4 and IPv6 network prefixes to values.
+ */
+typedef struct {
+	/** Root of IPv4 trie */
+	struct inet_lpm_node *root4;
+	/** Root of IPv6 trie */
+	struct inet_lpm_node *root6;
+	/** Number of prefixes */
+	size_t count;
+	/** Generation, incremented on each change to invalidate cache */
+	uint32_t gen;
+	/** Destination cache */
+	inet_lpm_cache_entry_t cache[INET_LPM_CACHE_SIZE];
+} inet_lpm_t;
+
+/** Static initializer for an empty longest prefix match table */
+#define INET_LPM_INITIALIZER { .gen = 1 }
+
+/** Define and initialize an empty longest prefix match table */
+#define INET_LPM_INITIALIZE(name) \
+	inet_lpm_t name = INET_LPM_INITIALIZER
+
+extern void inet_lpm_initialize(inet_lpm_t *);
+extern void inet_lpm_finalize(inet_lpm_t *);
+extern errno_t inet_lpm_insert(inet_lpm_t *, const inet_naddr_t *, void *);
+extern errno_t inet_lpm_remove(inet_lpm_t *, const inet_naddr_t *);
+extern void *inet_lpm_find(inet_lpm_t *, const inet_naddr_t *);
+extern void *inet_lpm_lookup(inet_lpm_t *, const inet_addr_t *);
+extern void *inet_lpm_lookup_nocache(inet_lpm_t *, const inet_addr_t *);
+
+#endif
+
+/** @}
+ */
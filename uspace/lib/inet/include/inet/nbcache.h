@@ -0,0 +1,158 @@
+/** @addtogroup libinet
+ * @{
+ */
+/**
+ * @file Neighbour cache
+ */
+
+#ifndef LIBINET_INET_NBCACHE_H
+#define LIBINET_INET_NBCACHE_H
+
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <inet/addr.h>
+#include <inet/eth_addr.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/** Time a neighbour is considered reachable after confirmation */
+#define INET_NB_REACHABLE_TIME SEC2USEC(30)
+/** Time between solicitations */
+#define INET_NB_RETRANS_TIME SEC2USEC(1)
+/** Maximum number of solicitations before giving up */
+#define INET_NB_MAX_SOLICIT 3
+/** Recently used entries are refreshed this long before they go stale */
+#define INET_NB_REFRESH_LEAD SEC2USEC(5)
+/** Stale entries not used for this long are removed */
+#define INET_NB_GC_TIME SEC2USEC(600)
+/** Maximum number of packets queued on an incomplete entry */
+#define INET_NB_QUEUE_MAX 3
+/** Period of the aging timer */
+#define INET_NB_TICK MSEC2USEC(250)
+
+/** Neighbour cache entry state (after RFC 4861) */
+typedef enum {
+	/** Address resolution is in progress */
+	nbs_incomplete,
+	/** Neighbour was recently confirmed reachable */
+	nbs_reachable,
+	/** Reachability has not been confirmed recently */
+	nbs_stale,
+	/** Reachability is being confirmed */
+	nbs_probe
+} inet_nb_state_t;
+
+/** Neighbour cache operations */
+typedef struct {
+	/** Send solicitation (ARP request or neighbour solicitation).
+	 *
+	 * @param link Link passed to inet_nbcache_resolve()
+	 * @param src Source protocol address
+	 * @param target Target protocol address
+	 * @param dest Destination link-layer address or @c NULL
+	 *             to broadcast (multicast) the solicitation
+	 */
+	errno_t (*solicit)(void *link, const inet_addr_t *src,
+	    const inet_addr_t *target, const eth_addr_t *dest);
+	/** Transmit queued packet once the address is resolved */
+	void (*xmit)(void *pkt, const eth_addr_t *mac);
+	/** Free queued packet which cannot be delivered */
+	void (*discard)(void *pkt);
+} inet_nbcache_ops_t;
+
+/** Neighbour cache counters */
+typedef struct {
+	/** Number of entries */
+	uint64_t entries;
+	/** Lookups satisfied from the cache */
+	uint64_t hits;
+	/** Lookups which started address resolution */
+	uint64_t misses;
+	/** Solicitations sent to resolve an address */
+	uint64_t solicits;
+	/** Solicitations sent to refresh a known address */
+	uint64_t probes;
+	/** Confirmations received */
+	uint64_t confirms;
+	/** Resolutions or refreshes which timed out */
+	uint64_t failures;
+	/** Packets queued on incomplete entries */
+	uint64_t queued;
+	/** Queued packets dropped */
+	uint64_t dropped;
+	/** Entries evicted because the cache was full */
+	uint64_t evictions;
+	/** Stale entries removed */
+	uint64_t expirations;
+} inet_nbcache_stats_t;
+
+/** Neighbour cache entry */
+typedef struct {
+	/** Link to inet_nbcache_t.entries */
+	ht_link_t lentries;
+	/** Link to inet_nbcache_t.lru */
+	link_t llru;
+	/** Protocol address */
+	inet_addr_t addr;
+	/** Link-layer address (not valid if incomplete) */
+	eth_addr_t mac;
+	/** State */
+	inet_nb_state_t state;
+	/** Link for sending solicitations */
+	void *link;
+	/** Source address for sending solicitations */
+	inet_addr_t src;
+	/** Time of last confirmation */
+	usec_t confirmed;
+	/** Time entry was last used to send a packet */
+	usec_t used;
+	/** Time of next solicitation (incomplete, probe) */
+	usec_t next;
+	/** Number of solicitations sent in the current state */
+	unsigned solicits;
+	/** Queued packets (of inet_nb_qpkt_t) */
+	list_t queue;
+	/** Number of queued packets */
+	size_t queued;
+} inet_nb_entry_t;
+
+/** Neighbour cache */
+typedef struct {
+	/** Protects the cache */
+	fibril_mutex_t lock;
+	/** Entries hashed by protocol address */
+	hash_table_t entries;
+	/** Entries, least recently used first */
+	list_t lru;
+	/** Maximum number of entries */
+	size_t max_entries;
+	/** Operations */
+	inet_nbcache_ops_t *ops;
+	/** Aging timer or @c NULL */
+	fibril_timer_t *timer;
+	/** Counters */
+	inet_nbcache_stats_t stats;
+} inet_nbcache_t;
+
+extern errno_t inet_nbcache_create(size_t, inet_nbcache_ops_t *,
+    inet_nbcache_t **);
+extern void inet_nbcache_destroy(inet_nbcache_t *);
+extern errno_t inet_nbcache_start(inet_nbcache_t *);
+extern errno_t inet_nbcache_resolve(inet_nbcache_t *, void *,
+    const inet_addr_t *, const inet_addr_t *, usec_t, eth_addr_t *);
+extern errno_t inet_nbcache_enqueue(inet_nbcache_t *, const inet_addr_t *,
+    void *, eth_addr_t *);
+extern errno_t inet_nbcache_update(inet_nbcache_t *, const inet_addr_t *,
+    const eth_addr_t *, usec_t);
+extern errno_t inet_nbcache_remove(inet_nbcache_t *, const inet_addr_t *);
+extern void inet_nbcache_tick(inet_nbcache_t *, usec_t);
+extern void inet_nbcache_get_stats(inet_nbcache_t *, inet_nbcache_stats_t *);
+extern usec_t inet_nbcache_now(void);
+
+#endif
+
+/** @}
+ */
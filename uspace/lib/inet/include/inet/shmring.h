@@ -0,0 +1,90 @@
+/** @addtogroup libinet
+ * @{
+ */
+/**
+ * @file Shared memory packet ring
+ */
+
+#ifndef LIBINET_INET_SHMRING_H
+#define LIBINET_INET_SHMRING_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Magic number identifying an initialized ring */
+#define INET_SHMRING_MAGIC 0x52494e47
+
+/** Size of ring header, data area follows */
+#define INET_SHMRING_HDR_SIZE 256
+
+/** Minimum size of ring data area */
+#define INET_SHMRING_MIN_SIZE 1024
+
+/** Ring header as placed in shared memory.
+ *
+ * Producer and consumer fields live in separate cache lines. The
+ * positions are free-running byte counts, the offset into the data area
+ * is the position modulo the (power of two) data size.
+ */
+typedef struct {
+	/** Magic number */
+	uint32_t magic;
+	/** Size of data area in bytes (power of two) */
+	uint32_t size;
+	/** Number of records dropped by producer because the ring was full */
+	uint32_t dropped;
+	uint32_t pad0[13];
+	/** Producer position */
+	uint32_t head;
+	/** Consumer is waiting for doorbell */
+	uint32_t cons_wait;
+	uint32_t pad1[14];
+	/** Consumer position */
+	uint32_t tail;
+	/** Producer is waiting for space */
+	uint32_t prod_wait;
+	uint32_t pad2[14];
+} inet_shmring_hdr_t;
+
+/** Shared memory ring (local view of one side) */
+typedef struct {
+	/** Header in shared memory */
+	inet_shmring_hdr_t *hdr;
+	/** Data area in shared memory */
+	uint8_t *data;
+	/** Size of data area (local copy, not trusted from peer) */
+	uint32_t size;
+	/** Own position (head for producer, tail for consumer) */
+	uint32_t pos;
+	/** Offset of reserved or read record */
+	uint32_t pending_off;
+	/** Padding to skip before reserved record */
+	uint32_t pending_pad;
+	/** Total size of read record */
+	uint32_t pending_size;
+} inet_shmring_t;
+
+extern size_t inet_shmring_area_size(size_t);
+extern errno_t inet_shmring_init(void *, size_t, inet_shmring_t *);
+extern errno_t inet_shmring_attach(void *, size_t, inet_shmring_t *);
+extern size_t inet_shmring_max_record(inet_shmring_t *);
+
+extern errno_t inet_shmring_reserve(inet_shmring_t *, size_t, void **);
+extern void inet_shmring_commit(inet_shmring_t *, size_t);
+extern errno_t inet_shmring_write(inet_shmring_t *, const void *, size_t,
+    const void *, size_t);
+extern bool inet_shmring_kick_needed(inet_shmring_t *);
+extern bool inet_shmring_prod_wait(inet_shmring_t *, size_t);
+extern void inet_shmring_drop(inet_shmring_t *);
+
+extern errno_t inet_shmring_read(inet_shmring_t *, void **, size_t *);
+extern void inet_shmring_consume(inet_shmring_t *);
+extern bool inet_shmring_space_kick_needed(inet_shmring_t *);
+extern bool inet_shmring_cons_wait(inet_shmring_t *);
+
+#endif
+
+/** @}
+ */
@@ -39,6 +39,7 @@
 #include <inet/addr.h>
 #include <inet/endpoint.h>
 #include <inet/inet.h>
+#include <inet/shmring.h>
 
 /** TCP connection */
 typedef struct {
@@ -54,6 +55,16 @@ typedef struct {
 	bool connected;
 	bool conn_failed;
 	bool conn_reset;
+	/** Shared area with data rings or @c NULL */
+	void *ring_area;
+	/** Serializes senders using the transmit ring */
+	fibril_mutex_t ring_lock;
+	/** Ring of data sent to the service */
+	inet_shmring_t tx_ring;
+	/** Ring of data received from the service */
+	inet_shmring_t rx_ring;
+	/** Number of bytes already read from current receive ring record */
+	size_t rx_off;
 } tcp_conn_t;
 
 /** TCP connection listener */
@@ -108,6 +119,7 @@ extern errno_t tcp_listener_create(tcp_t *, inet_ep_t *, tcp_listen_cb_t *, void
 extern void tcp_listener_destroy(tcp_listener_t *);
 extern void *tcp_listener_userptr(tcp_listener_t *);
 
+extern errno_t tcp_conn_ring_create(tcp_conn_t *, size_t);
 extern errno_t tcp_conn_wait_connected(tcp_conn_t *);
 extern errno_t tcp_conn_send(tcp_conn_t *, const void *, size_t);
 extern errno_t tcp_conn_send_fin(tcp_conn_t *);
@@ -40,6 +40,7 @@
 #include <inet/addr.h>
 #include <inet/endpoint.h>
 #include <inet/inet.h>
+#include <inet/shmring.h>
 #include <stdbool.h>
 
 /** UDP link state */
@@ -54,6 +55,8 @@ typedef struct {
 	sysarg_t assoc_id;
 	size_t size;
 	inet_ep_t remote_ep;
+	/** Message data if it was received via shared ring */
+	const void *data;
 } udp_rmsg_t;
 
 /** UDP received error */
@@ -67,6 +70,14 @@ typedef struct {
 	sysarg_t id;
 	struct udp_cb *cb;
 	void *cb_arg;
+	/** Shared area with message rings or @c NULL */
+	void *ring_area;
+	/** Serializes senders using the transmit ring */
+	fibril_mutex_t ring_lock;
+	/** Ring of messages sent to the service */
+	inet_shmring_t tx_ring;
+	/** Ring of messages received from the service */
+	inet_shmring_t rx_ring;
 } udp_assoc_t;
 
 /** UDP callbacks */
@@ -95,6 +106,7 @@ extern void udp_destroy(udp_t *);
 extern errno_t udp_assoc_create(udp_t *, inet_ep2_t *, udp_cb_t *, void *,
     udp_assoc_t **);
 extern errno_t udp_assoc_set_nolocal(udp_assoc_t *);
+extern errno_t udp_assoc_ring_create(udp_assoc_t *, size_t);
 extern void udp_assoc_destroy(udp_assoc_t *);
 extern errno_t udp_assoc_send_msg(udp_assoc_t *, inet_ep_t *, void *, size_t);
 extern void *udp_assoc_userptr(udp_assoc_t *);
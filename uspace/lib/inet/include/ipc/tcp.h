@@ -48,7 +48,9 @@ typedef enum {
 	TCP_CONN_PUSH,
 	TCP_CONN_RESET,
 	TCP_CONN_RECV,
-	TCP_CONN_RECV_WAIT
+	TCP_CONN_RECV_WAIT,
+	TCP_CONN_RING_CREATE,
+	TCP_CONN_RING_KICK
 } tcp_request_t;
 
 typedef enum {
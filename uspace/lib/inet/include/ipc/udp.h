@@ -35,6 +35,7 @@
 #ifndef LIBINET_IPC_UDP_H
 #define LIBINET_IPC_UDP_H
 
+#include <inet/endpoint.h>
 #include <ipc/common.h>
 
 typedef enum {
@@ -45,13 +46,28 @@ typedef enum {
 	UDP_ASSOC_SEND_MSG,
 	UDP_RMSG_INFO,
 	UDP_RMSG_READ,
-	UDP_RMSG_DISCARD
+	UDP_RMSG_DISCARD,
+	UDP_ASSOC_RING_CREATE,
+	UDP_ASSOC_RING_KICK
 } udp_request_t;
 
 typedef enum {
-	UDP_EV_DATA = IPC_FIRST_USER_METHOD
+	UDP_EV_DATA = IPC_FIRST_USER_METHOD,
+	UDP_EV_RING
 } udp_event_t;
 
+/** Header of message record in association shared ring.
+ *
+ * The shared area is split in two halves. The first half holds the
+ * ring of messages sent by the client, the second half the ring of
+ * received messages. Each record consists of this header followed
+ * by message data.
+ */
+typedef struct {
+	/** Destination (sent) or source (received) endpoint */
+	inet_ep_t ep;
+} udp_ring_msg_t;
+
 #endif
 
 /** @}
@@ -0,0 +1,37 @@
+/** @addtogroup libinet
+ * @{
+ */
+/** @file
+ */
+
+#ifndef LIBINET_TYPES_DNSR_H
+#define LIBINET_TYPES_DNSR_H
+
+#include <stdint.h>
+
+/** DNS resolver cache statistics */
+typedef struct {
+	/** Number of entries in the cache */
+	uint64_t entries;
+	/** Maximum number of entries */
+	uint64_t max_entries;
+	/** Queries answered from a positive entry */
+	uint64_t hits;
+	/** Queries answered from a negative entry */
+	uint64_t neg_hits;
+	/** Queries not found in the cache */
+	uint64_t misses;
+	/** Queries that waited for an identical query in progress */
+	uint64_t coalesced;
+	/** Entries inserted */
+	uint64_t inserts;
+	/** Entries evicted to make room for new ones */
+	uint64_t evictions;
+	/** Entries removed after their TTL expired */
+	uint64_t expirations;
+} dnsr_cache_stats_t;
+
+#endif
+
+/** @}
+ */
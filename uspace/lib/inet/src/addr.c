@@ -242,8 +242,9 @@ int inet_naddr_compare_mask(const inet_naddr_t *naddr, const inet_addr_t *addr)
 		if (naddr->prefix > 32)
 			return 0;
 
-		addr32_t mask =
-		    BIT_RANGE(addr32_t, 31, 31 - (naddr->prefix - 1));
+		/* Avoid shifting by the full width for /0 */
+		addr32_t mask = naddr->prefix == 0 ? 0 :
+		    ~(addr32_t) 0 << (32 - naddr->prefix);
 		return ((naddr->addr & mask) == (addr->addr & mask));
 	case ip_v6:
 		if (naddr->prefix > 128)
@@ -0,0 +1,223 @@
+/** @addtogroup libinet
+ * @{
+ */
+/**
+ * @file Internet checksum
+ *
+ * One's complement sum as defined by RFC 1071. The sum is independent
+ * of byte order, so we add up data in native order, several bytes at a
+ * time, and only convert the folded 16-bit result to host order at the end.
+ * Incremental update follows RFC 1624.
+ */
+
+#include <byteorder.h>
+#include <inet/checksum.h>
+#include <stdbool.h>
+
+/** 32-bit word that may alias any data we are summing */
+typedef uint32_t __attribute__((may_alias)) inet_csum_u32_t;
+/** 16-bit word that may alias any data we are summing */
+typedef uint16_t __attribute__((may_alias)) inet_csum_u16_t;
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+
+/** Use vector unit to sum the bulk of the data */
+#define INET_CSUM_VECTOR
+
+/** Four 32-bit lanes, only requiring natural alignment of the lanes */
+typedef uint32_t inet_csum_vec_t __attribute__((vector_size(16), aligned(4),
+    may_alias));
+
+/** Maximum number of vector loop iterations before flushing lanes.
+ *
+ * Each iteration adds at most 4 * 0xffff to each 32-bit lane.
+ */
+#define INET_CSUM_VEC_ITER_MAX 8192
+
+#endif
+
+/** Fold 64-bit one's complement accumulator to 16 bits.
+ *
+ * @param sum Accumulator
+ * @return Folded sum
+ */
+static uint16_t inet_csum_fold(uint64_t sum)
+{
+	while ((sum >> 16) != 0)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return sum;
+}
+
+#ifdef INET_CSUM_VECTOR
+
+/** Sum bulk of 4-byte aligned data using the vector unit.
+ *
+ * @param data Pointer to pointer to data, updated on return
+ * @param size Pointer to data size, updated on return
+ * @return Unfolded partial sum of native-order 16-bit words
+ */
+static uint64_t inet_csum_sum_vec(const uint8_t **data, size_t *size)
+{
+	const uint8_t *p = *data;
+	size_t n = *size;
+	uint64_t sum = 0;
+	inet_csum_vec_t v0, v1;
+	inet_csum_vec_t vsum;
+	unsigned i;
+
+	while (n >= 2 * sizeof(inet_csum_vec_t)) {
+		vsum = (inet_csum_vec_t) { 0, 0, 0, 0 };
+		i = 0;
+
+		while (n >= 2 * sizeof(inet_csum_vec_t) &&
+		    i < INET_CSUM_VEC_ITER_MAX) {
+			v0 = ((const inet_csum_vec_t *) p)[0];
+			v1 = ((const inet_csum_vec_t *) p)[1];
+			vsum += (v0 & 0xffff) + (v0 >> 16);
+			vsum += (v1 & 0xffff) + (v1 >> 16);
+			p += 2 * sizeof(inet_csum_vec_t);
+			n -= 2 * sizeof(inet_csum_vec_t);
+			++i;
+		}
+
+		sum += (uint64_t) vsum[0] + vsum[1] + vsum[2] + vsum[3];
+	}
+
+	*data = p;
+	*size = n;
+	return sum;
+}
+
+#endif
+
+/** Compute one's complement sum of data in native byte order.
+ *
+ * @param p Data
+ * @param size Size of data in bytes
+ * @return Folded sum of native-order 16-bit words
+ */
+static uint16_t inet_csum_sum(const uint8_t *p, size_t size)
+{
+	const inet_csum_u32_t *w;
+	uint64_t sum = 0;
+	uint64_t sum2 = 0;
+	uint16_t w16;
+	uint16_t res;
+	bool odd;
+
+	/*
+	 * If we start at an odd address, add the first byte as if
+	 * it was the second byte of a word and byte-swap the result
+	 * at the end.
+	 */
+	odd = ((uintptr_t) p & 1) != 0;
+	if (odd && size > 0) {
+		w16 = 0;
+		((uint8_t *) &w16)[1] = *p;
+		sum += w16;
+		++p;
+		--size;
+	}
+
+	/* Align to 32 bits */
+	if (((uintptr_t) p & 2) != 0 && size >= 2) {
+		sum += *(const inet_csum_u16_t *) p;
+		p += 2;
+		size -= 2;
+	}
+
+#ifdef INET_CSUM_VECTOR
+	sum += inet_csum_sum_vec(&p, &size);
+#endif
+
+	/* Main loop, 32 bytes per iteration, two independent accumulators */
+	w = (const inet_csum_u32_t *) p;
+	while (size >= 8 * sizeof(uint32_t)) {
+		sum += (uint64_t) w[0] + w[1] + w[2] + w[3];
+		sum2 += (uint64_t) w[4] + w[5] + w[6] + w[7];
+		w += 8;
+		size -= 8 * sizeof(uint32_t);
+	}
+
+	while (size >= sizeof(uint32_t)) {
+		sum += *w++;
+		size -= sizeof(uint32_t);
+	}
+
+	p = (const uint8_t *) w;
+	if (size >= 2) {
+		sum += *(const inet_csum_u16_t *) p;
+		p += 2;
+		size -= 2;
+	}
+
+	/* Trailing byte is padded with zero */
+	if (size > 0) {
+		w16 = 0;
+		((uint8_t *) &w16)[0] = *p;
+		sum += w16;
+	}
+
+	res = inet_csum_fold(inet_csum_fold(sum) + (uint64_t) inet_csum_fold(sum2));
+	if (odd)
+		res = uint16_t_byteorder_swap(res);
+
+	return res;
+}
+
+/** Compute Internet checksum.
+ *
+ * The checksum of data split into multiple buffers can be computed
+ * by passing the result of the previous call as @a ivalue. All buffers
+ * except the last one must be of even size.
+ *
+ * @param ivalue Initial value (INET_CHECKSUM_INIT or result of previous call)
+ * @param data Data
+ * @param size Size of data in bytes
+ * @return Checksum (in host byte order)
+ */
+uint16_t inet_checksum_calc(uint16_t ivalue, const void *data, size_t size)
+{
+	uint32_t sum;
+
+	sum = uint16_t_be2host(inet_csum_sum(data, size));
+	sum += (uint16_t) ~ivalue;
+
+	return ~inet_csum_fold(sum);
+}
+
+/** Update Internet checksum after changing a 16-bit field.
+ *
+ * @param csum Original checksum (in host byte order)
+ * @param oldv Old value of the field (in host byte order)
+ * @param newv New value of the field (in host byte order)
+ * @return Updated checksum (in host byte order)
+ */
+uint16_t inet_checksum_update16(uint16_t csum, uint16_t oldv, uint16_t newv)
+{
+	uint32_t sum;
+
+	/* RFC 1624, eqn. 3: HC' = ~(~HC + ~m + m') */
+	sum = (uint32_t) (uint16_t) ~csum + (uint16_t) ~oldv + newv;
+	return ~inet_csum_fold(sum);
+}
+
+/** Update Internet checksum after changing a 32-bit field.
+ *
+ * The field must be aligned on a 16-bit boundary within the checksummed
+ * data.
+ *
+ * @param csum Original checksum (in host byte order)
+ * @param oldv Old value of the field (in host byte order)
+ * @param newv New value of the field (in host byte order)
+ * @return Updated checksum (in host byte order)
+ */
+uint16_t inet_checksum_update32(uint16_t csum, uint32_t oldv, uint32_t newv)
+{
+	csum = inet_checksum_update16(csum, oldv >> 16, newv >> 16);
+	return inet_checksum_update16(csum, oldv & 0xffff, newv & 0xffff);
+}
+
+/** @}
+ */
@@ -0,0 +1,476 @@
+/** @addtogroup libinet
+ * @{
+ */
+/**
+ * @file Longest prefix match table
+ *
+ * Prefixes are kept in a path-compressed binary (PATRICIA) trie, one for
+ * each address family. Each node stores its full prefix, so that lookup
+ * only follows one path from the root and needs no backtracking. Nodes
+ * without a value (glue nodes) always have two children.
+ *
+ * Results of inet_lpm_lookup() are remembered in a small direct-mapped
+ * destination cache, which is invalidated whenever the table changes.
+ */
+
+#include <adt/hash.h>
+#include <assert.h>
+#include <errno.h>
+#include <inet/lpm.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdlib.h>
+
+/** Maximum prefix length (IPv6) */
+#define INET_LPM_BITS_MAX 128
+/** Key size in bytes */
+#define INET_LPM_KEY_SIZE (INET_LPM_BITS_MAX / 8)
+
+/** Trie node */
+typedef struct inet_lpm_node {
+	/** Children, indexed by the first bit following the prefix */
+	struct inet_lpm_node *child[2];
+	/** Prefix, bits following it are zero */
+	uint8_t key[INET_LPM_KEY_SIZE];
+	/** Prefix length */
+	unsigned bits;
+	/** Value or @c NULL for glue node */
+	void *value;
+} inet_lpm_node_t;
+
+/** Get bit of a key.
+ *
+ * @param key Key
+ * @param i Bit index, zero being the most significant bit
+ * @return Bit value
+ */
+static inline unsigned inet_lpm_bit(const uint8_t *key, unsigned i)
+{
+	return (key[i / 8] >> (7 - i % 8)) & 1;
+}
+
+/** Compute length of common prefix of two keys.
+ *
+ * @param a First key
+ * @param b Second key
+ * @param max Maximum number of bits to compare
+ * @return Number of leading bits the keys have in common, at most @a max
+ */
+static unsigned inet_lpm_common(const uint8_t *a, const uint8_t *b,
+    unsigned max)
+{
+	unsigned i;
+	uint8_t d;
+
+	for (i = 0; i < max; i += 8) {
+		d = a[i / 8] ^ b[i / 8];
+		if (d != 0) {
+			while ((d & 0x80) == 0) {
+				d <<= 1;
+				++i;
+			}
+			break;
+		}
+	}
+
+	return min(i, max);
+}
+
+/** Clear bits of key following the prefix.
+ *
+ * @param key Key
+ * @param bits Prefix length
+ */
+static void inet_lpm_mask(uint8_t *key, unsigned bits)
+{
+	unsigned i;
+
+	if (bits % 8 != 0)
+		key[bits / 8] &= 0xff << (8 - bits % 8);
+
+	for (i = (bits + 7) / 8; i < INET_LPM_KEY_SIZE; i++)
+		key[i] = 0;
+}
+
+/** Convert address to key.
+ *
+ * @param lpm Longest prefix match table
+ * @param addr Address
+ * @param key Key buffer
+ * @param rmaxbits Place to store address length in bits
+ * @return Pointer to root of the trie for the address family or @c NULL
+ *         if the address family is not supported
+ */
+static inet_lpm_node_t **inet_lpm_key(inet_lpm_t *lpm, const inet_addr_t *addr,
+    uint8_t *key, unsigned *rmaxbits)
+{
+	switch (addr->version) {
+	case ip_v4:
+		memset(key, 0, INET_LPM_KEY_SIZE);
+		key[0] = addr->addr >> 24;
+		key[1] = addr->addr >> 16;
+		key[2] = addr->addr >> 8;
+		key[3] = addr->addr;
+		*rmaxbits = 32;
+		return &lpm->root4;
+	case ip_v6:
+		memcpy(key, addr->addr6, INET_LPM_KEY_SIZE);
+		*rmaxbits = 128;
+		return &lpm->root6;
+	default:
+		return NULL;
+	}
+}
+
+/** Convert network address to key.
+ *
+ * @param lpm Longest prefix match table
+ * @param naddr Network address
+ * @param key Key buffer
+ * @param rbits Place to store prefix length
+ * @return Pointer to root of the trie for the address family or @c NULL
+ *         if the address family is not supported or prefix is invalid
+ */
+static inet_lpm_node_t **inet_lpm_nkey(inet_lpm_t *lpm,
+    const inet_naddr_t *naddr, uint8_t *key, unsigned *rbits)
+{
+	inet_lpm_node_t **root;
+	inet_addr_t addr;
+	unsigned maxbits;
+
+	inet_naddr_addr(naddr, &addr);
+	root = inet_lpm_key(lpm, &addr, key, &maxbits);
+	if (root == NULL || naddr->prefix > maxbits)
+		return NULL;
+
+	inet_lpm_mask(key, naddr->prefix);
+	*rbits = naddr->prefix;
+	return root;
+}
+
+/** Create trie node.
+ *
+ * @param key Key
+ * @param bits Prefix length
+ * @param value Value or @c NULL
+ * @return New node or @c NULL if out of memory
+ */
+static inet_lpm_node_t *inet_lpm_node_new(const uint8_t *key, unsigned bits,
+    void *value)
+{
+	inet_lpm_node_t *node;
+
+	node = calloc(1, sizeof(inet_lpm_node_t));
+	if (node == NULL)
+		return NULL;
+
+	memcpy(node->key, key, INET_LPM_KEY_SIZE);
+	inet_lpm_mask(node->key, bits);
+	node->bits = bits;
+	node->value = value;
+	return node;
+}
+
+/** Destroy trie.
+ *
+ * @param node Root of the (sub)trie or @c NULL
+ */
+static void inet_lpm_node_destroy(inet_lpm_node_t *node)
+{
+	if (node == NULL)
+		return;
+
+	inet_lpm_node_destroy(node->child[0]);
+	inet_lpm_node_destroy(node->child[1]);
+	free(node);
+}
+
+/** Invalidate destination cache.
+ *
+ * @param lpm Longest prefix match table
+ */
+static void inet_lpm_invalidate(inet_lpm_t *lpm)
+{
+	if (++lpm->gen == 0) {
+		memset(lpm->cache, 0, sizeof(lpm->cache));
+		lpm->gen = 1;
+	}
+}
+
+/** Initialize longest prefix match table.
+ *
+ * @param lpm Longest prefix match table
+ */
+void inet_lpm_initialize(inet_lpm_t *lpm)
+{
+	memset(lpm, 0, sizeof(inet_lpm_t));
+	lpm->gen = 1;
+}
+
+/** Finalize longest prefix match table.
+ *
+ * Frees all memory used by the table. The values are not touched.
+ *
+ * @param lpm Longest prefix match table
+ */
+void inet_lpm_finalize(inet_lpm_t *lpm)
+{
+	inet_lpm_node_destroy(lpm->root4);
+	inet_lpm_node_destroy(lpm->root6);
+	lpm->root4 = NULL;
+	lpm->root6 = NULL;
+	lpm->count = 0;
+	inet_lpm_invalidate(lpm);
+}
+
+/** Insert prefix into longest prefix match table.
+ *
+ * Host bits of @a naddr (following the prefix) are ignored.
+ *
+ * @param lpm Longest prefix match table
+ * @param naddr Network address
+ * @param value Value (not @c NULL)
+ * @return EOK on success, EEXIST if the prefix is already present,
+ *         EINVAL if @a naddr is not valid, ENOMEM if out of memory
+ */
+errno_t inet_lpm_insert(inet_lpm_t *lpm, const inet_naddr_t *naddr,
+    void *value)
+{
+	uint8_t key[INET_LPM_KEY_SIZE];
+	inet_lpm_node_t **pp;
+	inet_lpm_node_t *node;
+	inet_lpm_node_t *nnode;
+	inet_lpm_node_t *glue;
+	unsigned bits;
+	unsigned common;
+
+	assert(value != NULL);
+
+	pp = inet_lpm_nkey(lpm, naddr, key, &bits);
+	if (pp == NULL)
+		return EINVAL;
+
+	while (*pp != NULL) {
+		node = *pp;
+		common = inet_lpm_common(node->key, key, min(node->bits, bits));
+
+		if (common == node->bits) {
+			/* Node prefix is a prefix of the key */
+			if (node->bits == bits) {
+				if (node->value != NULL)
+					return EEXIST;
+
+				/* Turn glue node into a regular one */
+				node->value = value;
+				goto done;
+			}
+
+			pp = &node->child[inet_lpm_bit(key, node->bits)];
+			continue;
+		}
+
+		nnode = inet_lpm_node_new(key, bits, value);
+		if (nnode == NULL)
+			return ENOMEM;
+
+		if (common == bits) {
+			/* Key is a prefix of node prefix, insert above it */
+			nnode->child[inet_lpm_bit(node->key, bits)] = node;
+			*pp = nnode;
+		} else {
+			/* Prefixes diverge, split with a glue node */
+			glue = inet_lpm_node_new(key, common, NULL);
+			if (glue == NULL) {
+				free(nnode);
+				return ENOMEM;
+			}
+
+			glue->child[inet_lpm_bit(key, common)] = nnode;
+			glue->child[inet_lpm_bit(node->key, common)] = node;
+			*pp = glue;
+		}
+
+		goto done;
+	}
+
+	*pp = inet_lpm_node_new(key, bits, value);
+	if (*pp == NULL)
+		return ENOMEM;
+done:
+	++lpm->count;
+	inet_lpm_invalidate(lpm);
+	return EOK;
+}
+
+/** Remove prefix from longest prefix match table.
+ *
+ * @param lpm Longest prefix match table
+ * @param naddr Network address
+ * @return EOK on success, ENOENT if the prefix is not present
+ */
+errno_t inet_lpm_remove(inet_lpm_t *lpm, const inet_naddr_t *naddr)
+{
+	uint8_t key[INET_LPM_KEY_SIZE];
+	inet_lpm_node_t **pp;
+	inet_lpm_node_t **ppp;
+	inet_lpm_node_t *node;
+	inet_lpm_node_t *child;
+	inet_lpm_node_t *parent;
+	unsigned bits;
+
+	pp = inet_lpm_nkey(lpm, naddr, key, &bits);
+	if (pp == NULL)
+		return ENOENT;
+
+	ppp = NULL;
+	while ((node = *pp) != NULL) {
+		if (node->bits > bits ||
+		    inet_lpm_common(node->key, key, node->bits) < node->bits)
+			return ENOENT;
+
+		if (node->bits == bits)
+			break;
+
+		ppp = pp;
+		pp = &node->child[inet_lpm_bit(key, node->bits)];
+	}
+
+	if (node == NULL || node->value == NULL)
+		return ENOENT;
+
+	node->value = NULL;
+
+	/* With two children the node stays as a glue node */
+	if (node->child[0] == NULL || node->child[1] == NULL) {
+		child = node->child[0] != NULL ? node->child[0] : node->child[1];
+		*pp = child;
+		free(node);
+
+		/* Parent glue node may have been left with a single child */
+		if (child == NULL && ppp != NULL && (*ppp)->value == NULL) {
+			parent = *ppp;
+			*ppp = parent->child[0] != NULL ? parent->child[0] :
+			    parent->child[1];
+			free(parent);
+		}
+	}
+
+	--lpm->count;
+	inet_lpm_invalidate(lpm);
+	return EOK;
+}
+
+/** Find value of an exact prefix.
+ *
+ * @param lpm Longest prefix match table
+ * @param naddr Network address
+ * @return Value or @c NULL if the prefix is not present
+ */
+void *inet_lpm_find(inet_lpm_t *lpm, const inet_naddr_t *naddr)
+{
+	uint8_t key[INET_LPM_KEY_SIZE];
+	inet_lpm_node_t **pp;
+	inet_lpm_node_t *node;
+	unsigned bits;
+
+	pp = inet_lpm_nkey(lpm, naddr, key, &bits);
+	if (pp == NULL)
+		return NULL;
+
+	node = *pp;
+	while (node != NULL && node->bits <= bits &&
+	    inet_lpm_common(node->key, key, node->bits) == node->bits) {
+		if (node->bits == bits)
+			return node->value;
+
+		node = node->child[inet_lpm_bit(key, node->bits)];
+	}
+
+	return NULL;
+}
+
+/** Find value of the longest prefix matching an address.
+ *
+ * Unlike inet_lpm_lookup() this does not use the destination cache.
+ *
+ * @param lpm Longest prefix match table
+ * @param addr Address
+ * @return Value or @c NULL if no prefix matches
+ */
+void *inet_lpm_lookup_nocache(inet_lpm_t *lpm, const inet_addr_t *addr)
+{
+	uint8_t key[INET_LPM_KEY_SIZE];
+	inet_lpm_node_t **pp;
+	inet_lpm_node_t *node;
+	unsigned maxbits;
+	void *best;
+
+	pp = inet_lpm_key(lpm, addr, key, &maxbits);
+	if (pp == NULL)
+		return NULL;
+
+	best = NULL;
+	node = *pp;
+	while (node != NULL &&
+	    inet_lpm_common(node->key, key, node->bits) == node->bits) {
+		if (node->value != NULL)
+			best = node->value;
+
+		if (node->bits == maxbits)
+			break;
+
+		node = node->child[inet_lpm_bit(key, node->bits)];
+	}
+
+	return best;
+}
+
+/** Compute destination cache index.
+ *
+ * @param addr Address
+ * @return Cache index
+ */
+static size_t inet_lpm_cache_index(const inet_addr_t *addr)
+{
+	size_t hash;
+	uint32_t w;
+	unsigned i;
+
+	if (addr->version == ip_v4) {
+		hash = addr->addr;
+	} else {
+		hash = 0;
+		for (i = 0; i < sizeof(addr128_t); i += sizeof(uint32_t)) {
+			memcpy(&w, &addr->addr6[i], sizeof(uint32_t));
+			hash = hash_combine(hash, w);
+		}
+	}
+
+	return hash_mix(hash) % INET_LPM_CACHE_SIZE;
+}
+
+/** Find value of the longest prefix matching an address.
+ *
+ * @param lpm Longest prefix match table
+ * @param addr Address
+ * @return Value or @c NULL if no prefix matches
+ */
+void *inet_lpm_lookup(inet_lpm_t *lpm, const inet_addr_t *addr)
+{
+	inet_lpm_cache_entry_t *entry;
+
+	if (addr->version != ip_v4 && addr->version != ip_v6)
+		return NULL;
+
+	entry = &lpm->cache[inet_lpm_cache_index(addr)];
+	if (entry->gen == lpm->gen && inet_addr_compare(&entry->addr, addr))
+		return entry->value;
+
+	entry->addr = *addr;
+	entry->value = inet_lpm_lookup_nocache(lpm, addr);
+	entry->gen = lpm->gen;
+	return entry->value;
+}
+
+/** @}
+ */
@@ -0,0 +1,698 @@
+/** @addtogroup libinet
+ * @{
+ */
+/**
+ * @file Neighbour cache
+ *
+ * Maps protocol (IPv4 or IPv6) addresses of neighbours to link-layer
+ * addresses. Used both for ARP and NDP. Entries follow a simplified
+ * version of the RFC 4861 neighbour unreachability detection state
+ * machine:
+ *
+ * - Sending to an unknown address creates an incomplete entry and
+ *   broadcasts a solicitation. Packets are queued on the entry rather
+ *   than blocking the sender and transmitted once a reply arrives.
+ *   If there is no reply after several solicitations, the entry is
+ *   removed and its packets dropped.
+ * - A confirmed entry is reachable for some time. If it was used in
+ *   the meantime, it is refreshed with a unicast probe shortly before
+ *   it would go stale, so that active neighbours never need to be
+ *   resolved again synchronously.
+ * - A stale entry is still used for sending. Using it starts a probe.
+ *   Stale entries that are not used are eventually removed.
+ *
+ * Aging is driven by inet_nbcache_tick(), which inet_nbcache_start()
+ * arranges to be called periodically. The current time is always
+ * passed in by the caller. The solicit, xmit and discard operations are
+ * never called with the cache lock held.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <assert.h>
+#include <errno.h>
+#include <inet/nbcache.h>
+#include <mem.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/** Queued packet */
+typedef struct {
+	/** Link to inet_nb_entry_t.queue */
+	link_t lqueue;
+	/** Packet */
+	void *pkt;
+} inet_nb_qpkt_t;
+
+/** Solicitation to send once the cache lock is released */
+typedef struct {
+	/** Link */
+	void *link;
+	/** Source address */
+	inet_addr_t src;
+	/** Target address */
+	inet_addr_t target;
+	/** Destination link-layer address */
+	eth_addr_t dest;
+	/** Solicitation is unicast to @c dest */
+	bool unicast;
+} inet_nb_solicit_t;
+
+static size_t inet_nb_key_hash(const void *key)
+{
+	const inet_addr_t *addr = key;
+	size_t hash;
+	uint32_t w;
+	unsigned i;
+
+	hash = addr->version;
+	if (addr->version == ip_v4) {
+		hash = hash_combine(hash, addr->addr);
+	} else {
+		for (i = 0; i < sizeof(addr128_t); i += sizeof(uint32_t)) {
+			memcpy(&w, &addr->addr6[i], sizeof(uint32_t));
+			hash = hash_combine(hash, w);
+		}
+	}
+
+	return hash;
+}
+
+static size_t inet_nb_hash(const ht_link_t *item)
+{
+	inet_nb_entry_t *entry =
+	    hash_table_get_inst(item, inet_nb_entry_t, lentries);
+
+	return inet_nb_key_hash(&entry->addr);
+}
+
+static bool inet_nb_key_equal(const void *key, const ht_link_t *item)
+{
+	inet_nb_entry_t *entry =
+	    hash_table_get_inst(item, inet_nb_entry_t, lentries);
+
+	return inet_addr_compare(&entry->addr, key);
+}
+
+static void inet_nb_remove_callback(ht_link_t *item)
+{
+	inet_nb_entry_t *entry =
+	    hash_table_get_inst(item, inet_nb_entry_t, lentries);
+
+	assert(list_empty(&entry->queue));
+	list_remove(&entry->llru);
+	free(entry);
+}
+
+static hash_table_ops_t inet_nb_ops = {
+	.hash = inet_nb_hash,
+	.key_hash = inet_nb_key_hash,
+	.key_equal = inet_nb_key_equal,
+	.equal = NULL,
+	.remove_callback = inet_nb_remove_callback
+};
+
+/** Get current time for use with neighbour cache.
+ *
+ * @return Time since boot in microseconds
+ */
+usec_t inet_nbcache_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
+
+/** Create neighbour cache.
+ *
+ * @param max_entries Maximum number of entries
+ * @param ops Operations
+ * @param rnb Place to store pointer to new neighbour cache
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t inet_nbcache_create(size_t max_entries, inet_nbcache_ops_t *ops,
+    inet_nbcache_t **rnb)
+{
+	inet_nbcache_t *nb;
+
+	assert(max_entries > 0);
+
+	nb = calloc(1, sizeof(inet_nbcache_t));
+	if (nb == NULL)
+		return ENOMEM;
+
+	if (!hash_table_create(&nb->entries, 0, 0, &inet_nb_ops)) {
+		free(nb);
+		return ENOMEM;
+	}
+
+	fibril_mutex_initialize(&nb->lock);
+	list_initialize(&nb->lru);
+	nb->max_entries = max_entries;
+	nb->ops = ops;
+
+	*rnb = nb;
+	return EOK;
+}
+
+/** Move queued packets of entry to a list.
+ *
+ * @param entry Entry
+ * @param list List to append packets to
+ */
+static void inet_nb_entry_dequeue(inet_nb_entry_t *entry, list_t *list)
+{
+	list_concat(list, &entry->queue);
+	entry->queued = 0;
+}
+
+/** Remove entry from neighbour cache.
+ *
+ * @param nb Neighbour cache
+ * @param entry Entry
+ * @param drop List to append queued packets of the entry to
+ */
+static void inet_nb_entry_remove(inet_nbcache_t *nb, inet_nb_entry_t *entry,
+    list_t *drop)
+{
+	assert(fibril_mutex_is_locked(&nb->lock));
+
+	inet_nb_entry_dequeue(entry, drop);
+	hash_table_remove_item(&nb->entries, &entry->lentries);
+	--nb->stats.entries;
+}
+
+/** Create neighbour cache entry.
+ *
+ * If the cache is full, the least recently used entry is evicted.
+ *
+ * @param nb Neighbour cache
+ * @param addr Protocol address
+ * @param now Current time
+ * @param drop List to append packets of evicted entry to
+ * @return New entry or @c NULL if out of memory
+ */
+static inet_nb_entry_t *inet_nb_entry_create(inet_nbcache_t *nb,
+    const inet_addr_t *addr, usec_t now, list_t *drop)
+{
+	inet_nb_entry_t *entry;
+
+	assert(fibril_mutex_is_locked(&nb->lock));
+
+	entry = calloc(1, sizeof(inet_nb_entry_t));
+	if (entry == NULL)
+		return NULL;
+
+	if (nb->stats.entries >= nb->max_entries) {
+		inet_nb_entry_remove(nb, list_get_instance(list_first(&nb->lru),
+		    inet_nb_entry_t, llru), drop);
+		++nb->stats.evictions;
+	}
+
+	entry->addr = *addr;
+	entry->used = now;
+	list_initialize(&entry->queue);
+	hash_table_insert(&nb->entries, &entry->lentries);
+	list_append(&entry->llru, &nb->lru);
+	++nb->stats.entries;
+
+	return entry;
+}
+
+/** Find neighbour cache entry.
+ *
+ * @param nb Neighbour cache
+ * @param addr Protocol address
+ * @return Entry or @c NULL if not found
+ */
+static inet_nb_entry_t *inet_nb_find(inet_nbcache_t *nb,
+    const inet_addr_t *addr)
+{
+	ht_link_t *link;
+
+	assert(fibril_mutex_is_locked(&nb->lock));
+
+	link = hash_table_find(&nb->entries, addr);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, inet_nb_entry_t, lentries);
+}
+
+/** Discard list of queued packets.
+ *
+ * @param nb Neighbour cache
+ * @param list List of inet_nb_qpkt_t
+ */
+static void inet_nb_discard_list(inet_nbcache_t *nb, list_t *list)
+{
+	inet_nb_qpkt_t *qpkt;
+	link_t *link;
+
+	while ((link = list_first(list)) != NULL) {
+		qpkt = list_get_instance(link, inet_nb_qpkt_t, lqueue);
+		list_remove(&qpkt->lqueue);
+		nb->ops->discard(qpkt->pkt);
+		free(qpkt);
+	}
+}
+
+/** Prepare solicitation for entry.
+ *
+ * @param entry Entry
+ * @param sol Solicitation to fill in
+ */
+static void inet_nb_solicit_prepare(inet_nb_entry_t *entry,
+    inet_nb_solicit_t *sol)
+{
+	sol->link = entry->link;
+	sol->src = entry->src;
+	sol->target = entry->addr;
+	sol->dest = entry->mac;
+	sol->unicast = entry->state != nbs_incomplete;
+}
+
+/** Send solicitation.
+ *
+ * @param nb Neighbour cache
+ * @param sol Solicitation
+ */
+static void inet_nb_solicit_send(inet_nbcache_t *nb, inet_nb_solicit_t *sol)
+{
+	(void) nb->ops->solicit(sol->link, &sol->src, &sol->target,
+	    sol->unicast ? &sol->dest : NULL);
+}
+
+/** Start probing entry to confirm reachability.
+ *
+ * @param nb Neighbour cache
+ * @param entry Entry
+ * @param now Current time
+ */
+static void inet_nb_entry_probe(inet_nbcache_t *nb, inet_nb_entry_t *entry,
+    usec_t now)
+{
+	entry->state = nbs_probe;
+	entry->solicits = 1;
+	entry->next = now + INET_NB_RETRANS_TIME;
+	++nb->stats.probes;
+}
+
+/** Destroy neighbour cache.
+ *
+ * Queued packets are discarded.
+ *
+ * @param nb Neighbour cache
+ */
+void inet_nbcache_destroy(inet_nbcache_t *nb)
+{
+	inet_nb_entry_t *entry;
+	link_t *link;
+	list_t drop;
+
+	if (nb == NULL)
+		return;
+
+	if (nb->timer != NULL) {
+		(void) fibril_timer_clear(nb->timer);
+		fibril_timer_destroy(nb->timer);
+	}
+
+	list_initialize(&drop);
+
+	fibril_mutex_lock(&nb->lock);
+	while ((link = list_first(&nb->lru)) != NULL) {
+		entry = list_get_instance(link, inet_nb_entry_t, llru);
+		inet_nb_entry_remove(nb, entry, &drop);
+	}
+	fibril_mutex_unlock(&nb->lock);
+
+	inet_nb_discard_list(nb, &drop);
+	hash_table_destroy(&nb->entries);
+	free(nb);
+}
+
+/** Neighbour cache timer handler.
+ *
+ * @param arg Neighbour cache
+ */
+static void inet_nbcache_timer_fun(void *arg)
+{
+	inet_nbcache_t *nb = (inet_nbcache_t *) arg;
+
+	inet_nbcache_tick(nb, inet_nbcache_now());
+	fibril_timer_set(nb->timer, INET_NB_TICK, inet_nbcache_timer_fun, nb);
+}
+
+/** Start periodic aging of neighbour cache.
+ *
+ * @param nb Neighbour cache
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t inet_nbcache_start(inet_nbcache_t *nb)
+{
+	assert(nb->timer == NULL);
+
+	nb->timer = fibril_timer_create(NULL);
+	if (nb->timer == NULL)
+		return ENOMEM;
+
+	fibril_timer_set(nb->timer, INET_NB_TICK, inet_nbcache_timer_fun, nb);
+	return EOK;
+}
+
+/** Resolve protocol address to link-layer address.
+ *
+ * If the address is not known, address resolution is started and
+ * EINPROGRESS is returned. The caller can then queue the packet
+ * with inet_nbcache_enqueue().
+ *
+ * @param nb Neighbour cache
+ * @param link Link on which to send solicitations
+ * @param src Source address for solicitations
+ * @param addr Protocol address to resolve
+ * @param now Current time
+ * @param mac Place to store link-layer address
+ * @return EOK on success, EINPROGRESS if resolution is in progress,
+ *         ENOMEM if out of memory
+ */
+errno_t inet_nbcache_resolve(inet_nbcache_t *nb, void *link,
+    const inet_addr_t *src, const inet_addr_t *addr, usec_t now,
+    eth_addr_t *mac)
+{
+	inet_nb_entry_t *entry;
+	inet_nb_solicit_t sol;
+	bool solicit = false;
+	list_t drop;
+	errno_t rc;
+
+	list_initialize(&drop);
+
+	fibril_mutex_lock(&nb->lock);
+
+	entry = inet_nb_find(nb, addr);
+	if (entry == NULL) {
+		entry = inet_nb_entry_create(nb, addr, now, &drop);
+		if (entry == NULL) {
+			fibril_mutex_unlock(&nb->lock);
+			inet_nb_discard_list(nb, &drop);
+			return ENOMEM;
+		}
+
+		entry->state = nbs_incomplete;
+		entry->solicits = 1;
+		entry->next = now + INET_NB_RETRANS_TIME;
+		++nb->stats.solicits;
+		/* Further solicitations are sent by inet_nbcache_tick() */
+		solicit = true;
+	}
+
+	entry->link = link;
+	entry->src = *src;
+	entry->used = now;
+	list_remove(&entry->llru);
+	list_append(&entry->llru, &nb->lru);
+
+	switch (entry->state) {
+	case nbs_incomplete:
+		++nb->stats.misses;
+		rc = EINPROGRESS;
+		break;
+	case nbs_stale:
+		inet_nb_entry_probe(nb, entry, now);
+		solicit = true;
+		/* Fall through */
+	case nbs_reachable:
+	case nbs_probe:
+		*mac = entry->mac;
+		++nb->stats.hits;
+		rc = EOK;
+		break;
+	}
+
+	if (solicit)
+		inet_nb_solicit_prepare(entry, &sol);
+
+	fibril_mutex_unlock(&nb->lock);
+
+	if (solicit)
+		inet_nb_solicit_send(nb, &sol);
+
+	inet_nb_discard_list(nb, &drop);
+	return rc;
+}
+
+/** Queue packet on entry which is being resolved.
+ *
+ * Should be called after inet_nbcache_resolve() returned EINPROGRESS.
+ * Once the address is resolved, the packet is passed to the xmit
+ * operation. If resolution fails or the queue overflows, it is passed
+ * to the discard operation.
+ *
+ * @param nb Neighbour cache
+ * @param addr Protocol address
+ * @param pkt Packet
+ * @param mac Place to store link-layer address if it has been resolved
+ *            in the meantime
+ * @return EINPROGRESS if packet was queued, EOK if the address was
+ *         resolved in the meantime (the packet was not queued),
+ *         ENOENT if there is no entry for @a addr (the packet was not
+ *         queued), ENOMEM if out of memory
+ */
+errno_t inet_nbcache_enqueue(inet_nbcache_t *nb, const inet_addr_t *addr,
+    void *pkt, eth_addr_t *mac)
+{
+	inet_nb_entry_t *entry;
+	inet_nb_qpkt_t *qpkt;
+	link_t *link;
+	list_t drop;
+
+	list_initialize(&drop);
+
+	fibril_mutex_lock(&nb->lock);
+
+	entry = inet_nb_find(nb, addr);
+	if (entry == NULL) {
+		fibril_mutex_unlock(&nb->lock);
+		return ENOENT;
+	}
+
+	if (entry->state != nbs_incomplete) {
+		*mac = entry->mac;
+		fibril_mutex_unlock(&nb->lock);
+		return EOK;
+	}
+
+	qpkt = calloc(1, sizeof(inet_nb_qpkt_t));
+	if (qpkt == NULL) {
+		fibril_mutex_unlock(&nb->lock);
+		return ENOMEM;
+	}
+
+	if (entry->queued >= INET_NB_QUEUE_MAX) {
+		/* Drop oldest packet */
+		link = list_first(&entry->queue);
+		list_remove(link);
+		list_append(link, &drop);
+		--entry->queued;
+		++nb->stats.dropped;
+	}
+
+	qpkt->pkt = pkt;
+	list_append(&qpkt->lqueue, &entry->queue);
+	++entry->queued;
+	++nb->stats.queued;
+
+	fibril_mutex_unlock(&nb->lock);
+
+	inet_nb_discard_list(nb, &drop);
+	return EINPROGRESS;
+}
+
+/** Update neighbour cache with confirmed address.
+ *
+ * Creates the entry if it does not exist. Packets queued on the entry
+ * are transmitted.
+ *
+ * @param nb Neighbour cache
+ * @param addr Protocol address
+ * @param mac Link-layer address
+ * @param now Current time
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t inet_nbcache_update(inet_nbcache_t *nb, const inet_addr_t *addr,
+    const eth_addr_t *mac, usec_t now)
+{
+	inet_nb_entry_t *entry;
+	inet_nb_qpkt_t *qpkt;
+	link_t *link;
+	list_t xmit;
+	list_t drop;
+
+	list_initialize(&xmit);
+	list_initialize(&drop);
+
+	fibril_mutex_lock(&nb->lock);
+
+	entry = inet_nb_find(nb, addr);
+	if (entry == NULL) {
+		entry = inet_nb_entry_create(nb, addr, now, &drop);
+		if (entry == NULL) {
+			fibril_mutex_unlock(&nb->lock);
+			inet_nb_discard_list(nb, &drop);
+			return ENOMEM;
+		}
+	}
+
+	entry->mac = *mac;
+	entry->state = nbs_reachable;
+	entry->confirmed = now;
+	entry->solicits = 0;
+	inet_nb_entry_dequeue(entry, &xmit);
+	++nb->stats.confirms;
+
+	fibril_mutex_unlock(&nb->lock);
+
+	while ((link = list_first(&xmit)) != NULL) {
+		qpkt = list_get_instance(link, inet_nb_qpkt_t, lqueue);
+		list_remove(&qpkt->lqueue);
+		nb->ops->xmit(qpkt->pkt, mac);
+		free(qpkt);
+	}
+
+	inet_nb_discard_list(nb, &drop);
+	return EOK;
+}
+
+/** Remove neighbour cache entry.
+ *
+ * Packets queued on the entry are discarded.
+ *
+ * @param nb Neighbour cache
+ * @param addr Protocol address
+ * @return EOK on success, ENOENT if there is no entry for @a addr
+ */
+errno_t inet_nbcache_remove(inet_nbcache_t *nb, const inet_addr_t *addr)
+{
+	inet_nb_entry_t *entry;
+	list_t drop;
+
+	list_initialize(&drop);
+
+	fibril_mutex_lock(&nb->lock);
+
+	entry = inet_nb_find(nb, addr);
+	if (entry == NULL) {
+		fibril_mutex_unlock(&nb->lock);
+		return ENOENT;
+	}
+
+	inet_nb_entry_remove(nb, entry, &drop);
+	fibril_mutex_unlock(&nb->lock);
+
+	inet_nb_discard_list(nb, &drop);
+	return EOK;
+}
+
+/** Age neighbour cache entries.
+ *
+ * Retransmits solicitations, refreshes recently used entries before
+ * they go stale and removes entries that failed to resolve or have not
+ * been used for a long time.
+ *
+ * @param nb Neighbour cache
+ * @param now Current time
+ */
+void inet_nbcache_tick(inet_nbcache_t *nb, usec_t now)
+{
+	inet_nb_entry_t *entry;
+	inet_nb_solicit_t *sol;
+	size_t nsol;
+	size_t i;
+	usec_t expires;
+	usec_t last;
+	list_t drop;
+
+	list_initialize(&drop);
+
+	fibril_mutex_lock(&nb->lock);
+
+	sol = calloc(nb->stats.entries + 1, sizeof(inet_nb_solicit_t));
+	if (sol == NULL) {
+		fibril_mutex_unlock(&nb->lock);
+		return;
+	}
+
+	nsol = 0;
+
+	list_foreach_safe(nb->lru, cur, next) {
+		entry = list_get_instance(cur, inet_nb_entry_t, llru);
+
+		switch (entry->state) {
+		case nbs_incomplete:
+		case nbs_probe:
+			if (now < entry->next)
+				break;
+
+			if (entry->solicits >= INET_NB_MAX_SOLICIT) {
+				inet_nb_entry_remove(nb, entry, &drop);
+				++nb->stats.failures;
+				break;
+			}
+
+			++entry->solicits;
+			entry->next = now + INET_NB_RETRANS_TIME;
+			if (entry->state == nbs_incomplete)
+				++nb->stats.solicits;
+			else
+				++nb->stats.probes;
+
+			inet_nb_solicit_prepare(entry, &sol[nsol++]);
+			break;
+		case nbs_reachable:
+			expires = entry->confirmed + INET_NB_REACHABLE_TIME;
+
+			if (entry->link != NULL && entry->used > entry->confirmed &&
+			    now + INET_NB_REFRESH_LEAD >= expires) {
+				/* Entry is in use, refresh it in the background */
+				inet_nb_entry_probe(nb, entry, now);
+				inet_nb_solicit_prepare(entry, &sol[nsol++]);
+			} else if (now >= expires) {
+				entry->state = nbs_stale;
+			}
+			break;
+		case nbs_stale:
+			last = entry->used > entry->confirmed ? entry->used :
+			    entry->confirmed;
+			if (now >= last + INET_NB_GC_TIME) {
+				inet_nb_entry_remove(nb, entry, &drop);
+				++nb->stats.expirations;
+			}
+			break;
+		}
+	}
+
+	fibril_mutex_unlock(&nb->lock);
+
+	for (i = 0; i < nsol; i++)
+		inet_nb_solicit_send(nb, &sol[i]);
+
+	free(sol);
+	inet_nb_discard_list(nb, &drop);
+}
+
+/** Get neighbour cache counters.
+ *
+ * @param nb Neighbour cache
+ * @param stats Place to store counters
+ */
+void inet_nbcache_get_stats(inet_nbcache_t *nb, inet_nbcache_stats_t *stats)
+{
+	fibril_mutex_lock(&nb->lock);
+	*stats = nb->stats;
+	fibril_mutex_unlock(&nb->lock);
+}
+
+/** @}
+ */
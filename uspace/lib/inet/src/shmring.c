@@ -0,0 +1,445 @@
+/** @addtogroup libinet
+ * @{
+ */
+/**
+ * @file Shared memory packet ring
+ *
+ * Single-producer single-consumer ring of variable-size records placed
+ * in a memory area shared between two tasks. Used to pass datagrams or
+ * stream data between the networking services and their clients without
+ * an IPC round trip per message.
+ *
+ * Each record starts with a small header and is aligned to 8 bytes.
+ * Records never wrap around the end of the data area, instead a padding
+ * record fills the remainder. The producer only writes the head position,
+ * the consumer only writes the tail position. Each side keeps its own
+ * position locally and only reads the peer's position from shared memory,
+ * validating it, since the peer cannot be trusted.
+ *
+ * Notifications use doorbell suppression: a side that is about to sleep
+ * sets its wait flag and re-checks the ring. The peer only sends a
+ * notification (over IPC) when it finds the flag set, so a busy ring
+ * passes many records per notification.
+ */
+
+#include <align.h>
+#include <assert.h>
+#include <barrier.h>
+#include <errno.h>
+#include <inet/shmring.h>
+#include <mem.h>
+
+/** Record header */
+typedef struct {
+	/** Payload size */
+	uint32_t size;
+	/** Flags (INET_SHMRING_REC_PAD) */
+	uint32_t flags;
+} inet_shmring_rec_t;
+
+/** Record is padding up to the end of the data area */
+#define INET_SHMRING_REC_PAD 0x1
+
+/** Record alignment */
+#define INET_SHMRING_REC_ALIGN 8
+
+/** Total size of record with payload of @a size bytes */
+static uint32_t inet_shmring_rec_total(size_t size)
+{
+	return ALIGN_UP(sizeof(inet_shmring_rec_t) + size,
+	    INET_SHMRING_REC_ALIGN);
+}
+
+/** Get size of shared area needed for a ring.
+ *
+ * @param data_size Requested size of the data area
+ * @return Size of shared area
+ */
+size_t inet_shmring_area_size(size_t data_size)
+{
+	size_t size = INET_SHMRING_MIN_SIZE;
+
+	while (size < data_size)
+		size *= 2;
+
+	return INET_SHMRING_HDR_SIZE + size;
+}
+
+/** Set up local view of a ring.
+ *
+ * @param area Shared area
+ * @param size Size of data area
+ * @param ring Ring
+ */
+static void inet_shmring_setup(void *area, uint32_t size, inet_shmring_t *ring)
+{
+	memset(ring, 0, sizeof(inet_shmring_t));
+	ring->hdr = (inet_shmring_hdr_t *) area;
+	ring->data = (uint8_t *) area + INET_SHMRING_HDR_SIZE;
+	ring->size = size;
+}
+
+/** Initialize new ring in shared area.
+ *
+ * The data area is the largest power of two which fits in the area.
+ *
+ * @param area Shared area
+ * @param area_size Size of shared area
+ * @param ring Ring to initialize
+ * @return EOK on success, EINVAL if the area is too small
+ */
+errno_t inet_shmring_init(void *area, size_t area_size, inet_shmring_t *ring)
+{
+	inet_shmring_hdr_t *hdr = (inet_shmring_hdr_t *) area;
+	uint32_t size;
+
+	static_assert(sizeof(inet_shmring_hdr_t) <= INET_SHMRING_HDR_SIZE, "");
+
+	if (area_size < INET_SHMRING_HDR_SIZE + INET_SHMRING_MIN_SIZE)
+		return EINVAL;
+
+	size = INET_SHMRING_MIN_SIZE;
+	while (size <= UINT32_MAX / 2 &&
+	    INET_SHMRING_HDR_SIZE + 2 * (size_t) size <= area_size)
+		size *= 2;
+
+	memset(hdr, 0, sizeof(inet_shmring_hdr_t));
+	hdr->magic = INET_SHMRING_MAGIC;
+	hdr->size = size;
+	/* Consumer is idle, the first record must ring the doorbell */
+	hdr->cons_wait = 1;
+	write_barrier();
+
+	inet_shmring_setup(area, size, ring);
+	return EOK;
+}
+
+/** Attach to ring initialized by the peer.
+ *
+ * @param area Shared area
+ * @param area_size Size of shared area
+ * @param ring Place to store ring
+ * @return EOK on success, EINVAL if the area does not contain a valid ring
+ */
+errno_t inet_shmring_attach(void *area, size_t area_size, inet_shmring_t *ring)
+{
+	inet_shmring_hdr_t *hdr = (inet_shmring_hdr_t *) area;
+	uint32_t size;
+
+	if (area_size < INET_SHMRING_HDR_SIZE + INET_SHMRING_MIN_SIZE)
+		return EINVAL;
+
+	size = ACCESS_ONCE(hdr->size);
+	if (ACCESS_ONCE(hdr->magic) != INET_SHMRING_MAGIC ||
+	    size < INET_SHMRING_MIN_SIZE || (size & (size - 1)) != 0 ||
+	    INET_SHMRING_HDR_SIZE + (size_t) size > area_size)
+		return EINVAL;
+
+	inet_shmring_setup(area, size, ring);
+	return EOK;
+}
+
+/** Get maximum record payload size.
+ *
+ * @param ring Ring
+ * @return Maximum size of a single record payload
+ */
+size_t inet_shmring_max_record(inet_shmring_t *ring)
+{
+	return ring->size / 2 - sizeof(inet_shmring_rec_t);
+}
+
+/** Determine where the next record would be placed.
+ *
+ * @param ring Ring (producer side)
+ * @param size Record payload size
+ * @param rpad Place to store number of padding bytes before the record
+ * @return EOK if there is space, ENOSPC if the ring is full, EIO if
+ *         the consumer corrupted the ring
+ */
+static errno_t inet_shmring_space(inet_shmring_t *ring, size_t size,
+    uint32_t *rpad)
+{
+	uint32_t tail;
+	uint32_t used;
+	uint32_t off;
+	uint32_t contig;
+	uint32_t total;
+	uint32_t pad;
+
+	tail = ACCESS_ONCE(ring->hdr->tail);
+	/* Do not overwrite data before the consumer is done reading it */
+	read_barrier();
+
+	used = ring->pos - tail;
+	if (used > ring->size)
+		return EIO;
+
+	total = inet_shmring_rec_total(size);
+	off = ring->pos & (ring->size - 1);
+	contig = ring->size - off;
+	pad = total > contig ? contig : 0;
+
+	if (used + pad + total > ring->size)
+		return ENOSPC;
+
+	*rpad = pad;
+	return EOK;
+}
+
+/** Reserve space for a record.
+ *
+ * The record is published by calling inet_shmring_commit().
+ *
+ * @param ring Ring (producer side)
+ * @param size Record payload size
+ * @param rbuf Place to store pointer to payload buffer
+ * @return EOK on success, ENOSPC if the ring is currently full,
+ *         EINVAL if the record would never fit, EIO if the consumer
+ *         corrupted the ring
+ */
+errno_t inet_shmring_reserve(inet_shmring_t *ring, size_t size, void **rbuf)
+{
+	inet_shmring_rec_t *rec;
+	uint32_t off;
+	uint32_t pad;
+	errno_t rc;
+
+	if (size > inet_shmring_max_record(ring))
+		return EINVAL;
+
+	rc = inet_shmring_space(ring, size, &pad);
+	if (rc != EOK)
+		return rc;
+
+	off = ring->pos & (ring->size - 1);
+	if (pad > 0) {
+		rec = (inet_shmring_rec_t *) (ring->data + off);
+		rec->size = pad - sizeof(inet_shmring_rec_t);
+		rec->flags = INET_SHMRING_REC_PAD;
+		off = 0;
+	}
+
+	ring->pending_off = off;
+	ring->pending_pad = pad;
+	*rbuf = ring->data + off + sizeof(inet_shmring_rec_t);
+	return EOK;
+}
+
+/** Publish reserved record.
+ *
+ * @param ring Ring (producer side)
+ * @param size Actual payload size (at most the reserved size)
+ */
+void inet_shmring_commit(inet_shmring_t *ring, size_t size)
+{
+	inet_shmring_rec_t *rec;
+
+	rec = (inet_shmring_rec_t *) (ring->data + ring->pending_off);
+	rec->size = size;
+	rec->flags = 0;
+
+	ring->pos += ring->pending_pad + inet_shmring_rec_total(size);
+
+	/* Make the record visible before the new head */
+	write_barrier();
+	ACCESS_ONCE(ring->hdr->head) = ring->pos;
+}
+
+/** Write record consisting of a header and data.
+ *
+ * @param ring Ring (producer side)
+ * @param hdr Record header
+ * @param hdr_size Record header size
+ * @param data Data
+ * @param size Data size
+ * @return EOK on success, ENOSPC if the ring is currently full,
+ *         EINVAL if the record would never fit, EIO if the consumer
+ *         corrupted the ring
+ */
+errno_t inet_shmring_write(inet_shmring_t *ring, const void *hdr,
+    size_t hdr_size, const void *data, size_t size)
+{
+	void *buf;
+	errno_t rc;
+
+	rc = inet_shmring_reserve(ring, hdr_size + size, &buf);
+	if (rc != EOK)
+		return rc;
+
+	if (hdr_size > 0)
+		memcpy(buf, hdr, hdr_size);
+	if (size > 0)
+		memcpy((uint8_t *) buf + hdr_size, data, size);
+	inet_shmring_commit(ring, hdr_size + size);
+	return EOK;
+}
+
+/** Determine whether the consumer needs to be notified.
+ *
+ * Called by the producer after publishing one or more records.
+ *
+ * @param ring Ring (producer side)
+ * @return @c true if the caller should ring the doorbell
+ */
+bool inet_shmring_kick_needed(inet_shmring_t *ring)
+{
+	/* Order head update before reading the wait flag */
+	memory_barrier();
+
+	if (ACCESS_ONCE(ring->hdr->cons_wait) == 0)
+		return false;
+
+	ACCESS_ONCE(ring->hdr->cons_wait) = 0;
+	return true;
+}
+
+/** Prepare producer for waiting for space.
+ *
+ * Sets the wait flag so that the consumer rings the doorbell once it
+ * has freed some space.
+ *
+ * @param ring Ring (producer side)
+ * @param size Size of record the producer wants to write
+ * @return @c true if the producer should wait for the doorbell,
+ *         @c false if there is space now
+ */
+bool inet_shmring_prod_wait(inet_shmring_t *ring, size_t size)
+{
+	uint32_t pad;
+
+	ACCESS_ONCE(ring->hdr->prod_wait) = 1;
+	memory_barrier();
+
+	if (inet_shmring_space(ring, size, &pad) == ENOSPC)
+		return true;
+
+	ACCESS_ONCE(ring->hdr->prod_wait) = 0;
+	return false;
+}
+
+/** Count record dropped by the producer because the ring was full.
+ *
+ * @param ring Ring (producer side)
+ */
+void inet_shmring_drop(inet_shmring_t *ring)
+{
+	++ring->hdr->dropped;
+}
+
+/** Get next record.
+ *
+ * The record stays in the ring until inet_shmring_consume() is called.
+ *
+ * @param ring Ring (consumer side)
+ * @param rbuf Place to store pointer to record payload
+ * @param rsize Place to store record payload size
+ * @return EOK on success, ENOENT if the ring is empty, EIO if the
+ *         producer corrupted the ring
+ */
+errno_t inet_shmring_read(inet_shmring_t *ring, void **rbuf, size_t *rsize)
+{
+	inet_shmring_rec_t *rec;
+	uint32_t head;
+	uint32_t avail;
+	uint32_t off;
+	uint32_t size;
+	uint32_t flags;
+	uint32_t total;
+
+	while (true) {
+		head = ACCESS_ONCE(ring->hdr->head);
+		/* Read the record only after seeing the new head */
+		read_barrier();
+
+		avail = head - ring->pos;
+		if (avail == 0)
+			return ENOENT;
+
+		if (avail > ring->size || avail < sizeof(inet_shmring_rec_t))
+			return EIO;
+
+		off = ring->pos & (ring->size - 1);
+		rec = (inet_shmring_rec_t *) (ring->data + off);
+		size = ACCESS_ONCE(rec->size);
+		flags = ACCESS_ONCE(rec->flags);
+
+		if (size > ring->size)
+			return EIO;
+
+		total = inet_shmring_rec_total(size);
+		if (total > avail || off + total > ring->size)
+			return EIO;
+
+		if ((flags & INET_SHMRING_REC_PAD) == 0) {
+			ring->pending_size = total;
+			*rbuf = ring->data + off + sizeof(inet_shmring_rec_t);
+			*rsize = size;
+			return EOK;
+		}
+
+		/* Skip padding */
+		ring->pos += total;
+		write_barrier();
+		ACCESS_ONCE(ring->hdr->tail) = ring->pos;
+	}
+}
+
+/** Remove record returned by inet_shmring_read().
+ *
+ * @param ring Ring (consumer side)
+ */
+void inet_shmring_consume(inet_shmring_t *ring)
+{
+	assert(ring->pending_size > 0);
+
+	ring->pos += ring->pending_size;
+	ring->pending_size = 0;
+
+	/* Finish reading the record before releasing its space */
+	write_barrier();
+	ACCESS_ONCE(ring->hdr->tail) = ring->pos;
+}
+
+/** Determine whether the producer needs to be notified.
+ *
+ * Called by the consumer after consuming one or more records.
+ *
+ * @param ring Ring (consumer side)
+ * @return @c true if the caller should ring the doorbell
+ */
+bool inet_shmring_space_kick_needed(inet_shmring_t *ring)
+{
+	/* Order tail update before reading the wait flag */
+	memory_barrier();
+
+	if (ACCESS_ONCE(ring->hdr->prod_wait) == 0)
+		return false;
+
+	ACCESS_ONCE(ring->hdr->prod_wait) = 0;
+	return true;
+}
+
+/** Prepare consumer for waiting for records.
+ *
+ * Sets the wait flag so that the producer rings the doorbell with
+ * the next record.
+ *
+ * @param ring Ring (consumer side)
+ * @return @c true if the consumer should wait for the doorbell,
+ *         @c false if there are records in the ring
+ */
+bool inet_shmring_cons_wait(inet_shmring_t *ring)
+{
+	ACCESS_ONCE(ring->hdr->cons_wait) = 1;
+	memory_barrier();
+
+	if (ACCESS_ONCE(ring->hdr->head) == ring->pos)
+		return true;
+
+	ACCESS_ONCE(ring->hdr->cons_wait) = 0;
+	return false;
+}
+
+/** @}
+ */
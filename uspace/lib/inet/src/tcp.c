@@ -32,12 +32,16 @@
 /** @file TCP API
  */
 
+#include <as.h>
 #include <errno.h>
 #include <fibril.h>
 #include <inet/endpoint.h>
+#include <inet/shmring.h>
 #include <inet/tcp.h>
 #include <ipc/services.h>
 #include <ipc/tcp.h>
+#include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 
 static void tcp_cb_conn(ipc_call_t *, void *);
@@ -172,6 +176,7 @@ static errno_t tcp_conn_new(tcp_t *tcp, sysarg_t id, tcp_cb_t *cb, void *arg,
 	conn->data_avail = false;
 	fibril_mutex_initialize(&conn->lock);
 	fibril_condvar_initialize(&conn->cv);
+	fibril_mutex_initialize(&conn->ring_lock);
 
 	conn->tcp = tcp;
 	conn->id = id;
@@ -262,6 +267,9 @@ void tcp_conn_destroy(tcp_conn_t *conn)
 	errno_t rc = async_req_1_0(exch, TCP_CONN_DESTROY, conn->id);
 	async_exchange_end(exch);
 
+	if (conn->ring_area != NULL)
+		as_area_destroy(conn->ring_area);
+
 	free(conn);
 	(void) rc;
 }
@@ -439,6 +447,149 @@ errno_t tcp_conn_wait_connected(tcp_conn_t *conn)
 	}
 }
 
+/** Create shared data rings for TCP connection.
+ *
+ * Once the rings are set up, sent data is placed in a ring shared with
+ * the TCP service instead of being passed in an IPC request for each
+ * call, and the service moves received data to the other ring as soon
+ * as it arrives. The peer is only notified when it is idle, so a busy
+ * connection transfers many buffers per IPC round trip.
+ *
+ * Since sending is then asynchronous, an error encountered by the service
+ * while sending is reported by a later call to tcp_conn_send().
+ *
+ * @param conn Connection
+ * @param size Requested size of each ring in bytes
+ * @return EOK on success, EBUSY if the connection already has rings,
+ *         ENOMEM if out of memory or an error code
+ */
+errno_t tcp_conn_ring_create(tcp_conn_t *conn, size_t size)
+{
+	async_exch_t *exch;
+	size_t area_size;
+	void *area;
+	errno_t rc;
+
+	if (conn->ring_area != NULL)
+		return EBUSY;
+
+	area_size = PAGES2SIZE(SIZE2PAGES(2 * inet_shmring_area_size(size)));
+	area = as_area_create(AS_AREA_ANY, area_size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (area == AS_MAP_FAILED)
+		return ENOMEM;
+
+	rc = inet_shmring_init(area, area_size / 2, &conn->tx_ring);
+	if (rc != EOK)
+		goto error;
+
+	rc = inet_shmring_init((uint8_t *) area + area_size / 2,
+	    area_size / 2, &conn->rx_ring);
+	if (rc != EOK)
+		goto error;
+
+	fibril_mutex_lock(&conn->lock);
+	conn->ring_area = area;
+	conn->rx_off = 0;
+	fibril_mutex_unlock(&conn->lock);
+
+	exch = async_exchange_begin(conn->tcp->sess);
+	aid_t req = async_send_1(exch, TCP_CONN_RING_CREATE, conn->id, NULL);
+	rc = async_share_out_start(exch, area, AS_AREA_READ | AS_AREA_WRITE);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		goto error;
+	}
+
+	async_wait_for(req, &rc);
+	if (rc != EOK)
+		goto error;
+
+	return EOK;
+error:
+	fibril_mutex_lock(&conn->lock);
+	conn->ring_area = NULL;
+	fibril_mutex_unlock(&conn->lock);
+	as_area_destroy(area);
+	return rc;
+}
+
+/** Notify TCP service about transmit or receive ring activity.
+ *
+ * Tells the service that there is new data in the transmit ring or new
+ * space in the receive ring.
+ *
+ * @param conn Connection
+ * @param wait @c true to wait until the service has drained the transmit
+ *             ring
+ * @return EOK on success or an error code (including errors encountered
+ *         by the service while sending data from the ring)
+ */
+static errno_t tcp_conn_ring_kick(tcp_conn_t *conn, bool wait)
+{
+	async_exch_t *exch;
+	errno_t rc = EOK;
+
+	exch = async_exchange_begin(conn->tcp->sess);
+	if (wait)
+		rc = async_req_1_0(exch, TCP_CONN_RING_KICK, conn->id);
+	else
+		async_msg_1(exch, TCP_CONN_RING_KICK, conn->id);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
+/** Send data over TCP connection's transmit ring.
+ *
+ * @param conn  Connection
+ * @param data  Data
+ * @param bytes Data size in bytes
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t tcp_conn_ring_send(tcp_conn_t *conn, const void *data,
+    size_t bytes)
+{
+	const uint8_t *dp = data;
+	size_t max_rec;
+	size_t now;
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&conn->ring_lock);
+
+	max_rec = inet_shmring_max_record(&conn->tx_ring);
+	while (bytes > 0) {
+		now = min(bytes, max_rec);
+		rc = inet_shmring_write(&conn->tx_ring, NULL, 0, dp, now);
+		if (rc == ENOSPC) {
+			/* Ring is full, wait for the service to drain it */
+			rc = tcp_conn_ring_kick(conn, true);
+			if (rc != EOK)
+				break;
+			continue;
+		}
+
+		if (rc != EOK)
+			break;
+
+		dp += now;
+		bytes -= now;
+	}
+
+	if (inet_shmring_kick_needed(&conn->tx_ring)) {
+		if (rc == EOK)
+			rc = tcp_conn_ring_kick(conn, false);
+		else
+			(void) tcp_conn_ring_kick(conn, false);
+	}
+
+	fibril_mutex_unlock(&conn->ring_lock);
+	return rc;
+}
+
 /** Send data over TCP connection.
  *
  * @param conn  Connection
@@ -452,6 +603,9 @@ errno_t tcp_conn_send(tcp_conn_t *conn, const void *data, size_t bytes)
 	async_exch_t *exch;
 	errno_t rc;
 
+	if (conn->ring_area != NULL)
+		return tcp_conn_ring_send(conn, data, bytes);
+
 	exch = async_exchange_begin(conn->tcp->sess);
 	aid_t req = async_send_1(exch, TCP_CONN_SEND, conn->id, NULL);
 	rc = async_data_write_start(exch, data, bytes);
@@ -521,6 +675,81 @@ errno_t tcp_conn_reset(tcp_conn_t *conn)
 	return rc;
 }
 
+/** Read received data from connection's receive ring.
+ *
+ * Copy as much data as is available in the receive ring, up to @a bsize
+ * bytes. A zero-size record marks FIN. It is left in the ring so that
+ * all subsequent reads return zero bytes.
+ *
+ * The connection lock must be held.
+ *
+ * @param conn Connection
+ * @param buf  Buffer
+ * @param bsize Buffer size
+ * @param nrecv Place to store actual number of received bytes
+ *
+ * @return EOK on success, EAGAIN if no received data is pending, EIO
+ *         if the service corrupted the ring
+ */
+static errno_t tcp_conn_ring_recv(tcp_conn_t *conn, void *buf, size_t bsize,
+    size_t *nrecv)
+{
+	uint8_t *bp = buf;
+	void *rbuf;
+	size_t rsize;
+	size_t now;
+	size_t n = 0;
+	bool consumed = false;
+	bool fin = false;
+	errno_t rc = EOK;
+
+	while (n < bsize) {
+		rc = inet_shmring_read(&conn->rx_ring, &rbuf, &rsize);
+		if (rc == ENOENT) {
+			/* Only go to sleep if we have nothing to return */
+			if (n > 0)
+				break;
+			if (inet_shmring_cons_wait(&conn->rx_ring)) {
+				/* Service will send TCP_EV_DATA */
+				conn->data_avail = false;
+				break;
+			}
+			continue;
+		}
+
+		if (rc != EOK)
+			break;
+
+		if (rsize == 0) {
+			fin = true;
+			break;
+		}
+
+		now = min(rsize - conn->rx_off, bsize - n);
+		memcpy(bp + n, (uint8_t *) rbuf + conn->rx_off, now);
+		conn->rx_off += now;
+		n += now;
+
+		if (conn->rx_off == rsize) {
+			inet_shmring_consume(&conn->rx_ring);
+			conn->rx_off = 0;
+			consumed = true;
+		}
+	}
+
+	if (consumed && inet_shmring_space_kick_needed(&conn->rx_ring))
+		(void) tcp_conn_ring_kick(conn, false);
+
+	if (rc != EOK && rc != ENOENT)
+		return EIO;
+
+	if (n == 0 && !fin)
+		return EAGAIN;
+
+	*nrecv = n;
+	return EOK;
+}
+
 /** Read received data from connection without blocking.
  *
  * If any received data is pending on the connection, up to @a bsize bytes
@@ -544,6 +773,12 @@ errno_t tcp_conn_recv(tcp_conn_t *conn, void *buf, size_t bsize, size_t *nrecv)
 	ipc_call_t answer;
 
 	fibril_mutex_lock(&conn->lock);
+	if (conn->ring_area != NULL) {
+		errno_t rc = tcp_conn_ring_recv(conn, buf, bsize, nrecv);
+		fibril_mutex_unlock(&conn->lock);
+		return rc;
+	}
+
 	if (!conn->data_avail) {
 		fibril_mutex_unlock(&conn->lock);
 		return EAGAIN;
@@ -594,6 +829,22 @@ errno_t tcp_conn_recv_wait(tcp_conn_t *conn, void *buf, size_t bsize,
 
 again:
 	fibril_mutex_lock(&conn->lock);
+	if (conn->ring_area != NULL) {
+		errno_t rc;
+
+		while (true) {
+			rc = tcp_conn_ring_recv(conn, buf, bsize, nrecv);
+			if (rc != EAGAIN)
+				break;
+
+			while (!conn->data_avail)
+				fibril_condvar_wait(&conn->cv, &conn->lock);
+		}
+
+		fibril_mutex_unlock(&conn->lock);
+		return rc;
+	}
+
 	while (!conn->data_avail) {
 		fibril_condvar_wait(&conn->cv, &conn->lock);
 	}
@@ -32,12 +32,16 @@
 /** @file UDP API
  */
 
+#include <as.h>
 #include <errno.h>
 #include <inet/endpoint.h>
+#include <inet/shmring.h>
 #include <inet/udp.h>
 #include <ipc/services.h>
 #include <ipc/udp.h>
 #include <loc.h>
+#include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 
 static void udp_cb_conn(ipc_call_t *, void *);
@@ -192,6 +196,7 @@ errno_t udp_assoc_create(udp_t *udp, inet_ep2_t *epp, udp_cb_t *cb, void *arg,
 	assoc->id = ipc_get_arg1(&answer);
 	assoc->cb = cb;
 	assoc->cb_arg = arg;
+	fibril_mutex_initialize(&assoc->ring_lock);
 
 	list_append(&assoc->ludp, &udp->assoc);
 	*rassoc = assoc;
@@ -222,6 +227,9 @@ void udp_assoc_destroy(udp_assoc_t *assoc)
 	errno_t rc = async_req_1_0(exch, UDP_ASSOC_DESTROY, assoc->id);
 	async_exchange_end(exch);
 
+	if (assoc->ring_area != NULL)
+		as_area_destroy(assoc->ring_area);
+
 	free(assoc);
 	(void) rc;
 }
@@ -242,6 +250,141 @@ errno_t udp_assoc_set_nolocal(udp_assoc_t *assoc)
 	return rc;
 }
 
+/** Create shared message rings for UDP association.
+ *
+ * Once the rings are set up, sent messages are placed in a ring shared
+ * with the UDP service instead of being passed in an IPC request each,
+ * and received messages are delivered from the other ring. The service
+ * is only notified when it is idle, so a busy association can pass
+ * many messages per IPC round trip.
+ *
+ * Since sending is then asynchronous, udp_assoc_send_msg() does not
+ * report errors encountered by the service while transmitting individual
+ * messages. Messages received while the receive ring is full are dropped.
+ *
+ * @param assoc Association
+ * @param size  Requested size of each ring in bytes
+ * @return EOK on success, EBUSY if the association already has rings,
+ *         ENOMEM if out of memory or an error code
+ */
+errno_t udp_assoc_ring_create(udp_assoc_t *assoc, size_t size)
+{
+	async_exch_t *exch;
+	size_t area_size;
+	void *area;
+	errno_t rc;
+
+	if (assoc->ring_area != NULL)
+		return EBUSY;
+
+	area_size = PAGES2SIZE(SIZE2PAGES(2 * inet_shmring_area_size(size)));
+	area = as_area_create(AS_AREA_ANY, area_size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (area == AS_MAP_FAILED)
+		return ENOMEM;
+
+	rc = inet_shmring_init(area, area_size / 2, &assoc->tx_ring);
+	if (rc != EOK)
+		goto error;
+
+	rc = inet_shmring_init((uint8_t *) area + area_size / 2,
+	    area_size / 2, &assoc->rx_ring);
+	if (rc != EOK)
+		goto error;
+
+	/* The service may post UDP_EV_RING before answering */
+	assoc->ring_area = area;
+
+	exch = async_exchange_begin(assoc->udp->sess);
+	aid_t req = async_send_1(exch, UDP_ASSOC_RING_CREATE, assoc->id, NULL);
+	rc = async_share_out_start(exch, area, AS_AREA_READ | AS_AREA_WRITE);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		goto error;
+	}
+
+	async_wait_for(req, &rc);
+	if (rc != EOK)
+		goto error;
+
+	return EOK;
+error:
+	assoc->ring_area = NULL;
+	as_area_destroy(area);
+	return rc;
+}
+
+/** Notify UDP service that there are messages in the transmit ring.
+ *
+ * @param assoc Association
+ * @param wait  @c true to wait until the service has drained the ring
+ * @return EOK on success or an error code
+ */
+static errno_t udp_assoc_ring_kick(udp_assoc_t *assoc, bool wait)
+{
+	async_exch_t *exch;
+	errno_t rc = EOK;
+
+	exch = async_exchange_begin(assoc->udp->sess);
+	if (wait)
+		rc = async_req_1_0(exch, UDP_ASSOC_RING_KICK, assoc->id);
+	else
+		async_msg_1(exch, UDP_ASSOC_RING_KICK, assoc->id);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
+/** Send message via UDP association's transmit ring.
+ *
+ * @param assoc Association
+ * @param dest  Destination endpoint
+ * @param data  Message data
+ * @param bytes Message size in bytes
+ *
+ * @return EOK on success, EINVAL if the message does not fit in the ring
+ *         or an error code
+ */
+static errno_t udp_assoc_ring_send(udp_assoc_t *assoc, inet_ep_t *dest,
+    void *data, size_t bytes)
+{
+	udp_ring_msg_t hdr;
+	errno_t rc;
+
+	hdr.ep = *dest;
+
+	fibril_mutex_lock(&assoc->ring_lock);
+
+	while (true) {
+		rc = inet_shmring_write(&assoc->tx_ring, &hdr, sizeof(hdr),
+		    data, bytes);
+		if (rc != ENOSPC)
+			break;
+
+		/* Ring is full, wait for the service to drain it */
+		rc = udp_assoc_ring_kick(assoc, true);
+		if (rc != EOK)
+			break;
+	}
+
+	if (rc == EOK && inet_shmring_kick_needed(&assoc->tx_ring))
+		rc = udp_assoc_ring_kick(assoc, false);
+
+	if (rc == EINVAL) {
+		/*
+		 * Message is too large for the ring. Flush the ring
+		 * so that messages leave in order and let the caller
+		 * send it via IPC.
+		 */
+		(void) udp_assoc_ring_kick(assoc, true);
+	}
+
+	fibril_mutex_unlock(&assoc->ring_lock);
+	return rc;
+}
+
 /** Send message via UDP association.
  *
  * @param assoc Association
@@ -256,9 +399,7 @@ errno_t udp_assoc_send_msg(udp_assoc_t *assoc, inet_ep_t *dest, void *data,
 {
 	async_exch_t *exch;
 	inet_ep_t ddest;
-
-	exch = async_exchange_begin(assoc->udp->sess);
-	aid_t req = async_send_1(exch, UDP_ASSOC_SEND_MSG, assoc->id, NULL);
+	errno_t rc;
 
 	/* If dest is null, use default destination */
 	if (dest == NULL) {
@@ -266,7 +407,16 @@ errno_t udp_assoc_send_msg(udp_assoc_t *assoc, inet_ep_t *dest, void *data,
 		dest = &ddest;
 	}
 
-	errno_t rc = async_data_write_start(exch, (void *)dest,
+	if (assoc->ring_area != NULL) {
+		rc = udp_assoc_ring_send(assoc, dest, data, bytes);
+		if (rc != EINVAL)
+			return rc;
+	}
+
+	exch = async_exchange_begin(assoc->udp->sess);
+	aid_t req = async_send_1(exch, UDP_ASSOC_SEND_MSG, assoc->id, NULL);
+
+	rc = async_data_write_start(exch, (void *)dest,
 	    sizeof(inet_ep_t));
 	if (rc != EOK) {
 		async_exchange_end(exch);
@@ -329,6 +479,16 @@ errno_t udp_rmsg_read(udp_rmsg_t *rmsg, size_t off, void *buf, size_t bsize)
 	async_exch_t *exch;
 	ipc_call_t answer;
 
+	if (rmsg->data != NULL) {
+		/* Message is in the receive ring */
+		if (off > rmsg->size)
+			return EINVAL;
+
+		memcpy(buf, (const uint8_t *) rmsg->data + off,
+		    min(rmsg->size - off, bsize));
+		return EOK;
+	}
+
 	exch = async_exchange_begin(rmsg->udp->sess);
 	aid_t req = async_send_1(exch, UDP_RMSG_READ, off, &answer);
 	errno_t rc = async_data_read_start(exch, buf, bsize);
@@ -413,6 +573,7 @@ static errno_t udp_rmsg_info(udp_t *udp, udp_rmsg_t *rmsg)
 	rmsg->assoc_id = ipc_get_arg1(&answer);
 	rmsg->size = ipc_get_arg2(&answer);
 	rmsg->remote_ep = ep;
+	rmsg->data = NULL;
 	return EOK;
 }
 
@@ -490,6 +651,60 @@ static void udp_ev_data(udp_t *udp, ipc_call_t *icall)
 	async_answer_0(icall, EOK);
 }
 
+/** Handle 'ring' event, i.e. some message(s) arrived in receive ring.
+ *
+ * Call @c recv_msg callback for each message in the ring until the ring
+ * is empty.
+ *
+ * @param udp   UDP client
+ * @param icall IPC message
+ *
+ */
+static void udp_ev_ring(udp_t *udp, ipc_call_t *icall)
+{
+	udp_rmsg_t rmsg;
+	udp_ring_msg_t hdr;
+	udp_assoc_t *assoc;
+	void *buf;
+	size_t size;
+	errno_t rc;
+
+	rc = udp_assoc_get(udp, ipc_get_arg1(icall), &assoc);
+	if (rc != EOK || assoc->ring_area == NULL) {
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	while (true) {
+		rc = inet_shmring_read(&assoc->rx_ring, &buf, &size);
+		if (rc == ENOENT) {
+			if (inet_shmring_cons_wait(&assoc->rx_ring))
+				break;
+			continue;
+		}
+
+		if (rc != EOK)
+			break;
+
+		if (size >= sizeof(hdr)) {
+			memcpy(&hdr, buf, sizeof(hdr));
+
+			rmsg.udp = udp;
+			rmsg.assoc_id = assoc->id;
+			rmsg.size = size - sizeof(hdr);
+			rmsg.remote_ep = hdr.ep;
+			rmsg.data = (uint8_t *) buf + sizeof(hdr);
+
+			if (assoc->cb != NULL && assoc->cb->recv_msg != NULL)
+				assoc->cb->recv_msg(assoc, &rmsg);
+		}
+
+		inet_shmring_consume(&assoc->rx_ring);
+	}
+
+	async_answer_0(icall, rc == ENOENT ? EOK : rc);
+}
+
 /** UDP service callback connection.
  *
  * @param icall Connect message
@@ -514,6 +729,9 @@ static void udp_cb_conn(ipc_call_t *icall, void *arg)
 		case UDP_EV_DATA:
 			udp_ev_data(udp, &call);
 			break;
+		case UDP_EV_RING:
+			udp_ev_ring(udp, &call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 			break;
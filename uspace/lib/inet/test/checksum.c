@@ -0,0 +1,138 @@
+#include <inet/checksum.h>
+#include <pcut/pcut.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(checksum);
+
+/** Simple reference implementation of the Internet checksum */
+static uint16_t ref_checksum_calc(uint16_t ivalue, const uint8_t *data,
+    size_t size)
+{
+	uint32_t sum;
+	size_t i;
+
+	sum = (uint16_t) ~ivalue;
+	for (i = 0; i < size; i++) {
+		if (i % 2 == 0)
+			sum += (uint32_t) data[i] << 8;
+		else
+			sum += data[i];
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+
+	return ~sum;
+}
+
+/** Checksum of an example IPv4 header */
+PCUT_TEST(ipv4_header)
+{
+	uint8_t hdr[] = {
+		0x45, 0x00, 0x00, 0x73, 0x00, 0x00, 0x40, 0x00,
+		0x40, 0x11, 0x00, 0x00, 0xc0, 0xa8, 0x00, 0x01,
+		0xc0, 0xa8, 0x00, 0xc7
+	};
+
+	PCUT_ASSERT_INT_EQUALS(0xb861, inet_checksum_calc(INET_CHECKSUM_INIT,
+	    hdr, sizeof(hdr)));
+
+	/* Header including correct checksum sums up to zero */
+	hdr[10] = 0xb8;
+	hdr[11] = 0x61;
+	PCUT_ASSERT_INT_EQUALS(0, inet_checksum_calc(INET_CHECKSUM_INIT,
+	    hdr, sizeof(hdr)));
+}
+
+/** Checksum of empty and all-zero data */
+PCUT_TEST(zero)
+{
+	uint8_t data[8] = { 0 };
+
+	PCUT_ASSERT_INT_EQUALS(0xffff, inet_checksum_calc(INET_CHECKSUM_INIT,
+	    data, 0));
+	PCUT_ASSERT_INT_EQUALS(0xffff, inet_checksum_calc(INET_CHECKSUM_INIT,
+	    data, sizeof(data)));
+}
+
+/** Checksum matches reference for all alignments and many sizes */
+PCUT_TEST(alignment_size)
+{
+	uint8_t *buf;
+	size_t bsize = 4096 + 16;
+	size_t offs;
+	size_t size;
+	size_t i;
+
+	buf = malloc(bsize);
+	PCUT_ASSERT_NOT_NULL(buf);
+
+	for (i = 0; i < bsize; i++)
+		buf[i] = (i * 7 + 13) ^ (i >> 3);
+
+	for (offs = 0; offs < 16; offs++) {
+		for (size = 0; size <= 4096; size += (size < 128) ? 1 : 61) {
+			PCUT_ASSERT_INT_EQUALS(ref_checksum_calc(0x1234,
+			    buf + offs, size), inet_checksum_calc(0x1234,
+			    buf + offs, size));
+		}
+	}
+
+	/* All ones exercise carry propagation */
+	for (i = 0; i < bsize; i++)
+		buf[i] = 0xff;
+
+	for (offs = 0; offs < 4; offs++) {
+		PCUT_ASSERT_INT_EQUALS(ref_checksum_calc(INET_CHECKSUM_INIT,
+		    buf + offs, 4096), inet_checksum_calc(INET_CHECKSUM_INIT,
+		    buf + offs, 4096));
+	}
+
+	free(buf);
+}
+
+/** Checksum can be computed over several buffers */
+PCUT_TEST(chained)
+{
+	uint8_t data[] = {
+		0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09
+	};
+	uint16_t cs;
+
+	cs = inet_checksum_calc(INET_CHECKSUM_INIT, data, 4);
+	cs = inet_checksum_calc(cs, data + 4, sizeof(data) - 4);
+
+	PCUT_ASSERT_INT_EQUALS(inet_checksum_calc(INET_CHECKSUM_INIT, data,
+	    sizeof(data)), cs);
+}
+
+/** Incremental update gives the same result as recomputation */
+PCUT_TEST(update)
+{
+	uint8_t hdr[] = {
+		0x45, 0x00, 0x00, 0x73, 0x00, 0x00, 0x40, 0x00,
+		0x40, 0x11, 0x00, 0x00, 0xc0, 0xa8, 0x00, 0x01,
+		0xc0, 0xa8, 0x00, 0xc7
+	};
+	uint16_t cs;
+
+	cs = inet_checksum_calc(INET_CHECKSUM_INIT, hdr, sizeof(hdr));
+
+	/* Decrement TTL */
+	cs = inet_checksum_update16(cs, 0x4011, 0x3f11);
+	hdr[8] = 0x3f;
+	PCUT_ASSERT_INT_EQUALS(inet_checksum_calc(INET_CHECKSUM_INIT, hdr,
+	    sizeof(hdr)), cs);
+
+	/* Rewrite destination address */
+	cs = inet_checksum_update32(cs, 0xc0a800c7, 0x0a000002);
+	hdr[16] = 0x0a;
+	hdr[17] = 0x00;
+	hdr[18] = 0x00;
+	hdr[19] = 0x02;
+	PCUT_ASSERT_INT_EQUALS(inet_checksum_calc(INET_CHECKSUM_INIT, hdr,
+	    sizeof(hdr)), cs);
+}
+
+PCUT_EXPORT(checksum);
@@ -0,0 +1,235 @@
+#include <inet/addr.h>
+#include <inet/lpm.h>
+#include <pcut/pcut.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(lpm);
+
+/** Values stored in the table */
+static int val[8];
+
+static void naddr4(inet_naddr_t *naddr, uint8_t a, uint8_t b, uint8_t c,
+    uint8_t d, uint8_t prefix)
+{
+	inet_naddr(naddr, a, b, c, d, prefix);
+}
+
+static void *lookup4(inet_lpm_t *lpm, uint8_t a, uint8_t b, uint8_t c,
+    uint8_t d)
+{
+	inet_addr_t addr;
+
+	inet_addr(&addr, a, b, c, d);
+	return inet_lpm_lookup(lpm, &addr);
+}
+
+/** Lookup in empty table */
+PCUT_TEST(empty)
+{
+	inet_lpm_t lpm;
+	inet_addr_t addr;
+
+	inet_lpm_initialize(&lpm);
+
+	inet_addr(&addr, 10, 0, 0, 1);
+	PCUT_ASSERT_NULL(inet_lpm_lookup(&lpm, &addr));
+	inet_addr6(&addr, 0xfe80, 0, 0, 0, 0, 0, 0, 1);
+	PCUT_ASSERT_NULL(inet_lpm_lookup(&lpm, &addr));
+
+	inet_lpm_finalize(&lpm);
+}
+
+/** Most specific prefix wins */
+PCUT_TEST(longest_match)
+{
+	inet_lpm_t lpm;
+	inet_naddr_t naddr;
+	errno_t rc;
+
+	inet_lpm_initialize(&lpm);
+
+	naddr4(&naddr, 0, 0, 0, 0, 0);
+	rc = inet_lpm_insert(&lpm, &naddr, &val[0]);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	naddr4(&naddr, 10, 0, 0, 0, 8);
+	rc = inet_lpm_insert(&lpm, &naddr, &val[1]);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Host bits are ignored */
+	naddr4(&naddr, 10, 1, 2, 3, 16);
+	rc = inet_lpm_insert(&lpm, &naddr, &val[2]);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	naddr4(&naddr, 10, 1, 128, 0, 17);
+	rc = inet_lpm_insert(&lpm, &naddr, &val[3]);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	naddr4(&naddr, 10, 1, 0, 0, 16);
+	rc = inet_lpm_insert(&lpm, &naddr, &val[4]);
+	PCUT_ASSERT_ERRNO_VAL(EEXIST, rc);
+
+	PCUT_ASSERT_INT_EQUALS(4, lpm.count);
+
+	PCUT_ASSERT_EQUALS(&val[0], lookup4(&lpm, 192, 168, 0, 1));
+	PCUT_ASSERT_EQUALS(&val[1], lookup4(&lpm, 10, 2, 0, 1));
+	PCUT_ASSERT_EQUALS(&val[2], lookup4(&lpm, 10, 1, 127, 255));
+	PCUT_ASSERT_EQUALS(&val[3], lookup4(&lpm, 10, 1, 128, 0));
+
+	naddr4(&naddr, 10, 1, 0, 0, 16);
+	PCUT_ASSERT_EQUALS(&val[2], inet_lpm_find(&lpm, &naddr));
+	naddr4(&naddr, 10, 1, 0, 0, 15);
+	PCUT_ASSERT_NULL(inet_lpm_find(&lpm, &naddr));
+
+	inet_lpm_finalize(&lpm);
+}
+
+/** Removing prefixes */
+PCUT_TEST(remove)
+{
+	inet_lpm_t lpm;
+	inet_naddr_t naddr;
+	errno_t rc;
+
+	inet_lpm_initialize(&lpm);
+
+	naddr4(&naddr, 10, 0, 0, 0, 8);
+	rc = inet_lpm_insert(&lpm, &naddr, &val[0]);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* These two create a glue node at 10.1.0.0/23 */
+	naddr4(&naddr, 10, 1, 0, 0, 24);
+	rc = inet_lpm_insert(&lpm, &naddr, &val[1]);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	naddr4(&naddr, 10, 1, 1, 0, 24);
+	rc = inet_lpm_insert(&lpm, &naddr, &val[2]);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Warm up the cache */
+	PCUT_ASSERT_EQUALS(&val[1], lookup4(&lpm, 10, 1, 0, 1));
+
+	naddr4(&naddr, 10, 1, 0, 0, 23);
+	rc = inet_lpm_remove(&lpm, &naddr);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	naddr4(&naddr, 10, 1, 0, 0, 24);
+	rc = inet_lpm_remove(&lpm, &naddr);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = inet_lpm_remove(&lpm, &naddr);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	PCUT_ASSERT_EQUALS(&val[0], lookup4(&lpm, 10, 1, 0, 1));
+	PCUT_ASSERT_EQUALS(&val[2], lookup4(&lpm, 10, 1, 1, 1));
+
+	naddr4(&naddr, 10, 0, 0, 0, 8);
+	rc = inet_lpm_remove(&lpm, &naddr);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	PCUT_ASSERT_NULL(lookup4(&lpm, 10, 1, 0, 1));
+	PCUT_ASSERT_EQUALS(&val[2], lookup4(&lpm, 10, 1, 1, 1));
+
+	naddr4(&naddr, 10, 1, 1, 0, 24);
+	rc = inet_lpm_remove(&lpm, &naddr);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	PCUT_ASSERT_INT_EQUALS(0, lpm.count);
+	PCUT_ASSERT_NULL(lpm.root4);
+
+	inet_lpm_finalize(&lpm);
+}
+
+/** IPv6 prefixes are kept apart from IPv4 */
+PCUT_TEST(ipv6)
+{
+	inet_lpm_t lpm;
+	inet_naddr_t naddr;
+	inet_addr_t addr;
+	errno_t rc;
+
+	inet_lpm_initialize(&lpm);
+
+	naddr4(&naddr, 0, 0, 0, 0, 0);
+	rc = inet_lpm_insert(&lpm, &naddr, &val[0]);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_naddr6(&naddr, 0x2001, 0xdb8, 0, 0, 0, 0, 0, 0, 32);
+	rc = inet_lpm_insert(&lpm, &naddr, &val[1]);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_naddr6(&naddr, 0x2001, 0xdb8, 0, 0, 0, 0, 0, 1, 128);
+	rc = inet_lpm_insert(&lpm, &naddr, &val[2]);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_naddr6(&naddr, 0x2001, 0xdb8, 0, 0, 0, 0, 0, 0, 129);
+	rc = inet_lpm_insert(&lpm, &naddr, &val[3]);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+
+	inet_addr6(&addr, 0x2001, 0xdb8, 0, 0, 0, 0, 0, 1);
+	PCUT_ASSERT_EQUALS(&val[2], inet_lpm_lookup(&lpm, &addr));
+	inet_addr6(&addr, 0x2001, 0xdb8, 0, 0, 0, 0, 0, 2);
+	PCUT_ASSERT_EQUALS(&val[1], inet_lpm_lookup(&lpm, &addr));
+	inet_addr6(&addr, 0x2001, 0xdb9, 0, 0, 0, 0, 0, 1);
+	PCUT_ASSERT_NULL(inet_lpm_lookup(&lpm, &addr));
+
+	inet_lpm_finalize(&lpm);
+}
+
+/** Compare against linear search on random prefixes */
+PCUT_TEST(random)
+{
+	inet_lpm_t lpm;
+	inet_naddr_t pfx[200];
+	bool present[200];
+	inet_addr_t addr;
+	unsigned i, j, k;
+	int best;
+	errno_t rc;
+
+	inet_lpm_initialize(&lpm);
+	srand(1);
+
+	for (i = 0; i < 200; i++) {
+		/* Few distinct high bits so that prefixes nest */
+		naddr4(&pfx[i], 10, rand() % 4, rand() % 4, rand() % 256,
+		    8 + rand() % 25);
+		present[i] = inet_lpm_insert(&lpm, &pfx[i], &pfx[i]) == EOK;
+	}
+
+	for (k = 0; k < 2; k++) {
+		for (j = 0; j < 2000; j++) {
+			inet_addr(&addr, 10, rand() % 4, rand() % 4,
+			    rand() % 256);
+
+			best = -1;
+			for (i = 0; i < 200; i++) {
+				if (present[i] &&
+				    inet_naddr_compare_mask(&pfx[i], &addr) &&
+				    (best < 0 || pfx[i].prefix > pfx[best].prefix))
+					best = i;
+			}
+
+			if (best < 0)
+				PCUT_ASSERT_NULL(inet_lpm_lookup(&lpm, &addr));
+			else
+				PCUT_ASSERT_EQUALS(&pfx[best],
+				    inet_lpm_lookup(&lpm, &addr));
+		}
+
+		/* Remove half of the prefixes and try again */
+		for (i = 0; i < 200; i += 2) {
+			if (present[i]) {
+				rc = inet_lpm_remove(&lpm, &pfx[i]);
+				PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+				present[i] = false;
+			}
+		}
+	}
+
+	inet_lpm_finalize(&lpm);
+}
+
+PCUT_EXPORT(lpm);
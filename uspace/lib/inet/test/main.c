@@ -30,6 +30,10 @@
 
 PCUT_INIT;
 
+PCUT_IMPORT(checksum);
 PCUT_IMPORT(eth_addr);
+PCUT_IMPORT(lpm);
+PCUT_IMPORT(nbcache);
+PCUT_IMPORT(shmring);
 
 PCUT_MAIN();
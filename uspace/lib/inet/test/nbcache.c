@@ -0,0 +1,355 @@
+#include <errno.h>
+#include <inet/addr.h>
+#include <inet/eth_addr.h>
+#include <inet/nbcache.h>
+#include <pcut/pcut.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(nbcache);
+
+static errno_t test_solicit(void *, const inet_addr_t *, const inet_addr_t *,
+    const eth_addr_t *);
+static void test_xmit(void *, const eth_addr_t *);
+static void test_discard(void *);
+
+static inet_nbcache_ops_t test_ops = {
+	.solicit = test_solicit,
+	.xmit = test_xmit,
+	.discard = test_discard
+};
+
+/** Recorded calls to neighbour cache operations */
+static struct {
+	/** Number of broadcast solicitations */
+	unsigned bcast;
+	/** Number of unicast solicitations */
+	unsigned ucast;
+	/** Last solicitation target */
+	inet_addr_t target;
+	/** Number of transmitted packets */
+	unsigned xmit;
+	/** Link-layer address of last transmitted packet */
+	eth_addr_t xmit_mac;
+	/** Number of discarded packets */
+	unsigned discard;
+} calls;
+
+/** Dummy link */
+static int test_link;
+
+/** Packets */
+static int pkt[8];
+
+static const eth_addr_t test_mac = ETH_ADDR_INITIALIZER(0x02, 0, 0, 0, 0, 1);
+
+static void test_reset(void)
+{
+	calls.bcast = 0;
+	calls.ucast = 0;
+	calls.xmit = 0;
+	calls.discard = 0;
+}
+
+/** Resolve, queue a packet and answer */
+PCUT_TEST(resolve_queue_update)
+{
+	inet_nbcache_t *nb;
+	inet_nbcache_stats_t stats;
+	inet_addr_t src;
+	inet_addr_t addr;
+	eth_addr_t mac;
+	errno_t rc;
+
+	test_reset();
+	rc = inet_nbcache_create(16, &test_ops, &nb);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_addr(&src, 10, 0, 0, 1);
+	inet_addr(&addr, 10, 0, 0, 2);
+
+	/* Not queued if there is no entry */
+	rc = inet_nbcache_enqueue(nb, &addr, &pkt[0], &mac);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	rc = inet_nbcache_resolve(nb, &test_link, &src, &addr, 0, &mac);
+	PCUT_ASSERT_ERRNO_VAL(EINPROGRESS, rc);
+	PCUT_ASSERT_INT_EQUALS(1, calls.bcast);
+	PCUT_ASSERT_TRUE(inet_addr_compare(&addr, &calls.target));
+
+	rc = inet_nbcache_enqueue(nb, &addr, &pkt[0], &mac);
+	PCUT_ASSERT_ERRNO_VAL(EINPROGRESS, rc);
+
+	/* Second lookup does not send another solicitation */
+	rc = inet_nbcache_resolve(nb, &test_link, &src, &addr, 10, &mac);
+	PCUT_ASSERT_ERRNO_VAL(EINPROGRESS, rc);
+	PCUT_ASSERT_INT_EQUALS(1, calls.bcast);
+
+	rc = inet_nbcache_enqueue(nb, &addr, &pkt[1], &mac);
+	PCUT_ASSERT_ERRNO_VAL(EINPROGRESS, rc);
+
+	rc = inet_nbcache_update(nb, &addr, &test_mac, 20);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(2, calls.xmit);
+	PCUT_ASSERT_INT_EQUALS(0, eth_addr_compare(&test_mac, &calls.xmit_mac));
+
+	rc = inet_nbcache_resolve(nb, &test_link, &src, &addr, 30, &mac);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(0, eth_addr_compare(&test_mac, &mac));
+
+	/* Resolved in the meantime */
+	rc = inet_nbcache_enqueue(nb, &addr, &pkt[2], &mac);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_nbcache_get_stats(nb, &stats);
+	PCUT_ASSERT_INT_EQUALS(1, stats.entries);
+	PCUT_ASSERT_INT_EQUALS(1, stats.hits);
+	PCUT_ASSERT_INT_EQUALS(2, stats.misses);
+	PCUT_ASSERT_INT_EQUALS(1, stats.solicits);
+	PCUT_ASSERT_INT_EQUALS(1, stats.confirms);
+	PCUT_ASSERT_INT_EQUALS(2, stats.queued);
+
+	inet_nbcache_destroy(nb);
+	PCUT_ASSERT_INT_EQUALS(0, calls.discard);
+}
+
+/** Queue overflow drops oldest packets */
+PCUT_TEST(queue_overflow)
+{
+	inet_nbcache_t *nb;
+	inet_nbcache_stats_t stats;
+	inet_addr_t src;
+	inet_addr_t addr;
+	eth_addr_t mac;
+	unsigned i;
+	errno_t rc;
+
+	test_reset();
+	rc = inet_nbcache_create(16, &test_ops, &nb);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_addr(&src, 10, 0, 0, 1);
+	inet_addr(&addr, 10, 0, 0, 2);
+
+	rc = inet_nbcache_resolve(nb, &test_link, &src, &addr, 0, &mac);
+	PCUT_ASSERT_ERRNO_VAL(EINPROGRESS, rc);
+
+	for (i = 0; i < INET_NB_QUEUE_MAX + 2; i++) {
+		rc = inet_nbcache_enqueue(nb, &addr, &pkt[i], &mac);
+		PCUT_ASSERT_ERRNO_VAL(EINPROGRESS, rc);
+	}
+
+	PCUT_ASSERT_INT_EQUALS(2, calls.discard);
+
+	rc = inet_nbcache_update(nb, &addr, &test_mac, 10);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(INET_NB_QUEUE_MAX, calls.xmit);
+
+	inet_nbcache_get_stats(nb, &stats);
+	PCUT_ASSERT_INT_EQUALS(2, stats.dropped);
+
+	inet_nbcache_destroy(nb);
+}
+
+/** Resolution fails after several solicitations */
+PCUT_TEST(resolve_fail)
+{
+	inet_nbcache_t *nb;
+	inet_nbcache_stats_t stats;
+	inet_addr_t src;
+	inet_addr_t addr;
+	eth_addr_t mac;
+	usec_t now;
+	errno_t rc;
+
+	test_reset();
+	rc = inet_nbcache_create(16, &test_ops, &nb);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_addr6(&src, 0xfe80, 0, 0, 0, 0, 0, 0, 1);
+	inet_addr6(&addr, 0xfe80, 0, 0, 0, 0, 0, 0, 2);
+
+	rc = inet_nbcache_resolve(nb, &test_link, &src, &addr, 0, &mac);
+	PCUT_ASSERT_ERRNO_VAL(EINPROGRESS, rc);
+	rc = inet_nbcache_enqueue(nb, &addr, &pkt[0], &mac);
+	PCUT_ASSERT_ERRNO_VAL(EINPROGRESS, rc);
+
+	for (now = 0; now <= INET_NB_MAX_SOLICIT * INET_NB_RETRANS_TIME;
+	    now += INET_NB_TICK) {
+		inet_nbcache_tick(nb, now);
+	}
+
+	PCUT_ASSERT_INT_EQUALS(INET_NB_MAX_SOLICIT, calls.bcast);
+	PCUT_ASSERT_INT_EQUALS(1, calls.discard);
+	PCUT_ASSERT_INT_EQUALS(0, calls.xmit);
+
+	/* Entry was removed */
+	rc = inet_nbcache_remove(nb, &addr);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	inet_nbcache_get_stats(nb, &stats);
+	PCUT_ASSERT_INT_EQUALS(0, stats.entries);
+	PCUT_ASSERT_INT_EQUALS(1, stats.failures);
+
+	inet_nbcache_destroy(nb);
+}
+
+/** Entry in use is refreshed before it goes stale */
+PCUT_TEST(refresh)
+{
+	inet_nbcache_t *nb;
+	inet_addr_t src;
+	inet_addr_t addr;
+	eth_addr_t mac;
+	usec_t now;
+	errno_t rc;
+
+	test_reset();
+	rc = inet_nbcache_create(16, &test_ops, &nb);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_addr(&src, 10, 0, 0, 1);
+	inet_addr(&addr, 10, 0, 0, 2);
+
+	rc = inet_nbcache_resolve(nb, &test_link, &src, &addr, 0, &mac);
+	PCUT_ASSERT_ERRNO_VAL(EINPROGRESS, rc);
+	rc = inet_nbcache_update(nb, &addr, &test_mac, 0);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Use the entry */
+	rc = inet_nbcache_resolve(nb, &test_link, &src, &addr, 1, &mac);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	now = INET_NB_REACHABLE_TIME - INET_NB_REFRESH_LEAD - 1;
+	inet_nbcache_tick(nb, now);
+	PCUT_ASSERT_INT_EQUALS(0, calls.ucast);
+
+	now = INET_NB_REACHABLE_TIME - INET_NB_REFRESH_LEAD;
+	inet_nbcache_tick(nb, now);
+	PCUT_ASSERT_INT_EQUALS(1, calls.ucast);
+
+	/* Entry can still be used while it is being probed */
+	rc = inet_nbcache_resolve(nb, &test_link, &src, &addr, now, &mac);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = inet_nbcache_update(nb, &addr, &test_mac, now + 1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Not used since confirmation, goes stale without probing */
+	now += 1 + INET_NB_REACHABLE_TIME;
+	inet_nbcache_tick(nb, now);
+	PCUT_ASSERT_INT_EQUALS(1, calls.ucast);
+
+	/* Using stale entry starts a probe */
+	rc = inet_nbcache_resolve(nb, &test_link, &src, &addr, now, &mac);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(2, calls.ucast);
+	PCUT_ASSERT_INT_EQUALS(1, calls.bcast);
+
+	inet_nbcache_destroy(nb);
+}
+
+/** Unused stale entries are removed */
+PCUT_TEST(expire)
+{
+	inet_nbcache_t *nb;
+	inet_nbcache_stats_t stats;
+	inet_addr_t addr;
+	errno_t rc;
+
+	test_reset();
+	rc = inet_nbcache_create(16, &test_ops, &nb);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_addr(&addr, 10, 0, 0, 2);
+
+	rc = inet_nbcache_update(nb, &addr, &test_mac, 0);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_nbcache_tick(nb, INET_NB_REACHABLE_TIME);
+	inet_nbcache_tick(nb, INET_NB_GC_TIME - 1);
+	inet_nbcache_get_stats(nb, &stats);
+	PCUT_ASSERT_INT_EQUALS(1, stats.entries);
+
+	inet_nbcache_tick(nb, INET_NB_GC_TIME);
+	inet_nbcache_get_stats(nb, &stats);
+	PCUT_ASSERT_INT_EQUALS(0, stats.entries);
+	PCUT_ASSERT_INT_EQUALS(1, stats.expirations);
+
+	inet_nbcache_destroy(nb);
+}
+
+/** Least recently used entry is evicted when the cache is full */
+PCUT_TEST(evict)
+{
+	inet_nbcache_t *nb;
+	inet_nbcache_stats_t stats;
+	inet_addr_t src;
+	inet_addr_t addr;
+	eth_addr_t mac;
+	errno_t rc;
+
+	test_reset();
+	rc = inet_nbcache_create(2, &test_ops, &nb);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_addr(&src, 10, 0, 0, 1);
+
+	inet_addr(&addr, 10, 0, 0, 2);
+	rc = inet_nbcache_update(nb, &addr, &test_mac, 0);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	inet_addr(&addr, 10, 0, 0, 3);
+	rc = inet_nbcache_update(nb, &addr, &test_mac, 0);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Touch 10.0.0.2 so that 10.0.0.3 is evicted */
+	inet_addr(&addr, 10, 0, 0, 2);
+	rc = inet_nbcache_resolve(nb, &test_link, &src, &addr, 1, &mac);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_addr(&addr, 10, 0, 0, 4);
+	rc = inet_nbcache_update(nb, &addr, &test_mac, 2);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_addr(&addr, 10, 0, 0, 3);
+	rc = inet_nbcache_remove(nb, &addr);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+	inet_addr(&addr, 10, 0, 0, 2);
+	rc = inet_nbcache_remove(nb, &addr);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_nbcache_get_stats(nb, &stats);
+	PCUT_ASSERT_INT_EQUALS(1, stats.entries);
+	PCUT_ASSERT_INT_EQUALS(1, stats.evictions);
+
+	inet_nbcache_destroy(nb);
+}
+
+static errno_t test_solicit(void *link, const inet_addr_t *src,
+    const inet_addr_t *target, const eth_addr_t *dest)
+{
+	PCUT_ASSERT_EQUALS(&test_link, link);
+
+	if (dest != NULL)
+		++calls.ucast;
+	else
+		++calls.bcast;
+
+	calls.target = *target;
+	return EOK;
+}
+
+static void test_xmit(void *pkt, const eth_addr_t *mac)
+{
+	++calls.xmit;
+	calls.xmit_mac = *mac;
+}
+
+static void test_discard(void *pkt)
+{
+	++calls.discard;
+}
+
+PCUT_EXPORT(nbcache);
@@ -0,0 +1,231 @@
+#include <errno.h>
+#include <inet/shmring.h>
+#include <mem.h>
+#include <pcut/pcut.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(shmring);
+
+/** Size of shared area used by tests */
+#define AREA_SIZE (INET_SHMRING_HDR_SIZE + INET_SHMRING_MIN_SIZE)
+
+/** Shared area used by tests */
+static uint64_t area[AREA_SIZE / sizeof(uint64_t)];
+
+/** Records are read back in order */
+PCUT_TEST(write_read)
+{
+	inet_shmring_t prod;
+	inet_shmring_t cons;
+	char hdr[4] = "hdr";
+	char data[5] = "data";
+	void *buf;
+	size_t size;
+	errno_t rc;
+
+	rc = inet_shmring_init(area, sizeof(area), &prod);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = inet_shmring_attach(area, sizeof(area), &cons);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = inet_shmring_read(&cons, &buf, &size);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	rc = inet_shmring_write(&prod, hdr, sizeof(hdr), data, sizeof(data));
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = inet_shmring_write(&prod, hdr, 0, data, 2);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = inet_shmring_read(&cons, &buf, &size);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(sizeof(hdr) + sizeof(data), size);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(buf, "hdr\0data", size));
+	inet_shmring_consume(&cons);
+
+	rc = inet_shmring_read(&cons, &buf, &size);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(2, size);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(buf, "da", size));
+	inet_shmring_consume(&cons);
+
+	rc = inet_shmring_read(&cons, &buf, &size);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+}
+
+/** Records wrap around the end of the data area and the ring fills up */
+PCUT_TEST(wrap_full)
+{
+	inet_shmring_t prod;
+	inet_shmring_t cons;
+	uint8_t data[100];
+	uint8_t seq_w = 0;
+	uint8_t seq_r = 0;
+	unsigned nfull = 0;
+	unsigned i;
+	void *buf;
+	size_t size;
+	errno_t rc;
+
+	rc = inet_shmring_init(area, sizeof(area), &prod);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = inet_shmring_attach(area, sizeof(area), &cons);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	for (i = 0; i < 200; i++) {
+		/* Write until full, then drain a few */
+		memset(data, seq_w, sizeof(data));
+		rc = inet_shmring_write(&prod, NULL, 0, data,
+		    sizeof(data) - i % 7);
+		if (rc == ENOSPC) {
+			++nfull;
+			PCUT_ASSERT_TRUE(inet_shmring_prod_wait(&prod,
+			    sizeof(data)));
+
+			while (inet_shmring_read(&cons, &buf, &size) == EOK) {
+				PCUT_ASSERT_INT_EQUALS(seq_r,
+				    ((uint8_t *) buf)[size - 1]);
+				++seq_r;
+				inet_shmring_consume(&cons);
+			}
+
+			PCUT_ASSERT_TRUE(inet_shmring_space_kick_needed(&cons));
+			PCUT_ASSERT_FALSE(inet_shmring_space_kick_needed(&cons));
+			continue;
+		}
+
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+		++seq_w;
+	}
+
+	PCUT_ASSERT_TRUE(nfull > 0);
+
+	while (inet_shmring_read(&cons, &buf, &size) == EOK) {
+		PCUT_ASSERT_INT_EQUALS(seq_r, ((uint8_t *) buf)[0]);
+		++seq_r;
+		inet_shmring_consume(&cons);
+	}
+
+	PCUT_ASSERT_INT_EQUALS(seq_w, seq_r);
+}
+
+/** Doorbell is only needed when the consumer waits */
+PCUT_TEST(doorbell)
+{
+	inet_shmring_t prod;
+	inet_shmring_t cons;
+	void *buf;
+	size_t size;
+	errno_t rc;
+
+	rc = inet_shmring_init(area, sizeof(area), &prod);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = inet_shmring_attach(area, sizeof(area), &cons);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Consumer starts idle */
+	rc = inet_shmring_write(&prod, NULL, 0, "a", 1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_TRUE(inet_shmring_kick_needed(&prod));
+
+	/* Consumer is busy */
+	rc = inet_shmring_write(&prod, NULL, 0, "b", 1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_FALSE(inet_shmring_kick_needed(&prod));
+
+	/* Records are pending, consumer must not sleep */
+	PCUT_ASSERT_FALSE(inet_shmring_cons_wait(&cons));
+
+	while (inet_shmring_read(&cons, &buf, &size) == EOK)
+		inet_shmring_consume(&cons);
+
+	PCUT_ASSERT_TRUE(inet_shmring_cons_wait(&cons));
+
+	rc = inet_shmring_write(&prod, NULL, 0, "c", 1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_TRUE(inet_shmring_kick_needed(&prod));
+}
+
+/** Reserved record can be committed shorter */
+PCUT_TEST(reserve_commit)
+{
+	inet_shmring_t prod;
+	inet_shmring_t cons;
+	void *buf;
+	size_t size;
+	errno_t rc;
+
+	rc = inet_shmring_init(area, sizeof(area), &prod);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = inet_shmring_attach(area, sizeof(area), &cons);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = inet_shmring_reserve(&prod, inet_shmring_max_record(&prod) + 1,
+	    &buf);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+
+	rc = inet_shmring_reserve(&prod, 64, &buf);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Not visible before commit */
+	rc = inet_shmring_read(&cons, &buf, &size);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	rc = inet_shmring_reserve(&prod, 64, &buf);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	memcpy(buf, "xyz", 3);
+	inet_shmring_commit(&prod, 3);
+
+	rc = inet_shmring_read(&cons, &buf, &size);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(3, size);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(buf, "xyz", 3));
+}
+
+/** Corrupted ring is detected */
+PCUT_TEST(corrupt)
+{
+	inet_shmring_t prod;
+	inet_shmring_t cons;
+	inet_shmring_hdr_t *hdr = (inet_shmring_hdr_t *) area;
+	void *buf;
+	size_t size;
+	errno_t rc;
+
+	rc = inet_shmring_init(area, sizeof(area), &prod);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = inet_shmring_attach(area, sizeof(area), &cons);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Head too far ahead */
+	hdr->head = INET_SHMRING_MIN_SIZE + 8;
+	rc = inet_shmring_read(&cons, &buf, &size);
+	PCUT_ASSERT_ERRNO_VAL(EIO, rc);
+
+	/* Record larger than published data */
+	hdr->head = 16;
+	*(uint32_t *) ((uint8_t *) area + INET_SHMRING_HDR_SIZE) = 100;
+	rc = inet_shmring_read(&cons, &buf, &size);
+	PCUT_ASSERT_ERRNO_VAL(EIO, rc);
+
+	/* Tail ahead of head */
+	hdr->tail = 8;
+	rc = inet_shmring_write(&prod, NULL, 0, "a", 1);
+	PCUT_ASSERT_ERRNO_VAL(EIO, rc);
+
+	/* Bad magic */
+	hdr->magic = 0;
+	rc = inet_shmring_attach(area, sizeof(area), &cons);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+
+	/* Area too small for advertised size */
+	rc = inet_shmring_init(area, sizeof(area), &prod);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = inet_shmring_attach(area, sizeof(area) - 8, &cons);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+}
+
+PCUT_EXPORT(shmring);
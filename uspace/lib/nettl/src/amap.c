@@ -47,9 +47,14 @@
  *
  * In the unspecified case only the local port is known and the entry matches
  * all remote and local addresses.
+ *
+ * Entries of each kind are kept in a hash table keyed by the respective
+ * attributes so that finding a match takes constant time regardless
+ * of the number of associations.
  */
 
-#include <adt/list.h>
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <errno.h>
 #include <inet/addr.h>
 #include <inet/inet.h>
@@ -58,6 +63,157 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+/** Repla hash table key */
+typedef struct {
+	/** Remote endpoint */
+	inet_ep_t *rep;
+	/** Local address */
+	inet_addr_t *laddr;
+} amap_repla_key_t;
+
+/** Compute hash of an internet address.
+ *
+ * @param addr Address
+ * @return Hash value
+ */
+static size_t amap_addr_hash(const inet_addr_t *addr)
+{
+	size_t hash;
+	uint32_t w;
+	int i;
+
+	switch (addr->version) {
+	case ip_v4:
+		return hash_mix(addr->addr);
+	case ip_v6:
+		hash = 0;
+		for (i = 0; i < 16; i += 4) {
+			w = ((uint32_t) addr->addr6[i] << 24) |
+			    ((uint32_t) addr->addr6[i + 1] << 16) |
+			    ((uint32_t) addr->addr6[i + 2] << 8) |
+			    addr->addr6[i + 3];
+			hash = hash_combine(hash, w);
+		}
+		return hash_mix(hash);
+	default:
+		return 0;
+	}
+}
+
+static size_t amap_repla_hash_key(const amap_repla_key_t *key)
+{
+	size_t hash;
+
+	hash = amap_addr_hash(&key->rep->addr);
+	hash = hash_combine(hash, key->rep->port);
+	return hash_combine(hash, amap_addr_hash(key->laddr));
+}
+
+static size_t amap_repla_key_hash(const void *arg)
+{
+	return amap_repla_hash_key((const amap_repla_key_t *) arg);
+}
+
+static size_t amap_repla_hash(const ht_link_t *item)
+{
+	amap_repla_t *repla = hash_table_get_inst(item, amap_repla_t, lamap);
+	amap_repla_key_t key;
+
+	key.rep = &repla->rep;
+	key.laddr = &repla->laddr;
+	return amap_repla_hash_key(&key);
+}
+
+static bool amap_repla_key_equal(const void *arg, const ht_link_t *item)
+{
+	const amap_repla_key_t *key = (const amap_repla_key_t *) arg;
+	amap_repla_t *repla = hash_table_get_inst(item, amap_repla_t, lamap);
+
+	return repla->rep.port == key->rep->port &&
+	    inet_addr_compare(&repla->rep.addr, &key->rep->addr) &&
+	    inet_addr_compare(&repla->laddr, key->laddr);
+}
+
+static bool amap_repla_equal(const ht_link_t *a, const ht_link_t *b)
+{
+	amap_repla_t *repla = hash_table_get_inst(a, amap_repla_t, lamap);
+	amap_repla_key_t key;
+
+	key.rep = &repla->rep;
+	key.laddr = &repla->laddr;
+	return amap_repla_key_equal(&key, b);
+}
+
+static hash_table_ops_t amap_repla_ops = {
+	.hash = amap_repla_hash,
+	.key_hash = amap_repla_key_hash,
+	.key_equal = amap_repla_key_equal,
+	.equal = amap_repla_equal,
+	.remove_callback = NULL
+};
+
+static size_t amap_laddr_key_hash(const void *arg)
+{
+	return amap_addr_hash((const inet_addr_t *) arg);
+}
+
+static size_t amap_laddr_hash(const ht_link_t *item)
+{
+	amap_laddr_t *laddr = hash_table_get_inst(item, amap_laddr_t, lamap);
+	return amap_addr_hash(&laddr->laddr);
+}
+
+static bool amap_laddr_key_equal(const void *arg, const ht_link_t *item)
+{
+	amap_laddr_t *laddr = hash_table_get_inst(item, amap_laddr_t, lamap);
+	return inet_addr_compare(&laddr->laddr, (const inet_addr_t *) arg);
+}
+
+static bool amap_laddr_equal(const ht_link_t *a, const ht_link_t *b)
+{
+	amap_laddr_t *laddr = hash_table_get_inst(a, amap_laddr_t, lamap);
+	return amap_laddr_key_equal(&laddr->laddr, b);
+}
+
+static hash_table_ops_t amap_laddr_ops = {
+	.hash = amap_laddr_hash,
+	.key_hash = amap_laddr_key_hash,
+	.key_equal = amap_laddr_key_equal,
+	.equal = amap_laddr_equal,
+	.remove_callback = NULL
+};
+
+static size_t amap_llink_key_hash(const void *arg)
+{
+	return hash_mix(*(const service_id_t *) arg);
+}
+
+static size_t amap_llink_hash(const ht_link_t *item)
+{
+	amap_llink_t *llink = hash_table_get_inst(item, amap_llink_t, lamap);
+	return hash_mix(llink->llink);
+}
+
+static bool amap_llink_key_equal(const void *arg, const ht_link_t *item)
+{
+	amap_llink_t *llink = hash_table_get_inst(item, amap_llink_t, lamap);
+	return llink->llink == *(const service_id_t *) arg;
+}
+
+static bool amap_llink_equal(const ht_link_t *a, const ht_link_t *b)
+{
+	amap_llink_t *llink = hash_table_get_inst(a, amap_llink_t, lamap);
+	return amap_llink_key_equal(&llink->llink, b);
+}
+
+static hash_table_ops_t amap_llink_ops = {
+	.hash = amap_llink_hash,
+	.key_hash = amap_llink_key_hash,
+	.key_equal = amap_llink_key_equal,
+	.equal = amap_llink_equal,
+	.remove_callback = NULL
+};
+
 /** Convert association map flags to port range flags.
  *
  * @param flags Association map flags
@@ -97,12 +253,24 @@ errno_t amap_create(amap_t **rmap)
 		return ENOMEM;
 	}
 
-	list_initialize(&map->repla);
-	list_initialize(&map->laddr);
-	list_initialize(&map->llink);
+	if (!hash_table_create(&map->repla, 0, 0, &amap_repla_ops))
+		goto error;
+	if (!hash_table_create(&map->laddr, 0, 0, &amap_laddr_ops)) {
+		hash_table_destroy(&map->repla);
+		goto error;
+	}
+	if (!hash_table_create(&map->llink, 0, 0, &amap_llink_ops)) {
+		hash_table_destroy(&map->laddr);
+		hash_table_destroy(&map->repla);
+		goto error;
+	}
 
 	*rmap = map;
 	return EOK;
+error:
+	portrng_destroy(map->unspec);
+	free(map);
+	return ENOMEM;
 }
 
 /** Destroy association map.
@@ -113,9 +281,13 @@ void amap_destroy(amap_t *map)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_destroy()");
 
-	assert(list_empty(&map->repla));
-	assert(list_empty(&map->laddr));
-	assert(list_empty(&map->llink));
+	assert(hash_table_empty(&map->repla));
+	assert(hash_table_empty(&map->laddr));
+	assert(hash_table_empty(&map->llink));
+	hash_table_destroy(&map->repla);
+	hash_table_destroy(&map->laddr);
+	hash_table_destroy(&map->llink);
+	portrng_destroy(map->unspec);
 	free(map);
 }
 
@@ -133,34 +305,23 @@ void amap_destroy(amap_t *map)
 static errno_t amap_repla_find(amap_t *map, inet_ep_t *rep, inet_addr_t *la,
     amap_repla_t **rrepla)
 {
-	char *sraddr, *sladdr;
-
-	(void) inet_addr_format(&rep->addr, &sraddr);
-	(void) inet_addr_format(la, &sladdr);
-
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_repla_find(): rep=(%s,%" PRIu16
-	    ") la=%s", sraddr, rep->port, sladdr);
-	free(sraddr);
-	free(sladdr);
-
-	list_foreach(map->repla, lamap, amap_repla_t, repla) {
-		(void) inet_addr_format(&repla->rep.addr, &sraddr);
-		(void) inet_addr_format(&repla->laddr, &sladdr);
-		log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_repla_find(): "
-		    "compare to rep=(%s, %" PRIu16 ") la=%s",
-		    sraddr, repla->rep.port, sladdr);
-		free(sraddr);
-		free(sladdr);
-		if (inet_addr_compare(&repla->rep.addr, &rep->addr) &&
-		    repla->rep.port == rep->port &&
-		    inet_addr_compare(&repla->laddr, la)) {
-			*rrepla = repla;
-			return EOK;
-		}
+	amap_repla_key_t key;
+	ht_link_t *link;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_repla_find(): rport=%" PRIu16,
+	    rep->port);
+
+	key.rep = rep;
+	key.laddr = la;
+
+	link = hash_table_find(&map->repla, &key);
+	if (link == NULL) {
+		*rrepla = NULL;
+		return ENOENT;
 	}
 
-	*rrepla = NULL;
-	return ENOENT;
+	*rrepla = hash_table_get_inst(link, amap_repla_t, lamap);
+	return EOK;
 }
 
 /** Insert repla.
@@ -194,7 +355,7 @@ static errno_t amap_repla_insert(amap_t *map, inet_ep_t *rep, inet_addr_t *la,
 
 	repla->rep = *rep;
 	repla->laddr = *la;
-	list_append(&repla->lamap, &map->repla);
+	hash_table_insert(&map->repla, &repla->lamap);
 
 	*rrepla = repla;
 	return EOK;
@@ -209,7 +370,7 @@ static errno_t amap_repla_insert(amap_t *map, inet_ep_t *rep, inet_addr_t *la,
  */
 static void amap_repla_remove(amap_t *map, amap_repla_t *repla)
 {
-	list_remove(&repla->lamap);
+	hash_table_remove_item(&map->repla, &repla->lamap);
 	portrng_destroy(repla->portrng);
 	free(repla);
 }
@@ -227,15 +388,16 @@ static void amap_repla_remove(amap_t *map, amap_repla_t *repla)
 static errno_t amap_laddr_find(amap_t *map, inet_addr_t *addr,
     amap_laddr_t **rladdr)
 {
-	list_foreach(map->laddr, lamap, amap_laddr_t, laddr) {
-		if (inet_addr_compare(&laddr->laddr, addr)) {
-			*rladdr = laddr;
-			return EOK;
-		}
+	ht_link_t *link;
+
+	link = hash_table_find(&map->laddr, addr);
+	if (link == NULL) {
+		*rladdr = NULL;
+		return ENOENT;
 	}
 
-	*rladdr = NULL;
-	return ENOENT;
+	*rladdr = hash_table_get_inst(link, amap_laddr_t, lamap);
+	return EOK;
 }
 
 /** Insert laddr.
@@ -266,7 +428,7 @@ static errno_t amap_laddr_insert(amap_t *map, inet_addr_t *addr,
 	}
 
 	laddr->laddr = *addr;
-	list_append(&laddr->lamap, &map->laddr);
+	hash_table_insert(&map->laddr, &laddr->lamap);
 
 	*rladdr = laddr;
 	return EOK;
@@ -281,7 +443,7 @@ static errno_t amap_laddr_insert(amap_t *map, inet_addr_t *addr,
  */
 static void amap_laddr_remove(amap_t *map, amap_laddr_t *laddr)
 {
-	list_remove(&laddr->lamap);
+	hash_table_remove_item(&map->laddr, &laddr->lamap);
 	portrng_destroy(laddr->portrng);
 	free(laddr);
 }
@@ -299,15 +461,16 @@ static void amap_laddr_remove(amap_t *map, amap_laddr_t *laddr)
 static errno_t amap_llink_find(amap_t *map, sysarg_t link_id,
     amap_llink_t **rllink)
 {
-	list_foreach(map->llink, lamap, amap_llink_t, llink) {
-		if (llink->llink == link_id) {
-			*rllink = llink;
-			return EOK;
-		}
+	ht_link_t *link;
+
+	link = hash_table_find(&map->llink, &link_id);
+	if (link == NULL) {
+		*rllink = NULL;
+		return ENOENT;
 	}
 
-	*rllink = NULL;
-	return ENOENT;
+	*rllink = hash_table_get_inst(link, amap_llink_t, lamap);
+	return EOK;
 }
 
 /** Insert llink.
@@ -338,7 +501,7 @@ static errno_t amap_llink_insert(amap_t *map, sysarg_t link_id,
 	}
 
 	llink->llink = link_id;
-	list_append(&llink->lamap, &map->llink);
+	hash_table_insert(&map->llink, &llink->lamap);
 
 	*rllink = llink;
 	return EOK;
@@ -353,7 +516,7 @@ static errno_t amap_llink_insert(amap_t *map, sysarg_t link_id,
  */
 static void amap_llink_remove(amap_t *map, amap_llink_t *llink)
 {
-	list_remove(&llink->lamap);
+	hash_table_remove_item(&map->llink, &llink->lamap);
 	portrng_destroy(llink->portrng);
 	free(llink);
 }
@@ -730,7 +893,7 @@ errno_t amap_find_match(amap_t *map, inet_ep2_t *epp, void **rarg)
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_find_match(llink=%zu)",
 	    epp->local_link);
 
-	/* Remode endpoint, local address */
+	/* Remote endpoint, local address */
 	rc = amap_repla_find(map, &epp->remote, &epp->local.addr, &repla);
 	if (rc == EOK) {
 		rc = portrng_find_port(repla->portrng, epp->local.port,
@@ -755,8 +918,11 @@ errno_t amap_find_match(amap_t *map, inet_ep2_t *epp, void **rarg)
 	}
 
 	/* Local link */
-	rc = amap_llink_find(map, epp->local_link, &llink);
-	if (epp->local_link != 0 && rc == EOK) {
+	if (epp->local_link != 0)
+		rc = amap_llink_find(map, epp->local_link, &llink);
+	else
+		rc = ENOENT;
+	if (rc == EOK) {
 		rc = portrng_find_port(llink->portrng, epp->local.port,
 		    rarg);
 		if (rc == EOK) {
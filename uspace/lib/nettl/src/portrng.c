@@ -107,7 +107,7 @@ errno_t portrng_alloc(portrng_t *pr, uint16_t pnum, void *arg,
 			log_msg(LOG_DEFAULT, LVL_DEBUG2, "trying %" PRIu32, i);
 			found = false;
 			list_foreach(pr->used, lprng, portrng_port_t, port) {
-				if (port->pn == pnum) {
+				if (port->pn == i) {
 					found = true;
 					break;
 				}
@@ -69,8 +69,329 @@ const pcm_format_t AUDIO_FORMAT_ANY = {
 	.sample_format = 0,
 };
 
-static float get_normalized_sample(const void *buffer, size_t size,
-    unsigned frame, unsigned channel, const pcm_format_t *f);
+/** Number of samples converted at once by the generic mixing path */
+#define PCM_MIX_BLOCK 128
+
+/** Convert a run of samples to normalized float <-1,1>.
+ *
+ * @param buffer Audio data
+ * @param pos Index of the first sample
+ * @param count Number of samples
+ * @param out Normalized samples
+ */
+typedef void (*pcm_load_t)(const void *, size_t, size_t, float *);
+
+/** Convert a run of normalized float samples, clipping to <-1,1>.
+ *
+ * @param buffer Audio data
+ * @param pos Index of the first sample
+ * @param count Number of samples
+ * @param in Normalized samples
+ */
+typedef void (*pcm_store_t)(void *, size_t, size_t, const float *);
+
+/** Mix a run of samples of the same format, saturating the result.
+ *
+ * @param dst Destination audio data
+ * @param src Source audio data
+ * @param count Number of samples
+ */
+typedef void (*pcm_add_t)(void *, const void *, size_t);
+
+/** Operations on a sample format */
+typedef struct {
+	/** Conversion to normalized float */
+	pcm_load_t load;
+	/** Conversion from normalized float */
+	pcm_store_t store;
+	/** Same-format mixing, NULL if not available */
+	pcm_add_t add;
+} pcm_sample_ops_t;
+
+/** Define conversion of a sample format to and from normalized float.
+ *
+ * @a ftype is the type used for the arithmetic, it needs to hold
+ * every value of @a type exactly.
+ */
+#define PCM_DEFINE_CODEC(name, type, endian, low, high, ftype) \
+static void pcm_load_##name(const void *buffer, size_t pos, size_t count, \
+    float *out) \
+{ \
+	const type *p = (const type *) buffer + pos; \
+	const ftype rscale = 2 / ((ftype) (high) - (ftype) (low)); \
+	for (size_t i = 0; i < count; ++i) { \
+		out[i] = ((ftype) (type) type##_##endian##2host(p[i]) - \
+		    (ftype) (low)) * rscale - 1; \
+	} \
+} \
+\
+static void pcm_store_##name(void *buffer, size_t pos, size_t count, \
+    const float *in) \
+{ \
+	type *p = (type *) buffer + pos; \
+	const ftype scale = ((ftype) (high) - (ftype) (low)) / 2; \
+	for (size_t i = 0; i < count; ++i) { \
+		ftype c = in[i]; \
+		if (c < -1) \
+			c = -1; \
+		if (c > 1) \
+			c = 1; \
+		p[i] = host2##type##_##endian((type) ((c + 1) * scale + \
+		    (ftype) (low))); \
+	} \
+}
+
+PCM_DEFINE_CODEC(uint8, uint8_t, le, UINT8_MIN, UINT8_MAX, float);
+PCM_DEFINE_CODEC(sint8, int8_t, le, INT8_MIN, INT8_MAX, float);
+PCM_DEFINE_CODEC(uint16_le, uint16_t, le, UINT16_MIN, UINT16_MAX, float);
+PCM_DEFINE_CODEC(sint16_le, int16_t, le, INT16_MIN, INT16_MAX, float);
+PCM_DEFINE_CODEC(uint16_be, uint16_t, be, UINT16_MIN, UINT16_MAX, float);
+PCM_DEFINE_CODEC(sint16_be, int16_t, be, INT16_MIN, INT16_MAX, float);
+// TODO these are not right for 24bit
+PCM_DEFINE_CODEC(uint32_le, uint32_t, le, UINT32_MIN, UINT32_MAX, double);
+PCM_DEFINE_CODEC(sint32_le, int32_t, le, INT32_MIN, INT32_MAX, double);
+PCM_DEFINE_CODEC(uint32_be, uint32_t, be, UINT32_MIN, UINT32_MAX, double);
+PCM_DEFINE_CODEC(sint32_be, int32_t, be, INT32_MIN, INT32_MAX, double);
+
+static void pcm_load_float32(const void *buffer, size_t pos, size_t count,
+    float *out)
+{
+	const float *p = (const float *) buffer + pos;
+	for (size_t i = 0; i < count; ++i)
+		out[i] = float_le2host(p[i]);
+}
+
+static void pcm_store_float32(void *buffer, size_t pos, size_t count,
+    const float *in)
+{
+	float *p = (float *) buffer + pos;
+	for (size_t i = 0; i < count; ++i) {
+		float c = in[i];
+		if (c < -1)
+			c = -1;
+		if (c > 1)
+			c = 1;
+		p[i] = host2float_le(c);
+	}
+}
+
+#ifdef __BE__
+#define PCM_SWAP_LE true
+#define PCM_SWAP_BE false
+#else
+#define PCM_SWAP_LE false
+#define PCM_SWAP_BE true
+#endif
+
+static inline uint8_t pcm_swap8(uint8_t v)
+{
+	return v;
+}
+
+static inline uint16_t pcm_swap16(uint16_t v)
+{
+	return uint16_t_byteorder_swap(v);
+}
+
+static inline uint32_t pcm_swap32(uint32_t v)
+{
+	return uint32_t_byteorder_swap(v);
+}
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+
+/** Mix the bulk of the data using the vector unit */
+#define PCM_VECTOR
+
+/*
+ * Vectors of samples, only requiring natural alignment of the lanes.
+ * Signed variants are needed for arithmetic shifts.
+ */
+typedef uint8_t pcm_vu8_t __attribute__((vector_size(16), aligned(1),
+    may_alias));
+typedef int8_t pcm_vs8_t __attribute__((vector_size(16), aligned(1),
+    may_alias));
+typedef uint16_t pcm_vu16_t __attribute__((vector_size(16), aligned(2),
+    may_alias));
+typedef int16_t pcm_vs16_t __attribute__((vector_size(16), aligned(2),
+    may_alias));
+typedef uint32_t pcm_vu32_t __attribute__((vector_size(16), aligned(4),
+    may_alias));
+typedef int32_t pcm_vs32_t __attribute__((vector_size(16), aligned(4),
+    may_alias));
+
+static inline pcm_vu8_t pcm_vswap8(pcm_vu8_t v)
+{
+	return v;
+}
+
+static inline pcm_vu16_t pcm_vswap16(pcm_vu16_t v)
+{
+	return (v << 8) | (v >> 8);
+}
+
+static inline pcm_vu32_t pcm_vswap32(pcm_vu32_t v)
+{
+	return (v << 24) | ((v & 0xff00) << 8) | ((v >> 8) & 0xff00) |
+	    (v >> 24);
+}
+
+/** Saturating vector add of @a bits wide samples, see PCM_DEFINE_ADD */
+#define PCM_ADD_VECTOR(bits) \
+	for (; i + sizeof(pcm_vu##bits##_t) / sizeof(*d) <= count; \
+	    i += sizeof(pcm_vu##bits##_t) / sizeof(*d)) { \
+		pcm_vu##bits##_t a = *(pcm_vu##bits##_t *) (d + i); \
+		pcm_vu##bits##_t b = *(const pcm_vu##bits##_t *) (s + i); \
+		pcm_vu##bits##_t r, ovf, sat; \
+		if (swap) { \
+			a = pcm_vswap##bits(a); \
+			b = pcm_vswap##bits(b); \
+		} \
+		a ^= bias; \
+		b ^= bias; \
+		r = a + b; \
+		ovf = (pcm_vu##bits##_t) ((pcm_vs##bits##_t) \
+		    (~(a ^ b) & (a ^ r)) >> (bits - 1)); \
+		sat = (pcm_vu##bits##_t) ((pcm_vs##bits##_t) a >> (bits - 1)) ^ \
+		    INT##bits##_MAX; \
+		r = ((r & ~ovf) | (sat & ovf)) ^ bias; \
+		if (swap) \
+			r = pcm_vswap##bits(r); \
+		*(pcm_vu##bits##_t *) (d + i) = r; \
+	}
+
+#else
+
+#define PCM_ADD_VECTOR(bits)
+
+#endif
+
+/** Define saturating mixing of @a bits wide integer samples.
+ *
+ * Samples are added in their signed host order representation. Samples
+ * in foreign byte order are byte-swapped first (@a swap), unsigned samples
+ * are converted by flipping the sign bit (@a bias). Signed overflow
+ * happened iff both operands have the same sign and the sum does not.
+ */
+#define PCM_DEFINE_ADD(bits) \
+static inline void pcm_add##bits(void *dst, const void *src, size_t count, \
+    bool swap, uint##bits##_t bias) \
+{ \
+	uint##bits##_t *d = dst; \
+	const uint##bits##_t *s = src; \
+	size_t i = 0; \
+\
+	PCM_ADD_VECTOR(bits); \
+\
+	for (; i < count; ++i) { \
+		uint##bits##_t a = d[i]; \
+		uint##bits##_t b = s[i]; \
+		uint##bits##_t r; \
+		if (swap) { \
+			a = pcm_swap##bits(a); \
+			b = pcm_swap##bits(b); \
+		} \
+		a ^= bias; \
+		b ^= bias; \
+		r = a + b; \
+		if ((int##bits##_t) (~(a ^ b) & (a ^ r)) < 0) { \
+			r = ((int##bits##_t) a < 0) ? \
+			    (uint##bits##_t) INT##bits##_MIN : INT##bits##_MAX; \
+		} \
+		r ^= bias; \
+		d[i] = swap ? pcm_swap##bits(r) : r; \
+	} \
+}
+
+PCM_DEFINE_ADD(8);
+PCM_DEFINE_ADD(16);
+PCM_DEFINE_ADD(32);
+
+/** Define same-format mixing for a sample format */
+#define PCM_DEFINE_ADD_FORMAT(name, bits, swap, bias) \
+static void pcm_add_##name(void *dst, const void *src, size_t count) \
+{ \
+	pcm_add##bits(dst, src, count, swap, bias); \
+}
+
+PCM_DEFINE_ADD_FORMAT(uint8, 8, false, 0x80);
+PCM_DEFINE_ADD_FORMAT(sint8, 8, false, 0);
+PCM_DEFINE_ADD_FORMAT(uint16_le, 16, PCM_SWAP_LE, 0x8000);
+PCM_DEFINE_ADD_FORMAT(sint16_le, 16, PCM_SWAP_LE, 0);
+PCM_DEFINE_ADD_FORMAT(uint16_be, 16, PCM_SWAP_BE, 0x8000);
+PCM_DEFINE_ADD_FORMAT(sint16_be, 16, PCM_SWAP_BE, 0);
+PCM_DEFINE_ADD_FORMAT(uint32_le, 32, PCM_SWAP_LE, 0x80000000);
+PCM_DEFINE_ADD_FORMAT(sint32_le, 32, PCM_SWAP_LE, 0);
+PCM_DEFINE_ADD_FORMAT(uint32_be, 32, PCM_SWAP_BE, 0x80000000);
+PCM_DEFINE_ADD_FORMAT(sint32_be, 32, PCM_SWAP_BE, 0);
+
+#define PCM_OPS(name) { pcm_load_##name, pcm_store_##name, pcm_add_##name }
+
+/** Sample format operations, indexed by sample format */
+static const pcm_sample_ops_t pcm_sample_ops[] = {
+	[PCM_SAMPLE_UINT8] = PCM_OPS(uint8),
+	[PCM_SAMPLE_SINT8] = PCM_OPS(sint8),
+	[PCM_SAMPLE_UINT16_LE] = PCM_OPS(uint16_le),
+	[PCM_SAMPLE_UINT16_BE] = PCM_OPS(uint16_be),
+	[PCM_SAMPLE_SINT16_LE] = PCM_OPS(sint16_le),
+	[PCM_SAMPLE_SINT16_BE] = PCM_OPS(sint16_be),
+	[PCM_SAMPLE_UINT24_32_LE] = PCM_OPS(uint32_le),
+	[PCM_SAMPLE_UINT24_32_BE] = PCM_OPS(uint32_be),
+	[PCM_SAMPLE_SINT24_32_LE] = PCM_OPS(sint32_le),
+	[PCM_SAMPLE_SINT24_32_BE] = PCM_OPS(sint32_be),
+	[PCM_SAMPLE_UINT32_LE] = PCM_OPS(uint32_le),
+	[PCM_SAMPLE_UINT32_BE] = PCM_OPS(uint32_be),
+	[PCM_SAMPLE_SINT32_LE] = PCM_OPS(sint32_le),
+	[PCM_SAMPLE_SINT32_BE] = PCM_OPS(sint32_be),
+	[PCM_SAMPLE_FLOAT32] = { pcm_load_float32, pcm_store_float32, NULL },
+};
+
+/**
+ * Get operations on a sample format.
+ * @param format Sample format.
+ * @return Operations or NULL if the format is not supported.
+ */
+static const pcm_sample_ops_t *pcm_sample_ops_get(pcm_sample_format_t format)
+{
+	if (format >= sizeof(pcm_sample_ops) / sizeof(pcm_sample_ops[0]) ||
+	    pcm_sample_ops[format].load == NULL)
+		return NULL;
+	return &pcm_sample_ops[format];
+}
+
+/**
+ * Load source samples matching a run of destination samples.
+ * @param src Source audio data
+ * @param src_channels Number of channels in the source data
+ * @param dst_channels Number of channels in the destination data
+ * @param load Source conversion routine
+ * @param pos Index of the first destination sample
+ * @param count Number of samples
+ * @param out Normalized samples, 0.0 for channels missing in the source
+ */
+static void pcm_gather(const void *src, unsigned src_channels,
+    unsigned dst_channels, pcm_load_t load, size_t pos, size_t count,
+    float *out)
+{
+	size_t k = 0;
+
+	while (k < count) {
+		const size_t frame = (pos + k) / dst_channels;
+		const unsigned channel = (pos + k) % dst_channels;
+		const size_t run = min(dst_channels - channel, count - k);
+		size_t avail = 0;
+
+		if (channel < src_channels) {
+			avail = min(run, (size_t) (src_channels - channel));
+			load(src, frame * src_channels + channel, avail,
+			    out + k);
+		}
+
+		for (size_t i = avail; i < run; ++i)
+			out[k + i] = 0.0f;
+		k += run;
+	}
+}
 
 /**
  * Compare PCM format attribtues.
@@ -134,7 +455,10 @@ do { \
 		SET_NULL(uint32_t, be, INT32_MIN);
 		break;
 	case PCM_SAMPLE_SINT32_BE:
-		SET_NULL(int32_t, le, 0);
+		SET_NULL(int32_t, be, 0);
+		break;
+	case PCM_SAMPLE_FLOAT32:
+		SET_NULL(float, le, 0);
 		break;
 	case PCM_SAMPLE_UINT24_32_LE:
 	case PCM_SAMPLE_SINT24_32_LE:
@@ -144,7 +468,6 @@ do { \
 	case PCM_SAMPLE_SINT24_LE:
 	case PCM_SAMPLE_UINT24_BE:
 	case PCM_SAMPLE_SINT24_BE:
-	case PCM_SAMPLE_FLOAT32:
 	default:
 		break;
 	}
@@ -176,6 +499,11 @@ errno_t pcm_format_mix(void *dst, const void *src, size_t size, const pcm_format
  *
  * Buffers must contain entire frames. Destination buffer is always filled.
  * If there are not enough data in the source buffer silent data is assumed.
+ *
+ * Conversion routines for the format pair are looked up once per call.
+ * Integer data of the same format and channel count are mixed directly
+ * using saturating addition, everything else goes through normalized
+ * float in blocks of PCM_MIX_BLOCK samples.
  */
 errno_t pcm_format_convert_and_mix(void *dst, size_t dst_size, const void *src,
     size_t src_size, const pcm_format_t *sf, const pcm_format_t *df)
@@ -190,148 +518,53 @@ errno_t pcm_format_convert_and_mix(void *dst, size_t dst_size, const void *src,
 	if ((dst_size % dst_frame_size) != 0)
 		return EINVAL;
 
-	/*
-	 * This is so ugly it eats kittens, and puppies, and ducklings,
-	 * and all little fluffy things...
-	 */
-#define LOOP_ADD(type, endian, low, high) \
-do { \
-	const unsigned frame_count = dst_size / dst_frame_size; \
-	for (size_t i = 0; i < frame_count; ++i) { \
-		for (unsigned j = 0; j < df->channels; ++j) { \
-			const float a = \
-			    get_normalized_sample(dst, dst_size, i, j, df);\
-			const float b = \
-			    get_normalized_sample(src, src_size, i, j, sf);\
-			float c = (a + b); \
-			if (c < -1.0) c = -1.0; \
-			if (c > 1.0) c = 1.0; \
-			c += 1.0; \
-			c *= ((float)(type)high - (float)(type)low) / 2; \
-			c += (float)(type)low; \
-			type *dst_buf = dst; \
-			const unsigned pos = i * df->channels  + j; \
-			if (pos < (dst_size / sizeof(type))) \
-				dst_buf[pos] = to((type)c, type, endian); \
-		} \
-	} \
-} while (0)
-
-	switch (df->sample_format) {
-	case PCM_SAMPLE_UINT8:
-		LOOP_ADD(uint8_t, le, UINT8_MIN, UINT8_MAX);
-		break;
-	case PCM_SAMPLE_SINT8:
-		LOOP_ADD(uint8_t, le, INT8_MIN, INT8_MAX);
-		break;
-	case PCM_SAMPLE_UINT16_LE:
-		LOOP_ADD(uint16_t, le, UINT16_MIN, UINT16_MAX);
-		break;
-	case PCM_SAMPLE_SINT16_LE:
-		LOOP_ADD(int16_t, le, INT16_MIN, INT16_MAX);
-		break;
-	case PCM_SAMPLE_UINT16_BE:
-		LOOP_ADD(uint16_t, be, UINT16_MIN, UINT16_MAX);
-		break;
-	case PCM_SAMPLE_SINT16_BE:
-		LOOP_ADD(int16_t, be, INT16_MIN, INT16_MAX);
-		break;
-	case PCM_SAMPLE_UINT24_32_LE:
-	case PCM_SAMPLE_UINT32_LE: // TODO this are not right for 24bit
-		LOOP_ADD(uint32_t, le, UINT32_MIN, UINT32_MAX);
-		break;
-	case PCM_SAMPLE_SINT24_32_LE:
-	case PCM_SAMPLE_SINT32_LE:
-		LOOP_ADD(int32_t, le, INT32_MIN, INT32_MAX);
-		break;
-	case PCM_SAMPLE_UINT24_32_BE:
-	case PCM_SAMPLE_UINT32_BE:
-		LOOP_ADD(uint32_t, be, UINT32_MIN, UINT32_MAX);
-		break;
-	case PCM_SAMPLE_SINT24_32_BE:
-	case PCM_SAMPLE_SINT32_BE:
-		LOOP_ADD(int32_t, be, INT32_MIN, INT32_MAX);
-		break;
-	case PCM_SAMPLE_UINT24_LE:
-	case PCM_SAMPLE_SINT24_LE:
-	case PCM_SAMPLE_UINT24_BE:
-	case PCM_SAMPLE_SINT24_BE:
-	case PCM_SAMPLE_FLOAT32:
-	default:
+	const pcm_sample_ops_t *sops = pcm_sample_ops_get(sf->sample_format);
+	const pcm_sample_ops_t *dops = pcm_sample_ops_get(df->sample_format);
+	if (sops == NULL || dops == NULL)
 		return ENOTSUP;
+
+	const size_t dst_samples =
+	    dst_size / pcm_sample_format_size(df->sample_format);
+
+	/* Same layout, mix in place */
+	if (sf->sample_format == df->sample_format &&
+	    sf->channels == df->channels && dops->add != NULL) {
+		dops->add(dst, src, min(dst_size, src_size) /
+		    pcm_sample_format_size(df->sample_format));
+		return EOK;
 	}
-	return EOK;
-#undef LOOP_ADD
-}
 
-/**
- * Converts all sample formats to float <-1,1>
- * @param buffer Audio data
- * @param size Size of the buffer
- * @param frame Index of the frame to read
- * @param channel Channel within the frame
- * @param f Pointer to a format descriptor
- * @return Normalized sample <-1,1>, 0.0 if the data could not be read
- */
-static float get_normalized_sample(const void *buffer, size_t size,
-    unsigned frame, unsigned channel, const pcm_format_t *f)
-{
-	assert(f);
-	assert(buffer);
-	if (channel >= f->channels)
-		return 0.0f;
-#define GET(type, endian, low, high) \
-do { \
-	const type *src = buffer; \
-	const size_t sample_count = size / sizeof(type); \
-	const size_t sample_pos = frame * f->channels + channel; \
-	if (sample_pos >= sample_count) {\
-		return 0.0f; \
-	} \
-	float sample = from(src[sample_pos], type, endian); \
-	/* This makes it positive */ \
-	sample -= (float)(type)low; \
-	/* This makes it <0,2> */ \
-	sample /= (((float)(type)high - (float)(type)low) / 2.0f); \
-	return sample - 1.0f; \
-} while (0)
+	const unsigned src_channels = sf->channels;
+	const unsigned dst_channels = df->channels;
+	const size_t src_frames = src_size / src_frame_size;
 
-	switch (f->sample_format) {
-	case PCM_SAMPLE_UINT8:
-		GET(uint8_t, le, UINT8_MIN, UINT8_MAX);
-	case PCM_SAMPLE_SINT8:
-		GET(int8_t, le, INT8_MIN, INT8_MAX);
-	case PCM_SAMPLE_UINT16_LE:
-		GET(uint16_t, le, UINT16_MIN, UINT16_MAX);
-	case PCM_SAMPLE_SINT16_LE:
-		GET(int16_t, le, INT16_MIN, INT16_MAX);
-	case PCM_SAMPLE_UINT16_BE:
-		GET(uint16_t, be, UINT16_MIN, UINT16_MAX);
-	case PCM_SAMPLE_SINT16_BE:
-		GET(int16_t, be, INT16_MIN, INT16_MAX);
-	case PCM_SAMPLE_UINT24_32_LE:
-	case PCM_SAMPLE_UINT32_LE:
-		GET(uint32_t, le, UINT32_MIN, UINT32_MAX);
-	case PCM_SAMPLE_SINT24_32_LE:
-	case PCM_SAMPLE_SINT32_LE:
-		GET(int32_t, le, INT32_MIN, INT32_MAX);
-	case PCM_SAMPLE_UINT24_32_BE:
-	case PCM_SAMPLE_UINT32_BE:
-		GET(uint32_t, be, UINT32_MIN, UINT32_MAX);
-	case PCM_SAMPLE_SINT24_32_BE:
-	case PCM_SAMPLE_SINT32_BE:
-		GET(int32_t, le, INT32_MIN, INT32_MAX);
-	case PCM_SAMPLE_UINT24_LE:
-	case PCM_SAMPLE_SINT24_LE:
-	case PCM_SAMPLE_UINT24_BE:
-	case PCM_SAMPLE_SINT24_BE:
-	case PCM_SAMPLE_FLOAT32:
-	default:
-		break;
+	/* Destination samples past the source data are mixed with silence */
+	const size_t count = min(dst_samples, src_frames * dst_channels);
+
+	float a[PCM_MIX_BLOCK];
+	float b[PCM_MIX_BLOCK];
+
+	for (size_t pos = 0; pos < count; pos += PCM_MIX_BLOCK) {
+		const size_t n = min((size_t) PCM_MIX_BLOCK, count - pos);
+
+		dops->load(dst, pos, n, a);
+
+		if (src_channels == dst_channels) {
+			sops->load(src, pos, n, b);
+		} else {
+			pcm_gather(src, src_channels, dst_channels, sops->load,
+			    pos, n, b);
+		}
+
+		for (size_t i = 0; i < n; ++i)
+			a[i] += b[i];
+
+		dops->store(dst, pos, n, a);
 	}
-	return 0;
-#undef GET
+
+	return EOK;
 }
+
 /**
  * @}
  */
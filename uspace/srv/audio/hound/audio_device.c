@@ -39,6 +39,7 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <loc.h>
+#include <macros.h>
 #include <stdbool.h>
 #include <str.h>
 #include <str_error.h>
@@ -47,16 +48,24 @@
 #include "audio_device.h"
 #include "log.h"
 
-/* hardwired to provide ~21ms per fragment */
+/* Default fragment count, provides ~21ms per fragment */
 #define BUFFER_PARTS   16
 
+/* Number of fragments the mixer stays ahead of the device */
+#define MIX_AHEAD   2
+
+/** Requested fragment length, zero to use BUFFER_PARTS fragments */
+static usec_t device_period = 0;
+
 static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new);
 static errno_t device_source_connection_callback(audio_source_t *source, bool new);
 static void device_event_callback(ipc_call_t *icall, void *arg);
 static errno_t device_check_format(audio_sink_t *sink);
-static errno_t get_buffer(audio_device_t *dev);
+static errno_t get_buffer(audio_device_t *dev, const pcm_format_t *f);
 static errno_t release_buffer(audio_device_t *dev);
 static void advance_buffer(audio_device_t *dev, size_t size);
+static errno_t mixer_start(audio_device_t *dev);
+static void mixer_stop(audio_device_t *dev);
 static inline bool is_running(audio_device_t *dev)
 {
 	assert(dev);
@@ -64,6 +73,19 @@ static inline bool is_running(audio_device_t *dev)
 	return dev->buffer.base != NULL;
 }
 
+/**
+ * Set playback and capture fragment length of devices started from now on.
+ * @param period Requested fragment length, zero for the default.
+ *
+ * The fragment is the unit of mixing, the mixer stays MIX_AHEAD fragments
+ * ahead of the device. Fragments must tile the device buffer, so the
+ * actual length may be slightly shorter than requested.
+ */
+void audio_device_set_period(usec_t period)
+{
+	device_period = period;
+}
+
 /**
  * Initialize audio device structure.
  * @param dev The structure to initialize.
@@ -94,6 +116,16 @@ errno_t audio_device_init(audio_device_t *dev, service_id_t id, const char *name
 	dev->buffer.size = 0;
 	dev->buffer.fragment_size = 0;
 
+	/* Init mixer members */
+	dev->mixer.fid = NULL;
+	fibril_semaphore_initialize(&dev->mixer.sem, 0);
+	atomic_init(&dev->mixer.played, 0);
+	dev->mixer.ahead = 0;
+	dev->mixer.stop = false;
+	fibril_mutex_initialize(&dev->mixer.guard);
+	fibril_condvar_initialize(&dev->mixer.done);
+	dev->mixer.underruns = 0;
+
 	log_verbose("Initialized device (%p) '%s' with id %" PRIun ".",
 	    dev, dev->name, dev->id);
 
@@ -159,7 +191,7 @@ static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new)
 	if (new && list_count(&sink->connections) == 1) {
 		log_verbose("First connection on device sink '%s'", sink->name);
 
-		errno_t ret = get_buffer(dev);
+		errno_t ret = get_buffer(dev, &dev->sink.format);
 		if (ret != EOK) {
 			log_error("Failed to get device buffer: %s",
 			    str_error(ret));
@@ -169,16 +201,24 @@ static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new)
 		    device_event_callback, dev);
 
 		/*
-		 * Fill the buffer first. Fill the first two fragments,
-		 * so that we stay one fragment ahead
+		 * Fill the buffer first. Fill the first MIX_AHEAD fragments,
+		 * the mixer then keeps that distance from the device.
 		 */
 		pcm_format_silence(dev->buffer.base, dev->buffer.size,
 		    &dev->sink.format);
-		//TODO add underrun detection.
-		const size_t size = dev->buffer.fragment_size * 2;
-		/* We never cross the end of the buffer here */
-		audio_sink_mix_inputs(&dev->sink, dev->buffer.position, size);
-		advance_buffer(dev, size);
+		for (unsigned i = 0; i < MIX_AHEAD; ++i) {
+			/* We never cross the end of the buffer here */
+			audio_sink_mix_inputs(&dev->sink, dev->buffer.position,
+			    dev->buffer.fragment_size);
+			advance_buffer(dev, dev->buffer.fragment_size);
+		}
+
+		ret = mixer_start(dev);
+		if (ret != EOK) {
+			log_error("Failed to start mixer: %s", str_error(ret));
+			release_buffer(dev);
+			return ret;
+		}
 
 		const unsigned frames = dev->buffer.fragment_size /
 		    pcm_format_frame_size(&dev->sink.format);
@@ -189,6 +229,7 @@ static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new)
 		if (ret != EOK) {
 			log_error("Failed to start playback: %s",
 			    str_error(ret));
+			mixer_stop(dev);
 			release_buffer(dev);
 			return ret;
 		}
@@ -221,7 +262,7 @@ static errno_t device_source_connection_callback(audio_source_t *source, bool ne
 	assert(source);
 	audio_device_t *dev = source->private_data;
 	if (new && list_count(&source->connections) == 1) {
-		errno_t ret = get_buffer(dev);
+		errno_t ret = get_buffer(dev, &dev->source.format);
 		if (ret != EOK) {
 			log_error("Failed to get device buffer: %s",
 			    str_error(ret));
@@ -264,7 +305,6 @@ static errno_t device_source_connection_callback(audio_source_t *source, bool ne
  */
 static void device_event_callback(ipc_call_t *icall, void *arg)
 {
-	struct timespec time1;
 	errno_t ret;
 
 	audio_device_t *dev = arg;
@@ -276,16 +316,9 @@ static void device_event_callback(ipc_call_t *icall, void *arg)
 
 		switch (ipc_get_imethod(&call)) {
 		case PCM_EVENT_FRAMES_PLAYED:
-			getuptime(&time1);
-			//TODO add underrun detection.
-			/* We never cross the end of the buffer here */
-			audio_sink_mix_inputs(&dev->sink, dev->buffer.position,
-			    dev->buffer.fragment_size);
-			advance_buffer(dev, dev->buffer.fragment_size);
-			struct timespec time2;
-			getuptime(&time2);
-			log_verbose("Time to mix sources: %lld\n",
-			    NSEC2USEC(ts_sub_diff(&time2, &time1)));
+			/* Hand the work over to the mixer */
+			atomic_fetch_add(&dev->mixer.played, 1);
+			fibril_semaphore_up(&dev->mixer.sem);
 			break;
 		case PCM_EVENT_CAPTURE_TERMINATED:
 			log_verbose("Capture terminated");
@@ -299,6 +332,7 @@ static void device_event_callback(ipc_call_t *icall, void *arg)
 			break;
 		case PCM_EVENT_PLAYBACK_TERMINATED:
 			log_verbose("Playback Terminated");
+			mixer_stop(dev);
 			dev->sink.format = AUDIO_FORMAT_ANY;
 			ret = release_buffer(dev);
 			if (ret != EOK) {
@@ -339,12 +373,41 @@ static errno_t device_check_format(audio_sink_t *sink)
 	    &sink->format.sampling_rate, &sink->format.sample_format);
 }
 
+/**
+ * Compute fragment size for a device buffer.
+ * @param size Size of the device buffer.
+ * @param f Format of the audio data.
+ * @return Fragment size in bytes.
+ *
+ * Fragments evenly divide the buffer, so that a fragment never wraps
+ * around its end.
+ */
+static size_t fragment_size(size_t size, const pcm_format_t *f)
+{
+	const size_t frame_size = pcm_format_frame_size(f);
+	if (device_period == 0 || frame_size == 0 || f->sampling_rate == 0)
+		return size / BUFFER_PARTS;
+
+	const size_t frames = size / frame_size;
+	const size_t period_frames = max((size_t) 1, (size_t)
+	    ((uint64_t) f->sampling_rate * device_period / 1000000));
+
+	size_t parts = max((size_t) MIX_AHEAD + 1,
+	    (frames + period_frames - 1) / period_frames);
+	while (parts < frames && frames % parts != 0)
+		++parts;
+	parts = min(parts, frames);
+
+	return (frames / parts) * frame_size;
+}
+
 /**
  * Get access to device buffer.
  * @param dev Audio device.
+ * @param f Format of the audio data.
  * @return Error code.
  */
-static errno_t get_buffer(audio_device_t *dev)
+static errno_t get_buffer(audio_device_t *dev, const pcm_format_t *f)
 {
 	assert(dev);
 	if (!dev->sess) {
@@ -363,7 +426,9 @@ static errno_t get_buffer(audio_device_t *dev)
 	    &preferred_size);
 	if (ret == EOK) {
 		dev->buffer.size = preferred_size;
-		dev->buffer.fragment_size = dev->buffer.size / BUFFER_PARTS;
+		dev->buffer.fragment_size = fragment_size(dev->buffer.size, f);
+		log_verbose("Device buffer %zu bytes, fragment %zu bytes",
+		    dev->buffer.size, dev->buffer.fragment_size);
 		dev->buffer.position = dev->buffer.base;
 	}
 	return ret;
@@ -406,6 +471,107 @@ static void advance_buffer(audio_device_t *dev, size_t size)
 	if (dev->buffer.position == (dev->buffer.base + dev->buffer.size))
 		dev->buffer.position = dev->buffer.base;
 }
+/**
+ * Playback mixer fibril.
+ * @param arg Audio device.
+ * @return Error code.
+ *
+ * Keeps MIX_AHEAD fragments mixed ahead of the device playback position.
+ * The device event handler only counts played fragments, so that event
+ * delivery never waits for mixing.
+ */
+static errno_t mixer_fibril(void *arg)
+{
+	audio_device_t *dev = arg;
+	assert(dev);
+
+	while (true) {
+		fibril_semaphore_down(&dev->mixer.sem);
+		if (dev->mixer.stop)
+			break;
+
+		const unsigned played = atomic_exchange(&dev->mixer.played, 0);
+		if (played == 0)
+			continue;
+
+		if (played > dev->mixer.ahead) {
+			/* The device has played fragments we did not mix */
+			const unsigned missed = played - dev->mixer.ahead;
+			dev->mixer.underruns += missed;
+			log_warning("Device '%s' underrun, %u fragment(s) late",
+			    dev->name, missed);
+			for (unsigned i = 0; i < missed; ++i)
+				advance_buffer(dev, dev->buffer.fragment_size);
+			dev->mixer.ahead = 0;
+		} else {
+			dev->mixer.ahead -= played;
+		}
+
+		struct timespec time1;
+		getuptime(&time1);
+		while (dev->mixer.ahead < MIX_AHEAD) {
+			/* We never cross the end of the buffer here */
+			audio_sink_mix_inputs(&dev->sink, dev->buffer.position,
+			    dev->buffer.fragment_size);
+			advance_buffer(dev, dev->buffer.fragment_size);
+			++dev->mixer.ahead;
+		}
+		struct timespec time2;
+		getuptime(&time2);
+		log_verbose("Time to mix sources: %lld",
+		    NSEC2USEC(ts_sub_diff(&time2, &time1)));
+	}
+
+	fibril_mutex_lock(&dev->mixer.guard);
+	dev->mixer.fid = NULL;
+	fibril_condvar_broadcast(&dev->mixer.done);
+	fibril_mutex_unlock(&dev->mixer.guard);
+	return EOK;
+}
+
+/**
+ * Start playback mixer.
+ * @param dev Audio device, MIX_AHEAD fragments have been mixed already.
+ * @return Error code.
+ */
+static errno_t mixer_start(audio_device_t *dev)
+{
+	assert(dev);
+	fibril_mutex_lock(&dev->mixer.guard);
+	assert(dev->mixer.fid == NULL);
+	dev->mixer.fid = fibril_create(mixer_fibril, dev);
+	if (dev->mixer.fid == NULL) {
+		fibril_mutex_unlock(&dev->mixer.guard);
+		return ENOMEM;
+	}
+	atomic_store(&dev->mixer.played, 0);
+	dev->mixer.ahead = MIX_AHEAD;
+	dev->mixer.stop = false;
+	fibril_add_ready(dev->mixer.fid);
+	fibril_mutex_unlock(&dev->mixer.guard);
+	return EOK;
+}
+
+/**
+ * Stop playback mixer and wait for it to terminate.
+ * @param dev Audio device.
+ */
+static void mixer_stop(audio_device_t *dev)
+{
+	assert(dev);
+	fibril_mutex_lock(&dev->mixer.guard);
+	if (dev->mixer.fid != NULL) {
+		dev->mixer.stop = true;
+		fibril_semaphore_up(&dev->mixer.sem);
+		while (dev->mixer.fid != NULL)
+			fibril_condvar_wait(&dev->mixer.done, &dev->mixer.guard);
+	}
+	fibril_mutex_unlock(&dev->mixer.guard);
+	if (dev->mixer.underruns > 0) {
+		log_info("Device '%s' had %" PRIu64 " underrun fragment(s)",
+		    dev->name, dev->mixer.underruns);
+	}
+}
 /**
  * @}
  */
@@ -42,6 +42,8 @@
 #include <errno.h>
 #include <ipc/loc.h>
 #include <audio_pcm_iface.h>
+#include <stdatomic.h>
+#include <time.h>
 
 #include "audio_source.h"
 #include "audio_sink.h"
@@ -63,6 +65,25 @@ typedef struct {
 		void *position;
 		size_t fragment_size;
 	} buffer;
+	/** Playback mixer */
+	struct {
+		/** Mixer fibril, NULL if not running */
+		fid_t fid;
+		/** Signalled when the device finishes playing a fragment */
+		fibril_semaphore_t sem;
+		/** Fragments played and not yet seen by the mixer */
+		atomic_uint played;
+		/** Number of fragments mixed ahead of the device */
+		unsigned ahead;
+		/** Ask the mixer to terminate */
+		bool stop;
+		/** Mixer state synchronization */
+		fibril_mutex_t guard;
+		/** Signalled when the mixer fibril terminates */
+		fibril_condvar_t done;
+		/** Number of fragments the device played before we mixed them */
+		uint64_t underruns;
+	} mixer;
 	/** Capture device abstraction. */
 	audio_source_t source;
 	/** Playback device abstraction. */
@@ -75,6 +96,7 @@ static inline audio_device_t *audio_device_list_instance(link_t *l)
 	return l ? list_get_instance(l, audio_device_t, link) : NULL;
 }
 
+void audio_device_set_period(usec_t period);
 errno_t audio_device_init(audio_device_t *dev, service_id_t id, const char *name);
 void audio_device_fini(audio_device_t *dev);
 audio_source_t *audio_device_get_source(audio_device_t *dev);
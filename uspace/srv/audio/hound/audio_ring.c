@@ -0,0 +1,216 @@
+/** @addtogroup audio
+ * @brief HelenOS sound server
+ * @{
+ */
+/** @file
+ */
+
+#include <assert.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdlib.h>
+
+#include "audio_ring.h"
+
+/** Buffer position of a ring index.
+ * @param ring The audio ring.
+ * @param idx Head or tail index.
+ * @return Offset into the ring buffer.
+ */
+static size_t audio_ring_pos(audio_ring_t *ring, size_t idx)
+{
+	return idx < ring->size ? idx : idx - ring->size;
+}
+
+/** Advance a ring index.
+ * @param ring The audio ring.
+ * @param idx Head or tail index.
+ * @param size Number of bytes to advance by.
+ * @return New index, wrapped to [0, 2 * ring->size).
+ */
+static size_t audio_ring_advance(audio_ring_t *ring, size_t idx, size_t size)
+{
+	idx += size;
+	return idx < 2 * ring->size ? idx : idx - 2 * ring->size;
+}
+
+/**
+ * Initialize an empty audio ring.
+ * @param ring The ring to initialize.
+ * @param size Size of the ring buffer in bytes.
+ * @return Error code.
+ */
+errno_t audio_ring_init(audio_ring_t *ring, size_t size)
+{
+	assert(ring);
+	if (size == 0 || size > SIZE_MAX / 2)
+		return EINVAL;
+	ring->buffer = malloc(size);
+	if (!ring->buffer)
+		return ENOMEM;
+	ring->size = size;
+	atomic_init(&ring->head, 0);
+	atomic_init(&ring->tail, 0);
+	return EOK;
+}
+
+/**
+ * Release audio ring resources.
+ * @param ring The ring to finalize.
+ */
+void audio_ring_fini(audio_ring_t *ring)
+{
+	assert(ring);
+	free(ring->buffer);
+	ring->buffer = NULL;
+	ring->size = 0;
+}
+
+/**
+ * Number of bytes available for reading.
+ * @param ring The audio ring.
+ * @return Number of bytes stored in the ring.
+ */
+size_t audio_ring_used(audio_ring_t *ring)
+{
+	assert(ring);
+	const size_t tail = atomic_load_explicit(&ring->tail,
+	    memory_order_acquire);
+	const size_t head = atomic_load_explicit(&ring->head,
+	    memory_order_acquire);
+	return head >= tail ? head - tail : head + 2 * ring->size - tail;
+}
+
+/**
+ * Number of bytes available for writing.
+ * @param ring The audio ring.
+ * @return Number of free bytes in the ring.
+ */
+size_t audio_ring_free(audio_ring_t *ring)
+{
+	return ring->size - audio_ring_used(ring);
+}
+
+/**
+ * Get contiguous free space at the write position.
+ * @param ring The audio ring.
+ * @param[out] data Start of the free space.
+ * @return Size of the contiguous free space.
+ *
+ * Producer side only. The space is handed over to the consumer by
+ * audio_ring_write_end().
+ */
+size_t audio_ring_write_begin(audio_ring_t *ring, void **data)
+{
+	assert(ring);
+	assert(data);
+	const size_t head = atomic_load_explicit(&ring->head,
+	    memory_order_relaxed);
+	const size_t pos = audio_ring_pos(ring, head);
+	*data = ring->buffer + pos;
+	return min(audio_ring_free(ring), ring->size - pos);
+}
+
+/**
+ * Publish data written to the space returned by audio_ring_write_begin().
+ * @param ring The audio ring.
+ * @param size Number of bytes written.
+ */
+void audio_ring_write_end(audio_ring_t *ring, size_t size)
+{
+	assert(ring);
+	assert(size <= audio_ring_free(ring));
+	const size_t head = atomic_load_explicit(&ring->head,
+	    memory_order_relaxed);
+	atomic_store_explicit(&ring->head,
+	    audio_ring_advance(ring, head, size), memory_order_release);
+}
+
+/**
+ * Copy data into the ring.
+ * @param ring The audio ring.
+ * @param data Source buffer.
+ * @param size Size of the source buffer.
+ * @return Number of bytes written, less than @p size if the ring is full.
+ */
+size_t audio_ring_write(audio_ring_t *ring, const void *data, size_t size)
+{
+	const uint8_t *src = data;
+	size_t done = 0;
+
+	while (done < size) {
+		void *dst;
+		const size_t chunk = min(audio_ring_write_begin(ring, &dst),
+		    size - done);
+		if (chunk == 0)
+			break;
+		memcpy(dst, src + done, chunk);
+		audio_ring_write_end(ring, chunk);
+		done += chunk;
+	}
+	return done;
+}
+
+/**
+ * Get contiguous data at the read position.
+ * @param ring The audio ring.
+ * @param[out] data Start of the data.
+ * @return Size of the contiguous data.
+ *
+ * Consumer side only. The space is returned to the producer by
+ * audio_ring_read_end().
+ */
+size_t audio_ring_read_begin(audio_ring_t *ring, const void **data)
+{
+	assert(ring);
+	assert(data);
+	const size_t tail = atomic_load_explicit(&ring->tail,
+	    memory_order_relaxed);
+	const size_t pos = audio_ring_pos(ring, tail);
+	*data = ring->buffer + pos;
+	return min(audio_ring_used(ring), ring->size - pos);
+}
+
+/**
+ * Release data returned by audio_ring_read_begin().
+ * @param ring The audio ring.
+ * @param size Number of bytes consumed.
+ */
+void audio_ring_read_end(audio_ring_t *ring, size_t size)
+{
+	assert(ring);
+	assert(size <= audio_ring_used(ring));
+	const size_t tail = atomic_load_explicit(&ring->tail,
+	    memory_order_relaxed);
+	atomic_store_explicit(&ring->tail,
+	    audio_ring_advance(ring, tail, size), memory_order_release);
+}
+
+/**
+ * Copy data out of the ring.
+ * @param ring The audio ring.
+ * @param data Destination buffer.
+ * @param size Size of the destination buffer.
+ * @return Number of bytes read, less than @p size if the ring is empty.
+ */
+size_t audio_ring_read(audio_ring_t *ring, void *data, size_t size)
+{
+	uint8_t *dst = data;
+	size_t done = 0;
+
+	while (done < size) {
+		const void *src;
+		const size_t chunk = min(audio_ring_read_begin(ring, &src),
+		    size - done);
+		if (chunk == 0)
+			break;
+		memcpy(dst + done, src, chunk);
+		audio_ring_read_end(ring, chunk);
+		done += chunk;
+	}
+	return done;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,54 @@
+/** @addtogroup audio
+ * @brief HelenOS sound server
+ * @{
+ */
+/** @file
+ */
+
+#ifndef AUDIO_RING_H_
+#define AUDIO_RING_H_
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Single-producer single-consumer audio byte ring.
+ *
+ * One fibril (or thread) writes into the ring while another one reads
+ * from it, without any locking. Positions are byte indices kept in
+ * [0, 2 * size), each advanced only by its owner and wrapped explicitly,
+ * so the amount of data in the ring is their difference modulo 2 * size
+ * and a full ring is told apart from an empty one. The ring size need
+ * not be a power of two.
+ */
+typedef struct {
+	/** Ring buffer memory */
+	uint8_t *buffer;
+	/** Size of the ring buffer */
+	size_t size;
+	/** Write index, advanced by the producer */
+	atomic_size_t head;
+	/** Read index, advanced by the consumer */
+	atomic_size_t tail;
+} audio_ring_t;
+
+errno_t audio_ring_init(audio_ring_t *ring, size_t size);
+void audio_ring_fini(audio_ring_t *ring);
+
+size_t audio_ring_used(audio_ring_t *ring);
+size_t audio_ring_free(audio_ring_t *ring);
+
+size_t audio_ring_write_begin(audio_ring_t *ring, void **data);
+void audio_ring_write_end(audio_ring_t *ring, size_t size);
+size_t audio_ring_write(audio_ring_t *ring, const void *data, size_t size);
+
+size_t audio_ring_read_begin(audio_ring_t *ring, const void **data);
+void audio_ring_read_end(audio_ring_t *ring, size_t size);
+size_t audio_ring_read(audio_ring_t *ring, void *data, size_t size);
+
+#endif
+
+/**
+ * @}
+ */
@@ -35,6 +35,7 @@
  */
 
 #include <assert.h>
+#include <macros.h>
 #include <stdlib.h>
 #include <str.h>
 
@@ -407,6 +408,50 @@ errno_t hound_remove_sink(hound_t *hound, audio_sink_t *sink)
 	return EOK;
 }
 
+/**
+ * Get statistics of all streams.
+ * @param[in] hound The hound structure.
+ * @param[out] stats Array of stream statistics, to be freed by the caller.
+ * @param[out] count Number of elements in the @p stats array.
+ * @return Error code.
+ */
+errno_t hound_get_stream_stats(hound_t *hound, hound_stream_stats_t **stats,
+    size_t *count)
+{
+	assert(hound);
+	if (!stats || !count)
+		return EINVAL;
+
+	fibril_mutex_lock(&hound->list_guard);
+	size_t total = 0;
+	list_foreach(hound->contexts, link, hound_ctx_t, ctx) {
+		total += hound_ctx_get_stream_stats(ctx, NULL, 0);
+	}
+
+	hound_stream_stats_t *buf = NULL;
+	if (total > 0) {
+		buf = calloc(total, sizeof(hound_stream_stats_t));
+		if (!buf) {
+			fibril_mutex_unlock(&hound->list_guard);
+			return ENOMEM;
+		}
+	}
+
+	/* Streams may have come or gone in the meantime, do not overflow */
+	size_t i = 0;
+	list_foreach(hound->contexts, link, hound_ctx_t, ctx) {
+		if (i >= total)
+			break;
+		i += min(total - i,
+		    hound_ctx_get_stream_stats(ctx, buf + i, total - i));
+	}
+	fibril_mutex_unlock(&hound->list_guard);
+
+	*stats = buf;
+	*count = i;
+	return EOK;
+}
+
 /**
  * List all registered sources.
  * @param[in] hound The hound structure.
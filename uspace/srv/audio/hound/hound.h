@@ -76,6 +76,8 @@ errno_t hound_list_sources(hound_t *hound, char ***list, size_t *size);
 errno_t hound_list_sinks(hound_t *hound, char ***list, size_t *size);
 errno_t hound_list_connections(hound_t *hound, const char ***sources,
     const char ***sinks, size_t *size);
+errno_t hound_get_stream_stats(hound_t *hound, hound_stream_stats_t **stats,
+    size_t *count);
 errno_t hound_remove_source(hound_t *hound, audio_source_t *source);
 errno_t hound_remove_sink(hound_t *hound, audio_sink_t *sink);
 errno_t hound_connect(hound_t *hound, const char *source_name, const char *sink_name);
@@ -35,12 +35,16 @@
  */
 
 #include <macros.h>
+#include <mem.h>
 #include <errno.h>
+#include <stdatomic.h>
 #include <stdlib.h>
+#include <str.h>
 #include <str_error.h>
 
 #include "hound_ctx.h"
 #include "audio_data.h"
+#include "audio_ring.h"
 #include "connection.h"
 #include "log.h"
 
@@ -153,12 +157,22 @@ bool hound_ctx_is_record(hound_ctx_t *ctx)
  * STREAMS
  */
 
-/** Hound stream structure. */
+/** Default stream buffer length if the client does not ask for a size */
+#define STREAM_BUFFER_DEFAULT_USEC 500000
+
+/** Hound stream structure.
+ *
+ * Audio data pass through a lock-free single-producer single-consumer
+ * ring. Playback streams are filled by the client connection fibril and
+ * drained by the device mixer, recording streams the other way around.
+ * The mutex and condition variable are only used to put the client side
+ * to sleep when the ring is full (playback) or empty (recording).
+ */
 typedef struct hound_ctx_stream {
 	/** Hound context streams link */
 	link_t link;
-	/** Audio data pipe */
-	audio_pipe_t fifo;
+	/** Audio data ring */
+	audio_ring_t ring;
 	/** Parent context */
 	hound_ctx_t *ctx;
 	/** Stream data format */
@@ -167,12 +181,71 @@ typedef struct hound_ctx_stream {
 	int flags;
 	/** Maximum allowed buffer size */
 	size_t allowed_size;
-	/** Fifo access synchronization */
+	/** Number of fibrils waiting for a buffer status change */
+	atomic_uint waiters;
+	/** Wait synchronization */
 	fibril_mutex_t guard;
 	/** buffer status change condition */
 	fibril_condvar_t change;
+	/** Playback stream has run out of data */
+	bool starved;
+	/** Statistics, updated by the mixing side of the ring */
+	hound_stream_stats_t stats;
 } hound_ctx_stream_t;
 
+/**
+ * Prepare to wait for a buffer status change.
+ * @param stream The stream.
+ *
+ * Must be followed by stream_wait_end(). Conditions checked in between
+ * cannot miss a wakeup by stream_wakeup().
+ */
+static void stream_wait_begin(hound_ctx_stream_t *stream)
+{
+	fibril_mutex_lock(&stream->guard);
+	atomic_fetch_add(&stream->waiters, 1);
+	atomic_thread_fence(memory_order_seq_cst);
+}
+
+/**
+ * Stop waiting for buffer status changes.
+ * @param stream The stream.
+ */
+static void stream_wait_end(hound_ctx_stream_t *stream)
+{
+	atomic_fetch_sub(&stream->waiters, 1);
+	fibril_mutex_unlock(&stream->guard);
+}
+
+/**
+ * Wake up fibrils waiting for a buffer status change.
+ * @param stream The stream.
+ *
+ * The lock is only touched if there is somebody waiting.
+ */
+static void stream_wakeup(hound_ctx_stream_t *stream)
+{
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load(&stream->waiters) == 0)
+		return;
+	fibril_mutex_lock(&stream->guard);
+	fibril_condvar_broadcast(&stream->change);
+	fibril_mutex_unlock(&stream->guard);
+}
+
+/**
+ * Update latency statistics.
+ * @param stream The stream.
+ * @param size Amount of data in the stream buffer.
+ */
+static void stream_update_latency(hound_ctx_stream_t *stream, size_t size)
+{
+	const usec_t latency = pcm_format_size_to_usec(size, &stream->format);
+	stream->stats.latency = latency;
+	if (latency > stream->stats.latency_max)
+		stream->stats.latency_max = latency;
+}
+
 /**
  * New stream append helper.
  * @param ctx hound context.
@@ -192,33 +265,47 @@ static inline void stream_append(hound_ctx_t *ctx, hound_ctx_stream_t *stream)
 }
 
 /**
- * Push new data to stream, do not block.
+ * Push new recorded data to stream, do not block.
  * @param stream The target stream.
- * @param adata The new data.
+ * @param data Audio data.
+ * @param size Size of the @p data buffer.
+ * @param f Format of the audio data.
  * @return Error code.
  */
-static errno_t stream_push_data(hound_ctx_stream_t *stream, audio_data_t *adata)
+static errno_t stream_push_data(hound_ctx_stream_t *stream, const void *data,
+    size_t size, const pcm_format_t *f)
 {
 	assert(stream);
-	assert(adata);
+	assert(data);
 
-	if (stream->allowed_size && adata->size > stream->allowed_size)
-		return EINVAL;
+	const size_t src_frame_size = pcm_format_frame_size(f);
+	const size_t dst_frame_size = pcm_format_frame_size(&stream->format);
+	const size_t frames = size / src_frame_size;
 
-	fibril_mutex_lock(&stream->guard);
-	if (stream->allowed_size &&
-	    (audio_pipe_bytes(&stream->fifo) + adata->size >
-	    stream->allowed_size)) {
-		fibril_mutex_unlock(&stream->guard);
+	if (audio_ring_free(&stream->ring) < frames * dst_frame_size) {
+		++stream->stats.overruns;
 		return EOVERFLOW;
+	}
 
+	size_t done = 0;
+	while (done < frames) {
+		void *dst;
+		const size_t n = min(frames - done,
+		    audio_ring_write_begin(&stream->ring, &dst) /
+		    dst_frame_size);
+		assert(n > 0);
+		pcm_format_silence(dst, n * dst_frame_size, &stream->format);
+		pcm_format_convert_and_mix(dst, n * dst_frame_size,
+		    data + done * src_frame_size, n * src_frame_size, f,
+		    &stream->format);
+		audio_ring_write_end(&stream->ring, n * dst_frame_size);
+		done += n;
 	}
 
-	const errno_t ret = audio_pipe_push(&stream->fifo, adata);
-	fibril_mutex_unlock(&stream->guard);
-	if (ret == EOK)
-		fibril_condvar_signal(&stream->change);
-	return ret;
+	stream->stats.frames += frames;
+	stream_update_latency(stream, audio_ring_used(&stream->ring));
+	stream_wakeup(stream);
+	return EOK;
 }
 
 /**
@@ -247,21 +334,45 @@ hound_ctx_stream_t *hound_ctx_create_stream(hound_ctx_t *ctx, int flags,
     pcm_format_t format, size_t buffer_size)
 {
 	assert(ctx);
+	const size_t frame_size = pcm_format_frame_size(&format);
+	if (frame_size == 0 || format.sampling_rate == 0)
+		return NULL;
+
+	/* The ring holds whole frames, so that they never wrap around */
+	size_t ring_size = buffer_size;
+	if (ring_size == 0) {
+		ring_size = (uint64_t) format.sampling_rate *
+		    STREAM_BUFFER_DEFAULT_USEC / 1000000 * frame_size;
+	}
+	ring_size = max(frame_size,
+	    (ring_size + frame_size - 1) / frame_size * frame_size);
+
 	hound_ctx_stream_t *stream = malloc(sizeof(hound_ctx_stream_t));
-	if (stream) {
-		audio_pipe_init(&stream->fifo);
-		link_initialize(&stream->link);
-		fibril_mutex_initialize(&stream->guard);
-		fibril_condvar_initialize(&stream->change);
-		stream->ctx = ctx;
-		stream->flags = flags;
-		stream->format = format;
-		stream->allowed_size = buffer_size;
-		stream_append(ctx, stream);
-		log_verbose("CTX: %p added stream; flags:%#x ch: %u r:%u f:%s",
-		    ctx, flags, format.channels, format.sampling_rate,
-		    pcm_sample_format_str(format.sample_format));
+	if (!stream)
+		return NULL;
+	if (audio_ring_init(&stream->ring, ring_size) != EOK) {
+		free(stream);
+		return NULL;
 	}
+	link_initialize(&stream->link);
+	atomic_init(&stream->waiters, 0);
+	fibril_mutex_initialize(&stream->guard);
+	fibril_condvar_initialize(&stream->change);
+	stream->ctx = ctx;
+	stream->flags = flags;
+	stream->format = format;
+	stream->allowed_size = buffer_size;
+	stream->starved = true;
+	memset(&stream->stats, 0, sizeof(stream->stats));
+	stream->stats.record = hound_ctx_is_record(ctx);
+	stream->stats.format = format;
+	stream->stats.buffer_size = ring_size;
+	str_cpy(stream->stats.name, sizeof(stream->stats.name),
+	    ctx->source ? ctx->source->name : ctx->sink->name);
+	stream_append(ctx, stream);
+	log_verbose("CTX: %p added stream; flags:%#x ch: %u r:%u f:%s",
+	    ctx, flags, format.channels, format.sampling_rate,
+	    pcm_sample_format_str(format.sample_format));
 	return stream;
 }
 
@@ -275,15 +386,15 @@ void hound_ctx_destroy_stream(hound_ctx_stream_t *stream)
 {
 	if (stream) {
 		stream_remove(stream->ctx, stream);
-		if (audio_pipe_bytes(&stream->fifo))
+		if (audio_ring_used(&stream->ring))
 			log_warning("Destroying stream with non empty buffer");
 		log_verbose("CTX: %p remove stream (%zu/%zu); "
 		    "flags:%#x ch: %u r:%u f:%s",
-		    stream->ctx, audio_pipe_bytes(&stream->fifo),
-		    stream->allowed_size, stream->flags,
+		    stream->ctx, audio_ring_used(&stream->ring),
+		    stream->ring.size, stream->flags,
 		    stream->format.channels, stream->format.sampling_rate,
 		    pcm_sample_format_str(stream->format.sample_format));
-		audio_pipe_fini(&stream->fifo);
+		audio_ring_fini(&stream->ring);
 		free(stream);
 	}
 }
@@ -291,31 +402,37 @@ void hound_ctx_destroy_stream(hound_ctx_stream_t *stream)
 /**
  * Write new data to a stream.
  * @param stream The destination stream.
- * @param data audio data buffer.
+ * @param data audio data buffer, it is freed by this function.
  * @param size size of the @p data buffer.
  * @return Error code.
+ *
+ * Blocks until all data fit into the stream buffer.
  */
 errno_t hound_ctx_stream_write(hound_ctx_stream_t *stream, void *data,
     size_t size)
 {
 	assert(stream);
 
-	if (stream->allowed_size && size > stream->allowed_size)
+	if (stream->allowed_size && size > stream->allowed_size) {
+		free(data);
 		return EINVAL;
+	}
 
-	fibril_mutex_lock(&stream->guard);
-	while (stream->allowed_size &&
-	    (audio_pipe_bytes(&stream->fifo) + size > stream->allowed_size)) {
-		fibril_condvar_wait(&stream->change, &stream->guard);
-
+	size_t done = audio_ring_write(&stream->ring, data, size);
+	if (done < size) {
+		stream_wait_begin(stream);
+		while (true) {
+			done += audio_ring_write(&stream->ring, data + done,
+			    size - done);
+			if (done == size)
+				break;
+			fibril_condvar_wait(&stream->change, &stream->guard);
+		}
+		stream_wait_end(stream);
 	}
 
-	const errno_t ret =
-	    audio_pipe_push_data(&stream->fifo, data, size, stream->format);
-	fibril_mutex_unlock(&stream->guard);
-	if (ret == EOK)
-		fibril_condvar_signal(&stream->change);
-	return ret;
+	free(data);
+	return EOK;
 }
 
 /**
@@ -329,23 +446,18 @@ errno_t hound_ctx_stream_read(hound_ctx_stream_t *stream, void *data, size_t siz
 {
 	assert(stream);
 
-	if (stream->allowed_size && size > stream->allowed_size)
+	if (size > stream->ring.size)
 		return EINVAL;
 
-	fibril_mutex_lock(&stream->guard);
-	while (audio_pipe_bytes(&stream->fifo) < size) {
-		fibril_condvar_wait(&stream->change, &stream->guard);
+	if (audio_ring_used(&stream->ring) < size) {
+		stream_wait_begin(stream);
+		while (audio_ring_used(&stream->ring) < size)
+			fibril_condvar_wait(&stream->change, &stream->guard);
+		stream_wait_end(stream);
 	}
 
-	pcm_format_silence(data, size, &stream->format);
-	const size_t ret =
-	    audio_pipe_mix_data(&stream->fifo, data, size, &stream->format);
-	fibril_mutex_unlock(&stream->guard);
-	if (ret > 0) {
-		fibril_condvar_signal(&stream->change);
-		return EOK;
-	}
-	return EEMPTY;
+	const size_t ret = audio_ring_read(&stream->ring, data, size);
+	return ret > 0 ? EOK : EEMPTY;
 }
 
 /**
@@ -355,16 +467,48 @@ errno_t hound_ctx_stream_read(hound_ctx_stream_t *stream, void *data, size_t siz
  * @param size Size of the @p data buffer.
  * @param format Destination data format.
  * @return Size of the destination buffer touch with stream's data.
+ *
+ * This is the consumer side of the stream ring, it never blocks.
  */
 size_t hound_ctx_stream_add_self(hound_ctx_stream_t *stream, void *data,
     size_t size, const pcm_format_t *f)
 {
 	assert(stream);
-	fibril_mutex_lock(&stream->guard);
-	const size_t ret = audio_pipe_mix_data(&stream->fifo, data, size, f);
-	fibril_condvar_signal(&stream->change);
-	fibril_mutex_unlock(&stream->guard);
-	return ret;
+	const size_t src_frame_size = pcm_format_frame_size(&stream->format);
+	const size_t dst_frame_size = pcm_format_frame_size(f);
+	const size_t needed_frames = size / dst_frame_size;
+	size_t done = 0;
+
+	stream_update_latency(stream, audio_ring_used(&stream->ring));
+
+	while (done < needed_frames) {
+		const void *src;
+		const size_t available =
+		    audio_ring_read_begin(&stream->ring, &src) / src_frame_size;
+		if (available == 0)
+			break;
+		const size_t n = min(available, needed_frames - done);
+		pcm_format_convert_and_mix(data + done * dst_frame_size,
+		    n * dst_frame_size, src, n * src_frame_size,
+		    &stream->format, f);
+		audio_ring_read_end(&stream->ring, n * src_frame_size);
+		done += n;
+	}
+
+	stream->stats.frames += done;
+	if (done < needed_frames) {
+		/* Count each starvation period once */
+		if (!stream->starved &&
+		    !(stream->flags & HOUND_STREAM_IGNORE_UNDERFLOW))
+			++stream->stats.underruns;
+		stream->starved = true;
+	} else {
+		stream->starved = false;
+	}
+
+	if (done > 0)
+		stream_wakeup(stream);
+	return done * dst_frame_size;
 }
 
 /**
@@ -375,10 +519,33 @@ void hound_ctx_stream_drain(hound_ctx_stream_t *stream)
 {
 	assert(stream);
 	log_debug("Draining stream");
-	fibril_mutex_lock(&stream->guard);
-	while (audio_pipe_bytes(&stream->fifo))
+	const size_t frame_size = pcm_format_frame_size(&stream->format);
+	stream_wait_begin(stream);
+	while (audio_ring_used(&stream->ring) >= frame_size)
 		fibril_condvar_wait(&stream->change, &stream->guard);
-	fibril_mutex_unlock(&stream->guard);
+	stream_wait_end(stream);
+}
+
+/**
+ * Get statistics of all context streams.
+ * @param ctx hound context.
+ * @param stats Array to fill.
+ * @param count Size of the @p stats array.
+ * @return Number of streams of the context, may be larger than @p count.
+ */
+size_t hound_ctx_get_stream_stats(hound_ctx_t *ctx,
+    hound_stream_stats_t *stats, size_t count)
+{
+	assert(ctx);
+	size_t i = 0;
+	fibril_mutex_lock(&ctx->guard);
+	list_foreach(ctx->streams, link, hound_ctx_stream_t, stream) {
+		if (i < count)
+			stats[i] = stream->stats;
+		++i;
+	}
+	fibril_mutex_unlock(&ctx->guard);
+	return i;
 }
 
 /**
@@ -445,12 +612,6 @@ errno_t new_data(audio_sink_t *sink)
 		fibril_mutex_unlock(&ctx->guard);
 		return ENOMEM;
 	}
-	audio_data_t *adata = audio_data_create(buffer, bsize, sink->format);
-	if (!adata) {
-		fibril_mutex_unlock(&ctx->guard);
-		free(buffer);
-		return ENOMEM;
-	}
 
 	/* mix data */
 	pcm_format_silence(buffer, bsize, &sink->format);
@@ -461,12 +622,13 @@ errno_t new_data(audio_sink_t *sink)
 	}
 	/* push to all streams */
 	list_foreach(ctx->streams, link, hound_ctx_stream_t, stream) {
-		const errno_t ret = stream_push_data(stream, adata);
+		const errno_t ret =
+		    stream_push_data(stream, buffer, bsize, &sink->format);
 		if (ret != EOK)
 			log_error("Failed to push data to stream: %s",
 			    str_error(ret));
 	}
-	audio_data_unref(adata);
+	free(buffer);
 	fibril_mutex_unlock(&ctx->guard);
 	return ENOTSUP;
 }
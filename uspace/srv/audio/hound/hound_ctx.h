@@ -76,6 +76,8 @@ errno_t hound_ctx_stream_read(hound_ctx_stream_t *stream, void *buffer, size_t s
 size_t hound_ctx_stream_add_self(hound_ctx_stream_t *stream, void *data,
     size_t size, const pcm_format_t *f);
 void hound_ctx_stream_drain(hound_ctx_stream_t *stream);
+size_t hound_ctx_get_stream_stats(hound_ctx_t *ctx,
+    hound_stream_stats_t *stats, size_t count);
 
 #endif
 
@@ -39,11 +39,13 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <str.h>
 #include <str_error.h>
 #include <hound/server.h>
 #include <hound/protocol.h>
 #include <task.h>
 
+#include "audio_device.h"
 #include "hound.h"
 
 #define NAMESPACE "audio"
@@ -66,10 +68,30 @@ static void scan_for_devices(void *arg)
 	hound_server_devices_iterate(device_callback);
 }
 
+static void print_syntax(void)
+{
+	printf("Syntax: %s [-p <period>]\n", NAME);
+	printf("\t-p <period>\tDevice fragment length in milliseconds\n");
+}
+
 int main(int argc, char **argv)
 {
 	printf("%s: HelenOS sound service\n", NAME);
 
+	if (argc == 3 && str_cmp(argv[1], "-p") == 0) {
+		uint32_t period;
+		if (str_uint32_t(argv[2], NULL, 10, true, &period) != EOK ||
+		    period == 0) {
+			printf("%s: Invalid period '%s'.\n", NAME, argv[2]);
+			print_syntax();
+			return 1;
+		}
+		audio_device_set_period(MSEC2USEC(period));
+	} else if (argc != 1) {
+		print_syntax();
+		return 1;
+	}
+
 	if (log_init(NAME) != EOK) {
 		printf(NAME ": Failed to initialize logging.\n");
 		return 1;
@@ -54,9 +54,68 @@
 #include <loc.h>
 #include <macros.h>
 #include <inttypes.h>
+#include <byteorder.h>
+#include <inflate.h>
+#include <mem.h>
+#include <perf.h>
+#include <stdint.h>
+#include <stdlib.h>
 
 #define NAME  "rd"
 
+/** Magic identifying a compressed ramdisk image */
+#define RD_CIMG_MAGIC  "HORDCIMG"
+
+/** Compressed image format version */
+#define RD_CIMG_VERSION  1
+
+/** Maximum number of clean decompressed chunks kept in memory */
+#define RD_CACHE_CHUNKS  64
+
+/** Compressed image header.
+ *
+ * All fields are little-endian. The header is followed by a table
+ * of @c chunks chunk descriptors. Chunks are decompressed on first
+ * access, all-zero chunks are not stored at all and identical chunks
+ * can share their data.
+ */
+typedef struct {
+	/** RD_CIMG_MAGIC */
+	uint8_t magic[8];
+	/** RD_CIMG_VERSION */
+	uint32_t version;
+	/** Size of uncompressed chunk in bytes (multiple of block size) */
+	uint32_t chunk_size;
+	/** Size of uncompressed image in bytes */
+	uint64_t img_size;
+	/** Number of chunks */
+	uint32_t chunks;
+	uint32_t reserved;
+} __attribute__((packed)) rd_cimg_header_t;
+
+/** Compressed image chunk descriptor. */
+typedef struct {
+	/** Offset of chunk data from the start of the image */
+	uint32_t offset;
+	/**
+	 * Length of chunk data. Zero for an all-zero chunk, chunk size for
+	 * a chunk stored uncompressed, otherwise raw deflate stream.
+	 */
+	uint32_t length;
+} __attribute__((packed)) rd_cimg_chunk_t;
+
+/** Chunk of a compressed image. */
+typedef struct {
+	/** Offset of chunk data in the image */
+	size_t offset;
+	/** Length of chunk data in the image (see rd_cimg_chunk_t) */
+	size_t length;
+	/** Decompressed or written data or @c NULL */
+	uint8_t *data;
+	/** Chunk has been written, @c data is the only copy */
+	bool dirty;
+} rd_chunk_t;
+
 /** Pointer to the ramdisk's image */
 static void *rd_addr = AS_AREA_ANY;
 
@@ -66,6 +125,18 @@ static size_t rd_size;
 /** Block size */
 static const size_t block_size = 512;
 
+/** Chunks of compressed image or @c NULL if the image is not compressed */
+static rd_chunk_t *rd_chunks = NULL;
+
+/** Size of uncompressed chunk */
+static size_t rd_chunk_size;
+
+/** Clean decompressed chunks, replaced in round-robin order */
+static rd_chunk_t *rd_cache[RD_CACHE_CHUNKS];
+
+/** Next entry of rd_cache to replace */
+static size_t rd_cache_next;
+
 static errno_t rd_open(bd_srvs_t *, bd_srv_t *);
 static errno_t rd_close(bd_srv_t *);
 static errno_t rd_read_blocks(bd_srv_t *, aoff64_t, size_t, void *, size_t);
@@ -110,41 +181,316 @@ static errno_t rd_close(bd_srv_t *bd)
 	return EOK;
 }
 
+/** Load chunk data from the compressed image.
+ *
+ * @param chunk Chunk
+ * @param dst   Buffer of chunk size
+ * @return EOK on success or an error code
+ */
+static errno_t rd_chunk_load(rd_chunk_t *chunk, uint8_t *dst)
+{
+	uint8_t *src = (uint8_t *) rd_addr + chunk->offset;
+
+	if (chunk->length == 0) {
+		memset(dst, 0, rd_chunk_size);
+		return EOK;
+	}
+
+	if (chunk->length == rd_chunk_size) {
+		memcpy(dst, src, rd_chunk_size);
+		return EOK;
+	}
+
+	return inflate(src, chunk->length, dst, rd_chunk_size);
+}
+
+/** Get chunk data for reading.
+ *
+ * Decompress the chunk if needed and keep it among the clean cached
+ * chunks, possibly evicting another one.
+ *
+ * @param chunk Chunk
+ * @param rdata Place to store pointer to data or @c NULL if the chunk
+ *              contains only zeros
+ * @return EOK on success or an error code
+ */
+static errno_t rd_chunk_get(rd_chunk_t *chunk, uint8_t **rdata)
+{
+	if (chunk->data != NULL) {
+		*rdata = chunk->data;
+		return EOK;
+	}
+
+	if (chunk->length == 0) {
+		*rdata = NULL;
+		return EOK;
+	}
+
+	if (chunk->length == rd_chunk_size) {
+		/* Stored chunk can be used in place */
+		*rdata = (uint8_t *) rd_addr + chunk->offset;
+		return EOK;
+	}
+
+	uint8_t *data = malloc(rd_chunk_size);
+	if (data == NULL)
+		return ENOMEM;
+
+	errno_t rc = rd_chunk_load(chunk, data);
+	if (rc != EOK) {
+		free(data);
+		return EIO;
+	}
+
+	rd_chunk_t *victim = rd_cache[rd_cache_next];
+	if ((victim != NULL) && (!victim->dirty)) {
+		free(victim->data);
+		victim->data = NULL;
+	}
+
+	rd_cache[rd_cache_next] = chunk;
+	rd_cache_next = (rd_cache_next + 1) % RD_CACHE_CHUNKS;
+
+	chunk->data = data;
+	*rdata = data;
+	return EOK;
+}
+
+/** Make private writable copy of chunk data.
+ *
+ * @param chunk Chunk
+ * @return EOK on success or an error code
+ */
+static errno_t rd_chunk_cow(rd_chunk_t *chunk)
+{
+	if (chunk->dirty)
+		return EOK;
+
+	if (chunk->data == NULL) {
+		uint8_t *data = malloc(rd_chunk_size);
+		if (data == NULL)
+			return ENOMEM;
+
+		errno_t rc = rd_chunk_load(chunk, data);
+		if (rc != EOK) {
+			free(data);
+			return EIO;
+		}
+
+		chunk->data = data;
+	}
+
+	/*
+	 * A clean cached copy simply becomes the private copy, it is
+	 * skipped when its cache entry is replaced.
+	 */
+	chunk->dirty = true;
+	return EOK;
+}
+
+/** Drop private copy of chunk which has been overwritten with zeros. */
+static void rd_chunk_dedup(rd_chunk_t *chunk)
+{
+	for (size_t i = 0; i < rd_chunk_size; i++) {
+		if (chunk->data[i] != 0)
+			return;
+	}
+
+	for (size_t i = 0; i < RD_CACHE_CHUNKS; i++) {
+		if (rd_cache[i] == chunk)
+			rd_cache[i] = NULL;
+	}
+
+	free(chunk->data);
+	chunk->data = NULL;
+	chunk->dirty = false;
+	chunk->length = 0;
+}
+
+/** Read from compressed image.
+ *
+ * @param pos  Byte position in the uncompressed image
+ * @param buf  Destination buffer
+ * @param size Number of bytes to read
+ * @return EOK on success or an error code
+ */
+static errno_t rd_cimg_read(size_t pos, uint8_t *buf, size_t size)
+{
+	while (size > 0) {
+		rd_chunk_t *chunk = &rd_chunks[pos / rd_chunk_size];
+		size_t offs = pos % rd_chunk_size;
+		size_t len = min(size, rd_chunk_size - offs);
+		uint8_t *data;
+
+		errno_t rc = rd_chunk_get(chunk, &data);
+		if (rc != EOK)
+			return rc;
+
+		if (data != NULL)
+			memcpy(buf, data + offs, len);
+		else
+			memset(buf, 0, len);
+
+		pos += len;
+		buf += len;
+		size -= len;
+	}
+
+	return EOK;
+}
+
+/** Write to compressed image.
+ *
+ * Written chunks are kept as private copies in memory, the image
+ * itself is never modified.
+ *
+ * @param pos  Byte position in the uncompressed image
+ * @param buf  Source buffer
+ * @param size Number of bytes to write
+ * @return EOK on success or an error code
+ */
+static errno_t rd_cimg_write(size_t pos, const uint8_t *buf, size_t size)
+{
+	while (size > 0) {
+		rd_chunk_t *chunk = &rd_chunks[pos / rd_chunk_size];
+		size_t offs = pos % rd_chunk_size;
+		size_t len = min(size, rd_chunk_size - offs);
+
+		errno_t rc = rd_chunk_cow(chunk);
+		if (rc != EOK)
+			return rc;
+
+		memcpy(chunk->data + offs, buf, len);
+		rd_chunk_dedup(chunk);
+
+		pos += len;
+		buf += len;
+		size -= len;
+	}
+
+	return EOK;
+}
+
 /** Read blocks from the device. */
 static errno_t rd_read_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt, void *buf,
     size_t size)
 {
+	errno_t rc = EOK;
+
 	if ((ba + cnt) * block_size > rd_size) {
 		/* Reading past the end of the device. */
 		return ELIMIT;
 	}
 
+	if (rd_chunks != NULL) {
+		/* Decompression modifies the chunk cache */
+		fibril_rwlock_write_lock(&rd_lock);
+		rc = rd_cimg_read(ba * block_size, buf, min(block_size * cnt, size));
+		fibril_rwlock_write_unlock(&rd_lock);
+		return rc;
+	}
+
 	fibril_rwlock_read_lock(&rd_lock);
 	memcpy(buf, rd_addr + ba * block_size, min(block_size * cnt, size));
 	fibril_rwlock_read_unlock(&rd_lock);
 
-	return EOK;
+	return rc;
 }
 
 /** Write blocks to the device. */
 static errno_t rd_write_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
     const void *buf, size_t size)
 {
+	errno_t rc = EOK;
+
 	if ((ba + cnt) * block_size > rd_size) {
 		/* Writing past the end of the device. */
 		return ELIMIT;
 	}
 
 	fibril_rwlock_write_lock(&rd_lock);
-	memcpy(rd_addr + ba * block_size, buf, min(block_size * cnt, size));
+	if (rd_chunks != NULL)
+		rc = rd_cimg_write(ba * block_size, buf, min(block_size * cnt, size));
+	else
+		memcpy(rd_addr + ba * block_size, buf, min(block_size * cnt, size));
 	fibril_rwlock_write_unlock(&rd_lock);
 
+	return rc;
+}
+
+/** Set up compressed image if the ramdisk contains one.
+ *
+ * @param size Size of the ramdisk image
+ * @return EOK on success, ENOENT if the image is not compressed,
+ *         other error code if the image is invalid
+ */
+static errno_t rd_cimg_init(size_t size)
+{
+	const rd_cimg_header_t *hdr = (const rd_cimg_header_t *) rd_addr;
+
+	if ((size < sizeof(rd_cimg_header_t)) ||
+	    (memcmp(hdr->magic, RD_CIMG_MAGIC, sizeof(hdr->magic)) != 0))
+		return ENOENT;
+
+	if (uint32_t_le2host(hdr->version) != RD_CIMG_VERSION)
+		return ENOTSUP;
+
+	size_t chunk_size = uint32_t_le2host(hdr->chunk_size);
+	uint64_t isize = uint64_t_le2host(hdr->img_size);
+	size_t chunks = uint32_t_le2host(hdr->chunks);
+
+	if ((chunk_size == 0) || (chunk_size % block_size != 0) ||
+	    (isize > SIZE_MAX - chunk_size) ||
+	    (chunks != (isize + chunk_size - 1) / chunk_size) ||
+	    (chunks > (size - sizeof(rd_cimg_header_t)) /
+	    sizeof(rd_cimg_chunk_t)))
+		return EINVAL;
+
+	rd_chunks = calloc(chunks, sizeof(rd_chunk_t));
+	if (rd_chunks == NULL)
+		return ENOMEM;
+
+	const rd_cimg_chunk_t *desc = (const rd_cimg_chunk_t *) (hdr + 1);
+	size_t nzero = 0;
+	size_t nstored = 0;
+
+	for (size_t i = 0; i < chunks; i++) {
+		size_t offset = uint32_t_le2host(desc[i].offset);
+		size_t length = uint32_t_le2host(desc[i].length);
+
+		if ((length > chunk_size) || (offset > size) ||
+		    (length > size - offset)) {
+			free(rd_chunks);
+			rd_chunks = NULL;
+			return EINVAL;
+		}
+
+		if (length == 0)
+			nzero++;
+		else if (length == chunk_size)
+			nstored++;
+
+		rd_chunks[i].offset = offset;
+		rd_chunks[i].length = length;
+	}
+
+	rd_chunk_size = chunk_size;
+	rd_size = ALIGN_UP(isize, block_size);
+
+	printf("%s: Compressed image, %zu chunks of %zu bytes "
+	    "(%zu zero, %zu stored), %zu bytes expand to %" PRIu64 " bytes\n",
+	    NAME, chunks, chunk_size, nzero, nstored, size, isize);
+
 	return EOK;
 }
 
 /** Prepare the ramdisk image for operation. */
 static bool rd_init(void)
 {
+	stopwatch_t sw;
+	stopwatch_init(&sw);
+	stopwatch_start(&sw);
+
 	sysarg_t size;
 	errno_t ret = sysinfo_get_value("rd.size", &size);
 	if ((ret != EOK) || (size == 0)) {
@@ -173,6 +519,13 @@ static bool rd_init(void)
 	printf("%s: Found RAM disk at %p, %" PRIun " bytes\n", NAME,
 	    (void *) addr_phys, size);
 
+	ret = rd_cimg_init(size);
+	if ((ret != EOK) && (ret != ENOENT)) {
+		printf("%s: Invalid compressed RAM disk image: %s\n", NAME,
+		    str_error(ret));
+		return false;
+	}
+
 	bd_srvs_init(&bd_srvs);
 	bd_srvs.ops = &rd_bd_ops;
 
@@ -192,6 +545,10 @@ static bool rd_init(void)
 
 	fibril_rwlock_initialize(&rd_lock);
 
+	stopwatch_stop(&sw);
+	printf("%s: RAM disk ready in %lld us\n", NAME,
+	    NSEC2USEC(stopwatch_get_nanos(&sw)));
+
 	return true;
 }
 
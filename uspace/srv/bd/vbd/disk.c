@@ -34,6 +34,7 @@
  */
 
 #include <adt/list.h>
+#include <bd.h>
 #include <bd_srv.h>
 #include <block.h>
 #include <errno.h>
@@ -50,6 +51,9 @@
 #include "disk.h"
 #include "types/vbd.h"
 
+/** Maximum number of submitted requests executed concurrently per client */
+#define VBDS_BD_QDEPTH 32
+
 static fibril_mutex_t vbds_disks_lock;
 static list_t vbds_disks; /* of vbds_disk_t */
 static fibril_mutex_t vbds_parts_lock;
@@ -68,6 +72,10 @@ static errno_t vbds_bd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *,
     size_t);
 static errno_t vbds_bd_get_block_size(bd_srv_t *, size_t *);
 static errno_t vbds_bd_get_num_blocks(bd_srv_t *, aoff64_t *);
+static errno_t vbds_bd_share_buf(bd_srv_t *);
+static errno_t vbds_bd_fwd_begin(bd_srv_t *, aoff64_t, size_t, async_exch_t **,
+    aoff64_t *);
+static void vbds_bd_fwd_end(bd_srv_t *, async_exch_t *);
 
 static errno_t vbds_bsa_translate(vbds_part_t *, aoff64_t, size_t, aoff64_t *);
 
@@ -90,7 +98,10 @@ static bd_ops_t vbds_bd_ops = {
 	.sync_cache = vbds_bd_sync_cache,
 	.write_blocks = vbds_bd_write_blocks,
 	.get_block_size = vbds_bd_get_block_size,
-	.get_num_blocks = vbds_bd_get_num_blocks
+	.get_num_blocks = vbds_bd_get_num_blocks,
+	.share_buf = vbds_bd_share_buf,
+	.fwd_begin = vbds_bd_fwd_begin,
+	.fwd_end = vbds_bd_fwd_end
 };
 
 /** Provide disk access to liblabel */
@@ -331,6 +342,7 @@ static errno_t vbds_part_add(vbds_disk_t *disk, label_part_t *lpart,
 	bd_srvs_init(&part->bds);
 	part->bds.ops = &vbds_bd_ops;
 	part->bds.sarg = part;
+	part->bds.qdepth = VBDS_BD_QDEPTH;
 
 	if (lpinfo.pkind != lpk_extended) {
 		rc = vbds_part_svc_register(part);
@@ -464,6 +476,40 @@ errno_t vbds_disk_discovery_start(void)
 	return vbds_disks_check_new();
 }
 
+/** Open connection for forwarding partition I/O to disk.
+ *
+ * Failure is not fatal, I/O is then served through the block library.
+ */
+static void vbds_disk_fwd_open(vbds_disk_t *disk)
+{
+	async_sess_t *sess;
+	errno_t rc;
+
+	sess = loc_service_connect(disk->svc_id, INTERFACE_BLOCK, 0);
+	if (sess == NULL)
+		return;
+
+	rc = bd_open(sess, &disk->fwd_bd);
+	if (rc != EOK) {
+		async_hangup(sess);
+		disk->fwd_bd = NULL;
+	}
+}
+
+/** Close connection for forwarding partition I/O to disk. */
+static void vbds_disk_fwd_close(vbds_disk_t *disk)
+{
+	async_sess_t *sess;
+
+	if (disk->fwd_bd == NULL)
+		return;
+
+	sess = disk->fwd_bd->sess;
+	bd_close(disk->fwd_bd);
+	async_hangup(sess);
+	disk->fwd_bd = NULL;
+}
+
 errno_t vbds_disk_add(service_id_t sid)
 {
 	label_t *label = NULL;
@@ -538,6 +584,8 @@ errno_t vbds_disk_add(service_id_t sid)
 	disk->nblocks = nblocks;
 	disk->present = true;
 
+	vbds_disk_fwd_open(disk);
+
 	list_initialize(&disk->parts);
 	list_append(&disk->ldisks, &vbds_disks);
 
@@ -575,6 +623,7 @@ errno_t vbds_disk_remove(service_id_t sid)
 	}
 
 	list_remove(&disk->ldisks);
+	vbds_disk_fwd_close(disk);
 	label_close(disk->label);
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "block_fini(%zu)", sid);
 	block_fini(sid);
@@ -956,6 +1005,8 @@ static errno_t vbds_bd_open(bd_srvs_t *bds, bd_srv_t *bd)
 static errno_t vbds_bd_close(bd_srv_t *bd)
 {
 	vbds_part_t *part = bd_srv_part(bd);
+	bd_t *dbd = (bd_t *)bd->carg;
+	async_sess_t *sess;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "vbds_bd_close()");
 
@@ -964,14 +1015,87 @@ static errno_t vbds_bd_close(bd_srv_t *bd)
 	fibril_rwlock_write_lock(&part->lock);
 	part->open_cnt--;
 	fibril_rwlock_write_unlock(&part->lock);
+
+	if (dbd != NULL) {
+		sess = dbd->sess;
+		bd_close(dbd);
+		async_hangup(sess);
+		bd->carg = NULL;
+	}
+
+	return EOK;
+}
+
+/** Client has shared a buffer.
+ *
+ * Open a separate connection to the disk and share the same buffer with
+ * it. Requests whose data lies in the buffer are then passed through to
+ * the disk with their offset unchanged and the data never passes through
+ * VBD. If the disk does not accept the buffer, such requests are served
+ * through the block library as usual.
+ */
+static errno_t vbds_bd_share_buf(bd_srv_t *bd)
+{
+	vbds_part_t *part = bd_srv_part(bd);
+	async_sess_t *sess;
+	bd_t *dbd;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "vbds_bd_share_buf()");
+
+	sess = loc_service_connect(part->disk->svc_id, INTERFACE_BLOCK, 0);
+	if (sess == NULL)
+		return EOK;
+
+	rc = bd_open(sess, &dbd);
+	if (rc != EOK) {
+		async_hangup(sess);
+		return EOK;
+	}
+
+	rc = bd_share_buf(dbd, bd->shbuf, bd->shbuf_size);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Disk %s does not accept "
+		    "shared buffer: %s", part->disk->svc_name, str_error(rc));
+		bd_close(dbd);
+		async_hangup(sess);
+		return EOK;
+	}
+
+	bd->carg = dbd;
 	return EOK;
 }
 
+/** Get disk connection to pass a request through.
+ *
+ * @param bd Block device server
+ * @param buf Request data
+ * @param size Size of request data
+ * @param roffs Place to store offset of data in the shared buffer
+ * @return Disk connection or @c NULL if request cannot be passed through
+ */
+static bd_t *vbds_bd_passthru(bd_srv_t *bd, const void *buf, size_t size,
+    size_t *roffs)
+{
+	const char *shbuf = (const char *)bd->shbuf;
+	const char *data = (const char *)buf;
+
+	if (bd->carg == NULL || data < shbuf ||
+	    data + size > shbuf + bd->shbuf_size)
+		return NULL;
+
+	*roffs = data - shbuf;
+	return (bd_t *)bd->carg;
+}
+
 static errno_t vbds_bd_read_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
     void *buf, size_t size)
 {
 	vbds_part_t *part = bd_srv_part(bd);
 	aoff64_t gba;
+	bd_t *dbd;
+	bd_req_t req;
+	size_t offs;
 	errno_t rc;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "vbds_bd_read_blocks()");
@@ -987,12 +1111,65 @@ static errno_t vbds_bd_read_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
 		return ELIMIT;
 	}
 
-	rc = block_read_direct(part->disk->svc_id, gba, cnt, buf);
+	dbd = vbds_bd_passthru(bd, buf, size, &offs);
+	if (dbd != NULL) {
+		rc = bd_submit_read(dbd, gba, cnt, offs, size, &req);
+		if (rc == EOK)
+			rc = bd_req_wait(&req);
+	} else {
+		rc = block_read_direct(part->disk->svc_id, gba, cnt, buf);
+	}
+
 	fibril_rwlock_read_unlock(&part->lock);
 
 	return rc;
 }
 
+/** Begin forwarding a read or write request to the disk.
+ *
+ * The partition lock is held until vbds_bd_fwd_end() so that the
+ * partition cannot change while the data is being transferred.
+ */
+static errno_t vbds_bd_fwd_begin(bd_srv_t *bd, aoff64_t ba, size_t cnt,
+    async_exch_t **rexch, aoff64_t *rba)
+{
+	vbds_part_t *part = bd_srv_part(bd);
+	async_exch_t *exch;
+	aoff64_t gba;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "vbds_bd_fwd_begin()");
+	fibril_rwlock_read_lock(&part->lock);
+
+	if (part->disk->fwd_bd == NULL) {
+		fibril_rwlock_read_unlock(&part->lock);
+		return ENOTSUP;
+	}
+
+	if (vbds_bsa_translate(part, ba, cnt, &gba) != EOK) {
+		fibril_rwlock_read_unlock(&part->lock);
+		return ELIMIT;
+	}
+
+	exch = async_exchange_begin(part->disk->fwd_bd->sess);
+	if (exch == NULL) {
+		fibril_rwlock_read_unlock(&part->lock);
+		return ENOTSUP;
+	}
+
+	*rexch = exch;
+	*rba = gba;
+	return EOK;
+}
+
+/** End forwarding a request to the disk. */
+static void vbds_bd_fwd_end(bd_srv_t *bd, async_exch_t *exch)
+{
+	vbds_part_t *part = bd_srv_part(bd);
+
+	async_exchange_end(exch);
+	fibril_rwlock_read_unlock(&part->lock);
+}
+
 static errno_t vbds_bd_sync_cache(bd_srv_t *bd, aoff64_t ba, size_t cnt)
 {
 	vbds_part_t *part = bd_srv_part(bd);
@@ -1022,6 +1199,9 @@ static errno_t vbds_bd_write_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
 {
 	vbds_part_t *part = bd_srv_part(bd);
 	aoff64_t gba;
+	bd_t *dbd;
+	bd_req_t req;
+	size_t offs;
 	errno_t rc;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "vbds_bd_write_blocks()");
@@ -1037,7 +1217,15 @@ static errno_t vbds_bd_write_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
 		return ELIMIT;
 	}
 
-	rc = block_write_direct(part->disk->svc_id, gba, cnt, buf);
+	dbd = vbds_bd_passthru(bd, buf, size, &offs);
+	if (dbd != NULL) {
+		rc = bd_submit_write(dbd, gba, cnt, offs, size, &req);
+		if (rc == EOK)
+			rc = bd_req_wait(&req);
+	} else {
+		rc = block_write_direct(part->disk->svc_id, gba, cnt, buf);
+	}
+
 	fibril_rwlock_read_unlock(&part->lock);
 	return rc;
 }
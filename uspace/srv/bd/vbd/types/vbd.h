@@ -38,6 +38,7 @@
 #define TYPES_VBDS_H_
 
 #include <adt/list.h>
+#include <bd.h>
 #include <bd_srv.h>
 #include <label/label.h>
 #include <loc.h>
@@ -103,6 +104,8 @@ typedef struct vbds_disk {
 	aoff64_t nblocks;
 	/** Used to mark disks still present during re-discovery */
 	bool present;
+	/** Connection for forwarding partition I/O or @c NULL */
+	bd_t *fwd_bd;
 } vbds_disk_t;
 
 #endif
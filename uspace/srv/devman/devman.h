@@ -42,6 +42,7 @@
 #include <fibril_synch.h>
 #include <refcount.h>
 #include <async.h>
+#include <time.h>
 
 #include "util.h"
 
@@ -61,6 +62,16 @@ typedef struct {
 	struct driver *driver;
 } client_t;
 
+/** Driver match ID in the index of match IDs. */
+typedef struct {
+	/** Link in driver_list_t.match_index */
+	ht_link_t link;
+	/** Match ID of the driver */
+	match_id_t *mid;
+	/** The driver */
+	struct driver *drv;
+} match_index_entry_t;
+
 /** Representation of device driver. */
 typedef struct driver {
 	/** Pointers to previous and next drivers in a linked list. */
@@ -84,6 +95,20 @@ typedef struct driver {
 	match_id_list_t match_ids;
 	/** List of devices controlled by this driver. */
 	list_t devices;
+	/** Entries of driver's match IDs in the index of match IDs. */
+	match_index_entry_t *match_index;
+
+	/** Number of devices being passed to the driver. */
+	size_t dev_add_pending;
+	/** Signalled when passing a device to the driver finishes. */
+	fibril_condvar_t dev_add_cv;
+
+	/** Time when the driver was spawned. */
+	struct timespec spawn_time;
+	/** Time when the driver registered with the device manager. */
+	struct timespec reg_time;
+	/** Task ID of the running driver. */
+	task_id_t task_id;
 
 	/**
 	 * Fibril mutex for this driver - driver state, list of devices, session.
@@ -99,6 +124,10 @@ typedef struct driver_list {
 	fibril_mutex_t drivers_mutex;
 	/** Next free handle */
 	devman_handle_t next_handle;
+	/** Driver match IDs indexed by match ID string */
+	hash_table_t match_index;
+	/** Time when the list was initialized, start of driver timeline */
+	struct timespec start_time;
 } driver_list_t;
 
 /** Device state */
@@ -31,6 +31,7 @@
  * @{
  */
 
+#include <boottrace.h>
 #include <dirent.h>
 #include <errno.h>
 #include <io/log.h>
@@ -47,21 +48,32 @@
 #include "match.h"
 #include "main.h"
 
+/** Device being passed to a driver by a separate fibril. */
+typedef struct {
+	driver_t *driver;
+	dev_node_t *dev;
+	dev_tree_t *tree;
+} dev_pass_t;
+
 static errno_t driver_reassign_fibril(void *);
 
 /**
  * Initialize the list of device driver's.
  *
  * @param drv_list the list of device driver's.
+ * @return True on success, false if out of memory.
  *
  */
-void init_driver_list(driver_list_t *drv_list)
+bool init_driver_list(driver_list_t *drv_list)
 {
 	assert(drv_list != NULL);
 
 	list_initialize(&drv_list->drivers);
 	fibril_mutex_initialize(&drv_list->drivers_mutex);
 	drv_list->next_handle = 1;
+	getuptime(&drv_list->start_time);
+
+	return match_index_create(&drv_list->match_index);
 }
 
 /** Allocate and initialize a new driver structure.
@@ -80,16 +92,48 @@ driver_t *create_driver(void)
  *
  * @param drivers_list	List of drivers.
  * @param drv		Driver structure.
+ * @return		EOK on success, ENOMEM if out of memory.
  */
-void add_driver(driver_list_t *drivers_list, driver_t *drv)
+errno_t add_driver(driver_list_t *drivers_list, driver_t *drv)
 {
 	fibril_mutex_lock(&drivers_list->drivers_mutex);
+
+	errno_t rc = match_index_add(&drivers_list->match_index, drv);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&drivers_list->drivers_mutex);
+		return rc;
+	}
+
 	list_append(&drv->drivers, &drivers_list->drivers);
 	drv->handle = drivers_list->next_handle++;
 	fibril_mutex_unlock(&drivers_list->drivers_mutex);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Driver `%s' was added to the list of available "
 	    "drivers.", drv->name);
+	return EOK;
+}
+
+/** Log driver start event in the driver timeline.
+ *
+ * Times are relative to the start of the device manager, latencies
+ * are relative to spawning the driver.
+ *
+ * @param drivers_list	List of drivers.
+ * @param drv		Driver structure.
+ */
+static void driver_timeline_log(driver_list_t *drivers_list, driver_t *drv)
+{
+	struct timespec now;
+
+	getuptime(&now);
+
+	log_msg(LOG_DEFAULT, LVL_NOTE, "Timeline: driver `%s' running at "
+	    "+%lld ms (spawned at +%lld ms, registered after %lld ms, "
+	    "initialized after %lld ms).", drv->name,
+	    NSEC2MSEC(ts_sub_diff(&now, &drivers_list->start_time)),
+	    NSEC2MSEC(ts_sub_diff(&drv->spawn_time, &drivers_list->start_time)),
+	    NSEC2MSEC(ts_sub_diff(&drv->reg_time, &drv->spawn_time)),
+	    NSEC2MSEC(ts_sub_diff(&now, &drv->spawn_time)));
 }
 
 /**
@@ -186,7 +230,14 @@ int lookup_available_drivers(driver_list_t *drivers_list, const char *dir_path)
 		driver_t *drv = create_driver();
 		while ((diren = readdir(dir))) {
 			if (get_driver_info(dir_path, diren->d_name, drv)) {
-				add_driver(drivers_list, drv);
+				if (add_driver(drivers_list, drv) != EOK) {
+					log_msg(LOG_DEFAULT, LVL_ERROR,
+					    "Out of memory adding driver `%s'.",
+					    drv->name);
+					clean_driver(drv);
+					continue;
+				}
+
 				drv_cnt++;
 				drv = create_driver();
 			}
@@ -211,6 +262,10 @@ int lookup_available_drivers(driver_list_t *drivers_list, const char *dir_path)
  * same score in the list of drivers, or a driver with the next best score
  * (greater than zero).
  *
+ * Only drivers sharing a match id with the device can match, so they are
+ * looked up in the index of match ids instead of scoring every driver.
+ * Drivers are ordered by their handles, which follow the list of drivers.
+ *
  * @param drivers_list	The list of drivers, where we look for the driver
  *			suitable for handling the device.
  * @param node		The device node structure of the device.
@@ -219,51 +274,54 @@ int lookup_available_drivers(driver_list_t *drivers_list, const char *dir_path)
  */
 driver_t *find_best_match_driver(driver_list_t *drivers_list, dev_node_t *node)
 {
+	driver_t *cur_drv = node->drv;
+	driver_t *next_drv = NULL;
 	driver_t *best_drv = NULL;
 	int best_score = 0, score = 0;
 	int cur_score;
-	link_t *link;
 
 	fibril_mutex_lock(&drivers_list->drivers_mutex);
 
-	if (node->drv != NULL) {
-		cur_score = get_match_score(node->drv, node);
+	if (cur_drv != NULL)
+		cur_score = get_match_score(cur_drv, node);
+	else
+		cur_score = INT_MAX;
+
+	list_foreach(node->pfun->match_ids.ids, link, match_id_t, dev_id) {
+		ht_link_t *first = hash_table_find(&drivers_list->match_index,
+		    dev_id->id);
+		ht_link_t *item = first;
 
-		link = list_next(&node->drv->drivers, &drivers_list->drivers);
+		while (item != NULL) {
+			match_index_entry_t *entry = hash_table_get_inst(item,
+			    match_index_entry_t, link);
+			driver_t *drv = entry->drv;
 
-		/*
-		 * Find next driver with score equal to the current.
-		 */
-		while (link != NULL) {
-			driver_t *drv = list_get_instance(link, driver_t,
-			    drivers);
 			score = get_match_score(drv, node);
-			if (score == cur_score) {
-				/* Found it */
-				fibril_mutex_unlock(&drivers_list->drivers_mutex);
-				return drv;
+			if (cur_drv != NULL && score == cur_score &&
+			    drv->handle > cur_drv->handle) {
+				/* Next driver with score equal to the current */
+				if (next_drv == NULL ||
+				    drv->handle < next_drv->handle)
+					next_drv = drv;
+			} else if (score < cur_score && (score > best_score ||
+			    (score == best_score && best_drv != NULL &&
+			    drv->handle < best_drv->handle))) {
+				/* Driver with the next best score */
+				best_score = score;
+				best_drv = drv;
 			}
 
-			link = list_next(link, &drivers_list->drivers);
-		}
-
-		/* There is no driver with the same score */
-	} else {
-		cur_score = INT_MAX;
-	}
-
-	/*
-	 * Find driver with the next best score
-	 */
-	list_foreach(drivers_list->drivers, drivers, driver_t, drv) {
-		score = get_match_score(drv, node);
-		if (score > best_score && score < cur_score) {
-			best_score = score;
-			best_drv = drv;
+			item = hash_table_find_next(&drivers_list->match_index,
+			    first, item);
 		}
 	}
 
 	fibril_mutex_unlock(&drivers_list->drivers_mutex);
+
+	if (next_drv != NULL)
+		return next_drv;
+
 	return best_drv;
 }
 
@@ -336,6 +394,7 @@ bool start_driver(driver_t *drv)
 		return false;
 	}
 
+	getuptime(&drv->spawn_time);
 	drv->state = DRIVER_STARTING;
 	return true;
 }
@@ -416,14 +475,67 @@ driver_t *driver_find_by_name(driver_list_t *drv_list, const char *drv_name)
 	return res;
 }
 
+/** Pass a device to a driver and handle probe failure.
+ *
+ * @param driver	The driver to which the device is passed.
+ * @param dev		The device.
+ * @param tree		Device tree.
+ */
+static void pass_device_to_driver(driver_t *driver, dev_node_t *dev,
+    dev_tree_t *tree)
+{
+	add_device(driver, dev, tree);
+
+	/* Device probe failed, need to try next best driver */
+	if (dev->state == DEVICE_NOT_PRESENT) {
+		fibril_mutex_lock(&driver->driver_mutex);
+		list_remove(&dev->driver_devices);
+		fibril_mutex_unlock(&driver->driver_mutex);
+		/* Give an extra reference to driver_reassign_fibril */
+		dev_add_ref(dev);
+		fid_t fid = fibril_create(driver_reassign_fibril, dev);
+		if (fid == 0) {
+			log_msg(LOG_DEFAULT, LVL_ERROR,
+			    "Error creating fibril to assign driver.");
+			dev_del_ref(dev);
+		} else {
+			fibril_add_ready(fid);
+		}
+	}
+}
+
+/** Pass a device to a driver in a separate fibril.
+ *
+ * @param arg		Device being passed (dev_pass_t).
+ */
+static errno_t pass_device_fibril(void *arg)
+{
+	dev_pass_t *pass = (dev_pass_t *) arg;
+	driver_t *driver = pass->driver;
+
+	pass_device_to_driver(driver, pass->dev, pass->tree);
+	dev_del_ref(pass->dev);
+
+	fibril_mutex_lock(&driver->driver_mutex);
+	driver->dev_add_pending--;
+	fibril_condvar_broadcast(&driver->dev_add_cv);
+	fibril_mutex_unlock(&driver->driver_mutex);
+
+	free(pass);
+	return EOK;
+}
+
 /** Notify driver about the devices to which it was assigned.
+ *
+ * The devices are passed to the driver concurrently, each in a separate
+ * fibril. The device tree itself orders them: a child device only
+ * appears once its parent's driver has created the parent function.
  *
  * @param driver	The driver to which the devices are passed.
  */
 static void pass_devices_to_driver(driver_t *driver, dev_tree_t *tree)
 {
 	dev_node_t *dev;
-	link_t *link;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "pass_devices_to_driver(driver=\"%s\")",
 	    driver->name);
@@ -432,58 +544,60 @@ static void pass_devices_to_driver(driver_t *driver, dev_tree_t *tree)
 
 	/*
 	 * Go through devices list as long as there is some device
-	 * that has not been passed to the driver.
+	 * that has not been passed to the driver or is being passed
+	 * to it.
 	 */
-	link = driver->devices.head.next;
-	while (link != &driver->devices.head) {
-		dev = list_get_instance(link, dev_node_t, driver_devices);
+	while (true) {
 		fibril_rwlock_write_lock(&tree->rwlock);
 
-		if (dev->passed_to_driver) {
+		dev = NULL;
+		list_foreach(driver->devices, driver_devices, dev_node_t, d) {
+			if (!d->passed_to_driver) {
+				dev = d;
+				break;
+			}
+		}
+
+		if (dev == NULL) {
 			fibril_rwlock_write_unlock(&tree->rwlock);
-			link = link->next;
+			if (driver->dev_add_pending == 0)
+				break;
+
+			/* Wait, devices being added can bring more devices */
+			fibril_condvar_wait(&driver->dev_add_cv,
+			    &driver->driver_mutex);
 			continue;
 		}
 
+		dev->passed_to_driver = true;
 		dev_add_ref(dev);
-
-		/*
-		 * Unlock to avoid deadlock when adding device
-		 * handled by itself.
-		 */
-		fibril_mutex_unlock(&driver->driver_mutex);
 		fibril_rwlock_write_unlock(&tree->rwlock);
 
-		add_device(driver, dev, tree);
-
-		/* Device probe failed, need to try next best driver */
-		if (dev->state == DEVICE_NOT_PRESENT) {
-			fibril_mutex_lock(&driver->driver_mutex);
-			list_remove(&dev->driver_devices);
-			fibril_mutex_unlock(&driver->driver_mutex);
-			/* Give an extra reference to driver_reassign_fibril */
-			dev_add_ref(dev);
-			fid_t fid = fibril_create(driver_reassign_fibril, dev);
-			if (fid == 0) {
-				log_msg(LOG_DEFAULT, LVL_ERROR,
-				    "Error creating fibril to assign driver.");
-				dev_del_ref(dev);
-			}
-			fibril_add_ready(fid);
+		dev_pass_t *pass = malloc(sizeof(dev_pass_t));
+		fid_t fid = 0;
+		if (pass != NULL) {
+			pass->driver = driver;
+			pass->dev = dev;
+			pass->tree = tree;
+			fid = fibril_create(pass_device_fibril, pass);
 		}
 
-		dev_del_ref(dev);
+		if (fid == 0) {
+			free(pass);
 
-		/*
-		 * Lock again as we will work with driver's
-		 * structure.
-		 */
-		fibril_mutex_lock(&driver->driver_mutex);
+			/*
+			 * Pass the device synchronously. Unlock to avoid
+			 * deadlock when adding device handled by itself.
+			 */
+			fibril_mutex_unlock(&driver->driver_mutex);
+			pass_device_to_driver(driver, dev, tree);
+			dev_del_ref(dev);
+			fibril_mutex_lock(&driver->driver_mutex);
+			continue;
+		}
 
-		/*
-		 * Restart the cycle to go through all devices again.
-		 */
-		link = driver->devices.head.next;
+		driver->dev_add_pending++;
+		fibril_add_ready(fid);
 	}
 
 	/*
@@ -497,6 +611,7 @@ static void pass_devices_to_driver(driver_t *driver, dev_tree_t *tree)
 	 */
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Driver `%s' enters running state.", driver->name);
 	driver->state = DRIVER_RUNNING;
+	driver_timeline_log(&drivers_list, driver);
 
 	fibril_mutex_unlock(&driver->driver_mutex);
 }
@@ -534,6 +649,7 @@ void init_driver(driver_t *drv)
 	list_initialize(&drv->match_ids.ids);
 	list_initialize(&drv->devices);
 	fibril_mutex_initialize(&drv->driver_mutex);
+	fibril_condvar_initialize(&drv->dev_add_cv);
 	drv->sess = NULL;
 }
 
@@ -547,6 +663,7 @@ void clean_driver(driver_t *drv)
 
 	free(drv->name);
 	free(drv->binary_path);
+	free(drv->match_index);
 
 	clean_match_ids(&drv->match_ids);
 
@@ -667,6 +784,8 @@ void add_device(driver_t *drv, dev_node_t *dev, dev_tree_t *tree)
 	switch (rc) {
 	case EOK:
 		dev->state = DEVICE_USABLE;
+		boottrace_record(BOOTTRACE_DRIVER_ATTACH, drv->task_id,
+		    dev->handle, dev->pfun->pathname);
 		break;
 	case ENOENT:
 		dev->state = DEVICE_NOT_PRESENT;
@@ -103,11 +103,15 @@ static driver_t *devman_driver_register(ipc_call_t *call)
 		return NULL;
 	}
 
+	getuptime(&driver->reg_time);
+	driver->task_id = call->task_id;
+
 	switch (driver->state) {
 	case DRIVER_NOT_STARTED:
 		/* Somebody started the driver manually. */
 		log_msg(LOG_DEFAULT, LVL_NOTE, "Driver '%s' started manually.\n",
 		    driver->name);
+		driver->spawn_time = driver->reg_time;
 		driver->state = DRIVER_STARTING;
 		break;
 	case DRIVER_STARTING:
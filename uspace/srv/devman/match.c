@@ -35,6 +35,8 @@
 #include <str.h>
 #include <str_error.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <vfs/vfs.h>
 
 #include "devman.h"
@@ -42,6 +44,93 @@
 
 #define COMMENT	'#'
 
+static size_t match_id_hash(const char *id)
+{
+	size_t hash = 0;
+
+	for (const uint8_t *cp = (const uint8_t *) id; *cp != '\0'; cp++)
+		hash = hash * 31 + *cp;
+
+	return hash;
+}
+
+static size_t match_index_key_hash(const void *key)
+{
+	return match_id_hash(key);
+}
+
+static size_t match_index_hash(const ht_link_t *item)
+{
+	match_index_entry_t *entry = hash_table_get_inst(item,
+	    match_index_entry_t, link);
+	return match_id_hash(entry->mid->id);
+}
+
+static bool match_index_key_equal(const void *key, const ht_link_t *item)
+{
+	match_index_entry_t *entry = hash_table_get_inst(item,
+	    match_index_entry_t, link);
+	return str_cmp(key, entry->mid->id) == 0;
+}
+
+static bool match_index_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	match_index_entry_t *entry1 = hash_table_get_inst(item1,
+	    match_index_entry_t, link);
+	match_index_entry_t *entry2 = hash_table_get_inst(item2,
+	    match_index_entry_t, link);
+	return str_cmp(entry1->mid->id, entry2->mid->id) == 0;
+}
+
+/** Match ID index hash table operations. */
+static hash_table_ops_t match_index_ops = {
+	.hash = match_index_hash,
+	.key_hash = match_index_key_hash,
+	.key_equal = match_index_key_equal,
+	.equal = match_index_equal,
+	.remove_callback = NULL
+};
+
+/** Create index of driver match IDs.
+ *
+ * @param index Hash table to initialize
+ * @return True on success, false if out of memory
+ */
+bool match_index_create(hash_table_t *index)
+{
+	return hash_table_create(index, 0, 0, &match_index_ops);
+}
+
+/** Add match IDs of a driver to the index of match IDs.
+ *
+ * The driver keeps its entries until it is destroyed.
+ *
+ * @param index Index of match IDs
+ * @param drv   Driver
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t match_index_add(hash_table_t *index, driver_t *drv)
+{
+	size_t cnt = list_count(&drv->match_ids.ids);
+	match_index_entry_t *entries;
+	size_t i;
+
+	entries = calloc(cnt, sizeof(match_index_entry_t));
+	if (entries == NULL)
+		return ENOMEM;
+
+	i = 0;
+	list_foreach(drv->match_ids.ids, link, match_id_t, mid) {
+		entries[i].mid = mid;
+		entries[i].drv = drv;
+		hash_table_insert(index, &entries[i].link);
+		i++;
+	}
+
+	drv->match_index = entries;
+	return EOK;
+}
+
 /** Compute compound score of driver and device.
  *
  * @param driver Match id of the driver.
@@ -34,12 +34,15 @@
 #ifndef MATCH_H_
 #define MATCH_H_
 
+#include <errno.h>
 #include <stdbool.h>
 
 #include "devman.h"
 
 #define MATCH_EXT ".ma"
 
+extern bool match_index_create(hash_table_t *);
+extern errno_t match_index_add(hash_table_t *, driver_t *);
 extern int get_match_score(driver_t *, dev_node_t *);
 extern bool parse_match_ids(char *, match_id_list_t *);
 extern bool read_match_ids(const char *, match_id_list_t *);
@@ -38,6 +38,7 @@
 #include <ipc/services.h>
 #include <ns.h>
 #include <async.h>
+#include <boottrace.h>
 #include <stdio.h>
 #include <errno.h>
 #include <stdbool.h>
@@ -533,8 +534,20 @@ static void loc_service_register(ipc_call_t *icall, loc_server_t *server)
 
 	fibril_mutex_unlock(&service->server->services_mutex);
 	fibril_condvar_broadcast(&services_list_cv);
+
+	char fqsn_buf[BOOTTRACE_NAME_LEN];
+	if (str_size(namespace->name) > 0) {
+		snprintf(fqsn_buf, sizeof(fqsn_buf), "%s/%s", namespace->name,
+		    service->name);
+	} else {
+		snprintf(fqsn_buf, sizeof(fqsn_buf), "%s", service->name);
+	}
+
 	fibril_mutex_unlock(&services_list_mutex);
 
+	boottrace_record(BOOTTRACE_LOC_REGISTER, icall->task_id, service->id,
+	    fqsn_buf);
+
 	async_answer_1(icall, EOK, service->id);
 }
 
@@ -58,6 +58,7 @@ static errno_t handle_log_level_change(sysarg_t new_level)
 	log->logged_level = new_level;
 
 	log_unlock(log);
+	publish_log_levels();
 
 	return EOK;
 }
@@ -55,6 +55,7 @@ errno_t set_default_logging_level(log_level_t new_level)
 	fibril_mutex_lock(&default_logging_level_guard);
 	default_logging_level = new_level;
 	fibril_mutex_unlock(&default_logging_level_guard);
+	publish_log_levels();
 	return EOK;
 }
 
@@ -58,12 +58,16 @@ typedef struct {
 	fibril_mutex_t guard;
 	char *filename;
 	FILE *logfile;
+	/** Log file has unflushed messages */
+	bool dirty;
 } logger_dest_t;
 
 struct logger_log {
 	link_t link;
 
 	size_t ref_counter;
+	/** Log id (index into log level table + 1) */
+	sysarg_t id;
 
 	fibril_mutex_t guard;
 
@@ -81,6 +85,10 @@ typedef struct {
 	logger_log_t *logs[MAX_REFERENCED_LOGS_PER_CLIENT];
 } logger_registered_logs_t;
 
+errno_t logs_init(void);
+void *logs_levels_table(void);
+size_t logs_levels_size(void);
+void publish_log_levels(void);
 logger_log_t *find_log_by_name_and_lock(const char *name);
 logger_log_t *find_or_create_log_and_lock(const char *, sysarg_t);
 logger_log_t *find_log_by_id_and_lock(sysarg_t);
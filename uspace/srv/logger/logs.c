@@ -29,16 +29,78 @@
 /** @addtogroup logger
  * @{
  */
+#include <as.h>
 #include <assert.h>
 #include <errno.h>
+#include <ipc/logger.h>
+#include <mem.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
 #include "logger.h"
 
+/** Delay before flushing buffered messages to log files (microseconds) */
+#define LOG_FLUSH_DELAY 1000000
+
 static FIBRIL_MUTEX_INITIALIZE(log_list_guard);
 static LIST_INITIALIZE(log_list);
 
+/** Logs indexed by id - 1, protected by log_list_guard */
+static logger_log_t *log_slots[LOGGER_LEVELS_MAX];
+
+/** Table of effective log levels shared with writer clients */
+static uint8_t *log_levels;
+
+/** Guards flush_pending */
+static FIBRIL_MUTEX_INITIALIZE(flush_lock);
+/** Flush of log files has been scheduled */
+static bool flush_pending;
+/** Timer for flushing log files */
+static fibril_timer_t *flush_timer;
+
+/** Initialize logs.
+ *
+ * @return EOK on success or an error code
+ */
+errno_t logs_init(void)
+{
+	void *area;
+
+	area = as_area_create(AS_AREA_ANY, logs_levels_size(),
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (area == AS_MAP_FAILED)
+		return ENOMEM;
+
+	/* Until a log is created, clients should not filter anything */
+	memset(area, LVL_LIMIT - 1, logs_levels_size());
+	log_levels = area;
+
+	flush_timer = fibril_timer_create(&flush_lock);
+	if (flush_timer == NULL)
+		return ENOMEM;
+
+	return EOK;
+}
+
+/** Get table of effective log levels.
+ *
+ * @return Pointer to table of LOGGER_LEVELS_MAX levels indexed by
+ *         log id - 1
+ */
+void *logs_levels_table(void)
+{
+	return log_levels;
+}
+
+/** Get size of the (page-aligned) table of effective log levels.
+ *
+ * @return Size in bytes
+ */
+size_t logs_levels_size(void)
+{
+	return PAGES2SIZE(SIZE2PAGES(LOGGER_LEVELS_MAX));
+}
+
 static logger_log_t *find_log_by_name_and_parent_no_list_lock(const char *name, logger_log_t *parent)
 {
 	list_foreach(log_list, link, logger_log_t, log) {
@@ -59,6 +121,7 @@ static errno_t create_dest(const char *name, logger_dest_t **dest)
 		return ENOMEM;
 	}
 	result->logfile = NULL;
+	result->dirty = false;
 	fibril_mutex_initialize(&result->guard);
 	*dest = result;
 	return EOK;
@@ -109,19 +172,90 @@ error:
 
 }
 
+static log_level_t get_actual_log_level(logger_log_t *log)
+{
+	/* Find recursively proper log level. */
+	if (log->logged_level == LOG_LEVEL_USE_DEFAULT) {
+		if (log->parent == NULL)
+			return get_default_logging_level();
+		else
+			return get_actual_log_level(log->parent);
+	}
+	return log->logged_level;
+}
+
+static void publish_log_levels_no_list_lock(void)
+{
+	assert(fibril_mutex_is_locked(&log_list_guard));
+
+	if (log_levels == NULL)
+		return;
+
+	list_foreach(log_list, link, logger_log_t, log)
+		log_levels[log->id - 1] = get_actual_log_level(log);
+}
+
+/** Publish effective log levels to writer clients.
+ *
+ * Must be called after changing log level of any log so that clients
+ * stop suppressing (or start suppressing) messages.
+ */
+void publish_log_levels(void)
+{
+	fibril_mutex_lock(&log_list_guard);
+	publish_log_levels_no_list_lock();
+	fibril_mutex_unlock(&log_list_guard);
+}
+
+static logger_log_t *find_log_by_id_no_list_lock(sysarg_t id)
+{
+	assert(fibril_mutex_is_locked(&log_list_guard));
+
+	if (id < 1 || id > LOGGER_LEVELS_MAX)
+		return NULL;
+
+	return log_slots[id - 1];
+}
+
+static sysarg_t alloc_log_id_no_list_lock(void)
+{
+	size_t i;
+
+	for (i = 0; i < LOGGER_LEVELS_MAX; i++) {
+		if (log_slots[i] == NULL)
+			return i + 1;
+	}
+
+	return 0;
+}
+
 logger_log_t *find_or_create_log_and_lock(const char *name, sysarg_t parent_id)
 {
 	logger_log_t *result = NULL;
-	logger_log_t *parent = (logger_log_t *) parent_id;
+	logger_log_t *parent = NULL;
+	sysarg_t id;
 
 	fibril_mutex_lock(&log_list_guard);
 
+	if (parent_id != 0) {
+		parent = find_log_by_id_no_list_lock(parent_id);
+		if (parent == NULL)
+			goto leave;
+	}
+
 	result = find_log_by_name_and_parent_no_list_lock(name, parent);
 	if (result == NULL) {
+		id = alloc_log_id_no_list_lock();
+		if (id == 0)
+			goto leave;
 		result = create_log_no_locking(name, parent);
 		if (result == NULL)
 			goto leave;
+		result->id = id;
+		log_slots[id - 1] = result;
 		list_append(&result->link, &log_list);
+		if (log_levels != NULL)
+			log_levels[id - 1] = get_actual_log_level(result);
 		if (result->parent != NULL) {
 			fibril_mutex_lock(&result->parent->guard);
 			result->parent->ref_counter++;
@@ -159,30 +293,14 @@ logger_log_t *find_log_by_id_and_lock(sysarg_t id)
 	logger_log_t *result = NULL;
 
 	fibril_mutex_lock(&log_list_guard);
-	list_foreach(log_list, link, logger_log_t, log) {
-		if ((sysarg_t) log == id) {
-			fibril_mutex_lock(&log->guard);
-			result = log;
-			break;
-		}
-	}
+	result = find_log_by_id_no_list_lock(id);
+	if (result != NULL)
+		fibril_mutex_lock(&result->guard);
 	fibril_mutex_unlock(&log_list_guard);
 
 	return result;
 }
 
-static log_level_t get_actual_log_level(logger_log_t *log)
-{
-	/* Find recursively proper log level. */
-	if (log->logged_level == LOG_LEVEL_USE_DEFAULT) {
-		if (log->parent == NULL)
-			return get_default_logging_level();
-		else
-			return get_actual_log_level(log->parent);
-	}
-	return log->logged_level;
-}
-
 bool shall_log_message(logger_log_t *log, log_level_t level)
 {
 	fibril_mutex_lock(&log_list_guard);
@@ -256,6 +374,7 @@ void log_release(logger_log_t *log)
 	assert(log->ref_counter == 0);
 
 	list_remove(&log->link);
+	log_slots[log->id - 1] = NULL;
 	fibril_mutex_unlock(&log_list_guard);
 	fibril_mutex_unlock(&log->guard);
 
@@ -264,9 +383,11 @@ void log_release(logger_log_t *log)
 		 * Due to lazy file opening in write_to_log(),
 		 * it is possible that no file was actually opened.
 		 */
+		fibril_mutex_lock(&log->dest->guard);
 		if (log->dest->logfile != NULL) {
 			fclose(log->dest->logfile);
 		}
+		fibril_mutex_unlock(&log->dest->guard);
 		free(log->dest->filename);
 		free(log->dest);
 	} else {
@@ -282,8 +403,58 @@ void log_release(logger_log_t *log)
 	free(log);
 }
 
+/** Flush log files with buffered messages.
+ *
+ * @param arg Not used
+ */
+static void flush_logs(void *arg)
+{
+	(void) arg;
+
+	fibril_mutex_lock(&flush_lock);
+	flush_pending = false;
+	fibril_mutex_unlock(&flush_lock);
+
+	fibril_mutex_lock(&log_list_guard);
+	list_foreach(log_list, link, logger_log_t, log) {
+		/* Only top-level logs own their destination */
+		if (log->parent != NULL)
+			continue;
+
+		fibril_mutex_lock(&log->dest->guard);
+		if (log->dest->dirty && log->dest->logfile != NULL)
+			fflush(log->dest->logfile);
+		log->dest->dirty = false;
+		fibril_mutex_unlock(&log->dest->guard);
+	}
+	fibril_mutex_unlock(&log_list_guard);
+}
+
+/** Schedule flushing of log files. */
+static void schedule_flush(void)
+{
+	fibril_mutex_lock(&flush_lock);
+	if (!flush_pending && flush_timer != NULL) {
+		flush_pending = true;
+		fibril_timer_set_locked(flush_timer, LOG_FLUSH_DELAY,
+		    flush_logs, NULL);
+	}
+	fibril_mutex_unlock(&flush_lock);
+}
+
+/** Write message to log.
+ *
+ * Errors and fatal errors are flushed to the log file immediately,
+ * other messages are buffered and flushed after LOG_FLUSH_DELAY.
+ *
+ * @param log Log (locked)
+ * @param level Message severity level
+ * @param message Message text
+ */
 void write_to_log(logger_log_t *log, log_level_t level, const char *message)
 {
+	bool flush_later = false;
+
 	assert(fibril_mutex_is_locked(&log->guard));
 	assert(log->dest != NULL);
 	fibril_mutex_lock(&log->dest->guard);
@@ -294,10 +465,19 @@ void write_to_log(logger_log_t *log, log_level_t level, const char *message)
 		fprintf(log->dest->logfile, "[%s] %s: %s\n",
 		    log->full_name, log_level_str(level),
 		    (const char *) message);
-		fflush(log->dest->logfile);
+		if (level <= LVL_ERROR) {
+			fflush(log->dest->logfile);
+			log->dest->dirty = false;
+		} else if (!log->dest->dirty) {
+			log->dest->dirty = true;
+			flush_later = true;
+		}
 	}
 
 	fibril_mutex_unlock(&log->dest->guard);
+
+	if (flush_later)
+		schedule_flush();
 }
 
 void registered_logs_init(logger_registered_logs_t *logs)
@@ -34,6 +34,9 @@
 /** @file
  */
 
+#include <align.h>
+#include <as.h>
+#include <barrier.h>
 #include <ipc/services.h>
 #include <ipc/logger.h>
 #include <io/log.h>
@@ -44,9 +47,22 @@
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <str.h>
 #include <str_error.h>
 #include "logger.h"
 
+/** Message ring shared with a writer client */
+typedef struct {
+	/** Shared area */
+	void *area;
+	/** Ring header (in @c area) */
+	logger_ring_hdr_t *hdr;
+	/** Ring data (in @c area) */
+	uint8_t *data;
+	/** Buffer for null-terminated copy of message text */
+	char *msg;
+} logger_ring_t;
+
 static logger_log_t *handle_create_log(sysarg_t parent)
 {
 	void *name;
@@ -91,9 +107,204 @@ leave:
 	return rc;
 }
 
+/** Log message received through message ring.
+ *
+ * @param log_id Log id
+ * @param level Message severity level
+ * @param message Message text
+ */
+static void ring_log_message(sysarg_t log_id, sysarg_t level,
+    const char *message)
+{
+	logger_log_t *log = find_log_by_id_and_lock(log_id);
+	if (log == NULL)
+		return;
+
+	if (level < LVL_LIMIT && shall_log_message(log, level)) {
+		KLOG_PRINTF(level, "[%s] %s: %s",
+		    log->full_name, log_level_str(level), message);
+		write_to_log(log, level, message);
+	}
+
+	log_unlock(log);
+}
+
+/** Process all messages in message ring.
+ *
+ * The client is only allowed to write to the ring between head and
+ * the end of free space, so the records we read cannot change under us.
+ * Still, the client can write garbage to the header, so we must
+ * validate every record.
+ *
+ * @param ring Message ring
+ * @return EOK on success, EIO if the ring is corrupted
+ */
+static errno_t ring_drain(logger_ring_t *ring)
+{
+	logger_ring_hdr_t *hdr = ring->hdr;
+	logger_ring_rec_t rec;
+	uint32_t head;
+	uint32_t tail;
+	size_t off;
+	size_t rsize;
+
+	tail = hdr->tail;
+
+	while (true) {
+		head = ACCESS_ONCE(hdr->head);
+		if (head == tail) {
+			/* Ask to be kicked, then check again to avoid a race */
+			hdr->cons_wait = 1;
+			memory_barrier();
+			head = ACCESS_ONCE(hdr->head);
+			if (head == tail)
+				break;
+			hdr->cons_wait = 0;
+		}
+
+		if (head - tail > LOGGER_RING_DATA_SIZE)
+			return EIO;
+
+		/* Make sure we see the record the head points past */
+		read_barrier();
+
+		off = tail % LOGGER_RING_DATA_SIZE;
+		memcpy(&rec, ring->data + off, sizeof(rec));
+
+		if (rec.level == LOGGER_RING_PAD) {
+			/* Padding spans until the end of the ring */
+			rsize = LOGGER_RING_DATA_SIZE - off;
+		} else {
+			rsize = ALIGN_UP(sizeof(rec) + rec.size,
+			    LOGGER_RING_ALIGN);
+			if (off + sizeof(rec) + rec.size > LOGGER_RING_DATA_SIZE)
+				return EIO;
+
+			memcpy(ring->msg, ring->data + off + sizeof(rec),
+			    rec.size);
+			ring->msg[rec.size] = '\0';
+			ring_log_message(rec.log, rec.level, ring->msg);
+		}
+
+		if (rsize > head - tail)
+			return EIO;
+
+		tail += rsize;
+
+		/* Finish reading the record before releasing it */
+		memory_barrier();
+		hdr->tail = tail;
+	}
+
+	return EOK;
+}
+
+/** Handle LOGGER_WRITER_RING_CREATE.
+ *
+ * @param ring Message ring
+ * @param icall Call data
+ */
+static void handle_ring_create(logger_ring_t *ring, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	size_t size;
+	void *area;
+	errno_t rc;
+
+	if (!async_share_out_receive(&call, &size, NULL)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	if (ring->area != NULL || size < sizeof(logger_ring_hdr_t) +
+	    LOGGER_RING_DATA_SIZE) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	ring->msg = malloc(LOGGER_RING_DATA_SIZE + 1);
+	if (ring->msg == NULL) {
+		async_answer_0(&call, ENOMEM);
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	rc = async_share_out_finalize(&call, &area);
+	if (rc != EOK) {
+		free(ring->msg);
+		ring->msg = NULL;
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	ring->area = area;
+	ring->hdr = area;
+	ring->data = (uint8_t *) area + sizeof(logger_ring_hdr_t);
+
+	/*
+	 * The client cleared the header, so it would not kick us. Drain
+	 * the (empty) ring once, which asks for a kick on the next record.
+	 */
+	rc = ring_drain(ring);
+	if (rc != EOK)
+		logger_log("writer: corrupted message ring.\n");
+
+	async_answer_0(icall, EOK);
+}
+
+/** Handle LOGGER_WRITER_RING_KICK.
+ *
+ * @param ring Message ring
+ * @param icall Call data
+ */
+static void handle_ring_kick(logger_ring_t *ring, ipc_call_t *icall)
+{
+	errno_t rc;
+
+	if (ring->area == NULL) {
+		async_answer_0(icall, ENOENT);
+		return;
+	}
+
+	rc = ring_drain(ring);
+	if (rc != EOK)
+		logger_log("writer: corrupted message ring.\n");
+
+	async_answer_0(icall, rc);
+}
+
+/** Handle LOGGER_WRITER_GET_LEVELS.
+ *
+ * @param icall Call data
+ */
+static void handle_get_levels(ipc_call_t *icall)
+{
+	ipc_call_t call;
+	size_t size;
+	errno_t rc;
+
+	if (!async_share_in_receive(&call, &size)) {
+		async_answer_0(icall, EREFUSED);
+		return;
+	}
+
+	if (size != logs_levels_size() || logs_levels_table() == NULL) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	rc = async_share_in_finalize(&call, logs_levels_table(),
+	    AS_AREA_READ | AS_AREA_CACHEABLE);
+	async_answer_0(icall, rc);
+}
+
 void logger_connection_handler_writer(ipc_call_t *icall)
 {
 	logger_log_t *log;
+	sysarg_t id;
 	errno_t rc;
 
 	/* Acknowledge the connection. */
@@ -104,6 +315,10 @@ void logger_connection_handler_writer(ipc_call_t *icall)
 	logger_registered_logs_t registered_logs;
 	registered_logs_init(&registered_logs);
 
+	logger_ring_t ring = {
+		.area = NULL
+	};
+
 	while (true) {
 		ipc_call_t call;
 		async_get_call(&call);
@@ -125,20 +340,37 @@ void logger_connection_handler_writer(ipc_call_t *icall)
 				async_answer_0(&call, ELIMIT);
 				break;
 			}
+			id = log->id;
 			log_unlock(log);
-			async_answer_1(&call, EOK, (sysarg_t) log);
+			async_answer_1(&call, EOK, id);
 			break;
 		case LOGGER_WRITER_MESSAGE:
 			rc = handle_receive_message(ipc_get_arg1(&call),
 			    ipc_get_arg2(&call));
 			async_answer_0(&call, rc);
 			break;
+		case LOGGER_WRITER_GET_LEVELS:
+			handle_get_levels(&call);
+			break;
+		case LOGGER_WRITER_RING_CREATE:
+			handle_ring_create(&ring, &call);
+			break;
+		case LOGGER_WRITER_RING_KICK:
+			handle_ring_kick(&ring, &call);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 			break;
 		}
 	}
 
+	if (ring.area != NULL) {
+		/* Do not lose messages the client did not kick us for */
+		(void) ring_drain(&ring);
+		as_area_destroy(ring.area);
+		free(ring.msg);
+	}
+
 	unregister_logs(&registered_logs);
 	logger_log("writer: client terminated.\n");
 }
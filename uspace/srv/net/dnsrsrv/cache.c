@@ -0,0 +1,303 @@
+/** @addtogroup dnsrsrv
+ * @{
+ */
+/**
+ * @file DNS resolver cache
+ *
+ * Caches results of address queries, both positive and negative
+ * (RFC 2308), for the duration of their TTL. The number of entries
+ * is bounded; when the cache is full, the least recently used entry
+ * is evicted. Time is passed in by the caller (in seconds) so that
+ * the cache does not depend on the system clock.
+ */
+
+#include <adt/hash.h>
+#include <assert.h>
+#include <errno.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <str.h>
+#include "cache.h"
+
+/** Cache key */
+typedef struct {
+	const char *name;
+	dns_qtype_t qtype;
+} dns_cache_key_t;
+
+static void dns_cache_entry_destroy(dns_cache_entry_t *);
+
+/** Compute hash of a name, ignoring case of ASCII letters.
+ *
+ * @param name Domain name
+ * @return Hash
+ */
+static size_t dns_cache_name_hash(const char *name)
+{
+	size_t hash = 0;
+	const uint8_t *cp;
+	uint8_t c;
+
+	for (cp = (const uint8_t *) name; *cp != '\0'; cp++) {
+		c = *cp;
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		hash = hash * 31 + c;
+	}
+
+	return hash;
+}
+
+static size_t dns_cache_key_hash(const void *key)
+{
+	const dns_cache_key_t *ckey = key;
+
+	return hash_combine(dns_cache_name_hash(ckey->name),
+	    hash_mix(ckey->qtype));
+}
+
+static size_t dns_cache_hash(const ht_link_t *item)
+{
+	dns_cache_entry_t *entry =
+	    hash_table_get_inst(item, dns_cache_entry_t, lentries);
+	dns_cache_key_t key = { entry->name, entry->qtype };
+
+	return dns_cache_key_hash(&key);
+}
+
+static bool dns_cache_key_equal(const void *key, const ht_link_t *item)
+{
+	const dns_cache_key_t *ckey = key;
+	dns_cache_entry_t *entry =
+	    hash_table_get_inst(item, dns_cache_entry_t, lentries);
+
+	return entry->qtype == ckey->qtype &&
+	    str_casecmp(entry->name, ckey->name) == 0;
+}
+
+static void dns_cache_remove_callback(ht_link_t *item)
+{
+	dns_cache_entry_t *entry =
+	    hash_table_get_inst(item, dns_cache_entry_t, lentries);
+
+	list_remove(&entry->llru);
+	dns_cache_entry_destroy(entry);
+}
+
+static hash_table_ops_t dns_cache_ops = {
+	.hash = dns_cache_hash,
+	.key_hash = dns_cache_key_hash,
+	.key_equal = dns_cache_key_equal,
+	.equal = NULL,
+	.remove_callback = dns_cache_remove_callback
+};
+
+/** Destroy cache entry.
+ *
+ * @param entry Cache entry (not in cache)
+ */
+static void dns_cache_entry_destroy(dns_cache_entry_t *entry)
+{
+	free(entry->name);
+	free(entry->cname);
+	free(entry);
+}
+
+/** Create DNS cache.
+ *
+ * @param max_entries Maximum number of entries
+ * @param rcache Place to store pointer to new cache
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t dns_cache_create(size_t max_entries, dns_cache_t **rcache)
+{
+	dns_cache_t *cache;
+
+	cache = calloc(1, sizeof(dns_cache_t));
+	if (cache == NULL)
+		return ENOMEM;
+
+	if (!hash_table_create(&cache->entries, 0, 0, &dns_cache_ops)) {
+		free(cache);
+		return ENOMEM;
+	}
+
+	list_initialize(&cache->lru);
+	cache->max_entries = max_entries;
+	cache->stats.max_entries = max_entries;
+
+	*rcache = cache;
+	return EOK;
+}
+
+/** Destroy DNS cache.
+ *
+ * @param cache DNS cache
+ */
+void dns_cache_destroy(dns_cache_t *cache)
+{
+	if (cache == NULL)
+		return;
+
+	hash_table_destroy(&cache->entries);
+	free(cache);
+}
+
+/** Remove entry from cache and destroy it.
+ *
+ * @param cache DNS cache
+ * @param entry Cache entry
+ */
+static void dns_cache_remove(dns_cache_t *cache, dns_cache_entry_t *entry)
+{
+	hash_table_remove_item(&cache->entries, &entry->lentries);
+	--cache->stats.entries;
+}
+
+/** Look up entry in DNS cache.
+ *
+ * An expired entry is removed and treated as not found.
+ *
+ * @param cache DNS cache
+ * @param name Domain name
+ * @param qtype Query type
+ * @param now Current time (seconds)
+ * @param info Host information to fill in if positive entry is found.
+ *             The caller is responsible for freeing @c info->cname.
+ * @param rnegative Place to store @c true if the entry is negative
+ * @return EOK if entry was found, ENOENT if not, ENOMEM if out of memory
+ */
+errno_t dns_cache_lookup(dns_cache_t *cache, const char *name,
+    dns_qtype_t qtype, time_t now, dns_host_info_t *info, bool *rnegative)
+{
+	dns_cache_key_t key = { name, qtype };
+	dns_cache_entry_t *entry;
+	ht_link_t *link;
+
+	link = hash_table_find(&cache->entries, &key);
+	if (link == NULL) {
+		++cache->stats.misses;
+		return ENOENT;
+	}
+
+	entry = hash_table_get_inst(link, dns_cache_entry_t, lentries);
+	if (now >= entry->expires) {
+		dns_cache_remove(cache, entry);
+		++cache->stats.expirations;
+		++cache->stats.misses;
+		return ENOENT;
+	}
+
+	if (!entry->negative) {
+		info->cname = str_dup(entry->cname);
+		if (info->cname == NULL)
+			return ENOMEM;
+
+		info->addr = entry->addr;
+		++cache->stats.hits;
+	} else {
+		++cache->stats.neg_hits;
+	}
+
+	/* Move to the most recently used end */
+	list_remove(&entry->llru);
+	list_append(&entry->llru, &cache->lru);
+
+	*rnegative = entry->negative;
+	return EOK;
+}
+
+/** Insert entry into DNS cache.
+ *
+ * Any existing entry for the same name and query type is replaced.
+ * Answers with zero TTL are not cached.
+ *
+ * @param cache DNS cache
+ * @param name Domain name
+ * @param qtype Query type
+ * @param info Host information or @c NULL to insert a negative entry
+ * @param ttl Time to live (seconds)
+ * @param now Current time (seconds)
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t dns_cache_insert(dns_cache_t *cache, const char *name,
+    dns_qtype_t qtype, dns_host_info_t *info, uint32_t ttl, time_t now)
+{
+	dns_cache_key_t key = { name, qtype };
+	dns_cache_entry_t *entry;
+	ht_link_t *link;
+	link_t *llru;
+
+	if (info == NULL && ttl > DNS_CACHE_NEG_TTL_MAX)
+		ttl = DNS_CACHE_NEG_TTL_MAX;
+	if (ttl > DNS_CACHE_TTL_MAX)
+		ttl = DNS_CACHE_TTL_MAX;
+
+	if (ttl == 0 || cache->max_entries == 0)
+		return EOK;
+
+	entry = calloc(1, sizeof(dns_cache_entry_t));
+	if (entry == NULL)
+		return ENOMEM;
+
+	entry->name = str_dup(name);
+	if (entry->name == NULL)
+		goto error;
+
+	entry->qtype = qtype;
+	entry->negative = (info == NULL);
+	if (info != NULL) {
+		entry->cname = str_dup(info->cname);
+		if (entry->cname == NULL)
+			goto error;
+		entry->addr = info->addr;
+	}
+
+	entry->expires = now + ttl;
+
+	link = hash_table_find(&cache->entries, &key);
+	if (link != NULL) {
+		dns_cache_remove(cache,
+		    hash_table_get_inst(link, dns_cache_entry_t, lentries));
+	}
+
+	while (cache->stats.entries >= cache->max_entries) {
+		llru = list_first(&cache->lru);
+		assert(llru != NULL);
+		dns_cache_remove(cache,
+		    list_get_instance(llru, dns_cache_entry_t, llru));
+		++cache->stats.evictions;
+	}
+
+	hash_table_insert(&cache->entries, &entry->lentries);
+	list_append(&entry->llru, &cache->lru);
+	++cache->stats.entries;
+	++cache->stats.inserts;
+	return EOK;
+error:
+	dns_cache_entry_destroy(entry);
+	return ENOMEM;
+}
+
+/** Remove all entries from DNS cache.
+ *
+ * @param cache DNS cache
+ */
+void dns_cache_flush(dns_cache_t *cache)
+{
+	hash_table_clear(&cache->entries);
+	cache->stats.entries = 0;
+}
+
+/** Get DNS cache statistics.
+ *
+ * @param cache DNS cache
+ * @param stats Place to store statistics
+ */
+void dns_cache_get_stats(dns_cache_t *cache, dnsr_cache_stats_t *stats)
+{
+	*stats = cache->stats;
+}
+
+/** @}
+ */
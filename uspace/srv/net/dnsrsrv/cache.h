@@ -0,0 +1,70 @@
+/** @addtogroup dnsrsrv
+ * @{
+ */
+/**
+ * @file DNS resolver cache
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <types/dnsr.h>
+#include "dns_std.h"
+#include "dns_type.h"
+
+/** Upper bound on TTL of a cached answer (seconds) */
+#define DNS_CACHE_TTL_MAX 86400
+/** Upper bound on TTL of a cached negative answer (seconds) */
+#define DNS_CACHE_NEG_TTL_MAX 10800
+
+/** DNS cache entry */
+typedef struct {
+	/** Link to dns_cache_t.entries */
+	ht_link_t lentries;
+	/** Link to dns_cache_t.lru */
+	link_t llru;
+	/** Queried name */
+	char *name;
+	/** Query type */
+	dns_qtype_t qtype;
+	/** Name has no record of this type */
+	bool negative;
+	/** Canonical name (positive entries only) */
+	char *cname;
+	/** Address (positive entries only) */
+	inet_addr_t addr;
+	/** Entry is valid until this time (seconds of uptime) */
+	time_t expires;
+} dns_cache_entry_t;
+
+/** DNS cache */
+typedef struct {
+	/** Entries hashed by name and query type */
+	hash_table_t entries;
+	/** Entries, least recently used first */
+	list_t lru;
+	/** Maximum number of entries */
+	size_t max_entries;
+	/** Statistics */
+	dnsr_cache_stats_t stats;
+} dns_cache_t;
+
+extern errno_t dns_cache_create(size_t, dns_cache_t **);
+extern void dns_cache_destroy(dns_cache_t *);
+extern errno_t dns_cache_lookup(dns_cache_t *, const char *, dns_qtype_t,
+    time_t, dns_host_info_t *, bool *);
+extern errno_t dns_cache_insert(dns_cache_t *, const char *, dns_qtype_t,
+    dns_host_info_t *, uint32_t, time_t);
+extern void dns_cache_flush(dns_cache_t *);
+extern void dns_cache_get_stats(dns_cache_t *, dnsr_cache_stats_t *);
+
+#endif
+
+/** @}
+ */
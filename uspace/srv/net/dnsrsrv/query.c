@@ -34,21 +34,111 @@
  */
 
 #include <errno.h>
+#include <fibril_synch.h>
 #include <io/log.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 #include <str.h>
+#include <time.h>
+#include "cache.h"
 #include "dns_msg.h"
 #include "dns_std.h"
 #include "dns_type.h"
 #include "query.h"
 #include "transport.h"
 
+/** Maximum number of entries in the resolver cache */
+#define DNS_CACHE_SIZE 512
+
+/** Size of the SOA MINIMUM field which ends SOA RDATA */
+#define DNS_SOA_MINIMUM_SIZE 4
+
+/** Query in progress.
+ *
+ * Fibrils asking the same question while the query is in progress
+ * wait for its result instead of sending another request.
+ */
+typedef struct {
+	/** Link to dns_pending */
+	link_t lpending;
+	/** Queried name (owned by the fibril performing the query) */
+	const char *name;
+	/** Query type */
+	dns_qtype_t qtype;
+	/** Query has finished */
+	bool done;
+	/** Result of the query */
+	errno_t rc;
+	/** Host information if @c rc is EOK */
+	dns_host_info_t info;
+	/** Number of fibrils referencing this structure */
+	unsigned refcnt;
+} dns_pending_t;
+
 static uint16_t msg_id;
 
+/** Protects dns_cache and dns_pending */
+static FIBRIL_MUTEX_INITIALIZE(dns_query_lock);
+/** Signalled when a pending query finishes */
+static FIBRIL_CONDVAR_INITIALIZE(dns_query_cv);
+/** Queries in progress, list of dns_pending_t */
+static LIST_INITIALIZE(dns_pending);
+/** Resolver cache */
+static dns_cache_t *dns_cache;
+
+/** Initialize query module.
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t dns_query_init(void)
+{
+	return dns_cache_create(DNS_CACHE_SIZE, &dns_cache);
+}
+
+/** Determine how long a negative answer can be cached.
+ *
+ * Following RFC 2308 this is the smaller of the TTL of the SOA record
+ * in the authority section and its MINIMUM field. Without SOA the answer
+ * must not be cached.
+ *
+ * @param amsg Answer message
+ * @return TTL in seconds
+ */
+static uint32_t dns_negative_ttl(dns_message_t *amsg)
+{
+	uint32_t minimum;
+
+	list_foreach(amsg->authority, msg, dns_rr_t, rr) {
+		if (rr->rtype != DTYPE_SOA || rr->rclass != DC_IN ||
+		    rr->rdata_size < DNS_SOA_MINIMUM_SIZE)
+			continue;
+
+		minimum = dns_uint32_t_decode((uint8_t *) rr->rdata +
+		    rr->rdata_size - DNS_SOA_MINIMUM_SIZE,
+		    DNS_SOA_MINIMUM_SIZE);
+		return min(rr->ttl, minimum);
+	}
+
+	return 0;
+}
+
+/** Query DNS server for address of a name.
+ *
+ * @param name Domain name
+ * @param qtype Query type (DTYPE_A or DTYPE_AAAA)
+ * @param info Host information to fill in
+ * @param rttl Place to store number of seconds the (positive or negative)
+ *             answer can be cached for
+ * @return EOK on success, ENOENT if the server answered that the name
+ *         has no address of the requested type, EIO or other error code
+ *         if no valid answer was obtained
+ */
 static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
-    dns_host_info_t *info)
+    dns_host_info_t *info, uint32_t *rttl)
 {
+	uint32_t ttl = UINT32_MAX;
+
 	/* Start with the caller-provided name */
 	char *sname = str_dup(name);
 	if (sname == NULL)
@@ -129,6 +219,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 			/* Continue looking for the more canonical name */
 			free(sname);
 			sname = cname;
+			ttl = min(ttl, rr->ttl);
 		}
 
 		if ((qtype == DTYPE_A) && (rr->rtype == DTYPE_A) &&
@@ -146,6 +237,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 
 			inet_addr_set(dns_uint32_t_decode(rr->rdata, rr->rdata_size),
 			    &info->addr);
+			*rttl = min(ttl, rr->ttl);
 
 			dns_message_destroy(msg);
 			dns_message_destroy(amsg);
@@ -171,6 +263,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 			dns_addr128_t_decode(rr->rdata, rr->rdata_size, addr);
 
 			inet_addr_set6(addr, &info->addr);
+			*rttl = min(ttl, rr->ttl);
 
 			dns_message_destroy(msg);
 			dns_message_destroy(amsg);
@@ -182,11 +275,148 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "'%s' not resolved, fail", sname);
 
+	if (amsg->rcode == RC_OK || amsg->rcode == RC_NAME_ERR) {
+		/* Name does not exist or has no record of this type */
+		*rttl = dns_negative_ttl(amsg);
+		rc = ENOENT;
+	} else {
+		rc = EIO;
+	}
+
 	dns_message_destroy(msg);
 	dns_message_destroy(amsg);
 	free(sname);
 
-	return EIO;
+	return rc;
+}
+
+/** Find query in progress.
+ *
+ * @param name Domain name
+ * @param qtype Query type
+ * @return Pending query or @c NULL if not found
+ */
+static dns_pending_t *dns_pending_find(const char *name, dns_qtype_t qtype)
+{
+	assert(fibril_mutex_is_locked(&dns_query_lock));
+
+	list_foreach(dns_pending, lpending, dns_pending_t, pending) {
+		if (pending->qtype == qtype &&
+		    str_casecmp(pending->name, name) == 0)
+			return pending;
+	}
+
+	return NULL;
+}
+
+/** Drop reference to pending query.
+ *
+ * @param pending Pending query
+ */
+static void dns_pending_release(dns_pending_t *pending)
+{
+	assert(fibril_mutex_is_locked(&dns_query_lock));
+
+	if (--pending->refcnt == 0) {
+		free(pending->info.cname);
+		free(pending);
+	}
+}
+
+/** Resolve name using the cache, querying DNS server on a miss.
+ *
+ * If an identical query is already in progress, wait for its result.
+ *
+ * @param name Domain name
+ * @param qtype Query type (DTYPE_A or DTYPE_AAAA)
+ * @param info Host information to fill in
+ * @return EOK on success, ENOENT if the name has no address of the
+ *         requested type, EIO or other error code on failure
+ */
+static errno_t dns_cached_query(const char *name, dns_qtype_t qtype,
+    dns_host_info_t *info)
+{
+	dns_pending_t *pending;
+	struct timespec ts;
+	uint32_t ttl;
+	bool negative;
+	errno_t rc;
+
+	fibril_mutex_lock(&dns_query_lock);
+
+	getuptime(&ts);
+	rc = dns_cache_lookup(dns_cache, name, qtype, ts.tv_sec, info,
+	    &negative);
+	if (rc != ENOENT) {
+		fibril_mutex_unlock(&dns_query_lock);
+		if (rc == EOK && negative)
+			rc = ENOENT;
+		return rc;
+	}
+
+	pending = dns_pending_find(name, qtype);
+	if (pending != NULL) {
+		++dns_cache->stats.coalesced;
+		++pending->refcnt;
+
+		while (!pending->done)
+			fibril_condvar_wait(&dns_query_cv, &dns_query_lock);
+
+		rc = pending->rc;
+		if (rc == EOK) {
+			info->cname = str_dup(pending->info.cname);
+			if (info->cname == NULL)
+				rc = ENOMEM;
+			info->addr = pending->info.addr;
+		}
+
+		dns_pending_release(pending);
+		fibril_mutex_unlock(&dns_query_lock);
+		return rc;
+	}
+
+	pending = calloc(1, sizeof(dns_pending_t));
+	if (pending == NULL) {
+		fibril_mutex_unlock(&dns_query_lock);
+		return ENOMEM;
+	}
+
+	pending->name = name;
+	pending->qtype = qtype;
+	pending->refcnt = 1;
+	list_append(&pending->lpending, &dns_pending);
+	fibril_mutex_unlock(&dns_query_lock);
+
+	ttl = 0;
+	rc = dns_name_query(name, qtype, info, &ttl);
+
+	fibril_mutex_lock(&dns_query_lock);
+
+	/* Transport and server errors are never cached */
+	if (rc == EOK || rc == ENOENT) {
+		getuptime(&ts);
+		if (dns_cache_insert(dns_cache, name, qtype,
+		    rc == EOK ? info : NULL, ttl, ts.tv_sec) != EOK) {
+			log_msg(LOG_DEFAULT, LVL_WARN, "Out of memory "
+			    "caching answer.");
+		}
+	}
+
+	pending->rc = rc;
+	if (rc == EOK) {
+		pending->info.cname = str_dup(info->cname);
+		if (pending->info.cname == NULL)
+			pending->rc = ENOMEM;
+		pending->info.addr = info->addr;
+	}
+
+	list_remove(&pending->lpending);
+	pending->done = true;
+	dns_pending_release(pending);
+	fibril_condvar_broadcast(&dns_query_cv);
+
+	fibril_mutex_unlock(&dns_query_lock);
+	return rc;
 }
 
 errno_t dns_name2host(const char *name, dns_host_info_t **rinfo, ip_ver_t ver)
@@ -199,22 +429,26 @@ errno_t dns_name2host(const char *name, dns_host_info_t **rinfo, ip_ver_t ver)
 
 	switch (ver) {
 	case ip_any:
-		rc = dns_name_query(name, DTYPE_AAAA, info);
+		rc = dns_cached_query(name, DTYPE_AAAA, info);
 
 		if (rc != EOK)
-			rc = dns_name_query(name, DTYPE_A, info);
+			rc = dns_cached_query(name, DTYPE_A, info);
 
 		break;
 	case ip_v4:
-		rc = dns_name_query(name, DTYPE_A, info);
+		rc = dns_cached_query(name, DTYPE_A, info);
 		break;
 	case ip_v6:
-		rc = dns_name_query(name, DTYPE_AAAA, info);
+		rc = dns_cached_query(name, DTYPE_AAAA, info);
 		break;
 	default:
 		rc = EINVAL;
 	}
 
+	/* Clients expect EIO if the name cannot be resolved */
+	if (rc == ENOENT)
+		rc = EIO;
+
 	if (rc == EOK)
 		*rinfo = info;
 	else
@@ -229,5 +463,24 @@ void dns_hostinfo_destroy(dns_host_info_t *info)
 	free(info);
 }
 
+/** Get resolver cache statistics.
+ *
+ * @param stats Place to store statistics
+ */
+void dns_query_cache_stats(dnsr_cache_stats_t *stats)
+{
+	fibril_mutex_lock(&dns_query_lock);
+	dns_cache_get_stats(dns_cache, stats);
+	fibril_mutex_unlock(&dns_query_lock);
+}
+
+/** Remove all entries from resolver cache. */
+void dns_query_cache_flush(void)
+{
+	fibril_mutex_lock(&dns_query_lock);
+	dns_cache_flush(dns_cache);
+	fibril_mutex_unlock(&dns_query_lock);
+}
+
 /** @}
  */
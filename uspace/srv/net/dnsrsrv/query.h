@@ -37,10 +37,14 @@
 #define QUERY_H
 
 #include <inet/addr.h>
+#include <types/dnsr.h>
 #include "dns_type.h"
 
+extern errno_t dns_query_init(void);
 extern errno_t dns_name2host(const char *, dns_host_info_t **, ip_ver_t);
 extern void dns_hostinfo_destroy(dns_host_info_t *);
+extern void dns_query_cache_stats(dnsr_cache_stats_t *);
+extern void dns_query_cache_flush(void);
 
 #endif
 
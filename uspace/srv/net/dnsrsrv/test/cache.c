@@ -0,0 +1,242 @@
+#include <errno.h>
+#include <inet/addr.h>
+#include <pcut/pcut.h>
+#include <stdlib.h>
+#include <str.h>
+
+#include "../cache.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(cache);
+
+/** Insert positive entry for @a name with address 10.0.0.<n> */
+static void test_insert(dns_cache_t *cache, const char *name, uint8_t n,
+    uint32_t ttl, time_t now)
+{
+	dns_host_info_t info;
+	errno_t rc;
+
+	info.cname = (char *) name;
+	inet_addr(&info.addr, 10, 0, 0, n);
+
+	rc = dns_cache_insert(cache, name, DTYPE_A, &info, ttl, now);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+}
+
+/** Return true if @a name is cached positively with address 10.0.0.<n> */
+static bool test_cached(dns_cache_t *cache, const char *name, uint8_t n,
+    time_t now)
+{
+	dns_host_info_t info;
+	inet_addr_t addr;
+	bool negative;
+	bool same;
+	errno_t rc;
+
+	rc = dns_cache_lookup(cache, name, DTYPE_A, now, &info, &negative);
+	if (rc != EOK)
+		return false;
+
+	PCUT_ASSERT_FALSE(negative);
+	inet_addr(&addr, 10, 0, 0, n);
+	same = inet_addr_compare(&addr, &info.addr);
+	free(info.cname);
+	return same;
+}
+
+/** Create and destroy cache */
+PCUT_TEST(create_destroy)
+{
+	dns_cache_t *cache;
+	errno_t rc;
+
+	rc = dns_cache_create(4, &cache);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	dns_cache_destroy(cache);
+}
+
+/** Positive entry is found until its TTL expires */
+PCUT_TEST(positive_ttl)
+{
+	dns_cache_t *cache;
+	dns_host_info_t info;
+	dnsr_cache_stats_t stats;
+	bool negative;
+	errno_t rc;
+
+	rc = dns_cache_create(4, &cache);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_insert(cache, "www.example.com", 1, 60, 100);
+
+	rc = dns_cache_lookup(cache, "www.example.com", DTYPE_A, 100, &info,
+	    &negative);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_FALSE(negative);
+	PCUT_ASSERT_STR_EQUALS("www.example.com", info.cname);
+	free(info.cname);
+
+	/* Names are case-insensitive, query type is part of the key */
+	PCUT_ASSERT_TRUE(test_cached(cache, "WWW.Example.COM", 1, 159));
+	rc = dns_cache_lookup(cache, "www.example.com", DTYPE_AAAA, 100,
+	    &info, &negative);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	/* Expired */
+	PCUT_ASSERT_FALSE(test_cached(cache, "www.example.com", 1, 160));
+
+	dns_cache_get_stats(cache, &stats);
+	PCUT_ASSERT_INT_EQUALS(0, stats.entries);
+	PCUT_ASSERT_INT_EQUALS(2, stats.hits);
+	PCUT_ASSERT_INT_EQUALS(2, stats.misses);
+	PCUT_ASSERT_INT_EQUALS(1, stats.expirations);
+
+	dns_cache_destroy(cache);
+}
+
+/** Negative entry */
+PCUT_TEST(negative)
+{
+	dns_cache_t *cache;
+	dns_host_info_t info;
+	dnsr_cache_stats_t stats;
+	bool negative;
+	errno_t rc;
+
+	rc = dns_cache_create(4, &cache);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = dns_cache_insert(cache, "nx.example.com", DTYPE_AAAA, NULL, 30,
+	    0);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	negative = false;
+	rc = dns_cache_lookup(cache, "nx.example.com", DTYPE_AAAA, 29, &info,
+	    &negative);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_TRUE(negative);
+
+	rc = dns_cache_lookup(cache, "nx.example.com", DTYPE_AAAA, 30, &info,
+	    &negative);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	dns_cache_get_stats(cache, &stats);
+	PCUT_ASSERT_INT_EQUALS(1, stats.neg_hits);
+	PCUT_ASSERT_INT_EQUALS(0, stats.hits);
+
+	dns_cache_destroy(cache);
+}
+
+/** Zero TTL is not cached, excessive TTL is capped */
+PCUT_TEST(ttl_limits)
+{
+	dns_cache_t *cache;
+	dns_host_info_t info;
+	bool negative;
+	errno_t rc;
+
+	rc = dns_cache_create(4, &cache);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_insert(cache, "a.example.com", 1, 0, 0);
+	PCUT_ASSERT_FALSE(test_cached(cache, "a.example.com", 1, 0));
+
+	test_insert(cache, "b.example.com", 2, UINT32_MAX, 0);
+	PCUT_ASSERT_TRUE(test_cached(cache, "b.example.com", 2,
+	    DNS_CACHE_TTL_MAX - 1));
+	PCUT_ASSERT_FALSE(test_cached(cache, "b.example.com", 2,
+	    DNS_CACHE_TTL_MAX));
+
+	rc = dns_cache_insert(cache, "c.example.com", DTYPE_A, NULL,
+	    UINT32_MAX, 0);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = dns_cache_lookup(cache, "c.example.com", DTYPE_A,
+	    DNS_CACHE_NEG_TTL_MAX, &info, &negative);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	dns_cache_destroy(cache);
+}
+
+/** Inserting an existing key replaces the entry */
+PCUT_TEST(replace)
+{
+	dns_cache_t *cache;
+	dnsr_cache_stats_t stats;
+	errno_t rc;
+
+	rc = dns_cache_create(4, &cache);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_insert(cache, "www.example.com", 1, 60, 0);
+	test_insert(cache, "WWW.example.com", 2, 60, 0);
+	PCUT_ASSERT_TRUE(test_cached(cache, "www.example.com", 2, 0));
+
+	dns_cache_get_stats(cache, &stats);
+	PCUT_ASSERT_INT_EQUALS(1, stats.entries);
+	PCUT_ASSERT_INT_EQUALS(0, stats.evictions);
+
+	dns_cache_destroy(cache);
+}
+
+/** Least recently used entry is evicted when cache is full */
+PCUT_TEST(lru_eviction)
+{
+	dns_cache_t *cache;
+	dnsr_cache_stats_t stats;
+	errno_t rc;
+
+	rc = dns_cache_create(3, &cache);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_insert(cache, "a", 1, 60, 0);
+	test_insert(cache, "b", 2, 60, 0);
+	test_insert(cache, "c", 3, 60, 0);
+
+	/* Touch a so that b becomes least recently used */
+	PCUT_ASSERT_TRUE(test_cached(cache, "a", 1, 0));
+
+	test_insert(cache, "d", 4, 60, 0);
+
+	PCUT_ASSERT_TRUE(test_cached(cache, "a", 1, 0));
+	PCUT_ASSERT_FALSE(test_cached(cache, "b", 2, 0));
+	PCUT_ASSERT_TRUE(test_cached(cache, "c", 3, 0));
+	PCUT_ASSERT_TRUE(test_cached(cache, "d", 4, 0));
+
+	dns_cache_get_stats(cache, &stats);
+	PCUT_ASSERT_INT_EQUALS(3, stats.entries);
+	PCUT_ASSERT_INT_EQUALS(1, stats.evictions);
+	PCUT_ASSERT_INT_EQUALS(4, stats.inserts);
+
+	dns_cache_destroy(cache);
+}
+
+/** Flush removes all entries */
+PCUT_TEST(flush)
+{
+	dns_cache_t *cache;
+	dnsr_cache_stats_t stats;
+	errno_t rc;
+
+	rc = dns_cache_create(4, &cache);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_insert(cache, "a", 1, 60, 0);
+	test_insert(cache, "b", 2, 60, 0);
+	dns_cache_flush(cache);
+
+	PCUT_ASSERT_FALSE(test_cached(cache, "a", 1, 0));
+	PCUT_ASSERT_FALSE(test_cached(cache, "b", 2, 0));
+
+	dns_cache_get_stats(cache, &stats);
+	PCUT_ASSERT_INT_EQUALS(0, stats.entries);
+
+	/* Cache is still usable */
+	test_insert(cache, "a", 1, 60, 0);
+	PCUT_ASSERT_TRUE(test_cached(cache, "a", 1, 0));
+
+	dns_cache_destroy(cache);
+}
+
+PCUT_EXPORT(cache);
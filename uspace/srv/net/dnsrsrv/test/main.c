@@ -0,0 +1,7 @@
+#include <pcut/pcut.h>
+
+PCUT_INIT;
+
+PCUT_IMPORT(cache);
+
+PCUT_MAIN();
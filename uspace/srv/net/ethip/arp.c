@@ -47,9 +47,6 @@
 #include "pdu.h"
 #include "std.h"
 
-/** Time to wait for ARP reply in microseconds */
-#define ARP_REQUEST_TIMEOUT (3 * 1000 * 1000)
-
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet);
 
 void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
@@ -94,6 +91,18 @@ void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
 	}
 }
 
+/** Translate IPv4 address to MAC address.
+ *
+ * Does not block. If the address is not known, an ARP request is sent
+ * and EINPROGRESS is returned.
+ *
+ * @param nic NIC
+ * @param src_addr Source IPv4 address
+ * @param ip_addr IPv4 address to translate
+ * @param mac_addr Place to store MAC address
+ * @return EOK on success, EINPROGRESS if address resolution is in
+ *         progress or an error code
+ */
 errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
     eth_addr_t *mac_addr)
 {
@@ -103,23 +112,29 @@ errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
 		return EOK;
 	}
 
-	errno_t rc = atrans_lookup(ip_addr, mac_addr);
-	if (rc == EOK)
-		return EOK;
+	return atrans_lookup(nic, src_addr, ip_addr, mac_addr);
+}
 
+/** Send ARP request.
+ *
+ * @param nic NIC
+ * @param src_addr Sender IPv4 address
+ * @param ip_addr Target IPv4 address
+ * @param dest Destination MAC address or @c NULL to broadcast
+ * @return EOK on success or an error code
+ */
+errno_t arp_request(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
+    const eth_addr_t *dest)
+{
 	arp_eth_packet_t packet;
 
 	packet.opcode = aop_request;
 	packet.sender_hw_addr = nic->mac_addr;
 	packet.sender_proto_addr = src_addr;
-	packet.target_hw_addr = eth_addr_broadcast;
+	packet.target_hw_addr = dest != NULL ? *dest : eth_addr_broadcast;
 	packet.target_proto_addr = ip_addr;
 
-	rc = arp_send_packet(nic, &packet);
-	if (rc != EOK)
-		return rc;
-
-	return atrans_lookup_timeout(ip_addr, ARP_REQUEST_TIMEOUT, mac_addr);
+	return arp_send_packet(nic, &packet);
 }
 
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet)
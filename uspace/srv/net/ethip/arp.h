@@ -44,6 +44,8 @@
 
 extern void arp_received(ethip_nic_t *, eth_frame_t *);
 extern errno_t arp_translate(ethip_nic_t *, addr32_t, addr32_t, eth_addr_t *);
+extern errno_t arp_request(ethip_nic_t *, addr32_t, addr32_t,
+    const eth_addr_t *);
 
 #endif
 
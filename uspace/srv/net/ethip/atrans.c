@@ -34,132 +34,210 @@
  * @brief
  */
 
-#include <adt/list.h>
 #include <errno.h>
-#include <fibril_synch.h>
+#include <inet/addr.h>
 #include <inet/eth_addr.h>
 #include <inet/iplink_srv.h>
+#include <inet/nbcache.h>
+#include <io/log.h>
+#include <mem.h>
 #include <stdlib.h>
 
+#include "arp.h"
 #include "atrans.h"
 #include "ethip.h"
+#include "std.h"
 
-/** Address translation list (of ethip_atrans_t) */
-static FIBRIL_MUTEX_INITIALIZE(atrans_list_lock);
-static LIST_INITIALIZE(atrans_list);
-static FIBRIL_CONDVAR_INITIALIZE(atrans_cv);
+/** Maximum number of address translation entries */
+#define ATRANS_MAX_ENTRIES 1024
 
-static ethip_atrans_t *atrans_find(addr32_t ip_addr)
-{
-	list_foreach(atrans_list, atrans_list, ethip_atrans_t, atrans) {
-		if (atrans->ip_addr == ip_addr)
-			return atrans;
-	}
+static errno_t atrans_solicit(void *, const inet_addr_t *, const inet_addr_t *,
+    const eth_addr_t *);
+static void atrans_xmit(void *, const eth_addr_t *);
+static void atrans_discard(void *);
 
-	return NULL;
-}
+static inet_nbcache_ops_t atrans_ops = {
+	.solicit = atrans_solicit,
+	.xmit = atrans_xmit,
+	.discard = atrans_discard
+};
 
-errno_t atrans_add(addr32_t ip_addr, eth_addr_t *mac_addr)
-{
-	ethip_atrans_t *atrans;
-	ethip_atrans_t *prev;
+/** Address translation cache */
+static inet_nbcache_t *atrans_cache;
 
-	atrans = calloc(1, sizeof(ethip_atrans_t));
-	if (atrans == NULL)
-		return ENOMEM;
+/** Initialize address translation.
+ *
+ * @return EOK on success or an error code
+ */
+errno_t atrans_init(void)
+{
+	errno_t rc;
 
-	atrans->ip_addr = ip_addr;
-	atrans->mac_addr = *mac_addr;
+	rc = inet_nbcache_create(ATRANS_MAX_ENTRIES, &atrans_ops, &atrans_cache);
+	if (rc != EOK)
+		return rc;
 
-	fibril_mutex_lock(&atrans_list_lock);
-	prev = atrans_find(ip_addr);
-	if (prev != NULL) {
-		list_remove(&prev->atrans_list);
-		free(prev);
+	rc = inet_nbcache_start(atrans_cache);
+	if (rc != EOK) {
+		inet_nbcache_destroy(atrans_cache);
+		atrans_cache = NULL;
+		return rc;
 	}
 
-	list_append(&atrans->atrans_list, &atrans_list);
-	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
-
 	return EOK;
 }
 
-errno_t atrans_remove(addr32_t ip_addr)
+/** Add or confirm address translation.
+ *
+ * Packets waiting for the address to be resolved are sent.
+ *
+ * @param ip_addr IPv4 address
+ * @param mac_addr MAC address
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t atrans_add(addr32_t ip_addr, eth_addr_t *mac_addr)
 {
-	ethip_atrans_t *atrans;
+	inet_addr_t addr;
 
-	fibril_mutex_lock(&atrans_list_lock);
-	atrans = atrans_find(ip_addr);
-	if (atrans == NULL) {
-		fibril_mutex_unlock(&atrans_list_lock);
-		return ENOENT;
-	}
+	inet_addr_set(ip_addr, &addr);
+	return inet_nbcache_update(atrans_cache, &addr, mac_addr,
+	    inet_nbcache_now());
+}
 
-	list_remove(&atrans->atrans_list);
-	fibril_mutex_unlock(&atrans_list_lock);
-	free(atrans);
+/** Remove address translation.
+ *
+ * @param ip_addr IPv4 address
+ * @return EOK on success, ENOENT if not found
+ */
+errno_t atrans_remove(addr32_t ip_addr)
+{
+	inet_addr_t addr;
 
-	return EOK;
+	inet_addr_set(ip_addr, &addr);
+	return inet_nbcache_remove(atrans_cache, &addr);
 }
 
-static errno_t atrans_lookup_locked(addr32_t ip_addr, eth_addr_t *mac_addr)
+/** Look up address translation.
+ *
+ * If the address is not known, an ARP request is sent and
+ * EINPROGRESS is returned. The packet can then be queued using
+ * atrans_enqueue().
+ *
+ * @param nic NIC for sending ARP requests
+ * @param src_addr Source IPv4 address for ARP requests
+ * @param ip_addr IPv4 address to translate
+ * @param mac_addr Place to store MAC address
+ * @return EOK on success, EINPROGRESS if address resolution is in
+ *         progress, ENOMEM if out of memory
+ */
+errno_t atrans_lookup(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
+    eth_addr_t *mac_addr)
 {
-	ethip_atrans_t *atrans = atrans_find(ip_addr);
-	if (atrans == NULL)
-		return ENOENT;
+	inet_addr_t src;
+	inet_addr_t addr;
 
-	*mac_addr = atrans->mac_addr;
-	return EOK;
+	inet_addr_set(src_addr, &src);
+	inet_addr_set(ip_addr, &addr);
+	return inet_nbcache_resolve(atrans_cache, nic, &src, &addr,
+	    inet_nbcache_now(), mac_addr);
 }
 
-errno_t atrans_lookup(addr32_t ip_addr, eth_addr_t *mac_addr)
+/** Queue IPv4 packet until its destination address is resolved.
+ *
+ * The packet data is copied.
+ *
+ * @param nic NIC to send the packet on
+ * @param ip_addr Destination IPv4 address
+ * @param data Packet data
+ * @param size Packet size
+ * @param mac_addr Place to store MAC address if it has been resolved
+ *                 in the meantime
+ * @return EINPROGRESS if the packet was queued, EOK if the address was
+ *         resolved in the meantime and the caller should send the packet,
+ *         ENOENT if resolution failed in the meantime, ENOMEM if out
+ *         of memory
+ */
+errno_t atrans_enqueue(ethip_nic_t *nic, addr32_t ip_addr, void *data,
+    size_t size, eth_addr_t *mac_addr)
 {
+	inet_addr_t addr;
+	ethip_qpkt_t *qpkt;
 	errno_t rc;
 
-	fibril_mutex_lock(&atrans_list_lock);
-	rc = atrans_lookup_locked(ip_addr, mac_addr);
-	fibril_mutex_unlock(&atrans_list_lock);
+	qpkt = calloc(1, sizeof(ethip_qpkt_t));
+	if (qpkt == NULL)
+		return ENOMEM;
+
+	qpkt->data = malloc(size);
+	if (qpkt->data == NULL) {
+		free(qpkt);
+		return ENOMEM;
+	}
+
+	memcpy(qpkt->data, data, size);
+	qpkt->size = size;
+	qpkt->nic = nic;
+
+	inet_addr_set(ip_addr, &addr);
+	rc = inet_nbcache_enqueue(atrans_cache, &addr, qpkt, mac_addr);
+	if (rc != EINPROGRESS)
+		atrans_discard(qpkt);
 
 	return rc;
 }
 
-static void atrans_lookup_timeout_handler(void *arg)
+/** Send ARP request on behalf of address translation cache.
+ *
+ * @param arg NIC
+ * @param src Source IPv4 address
+ * @param target Target IPv4 address
+ * @param dest Destination MAC address or @c NULL to broadcast
+ * @return EOK on success or an error code
+ */
+static errno_t atrans_solicit(void *arg, const inet_addr_t *src,
+    const inet_addr_t *target, const eth_addr_t *dest)
 {
-	bool *timedout = (bool *)arg;
+	ethip_nic_t *nic = (ethip_nic_t *) arg;
+	addr32_t src_v4;
+	addr32_t target_v4;
+
+	if (inet_addr_get(src, &src_v4, NULL) != ip_v4 ||
+	    inet_addr_get(target, &target_v4, NULL) != ip_v4)
+		return EINVAL;
 
-	fibril_mutex_lock(&atrans_list_lock);
-	*timedout = true;
-	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
+	return arp_request(nic, src_v4, target_v4, dest);
 }
 
-errno_t atrans_lookup_timeout(addr32_t ip_addr, usec_t timeout,
-    eth_addr_t *mac_addr)
+/** Send packet queued on address translation entry.
+ *
+ * @param arg Queued packet
+ * @param mac_addr Resolved MAC address
+ */
+static void atrans_xmit(void *arg, const eth_addr_t *mac_addr)
 {
-	fibril_timer_t *t;
-	bool timedout;
+	ethip_qpkt_t *qpkt = (ethip_qpkt_t *) arg;
 	errno_t rc;
 
-	t = fibril_timer_create(NULL);
-	if (t == NULL)
-		return ENOMEM;
-
-	timedout = false;
-	fibril_timer_set(t, timeout, atrans_lookup_timeout_handler, &timedout);
-
-	fibril_mutex_lock(&atrans_list_lock);
-
-	while ((rc = atrans_lookup_locked(ip_addr, mac_addr)) == ENOENT &&
-	    !timedout) {
-		fibril_condvar_wait(&atrans_cv, &atrans_list_lock);
+	rc = ethip_frame_send(qpkt->nic, mac_addr, ETYPE_IP, qpkt->data,
+	    qpkt->size);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Failed sending queued "
+		    "packet.");
 	}
 
-	fibril_mutex_unlock(&atrans_list_lock);
-	(void) fibril_timer_clear(t);
-	fibril_timer_destroy(t);
+	atrans_discard(qpkt);
+}
 
-	return rc;
+/** Free queued packet.
+ *
+ * @param arg Queued packet
+ */
+static void atrans_discard(void *arg)
+{
+	ethip_qpkt_t *qpkt = (ethip_qpkt_t *) arg;
+
+	free(qpkt->data);
+	free(qpkt);
 }
 
 /** @}
@@ -42,10 +42,12 @@
 #include <inet/iplink_srv.h>
 #include "ethip.h"
 
+extern errno_t atrans_init(void);
 extern errno_t atrans_add(addr32_t, eth_addr_t *);
 extern errno_t atrans_remove(addr32_t);
-extern errno_t atrans_lookup(addr32_t, eth_addr_t *);
-extern errno_t atrans_lookup_timeout(addr32_t, usec_t, eth_addr_t *);
+extern errno_t atrans_lookup(ethip_nic_t *, addr32_t, addr32_t, eth_addr_t *);
+extern errno_t atrans_enqueue(ethip_nic_t *, addr32_t, void *, size_t,
+    eth_addr_t *);
 
 #endif
 
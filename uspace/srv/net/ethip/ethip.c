@@ -46,6 +46,7 @@
 #include <stdlib.h>
 #include <task.h>
 #include "arp.h"
+#include "atrans.h"
 #include "ethip.h"
 #include "ethip_nic.h"
 #include "pdu.h"
@@ -81,7 +82,14 @@ static errno_t ethip_init(void)
 {
 	async_set_fallback_port_handler(ethip_client_conn, NULL);
 
-	errno_t rc = loc_server_register(NAME);
+	errno_t rc = atrans_init();
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed initializing address "
+		    "translation.");
+		return rc;
+	}
+
+	rc = loc_server_register(NAME);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed registering server.");
 		return rc;
@@ -170,35 +178,60 @@ static errno_t ethip_close(iplink_srv_t *srv)
 	return EOK;
 }
 
+/** Encapsulate payload in Ethernet frame and send it.
+ *
+ * @param nic NIC
+ * @param dest Destination MAC address
+ * @param etype Ethertype
+ * @param data Payload
+ * @param size Payload size
+ * @return EOK on success or an error code
+ */
+errno_t ethip_frame_send(ethip_nic_t *nic, const eth_addr_t *dest,
+    uint16_t etype, void *data, size_t size)
+{
+	eth_frame_t frame;
+
+	frame.dest = *dest;
+	frame.src = nic->mac_addr;
+	frame.etype_len = etype;
+	frame.data = data;
+	frame.size = size;
+
+	void *fdata;
+	size_t fsize;
+	errno_t rc = eth_pdu_encode(&frame, &fdata, &fsize);
+	if (rc != EOK)
+		return rc;
+
+	rc = ethip_nic_send(nic, fdata, fsize);
+	free(fdata);
+
+	return rc;
+}
+
 static errno_t ethip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_send()");
 
 	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
-	eth_frame_t frame;
+	eth_addr_t dest;
+
+	errno_t rc = arp_translate(nic, sdu->src, sdu->dest, &dest);
+	if (rc == EINPROGRESS) {
+		/* Do not block the sender, send once the address is resolved */
+		rc = atrans_enqueue(nic, sdu->dest, sdu->data, sdu->size, &dest);
+		if (rc == EINPROGRESS)
+			return EOK;
+	}
 
-	errno_t rc = arp_translate(nic, sdu->src, sdu->dest, &frame.dest);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_WARN, "Failed to look up IPv4 address 0x%"
 		    PRIx32, sdu->dest);
 		return rc;
 	}
 
-	frame.src = nic->mac_addr;
-	frame.etype_len = ETYPE_IP;
-	frame.data = sdu->data;
-	frame.size = sdu->size;
-
-	void *data;
-	size_t size;
-	rc = eth_pdu_encode(&frame, &data, &size);
-	if (rc != EOK)
-		return rc;
-
-	rc = ethip_nic_send(nic, data, size);
-	free(data);
-
-	return rc;
+	return ethip_frame_send(nic, &dest, ETYPE_IP, sdu->data, sdu->size);
 }
 
 static errno_t ethip_send6(iplink_srv_t *srv, iplink_sdu6_t *sdu)
@@ -206,24 +239,9 @@ static errno_t ethip_send6(iplink_srv_t *srv, iplink_sdu6_t *sdu)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_send6()");
 
 	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
-	eth_frame_t frame;
-
-	frame.dest = sdu->dest;
-	frame.src = nic->mac_addr;
-	frame.etype_len = ETYPE_IPV6;
-	frame.data = sdu->data;
-	frame.size = sdu->size;
-
-	void *data;
-	size_t size;
-	errno_t rc = eth_pdu_encode(&frame, &data, &size);
-	if (rc != EOK)
-		return rc;
 
-	rc = ethip_nic_send(nic, data, size);
-	free(data);
-
-	return rc;
+	return ethip_frame_send(nic, &sdu->dest, ETYPE_IPV6, sdu->data,
+	    sdu->size);
 }
 
 errno_t ethip_received(iplink_srv_t *srv, void *data, size_t size)
@@ -109,14 +109,19 @@ typedef struct {
 	addr32_t target_proto_addr;
 } arp_eth_packet_t;
 
-/** Address translation table element */
+/** IPv4 packet waiting for its destination address to be resolved */
 typedef struct {
-	link_t atrans_list;
-	addr32_t ip_addr;
-	eth_addr_t mac_addr;
-} ethip_atrans_t;
+	/** NIC to send the packet on */
+	ethip_nic_t *nic;
+	/** Packet data */
+	void *data;
+	/** Packet size */
+	size_t size;
+} ethip_qpkt_t;
 
 extern errno_t ethip_iplink_init(ethip_nic_t *);
+extern errno_t ethip_frame_send(ethip_nic_t *, const eth_addr_t *, uint16_t,
+    void *, size_t);
 extern errno_t ethip_received(iplink_srv_t *, void *, size_t);
 
 #endif
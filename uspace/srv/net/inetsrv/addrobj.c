@@ -38,6 +38,7 @@
 #include <errno.h>
 #include <fibril_synch.h>
 #include <inet/eth_addr.h>
+#include <inet/lpm.h>
 #include <io/log.h>
 #include <ipc/loc.h>
 #include <stdlib.h>
@@ -46,11 +47,16 @@
 #include "inetsrv.h"
 #include "inet_link.h"
 #include "ndp.h"
+#include "ntrans.h"
 
 static inet_addrobj_t *inet_addrobj_find_by_name_locked(const char *, inet_link_t *);
 
 static FIBRIL_MUTEX_INITIALIZE(addr_list_lock);
 static LIST_INITIALIZE(addr_list);
+/** Address objects indexed by network */
+static INET_LPM_INITIALIZE(addr_net_lpm);
+/** Address objects indexed by host address */
+static INET_LPM_INITIALIZE(addr_host_lpm);
 static sysarg_t addr_id = 0;
 
 inet_addrobj_t *inet_addrobj_new(void)
@@ -78,9 +84,111 @@ void inet_addrobj_delete(inet_addrobj_t *addr)
 	free(addr);
 }
 
+/** Get host address of address object as a network address.
+ *
+ * @param addr Address object
+ * @param host Place to store host address with full-length prefix
+ */
+static void inet_addrobj_host(inet_addrobj_t *addr, inet_naddr_t *host)
+{
+	inet_addr_t haddr;
+
+	inet_naddr_addr(&addr->naddr, &haddr);
+	inet_addr_naddr(&haddr, haddr.version == ip_v4 ? 32 : 128, host);
+}
+
+/** Index address object by network and host address.
+ *
+ * If another address object with the same network or host address
+ * is already indexed, it takes precedence. Address objects with invalid
+ * address never match and are not indexed.
+ *
+ * @param addr Address object
+ * @return EOK on success, ENOMEM if out of memory
+ */
+static errno_t inet_addrobj_index(inet_addrobj_t *addr)
+{
+	inet_naddr_t host;
+	errno_t rc;
+
+	assert(fibril_mutex_is_locked(&addr_list_lock));
+
+	rc = inet_lpm_insert(&addr_net_lpm, &addr->naddr, addr);
+	if (rc == ENOMEM)
+		return rc;
+
+	inet_addrobj_host(addr, &host);
+	rc = inet_lpm_insert(&addr_host_lpm, &host, addr);
+	if (rc == ENOMEM) {
+		if (inet_lpm_find(&addr_net_lpm, &addr->naddr) == addr)
+			(void) inet_lpm_remove(&addr_net_lpm, &addr->naddr);
+		return rc;
+	}
+
+	return EOK;
+}
+
+/** Remove address object from indices.
+ *
+ * Another address object with the same network or host address
+ * takes its place. The address object must already be removed from
+ * the address object list.
+ *
+ * @param addr Address object
+ */
+static void inet_addrobj_unindex(inet_addrobj_t *addr)
+{
+	inet_naddr_t host;
+	inet_naddr_t ahost;
+	inet_addr_t haddr;
+	errno_t rc;
+
+	assert(fibril_mutex_is_locked(&addr_list_lock));
+
+	inet_naddr_addr(&addr->naddr, &haddr);
+
+	if (inet_lpm_find(&addr_net_lpm, &addr->naddr) == addr) {
+		(void) inet_lpm_remove(&addr_net_lpm, &addr->naddr);
+
+		list_foreach(addr_list, addr_list, inet_addrobj_t, aobj) {
+			if (aobj->naddr.prefix != addr->naddr.prefix ||
+			    !inet_naddr_compare_mask(&aobj->naddr, &haddr))
+				continue;
+
+			rc = inet_lpm_insert(&addr_net_lpm, &aobj->naddr, aobj);
+			if (rc != EOK) {
+				log_msg(LOG_DEFAULT, LVL_ERROR, "Out of memory "
+				    "indexing address object.");
+			}
+
+			break;
+		}
+	}
+
+	inet_addrobj_host(addr, &host);
+	if (inet_lpm_find(&addr_host_lpm, &host) == addr) {
+		(void) inet_lpm_remove(&addr_host_lpm, &host);
+
+		list_foreach(addr_list, addr_list, inet_addrobj_t, aobj) {
+			if (!inet_naddr_compare(&aobj->naddr, &haddr))
+				continue;
+
+			inet_addrobj_host(aobj, &ahost);
+			rc = inet_lpm_insert(&addr_host_lpm, &ahost, aobj);
+			if (rc != EOK) {
+				log_msg(LOG_DEFAULT, LVL_ERROR, "Out of memory "
+				    "indexing address object.");
+			}
+
+			break;
+		}
+	}
+}
+
 errno_t inet_addrobj_add(inet_addrobj_t *addr)
 {
 	inet_addrobj_t *aobj;
+	errno_t rc;
 
 	fibril_mutex_lock(&addr_list_lock);
 	aobj = inet_addrobj_find_by_name_locked(addr->name, addr->ilink);
@@ -90,6 +198,12 @@ errno_t inet_addrobj_add(inet_addrobj_t *addr)
 		return EEXIST;
 	}
 
+	rc = inet_addrobj_index(addr);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&addr_list_lock);
+		return rc;
+	}
+
 	list_append(&addr->addr_list, &addr_list);
 	fibril_mutex_unlock(&addr_list_lock);
 
@@ -100,45 +214,41 @@ void inet_addrobj_remove(inet_addrobj_t *addr)
 {
 	fibril_mutex_lock(&addr_list_lock);
 	list_remove(&addr->addr_list);
+	inet_addrobj_unindex(addr);
 	fibril_mutex_unlock(&addr_list_lock);
 }
 
 /** Find address object matching address @a addr.
  *
  * @param addr Address
- * @oaram find iaf_net to find network (using mask),
+ * @oaram find iaf_net to find network (using mask, the most specific
+ *             network is returned),
  *             iaf_addr to find local address (exact match)
  *
  */
 inet_addrobj_t *inet_addrobj_find(inet_addr_t *addr, inet_addrobj_find_t find)
 {
+	inet_addrobj_t *aobj = NULL;
+
 	fibril_mutex_lock(&addr_list_lock);
 
-	list_foreach(addr_list, addr_list, inet_addrobj_t, naddr) {
-		switch (find) {
-		case iaf_net:
-			if (inet_naddr_compare_mask(&naddr->naddr, addr)) {
-				fibril_mutex_unlock(&addr_list_lock);
-				log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_addrobj_find: found %p",
-				    naddr);
-				return naddr;
-			}
-			break;
-		case iaf_addr:
-			if (inet_naddr_compare(&naddr->naddr, addr)) {
-				fibril_mutex_unlock(&addr_list_lock);
-				log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_addrobj_find: found %p",
-				    naddr);
-				return naddr;
-			}
-			break;
-		}
+	switch (find) {
+	case iaf_net:
+		aobj = inet_lpm_lookup(&addr_net_lpm, addr);
+		break;
+	case iaf_addr:
+		aobj = inet_lpm_lookup(&addr_host_lpm, addr);
+		break;
 	}
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_addrobj_find: Not found");
 	fibril_mutex_unlock(&addr_list_lock);
 
-	return NULL;
+	if (aobj != NULL)
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_addrobj_find: found %p", aobj);
+	else
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_addrobj_find: Not found");
+
+	return aobj;
 }
 
 /** Find address object on a link, with a specific name.
@@ -240,6 +350,14 @@ errno_t inet_addrobj_send_dgram(inet_addrobj_t *addr, inet_addr_t *ldest,
 		 * Translate local destination IPv6 address.
 		 */
 		rc = ndp_translate(lsrc_v6, ldest_v6, &ldest_mac, addr->ilink);
+		if (rc == EINPROGRESS) {
+			/* Do not block, send once the address is resolved */
+			rc = ntrans_enqueue(addr->ilink, ldest_v6, dgram, proto,
+			    ttl, df, &ldest_mac);
+			if (rc == EINPROGRESS)
+				return EOK;
+		}
+
 		if (rc != EOK)
 			return rc;
 
@@ -46,9 +46,6 @@
 #include "inet_link.h"
 #include "ndp.h"
 
-/** Time to wait for NDP reply in microseconds */
-#define NDP_REQUEST_TIMEOUT  (3 * 1000 * 1000)
-
 static addr128_t solicited_node_ip =
     { 0xff, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0xff, 0, 0, 0 };
 
@@ -142,6 +139,9 @@ errno_t ndp_received(inet_dgram_t *dgram)
 }
 
 /** Translate IPv6 to MAC address
+ *
+ * Does not block. If the address is not known, a neighbour solicitation
+ * is sent and EINPROGRESS is returned.
  *
  * @param src  Source IPv6 address
  * @param dest Destination IPv6 address
@@ -149,7 +149,8 @@ errno_t ndp_received(inet_dgram_t *dgram)
  * @param link Network interface
  *
  * @return EOK on success
- * @return ENOENT when NDP translation failed
+ * @return EINPROGRESS if NDP translation is in progress
+ * @return ENOMEM if not enough memory
  *
  */
 errno_t ndp_translate(addr128_t src_addr, addr128_t ip_addr, eth_addr_t *mac_addr,
@@ -161,24 +162,38 @@ errno_t ndp_translate(addr128_t src_addr, addr128_t ip_addr, eth_addr_t *mac_add
 		return EOK;
 	}
 
-	errno_t rc = ntrans_lookup(ip_addr, mac_addr);
-	if (rc == EOK)
-		return EOK;
+	return ntrans_lookup(ilink, src_addr, ip_addr, mac_addr);
+}
 
+/** Send neighbour solicitation
+ *
+ * @param ilink    Network interface
+ * @param src_addr Source IPv6 address
+ * @param ip_addr  Target IPv6 address
+ * @param dest     Destination MAC address or NULL to send to
+ *                 the solicited-node multicast address
+ *
+ * @return EOK on success or an error code
+ *
+ */
+errno_t ndp_solicit(inet_link_t *ilink, addr128_t src_addr, addr128_t ip_addr,
+    const eth_addr_t *dest)
+{
 	ndp_packet_t packet;
 
 	packet.opcode = ICMPV6_NEIGHBOUR_SOLICITATION;
 	packet.sender_hw_addr = ilink->mac;
 	addr128(src_addr, packet.sender_proto_addr);
 	addr128(ip_addr, packet.solicited_ip);
-	eth_addr_solicited_node(ip_addr, &packet.target_hw_addr);
-	ndp_solicited_node_ip(ip_addr, packet.target_proto_addr);
-
-	rc = ndp_send_packet(ilink, &packet);
-	if (rc != EOK)
-		return rc;
 
-	(void) ntrans_wait_timeout(NDP_REQUEST_TIMEOUT);
+	if (dest != NULL) {
+		/* Unicast probe to confirm reachability */
+		packet.target_hw_addr = *dest;
+		addr128(ip_addr, packet.target_proto_addr);
+	} else {
+		eth_addr_solicited_node(ip_addr, &packet.target_hw_addr);
+		ndp_solicited_node_ip(ip_addr, packet.target_proto_addr);
+	}
 
-	return ntrans_lookup(ip_addr, mac_addr);
+	return ndp_send_packet(ilink, &packet);
 }
@@ -66,5 +66,7 @@ typedef struct {
 
 extern errno_t ndp_received(inet_dgram_t *);
 extern errno_t ndp_translate(addr128_t, addr128_t, eth_addr_t *, inet_link_t *);
+extern errno_t ndp_solicit(inet_link_t *, addr128_t, addr128_t,
+    const eth_addr_t *);
 
 #endif
@@ -35,40 +35,65 @@
  * @brief
  */
 
-#include <adt/list.h>
 #include <errno.h>
-#include <fibril_synch.h>
+#include <inet/addr.h>
 #include <inet/eth_addr.h>
 #include <inet/iplink_srv.h>
+#include <inet/nbcache.h>
+#include <io/log.h>
+#include <mem.h>
 #include <stdlib.h>
+#include "inet_link.h"
+#include "ndp.h"
 #include "ntrans.h"
 
-/** Address translation list (of inet_ntrans_t) */
-static FIBRIL_MUTEX_INITIALIZE(ntrans_list_lock);
-static LIST_INITIALIZE(ntrans_list);
-static FIBRIL_CONDVAR_INITIALIZE(ntrans_cv);
+/** Maximum number of neighbour cache entries */
+#define NTRANS_MAX_ENTRIES 1024
 
-/** Look for address in translation table
+static errno_t ntrans_solicit(void *, const inet_addr_t *, const inet_addr_t *,
+    const eth_addr_t *);
+static void ntrans_xmit(void *, const eth_addr_t *);
+static void ntrans_discard(void *);
+
+static inet_nbcache_ops_t ntrans_ops = {
+	.solicit = ntrans_solicit,
+	.xmit = ntrans_xmit,
+	.discard = ntrans_discard
+};
+
+/** Neighbour cache */
+static inet_nbcache_t *ntrans_cache;
+
+/** Initialize translation table
  *
- * @param ip_addr IPv6 address
+ * @return EOK on success
+ * @return ENOMEM if not enough memory
  *
- * @return inet_ntrans_t with the address on success
- * @return NULL if nothing found
  */
-static inet_ntrans_t *ntrans_find(addr128_t ip_addr)
+errno_t ntrans_init(void)
 {
-	list_foreach(ntrans_list, ntrans_list, inet_ntrans_t, ntrans) {
-		if (addr128_compare(ntrans->ip_addr, ip_addr))
-			return ntrans;
+	errno_t rc;
+
+	rc = inet_nbcache_create(NTRANS_MAX_ENTRIES, &ntrans_ops, &ntrans_cache);
+	if (rc != EOK)
+		return rc;
+
+	rc = inet_nbcache_start(ntrans_cache);
+	if (rc != EOK) {
+		inet_nbcache_destroy(ntrans_cache);
+		ntrans_cache = NULL;
+		return rc;
 	}
 
-	return NULL;
+	return EOK;
 }
 
-/** Add entry to translation table
+/** Add or confirm entry in translation table
  *
- * @param ip_addr  IPv6 address of the new entry
- * @param mac_addr MAC address of the new entry
+ * Datagrams waiting for the address to be resolved are sent.
+ *
+ * @param ip_addr  IPv6 address of the entry
+ * @param mac_addr MAC address of the entry
  *
  * @return EOK on success
  * @return ENOMEM if not enough memory
@@ -76,28 +101,11 @@ static inet_ntrans_t *ntrans_find(addr128_t ip_addr)
  */
 errno_t ntrans_add(addr128_t ip_addr, eth_addr_t *mac_addr)
 {
-	inet_ntrans_t *ntrans;
-	inet_ntrans_t *prev;
-
-	ntrans = calloc(1, sizeof(inet_ntrans_t));
-	if (ntrans == NULL)
-		return ENOMEM;
-
-	addr128(ip_addr, ntrans->ip_addr);
-	ntrans->mac_addr = *mac_addr;
-
-	fibril_mutex_lock(&ntrans_list_lock);
-	prev = ntrans_find(ip_addr);
-	if (prev != NULL) {
-		list_remove(&prev->ntrans_list);
-		free(prev);
-	}
-
-	list_append(&ntrans->ntrans_list, &ntrans_list);
-	fibril_mutex_unlock(&ntrans_list_lock);
-	fibril_condvar_broadcast(&ntrans_cv);
+	inet_addr_t addr;
 
-	return EOK;
+	inet_addr_set6(ip_addr, &addr);
+	return inet_nbcache_update(ntrans_cache, &addr, mac_addr,
+	    inet_nbcache_now());
 }
 
 /** Remove entry from translation table
@@ -110,62 +118,149 @@ errno_t ntrans_add(addr128_t ip_addr, eth_addr_t *mac_addr)
  */
 errno_t ntrans_remove(addr128_t ip_addr)
 {
-	inet_ntrans_t *ntrans;
-
-	fibril_mutex_lock(&ntrans_list_lock);
-	ntrans = ntrans_find(ip_addr);
-	if (ntrans == NULL) {
-		fibril_mutex_unlock(&ntrans_list_lock);
-		return ENOENT;
-	}
-
-	list_remove(&ntrans->ntrans_list);
-	fibril_mutex_unlock(&ntrans_list_lock);
-	free(ntrans);
+	inet_addr_t addr;
 
-	return EOK;
+	inet_addr_set6(ip_addr, &addr);
+	return inet_nbcache_remove(ntrans_cache, &addr);
 }
 
 /** Translate IPv6 address to MAC address using the translation table
  *
+ * If the address is not known, a neighbour solicitation is sent.
+ *
+ * @param ilink    Link for sending neighbour solicitations
+ * @param src_addr Source IPv6 address for neighbour solicitations
  * @param ip_addr  IPv6 address to be translated
  * @param mac_addr MAC address to be assigned
  *
  * @return EOK on success
- * @return ENOENT when no such address found
+ * @return EINPROGRESS if address resolution is in progress
+ * @return ENOMEM if not enough memory
  *
  */
-errno_t ntrans_lookup(addr128_t ip_addr, eth_addr_t *mac_addr)
+errno_t ntrans_lookup(inet_link_t *ilink, addr128_t src_addr,
+    addr128_t ip_addr, eth_addr_t *mac_addr)
 {
-	fibril_mutex_lock(&ntrans_list_lock);
-	inet_ntrans_t *ntrans = ntrans_find(ip_addr);
-	if (ntrans == NULL) {
-		fibril_mutex_unlock(&ntrans_list_lock);
-		return ENOENT;
-	}
+	inet_addr_t src;
+	inet_addr_t addr;
 
-	fibril_mutex_unlock(&ntrans_list_lock);
-	*mac_addr = ntrans->mac_addr;
-	return EOK;
+	inet_addr_set6(src_addr, &src);
+	inet_addr_set6(ip_addr, &addr);
+	return inet_nbcache_resolve(ntrans_cache, ilink, &src, &addr,
+	    inet_nbcache_now(), mac_addr);
 }
 
-/** Wait on translation table CV for some time
+/** Queue datagram until its destination address is resolved
  *
- * @param timeout Timeout in microseconds
+ * The datagram data is copied.
  *
- * @return EOK if woken up by another fibril
- * @return ETIMEOUT if timed out
+ * @param ilink    Link to send the datagram on
+ * @param ip_addr  Local destination IPv6 address
+ * @param dgram    Datagram
+ * @param proto    Protocol
+ * @param ttl      Time to live
+ * @param df       Do not fragment
+ * @param mac_addr MAC address to be assigned if it has been resolved
+ *                 in the meantime
+ *
+ * @return EINPROGRESS if the datagram was queued
+ * @return EOK if the address was resolved in the meantime
+ *         and the caller should send the datagram
+ * @return ENOENT if address resolution failed in the meantime
+ * @return ENOMEM if not enough memory
  *
  */
-errno_t ntrans_wait_timeout(usec_t timeout)
+errno_t ntrans_enqueue(inet_link_t *ilink, addr128_t ip_addr,
+    inet_dgram_t *dgram, uint8_t proto, uint8_t ttl, int df,
+    eth_addr_t *mac_addr)
 {
-	fibril_mutex_lock(&ntrans_list_lock);
-	errno_t rc = fibril_condvar_wait_timeout(&ntrans_cv, &ntrans_list_lock,
-	    timeout);
-	fibril_mutex_unlock(&ntrans_list_lock);
+	inet_ntrans_qpkt_t *qpkt;
+	inet_addr_t addr;
+	errno_t rc;
+
+	qpkt = calloc(1, sizeof(inet_ntrans_qpkt_t));
+	if (qpkt == NULL)
+		return ENOMEM;
+
+	qpkt->dgram = *dgram;
+	qpkt->dgram.data = malloc(dgram->size);
+	if (qpkt->dgram.data == NULL) {
+		free(qpkt);
+		return ENOMEM;
+	}
+
+	memcpy(qpkt->dgram.data, dgram->data, dgram->size);
+	qpkt->ilink = ilink;
+	qpkt->proto = proto;
+	qpkt->ttl = ttl;
+	qpkt->df = df;
+
+	inet_addr_set6(ip_addr, &addr);
+	rc = inet_nbcache_enqueue(ntrans_cache, &addr, qpkt, mac_addr);
+	if (rc != EINPROGRESS)
+		ntrans_discard(qpkt);
 
 	return rc;
 }
 
+/** Send neighbour solicitation on behalf of neighbour cache
+ *
+ * @param arg    Link
+ * @param src    Source IPv6 address
+ * @param target Target IPv6 address
+ * @param dest   Destination MAC address or NULL for multicast
+ *
+ * @return EOK on success or an error code
+ *
+ */
+static errno_t ntrans_solicit(void *arg, const inet_addr_t *src,
+    const inet_addr_t *target, const eth_addr_t *dest)
+{
+	inet_link_t *ilink = (inet_link_t *) arg;
+	addr128_t src_v6;
+	addr128_t target_v6;
+
+	if (inet_addr_get(src, NULL, &src_v6) != ip_v6 ||
+	    inet_addr_get(target, NULL, &target_v6) != ip_v6)
+		return EINVAL;
+
+	return ndp_solicit(ilink, src_v6, target_v6, dest);
+}
+
+/** Send datagram queued on neighbour cache entry
+ *
+ * @param arg      Queued datagram
+ * @param mac_addr Resolved MAC address
+ *
+ */
+static void ntrans_xmit(void *arg, const eth_addr_t *mac_addr)
+{
+	inet_ntrans_qpkt_t *qpkt = (inet_ntrans_qpkt_t *) arg;
+	eth_addr_t mac = *mac_addr;
+	errno_t rc;
+
+	rc = inet_link_send_dgram6(qpkt->ilink, &mac, &qpkt->dgram,
+	    qpkt->proto, qpkt->ttl, qpkt->df);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Failed sending queued "
+		    "datagram.");
+	}
+
+	ntrans_discard(qpkt);
+}
+
+/** Free queued datagram
+ *
+ * @param arg Queued datagram
+ *
+ */
+static void ntrans_discard(void *arg)
+{
+	inet_ntrans_qpkt_t *qpkt = (inet_ntrans_qpkt_t *) arg;
+
+	free(qpkt->dgram.data);
+	free(qpkt);
+}
+
 /** @}
  */
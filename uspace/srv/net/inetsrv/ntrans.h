@@ -41,18 +41,29 @@
 #include <inet/addr.h>
 #include <inet/eth_addr.h>
 #include <inet/iplink_srv.h>
+#include "inetsrv.h"
 
-/** Address translation table element */
+/** Datagram waiting for its destination address to be resolved */
 typedef struct {
-	link_t ntrans_list;
-	addr128_t ip_addr;
-	eth_addr_t mac_addr;
-} inet_ntrans_t;
+	/** Link to send the datagram on */
+	inet_link_t *ilink;
+	/** Datagram */
+	inet_dgram_t dgram;
+	/** Protocol */
+	uint8_t proto;
+	/** Time to live */
+	uint8_t ttl;
+	/** Do not fragment */
+	int df;
+} inet_ntrans_qpkt_t;
 
+extern errno_t ntrans_init(void);
 extern errno_t ntrans_add(addr128_t, eth_addr_t *);
 extern errno_t ntrans_remove(addr128_t);
-extern errno_t ntrans_lookup(addr128_t, eth_addr_t *);
-extern errno_t ntrans_wait_timeout(usec_t);
+extern errno_t ntrans_lookup(inet_link_t *, addr128_t, addr128_t,
+    eth_addr_t *);
+extern errno_t ntrans_enqueue(inet_link_t *, addr128_t, inet_dgram_t *,
+    uint8_t, uint8_t, int, eth_addr_t *);
 
 #endif
 
@@ -37,6 +37,7 @@
 #include <bitops.h>
 #include <errno.h>
 #include <fibril_synch.h>
+#include <inet/lpm.h>
 #include <io/log.h>
 #include <ipc/loc.h>
 #include <stdlib.h>
@@ -47,6 +48,8 @@
 
 static FIBRIL_MUTEX_INITIALIZE(sroute_list_lock);
 static LIST_INITIALIZE(sroute_list);
+/** Static routes indexed by destination network */
+static INET_LPM_INITIALIZE(sroute_lpm);
 static sysarg_t sroute_id = 0;
 
 inet_sroute_t *inet_sroute_new(void)
@@ -74,61 +77,91 @@ void inet_sroute_delete(inet_sroute_t *sroute)
 	free(sroute);
 }
 
-void inet_sroute_add(inet_sroute_t *sroute)
+/** Add static route.
+ *
+ * If there already is a route to the same destination network,
+ * it takes precedence until it is removed.
+ *
+ * @param sroute Static route
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t inet_sroute_add(inet_sroute_t *sroute)
 {
+	errno_t rc;
+
 	fibril_mutex_lock(&sroute_list_lock);
+
+	/* Routes with invalid destination never match and are not indexed */
+	rc = inet_lpm_insert(&sroute_lpm, &sroute->dest, sroute);
+	if (rc == ENOMEM) {
+		fibril_mutex_unlock(&sroute_list_lock);
+		return rc;
+	}
+
 	list_append(&sroute->sroute_list, &sroute_list);
 	fibril_mutex_unlock(&sroute_list_lock);
+
+	return EOK;
+}
+
+/** Determine if two static routes have the same destination network.
+ *
+ * @param a First static route
+ * @param b Second static route
+ * @return @c true if destination networks are the same
+ */
+static bool inet_sroute_same_dest(inet_sroute_t *a, inet_sroute_t *b)
+{
+	inet_addr_t baddr;
+
+	inet_naddr_addr(&b->dest, &baddr);
+	return a->dest.prefix == b->dest.prefix &&
+	    inet_naddr_compare_mask(&a->dest, &baddr);
 }
 
 void inet_sroute_remove(inet_sroute_t *sroute)
 {
 	fibril_mutex_lock(&sroute_list_lock);
 	list_remove(&sroute->sroute_list);
+
+	if (inet_lpm_find(&sroute_lpm, &sroute->dest) == sroute) {
+		(void) inet_lpm_remove(&sroute_lpm, &sroute->dest);
+
+		/* Replace with another route to the same network, if any */
+		list_foreach(sroute_list, sroute_list, inet_sroute_t, sr) {
+			if (!inet_sroute_same_dest(sr, sroute))
+				continue;
+
+			if (inet_lpm_insert(&sroute_lpm, &sr->dest, sr) != EOK) {
+				log_msg(LOG_DEFAULT, LVL_ERROR, "Out of memory "
+				    "indexing static route.");
+			}
+
+			break;
+		}
+	}
+
 	fibril_mutex_unlock(&sroute_list_lock);
 }
 
 /** Find static route object matching address @a addr.
+ *
+ * The most specific route is returned.
  *
  * @param addr	Address
  */
 inet_sroute_t *inet_sroute_find(inet_addr_t *addr)
 {
-	ip_ver_t addr_ver = inet_addr_get(addr, NULL, NULL);
-
-	inet_sroute_t *best = NULL;
-	uint8_t best_bits = 0;
+	inet_sroute_t *sroute;
 
 	fibril_mutex_lock(&sroute_list_lock);
+	sroute = inet_lpm_lookup(&sroute_lpm, addr);
+	fibril_mutex_unlock(&sroute_list_lock);
 
-	list_foreach(sroute_list, sroute_list, inet_sroute_t, sroute) {
-		uint8_t dest_bits;
-		ip_ver_t dest_ver = inet_naddr_get(&sroute->dest, NULL, NULL,
-		    &dest_bits);
-
-		/* Skip comparison with different address family */
-		if (addr_ver != dest_ver)
-			continue;
-
-		/* Look for the most specific route */
-		if ((best != NULL) && (best_bits >= dest_bits))
-			continue;
-
-		if (inet_naddr_compare_mask(&sroute->dest, addr)) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: found candidate %p",
-			    sroute);
-
-			best = sroute;
-			best_bits = dest_bits;
-		}
-	}
-
-	if (best == NULL)
+	if (sroute == NULL)
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: Not found");
 
-	fibril_mutex_unlock(&sroute_list_lock);
-
-	return best;
+	return sroute;
 }
 
 /** Find static route with a specific name.
@@ -66,7 +66,7 @@ static FIBRIL_MUTEX_INITIALIZE(conn_list_lock);
 /** Connection association map */
 static amap_t *amap;
 /** Taken after tcp_conn_t lock */
-static FIBRIL_MUTEX_INITIALIZE(amap_lock);
+static FIBRIL_RWLOCK_INITIALIZE(amap_lock);
 
 /** Internal loopback configuration */
 tcp_lb_t tcp_conn_lb = tcp_lb_none;
@@ -310,20 +310,20 @@ errno_t tcp_conn_add(tcp_conn_t *conn)
 	errno_t rc;
 
 	tcp_conn_addref(conn);
-	fibril_mutex_lock(&amap_lock);
+	fibril_rwlock_write_lock(&amap_lock);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_add: conn=%p", conn);
 
 	rc = amap_insert(amap, &conn->ident, conn, af_allow_system, &aepp);
 	if (rc != EOK) {
 		tcp_conn_delref(conn);
-		fibril_mutex_unlock(&amap_lock);
+		fibril_rwlock_write_unlock(&amap_lock);
 		return rc;
 	}
 
 	conn->ident = aepp;
 	conn->mapped = true;
-	fibril_mutex_unlock(&amap_lock);
+	fibril_rwlock_write_unlock(&amap_lock);
 
 	return EOK;
 }
@@ -337,10 +337,10 @@ static void tcp_conn_remove(tcp_conn_t *conn)
 	if (!conn->mapped)
 		return;
 
-	fibril_mutex_lock(&amap_lock);
+	fibril_rwlock_write_lock(&amap_lock);
 	amap_remove(amap, &conn->ident);
 	conn->mapped = false;
-	fibril_mutex_unlock(&amap_lock);
+	fibril_rwlock_write_unlock(&amap_lock);
 	tcp_conn_delref(conn);
 }
 
@@ -432,24 +432,55 @@ tcp_conn_t *tcp_conn_find_ref(inet_ep2_t *epp)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_find_ref(%p)", epp);
 
-	fibril_mutex_lock(&amap_lock);
+	fibril_rwlock_read_lock(&amap_lock);
 
 	rc = amap_find_match(amap, epp, &arg);
 	if (rc != EOK) {
 		assert(rc == ENOENT);
-		fibril_mutex_unlock(&amap_lock);
+		fibril_rwlock_read_unlock(&amap_lock);
 		return NULL;
 	}
 
 	conn = (tcp_conn_t *)arg;
 	tcp_conn_addref(conn);
 
-	fibril_mutex_unlock(&amap_lock);
+	fibril_rwlock_read_unlock(&amap_lock);
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_find_ref: got conn=%p",
 	    conn);
 	return conn;
 }
 
+/** Determine whether endpoint pair belongs to connection.
+ *
+ * Unspecified parts of the connection identity match anything.
+ *
+ * @param conn	Connection
+ * @param epp	Endpoint pair, oriented for reception
+ * @return	@c true if @a epp matches the connection identity
+ */
+static bool tcp_conn_ident_match(tcp_conn_t *conn, inet_ep2_t *epp)
+{
+	inet_ep2_t *ident = &conn->ident;
+
+	if (!inet_addr_is_any(&ident->remote.addr) &&
+	    !inet_addr_compare(&ident->remote.addr, &epp->remote.addr))
+		return false;
+
+	if (ident->remote.port != inet_port_any &&
+	    ident->remote.port != epp->remote.port)
+		return false;
+
+	if (!inet_addr_is_any(&ident->local.addr) &&
+	    !inet_addr_compare(&ident->local.addr, &epp->local.addr))
+		return false;
+
+	if (ident->local.port != inet_port_any &&
+	    ident->local.port != epp->local.port)
+		return false;
+
+	return true;
+}
+
 /** Reset connection.
  *
  * @param conn	Connection
@@ -1229,6 +1260,7 @@ static void tcp_conn_seg_process(tcp_conn_t *conn, tcp_segment_t *seg)
 void tcp_conn_segment_arrived(tcp_conn_t *conn, inet_ep2_t *epp,
     tcp_segment_t *seg)
 {
+	tcp_conn_t *nconn;
 	inet_ep2_t aepp;
 	inet_ep2_t oldepp;
 	errno_t rc;
@@ -1238,6 +1270,26 @@ void tcp_conn_segment_arrived(tcp_conn_t *conn, inet_ep2_t *epp,
 
 	tcp_conn_lock(conn);
 
+	if (!tcp_conn_ident_match(conn, epp)) {
+		/*
+		 * Segments of different endpoint pairs are processed
+		 * concurrently. Since we found the connection, it has been
+		 * bound to another peer. Look up the connection again.
+		 */
+		tcp_conn_unlock(conn);
+
+		nconn = tcp_conn_find_ref(epp);
+		if (nconn == NULL) {
+			log_msg(LOG_DEFAULT, LVL_WARN, "No connection found.");
+			tcp_unexpected_segment(epp, seg);
+			return;
+		}
+
+		tcp_conn_segment_arrived(nconn, epp, seg);
+		tcp_conn_delref(nconn);
+		return;
+	}
+
 	if (conn->cstate == st_closed) {
 		log_msg(LOG_DEFAULT, LVL_WARN, "Connection is closed.");
 		tcp_unexpected_segment(epp, seg);
@@ -1254,7 +1306,7 @@ void tcp_conn_segment_arrived(tcp_conn_t *conn, inet_ep2_t *epp,
 		oldepp = conn->ident;
 
 		/* Need to remove and re-insert connection with new identity */
-		fibril_mutex_lock(&amap_lock);
+		fibril_rwlock_write_lock(&amap_lock);
 
 		if (inet_addr_is_any(&conn->ident.remote.addr))
 			conn->ident.remote.addr = epp->remote.addr;
@@ -1270,13 +1322,13 @@ void tcp_conn_segment_arrived(tcp_conn_t *conn, inet_ep2_t *epp,
 			assert(rc != EEXIST);
 			assert(rc == ENOMEM);
 			log_msg(LOG_DEFAULT, LVL_ERROR, "Out of memory.");
-			fibril_mutex_unlock(&amap_lock);
+			fibril_rwlock_write_unlock(&amap_lock);
 			tcp_conn_unlock(conn);
 			return;
 		}
 
 		amap_remove(amap, &oldepp);
-		fibril_mutex_unlock(&amap_lock);
+		fibril_rwlock_write_unlock(&amap_lock);
 
 		conn->name = (char *) "a";
 	}
@@ -31,9 +31,19 @@
  */
 
 /**
- * @file Global segment receive queue
+ * @file Segment receive queue
+ *
+ * Received segments are distributed among several worker fibrils based
+ * on a hash of the endpoint pair. All segments of one connection are thus
+ * processed by the same worker, in order, while a connection that is
+ * blocked (e.g. waiting for its lock) does not hold up the others.
+ * Segments from different peers can still reach the same listening
+ * connection concurrently, tcp_conn_segment_arrived() checks under the
+ * connection lock that the connection has not been bound to another peer.
+ * Queue entries are recycled via a per-worker pool.
  */
 
+#include <adt/hash.h>
 #include <adt/prodcons.h>
 #include <errno.h>
 #include <io/log.h>
@@ -47,34 +57,162 @@
 #include "tcp_type.h"
 #include "ucall.h"
 
-static prodcons_t rqueue;
-static bool fibril_active;
+/** Number of receive queue workers */
+#define RQUEUE_WORKERS 4
+
+/** Maximum number of free entries kept by each worker */
+#define RQUEUE_POOL_MAX 64
+
+static tcp_rqueue_worker_t workers[RQUEUE_WORKERS];
 static fibril_mutex_t lock;
 static fibril_condvar_t cv;
 static tcp_rqueue_cb_t *rqueue_cb;
 
+/** Compute hash of an internet address.
+ *
+ * @param addr Address
+ * @return Hash value
+ */
+static size_t tcp_rqueue_addr_hash(inet_addr_t *addr)
+{
+	size_t hash;
+	uint32_t w;
+	int i;
+
+	switch (addr->version) {
+	case ip_v4:
+		return addr->addr;
+	case ip_v6:
+		hash = 0;
+		for (i = 0; i < 16; i += 4) {
+			w = ((uint32_t) addr->addr6[i] << 24) |
+			    ((uint32_t) addr->addr6[i + 1] << 16) |
+			    ((uint32_t) addr->addr6[i + 2] << 8) |
+			    addr->addr6[i + 3];
+			hash = hash_combine(hash, w);
+		}
+		return hash;
+	default:
+		return 0;
+	}
+}
+
+/** Select worker for endpoint pair.
+ *
+ * @param epp Endpoint pair, oriented for reception
+ * @return Worker that processes segments for @a epp
+ */
+static tcp_rqueue_worker_t *tcp_rqueue_worker(inet_ep2_t *epp)
+{
+	size_t hash;
+
+	hash = tcp_rqueue_addr_hash(&epp->remote.addr);
+	hash = hash_combine(hash, epp->remote.port);
+	hash = hash_combine(hash, tcp_rqueue_addr_hash(&epp->local.addr));
+	hash = hash_combine(hash, epp->local.port);
+
+	return &workers[hash_mix(hash) % RQUEUE_WORKERS];
+}
+
+/** Allocate receive queue entry.
+ *
+ * @param worker Worker
+ * @return New entry or @c NULL if out of memory
+ */
+static tcp_rqueue_entry_t *tcp_rqueue_entry_new(tcp_rqueue_worker_t *worker)
+{
+	link_t *link;
+
+	fibril_mutex_lock(&worker->pool_lock);
+	link = list_first(&worker->pool);
+	if (link != NULL) {
+		list_remove(link);
+		--worker->pool_count;
+	}
+	fibril_mutex_unlock(&worker->pool_lock);
+
+	if (link != NULL)
+		return list_get_instance(link, tcp_rqueue_entry_t, link);
+
+	return calloc(1, sizeof(tcp_rqueue_entry_t));
+}
+
+/** Free receive queue entry.
+ *
+ * @param worker Worker
+ * @param rqe Entry
+ */
+static void tcp_rqueue_entry_delete(tcp_rqueue_worker_t *worker,
+    tcp_rqueue_entry_t *rqe)
+{
+	fibril_mutex_lock(&worker->pool_lock);
+	if (worker->pool_count < RQUEUE_POOL_MAX) {
+		list_append(&rqe->link, &worker->pool);
+		++worker->pool_count;
+		rqe = NULL;
+	}
+	fibril_mutex_unlock(&worker->pool_lock);
+
+	free(rqe);
+}
+
 /** Initialize segment receive queue. */
 void tcp_rqueue_init(tcp_rqueue_cb_t *rcb)
 {
-	prodcons_initialize(&rqueue);
+	int i;
+
+	for (i = 0; i < RQUEUE_WORKERS; i++) {
+		prodcons_initialize(&workers[i].queue);
+		fibril_mutex_initialize(&workers[i].pool_lock);
+		list_initialize(&workers[i].pool);
+		workers[i].pool_count = 0;
+		workers[i].active = false;
+	}
+
 	fibril_mutex_initialize(&lock);
 	fibril_condvar_initialize(&cv);
-	fibril_active = false;
 	rqueue_cb = rcb;
 }
 
 /** Finalize segment receive queue. */
 void tcp_rqueue_fini(void)
 {
-	inet_ep2_t epp;
+	tcp_rqueue_entry_t *rqe;
+	link_t *link;
+	bool active;
+	int i;
+
+	/* Tell each worker to terminate once it processes its queue */
+	for (i = 0; i < RQUEUE_WORKERS; i++) {
+		rqe = tcp_rqueue_entry_new(&workers[i]);
+		if (rqe == NULL) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Failed allocating RQE.");
+			return;
+		}
 
-	inet_ep2_init(&epp);
-	tcp_rqueue_insert_seg(&epp, NULL);
+		inet_ep2_init(&rqe->epp);
+		rqe->seg = NULL;
+		prodcons_produce(&workers[i].queue, &rqe->link);
+	}
 
 	fibril_mutex_lock(&lock);
-	while (fibril_active)
-		fibril_condvar_wait(&cv, &lock);
+	do {
+		active = false;
+		for (i = 0; i < RQUEUE_WORKERS; i++)
+			active = active || workers[i].active;
+		if (active)
+			fibril_condvar_wait(&cv, &lock);
+	} while (active);
 	fibril_mutex_unlock(&lock);
+
+	for (i = 0; i < RQUEUE_WORKERS; i++) {
+		while ((link = list_first(&workers[i].pool)) != NULL) {
+			list_remove(link);
+			free(list_get_instance(link, tcp_rqueue_entry_t, link));
+		}
+
+		workers[i].pool_count = 0;
+	}
 }
 
 /** Insert segment into receive queue.
@@ -84,6 +222,7 @@ void tcp_rqueue_fini(void)
  */
 void tcp_rqueue_insert_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 {
+	tcp_rqueue_worker_t *worker;
 	tcp_rqueue_entry_t *rqe;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "tcp_rqueue_insert_seg()");
@@ -91,7 +230,8 @@ void tcp_rqueue_insert_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 	if (seg != NULL)
 		tcp_segment_dump(seg);
 
-	rqe = calloc(1, sizeof(tcp_rqueue_entry_t));
+	worker = tcp_rqueue_worker(epp);
+	rqe = tcp_rqueue_entry_new(worker);
 	if (rqe == NULL) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed allocating RQE.");
 		return;
@@ -100,56 +240,67 @@ void tcp_rqueue_insert_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 	rqe->epp = *epp;
 	rqe->seg = seg;
 
-	prodcons_produce(&rqueue, &rqe->link);
+	prodcons_produce(&worker->queue, &rqe->link);
 }
 
-/** Receive queue handler fibril. */
+/** Receive queue worker fibril.
+ *
+ * @param arg Worker
+ */
 static errno_t tcp_rqueue_fibril(void *arg)
 {
+	tcp_rqueue_worker_t *worker = (tcp_rqueue_worker_t *) arg;
 	link_t *link;
 	tcp_rqueue_entry_t *rqe;
+	inet_ep2_t epp;
+	tcp_segment_t *seg;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_rqueue_fibril()");
 
 	while (true) {
-		link = prodcons_consume(&rqueue);
+		link = prodcons_consume(&worker->queue);
 		rqe = list_get_instance(link, tcp_rqueue_entry_t, link);
 
-		if (rqe->seg == NULL) {
-			free(rqe);
+		epp = rqe->epp;
+		seg = rqe->seg;
+		tcp_rqueue_entry_delete(worker, rqe);
+
+		if (seg == NULL)
 			break;
-		}
 
-		rqueue_cb->seg_received(&rqe->epp, rqe->seg);
-		free(rqe);
+		rqueue_cb->seg_received(&epp, seg);
 	}
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "tcp_rqueue_fibril() exiting");
 
 	/* Finished */
 	fibril_mutex_lock(&lock);
-	fibril_active = false;
+	worker->active = false;
 	fibril_mutex_unlock(&lock);
 	fibril_condvar_broadcast(&cv);
 
 	return 0;
 }
 
-/** Start receive queue handler fibril. */
+/** Start receive queue worker fibrils. */
 void tcp_rqueue_fibril_start(void)
 {
 	fid_t fid;
+	int i;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_rqueue_fibril_start()");
 
-	fid = fibril_create(tcp_rqueue_fibril, NULL);
-	if (fid == 0) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed creating rqueue fibril.");
-		return;
-	}
+	for (i = 0; i < RQUEUE_WORKERS; i++) {
+		fid = fibril_create(tcp_rqueue_fibril, &workers[i]);
+		if (fid == 0) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Failed creating "
+			    "rqueue fibril.");
+			return;
+		}
 
-	fibril_add_ready(fid);
-	fibril_active = true;
+		workers[i].active = true;
+		fibril_add_ready(fid);
+	}
 }
 
 /**
@@ -29,7 +29,7 @@
 /** @addtogroup tcp
  * @{
  */
-/** @file Global segment receive queue
+/** @file Segment receive queue
  */
 
 #ifndef RQUEUE_H
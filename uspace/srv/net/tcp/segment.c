@@ -34,6 +34,8 @@
  * @file Segment processing
  */
 
+#include <adt/list.h>
+#include <fibril_synch.h>
 #include <io/log.h>
 #include <mem.h>
 #include <stdlib.h>
@@ -41,17 +43,81 @@
 #include "seq_no.h"
 #include "tcp_type.h"
 
+/** Maximum number of deleted segments kept for reuse */
+#define SEG_POOL_MAX 256
+
+/** Size of data buffer kept with pooled segments (fits a typical MSS) */
+#define SEG_POOL_BUF_SIZE 2048
+
+/** Deleted segments kept for reuse */
+static LIST_INITIALIZE(seg_pool);
+static size_t seg_pool_count;
+static FIBRIL_MUTEX_INITIALIZE(seg_pool_lock);
+
 /** Alocate new segment structure. */
 static tcp_segment_t *tcp_segment_new(void)
 {
-	return calloc(1, sizeof(tcp_segment_t));
+	tcp_segment_t *seg;
+	link_t *link;
+	void *pbuf;
+
+	fibril_mutex_lock(&seg_pool_lock);
+	link = list_first(&seg_pool);
+	if (link != NULL) {
+		list_remove(link);
+		--seg_pool_count;
+	}
+	fibril_mutex_unlock(&seg_pool_lock);
+
+	if (link == NULL)
+		return calloc(1, sizeof(tcp_segment_t));
+
+	seg = list_get_instance(link, tcp_segment_t, lpool);
+	pbuf = seg->pbuf;
+	memset(seg, 0, sizeof(tcp_segment_t));
+	seg->pbuf = pbuf;
+	return seg;
+}
+
+/** Allocate segment data buffer.
+ *
+ * Small buffers are taken from the buffer kept with the segment
+ * structure.
+ *
+ * @param seg  Segment
+ * @param size Buffer size
+ * @return Buffer or @c NULL if out of memory
+ */
+static void *tcp_segment_data_alloc(tcp_segment_t *seg, size_t size)
+{
+	if (size <= SEG_POOL_BUF_SIZE) {
+		if (seg->pbuf == NULL)
+			seg->pbuf = malloc(SEG_POOL_BUF_SIZE);
+		return seg->pbuf;
+	}
+
+	seg->dfptr = malloc(size);
+	return seg->dfptr;
 }
 
 /** Delete segment. */
 void tcp_segment_delete(tcp_segment_t *seg)
 {
 	free(seg->dfptr);
-	free(seg);
+	seg->dfptr = NULL;
+
+	fibril_mutex_lock(&seg_pool_lock);
+	if (seg_pool_count < SEG_POOL_MAX) {
+		list_append(&seg->lpool, &seg_pool);
+		++seg_pool_count;
+		seg = NULL;
+	}
+	fibril_mutex_unlock(&seg_pool_lock);
+
+	if (seg != NULL) {
+		free(seg->pbuf);
+		free(seg);
+	}
 }
 
 /** Create duplicate of segment.
@@ -76,14 +142,13 @@ tcp_segment_t *tcp_segment_dup(tcp_segment_t *seg)
 	scopy->up = seg->up;
 
 	tsize = tcp_segment_text_size(seg);
-	scopy->data = calloc(tsize, 1);
+	scopy->data = tcp_segment_data_alloc(scopy, tsize);
 	if (scopy->data == NULL) {
-		free(scopy);
+		tcp_segment_delete(scopy);
 		return NULL;
 	}
 
 	memcpy(scopy->data, seg->data, tsize);
-	scopy->dfptr = scopy->data;
 
 	return scopy;
 }
@@ -147,9 +212,9 @@ tcp_segment_t *tcp_segment_make_data(tcp_control_t ctrl, void *data,
 	seg->ctrl = ctrl;
 	seg->len = seq_no_control_len(ctrl) + size;
 
-	seg->dfptr = seg->data = malloc(size);
-	if (seg->dfptr == NULL) {
-		free(seg);
+	seg->data = tcp_segment_data_alloc(seg, size);
+	if (seg->data == NULL) {
+		tcp_segment_delete(seg);
 		return NULL;
 	}
 
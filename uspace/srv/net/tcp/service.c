@@ -34,11 +34,13 @@
  * @file HelenOS service implementation
  */
 
+#include <as.h>
 #include <async.h>
 #include <errno.h>
 #include <str_error.h>
 #include <inet/endpoint.h>
 #include <inet/inet.h>
+#include <inet/shmring.h>
 #include <io/log.h>
 #include <ipc/services.h>
 #include <ipc/tcp.h>
@@ -57,6 +59,9 @@
 /** Maximum amount of data transferred in one send call */
 #define MAX_MSG_SIZE DATA_XFER_LIMIT
 
+/** Maximum amount of data moved to receive ring in one record */
+#define RING_CHUNK_MAX 16384
+
 static void tcp_ev_data(tcp_cconn_t *);
 static void tcp_ev_connected(tcp_cconn_t *);
 static void tcp_ev_conn_failed(tcp_cconn_t *);
@@ -68,6 +73,7 @@ static void tcp_service_recv_data(tcp_conn_t *, void *);
 static void tcp_service_lst_cstate_change(tcp_conn_t *, void *, tcp_cstate_t);
 
 static errno_t tcp_cconn_create(tcp_client_t *, tcp_conn_t *, tcp_cconn_t **);
+static void tcp_cconn_pump_req(tcp_cconn_t *);
 
 /** Connection callbacks to tie us to lower layer */
 static tcp_cb_t tcp_service_cb = {
@@ -195,7 +201,14 @@ static void tcp_service_recv_data(tcp_conn_t *conn, void *arg)
 {
 	tcp_cconn_t *cconn = (tcp_cconn_t *)arg;
 
-	tcp_ev_data(cconn);
+	/*
+	 * We are called with the connection locked and thus cannot
+	 * receive the data right here. Let the pump fibril do it.
+	 */
+	if (cconn->ring_area != NULL)
+		tcp_cconn_pump_req(cconn);
+	else
+		tcp_ev_data(cconn);
 }
 
 /** Send 'data' event to client.
@@ -331,9 +344,167 @@ static errno_t tcp_cconn_create(tcp_client_t *client, tcp_conn_t *conn,
 static void tcp_cconn_destroy(tcp_cconn_t *cconn)
 {
 	list_remove(&cconn->lclient);
+	if (cconn->ring_area != NULL)
+		as_area_destroy(cconn->ring_area);
 	free(cconn);
 }
 
+/** Send data from client connection's transmit ring.
+ *
+ * Data is sent until the ring is empty. The first error encountered
+ * is remembered and reported to the client in answer to its next
+ * ring request.
+ *
+ * @param cconn Client connection
+ */
+static void tcp_cconn_ring_send(tcp_cconn_t *cconn)
+{
+	void *buf;
+	size_t size;
+	tcp_error_t trc;
+	errno_t rc;
+
+	if (cconn->ring_area == NULL)
+		return;
+
+	while (true) {
+		rc = inet_shmring_read(&cconn->tx_ring, &buf, &size);
+		if (rc == ENOENT) {
+			if (inet_shmring_cons_wait(&cconn->tx_ring))
+				break;
+			continue;
+		}
+
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_WARN, "Corrupted transmit "
+			    "ring on connection %zu.", cconn->id);
+			if (cconn->ring_error == EOK)
+				cconn->ring_error = EIO;
+			break;
+		}
+
+		if (size > 0) {
+			trc = tcp_uc_send(cconn->conn, buf, size, 0);
+			if (trc != TCP_EOK && cconn->ring_error == EOK)
+				cconn->ring_error = EIO;
+		}
+
+		inet_shmring_consume(&cconn->tx_ring);
+	}
+}
+
+/** Move received data to client connection's receive ring.
+ *
+ * Data is moved until there is no more received data or the ring
+ * is full. In the latter case the client notifies us once it frees
+ * some space.
+ *
+ * @param cconn Client connection
+ */
+static void tcp_cconn_ring_recv(tcp_cconn_t *cconn)
+{
+	size_t chunk;
+	size_t nrecv;
+	xflags_t xflags;
+	void *buf;
+	tcp_error_t trc;
+	errno_t rc;
+
+	chunk = min(inet_shmring_max_record(&cconn->rx_ring), RING_CHUNK_MAX);
+
+	while (!cconn->rx_fin) {
+		rc = inet_shmring_reserve(&cconn->rx_ring, chunk, &buf);
+		if (rc == ENOSPC) {
+			if (inet_shmring_prod_wait(&cconn->rx_ring, chunk))
+				break;
+			continue;
+		}
+
+		if (rc != EOK)
+			break;
+
+		/* Receive directly into the ring */
+		trc = tcp_uc_receive(cconn->conn, buf, chunk, &nrecv, &xflags);
+		if (trc == TCP_ECLOSING) {
+			/* Zero-size record marks FIN */
+			nrecv = 0;
+			cconn->rx_fin = true;
+		} else if (trc != TCP_EOK || nrecv == 0) {
+			break;
+		}
+
+		inet_shmring_commit(&cconn->rx_ring, nrecv);
+		if (inet_shmring_kick_needed(&cconn->rx_ring))
+			tcp_ev_data(cconn);
+	}
+}
+
+/** Receive ring pump fibril.
+ *
+ * Moves received data to client connection's receive ring whenever
+ * requested via tcp_cconn_pump_req().
+ *
+ * @param arg Client connection
+ * @return EOK
+ */
+static errno_t tcp_cconn_pump_fibril(void *arg)
+{
+	tcp_cconn_t *cconn = (tcp_cconn_t *)arg;
+
+	fibril_mutex_lock(&cconn->pump_lock);
+
+	while (true) {
+		while (!cconn->pump_req && !cconn->pump_stop)
+			fibril_condvar_wait(&cconn->pump_cv, &cconn->pump_lock);
+
+		if (cconn->pump_stop)
+			break;
+
+		cconn->pump_req = false;
+		fibril_mutex_unlock(&cconn->pump_lock);
+
+		tcp_cconn_ring_recv(cconn);
+
+		fibril_mutex_lock(&cconn->pump_lock);
+	}
+
+	cconn->pump_done = true;
+	fibril_condvar_broadcast(&cconn->pump_cv);
+	fibril_mutex_unlock(&cconn->pump_lock);
+	return EOK;
+}
+
+/** Request receive ring pump to move received data to the ring.
+ *
+ * @param cconn Client connection
+ */
+static void tcp_cconn_pump_req(tcp_cconn_t *cconn)
+{
+	fibril_mutex_lock(&cconn->pump_lock);
+	cconn->pump_req = true;
+	fibril_condvar_broadcast(&cconn->pump_cv);
+	fibril_mutex_unlock(&cconn->pump_lock);
+}
+
+/** Stop receive ring pump.
+ *
+ * Must be called before the underlying connection is closed.
+ *
+ * @param cconn Client connection
+ */
+static void tcp_cconn_pump_stop(tcp_cconn_t *cconn)
+{
+	if (cconn->ring_area == NULL)
+		return;
+
+	fibril_mutex_lock(&cconn->pump_lock);
+	cconn->pump_stop = true;
+	fibril_condvar_broadcast(&cconn->pump_cv);
+	while (!cconn->pump_done)
+		fibril_condvar_wait(&cconn->pump_cv, &cconn->pump_lock);
+	fibril_mutex_unlock(&cconn->pump_lock);
+}
+
 /** Create client listener.
  *
  * Create client listener based on sentinel connection.
@@ -493,6 +664,8 @@ static errno_t tcp_conn_destroy_impl(tcp_client_t *client, sysarg_t conn_id)
 		return ENOENT;
 	}
 
+	tcp_cconn_ring_send(cconn);
+	tcp_cconn_pump_stop(cconn);
 	tcp_uc_close(cconn->conn);
 	tcp_uc_delete(cconn->conn);
 	tcp_cconn_destroy(cconn);
@@ -593,7 +766,7 @@ static errno_t tcp_conn_send_fin_impl(tcp_client_t *client, sysarg_t conn_id)
 		return ENOENT;
 	}
 
-	(void) cconn;
+	tcp_cconn_ring_send(cconn);
 	/* XXX TODO */
 	return EOK;
 }
@@ -618,7 +791,7 @@ static errno_t tcp_conn_push_impl(tcp_client_t *client, sysarg_t conn_id)
 		return ENOENT;
 	}
 
-	(void) cconn;
+	tcp_cconn_ring_send(cconn);
 	/* XXX TODO */
 	return EOK;
 }
@@ -643,6 +816,7 @@ static errno_t tcp_conn_reset_impl(tcp_client_t *client, sysarg_t conn_id)
 		return ENOENT;
 	}
 
+	tcp_cconn_ring_send(cconn);
 	tcp_uc_abort(cconn->conn);
 	return EOK;
 }
@@ -669,6 +843,9 @@ static errno_t tcp_conn_send_impl(tcp_client_t *client, sysarg_t conn_id,
 	if (rc != EOK)
 		return rc;
 
+	/* Data from the ring goes first */
+	tcp_cconn_ring_send(cconn);
+
 	trc = tcp_uc_send(cconn->conn, data, size, 0);
 	if (trc != TCP_EOK)
 		return EIO;
@@ -996,6 +1173,106 @@ static void tcp_conn_send_srv(tcp_client_t *client, ipc_call_t *icall)
 	free(data);
 }
 
+/** Set up data rings for connection.
+ *
+ * Handle client request to set up data rings. The client shares out
+ * an area holding the transmit ring in the first half and the receive ring
+ * in the second half.
+ *
+ * @param client TCP client
+ * @param icall  Async request data
+ *
+ */
+static void tcp_conn_ring_create_srv(tcp_client_t *client, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	tcp_cconn_t *cconn;
+	unsigned int flags;
+	size_t size;
+	void *area;
+	fid_t fid;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_ring_create_srv()");
+
+	if (!async_share_out_receive(&call, &size, &flags)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	rc = tcp_cconn_get(client, ipc_get_arg1(icall), &cconn);
+	if (rc == EOK && cconn->ring_area != NULL)
+		rc = EBUSY;
+	if (rc == EOK && (flags & AS_AREA_WRITE) == 0)
+		rc = EINVAL;
+	if (rc != EOK) {
+		async_answer_0(&call, rc);
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	rc = async_share_out_finalize(&call, &area);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	rc = inet_shmring_attach(area, size / 2, &cconn->tx_ring);
+	if (rc == EOK) {
+		rc = inet_shmring_attach((uint8_t *) area + size / 2,
+		    size / 2, &cconn->rx_ring);
+	}
+
+	if (rc != EOK) {
+		as_area_destroy(area);
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	fibril_mutex_initialize(&cconn->pump_lock);
+	fibril_condvar_initialize(&cconn->pump_cv);
+
+	fid = fibril_create(tcp_cconn_pump_fibril, cconn);
+	if (fid == 0) {
+		as_area_destroy(area);
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	cconn->ring_area = area;
+	fibril_add_ready(fid);
+
+	/* Move any data received so far */
+	tcp_cconn_pump_req(cconn);
+	async_answer_0(icall, EOK);
+}
+
+/** Handle activity in connection's data rings.
+ *
+ * Handle client notification that there is new data in the transmit ring
+ * or new space in the receive ring.
+ *
+ * @param client TCP client
+ * @param icall  Async request data
+ *
+ */
+static void tcp_conn_ring_kick_srv(tcp_client_t *client, ipc_call_t *icall)
+{
+	tcp_cconn_t *cconn;
+	errno_t rc;
+
+	rc = tcp_cconn_get(client, ipc_get_arg1(icall), &cconn);
+	if (rc != EOK || cconn->ring_area == NULL) {
+		async_answer_0(icall, ENOENT);
+		return;
+	}
+
+	tcp_cconn_ring_send(cconn);
+	tcp_cconn_pump_req(cconn);
+	async_answer_0(icall, cconn->ring_error);
+}
+
 /** Read received data from connection without blocking.
  *
  * Handle client request to read received data via connection without blocking.
@@ -1140,6 +1417,7 @@ static void tcp_client_fini(tcp_client_t *client)
 		while (!list_empty(&client->cconn)) {
 			cconn = list_get_instance(list_first(&client->cconn),
 			    tcp_cconn_t, lclient);
+			tcp_cconn_pump_stop(cconn);
 			tcp_uc_close(cconn->conn);
 			tcp_uc_delete(cconn->conn);
 			tcp_cconn_destroy(cconn);
@@ -1223,6 +1501,12 @@ static void tcp_client_conn(ipc_call_t *icall, void *arg)
 		case TCP_CONN_RECV_WAIT:
 			tcp_conn_recv_wait_srv(&client, &call);
 			break;
+		case TCP_CONN_RING_CREATE:
+			tcp_conn_ring_create_srv(&client, &call);
+			break;
+		case TCP_CONN_RING_KICK:
+			tcp_conn_ring_kick_srv(&client, &call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 			break;
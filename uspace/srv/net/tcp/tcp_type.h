@@ -36,7 +36,9 @@
 #define TCP_TYPE_H
 
 #include <adt/list.h>
+#include <adt/prodcons.h>
 #include <async.h>
+#include <errno.h>
 #include <stdbool.h>
 #include <fibril.h>
 #include <fibril_synch.h>
@@ -45,6 +47,7 @@
 #include <stdint.h>
 #include <inet/addr.h>
 #include <inet/endpoint.h>
+#include <inet/shmring.h>
 
 struct tcp_conn;
 
@@ -171,8 +174,12 @@ typedef struct {
 
 	/** Segment data, may be moved when trimming segment */
 	void *data;
-	/** Segment data, original pointer used to free data */
+	/** Separately allocated segment data (or @c NULL), used to free data */
 	void *dfptr;
+	/** Data buffer kept with the segment structure for reuse */
+	void *pbuf;
+	/** Link to segment pool */
+	link_t lpool;
 } tcp_segment_t;
 
 /** Receive queue entry */
@@ -182,6 +189,20 @@ typedef struct {
 	tcp_segment_t *seg;
 } tcp_rqueue_entry_t;
 
+/** Receive queue worker */
+typedef struct {
+	/** Queue of segments to process */
+	prodcons_t queue;
+	/** Protects @c pool */
+	fibril_mutex_t pool_lock;
+	/** Free entries for reuse */
+	list_t pool; /* of tcp_rqueue_entry_t */
+	/** Number of entries in @c pool */
+	size_t pool_count;
+	/** Worker fibril is running */
+	bool active;
+} tcp_rqueue_worker_t;
+
 /** Receive queue callbacks */
 typedef struct {
 	/** Segment received */
@@ -353,6 +374,26 @@ typedef struct tcp_cconn {
 	/** Client */
 	struct tcp_client *client;
 	link_t lclient;
+	/** Area shared with client containing data rings or @c NULL */
+	void *ring_area;
+	/** Ring of data sent by the client */
+	inet_shmring_t tx_ring;
+	/** Ring of data received for the client */
+	inet_shmring_t rx_ring;
+	/** Error encountered while sending data from transmit ring */
+	errno_t ring_error;
+	/** FIN has been placed in receive ring */
+	bool rx_fin;
+	/** Protects receive ring pump state */
+	fibril_mutex_t pump_lock;
+	/** Signals change of receive ring pump state */
+	fibril_condvar_t pump_cv;
+	/** Receive ring pump should move received data to the ring */
+	bool pump_req;
+	/** Receive ring pump should terminate */
+	bool pump_stop;
+	/** Receive ring pump has terminated */
+	bool pump_done;
 } tcp_cconn_t;
 
 /** TCP client listener */
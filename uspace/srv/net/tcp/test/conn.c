@@ -226,6 +226,94 @@ PCUT_TEST(conn_establish)
 	tcp_conn_delete(sconn);
 }
 
+/** Test two clients connecting to one listening connection */
+PCUT_TEST(conn_listen_two_remotes)
+{
+	tcp_conn_t *cconn[2], *sconn, *estab;
+	inet_ep2_t cepp, sepp;
+	int nestab;
+	int i;
+	errno_t rc;
+
+	/* Client EPP */
+	inet_ep2_init(&cepp);
+	inet_addr(&cepp.local.addr, 127, 0, 0, 1);
+	inet_addr(&cepp.remote.addr, 127, 0, 0, 1);
+	cepp.remote.port = inet_port_user_lo;
+
+	/* Server EPP */
+	inet_ep2_init(&sepp);
+	inet_addr(&sepp.local.addr, 127, 0, 0, 1);
+	sepp.local.port = inet_port_user_lo;
+
+	sconn = tcp_conn_new(&sepp);
+	PCUT_ASSERT_NOT_NULL(sconn);
+
+	rc = tcp_conn_add(sconn);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Two clients, each gets a different local port */
+	for (i = 0; i < 2; i++) {
+		cconn[i] = tcp_conn_new(&cepp);
+		PCUT_ASSERT_NOT_NULL(cconn[i]);
+
+		rc = tcp_conn_add(cconn[i]);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	}
+
+	PCUT_ASSERT_FALSE(cconn[0]->ident.local.port ==
+	    cconn[1]->ident.local.port);
+
+	/* Send both SYNs before waiting for either of them */
+	for (i = 0; i < 2; i++) {
+		tcp_conn_lock(cconn[i]);
+		tcp_conn_sync(cconn[i]);
+		tcp_conn_unlock(cconn[i]);
+	}
+
+	/* Exactly one client gets through, the other one is reset */
+	nestab = 0;
+	estab = NULL;
+	for (i = 0; i < 2; i++) {
+		tcp_conn_lock(cconn[i]);
+		while (cconn[i]->cstate == st_syn_sent)
+			fibril_condvar_wait(&cconn[i]->cstate_cv, &cconn[i]->lock);
+
+		if (cconn[i]->cstate == st_established) {
+			++nestab;
+			estab = cconn[i];
+		} else {
+			PCUT_ASSERT_INT_EQUALS(st_closed, cconn[i]->cstate);
+		}
+
+		tcp_conn_unlock(cconn[i]);
+	}
+
+	PCUT_ASSERT_INT_EQUALS(1, nestab);
+
+	/* The server side is bound to the client that got through */
+	tcp_conn_lock(sconn);
+	while (sconn->cstate == st_listen || sconn->cstate == st_syn_received)
+		fibril_condvar_wait(&sconn->cstate_cv, &sconn->lock);
+
+	PCUT_ASSERT_INT_EQUALS(st_established, sconn->cstate);
+	PCUT_ASSERT_INT_EQUALS(estab->ident.local.port,
+	    sconn->ident.remote.port);
+	tcp_conn_unlock(sconn);
+
+	for (i = 0; i < 2; i++) {
+		tcp_conn_lock(cconn[i]);
+		tcp_conn_reset(cconn[i]);
+		tcp_conn_unlock(cconn[i]);
+		tcp_conn_delete(cconn[i]);
+	}
+
+	tcp_conn_lock(sconn);
+	tcp_conn_reset(sconn);
+	tcp_conn_unlock(sconn);
+	tcp_conn_delete(sconn);
+}
+
 PCUT_TEST(ep2_flipped)
 {
 	inet_ep2_t a, fa;
@@ -39,7 +39,8 @@ PCUT_INIT;
 PCUT_TEST_SUITE(rqueue);
 
 enum {
-	test_seg_max = 10
+	test_seg_max = 10,
+	test_conn_max = 8
 };
 
 static void test_seg_received(inet_ep2_t *, tcp_segment_t *);
@@ -49,10 +50,12 @@ static tcp_rqueue_cb_t rcb = {
 };
 
 static int seg_cnt;
-static tcp_segment_t *recv_seg[test_seg_max];
+static tcp_segment_t *recv_seg[test_conn_max * test_seg_max];
+static uint16_t recv_port[test_conn_max * test_seg_max];
 
 static void test_seg_received(inet_ep2_t *epp, tcp_segment_t *seg)
 {
+	recv_port[seg_cnt] = epp->remote.port;
 	recv_seg[seg_cnt++] = seg;
 }
 
@@ -126,4 +129,52 @@ PCUT_TEST(multiple_segments)
 
 }
 
+/** Test segments of multiple connections are received in order */
+PCUT_TEST(multiple_conns)
+{
+	tcp_segment_t *seg[test_conn_max][test_seg_max];
+	int next[test_conn_max];
+	inet_ep2_t epp;
+	int c, i;
+
+	tcp_rqueue_init(&rcb);
+	seg_cnt = 0;
+
+	tcp_rqueue_fibril_start();
+
+	for (i = 0; i < test_seg_max; i++) {
+		for (c = 0; c < test_conn_max; c++) {
+			inet_ep2_init(&epp);
+			inet_addr(&epp.remote.addr, 127, 0, 0, 1);
+			epp.remote.port = 1000 + c;
+			epp.local.port = 80;
+
+			seg[c][i] = tcp_segment_make_ctrl(CTL_ACK);
+			PCUT_ASSERT_NOT_NULL(seg[c][i]);
+			tcp_rqueue_insert_seg(&epp, seg[c][i]);
+		}
+	}
+
+	tcp_rqueue_fini();
+
+	PCUT_ASSERT_INT_EQUALS(test_conn_max * test_seg_max, seg_cnt);
+
+	for (c = 0; c < test_conn_max; c++)
+		next[c] = 0;
+
+	/* Each connection's segments must arrive in order */
+	for (i = 0; i < seg_cnt; i++) {
+		c = recv_port[i] - 1000;
+		PCUT_ASSERT_TRUE(c >= 0 && c < test_conn_max);
+		PCUT_ASSERT_TRUE(next[c] < test_seg_max);
+		PCUT_ASSERT_EQUALS(seg[c][next[c]], recv_seg[i]);
+		++next[c];
+	}
+
+	for (c = 0; c < test_conn_max; c++) {
+		for (i = 0; i < test_seg_max; i++)
+			tcp_segment_delete(seg[c][i]);
+	}
+}
+
 PCUT_EXPORT(rqueue);
@@ -244,4 +244,46 @@ PCUT_TEST(data_seg_trim)
 	free(cdata);
 }
 
+/** Test reusing deleted segments with small and large data */
+PCUT_TEST(data_seg_reuse)
+{
+	tcp_segment_t *seg;
+	tcp_segment_t *dup;
+	uint8_t *data;
+	uint8_t *cdata;
+	size_t i, j, dsize;
+	size_t sizes[] = { 15, 4000, 0, 1500 };
+
+	dsize = 4000;
+	data = malloc(dsize);
+	PCUT_ASSERT_NOT_NULL(data);
+	cdata = malloc(dsize);
+	PCUT_ASSERT_NOT_NULL(cdata);
+
+	for (j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+		for (i = 0; i < sizes[j]; i++)
+			data[i] = (uint8_t) (i + j);
+
+		seg = tcp_segment_make_data(CTL_ACK, data, sizes[j]);
+		PCUT_ASSERT_NOT_NULL(seg);
+		PCUT_ASSERT_INT_EQUALS(CTL_ACK, seg->ctrl);
+		PCUT_ASSERT_INT_EQUALS(0, seg->seq);
+
+		dup = tcp_segment_dup(seg);
+		PCUT_ASSERT_NOT_NULL(dup);
+		tcp_segment_delete(seg);
+
+		PCUT_ASSERT_INT_EQUALS(sizes[j], tcp_segment_text_size(dup));
+		tcp_segment_text_copy(dup, cdata, sizes[j]);
+
+		for (i = 0; i < sizes[j]; i++)
+			PCUT_ASSERT_INT_EQUALS(data[i], cdata[i]);
+
+		tcp_segment_delete(dup);
+	}
+
+	free(data);
+	free(cdata);
+}
+
 PCUT_EXPORT(segment);
@@ -36,6 +36,7 @@
  * Ties UDP associations into the namespace of a client
  */
 
+#include <as.h>
 #include <errno.h>
 #include <inet/endpoint.h>
 #include <io/log.h>
@@ -116,6 +117,8 @@ errno_t udp_cassoc_create(udp_client_t *client, udp_assoc_t *assoc,
 void udp_cassoc_destroy(udp_cassoc_t *cassoc)
 {
 	list_remove(&cassoc->lclient);
+	if (cassoc->ring_area != NULL)
+		as_area_destroy(cassoc->ring_area);
 	free(cassoc);
 }
 
@@ -34,14 +34,17 @@
  * @file HelenOS service implementation
  */
 
+#include <as.h>
 #include <async.h>
 #include <errno.h>
 #include <inet/endpoint.h>
+#include <inet/shmring.h>
 #include <io/log.h>
 #include <ipc/services.h>
 #include <ipc/udp.h>
 #include <loc.h>
 #include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 
 #include "assoc.h"
@@ -79,10 +82,27 @@ static void udp_ev_data(udp_client_t *client)
 	async_forget(req);
 }
 
+/** Send 'ring' event to client.
+ *
+ * @param cassoc Client association
+ */
+static void udp_ev_ring(udp_cassoc_t *cassoc)
+{
+	async_exch_t *exch;
+
+	exch = async_exchange_begin(cassoc->client->sess);
+	async_msg_1(exch, UDP_EV_RING, cassoc->id);
+	async_exchange_end(exch);
+}
+
 /** Message received on client association.
  *
  * Used as udp_assoc_cb.recv_msg callback.
  *
+ * If the client set up message rings, the message is placed in the
+ * receive ring (and dropped if the ring is full). Otherwise it is queued
+ * until the client fetches it.
+ *
  * @param arg Callback argument, client association
  * @param epp Endpoint pair where message was received
  * @param msg Message
@@ -90,6 +110,25 @@ static void udp_ev_data(udp_client_t *client)
 static void udp_recv_msg_cassoc(void *arg, inet_ep2_t *epp, udp_msg_t *msg)
 {
 	udp_cassoc_t *cassoc = (udp_cassoc_t *) arg;
+	udp_ring_msg_t hdr;
+	errno_t rc;
+
+	if (cassoc->ring_area != NULL) {
+		hdr.ep = epp->remote;
+		rc = inet_shmring_write(&cassoc->rx_ring, &hdr, sizeof(hdr),
+		    msg->data, msg->data_size);
+		if (rc == EOK || rc == ENOSPC) {
+			if (rc == ENOSPC)
+				inet_shmring_drop(&cassoc->rx_ring);
+			else if (inet_shmring_kick_needed(&cassoc->rx_ring))
+				udp_ev_ring(cassoc);
+
+			udp_msg_delete(msg);
+			return;
+		}
+
+		/* Message too large for the ring, use the receive queue */
+	}
 
 	udp_cassoc_queue_msg(cassoc, epp, msg);
 	udp_ev_data(cassoc->client);
@@ -225,6 +264,120 @@ static errno_t udp_assoc_send_msg_impl(udp_client_t *client, sysarg_t assoc_id,
 	return EOK;
 }
 
+/** Set up message rings for association.
+ *
+ * Handle client request to set up message rings. The client shares
+ * out an area holding the transmit ring in the first half and the receive
+ * ring in the second half.
+ *
+ * @param client UDP client
+ * @param icall  Async request data
+ *
+ */
+static void udp_assoc_ring_create_srv(udp_client_t *client,
+    ipc_call_t *icall)
+{
+	ipc_call_t call;
+	udp_cassoc_t *cassoc;
+	unsigned int flags;
+	size_t size;
+	void *area;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_assoc_ring_create_srv()");
+
+	if (!async_share_out_receive(&call, &size, &flags)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	rc = udp_cassoc_get(client, ipc_get_arg1(icall), &cassoc);
+	if (rc == EOK && cassoc->ring_area != NULL)
+		rc = EBUSY;
+	if (rc == EOK && (flags & AS_AREA_WRITE) == 0)
+		rc = EINVAL;
+	if (rc != EOK) {
+		async_answer_0(&call, rc);
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	rc = async_share_out_finalize(&call, &area);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	rc = inet_shmring_attach(area, size / 2, &cassoc->tx_ring);
+	if (rc == EOK) {
+		rc = inet_shmring_attach((uint8_t *) area + size / 2,
+		    size / 2, &cassoc->rx_ring);
+	}
+
+	if (rc != EOK) {
+		as_area_destroy(area);
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	cassoc->ring_area = area;
+	async_answer_0(icall, EOK);
+}
+
+/** Send messages from association's transmit ring.
+ *
+ * Handle client notification that there are messages in the transmit
+ * ring. Messages are sent until the ring is empty.
+ *
+ * @param client UDP client
+ * @param icall  Async request data
+ *
+ */
+static void udp_assoc_ring_kick_srv(udp_client_t *client, ipc_call_t *icall)
+{
+	udp_cassoc_t *cassoc;
+	udp_ring_msg_t hdr;
+	udp_msg_t msg;
+	void *buf;
+	size_t size;
+	errno_t rc;
+
+	rc = udp_cassoc_get(client, ipc_get_arg1(icall), &cassoc);
+	if (rc != EOK || cassoc->ring_area == NULL) {
+		async_answer_0(icall, ENOENT);
+		return;
+	}
+
+	while (true) {
+		rc = inet_shmring_read(&cassoc->tx_ring, &buf, &size);
+		if (rc == ENOENT) {
+			if (inet_shmring_cons_wait(&cassoc->tx_ring))
+				break;
+			continue;
+		}
+
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_WARN, "Corrupted transmit "
+			    "ring on association %zu.", cassoc->id);
+			break;
+		}
+
+		if (size >= sizeof(hdr)) {
+			memcpy(&hdr, buf, sizeof(hdr));
+			msg.data = (uint8_t *) buf + sizeof(hdr);
+			msg.data_size = size - sizeof(hdr);
+
+			/* Errors are not reported for individual messages */
+			(void) udp_assoc_send(cassoc->assoc, &hdr.ep, &msg);
+		}
+
+		inet_shmring_consume(&cassoc->tx_ring);
+	}
+
+	async_answer_0(icall, rc == ENOENT ? EOK : rc);
+}
+
 /** Create callback session.
  *
  * Handle client request to create callback session.
@@ -617,6 +770,12 @@ static void udp_client_conn(ipc_call_t *icall, void *arg)
 		case UDP_RMSG_DISCARD:
 			udp_rmsg_discard_srv(&client, &call);
 			break;
+		case UDP_ASSOC_RING_CREATE:
+			udp_assoc_ring_create_srv(&client, &call);
+			break;
+		case UDP_ASSOC_RING_KICK:
+			udp_assoc_ring_kick_srv(&client, &call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 			break;
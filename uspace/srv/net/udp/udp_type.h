@@ -40,6 +40,7 @@
 #include <fibril.h>
 #include <fibril_synch.h>
 #include <inet/endpoint.h>
+#include <inet/shmring.h>
 #include <ipc/loc.h>
 #include <refcount.h>
 #include <stdbool.h>
@@ -168,6 +169,12 @@ typedef struct udp_cassoc {
 	/** Client */
 	struct udp_client *client;
 	link_t lclient;
+	/** Area shared with client containing message rings or @c NULL */
+	void *ring_area;
+	/** Ring of messages sent by the client */
+	inet_shmring_t tx_ring;
+	/** Ring of messages received for the client */
+	inet_shmring_t rx_ring;
 } udp_cassoc_t;
 
 /** UDP client receive queue entry */
@@ -37,6 +37,7 @@
 
 #include <abi/ipc/methods.h>
 #include <async.h>
+#include <boottrace.h>
 #include <ipc/ns.h>
 #include <ipc/services.h>
 #include <abi/ipc/interfaces.h>
@@ -98,10 +99,19 @@ static void ns_connection(ipc_call_t *icall, void *arg)
 				retval = ns_service_register(service, iface);
 			}
 
+			if (retval == EOK) {
+				boottrace_record(BOOTTRACE_NS_REGISTER,
+				    call.task_id, service, NULL);
+			}
+
 			break;
 		case NS_REGISTER_BROKER:
 			service = ipc_get_arg1(&call);
 			retval = ns_service_register_broker(service);
+			if (retval == EOK) {
+				boottrace_record(BOOTTRACE_NS_REGISTER,
+				    call.task_id, service, NULL);
+			}
 			break;
 		case NS_PING:
 			retval = EOK;
@@ -116,6 +126,10 @@ static void ns_connection(ipc_call_t *icall, void *arg)
 			break;
 		case NS_RETVAL:
 			retval = ns_task_retval(&call);
+			if (retval == EOK) {
+				boottrace_record(BOOTTRACE_TASK_READY,
+				    call.task_id, ipc_get_arg1(&call), NULL);
+			}
 			break;
 		default:
 			printf("%s: Method not supported (%" PRIun ")\n",
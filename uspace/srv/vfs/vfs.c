@@ -99,6 +99,22 @@ int main(int argc, char **argv)
 		return ENOMEM;
 	}
 
+	/*
+	 * Initialize VFS name cache.
+	 */
+	if (!vfs_dcache_init()) {
+		printf("%s: Failed to initialize VFS name cache\n", NAME);
+		return ENOMEM;
+	}
+
+	/*
+	 * Initialize VFS page cache.
+	 */
+	if (!vfs_cache_init()) {
+		printf("%s: Failed to initialize VFS page cache\n", NAME);
+		return ENOMEM;
+	}
+
 	/*
 	 * Allocate and initialize the Path Lookup Buffer.
 	 */
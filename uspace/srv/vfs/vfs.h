@@ -123,6 +123,9 @@ typedef struct _vfs_node {
 	 */
 	fibril_rwlock_t contents_rwlock;
 
+	/** The node has lost a link, purge its cached pages once unused. */
+	bool unlinked;
+
 	struct _vfs_node *mount;
 } vfs_node_t;
 
@@ -147,6 +150,35 @@ typedef struct {
 	bool append;
 } vfs_file_t;
 
+/**
+ * Instances of this type represent one page of file contents kept in the
+ * VFS page cache.
+ */
+typedef struct {
+	ht_link_t ph_link;	/**< Page cache hash-table link. */
+	link_t lru_link;	/**< Link in the LRU list of cached pages. */
+
+	/** Node the page belongs to. */
+	vfs_triplet_t triplet;
+	/** Page-aligned offset of the page within the file. */
+	aoff64_t offset;
+	/** Page contents, mapped in our address space. */
+	void *data;
+	/** Number of bytes of the page that lie within the file. */
+	size_t size;
+
+	/** Number of fibrils currently using the page. */
+	unsigned refcnt;
+	/** Page contents have been read in. */
+	bool valid;
+	/** File was written while the page was being read in. */
+	bool refill;
+	/** Page is no longer in the cache, free it once unused. */
+	bool stale;
+	/** Page is mapped shared and writable and may have been modified. */
+	bool dirty;
+} vfs_cache_page_t;
+
 extern fibril_mutex_t nodes_mutex;
 
 extern fibril_condvar_t fs_list_cv;
@@ -229,6 +261,30 @@ extern void vfs_register(ipc_call_t *);
 
 extern void vfs_page_in(ipc_call_t *);
 
+extern bool vfs_dcache_init(void);
+extern unsigned vfs_dcache_gen(void);
+extern bool vfs_dcache_find(vfs_triplet_t *, const char *, bool *,
+    vfs_lookup_res_t *);
+extern void vfs_dcache_insert(vfs_triplet_t *, const char *,
+    vfs_lookup_res_t *, unsigned);
+extern void vfs_dcache_remove(vfs_triplet_t *, const char *);
+extern void vfs_dcache_set_size(vfs_triplet_t *, aoff64_t);
+extern void vfs_dcache_purge_dir(vfs_triplet_t *);
+extern void vfs_dcache_purge_fs(fs_handle_t, service_id_t);
+extern bool vfs_dcache_enabled(vfs_triplet_t *);
+extern void vfs_dcache_enable(fs_handle_t, service_id_t, bool);
+
+extern bool vfs_cache_init(void);
+extern errno_t vfs_cache_get(vfs_node_t *, aoff64_t, vfs_cache_page_t **);
+extern void vfs_cache_put(vfs_cache_page_t *);
+extern void vfs_cache_mark_dirty(vfs_cache_page_t *);
+extern errno_t vfs_cache_read(vfs_node_t *, aoff64_t, size_t *);
+extern errno_t vfs_cache_writeback(vfs_node_t *);
+extern void vfs_cache_update(vfs_node_t *, aoff64_t, aoff64_t, size_t);
+extern void vfs_cache_resize(vfs_node_t *, aoff64_t);
+extern void vfs_cache_purge_node(vfs_triplet_t *);
+extern void vfs_cache_purge_fs(fs_handle_t, service_id_t);
+
 typedef struct {
 	void *buffer;
 	size_t size;
@@ -0,0 +1,773 @@
+/** @addtogroup vfs
+ * @{
+ */
+
+/**
+ * @file	vfs_cache.c
+ * @brief	VFS page cache.
+ *
+ * The page cache keeps file contents paged in through the VFS pager. Each
+ * cached page lives in its own anonymous area in our address space and the
+ * pager hands out the frame backing this area, so all read-only and shared
+ * mappings of a file page share one frame. The kernel holds a reference to
+ * the frame for each mapping, so evicting a page from the cache only drops
+ * our own reference.
+ *
+ * Reads through the VFS are served from cached pages when possible and
+ * writes update the cached pages in place, which keeps mappings coherent
+ * with vfs_read() and vfs_write(). Pages mapped shared and writable may be
+ * modified by their clients without us knowing, so they are considered
+ * dirty and are written back before the file is read or written via the
+ * file system server, on sync and on unmount. Dirty pages stay in the cache
+ * as we cannot tell when the last such mapping goes away.
+ */
+
+#include "vfs.h"
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <align.h>
+#include <as.h>
+#include <assert.h>
+#include <async.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <mem.h>
+#include <smc.h>
+#include <stats.h>
+#include <stdlib.h>
+
+/** Maximum number of pages in the page cache. */
+#define CACHE_PAGES_MAX		2048
+
+/** Number of page allocations between checks for memory pressure. */
+#define CACHE_PRESSURE_INTERVAL	16
+
+/** Less than 1/CACHE_PRESSURE_RATIO of memory free means memory pressure. */
+#define CACHE_PRESSURE_RATIO	32
+
+/** Number of pages to reclaim at once under memory pressure. */
+#define CACHE_RECLAIM_BATCH	64
+
+/** Mutex protecting the page cache. */
+static FIBRIL_MUTEX_INITIALIZE(cache_mutex);
+
+/** Signalled when a page has been read in or has failed to be read in. */
+static FIBRIL_CONDVAR_INITIALIZE(cache_cv);
+
+/** Page cache hash table. */
+static hash_table_t pages;
+
+/** Cached pages, most recently used first. */
+static LIST_INITIALIZE(cache_lru);
+
+/** Number of pages in the page cache. */
+static size_t cache_pages;
+
+/** Number of dirty pages in the page cache. */
+static size_t cache_dirty;
+
+/** Number of page allocations since the last check for memory pressure. */
+static unsigned cache_allocs;
+
+typedef struct {
+	vfs_triplet_t triplet;
+	aoff64_t offset;
+} cache_key_t;
+
+/** Set of pages of one node or of one file system instance. */
+typedef struct {
+	fs_handle_t fs_handle;
+	service_id_t service_id;
+	fs_index_t index;
+	/** Match pages of all nodes of the file system instance. */
+	bool all;
+
+	/** Only match dirty pages. */
+	bool dirty;
+	/** Matching pages. */
+	vfs_cache_page_t **pages;
+	/** Number of matching pages. */
+	size_t count;
+} cache_match_t;
+
+static size_t cache_key_hash(const void *key)
+{
+	const cache_key_t *ck = key;
+	size_t hash = hash_combine(ck->triplet.fs_handle, ck->triplet.index);
+	hash = hash_combine(hash, ck->triplet.service_id);
+	return hash_combine(hash, ck->offset / PAGE_SIZE);
+}
+
+static size_t cache_hash(const ht_link_t *item)
+{
+	vfs_cache_page_t *pg = hash_table_get_inst(item, vfs_cache_page_t,
+	    ph_link);
+	cache_key_t key = {
+		.triplet = pg->triplet,
+		.offset = pg->offset
+	};
+
+	return cache_key_hash(&key);
+}
+
+static bool cache_key_equal(const void *key, const ht_link_t *item)
+{
+	const cache_key_t *ck = key;
+	vfs_cache_page_t *pg = hash_table_get_inst(item, vfs_cache_page_t,
+	    ph_link);
+
+	return pg->triplet.fs_handle == ck->triplet.fs_handle &&
+	    pg->triplet.service_id == ck->triplet.service_id &&
+	    pg->triplet.index == ck->triplet.index &&
+	    pg->offset == ck->offset;
+}
+
+/** Page cache hash table operations. */
+static hash_table_ops_t pages_ops = {
+	.hash = cache_hash,
+	.key_hash = cache_key_hash,
+	.key_equal = cache_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL,
+};
+
+/** Initialize the VFS page cache.
+ *
+ * @return		Return true on success, false on failure.
+ */
+bool vfs_cache_init(void)
+{
+	return hash_table_create(&pages, 0, 0, &pages_ops);
+}
+
+static void cache_key_init(cache_key_t *key, vfs_node_t *node,
+    aoff64_t offset)
+{
+	key->triplet.fs_handle = node->fs_handle;
+	key->triplet.service_id = node->service_id;
+	key->triplet.index = node->index;
+	key->offset = offset;
+}
+
+static bool cache_match(vfs_cache_page_t *pg, cache_match_t *match)
+{
+	return pg->triplet.fs_handle == match->fs_handle &&
+	    pg->triplet.service_id == match->service_id &&
+	    (match->all || pg->triplet.index == match->index);
+}
+
+static vfs_cache_page_t *cache_page_create(cache_key_t *key)
+{
+	vfs_cache_page_t *pg = malloc(sizeof(vfs_cache_page_t));
+	if (pg == NULL)
+		return NULL;
+
+	memset(pg, 0, sizeof(vfs_cache_page_t));
+	pg->triplet = key->triplet;
+	pg->offset = key->offset;
+	link_initialize(&pg->lru_link);
+
+	pg->data = as_area_create(AS_AREA_ANY, PAGE_SIZE,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
+	    AS_AREA_UNPAGED);
+	if (pg->data == AS_MAP_FAILED) {
+		free(pg);
+		return NULL;
+	}
+
+	return pg;
+}
+
+static void cache_page_destroy(vfs_cache_page_t *pg)
+{
+	as_area_destroy(pg->data);
+	free(pg);
+}
+
+/** Remove page from the page cache.
+ *
+ * The page is destroyed by the last vfs_cache_put() if it is in use.
+ * Must be called with cache_mutex held.
+ *
+ * @param pg	Cached page.
+ * @return	True if the page is not in use and the caller should destroy it.
+ */
+static bool cache_page_remove(vfs_cache_page_t *pg)
+{
+	assert(!pg->stale);
+
+	hash_table_remove_item(&pages, &pg->ph_link);
+	list_remove(&pg->lru_link);
+	cache_pages--;
+	if (pg->dirty)
+		cache_dirty--;
+
+	pg->stale = true;
+	return pg->refcnt == 0;
+}
+
+/** Read page contents from the file system server.
+ *
+ * The part of the page beyond the end of the file is cleared.
+ *
+ * @param pg	Cached page.
+ * @param size	Place to store the number of bytes within the file.
+ * @return	EOK on success or an error code.
+ */
+static errno_t cache_page_read(vfs_cache_page_t *pg, size_t *size)
+{
+	size_t total = 0;
+	errno_t rc = EOK;
+
+	while (total < PAGE_SIZE) {
+		aoff64_t pos = pg->offset + total;
+		ipc_call_t answer;
+
+		async_exch_t *exch = vfs_exchange_grab(pg->triplet.fs_handle);
+		aid_t msg = async_send_4(exch, VFS_OUT_READ,
+		    pg->triplet.service_id, pg->triplet.index, LOWER32(pos),
+		    UPPER32(pos), &answer);
+
+		rc = async_data_read_start(exch, pg->data + total,
+		    PAGE_SIZE - total);
+		if (rc != EOK) {
+			async_forget(msg);
+			vfs_exchange_release(exch);
+			return rc;
+		}
+
+		async_wait_for(msg, &rc);
+		vfs_exchange_release(exch);
+		if (rc != EOK)
+			return rc;
+
+		size_t nread = ipc_get_arg1(&answer);
+		if (nread == 0)
+			break;
+
+		total += nread;
+	}
+
+	memset(pg->data + total, 0, PAGE_SIZE - total);
+
+	/* The page may be mapped executable by the pager clients. */
+	(void) smc_coherence(pg->data, PAGE_SIZE);
+
+	*size = total;
+	return EOK;
+}
+
+/** Write page contents back to the file system server.
+ *
+ * Only the part of the page within the file is written so that the file
+ * does not grow.
+ *
+ * @param pg	Cached page.
+ * @return	EOK on success or an error code.
+ */
+static errno_t cache_page_write(vfs_cache_page_t *pg)
+{
+	size_t total = 0;
+	errno_t rc;
+
+	while (total < pg->size) {
+		aoff64_t pos = pg->offset + total;
+		ipc_call_t answer;
+
+		async_exch_t *exch = vfs_exchange_grab(pg->triplet.fs_handle);
+		aid_t msg = async_send_4(exch, VFS_OUT_WRITE,
+		    pg->triplet.service_id, pg->triplet.index, LOWER32(pos),
+		    UPPER32(pos), &answer);
+
+		rc = async_data_write_start(exch, pg->data + total,
+		    pg->size - total);
+		if (rc != EOK) {
+			async_forget(msg);
+			vfs_exchange_release(exch);
+			return rc;
+		}
+
+		async_wait_for(msg, &rc);
+		vfs_exchange_release(exch);
+		if (rc != EOK)
+			return rc;
+
+		size_t nwritten = ipc_get_arg1(&answer);
+		if (nwritten == 0)
+			return EIO;
+
+		total += nwritten;
+	}
+
+	return EOK;
+}
+
+/** Determine whether the system is running low on physical memory. */
+static bool cache_memory_low(void)
+{
+	stats_physmem_t *physmem = stats_get_physmem();
+	if (physmem == NULL)
+		return false;
+
+	bool low = physmem->free < physmem->total / CACHE_PRESSURE_RATIO;
+	free(physmem);
+	return low;
+}
+
+/** Make room for a new page in the page cache.
+ *
+ * Evicts least recently used pages which are neither in use nor dirty when
+ * the cache is full or the system is short of memory.
+ * Must be called with cache_mutex held.
+ */
+static void cache_reclaim(void)
+{
+	size_t goal = 0;
+
+	if (cache_pages >= CACHE_PAGES_MAX)
+		goal = cache_pages - CACHE_PAGES_MAX + 1;
+
+	if (++cache_allocs >= CACHE_PRESSURE_INTERVAL) {
+		cache_allocs = 0;
+		if (cache_memory_low())
+			goal = max(goal, CACHE_RECLAIM_BATCH);
+	}
+
+	link_t *link = list_last(&cache_lru);
+	while (goal > 0 && link != NULL) {
+		link_t *prev = list_prev(link, &cache_lru);
+		vfs_cache_page_t *pg = list_get_instance(link,
+		    vfs_cache_page_t, lru_link);
+
+		if (pg->refcnt == 0 && !pg->dirty) {
+			if (cache_page_remove(pg))
+				cache_page_destroy(pg);
+			goal--;
+		}
+
+		link = prev;
+	}
+}
+
+/** Get page of a file from the page cache.
+ *
+ * The page is read in from the file system server if it is not cached.
+ * The caller must hold the node's contents lock and must eventually return
+ * the page by calling vfs_cache_put().
+ *
+ * @param node		VFS node of the file.
+ * @param offset	Page-aligned offset of the page within the file.
+ * @param rpage		Place to store the cached page.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t vfs_cache_get(vfs_node_t *node, aoff64_t offset,
+    vfs_cache_page_t **rpage)
+{
+	vfs_cache_page_t *pg;
+	cache_key_t key;
+	size_t size;
+	errno_t rc;
+
+	assert(ALIGN_DOWN(offset, PAGE_SIZE) == offset);
+	cache_key_init(&key, node, offset);
+
+	fibril_mutex_lock(&cache_mutex);
+
+	while (true) {
+		ht_link_t *link = hash_table_find(&pages, &key);
+		if (link == NULL)
+			break;
+
+		pg = hash_table_get_inst(link, vfs_cache_page_t, ph_link);
+		if (pg->valid) {
+			pg->refcnt++;
+			list_remove(&pg->lru_link);
+			list_prepend(&pg->lru_link, &cache_lru);
+			fibril_mutex_unlock(&cache_mutex);
+
+			*rpage = pg;
+			return EOK;
+		}
+
+		/* Another fibril is reading the page in. */
+		fibril_condvar_wait(&cache_cv, &cache_mutex);
+	}
+
+	cache_reclaim();
+
+	pg = cache_page_create(&key);
+	if (pg == NULL) {
+		fibril_mutex_unlock(&cache_mutex);
+		return ENOMEM;
+	}
+
+	pg->refcnt = 1;
+	hash_table_insert(&pages, &pg->ph_link);
+	list_prepend(&pg->lru_link, &cache_lru);
+	cache_pages++;
+
+	do {
+		pg->refill = false;
+		fibril_mutex_unlock(&cache_mutex);
+		rc = cache_page_read(pg, &size);
+		fibril_mutex_lock(&cache_mutex);
+	} while (rc == EOK && pg->refill);
+
+	if (rc != EOK) {
+		if (!pg->stale)
+			(void) cache_page_remove(pg);
+		pg->refcnt--;
+		fibril_condvar_broadcast(&cache_cv);
+		fibril_mutex_unlock(&cache_mutex);
+
+		cache_page_destroy(pg);
+		return rc;
+	}
+
+	pg->size = size;
+	pg->valid = true;
+	fibril_condvar_broadcast(&cache_cv);
+	fibril_mutex_unlock(&cache_mutex);
+
+	*rpage = pg;
+	return EOK;
+}
+
+/** Return page obtained by vfs_cache_get().
+ *
+ * @param pg	Cached page.
+ */
+void vfs_cache_put(vfs_cache_page_t *pg)
+{
+	fibril_mutex_lock(&cache_mutex);
+	assert(pg->refcnt > 0);
+	pg->refcnt--;
+	bool destroy = pg->refcnt == 0 && pg->stale;
+	fibril_mutex_unlock(&cache_mutex);
+
+	if (destroy)
+		cache_page_destroy(pg);
+}
+
+/** Mark page as mapped shared and writable.
+ *
+ * @param pg	Cached page.
+ */
+void vfs_cache_mark_dirty(vfs_cache_page_t *pg)
+{
+	fibril_mutex_lock(&cache_mutex);
+	if (!pg->dirty && !pg->stale) {
+		pg->dirty = true;
+		cache_dirty++;
+	}
+	fibril_mutex_unlock(&cache_mutex);
+}
+
+/** Serve client's read request from the page cache.
+ *
+ * If the page containing @a pos is cached, the pending IPC_M_DATA_READ
+ * request is answered with data up to the end of the page. Otherwise
+ * the request is left untouched. The caller must hold the node's contents
+ * lock.
+ *
+ * @param node		VFS node of the file.
+ * @param pos		Position within the file.
+ * @param bytes		Place to store the number of bytes read.
+ *
+ * @return		EOK on success, ENOENT if the page is not cached
+ *			or another error code.
+ */
+errno_t vfs_cache_read(vfs_node_t *node, aoff64_t pos, size_t *bytes)
+{
+	vfs_cache_page_t *pg;
+	cache_key_t key;
+
+	cache_key_init(&key, node, ALIGN_DOWN(pos, PAGE_SIZE));
+
+	fibril_mutex_lock(&cache_mutex);
+	ht_link_t *link = hash_table_find(&pages, &key);
+	if (link == NULL) {
+		fibril_mutex_unlock(&cache_mutex);
+		return ENOENT;
+	}
+
+	pg = hash_table_get_inst(link, vfs_cache_page_t, ph_link);
+	if (!pg->valid) {
+		fibril_mutex_unlock(&cache_mutex);
+		return ENOENT;
+	}
+
+	pg->refcnt++;
+	list_remove(&pg->lru_link);
+	list_prepend(&pg->lru_link, &cache_lru);
+	fibril_mutex_unlock(&cache_mutex);
+
+	ipc_call_t call;
+	size_t size;
+	if (!async_data_read_receive(&call, &size)) {
+		vfs_cache_put(pg);
+		return EINVAL;
+	}
+
+	size_t skip = pos - pg->offset;
+	size = min(size, pg->size > skip ? pg->size - skip : 0);
+
+	errno_t rc = async_data_read_finalize(&call, pg->data + skip, size);
+	vfs_cache_put(pg);
+
+	if (rc == EOK)
+		*bytes = size;
+	return rc;
+}
+
+static bool collect_visitor(ht_link_t *item, void *arg)
+{
+	vfs_cache_page_t *pg = hash_table_get_inst(item, vfs_cache_page_t,
+	    ph_link);
+	cache_match_t *match = (cache_match_t *) arg;
+
+	if (!cache_match(pg, match) || (match->dirty && !pg->dirty))
+		return true;
+
+	pg->refcnt++;
+	match->pages[match->count++] = pg;
+	return true;
+}
+
+/** Write dirty pages matching a set back to the file system server.
+ *
+ * @param match		Set of pages to write back.
+ * @return		EOK on success or an error code.
+ */
+static errno_t cache_writeback(cache_match_t *match)
+{
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&cache_mutex);
+	if (cache_dirty == 0) {
+		fibril_mutex_unlock(&cache_mutex);
+		return EOK;
+	}
+
+	match->dirty = true;
+	match->count = 0;
+	match->pages = malloc(cache_dirty * sizeof(vfs_cache_page_t *));
+	if (match->pages == NULL) {
+		fibril_mutex_unlock(&cache_mutex);
+		return ENOMEM;
+	}
+
+	hash_table_apply(&pages, collect_visitor, match);
+	fibril_mutex_unlock(&cache_mutex);
+
+	for (size_t i = 0; i < match->count; i++) {
+		errno_t rc2 = cache_page_write(match->pages[i]);
+		if (rc == EOK)
+			rc = rc2;
+		vfs_cache_put(match->pages[i]);
+	}
+
+	free(match->pages);
+	return rc;
+}
+
+/** Write dirty pages of a file back to the file system server.
+ *
+ * The caller must hold the node's contents lock.
+ *
+ * @param node		VFS node of the file.
+ * @return		EOK on success or an error code.
+ */
+errno_t vfs_cache_writeback(vfs_node_t *node)
+{
+	cache_match_t match = {
+		.fs_handle = node->fs_handle,
+		.service_id = node->service_id,
+		.index = node->index
+	};
+
+	return cache_writeback(&match);
+}
+
+/** Re-read cached pages overlapping a range of a file.
+ *
+ * @param node		VFS node of the file.
+ * @param start		Start of the range.
+ * @param end		End of the range.
+ */
+static void cache_refresh(vfs_node_t *node, aoff64_t start, aoff64_t end)
+{
+	vfs_cache_page_t *pg;
+	cache_key_t key;
+	size_t size;
+
+	for (aoff64_t off = ALIGN_DOWN(start, PAGE_SIZE); off < end;
+	    off += PAGE_SIZE) {
+		cache_key_init(&key, node, off);
+
+		fibril_mutex_lock(&cache_mutex);
+		ht_link_t *link = hash_table_find(&pages, &key);
+		if (link == NULL) {
+			fibril_mutex_unlock(&cache_mutex);
+			continue;
+		}
+
+		pg = hash_table_get_inst(link, vfs_cache_page_t, ph_link);
+		if (!pg->valid) {
+			/* Make the fibril reading the page in read it again. */
+			pg->refill = true;
+			fibril_mutex_unlock(&cache_mutex);
+			continue;
+		}
+
+		pg->refcnt++;
+		fibril_mutex_unlock(&cache_mutex);
+
+		errno_t rc = cache_page_read(pg, &size);
+
+		fibril_mutex_lock(&cache_mutex);
+		if (rc == EOK)
+			pg->size = size;
+		else if (!pg->stale)
+			(void) cache_page_remove(pg);
+		fibril_mutex_unlock(&cache_mutex);
+
+		vfs_cache_put(pg);
+	}
+}
+
+/** Update the page cache after a file has been written.
+ *
+ * The caller must hold the node's contents lock.
+ *
+ * @param node		VFS node of the file.
+ * @param old_size	Size of the file before the write.
+ * @param pos		Position of the write.
+ * @param bytes		Number of bytes written.
+ */
+void vfs_cache_update(vfs_node_t *node, aoff64_t old_size, aoff64_t pos,
+    size_t bytes)
+{
+	/* Writing past the end of the file has created a hole. */
+	if (pos > old_size)
+		vfs_cache_resize(node, pos);
+
+	if (bytes > 0)
+		cache_refresh(node, pos, pos + bytes);
+}
+
+struct resize_data {
+	cache_match_t match;
+	aoff64_t size;
+};
+
+static bool resize_visitor(ht_link_t *item, void *arg)
+{
+	vfs_cache_page_t *pg = hash_table_get_inst(item, vfs_cache_page_t,
+	    ph_link);
+	struct resize_data *rd = (struct resize_data *) arg;
+
+	if (!cache_match(pg, &rd->match))
+		return true;
+
+	if (!pg->valid) {
+		pg->refill = true;
+		return true;
+	}
+
+	if (pg->offset >= rd->size) {
+		if (pg->size > 0 && cache_page_remove(pg))
+			cache_page_destroy(pg);
+		return true;
+	}
+
+	size_t size = min(rd->size - pg->offset, PAGE_SIZE);
+	if (size < pg->size)
+		memset(pg->data + size, 0, pg->size - size);
+	pg->size = size;
+	return true;
+}
+
+/** Update the page cache after a file has been resized.
+ *
+ * The caller must hold the node's contents lock.
+ *
+ * @param node		VFS node of the file.
+ * @param size		New size of the file.
+ */
+void vfs_cache_resize(vfs_node_t *node, aoff64_t size)
+{
+	struct resize_data rd = {
+		.match = {
+			.fs_handle = node->fs_handle,
+			.service_id = node->service_id,
+			.index = node->index
+		},
+		.size = size
+	};
+
+	fibril_mutex_lock(&cache_mutex);
+	if (cache_pages > 0)
+		hash_table_apply(&pages, resize_visitor, &rd);
+	fibril_mutex_unlock(&cache_mutex);
+}
+
+static bool purge_visitor(ht_link_t *item, void *arg)
+{
+	vfs_cache_page_t *pg = hash_table_get_inst(item, vfs_cache_page_t,
+	    ph_link);
+	cache_match_t *match = (cache_match_t *) arg;
+
+	if (cache_match(pg, match) && cache_page_remove(pg))
+		cache_page_destroy(pg);
+
+	return true;
+}
+
+static void cache_purge(cache_match_t *match)
+{
+	fibril_mutex_lock(&cache_mutex);
+	if (cache_pages > 0)
+		hash_table_apply(&pages, purge_visitor, match);
+	fibril_mutex_unlock(&cache_mutex);
+}
+
+/** Drop all cached pages of a file which is being destroyed.
+ *
+ * @param triplet	Triplet identifying the file.
+ */
+void vfs_cache_purge_node(vfs_triplet_t *triplet)
+{
+	cache_match_t match = {
+		.fs_handle = triplet->fs_handle,
+		.service_id = triplet->service_id,
+		.index = triplet->index
+	};
+
+	cache_purge(&match);
+}
+
+/** Write back and drop all cached pages of a file system instance.
+ *
+ * @param fs_handle	File system handle.
+ * @param service_id	Service ID of the file system instance.
+ */
+void vfs_cache_purge_fs(fs_handle_t fs_handle, service_id_t service_id)
+{
+	cache_match_t match = {
+		.fs_handle = fs_handle,
+		.service_id = service_id,
+		.all = true
+	};
+
+	(void) cache_writeback(&match);
+	match.dirty = false;
+	cache_purge(&match);
+}
+
+/**
+ * @}
+ */
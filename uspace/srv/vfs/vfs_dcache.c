@@ -0,0 +1,479 @@
+/** @addtogroup vfs
+ * @{
+ */
+
+/**
+ * @file	vfs_dcache.c
+ * @brief	VFS name cache.
+ *
+ * The name cache maps a directory and a name to the result of looking the
+ * name up in the directory, so that repeated lookups of the same paths do
+ * not need to be resolved by the file system servers. Names which do not
+ * exist are cached as negative entries.
+ *
+ * Directories are identified by their triplets after crossing mount points.
+ * All changes of the namespace go through VFS, which drops the affected
+ * entries. File systems whose namespace changes by other means (such as
+ * locfs) are not cached. Since cached results do not hold references to VFS nodes, the
+ * cached size of a node is refreshed when its VFS node is freed.
+ */
+
+#include "vfs.h"
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <fibril_synch.h>
+#include <stdlib.h>
+#include <str.h>
+
+/** Maximum number of entries in the name cache. */
+#define DCACHE_ENTRIES_MAX	4096
+
+/** Mutex protecting the name cache. */
+static FIBRIL_MUTEX_INITIALIZE(dcache_mutex);
+
+/** Name cache hash table, keyed by directory and name. */
+static hash_table_t dentries;
+
+/** Positive name cache entries, keyed by the node they refer to. */
+static hash_table_t targets;
+
+/** Name cache entries, most recently used first. */
+static LIST_INITIALIZE(dcache_lru);
+
+/** File system instances mounted with VFS_MOUNT_NO_DCACHE. */
+static LIST_INITIALIZE(dcache_disabled);
+
+/** Number of entries in the name cache. */
+static size_t dcache_entries;
+
+/** Incremented whenever entries are dropped from the name cache. */
+static unsigned dcache_gen;
+
+/** Name cache entry. */
+typedef struct {
+	ht_link_t dh_link;	/**< Name hash-table link. */
+	ht_link_t th_link;	/**< Target hash-table link. */
+	link_t lru_link;	/**< Link in the LRU list. */
+
+	/** Directory containing the name. */
+	vfs_triplet_t parent;
+	/** Name within the directory. */
+	char *name;
+	/** The name exists. */
+	bool exists;
+	/** Result of looking up the name if it exists. */
+	vfs_lookup_res_t res;
+} dentry_t;
+
+/** File system instance which does not use the name cache. */
+typedef struct {
+	link_t link;
+	vfs_pair_t pair;
+} dcache_disabled_t;
+
+typedef struct {
+	const vfs_triplet_t *parent;
+	const char *name;
+} dentry_key_t;
+
+static size_t triplet_hash(const vfs_triplet_t *tri)
+{
+	size_t hash = hash_combine(tri->fs_handle, tri->index);
+	return hash_combine(hash, tri->service_id);
+}
+
+static bool triplet_equal(const vfs_triplet_t *a, const vfs_triplet_t *b)
+{
+	return a->fs_handle == b->fs_handle &&
+	    a->service_id == b->service_id && a->index == b->index;
+}
+
+static size_t name_hash(const char *name)
+{
+	size_t hash = 0;
+
+	for (const uint8_t *cp = (const uint8_t *) name; *cp != '\0'; cp++)
+		hash = hash * 31 + *cp;
+
+	return hash;
+}
+
+static size_t dentries_key_hash(const void *key)
+{
+	const dentry_key_t *dk = key;
+	return hash_combine(triplet_hash(dk->parent), name_hash(dk->name));
+}
+
+static size_t dentries_hash(const ht_link_t *item)
+{
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, dh_link);
+	dentry_key_t key = {
+		.parent = &dentry->parent,
+		.name = dentry->name
+	};
+
+	return dentries_key_hash(&key);
+}
+
+static bool dentries_key_equal(const void *key, const ht_link_t *item)
+{
+	const dentry_key_t *dk = key;
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, dh_link);
+
+	return triplet_equal(dk->parent, &dentry->parent) &&
+	    str_cmp(dk->name, dentry->name) == 0;
+}
+
+/** Name cache hash table operations. */
+static hash_table_ops_t dentries_ops = {
+	.hash = dentries_hash,
+	.key_hash = dentries_key_hash,
+	.key_equal = dentries_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL,
+};
+
+static size_t targets_key_hash(const void *key)
+{
+	return triplet_hash(key);
+}
+
+static size_t targets_hash(const ht_link_t *item)
+{
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, th_link);
+	return triplet_hash(&dentry->res.triplet);
+}
+
+static bool targets_key_equal(const void *key, const ht_link_t *item)
+{
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, th_link);
+	return triplet_equal(key, &dentry->res.triplet);
+}
+
+static bool targets_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	dentry_t *dentry1 = hash_table_get_inst(item1, dentry_t, th_link);
+	dentry_t *dentry2 = hash_table_get_inst(item2, dentry_t, th_link);
+	return triplet_equal(&dentry1->res.triplet, &dentry2->res.triplet);
+}
+
+/** Target hash table operations. */
+static hash_table_ops_t targets_ops = {
+	.hash = targets_hash,
+	.key_hash = targets_key_hash,
+	.key_equal = targets_key_equal,
+	.equal = targets_equal,
+	.remove_callback = NULL,
+};
+
+/** Initialize the VFS name cache.
+ *
+ * @return		Return true on success, false on failure.
+ */
+bool vfs_dcache_init(void)
+{
+	if (!hash_table_create(&dentries, 0, 0, &dentries_ops))
+		return false;
+
+	if (!hash_table_create(&targets, 0, 0, &targets_ops)) {
+		hash_table_destroy(&dentries);
+		return false;
+	}
+
+	return true;
+}
+
+/** Remove entry from the name cache and free it.
+ *
+ * Must be called with dcache_mutex held.
+ */
+static void dentry_destroy(dentry_t *dentry)
+{
+	hash_table_remove_item(&dentries, &dentry->dh_link);
+	if (dentry->exists)
+		hash_table_remove_item(&targets, &dentry->th_link);
+	list_remove(&dentry->lru_link);
+	dcache_entries--;
+
+	free(dentry->name);
+	free(dentry);
+}
+
+static bool dcache_is_disabled(const vfs_triplet_t *parent)
+{
+	list_foreach(dcache_disabled, link, dcache_disabled_t, disabled) {
+		if (disabled->pair.fs_handle == parent->fs_handle &&
+		    disabled->pair.service_id == parent->service_id)
+			return true;
+	}
+
+	return false;
+}
+
+/** Get current generation of the name cache.
+ *
+ * Results of lookups which started before entries were dropped from the
+ * cache may no longer be valid. Pass the generation obtained before the
+ * lookup to vfs_dcache_insert() to have such results ignored.
+ *
+ * @return		Name cache generation.
+ */
+unsigned vfs_dcache_gen(void)
+{
+	fibril_mutex_lock(&dcache_mutex);
+	unsigned gen = dcache_gen;
+	fibril_mutex_unlock(&dcache_mutex);
+
+	return gen;
+}
+
+/** Look up name in the name cache.
+ *
+ * @param parent	Directory containing the name.
+ * @param name		Name to look up.
+ * @param exists	Place to store whether the name exists.
+ * @param res		Place to store the lookup result if the name exists.
+ *
+ * @return		True if the name was found in the cache.
+ */
+bool vfs_dcache_find(vfs_triplet_t *parent, const char *name, bool *exists,
+    vfs_lookup_res_t *res)
+{
+	dentry_key_t key = {
+		.parent = parent,
+		.name = name
+	};
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	ht_link_t *link = hash_table_find(&dentries, &key);
+	if (link == NULL) {
+		fibril_mutex_unlock(&dcache_mutex);
+		return false;
+	}
+
+	dentry_t *dentry = hash_table_get_inst(link, dentry_t, dh_link);
+	list_remove(&dentry->lru_link);
+	list_prepend(&dentry->lru_link, &dcache_lru);
+
+	*exists = dentry->exists;
+	if (dentry->exists)
+		*res = dentry->res;
+
+	fibril_mutex_unlock(&dcache_mutex);
+	return true;
+}
+
+/** Insert lookup result into the name cache.
+ *
+ * @param parent	Directory containing the name.
+ * @param name		Name within the directory.
+ * @param res		Lookup result or NULL if the name does not exist.
+ * @param gen		Name cache generation before the lookup started.
+ */
+void vfs_dcache_insert(vfs_triplet_t *parent, const char *name,
+    vfs_lookup_res_t *res, unsigned gen)
+{
+	dentry_key_t key = {
+		.parent = parent,
+		.name = name
+	};
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	if (gen != dcache_gen || dcache_is_disabled(parent) ||
+	    hash_table_find(&dentries, &key) != NULL) {
+		fibril_mutex_unlock(&dcache_mutex);
+		return;
+	}
+
+	dentry_t *dentry = calloc(1, sizeof(dentry_t));
+	if (dentry == NULL) {
+		fibril_mutex_unlock(&dcache_mutex);
+		return;
+	}
+
+	dentry->name = str_dup(name);
+	if (dentry->name == NULL) {
+		free(dentry);
+		fibril_mutex_unlock(&dcache_mutex);
+		return;
+	}
+
+	if (dcache_entries >= DCACHE_ENTRIES_MAX) {
+		dentry_destroy(list_get_instance(list_last(&dcache_lru),
+		    dentry_t, lru_link));
+	}
+
+	dentry->parent = *parent;
+	if (res != NULL) {
+		dentry->exists = true;
+		dentry->res = *res;
+		hash_table_insert(&targets, &dentry->th_link);
+	}
+
+	hash_table_insert(&dentries, &dentry->dh_link);
+	list_prepend(&dentry->lru_link, &dcache_lru);
+	dcache_entries++;
+
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+/** Drop name from the name cache.
+ *
+ * @param parent	Directory containing the name.
+ * @param name		Name within the directory.
+ */
+void vfs_dcache_remove(vfs_triplet_t *parent, const char *name)
+{
+	dentry_key_t key = {
+		.parent = parent,
+		.name = name
+	};
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	dcache_gen++;
+
+	ht_link_t *link = hash_table_find(&dentries, &key);
+	if (link != NULL)
+		dentry_destroy(hash_table_get_inst(link, dentry_t, dh_link));
+
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+/** Update cached size of a node.
+ *
+ * Called when the VFS node which kept track of the size is freed.
+ *
+ * @param triplet	Triplet identifying the node.
+ * @param size		Size of the node.
+ */
+void vfs_dcache_set_size(vfs_triplet_t *triplet, aoff64_t size)
+{
+	fibril_mutex_lock(&dcache_mutex);
+
+	ht_link_t *first = hash_table_find(&targets, triplet);
+	ht_link_t *link = first;
+	while (link != NULL) {
+		dentry_t *dentry = hash_table_get_inst(link, dentry_t, th_link);
+		dentry->res.size = size;
+		link = hash_table_find_next(&targets, first, link);
+	}
+
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+typedef struct {
+	vfs_pair_t pair;
+	/** Only purge entries of this directory. */
+	const vfs_triplet_t *dir;
+} dcache_purge_t;
+
+static bool purge_visitor(ht_link_t *item, void *arg)
+{
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, dh_link);
+	dcache_purge_t *purge = (dcache_purge_t *) arg;
+
+	if (purge->dir != NULL) {
+		if (triplet_equal(&dentry->parent, purge->dir))
+			dentry_destroy(dentry);
+	} else if (dentry->parent.fs_handle == purge->pair.fs_handle &&
+	    dentry->parent.service_id == purge->pair.service_id) {
+		dentry_destroy(dentry);
+	}
+
+	return true;
+}
+
+/** Drop all names within a directory from the name cache.
+ *
+ * @param dir		Triplet identifying the directory.
+ */
+void vfs_dcache_purge_dir(vfs_triplet_t *dir)
+{
+	dcache_purge_t purge = {
+		.dir = dir
+	};
+
+	fibril_mutex_lock(&dcache_mutex);
+	dcache_gen++;
+	if (dcache_entries > 0)
+		hash_table_apply(&dentries, purge_visitor, &purge);
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+/** Drop all names of a file system instance from the name cache.
+ *
+ * @param fs_handle	File system handle.
+ * @param service_id	Service ID of the file system instance.
+ */
+void vfs_dcache_purge_fs(fs_handle_t fs_handle, service_id_t service_id)
+{
+	dcache_purge_t purge = {
+		.pair = {
+			.fs_handle = fs_handle,
+			.service_id = service_id
+		}
+	};
+
+	fibril_mutex_lock(&dcache_mutex);
+	dcache_gen++;
+	if (dcache_entries > 0)
+		hash_table_apply(&dentries, purge_visitor, &purge);
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+/** Check whether the name cache is enabled for a file system instance.
+ *
+ * @param dir		Any node of the file system instance.
+ *
+ * @return		True if names in the file system are cached.
+ */
+bool vfs_dcache_enabled(vfs_triplet_t *dir)
+{
+	fibril_mutex_lock(&dcache_mutex);
+	bool enabled = !dcache_is_disabled(dir);
+	fibril_mutex_unlock(&dcache_mutex);
+
+	return enabled;
+}
+
+/** Enable or disable the name cache for a file system instance.
+ *
+ * @param fs_handle	File system handle.
+ * @param service_id	Service ID of the file system instance.
+ * @param enable	True to enable, false to disable the name cache.
+ */
+void vfs_dcache_enable(fs_handle_t fs_handle, service_id_t service_id,
+    bool enable)
+{
+	fibril_mutex_lock(&dcache_mutex);
+
+	list_foreach_safe(dcache_disabled, cur, next) {
+		dcache_disabled_t *disabled = list_get_instance(cur,
+		    dcache_disabled_t, link);
+		if (disabled->pair.fs_handle == fs_handle &&
+		    disabled->pair.service_id == service_id) {
+			list_remove(&disabled->link);
+			free(disabled);
+		}
+	}
+
+	if (!enable) {
+		dcache_disabled_t *disabled = malloc(sizeof(dcache_disabled_t));
+		if (disabled != NULL) {
+			link_initialize(&disabled->link);
+			disabled->pair.fs_handle = fs_handle;
+			disabled->pair.service_id = service_id;
+			list_append(&disabled->link, &dcache_disabled);
+		}
+	}
+
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+/**
+ * @}
+ */
@@ -29,6 +29,7 @@
 #include <vfs/vfs.h>
 #include "vfs.h"
 
+#include <boottrace.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <str.h>
@@ -150,6 +151,8 @@ static void vfs_in_mount(ipc_call_t *req)
 	int outfd = 0;
 	rc = vfs_op_mount(mpfd, service_id, flags, instance, opts, fs_name,
 	    &outfd);
+	if (rc == EOK)
+		boottrace_record(BOOTTRACE_MOUNT, req->task_id, service_id, fs_name);
 	async_answer_1(req, rc, outfd);
 
 	free(opts);
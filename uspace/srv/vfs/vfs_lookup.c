@@ -202,6 +202,8 @@ errno_t vfs_link_internal(vfs_node_t *base, char *path, vfs_triplet_t *child)
 	if (orig_rc != EOK)
 		rc = orig_rc;
 
+	vfs_dcache_remove(triplet, component);
+
 out:
 	return rc;
 }
@@ -237,7 +239,81 @@ static errno_t out_lookup(vfs_triplet_t *base, size_t *pfirst, size_t *plen,
 	return EOK;
 }
 
-static errno_t _vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
+/** Look up a single name in a directory using the file system server.
+ *
+ * @param dir     Directory in which to look up the name.
+ * @param name    Name to look up; it need not be NULL-terminated.
+ * @param nlen    Length of the name.
+ * @param exists  Place to store whether the name exists.
+ * @param result  Place to store the lookup result if the name exists.
+ *
+ * @return EOK on success or an error code from errno.h.
+ */
+static errno_t out_lookup_name(vfs_triplet_t *dir, const char *name,
+    size_t nlen, bool *exists, vfs_lookup_res_t *result)
+{
+	char path[NAME_MAX + 2];
+	plb_entry_t entry;
+	size_t first;
+	errno_t rc;
+
+	path[0] = '/';
+	memcpy(path + 1, name, nlen);
+
+	rc = plb_insert_entry(&entry, path, &first, nlen + 1);
+	if (rc != EOK)
+		return rc;
+
+	size_t next = first;
+	size_t len = nlen + 1;
+	rc = out_lookup(dir, &next, &len, L_NONE, result);
+
+	plb_clear_entry(&entry, first, nlen + 1);
+
+	/* The file system stops short of names which do not exist. */
+	if (rc == EOK)
+		*exists = (len == 0);
+	return rc;
+}
+
+/** Cross mount points stacked on a looked up node.
+ *
+ * @param res     Lookup result, updated to refer to the mounted root.
+ * @param lflag   Flags used during lookup.
+ *
+ * @return EOK on success or EXDEV if a mount point should not be crossed.
+ */
+static errno_t cross_mounts(vfs_lookup_res_t *res, int lflag)
+{
+	vfs_node_t *node = vfs_node_peek(res);
+	if (!node)
+		return EOK;
+
+	if (node->mount && (lflag & L_DISABLE_MOUNTS)) {
+		vfs_node_put(node);
+		return EXDEV;
+	}
+
+	while (node->mount) {
+		vfs_node_addref(node->mount);
+		vfs_node_t *nnode = node->mount;
+		vfs_node_put(node);
+		node = nnode;
+	}
+
+	res->triplet = *((vfs_triplet_t *) node);
+	res->type = node->type;
+	res->size = node->size;
+	vfs_node_put(node);
+	return EOK;
+}
+
+/** Perform a path lookup by the file system servers, using the PLB.
+ *
+ * The whole path is handed to the file system at once and only broken
+ * up at mount points.
+ */
+static errno_t plb_lookup(vfs_node_t *base, char *path, int lflag,
     vfs_lookup_res_t *result, size_t len)
 {
 	size_t first;
@@ -321,6 +397,118 @@ out:
 	return rc;
 }
 
+/** Perform a path lookup one name at a time using the name cache.
+ *
+ * Names missing from the name cache are looked up by the file system
+ * servers and added to the cache.
+ */
+static errno_t dcache_lookup(vfs_node_t *base, char *path, int lflag,
+    vfs_lookup_res_t *result, size_t len)
+{
+	char component[NAME_MAX + 1];
+	vfs_lookup_res_t cur;
+	vfs_lookup_res_t res;
+	bool exists;
+	errno_t rc;
+
+	while (base->mount) {
+		if (lflag & L_DISABLE_MOUNTS)
+			return EXDEV;
+
+		base = base->mount;
+	}
+
+	cur.triplet = *((vfs_triplet_t *) base);
+	cur.type = base->type;
+	cur.size = base->size;
+
+	size_t pos = 0;
+	while (pos < len) {
+		assert(path[pos] == '/');
+
+		if (!vfs_dcache_enabled(&cur.triplet)) {
+			/*
+			 * Names in this file system are not cached, so a
+			 * walk would cost one lookup per component. Let the
+			 * file system resolve the rest of the path at once.
+			 */
+			vfs_node_t *node = vfs_node_get(&cur);
+			if (node == NULL)
+				return ENOMEM;
+
+			rc = plb_lookup(node, path + pos, lflag, result,
+			    len - pos);
+			vfs_node_put(node);
+			return rc;
+		}
+
+		size_t start = pos + 1;
+		size_t end = start;
+		while (end < len && path[end] != '/')
+			end++;
+
+		if (end == start) {
+			/* The path is just "/". */
+			break;
+		}
+
+		if (end - start > NAME_MAX)
+			return ENAMETOOLONG;
+
+		memcpy(component, path + start, end - start);
+		component[end - start] = '\0';
+		pos = end;
+
+		if (cur.type != VFS_NODE_DIRECTORY)
+			return ENOTDIR;
+
+		if (!vfs_dcache_find(&cur.triplet, component, &exists, &res)) {
+			unsigned gen = vfs_dcache_gen();
+
+			rc = out_lookup_name(&cur.triplet, component,
+			    end - start, &exists, &res);
+			if (rc != EOK)
+				return rc;
+
+			vfs_dcache_insert(&cur.triplet, component,
+			    exists ? &res : NULL, gen);
+		}
+
+		if (!exists)
+			return ENOENT;
+
+		cur = res;
+
+		/* The found file may be a mount point. Try to cross it. */
+		if (pos < len || !(lflag & (L_MP | L_DISABLE_MOUNTS))) {
+			rc = cross_mounts(&cur, lflag);
+			if (rc != EOK)
+				return rc;
+		}
+	}
+
+	if ((lflag & L_FILE) && cur.type == VFS_NODE_DIRECTORY)
+		return EISDIR;
+
+	if ((lflag & L_DIRECTORY) && cur.type == VFS_NODE_FILE)
+		return ENOTDIR;
+
+	if (result != NULL)
+		*result = cur;
+
+	return EOK;
+}
+
+static errno_t _vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
+    vfs_lookup_res_t *result, size_t len)
+{
+	/* Names are only created and removed by the file system servers. */
+	if (!(lflag & (L_CREATE | L_UNLINK)))
+		return dcache_lookup(base, path, lflag, result, len);
+
+	return plb_lookup(base, path, lflag, result, len);
+}
+
 /** Perform a path lookup.
  *
  * @param base    The file from which to perform the lookup.
@@ -385,6 +573,16 @@ errno_t vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
 		rc = _vfs_lookup_internal(parent, slash, lflag, result,
 		    len - (slash - path));
 
+		/* The name may have been created or removed. */
+		vfs_node_t *dir = parent;
+		while (dir->mount)
+			dir = dir->mount;
+
+		vfs_dcache_remove((vfs_triplet_t *) dir, slash + 1);
+		if (rc == EOK && (lflag & L_UNLINK) && result != NULL &&
+		    result->type == VFS_NODE_DIRECTORY)
+			vfs_dcache_purge_dir(&result->triplet);
+
 		vfs_node_put(parent);
 
 	} else {
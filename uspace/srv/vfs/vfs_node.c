@@ -124,6 +124,17 @@ void vfs_node_delref(vfs_node_t *node)
 	fibril_mutex_unlock(&nodes_mutex);
 
 	if (free_node) {
+		/*
+		 * The file may be destroyed now and its index reused, so
+		 * forget its contents.
+		 */
+		vfs_triplet_t triplet = node_triplet(node);
+		if (node->unlinked)
+			vfs_cache_purge_node(&triplet);
+
+		/* Names cached for the node now need to know its size. */
+		vfs_dcache_set_size(&triplet, node->size);
+
 		/*
 		 * VFS_OUT_DESTROY will free up the file's resources if there
 		 * are no more hard links.
@@ -79,6 +79,8 @@ static size_t shared_path(char *a, char *b)
 /* This call destroys the file if and only if there are no hard links left. */
 static void out_destroy(vfs_triplet_t *file)
 {
+	vfs_cache_purge_node(file);
+
 	async_exch_t *exch = vfs_exchange_grab(file->fs_handle);
 	async_msg_2(exch, VFS_OUT_DESTROY, (sysarg_t) file->service_id,
 	    (sysarg_t) file->index);
@@ -267,7 +269,21 @@ errno_t vfs_op_mount(int mpfd, unsigned service_id, unsigned flags,
 
 	rc = vfs_connect_internal(service_id, flags, instance, opts, fs_name,
 	    &root);
+	if (rc == EOK) {
+		vfs_info_t *fs_info = fs_handle_to_info(root->fs_handle);
+		assert(fs_info);
+
+		/* Forget names cached during a previous mount. */
+		vfs_dcache_purge_fs(root->fs_handle, root->service_id);
+		vfs_dcache_enable(root->fs_handle, root->service_id,
+		    !(flags & VFS_MOUNT_NO_DCACHE) &&
+		    !fs_info->external_namespace);
+	}
+
 	if (rc == EOK && !(flags & VFS_MOUNT_CONNECT_ONLY)) {
+		/* Names in the mount point are now hidden. */
+		vfs_dcache_purge_dir((vfs_triplet_t *) mp->node);
+
 		vfs_node_addref(mp->node);
 		vfs_node_addref(root);
 		mp->node->mount = root;
@@ -357,6 +373,13 @@ static errno_t rdwr_ipc_client(async_exch_t *exch, vfs_file_t *file, aoff64_t po
 	size_t *bytes = (size_t *) data;
 	errno_t rc;
 
+	/* Serve the read from the page cache if possible. */
+	if (read && file->node->type == VFS_NODE_FILE) {
+		rc = vfs_cache_read(file->node, pos, bytes);
+		if (rc != ENOENT)
+			return rc;
+	}
+
 	/*
 	 * Make a VFS_READ/VFS_WRITE request at the destination FS server
 	 * and forward the IPC_M_DATA_READ/IPC_M_DATA_WRITE request to the
@@ -467,34 +490,51 @@ static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
 		fibril_rwlock_read_lock(&namespace_rwlock);
 	}
 
-	async_exch_t *fs_exch = vfs_exchange_grab(file->node->fs_handle);
-
 	if (!read && file->append)
 		pos = file->node->size;
 
+	/*
+	 * Modifications of shared writable mappings must reach the endpoint
+	 * FS before it gets to see the read or write.
+	 */
+	aoff64_t old_size = file->node->size;
+	errno_t rc = EOK;
+	if (file->node->type == VFS_NODE_FILE)
+		rc = vfs_cache_writeback(file->node);
+
 	/*
 	 * Handle communication with the endpoint FS.
 	 */
 	ipc_call_t answer;
-	errno_t rc = ipc_cb(fs_exch, file, pos, &answer, read, ipc_cb_data);
-
-	vfs_exchange_release(fs_exch);
+	if (rc == EOK) {
+		async_exch_t *fs_exch = vfs_exchange_grab(file->node->fs_handle);
+		rc = ipc_cb(fs_exch, file, pos, &answer, read, ipc_cb_data);
+		vfs_exchange_release(fs_exch);
+	}
 
 	if (file->node->type == VFS_NODE_DIRECTORY)
 		fibril_rwlock_read_unlock(&namespace_rwlock);
 
-	/* Unlock the VFS node. */
-	if (rlock) {
-		fibril_rwlock_read_unlock(&file->node->contents_rwlock);
-	} else {
+	if (!read && rc == EOK) {
 		/* Update the cached version of node's size. */
-		if (rc == EOK) {
+		if (!rlock) {
 			file->node->size = MERGE_LOUP32(ipc_get_arg2(&answer),
 			    ipc_get_arg3(&answer));
 		}
-		fibril_rwlock_write_unlock(&file->node->contents_rwlock);
+
+		/* Bring cached pages up to date with the write. */
+		if (file->node->type == VFS_NODE_FILE) {
+			vfs_cache_update(file->node, old_size, pos,
+			    ipc_get_arg1(&answer));
+		}
 	}
 
+	/* Unlock the VFS node. */
+	if (rlock)
+		fibril_rwlock_read_unlock(&file->node->contents_rwlock);
+	else
+		fibril_rwlock_write_unlock(&file->node->contents_rwlock);
+
 	vfs_file_put(file);
 
 	return rc;
@@ -600,10 +640,12 @@ errno_t vfs_op_rename(int basefd, char *old, char *new)
 	/* If the node is not held by anyone, try to destroy it. */
 	if (orig_unlinked) {
 		vfs_node_t *node = vfs_node_peek(&new_lr_orig);
-		if (!node)
+		if (!node) {
 			out_destroy(&new_lr_orig.triplet);
-		else
+		} else {
+			node->unlinked = true;
 			vfs_node_put(node);
+		}
 	}
 
 	vfs_node_put(base);
@@ -626,8 +668,10 @@ errno_t vfs_op_resize(int fd, int64_t size)
 
 	errno_t rc = vfs_truncate_internal(file->node->fs_handle,
 	    file->node->service_id, file->node->index, size);
-	if (rc == EOK)
+	if (rc == EOK) {
 		file->node->size = size;
+		vfs_cache_resize(file->node, size);
+	}
 
 	fibril_rwlock_write_unlock(&file->node->contents_rwlock);
 	vfs_file_put(file);
@@ -674,6 +718,14 @@ errno_t vfs_op_sync(int fd)
 	if (!file)
 		return EBADF;
 
+	fibril_rwlock_read_lock(&file->node->contents_rwlock);
+	errno_t rc = vfs_cache_writeback(file->node);
+	fibril_rwlock_read_unlock(&file->node->contents_rwlock);
+	if (rc != EOK) {
+		vfs_file_put(file);
+		return rc;
+	}
+
 	async_exch_t *fs_exch = vfs_exchange_grab(file->node->fs_handle);
 
 	aid_t msg;
@@ -683,7 +735,6 @@ errno_t vfs_op_sync(int fd)
 
 	vfs_exchange_release(fs_exch);
 
-	errno_t rc;
 	async_wait_for(msg, &rc);
 
 	vfs_file_put(file);
@@ -768,10 +819,12 @@ errno_t vfs_op_unlink(int parentfd, int expectfd, char *path)
 
 	/* If the node is not held by anyone, try to destroy it. */
 	vfs_node_t *node = vfs_node_peek(&lr);
-	if (!node)
+	if (!node) {
 		out_destroy(&lr.triplet);
-	else
+	} else {
+		node->unlinked = true;
 		vfs_node_put(node);
+	}
 
 exit:
 	if (path)
@@ -811,6 +864,9 @@ errno_t vfs_op_unmount(int mpfd)
 		return EBUSY;
 	}
 
+	vfs_cache_purge_fs(mp->node->mount->fs_handle,
+	    mp->node->mount->service_id);
+
 	async_exch_t *exch = vfs_exchange_grab(mp->node->mount->fs_handle);
 	errno_t rc = async_req_1_0(exch, VFS_OUT_UNMOUNTED,
 	    mp->node->mount->service_id);
@@ -822,6 +878,11 @@ errno_t vfs_op_unmount(int mpfd)
 		return rc;
 	}
 
+	vfs_dcache_purge_fs(mp->node->mount->fs_handle,
+	    mp->node->mount->service_id);
+	vfs_dcache_enable(mp->node->mount->fs_handle,
+	    mp->node->mount->service_id, true);
+
 	vfs_node_forget(mp->node->mount);
 	vfs_node_put(mp->node);
 	mp->node->mount = NULL;
@@ -36,6 +36,7 @@
  */
 
 #include "vfs.h"
+#include <align.h>
 #include <async.h>
 #include <fibril_synch.h>
 #include <errno.h>
@@ -43,49 +44,67 @@
 
 void vfs_page_in(ipc_call_t *req)
 {
-	aoff64_t offset = ipc_get_arg1(req);
+	aoff64_t offset = ipc_get_arg1(req) + ipc_get_arg5(req);
 	size_t page_size = ipc_get_arg2(req);
 	int fd = ipc_get_arg3(req);
-	void *page;
+	vfs_pager_flags_t flags = ipc_get_arg4(req);
+	sysarg_t pflags = 0;
+	vfs_cache_page_t *pg;
 	errno_t rc;
 
-	page = as_area_create(AS_AREA_ANY, page_size,
-	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
-	    AS_AREA_UNPAGED);
+	if (page_size != PAGE_SIZE || ALIGN_DOWN(offset, PAGE_SIZE) != offset) {
+		async_answer_0(req, EINVAL);
+		return;
+	}
 
-	if (page == AS_MAP_FAILED) {
-		async_answer_0(req, ENOMEM);
+	vfs_file_t *file = vfs_file_get(fd);
+	if (!file) {
+		async_answer_0(req, EBADF);
 		return;
 	}
 
-	rdwr_io_chunk_t chunk = {
-		.buffer = page,
-		.size = page_size
-	};
+	if (!file->open_read || file->node->type != VFS_NODE_FILE) {
+		vfs_file_put(file);
+		async_answer_0(req, EINVAL);
+		return;
+	}
 
-	size_t total = 0;
-	aoff64_t pos = offset;
-	do {
-		rc = vfs_rdwr_internal(fd, pos, true, &chunk);
-		if (rc != EOK)
-			break;
-		if (chunk.size == 0)
-			break;
-		total += chunk.size;
-		pos += chunk.size;
-		chunk.buffer += chunk.size;
-		chunk.size = page_size - total;
-	} while (total < page_size);
+	if ((flags & VFS_PAGER_WRITE) && (flags & VFS_PAGER_SHARED) &&
+	    !file->open_write) {
+		vfs_file_put(file);
+		async_answer_0(req, EPERM);
+		return;
+	}
 
-	async_answer_1(req, rc, (sysarg_t) page);
+	fibril_rwlock_read_lock(&file->node->contents_rwlock);
+	rc = vfs_cache_get(file->node, offset, &pg);
+	fibril_rwlock_read_unlock(&file->node->contents_rwlock);
+	vfs_file_put(file);
+
+	if (rc != EOK) {
+		async_answer_0(req, rc);
+		return;
+	}
+
+	if ((flags & VFS_PAGER_WRITE) != 0) {
+		if ((flags & VFS_PAGER_SHARED) != 0) {
+			/* The client may modify the cached page. */
+			vfs_cache_mark_dirty(pg);
+		} else {
+			/*
+			 * Private writable areas share the cached page until
+			 * they write to it, then the kernel copies it.
+			 */
+			pflags = AS_PAGE_IN_COW;
+		}
+	}
 
 	/*
-	 * FIXME:
-	 * This is just for now until we implement proper page cache
-	 * management.  Not keeping the pages around in a cache results in
-	 * inherently non-coherent private mappings.
+	 * The kernel takes its own reference to the frame backing the page
+	 * before we get to drop ours.
 	 */
-	as_area_destroy(page);
+	async_answer_2(req, EOK, (sysarg_t) pg->data, pflags);
+	vfs_cache_put(pg);
 }
 
 /**